@@ -1,4 +1,4 @@
-QT += core gui widgets multimedia multimediawidgets
+QT += core gui widgets multimedia multimediawidgets network
 QMAKE_PROJECT_DEPTH = 0
 
 TARGET = cameraextension
@@ -32,34 +32,154 @@ SOURCES += \
 	src/cameraextension.cpp \
 	src/cameraextensionform.cpp \
 	src/camerasettingsdialog.cpp \
+	src/cameraviewpanel.cpp \
 	src/cameraviewwidget.cpp  \
+	src/detachablepanel.cpp \
+	src/driftlogger.cpp \
+	src/lineprofileview.cpp \
+	src/mosaicitem.cpp \
+	src/nativecapturecontroller.cpp \
+	src/overlayanalysiscontroller.cpp \
+	src/playbackcontrols.cpp \
+	src/polarunwrapview.cpp \
+	src/recordingcontroller.cpp \
+	src/statisticsview.cpp \
+	src/capture/cameracapabilities.cpp \
+	src/capture/cameradeviceconfig.cpp \
+	src/capture/capabilityprobe.cpp \
+	src/capture/stillcapture.cpp \
+	src/capture/v4l2device.cpp \
+	src/capture/v4l2source.cpp \
+	src/control/controlserver.cpp \
+	src/export/frameexporter.cpp \
 	src/overlayitems/anchorpoint.cpp \
 	src/overlayitems/circleoverlay.cpp \
 	src/overlayitems/lineoverlay.cpp \
 	src/overlayitems/overlayitem.cpp \
 	src/overlayitems/polygonoverlay.cpp \
-	src/overlayitems/rectoverlay.cpp
+	src/overlayitems/rectoverlay.cpp \
+	src/processing/acquisitiongovernor.cpp \
+	src/processing/demosaic.cpp \
+	src/processing/displaymipmap.cpp \
+	src/processing/drifttracker.cpp \
+	src/processing/fft.cpp \
+	src/processing/focusanalyzer.cpp \
+	src/processing/focusmetric.cpp \
+	src/processing/frameanalyzer.cpp \
+	src/processing/frameconversion.cpp \
+	src/processing/framegrabber.cpp \
+	src/processing/frametapsurface.cpp \
+	src/processing/imageadjustment.cpp \
+	src/processing/lenscalibration.cpp \
+	src/processing/lensundistortion.cpp \
+	src/processing/lineprofile.cpp \
+	src/processing/mosaicbuilder.cpp \
+	src/processing/mosaiccanvas.cpp \
+	src/processing/overlaytracker.cpp \
+	src/processing/phasecorrelator.cpp \
+	src/processing/polarunwrap.cpp \
+	src/processing/referencecomparison.cpp \
+	src/processing/remaptable.cpp \
+	src/processing/roistatistics.cpp \
+	src/processing/scanlinespans.cpp \
+	src/processing/snapshotrenderer.cpp \
+	src/processing/windowlevel.cpp \
+	src/processing/workstealingpool.cpp \
+	src/recording/framerecorder.cpp \
+	src/recording/lzcodec.cpp \
+	src/recording/playbacksource.cpp \
+	src/recording/recordingcodec.cpp \
+	src/recording/recordingreader.cpp \
+	src/recording/recordingwriter.cpp
 
 HEADERS += \
 	src/cameraextension.h \
 	src/cameraextensionform.h \
 	src/cameraextensionparameters.h \
 	src/camerasettingsdialog.h \
+	src/cameraviewpanel.h \
 	src/cameraviewwidget.h  \
+	src/detachablepanel.h \
+	src/driftlogger.h \
+	src/lineprofileview.h \
+	src/mosaicitem.h \
+	src/nativecapturecontroller.h \
+	src/overlayanalysiscontroller.h \
+	src/playbackcontrols.h \
+	src/polarunwrapview.h \
+	src/recordingcontroller.h \
+	src/statisticsview.h \
+	src/capture/cameracapabilities.h \
+	src/capture/cameradeviceconfig.h \
+	src/capture/capabilityprobe.h \
+	src/capture/stillcapture.h \
+	src/capture/v4l2device.h \
+	src/capture/v4l2source.h \
+	src/control/controlprotocol.h \
+	src/control/controlserver.h \
+	src/export/frameexporter.h \
+	src/export/framering.h \
 	src/overlayitems/anchorpoint.h \
 	src/overlayitems/circleoverlay.h \
 	src/overlayitems/lineoverlay.h \
 	src/overlayitems/overlayitem.h \
 	src/overlayitems/polygonoverlay.h \
-	src/overlayitems/rectoverlay.h
+	src/overlayitems/rectoverlay.h \
+	src/processing/acquisitiongovernor.h \
+	src/processing/demosaic.h \
+	src/processing/displaymipmap.h \
+	src/processing/drifttracker.h \
+	src/processing/fft.h \
+	src/processing/focusanalyzer.h \
+	src/processing/focusmetric.h \
+	src/processing/frameanalyzer.h \
+	src/processing/frameconversion.h \
+	src/processing/framegrabber.h \
+	src/processing/frametapsurface.h \
+	src/processing/imageadjustment.h \
+	src/processing/lenscalibration.h \
+	src/processing/lensundistortion.h \
+	src/processing/lineprofile.h \
+	src/processing/lumaimage.h \
+	src/processing/mosaicbuilder.h \
+	src/processing/mosaiccanvas.h \
+	src/processing/overlaytracker.h \
+	src/processing/phasecorrelator.h \
+	src/processing/polarunwrap.h \
+	src/processing/referencecomparison.h \
+	src/processing/remaptable.h \
+	src/processing/roistatistics.h \
+	src/processing/scanlinespans.h \
+	src/processing/simd.h \
+	src/processing/snapshotrenderer.h \
+	src/processing/windowlevel.h \
+	src/processing/workstealingpool.h \
+	src/recording/framerecorder.h \
+	src/recording/lzcodec.h \
+	src/recording/playbacksource.h \
+	src/recording/recordingcodec.h \
+	src/recording/recordingformat.h \
+	src/recording/recordingreader.h \
+	src/recording/recordingwriter.h
 
 FORMS +=  \
-	src/cameraextensionform.ui
+	src/cameraextensionform.ui \
+	src/cameraviewpanel.ui
 
 INCLUDEPATH += \
 	$$SHAREDIR \
 	src \
-	src/overlayitems
+	src/capture \
+	src/control \
+	src/export \
+	src/overlayitems \
+	src/processing \
+	src/recording
+
+#shm_open for the frame export is part of librt on older glibc versions
+unix:!macx {
+	LIBS += -lrt
+}
 
 
 #set system specific output directory for extension
@@ -1,4 +1,5 @@
 #include "cameraextension.h"
+#include "workstealingpool.h"
 
 
 CameraExtension::CameraExtension() : Extension() {
@@ -17,11 +18,23 @@ CameraExtension::CameraExtension() : Extension() {
 	
 	//settings
 	connect(this->form, &CameraExtensionForm::paramsChanged, this, &CameraExtension::storeParameters);
+
+	//forward drift estimates so they can be used outside of the extension
+	connect(this->form, &CameraExtensionForm::driftMeasured, this, &CameraExtension::driftMeasured);
+
+	//control API for scripts, listening while the extension is active
+	this->controlServer = new ControlServer(this->form, this);
+	connect(this->controlServer, &ControlServer::info, this, &CameraExtension::info);
+	connect(this->controlServer, &ControlServer::error, this, &CameraExtension::error);
 }
 
 
 CameraExtension::~CameraExtension() {
+	delete this->controlServer;
 	delete this->form;
+
+	//all analyzers are gone with the form, so the shared worker threads can be stopped
+	WorkStealingPool::shutdownGlobalInstance();
 }
 
 QWidget* CameraExtension::getWidget() {
@@ -32,11 +45,15 @@ QWidget* CameraExtension::getWidget() {
 void CameraExtension::activateExtension() {
 	//this method is called by OCTproZ as soon as user activates the extension. If the extension controls hardware components, they can be prepared, activated, initialized or started here.
 	//this->active = true;
+	this->controlServer->start();
+	this->form->getGovernor()->setExtensionActive(true);
 }
 
 void CameraExtension::deactivateExtension() {
 	//this method is called by OCTproZ as soon as user deactivates the extension. If the extension controls hardware components, they can be deactivated, resetted or stopped here.
 	//this->active = false;
+	this->controlServer->stop();
+	this->form->getGovernor()->setExtensionActive(false);
 }
 
 void CameraExtension::settingsLoaded(QVariantMap settings) {
@@ -44,6 +61,73 @@ void CameraExtension::settingsLoaded(QVariantMap settings) {
 	this->form->setSettings(settings); //update gui with stored settings
 }
 
+int CameraExtension::getViewCount() const {
+	return this->form->getViewCount();
+}
+
+QVariantMap CameraExtension::getFocusState(int viewIndex) const {
+	QVariantMap state;
+	CameraViewWidget* view = this->form->getView(viewIndex);
+	if(view == nullptr){
+		return state;
+	}
+	FocusResult result = view->getFocusResult();
+	state.insert("enabled", view->isFocusIndicatorEnabled());
+	state.insert("valid", result.valid);
+	state.insert("score", result.score);
+	state.insert("peak", result.peak);
+	state.insert("method", result.method == FocusMetric::TENENGRAD ? QString("tenengrad") : QString("laplacian_variance"));
+	state.insert("region", view->getFocusRegion());
+	state.insert("timestamp", result.timestamp);
+	return state;
+}
+
+QVariantMap CameraExtension::getDriftState(int viewIndex) const {
+	QVariantMap state;
+	CameraViewWidget* view = this->form->getView(viewIndex);
+	if(view == nullptr){
+		return state;
+	}
+	DriftEstimate estimate = view->getDriftEstimate();
+	state.insert("enabled", view->isDriftTrackingEnabled());
+	state.insert("valid", estimate.valid);
+	state.insert("dx", estimate.dx);
+	state.insert("dy", estimate.dy);
+	state.insert("rotation", estimate.rotation);
+	state.insert("confidence", estimate.confidence);
+	state.insert("reliable", estimate.reliable);
+	state.insert("region", estimate.region);
+	state.insert("timestamp", estimate.timestamp);
+	state.insert("frame_nr", estimate.frameNumber);
+	return state;
+}
+
+QVariantMap CameraExtension::getRoiStatistics(int viewIndex) const {
+	QVariantMap state;
+	CameraViewWidget* view = this->form->getView(viewIndex);
+	if(view == nullptr){
+		return state;
+	}
+	const RoiStatisticsMap statistics = view->getOverlayAnalysis()->getRoiStatistics();
+	for(auto it = statistics.constBegin(); it != statistics.constEnd(); ++it){
+		QVariantMap region;
+		QVariantList histogram;
+		for(quint32 count : it.value().histogram){
+			histogram.append(count);
+		}
+		region.insert("valid", it.value().valid);
+		region.insert("pixel_count", it.value().pixelCount);
+		region.insert("mean", it.value().mean);
+		region.insert("std_dev", it.value().stdDev);
+		region.insert("min", it.value().min);
+		region.insert("max", it.value().max);
+		region.insert("histogram", histogram);
+		region.insert("timestamp", it.value().timestamp);
+		state.insert(it.key(), region);
+	}
+	return state;
+}
+
 void CameraExtension::storeParameters() {
 	//update settingsMap, so parameters can be reloaded into gui at next start of application
 	this->form->getSettings(&this->settingsMap);
@@ -51,7 +135,7 @@ void CameraExtension::storeParameters() {
 }
 
 void CameraExtension::rawDataReceived(void* buffer, unsigned bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame, unsigned int framesPerBuffer, unsigned int buffersPerVolume, unsigned int currentBufferNr) {
-	//do nothing here as we do not need the raw data. Q_UNUSED is used to suppress compiler warnings
+	//the raw data itself is not needed, only its cadence tells whether OCTproZ is acquiring. Q_UNUSED is used to suppress compiler warnings
 	Q_UNUSED(buffer)
 	Q_UNUSED(bitDepth)
 	Q_UNUSED(samplesPerLine)
@@ -59,6 +143,7 @@ void CameraExtension::rawDataReceived(void* buffer, unsigned bitDepth, unsigned
 	Q_UNUSED(framesPerBuffer)
 	Q_UNUSED(buffersPerVolume)
 	Q_UNUSED(currentBufferNr)
+	this->form->getGovernor()->notifyRawData();
 }
 
 void CameraExtension::processedDataReceived(void* buffer, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame, unsigned int framesPerBuffer, unsigned int buffersPerVolume, unsigned int currentBufferNr) {
@@ -68,5 +153,8 @@ void CameraExtension::processedDataReceived(void* buffer, unsigned int bitDepth,
 	Q_UNUSED(linesPerFrame)
 	Q_UNUSED(framesPerBuffer)
 	Q_UNUSED(buffersPerVolume)
-	Q_UNUSED(currentBufferNr)
+
+	//log latest sample drift together with the buffer number, so OCT data can be corrected for motion afterwards. does nothing if logging is not active
+	this->form->logBuffer(currentBufferNr);
+	this->form->getGovernor()->notifyProcessedData();
 }
@@ -6,6 +6,7 @@
 #include "octproz_devkit.h"
 #include "cameraviewwidget.h"
 #include "cameraextensionform.h"
+#include "controlserver.h"
 
 
 class CameraExtension : public Extension
@@ -23,9 +24,18 @@ public:
 	virtual void deactivateExtension() override;
 	virtual void settingsLoaded(QVariantMap settings) override;
 
+	//can be queried by OCTproZ (or other plugins) via QMetaObject::invokeMethod
+	//viewIndex selects the camera view, 0 is the view in the main extension window
+	Q_INVOKABLE int getViewCount() const;
+	Q_INVOKABLE QVariantMap getFocusState(int viewIndex = 0) const;
+	Q_INVOKABLE QVariantMap getDriftState(int viewIndex = 0) const;
+	//intensity statistics per overlay name, see RoiStatistics
+	Q_INVOKABLE QVariantMap getRoiStatistics(int viewIndex = 0) const;
+
 private:
 	CameraExtensionForm* form;
 	CameraViewWidget* cameraWidget;
+	ControlServer* controlServer;
 
 public slots:
 	void storeParameters();
@@ -33,7 +43,7 @@ public slots:
 	virtual void processedDataReceived(void* buffer, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame, unsigned int framesPerBuffer, unsigned int buffersPerVolume, unsigned int currentBufferNr) override;
 
 signals:
-
+	void driftMeasured(int viewIndex, DriftEstimate estimate);
 };
 
 #endif // CAMERAEXTENSION_H
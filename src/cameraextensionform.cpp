@@ -1,86 +1,182 @@
 #include "cameraextensionform.h"
-#include "camerasettingsdialog.h"
 #include "ui_cameraextensionform.h"
-#include <QTimer>
+#include <QtMath>
 
 
 CameraExtensionForm::CameraExtensionForm(QWidget *parent) :
 	QWidget(parent),
-	ui(new Ui::CameraExtensionForm) {
+	ui(new Ui::CameraExtensionForm),
+	separateWindows(false),
+	governor(new AcquisitionGovernor(this)),
+	deviceConfigs(new CameraDeviceConfigStore(this)) {
 	ui->setupUi(this);
-	fillCameraComboBox();
-
-	connect(ui->comboBox_camera, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),this, &CameraExtensionForm::connectToSelectedCamera);
-	connect(ui->toolButton_settings, &QToolButton::clicked, this, &CameraExtensionForm::openSettingsDialog);
-	connect(ui->toolButton_reload, &QToolButton::clicked, this, &CameraExtensionForm::fillCameraComboBox);
-	connect(ui->widget_video, &CameraViewWidget::info, this, &CameraExtensionForm::info);
-	connect(ui->widget_video, &CameraViewWidget::error, this, &CameraExtensionForm::error);
-
-	//connect to save changed CameraViewWidget settings
-	connect(ui->widget_video, &CameraViewWidget::overlayStateChanged, this, &CameraExtensionForm::paramsChanged);
-	connect(ui->widget_video, &CameraViewWidget::rotationAngleChanged, this, [this](qreal rotationAngle) {
-		this->parameters.rotationAngle = rotationAngle;
-		emit this->paramsChanged();
-	});
-	connect(ui->widget_video, &CameraViewWidget::currentCameraChanged, this, [this](QString cameraName) {
-		this->parameters.selectedCamera = cameraName;
-		emit this->paramsChanged();
-	});	
-	connect(ui->widget_video, &CameraViewWidget::snapshotDirChanged, this, [this](QString snapshotDir) {
-		this->parameters.snapShotSavePath = snapshotDir;
-		emit this->paramsChanged();
+
+	//camera settings are stored per device, not per view
+	connect(this->deviceConfigs, &CameraDeviceConfigStore::configChanged, this, &CameraExtensionForm::paramsChanged);
+
+	//all views share one governor, it limits their load while OCTproZ acquires
+	connect(this->governor, &AcquisitionGovernor::settingsChanged, this, &CameraExtensionForm::paramsChanged);
+	connect(this->governor, &AcquisitionGovernor::acquisitionStateChanged, this, [this](bool active) {
+		if(this->governor->getSettings().enabled){
+			emit info(active ? tr("OCTproZ acquisition detected, camera display and analysis are throttled.") : tr("OCTproZ acquisition stopped, camera display and analysis run at full rate."));
+		}
 	});
 
+	//there is always at least one camera view
+	this->addView();
+
 	this->installEventFilter(this);
 }
 
 CameraExtensionForm::~CameraExtensionForm() {
+	QWriteLocker locker(&this->panelsLock);
+	//panels in separate windows have no parent and need to be deleted explicitly
+	for(CameraViewPanel* panel : this->panels){
+		delete panel;
+	}
+	this->panels.clear();
 	delete ui;
 }
 
-void CameraExtensionForm::setSettings(QVariantMap settings){
-	//update parameters struct, use default values if empty
-	this->parameters.selectedCamera = settings.value(CAMERA_SELECTION, "").toString();
-	this->parameters.rotationAngle = settings.value(CAMERA_ROTATION_ANGLE, 0.0).toDouble();
-	this->parameters.snapShotSavePath = settings.value(CAMERA_SNAPSHOT_SAVE_PATH, "").toString();
-	this->parameters.windowState = settings.value(CAMERA_WINDOW_STATE).toByteArray();
+CameraViewWidget* CameraExtensionForm::getView(int index) const {
+	if(index < 0 || index >= this->panels.size()){
+		return nullptr;
+	}
+	return this->panels.at(index)->getView();
+}
 
-	//apply parameters to widgets
-	this->ui->widget_video->setSnapshotSaveDir(this->parameters.snapShotSavePath);
-	this->ui->widget_video->rotateAbsolute(this->parameters.rotationAngle);
-	this->connectToCamera(this->parameters.selectedCamera);
+void CameraExtensionForm::logBuffer(unsigned int currentBufferNr) {
+	QReadLocker locker(&this->panelsLock);
+	for(CameraViewPanel* panel : this->panels){
+		panel->getView()->getDriftLogger()->logBuffer(currentBufferNr);
+	}
+}
 
-	//update gui to represent correct settings
-	int index = this->ui->comboBox_camera->findData(this->parameters.selectedCamera);
-	if (index != -1) {
-		disconnect(ui->comboBox_camera, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &CameraExtensionForm::connectToSelectedCamera);
-		this->ui->comboBox_camera->setCurrentIndex(index);
-		connect(ui->comboBox_camera, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &CameraExtensionForm::connectToSelectedCamera);
+void CameraExtensionForm::setSettings(QVariantMap settings){
+	//update parameters, use default values if empty
+	this->windowState = settings.value(CAMERA_WINDOW_STATE).toByteArray();
+	int viewCount = qMax(1, settings.value(CAMERA_VIEW_COUNT, 1).toInt());
+	bool separate = settings.value(CAMERA_SEPARATE_WINDOWS, false).toBool();
+	GovernorSettings governorSettings;
+	governorSettings.enabled = settings.value(CAMERA_GOVERNOR_ENABLED, governorSettings.enabled).toBool();
+	governorSettings.displayRateLimit = qMax(0, settings.value(CAMERA_GOVERNOR_DISPLAY_RATE, governorSettings.displayRateLimit).toInt());
+	governorSettings.idlePriority = settings.value(CAMERA_GOVERNOR_IDLE_PRIORITY, governorSettings.idlePriority).toBool();
+	governorSettings.excludedCores = AcquisitionGovernor::coresFromString(settings.value(CAMERA_GOVERNOR_EXCLUDED_CORES).toString());
+	this->governor->setSettings(governorSettings);
+	this->deviceConfigs->setSettings(settings.value(CAMERA_DEVICE_CONFIGS).toMap());
+
+	//create views and apply their settings
+	while(this->panels.size() < viewCount){
+		this->addView();
+	}
+	this->setSeparateWindows(separate);
+	for(CameraViewPanel* panel : this->panels){
+		panel->setSettings(settings);
 	}
 
 	//restore window geometry
-	this->restoreGeometry(this->parameters.windowState);
-
-	//update overlays
-	auto overlays = this->ui->widget_video->getOverlays();
-	for (const auto &overlay : overlays) {
-		if (settings.contains(overlay.second + "_state")) {
-			QVariantMap overlayState = settings.value(overlay.second + "_state").toMap();
-			overlay.first->loadState(overlayState);
-		}
-	}
+	this->restoreGeometry(this->windowState);
 }
 
 void CameraExtensionForm::getSettings(QVariantMap* settings) {
-	settings->insert(CAMERA_SELECTION, this->parameters.selectedCamera);
-	settings->insert(CAMERA_ROTATION_ANGLE, this->parameters.rotationAngle);
-	settings->insert(CAMERA_SNAPSHOT_SAVE_PATH, this->parameters.snapShotSavePath);
-	settings->insert(CAMERA_WINDOW_STATE, this->parameters.windowState);
+	settings->insert(CAMERA_WINDOW_STATE, this->windowState);
+	settings->insert(CAMERA_VIEW_COUNT, this->panels.size());
+	settings->insert(CAMERA_SEPARATE_WINDOWS, this->separateWindows);
+	GovernorSettings governorSettings = this->governor->getSettings();
+	settings->insert(CAMERA_GOVERNOR_ENABLED, governorSettings.enabled);
+	settings->insert(CAMERA_GOVERNOR_DISPLAY_RATE, governorSettings.displayRateLimit);
+	settings->insert(CAMERA_GOVERNOR_IDLE_PRIORITY, governorSettings.idlePriority);
+	settings->insert(CAMERA_GOVERNOR_EXCLUDED_CORES, AcquisitionGovernor::coresToString(governorSettings.excludedCores));
+	settings->insert(CAMERA_DEVICE_CONFIGS, this->deviceConfigs->getSettings());
+	for(CameraViewPanel* panel : this->panels){
+		panel->getSettings(settings);
+	}
+}
+
+CameraViewPanel* CameraExtensionForm::addView() {
+	CameraViewPanel* panel = new CameraViewPanel(this->panels.size(), this);
+	panel->setSeparateWindowMode(this->separateWindows);
+	panel->getView()->setGovernor(this->governor);
+	panel->getView()->setDeviceConfigStore(this->deviceConfigs);
+	connect(panel, &CameraViewPanel::info, this, &CameraExtensionForm::info);
+	connect(panel, &CameraViewPanel::error, this, &CameraExtensionForm::error);
+	connect(panel, &CameraViewPanel::paramsChanged, this, &CameraExtensionForm::paramsChanged);
+	connect(panel, &CameraViewPanel::addViewRequested, this, &CameraExtensionForm::addView);
+	connect(panel, &CameraViewPanel::removeViewRequested, this, &CameraExtensionForm::removeView);
+	connect(panel, &CameraViewPanel::separateWindowsRequested, this, &CameraExtensionForm::setSeparateWindows);
+	connect(panel->getView(), &CameraViewWidget::driftMeasured, this, [this, panel](DriftEstimate estimate) {
+		emit this->driftMeasured(panel->getIndex(), estimate);
+	});
+
+	this->panelsLock.lockForWrite();
+	this->panels.append(panel);
+	this->panelsLock.unlock();
+
+	this->arrangeViews();
+	emit paramsChanged();
+	return panel;
+}
+
+void CameraExtensionForm::removeView(CameraViewPanel* panel) {
+	int index = this->panels.indexOf(panel);
+	if(index <= 0){
+		return;
+	}
+	panel->disconnectCurrentCamera();
+
+	this->panelsLock.lockForWrite();
+	this->panels.removeAt(index);
+	this->panelsLock.unlock();
+	panel->deleteLater();
 
-	//save states of overlays
-	auto overlays = this->ui->widget_video->getOverlays();
-	for (auto &overlay : overlays) {
-		settings->insert(overlay.second + "_state", overlay.first->saveState());
+	//views after the removed one move up and store their settings with the new key prefix
+	for(int i = index; i < this->panels.size(); i++){
+		this->panels.at(i)->setIndex(i);
+	}
+	this->arrangeViews();
+	emit paramsChanged();
+}
+
+void CameraExtensionForm::setSeparateWindows(bool separate) {
+	if(this->separateWindows == separate){
+		return;
+	}
+	this->separateWindows = separate;
+	for(CameraViewPanel* panel : this->panels){
+		panel->setSeparateWindowMode(separate);
+	}
+	this->arrangeViews();
+	emit paramsChanged();
+}
+
+void CameraExtensionForm::arrangeViews() {
+	for(CameraViewPanel* panel : this->panels){
+		this->ui->gridLayout_views->removeWidget(panel);
+	}
+
+	//the first view always stays in the extension window. other views are tiled next to it or get their own window
+	QList<CameraViewPanel*> tiledPanels;
+	for(CameraViewPanel* panel : this->panels){
+		bool ownWindow = this->separateWindows && panel->getIndex() != 0;
+		if(ownWindow){
+			if(!panel->isWindow()){
+				panel->setParent(nullptr, Qt::Window);
+				if(this->isVisible()){
+					panel->show();
+				}
+			}
+		} else {
+			if(panel->isWindow()){
+				panel->setParent(this, Qt::Widget);
+			}
+			tiledPanels.append(panel);
+		}
+	}
+
+	int columns = qCeil(qSqrt(tiledPanels.size()));
+	for(int i = 0; i < tiledPanels.size(); i++){
+		this->ui->gridLayout_views->addWidget(tiledPanels.at(i), i/columns, i%columns);
+		tiledPanels.at(i)->show();
 	}
 }
 
@@ -88,7 +184,7 @@ bool CameraExtensionForm::eventFilter(QObject* watched, QEvent* event) {
 	if (watched == this) {
 		if (event->type() == QEvent::Resize || event->type() == QEvent::Move) {
 			if (this->isVisible()) {
-				this->parameters.windowState = this->saveGeometry();
+				this->windowState = this->saveGeometry();
 				emit paramsChanged();
 			}
 		}
@@ -96,47 +192,21 @@ bool CameraExtensionForm::eventFilter(QObject* watched, QEvent* event) {
 	return QWidget::eventFilter(watched, event);
 }
 
-void CameraExtensionForm::openSettingsDialog() {
-	QCamera* currentCamera = ui->widget_video->getCamera();
-	QList<QCameraViewfinderSettings> supportedSettings = ui->widget_video->getSupportedSettings();
-	if(currentCamera) {
-		CameraSettingsDialog dialog(currentCamera, supportedSettings, this);
-		dialog.exec();
-	} else {
-		qDebug() << "No camera is currently selected or available.";
-	}
-}
-
-void CameraExtensionForm::connectToSelectedCamera() {
-	QString selectedCamera = this->ui->comboBox_camera->currentData().toString();
-	this->connectToCamera(selectedCamera);
-}
-
-void CameraExtensionForm::disconnectCurrentCamera() {
-	this->ui->widget_video->closeCamera();
-}
-
-void CameraExtensionForm::fillCameraComboBox() {
-	this->ui->comboBox_camera->clear();
-	QList<QCameraInfo> cameras = QCameraInfo::availableCameras();
-	for(const QCameraInfo &cameraInfo : cameras) {
-		this->ui->comboBox_camera->addItem(cameraInfo.description(), cameraInfo.deviceName());
+void CameraExtensionForm::showEvent(QShowEvent* event) {
+	QWidget::showEvent(event);
+	for(CameraViewPanel* panel : this->panels){
+		if(panel->isWindow()){
+			panel->show();
+		}
 	}
 }
 
-void CameraExtensionForm::connectToCamera(QString deviceName) {
-	if(deviceName.isEmpty()){
-		return;
-	}
-	QList<QCameraInfo> cameras = QCameraInfo::availableCameras();
-	for(const QCameraInfo &cameraInfo : cameras) {
-		if (cameraInfo.deviceName() == deviceName) {
-			if(!this->ui->widget_video->isVisible()){
-				this->ui->widget_video->setCamera(cameraInfo);
-			} else {
-				QTimer::singleShot(0, this, [this, cameraInfo]() { this->ui->widget_video->openCamera(cameraInfo); });
-			}
-			break;
+void CameraExtensionForm::hideEvent(QHideEvent* event) {
+	QWidget::hideEvent(event);
+	//separate camera windows belong to the extension window
+	for(CameraViewPanel* panel : this->panels){
+		if(panel->isWindow()){
+			panel->hide();
 		}
 	}
 }
@@ -2,7 +2,12 @@
 #define CAMERAEXTENSIONFORM_H
 
 #include <QWidget>
+#include <QReadWriteLock>
 #include "cameraextensionparameters.h"
+#include "cameraviewpanel.h"
+#include "cameraviewwidget.h"
+#include "acquisitiongovernor.h"
+#include "cameradeviceconfig.h"
 
 namespace Ui {
 class CameraExtensionForm;
@@ -19,20 +24,34 @@ public:
 	void setSettings(QVariantMap settings);
 	void getSettings(QVariantMap* settings);
 
+	int getViewCount() const {return this->panels.size();}
+	CameraViewWidget* getView(int index) const;
+	//called from the thread that delivers processed OCT data
+	void logBuffer(unsigned int currentBufferNr);
+	AcquisitionGovernor* getGovernor() const {return this->governor;}
+	CameraDeviceConfigStore* getDeviceConfigs() const {return this->deviceConfigs;}
+
 	Ui::CameraExtensionForm* ui;
 
 protected:
 	bool eventFilter(QObject* watched, QEvent* event) override;
+	void showEvent(QShowEvent* event) override;
+	void hideEvent(QHideEvent* event) override;
 
 public slots:
-	void connectToSelectedCamera();
-	void disconnectCurrentCamera();
-	void openSettingsDialog();
+	CameraViewPanel* addView();
+	void removeView(CameraViewPanel* panel);
+	void setSeparateWindows(bool separate);
 
 private:
-	void fillCameraComboBox();
-	void connectToCamera(QString deviceName);
-	CameraExtensionParameters parameters;
+	QList<CameraViewPanel*> panels;
+	QReadWriteLock panelsLock;
+	bool separateWindows;
+	QByteArray windowState;
+	AcquisitionGovernor* governor;
+	CameraDeviceConfigStore* deviceConfigs;
+
+	void arrangeViews();
 
 signals:
 	void paramsChanged();
@@ -41,6 +60,7 @@ signals:
 	void aboutToClose();
 	void info(QString);
 	void error(QString);
+	void driftMeasured(int viewIndex, DriftEstimate estimate);
 
 };
 
@@ -10,12 +10,57 @@
 #define CAMERA_ROTATION_ANGLE "camera_rotation_angle"
 #define CAMERA_SNAPSHOT_SAVE_PATH "snapshot_save_path"
 #define CAMERA_WINDOW_STATE "camera_window_state"
+#define CAMERA_VIEW_COUNT "camera_view_count"
+#define CAMERA_SEPARATE_WINDOWS "camera_separate_windows"
+#define CAMERA_FOCUS_INDICATOR_ENABLED "focus_indicator_enabled"
+#define CAMERA_FOCUS_METHOD "focus_method"
+#define CAMERA_FOCUS_REGION "focus_region"
+#define CAMERA_ROI_STATISTICS_ENABLED "roi_statistics_enabled"
+#define CAMERA_LINE_PROFILE_ENABLED "line_profile_enabled"
+#define CAMERA_LINE_PROFILE_WIDTH "line_profile_width"
+#define CAMERA_POLAR_UNWRAP_ENABLED "polar_unwrap_enabled"
+#define CAMERA_POLAR_UNWRAP_BAND "polar_unwrap_band"
+#define CAMERA_REFERENCE_PATH "reference_path"
+#define CAMERA_REFERENCE_MODE "reference_mode"
+#define CAMERA_REFERENCE_OPACITY "reference_opacity"
+#define CAMERA_REFERENCE_GAIN "reference_gain"
+#define CAMERA_DISPLAY_MIPMAP "display_mipmap"
+#define CAMERA_DRIFT_TRACKING_ENABLED "drift_tracking_enabled"
+#define CAMERA_DRIFT_ROTATION_ENABLED "drift_rotation_enabled"
+#define CAMERA_DRIFT_REGION "drift_region"
+#define CAMERA_OVERLAY_LOCK_ENABLED "overlay_lock_enabled"
+#define CAMERA_RECORDING_COMPRESSION "recording_compression"
+#define CAMERA_FRAME_EXPORT "frame_export"
+#define CAMERA_GOVERNOR_ENABLED "governor_enabled"
+#define CAMERA_GOVERNOR_DISPLAY_RATE "governor_display_rate"
+#define CAMERA_GOVERNOR_IDLE_PRIORITY "governor_idle_priority"
+#define CAMERA_GOVERNOR_EXCLUDED_CORES "governor_excluded_cores"
+#define CAMERA_DEVICE_CONFIGS "device_configs"
 
 struct CameraExtensionParameters {
 	QString selectedCamera;
 	qreal rotationAngle;
 	QString snapShotSavePath;
 	QByteArray windowState;
+	bool focusIndicatorEnabled;
+	int focusMethod;
+	QString focusRegion;
+	bool roiStatisticsEnabled;
+	bool lineProfileEnabled;
+	int lineProfileWidth;
+	bool polarUnwrapEnabled;
+	int polarUnwrapBand;
+	QString referencePath;
+	int referenceMode;
+	qreal referenceOpacity;
+	int referenceGain;
+	bool displayMipmap;
+	bool driftTrackingEnabled;
+	bool driftRotationEnabled;
+	QString driftRegion;
+	bool overlayLockEnabled;
+	bool recordingCompression;
+	bool frameExport;
 };
 Q_DECLARE_METATYPE(CameraExtensionParameters)
 
@@ -6,11 +6,13 @@
 #include <QCameraZoomControl>
 
 
-CameraSettingsDialog::CameraSettingsDialog(QCamera* existingCamera, QList<QCameraViewfinderSettings> existingSupportedSettings, QWidget* parent)
+CameraSettingsDialog::CameraSettingsDialog(QCamera* existingCamera, QList<QCameraViewfinderSettings> existingSupportedSettings, ImageAdjustment* imageAdjustment, QWidget* parent)
 	: QDialog(parent), 
 	  camera(existingCamera),
-	  supportedSettings(existingSupportedSettings)
+	  supportedSettings(existingSupportedSettings),
+	  imageAdjustment(imageAdjustment)
 {
+	this->capabilities = CameraCapabilities::load(QCameraInfo(*existingCamera).deviceName());
 	setupUi();
 }
 
@@ -29,12 +31,30 @@ void CameraSettingsDialog::setupUi() {
 		addCameraImageProcessingControl(tr("Contrast"), QCameraImageProcessingControl::Contrast);
 		addCameraImageProcessingControl(tr("Saturation"), QCameraImageProcessingControl::Saturation);
 		addCameraImageProcessingControl(tr("Sharpening"), QCameraImageProcessingControl::Sharpening);
+	} else if (this->imageAdjustment != nullptr) {
+		//the camera has no image processing controls, the same sliders drive the software processing of the displayed frames
+		addSoftwareAdjustmentControl(tr("Brightness"), &ImageAdjustmentSettings::brightness, -1.0, 1.0);
+		addSoftwareAdjustmentControl(tr("Contrast"), &ImageAdjustmentSettings::contrast, -1.0, 1.0);
+		addSoftwareAdjustmentControl(tr("Sharpening"), &ImageAdjustmentSettings::sharpening, 0.0, 1.0);
+	}
+	if (this->imageAdjustment != nullptr) {
+		addSoftwareAdjustmentControl(tr("Gamma"), &ImageAdjustmentSettings::gamma, 0.2, 5.0);
+		addFalseColorControl();
 	}
 	this->addResolutionAndFpsControl();
 	this->addPixelFormatControl();
 	this->addColorFilterControl();
 	this->addZoomControl();
 
+	//measuring needs the camera exclusively, so the dialog is closed and the camera view takes over
+	QPushButton *probeButton = new QPushButton(this->capabilities.isEmpty() ? tr("Measure camera modes") : tr("Measure camera modes again"), this);
+	probeButton->setToolTip(tr("Opens the camera with every mode and measures the frame rate that is actually delivered. The live view is interrupted while measuring."));
+	connect(probeButton, &QPushButton::clicked, this, [this]() {
+		emit probeRequested();
+		this->accept();
+	});
+	this->layout->addWidget(probeButton);
+
 	QPushButton *closeButton = new QPushButton(tr("Close"), this);
 	connect(closeButton, &QPushButton::clicked, this, &CameraSettingsDialog::accept);
 	this->layout->addWidget(closeButton);
@@ -115,6 +135,59 @@ void CameraSettingsDialog::addCameraImageProcessingControl(const QString &labelT
 	this->layout->addLayout(hLayout);
 }
 
+void CameraSettingsDialog::addSoftwareAdjustmentControl(const QString &labelText, qreal ImageAdjustmentSettings::*value, qreal minValue, qreal maxValue) {
+	QHBoxLayout *hLayout = new QHBoxLayout();
+	QLabel *label = new QLabel(labelText, this);
+	label->setToolTip(tr("Applied in software to the displayed frames. Recordings and shared frames stay unmodified."));
+	this->standardizeLabelSize(label);
+	QSlider *slider = new QSlider(Qt::Horizontal, this);
+	QDoubleSpinBox *doubleSpinBox = new QDoubleSpinBox(this);
+	slider->setRange(static_cast<int>(minValue * 100), static_cast<int>(maxValue * 100));
+	doubleSpinBox->setRange(minValue, maxValue);
+	doubleSpinBox->setSingleStep(0.01);
+
+	qreal initialValue = this->imageAdjustment->getSettings().*value;
+	slider->setValue(static_cast<int>(initialValue * 100));
+	doubleSpinBox->setValue(initialValue);
+
+	connect(slider, &QSlider::valueChanged, this, [doubleSpinBox](int sliderValue) {
+		doubleSpinBox->setValue(sliderValue / 100.0);
+	});
+	connect(doubleSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [slider](double spinBoxValue) {
+		slider->setValue(static_cast<int>(spinBoxValue * 100));
+	});
+	ImageAdjustment* adjustment = this->imageAdjustment;
+	connect(doubleSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, [adjustment, value](double spinBoxValue) {
+		ImageAdjustmentSettings settings = adjustment->getSettings();
+		settings.*value = spinBoxValue;
+		adjustment->setSettings(settings);
+	});
+
+	hLayout->addWidget(label);
+	hLayout->addWidget(slider);
+	hLayout->addWidget(doubleSpinBox);
+	this->layout->addLayout(hLayout);
+}
+
+void CameraSettingsDialog::addFalseColorControl() {
+	QComboBox *comboBox = new QComboBox(this);
+	comboBox->addItems(ImageAdjustment::falseColorNames());
+	comboBox->setCurrentIndex(this->imageAdjustment->getSettings().falseColor);
+	ImageAdjustment* adjustment = this->imageAdjustment;
+	connect(comboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [adjustment](int index) {
+		ImageAdjustmentSettings settings = adjustment->getSettings();
+		settings.falseColor = index;
+		adjustment->setSettings(settings);
+	});
+
+	QHBoxLayout *hLayout = new QHBoxLayout();
+	QLabel *label = new QLabel(tr("False Color"), this);
+	this->standardizeLabelSize(label);
+	hLayout->addWidget(label);
+	hLayout->addWidget(comboBox);
+	this->layout->addLayout(hLayout);
+}
+
 void CameraSettingsDialog::addColorFilterControl() {
 	QCameraImageProcessing *imageProcessing = this->camera->imageProcessing();
 	if (!imageProcessing->isAvailable()) {
@@ -203,35 +276,24 @@ void CameraSettingsDialog::addResolutionAndFpsControl() {
 	QComboBox *comboBox = new QComboBox(this);
 
 	//get resolution/fps combinations and populate combobox
-	const QList<QCameraViewfinderSettings> supportedSettings = this->supportedSettings;
-	if(!supportedSettings.isEmpty()){
-		for(const QCameraViewfinderSettings &settings : supportedSettings) {
-			QString resolutionFps = QString("%1x%2, %3 FPS")
-										.arg(settings.resolution().width())
-										.arg(settings.resolution().height())
-										.arg(settings.minimumFrameRate());
-			comboBox->addItem(resolutionFps, QVariant::fromValue(settings));
+	QList<QCameraViewfinderSettings> modes = this->supportedSettings;
+	if(modes.isEmpty() && !this->capabilities.isEmpty()){
+		//measured modes replace the guessed fallback list
+		for(const ProbedMode& mode : this->capabilities.modes){
+			modes.append(mode.settings);
 		}
-	} else {
+	}
+	if(modes.isEmpty()){
 		//on some tested systems (Jetson Nano) supportedViewfinderSettings() is empty. In this case we generate some common resolution fps combinations and hope that these are supported by the used camera system
-		struct ResolutionFps { int width; int height; qreal fps; };
-		QList<ResolutionFps> standardSettings = {
-			{320, 240, 20},
-			{640, 480, 20},
-			{640, 480, 5},
-			{960, 720, 20},
-			{1280, 720, 20}
-		};
-
-		for (const auto &setting : standardSettings) {
-			QCameraViewfinderSettings standardSetting;
-			standardSetting.setResolution(setting.width, setting.height);
-			standardSetting.setMinimumFrameRate(setting.fps);
-			standardSetting.setMaximumFrameRate(setting.fps);
-
-			QString resolutionFps = QString("%1x%2, %3 FPS").arg(setting.width).arg(setting.height).arg(setting.fps);
-			comboBox->addItem(resolutionFps, QVariant::fromValue(standardSetting));
+		modes = CameraCapabilities::fallbackModes();
+	}
+	for(const QCameraViewfinderSettings &settings : modes) {
+		//modes that were measured and did not deliver frames are not offered
+		const ProbedMode* probedMode = this->capabilities.find(settings);
+		if(probedMode != nullptr && !probedMode->valid){
+			continue;
 		}
+		comboBox->addItem(this->modeText(settings), QVariant::fromValue(settings));
 	}
 	
 	if (comboBox->count() > 0) {
@@ -255,14 +317,11 @@ void CameraSettingsDialog::addResolutionAndFpsControl() {
 
 void CameraSettingsDialog::addCurrentResolutionSettingsToComboBox(QComboBox* comboBox, const QCamera* camera) {
 	QCameraViewfinderSettings currentSettings = camera->viewfinderSettings();
-	QString currentSettingsText = QString("%1x%2, %3 FPS")
-										.arg(currentSettings.resolution().width())
-										.arg(currentSettings.resolution().height())
-										.arg(currentSettings.minimumFrameRate());
+	QString currentSettingsText = this->modeText(currentSettings);
 
 	bool found = false;
 	for (int i = 0; i < comboBox->count(); ++i) {
-		if (comboBox->itemText(i) == currentSettingsText) {
+		if (CameraCapabilities::isSameMode(comboBox->itemData(i).value<QCameraViewfinderSettings>(), currentSettings)) {
 			found = true;
 			comboBox->setCurrentIndex(i);
 			break;
@@ -275,6 +334,15 @@ void CameraSettingsDialog::addCurrentResolutionSettingsToComboBox(QComboBox* com
 	}
 }
 
+QString CameraSettingsDialog::modeText(const QCameraViewfinderSettings& settings) const {
+	QString text = CameraCapabilities::modeToString(settings);
+	const ProbedMode* probedMode = this->capabilities.find(settings);
+	if(probedMode != nullptr && probedMode->valid){
+		text += tr(" (measured %1 FPS, first frame after %2 ms)").arg(probedMode->measuredFps, 0, 'f', 1).arg(probedMode->firstFrameMs);
+	}
+	return text;
+}
+
 void CameraSettingsDialog::addZoomControl() {
 	QCameraZoomControl *zoomControl = this->camera->service()->requestControl<QCameraZoomControl*>();
 	if (!zoomControl) {
@@ -12,29 +12,39 @@
 #include <QDebug>
 #include <QMetaEnum>
 #include <QComboBox>
+#include "cameracapabilities.h"
+#include "imageadjustment.h"
 
 
 class CameraSettingsDialog : public QDialog {
 	Q_OBJECT
 
 public:
-	explicit CameraSettingsDialog(QCamera *camera, QList<QCameraViewfinderSettings> supportedSettings, QWidget *parent = nullptr);
+	explicit CameraSettingsDialog(QCamera *camera, QList<QCameraViewfinderSettings> supportedSettings, ImageAdjustment* imageAdjustment, QWidget *parent = nullptr);
 	~CameraSettingsDialog();
 
 private:
 	QCamera* camera;
 	QList<QCameraViewfinderSettings> supportedSettings;
 	QVBoxLayout* layout;
+	DeviceCapabilities capabilities;
+	ImageAdjustment* imageAdjustment;
 	
 	void setupUi();
 	void addCameraImageProcessingControl(const QString &labelText, QCameraImageProcessingControl::ProcessingParameter param);
+	void addSoftwareAdjustmentControl(const QString &labelText, qreal ImageAdjustmentSettings::*value, qreal minValue, qreal maxValue);
+	void addFalseColorControl();
 	void addColorFilterControl();
 	void addPixelFormatControl();
 	void addResolutionAndFpsControl();
 	void addCurrentResolutionSettingsToComboBox(QComboBox* comboBox, const QCamera* camera);
+	QString modeText(const QCameraViewfinderSettings& settings) const;
 	QString pixelFormatToString(QVideoFrame::PixelFormat format);
 	void addZoomControl();
 	void standardizeLabelSize(QLabel *label);
+
+signals:
+	void probeRequested();
 };
 
 #endif //CAMERASETTINGSDIALOG_H
@@ -0,0 +1,372 @@
+#include "cameraviewpanel.h"
+#include "camerasettingsdialog.h"
+#include "ui_cameraviewpanel.h"
+#include "playbackcontrols.h"
+#include "lineprofileview.h"
+#include "polarunwrapview.h"
+#include <QTimer>
+#include <QMenu>
+#include <QCloseEvent>
+
+
+CameraViewPanel::CameraViewPanel(int index, QWidget *parent) :
+	QWidget(parent),
+	ui(new Ui::CameraViewPanel),
+	index(-1),
+	separateWindowMode(false),
+	playbackControls(nullptr),
+	lineProfileView(nullptr),
+	polarUnwrapView(nullptr) {
+	ui->setupUi(this);
+	this->setMinimumSize(160, 160);
+	this->setIndex(index);
+	fillCameraComboBox();
+	this->setupViewsMenu();
+
+	connect(ui->comboBox_camera, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),this, &CameraViewPanel::connectToSelectedCamera);
+	connect(ui->toolButton_settings, &QToolButton::clicked, this, &CameraViewPanel::openSettingsDialog);
+	connect(ui->toolButton_reload, &QToolButton::clicked, this, &CameraViewPanel::fillCameraComboBox);
+	connect(ui->widget_video, &CameraViewWidget::info, this, &CameraViewPanel::info);
+	connect(ui->widget_video, &CameraViewWidget::error, this, &CameraViewPanel::error);
+
+	//connect to save changed CameraViewWidget settings
+	connect(ui->widget_video, &CameraViewWidget::overlayStateChanged, this, &CameraViewPanel::paramsChanged);
+	connect(ui->widget_video, &CameraViewWidget::rotationAngleChanged, this, [this](qreal rotationAngle) {
+		this->parameters.rotationAngle = rotationAngle;
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video, &CameraViewWidget::currentCameraChanged, this, [this](QString cameraName) {
+		this->parameters.selectedCamera = cameraName;
+		//camera may have been switched without the combo box (e.g. via the control API)
+		int index = this->ui->comboBox_camera->findData(cameraName);
+		if(index != -1 && index != this->ui->comboBox_camera->currentIndex()){
+			QSignalBlocker blocker(this->ui->comboBox_camera);
+			this->ui->comboBox_camera->setCurrentIndex(index);
+		}
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video, &CameraViewWidget::snapshotDirChanged, this, [this](QString snapshotDir) {
+		this->parameters.snapShotSavePath = snapshotDir;
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video, &CameraViewWidget::focusSettingsChanged, this, [this]() {
+		this->parameters.focusIndicatorEnabled = this->ui->widget_video->isFocusIndicatorEnabled();
+		this->parameters.focusMethod = this->ui->widget_video->getFocusMethod();
+		this->parameters.focusRegion = this->ui->widget_video->getFocusRegion();
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video->getOverlayAnalysis(), &OverlayAnalysisController::roiStatisticsChanged, this, [this](bool enabled) {
+		this->parameters.roiStatisticsEnabled = enabled;
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video->getOverlayAnalysis(), &OverlayAnalysisController::lineProfileSettingsChanged, this, [this]() {
+		this->parameters.lineProfileEnabled = this->ui->widget_video->getOverlayAnalysis()->isLineProfileEnabled();
+		this->parameters.lineProfileWidth = this->ui->widget_video->getOverlayAnalysis()->getLineProfileWidth();
+		this->lineProfileView->setVisible(this->parameters.lineProfileEnabled);
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video->getOverlayAnalysis(), &OverlayAnalysisController::polarUnwrapSettingsChanged, this, [this]() {
+		this->parameters.polarUnwrapEnabled = this->ui->widget_video->getOverlayAnalysis()->isPolarUnwrapEnabled();
+		this->parameters.polarUnwrapBand = this->ui->widget_video->getOverlayAnalysis()->getPolarUnwrapBand();
+		this->polarUnwrapView->setVisible(this->parameters.polarUnwrapEnabled);
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video, &CameraViewWidget::referenceSettingsChanged, this, [this]() {
+		ReferenceComparisonSettings referenceSettings = this->ui->widget_video->getReferenceComparisonSettings();
+		this->parameters.referencePath = this->ui->widget_video->getReferencePath();
+		this->parameters.referenceMode = referenceSettings.mode;
+		this->parameters.referenceOpacity = referenceSettings.opacity;
+		this->parameters.referenceGain = referenceSettings.gain;
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video, &CameraViewWidget::overlayLockChanged, this, [this](bool enabled) {
+		this->parameters.overlayLockEnabled = enabled;
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video->getRecordingControl(), &RecordingController::recordingCompressionChanged, this, [this](bool enabled) {
+		this->parameters.recordingCompression = enabled;
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video, &CameraViewWidget::displayMipmapChanged, this, [this](bool enabled) {
+		this->parameters.displayMipmap = enabled;
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video, &CameraViewWidget::frameExportChanged, this, [this](bool enabled) {
+		this->parameters.frameExport = enabled;
+		emit this->paramsChanged();
+	});
+	connect(ui->widget_video, &CameraViewWidget::driftSettingsChanged, this, [this]() {
+		this->parameters.driftTrackingEnabled = this->ui->widget_video->isDriftTrackingEnabled();
+		this->parameters.driftRotationEnabled = this->ui->widget_video->isDriftRotationEnabled();
+		this->parameters.driftRegion = this->ui->widget_video->getDriftRegion();
+		emit this->paramsChanged();
+	});
+
+	//transport bar below the video, only shown while a recording is played
+	this->playbackControls = new PlaybackControls(this);
+	this->playbackControls->hide();
+	this->ui->verticalLayout->insertWidget(this->ui->verticalLayout->indexOf(this->ui->widget_video) + 1, this->playbackControls);
+	connect(ui->widget_video->getRecordingControl(), &RecordingController::playbackStateChanged, this, [this](bool active) {
+		this->playbackControls->setSource(active ? this->ui->widget_video->getRecordingControl()->getPlayback() : nullptr);
+		this->playbackControls->setVisible(active);
+	});
+
+	//intensity profile along the line overlay, below the video (or detached), only shown while the profile is enabled
+	this->lineProfileView = new LineProfileView(this);
+	this->lineProfileView->hide();
+	this->ui->verticalLayout->insertWidget(this->ui->verticalLayout->indexOf(this->ui->widget_video) + 1, this->lineProfileView);
+	connect(ui->widget_video->getOverlayAnalysis(), &OverlayAnalysisController::lineProfileMeasured, this->lineProfileView, &LineProfileView::setProfile);
+
+	//circle overlay unwrapped into an angle x radius strip, below the line profile (or detached)
+	this->polarUnwrapView = new PolarUnwrapView(this);
+	this->polarUnwrapView->hide();
+	this->ui->verticalLayout->insertWidget(this->ui->verticalLayout->indexOf(this->lineProfileView) + 1, this->polarUnwrapView);
+	connect(ui->widget_video->getOverlayAnalysis(), &OverlayAnalysisController::polarStripMeasured, this->polarUnwrapView, &PolarUnwrapView::setStrip);
+
+	this->installEventFilter(this);
+}
+
+CameraViewPanel::~CameraViewPanel() {
+	delete ui;
+}
+
+void CameraViewPanel::setIndex(int index) {
+	if(this->index == index){
+		return;
+	}
+	this->index = index;
+	this->setWindowTitle(tr("Camera view %1").arg(index + 1));
+	this->ui->widget_video->setViewTag(index == 0 ? QString() : QString("view%1").arg(index + 1));
+}
+
+void CameraViewPanel::setSeparateWindowMode(bool separate) {
+	this->separateWindowMode = separate;
+}
+
+QString CameraViewPanel::getKeyPrefix() const {
+	return this->index == 0 ? QString() : QString("view%1_").arg(this->index + 1);
+}
+
+CameraViewWidget* CameraViewPanel::getView() const {
+	return this->ui->widget_video;
+}
+
+void CameraViewPanel::setSettings(const QVariantMap& settings){
+	//update parameters struct, use default values if empty
+	this->parameters.selectedCamera = settings.value(key(CAMERA_SELECTION), "").toString();
+	this->parameters.rotationAngle = settings.value(key(CAMERA_ROTATION_ANGLE), 0.0).toDouble();
+	this->parameters.snapShotSavePath = settings.value(key(CAMERA_SNAPSHOT_SAVE_PATH), "").toString();
+	this->parameters.windowState = settings.value(key(CAMERA_WINDOW_STATE)).toByteArray();
+	this->parameters.focusIndicatorEnabled = settings.value(key(CAMERA_FOCUS_INDICATOR_ENABLED), false).toBool();
+	this->parameters.focusMethod = settings.value(key(CAMERA_FOCUS_METHOD), FocusMetric::LAPLACIAN_VARIANCE).toInt();
+	this->parameters.focusRegion = settings.value(key(CAMERA_FOCUS_REGION), "").toString();
+	this->parameters.roiStatisticsEnabled = settings.value(key(CAMERA_ROI_STATISTICS_ENABLED), false).toBool();
+	this->parameters.lineProfileEnabled = settings.value(key(CAMERA_LINE_PROFILE_ENABLED), false).toBool();
+	this->parameters.lineProfileWidth = settings.value(key(CAMERA_LINE_PROFILE_WIDTH), 1).toInt();
+	this->parameters.polarUnwrapEnabled = settings.value(key(CAMERA_POLAR_UNWRAP_ENABLED), false).toBool();
+	this->parameters.polarUnwrapBand = settings.value(key(CAMERA_POLAR_UNWRAP_BAND), 50).toInt();
+	this->parameters.referencePath = settings.value(key(CAMERA_REFERENCE_PATH), "").toString();
+	this->parameters.referenceMode = settings.value(key(CAMERA_REFERENCE_MODE), ReferenceComparison::OFF).toInt();
+	this->parameters.referenceOpacity = settings.value(key(CAMERA_REFERENCE_OPACITY), 0.5).toDouble();
+	this->parameters.referenceGain = settings.value(key(CAMERA_REFERENCE_GAIN), 1).toInt();
+	this->parameters.displayMipmap = settings.value(key(CAMERA_DISPLAY_MIPMAP), true).toBool();
+	this->parameters.driftTrackingEnabled = settings.value(key(CAMERA_DRIFT_TRACKING_ENABLED), false).toBool();
+	this->parameters.driftRotationEnabled = settings.value(key(CAMERA_DRIFT_ROTATION_ENABLED), false).toBool();
+	this->parameters.driftRegion = settings.value(key(CAMERA_DRIFT_REGION), "").toString();
+	this->parameters.overlayLockEnabled = settings.value(key(CAMERA_OVERLAY_LOCK_ENABLED), false).toBool();
+	this->parameters.recordingCompression = settings.value(key(CAMERA_RECORDING_COMPRESSION), false).toBool();
+	this->parameters.frameExport = settings.value(key(CAMERA_FRAME_EXPORT), false).toBool();
+
+	//apply parameters to widgets
+	this->ui->widget_video->setSnapshotSaveDir(this->parameters.snapShotSavePath);
+	this->ui->widget_video->rotateAbsolute(this->parameters.rotationAngle);
+	this->connectToCamera(this->parameters.selectedCamera);
+
+	//update gui to represent correct settings
+	int index = this->ui->comboBox_camera->findData(this->parameters.selectedCamera);
+	if (index != -1) {
+		disconnect(ui->comboBox_camera, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &CameraViewPanel::connectToSelectedCamera);
+		this->ui->comboBox_camera->setCurrentIndex(index);
+		connect(ui->comboBox_camera, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &CameraViewPanel::connectToSelectedCamera);
+	}
+
+	//restore window geometry if this panel is shown in a separate window. the geometry of the first panel is part of the extension window
+	if(this->isWindow() && !this->parameters.windowState.isEmpty()){
+		this->restoreGeometry(this->parameters.windowState);
+	}
+
+	//update overlays
+	auto overlays = this->ui->widget_video->getOverlays();
+	for (const auto &overlay : overlays) {
+		if (settings.contains(key(overlay.second + "_state"))) {
+			QVariantMap overlayState = settings.value(key(overlay.second + "_state")).toMap();
+			overlay.first->loadState(overlayState);
+		}
+	}
+
+	//focus indicator (region is applied after the overlays, as it depends on their position)
+	this->ui->widget_video->setFocusMethod(static_cast<FocusMetric::Method>(this->parameters.focusMethod));
+	this->ui->widget_video->setFocusRegion(this->parameters.focusRegion);
+	this->ui->widget_video->setFocusIndicatorEnabled(this->parameters.focusIndicatorEnabled);
+
+	//intensity statistics inside the overlays
+	this->ui->widget_video->getOverlayAnalysis()->setRoiStatisticsEnabled(this->parameters.roiStatisticsEnabled);
+	//the setters report back through lineProfileSettingsChanged, which overwrites the parameters
+	bool lineProfileEnabled = this->parameters.lineProfileEnabled;
+	this->ui->widget_video->getOverlayAnalysis()->setLineProfileWidth(this->parameters.lineProfileWidth);
+	this->ui->widget_video->getOverlayAnalysis()->setLineProfileEnabled(lineProfileEnabled);
+	bool polarUnwrapEnabled = this->parameters.polarUnwrapEnabled;
+	this->ui->widget_video->getOverlayAnalysis()->setPolarUnwrapBand(this->parameters.polarUnwrapBand);
+	this->ui->widget_video->getOverlayAnalysis()->setPolarUnwrapEnabled(polarUnwrapEnabled);
+
+	//reference frame comparison. a reference captured from the live view is not stored, only references loaded from a file are restored
+	ReferenceComparisonSettings referenceSettings;
+	referenceSettings.mode = this->parameters.referenceMode;
+	referenceSettings.opacity = this->parameters.referenceOpacity;
+	referenceSettings.gain = this->parameters.referenceGain;
+	QString referencePath = this->parameters.referencePath;
+	this->ui->widget_video->setReferenceComparisonSettings(referenceSettings);
+	if(!referencePath.isEmpty()){
+		this->ui->widget_video->loadReference(referencePath);
+	}
+
+	//drift tracking
+	this->ui->widget_video->setDriftRotationEnabled(this->parameters.driftRotationEnabled);
+	this->ui->widget_video->setDriftRegion(this->parameters.driftRegion);
+	this->ui->widget_video->setDriftTrackingEnabled(this->parameters.driftTrackingEnabled);
+
+	//overlays locked to the sample
+	this->ui->widget_video->setOverlayLockEnabled(this->parameters.overlayLockEnabled);
+
+	//display
+	this->ui->widget_video->setDisplayMipmapEnabled(this->parameters.displayMipmap);
+
+	//recording
+	this->ui->widget_video->getRecordingControl()->setRecordingCompressionEnabled(this->parameters.recordingCompression);
+
+	//frame export to other processes
+	this->ui->widget_video->setFrameExportEnabled(this->parameters.frameExport);
+}
+
+void CameraViewPanel::getSettings(QVariantMap* settings) {
+	settings->insert(key(CAMERA_SELECTION), this->parameters.selectedCamera);
+	settings->insert(key(CAMERA_ROTATION_ANGLE), this->parameters.rotationAngle);
+	settings->insert(key(CAMERA_SNAPSHOT_SAVE_PATH), this->parameters.snapShotSavePath);
+	if(this->index != 0){
+		settings->insert(key(CAMERA_WINDOW_STATE), this->parameters.windowState);
+	}
+	settings->insert(key(CAMERA_FOCUS_INDICATOR_ENABLED), this->parameters.focusIndicatorEnabled);
+	settings->insert(key(CAMERA_FOCUS_METHOD), this->parameters.focusMethod);
+	settings->insert(key(CAMERA_FOCUS_REGION), this->parameters.focusRegion);
+	settings->insert(key(CAMERA_ROI_STATISTICS_ENABLED), this->parameters.roiStatisticsEnabled);
+	settings->insert(key(CAMERA_LINE_PROFILE_ENABLED), this->parameters.lineProfileEnabled);
+	settings->insert(key(CAMERA_LINE_PROFILE_WIDTH), this->parameters.lineProfileWidth);
+	settings->insert(key(CAMERA_POLAR_UNWRAP_ENABLED), this->parameters.polarUnwrapEnabled);
+	settings->insert(key(CAMERA_POLAR_UNWRAP_BAND), this->parameters.polarUnwrapBand);
+	settings->insert(key(CAMERA_REFERENCE_PATH), this->parameters.referencePath);
+	settings->insert(key(CAMERA_REFERENCE_MODE), this->parameters.referenceMode);
+	settings->insert(key(CAMERA_REFERENCE_OPACITY), this->parameters.referenceOpacity);
+	settings->insert(key(CAMERA_REFERENCE_GAIN), this->parameters.referenceGain);
+	settings->insert(key(CAMERA_DISPLAY_MIPMAP), this->parameters.displayMipmap);
+	settings->insert(key(CAMERA_DRIFT_TRACKING_ENABLED), this->parameters.driftTrackingEnabled);
+	settings->insert(key(CAMERA_DRIFT_ROTATION_ENABLED), this->parameters.driftRotationEnabled);
+	settings->insert(key(CAMERA_DRIFT_REGION), this->parameters.driftRegion);
+	settings->insert(key(CAMERA_OVERLAY_LOCK_ENABLED), this->parameters.overlayLockEnabled);
+	settings->insert(key(CAMERA_RECORDING_COMPRESSION), this->parameters.recordingCompression);
+	settings->insert(key(CAMERA_FRAME_EXPORT), this->parameters.frameExport);
+
+	//save states of overlays
+	auto overlays = this->ui->widget_video->getOverlays();
+	for (auto &overlay : overlays) {
+		settings->insert(key(overlay.second + "_state"), overlay.first->saveState());
+	}
+}
+
+bool CameraViewPanel::eventFilter(QObject* watched, QEvent* event) {
+	if (watched == this && this->isWindow()) {
+		if (event->type() == QEvent::Resize || event->type() == QEvent::Move) {
+			if (this->isVisible()) {
+				this->parameters.windowState = this->saveGeometry();
+				emit paramsChanged();
+			}
+		}
+	}
+	return QWidget::eventFilter(watched, event);
+}
+
+void CameraViewPanel::closeEvent(QCloseEvent* event) {
+	//closing a separate camera window removes the view
+	if(this->isWindow() && this->index != 0){
+		event->ignore();
+		emit removeViewRequested(this);
+		return;
+	}
+	QWidget::closeEvent(event);
+}
+
+void CameraViewPanel::setupViewsMenu() {
+	QMenu* menu = new QMenu(this);
+	QAction* addAction = menu->addAction(tr("Add camera view"));
+	connect(addAction, &QAction::triggered, this, &CameraViewPanel::addViewRequested);
+	QAction* removeAction = menu->addAction(tr("Remove this camera view"));
+	connect(removeAction, &QAction::triggered, this, [this]() { emit removeViewRequested(this); });
+	menu->addSeparator();
+	QAction* separateAction = menu->addAction(tr("Show additional views in separate windows"));
+	separateAction->setCheckable(true);
+	connect(separateAction, &QAction::triggered, this, &CameraViewPanel::separateWindowsRequested);
+
+	//the first view can not be removed. the check state of the window mode is owned by CameraExtensionForm and may change at any time
+	connect(menu, &QMenu::aboutToShow, this, [this, removeAction, separateAction]() {
+		removeAction->setEnabled(this->index != 0);
+		separateAction->setChecked(this->separateWindowMode);
+	});
+	this->ui->toolButton_views->setMenu(menu);
+}
+
+void CameraViewPanel::openSettingsDialog() {
+	QCamera* currentCamera = ui->widget_video->getCamera();
+	QList<QCameraViewfinderSettings> supportedSettings = ui->widget_video->getSupportedSettings();
+	if(currentCamera) {
+		CameraSettingsDialog dialog(currentCamera, supportedSettings, ui->widget_video->getImageAdjustment(), this);
+		connect(&dialog, &CameraSettingsDialog::probeRequested, ui->widget_video, &CameraViewWidget::probeCapabilities, Qt::QueuedConnection);
+		dialog.exec();
+		//the settings are remembered per device and applied before the camera is started the next time
+		ui->widget_video->storeDeviceConfig();
+	} else {
+		qDebug() << "No camera is currently selected or available.";
+	}
+}
+
+void CameraViewPanel::connectToSelectedCamera() {
+	QString selectedCamera = this->ui->comboBox_camera->currentData().toString();
+	this->connectToCamera(selectedCamera);
+}
+
+void CameraViewPanel::disconnectCurrentCamera() {
+	this->ui->widget_video->closeCamera();
+}
+
+void CameraViewPanel::fillCameraComboBox() {
+	this->ui->comboBox_camera->clear();
+	QList<QCameraInfo> cameras = QCameraInfo::availableCameras();
+	for(const QCameraInfo &cameraInfo : cameras) {
+		this->ui->comboBox_camera->addItem(cameraInfo.description(), cameraInfo.deviceName());
+	}
+}
+
+void CameraViewPanel::connectToCamera(QString deviceName) {
+	if(deviceName.isEmpty()){
+		return;
+	}
+	QList<QCameraInfo> cameras = QCameraInfo::availableCameras();
+	for(const QCameraInfo &cameraInfo : cameras) {
+		if (cameraInfo.deviceName() == deviceName) {
+			if(!this->ui->widget_video->isVisible()){
+				this->ui->widget_video->setCamera(cameraInfo);
+			} else {
+				QTimer::singleShot(0, this, [this, cameraInfo]() { this->ui->widget_video->openCamera(cameraInfo); });
+			}
+			break;
+		}
+	}
+}
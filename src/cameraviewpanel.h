@@ -0,0 +1,67 @@
+#ifndef CAMERAVIEWPANEL_H
+#define CAMERAVIEWPANEL_H
+
+#include <QWidget>
+#include "cameraextensionparameters.h"
+
+class CameraViewWidget;
+class PlaybackControls;
+class LineProfileView;
+class PolarUnwrapView;
+
+namespace Ui {
+class CameraViewPanel;
+}
+
+//one camera view with its own camera selection, overlays and settings. all settings keys of a panel are prefixed with getKeyPrefix(),
+//the first panel uses no prefix so settings of earlier versions with a single camera view are still valid
+class CameraViewPanel : public QWidget
+{
+	Q_OBJECT
+
+public:
+	explicit CameraViewPanel(int index, QWidget *parent = 0);
+	~CameraViewPanel();
+
+	void setSettings(const QVariantMap& settings);
+	void getSettings(QVariantMap* settings);
+
+	int getIndex() const {return this->index;}
+	void setIndex(int index);
+	void setSeparateWindowMode(bool separate);
+	QString getKeyPrefix() const;
+	CameraViewWidget* getView() const;
+
+	Ui::CameraViewPanel* ui;
+
+protected:
+	bool eventFilter(QObject* watched, QEvent* event) override;
+	void closeEvent(QCloseEvent* event) override;
+
+public slots:
+	void connectToSelectedCamera();
+	void disconnectCurrentCamera();
+	void openSettingsDialog();
+
+private:
+	void fillCameraComboBox();
+	void connectToCamera(QString deviceName);
+	void setupViewsMenu();
+	QString key(const QString& name) const {return this->getKeyPrefix() + name;}
+	int index;
+	bool separateWindowMode;
+	PlaybackControls* playbackControls;
+	LineProfileView* lineProfileView;
+	PolarUnwrapView* polarUnwrapView;
+	CameraExtensionParameters parameters;
+
+signals:
+	void paramsChanged();
+	void info(QString);
+	void error(QString);
+	void addViewRequested();
+	void removeViewRequested(CameraViewPanel* panel);
+	void separateWindowsRequested(bool separate);
+};
+
+#endif // CAMERAVIEWPANEL_H
@@ -1,4 +1,6 @@
 #include "cameraviewwidget.h"
+#include "workstealingpool.h"
+#include "lenscalibration.h"
 
 #include <QMouseEvent>
 #include <QPainter>
@@ -11,9 +13,17 @@
 #include <QDateTime>
 #include <QMenu>
 #include <QAction>
+#include <QActionGroup>
 #include <QPair>
 #include <QDir>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QtMath>
+#include <QInputDialog>
+#include <QThread>
+
+//length in camera frame pixels of the pieces that overlay edges are subdivided into before they are mapped through the lens model
+#define REGION_EDGE_STEP 8.0
 
 
 CameraViewWidget::CameraViewWidget(QWidget *parent)
@@ -22,15 +32,134 @@ CameraViewWidget::CameraViewWidget(QWidget *parent)
 	  scene(new QGraphicsScene(this)),
 	  videoWidget(new QGraphicsVideoItem()),
 	  oldRotationAngle(0.0),
-	  isFirstShowEvent(true)
+	  isFirstShowEvent(true),
+	  snapshotRenderer(new SnapshotRenderer(this)),
+	  focusAnalyzer(new FocusAnalyzer(this)),
+	  driftTracker(new DriftTracker(this)),
+	  mosaicBuilder(new MosaicBuilder(this)),
+	  mosaicItem(nullptr),
+	  overlayTracker(new OverlayTracker(this)),
+	  overlayStateSaveTimer(new QTimer(this)),
+	  exporter(new FrameExporter(this)),
+	  frameGrabber(new FrameGrabber(this)),
+	  stillCapture(new StillCapture(this)),
+	  statisticsView(nullptr),
+	  statisticsTimer(new QTimer(this)),
+	  displayInterval(0),
+	  probe(nullptr),
+	  deviceControlsPending(false),
+	  timeToFirstFrame(-1)
 {
 	this->createOverlays();
 	this->setScene(this->scene);
 	this->scene->addItem(this->videoWidget);
+	//the mosaic is a child of the video item, so it follows rotation and zoom of the camera image and stays below the overlays
+	this->mosaicItem = new MosaicItem(this->mosaicBuilder->getCanvas(), this->videoWidget);
+	this->mosaicItem->setVisible(false);
+	//tiles are loaded from the spill file on a pool thread, the mosaic is repainted in the gui thread once they are in memory
+	this->mosaicBuilder->getCanvas()->setTileLoadedCallback([this]() {
+		QMetaObject::invokeMethod(this, [this]() { this->mosaicItem->update(); }, Qt::QueuedConnection);
+	});
+
+	//the camera renders into frameTap, which forwards every frame to the video item and to the analysis stages
+	this->frameTap = new FrameTapSurface(this->videoWidget->videoSurface(), this);
+	this->frameTap->setDisplayFilter(&this->imageAdjustment);
+	this->frameTap->setDemosaic(&this->demosaic);
+	this->frameTap->setWindowLevel(&this->windowLevel);
+	this->frameTap->setReferenceComparison(&this->referenceComparison);
+	this->frameTap->setLensUndistortion(&this->lensUndistortion);
+	this->frameTap->setDisplayMipmap(&this->displayMipmap);
+	//the level only depends on the camera frame size and the view transform. the native size of the video item follows the reduced frames,
+	//so it must not feed back into the level
+	connect(this->frameTap, &FrameTapSurface::firstFramePresented, this, &CameraViewWidget::updateDisplayMipmap);
+	connect(this->frameTap, &FrameTapSurface::frameAvailable, this->snapshotRenderer, &SnapshotRenderer::submitFrame);
+	connect(this->snapshotRenderer, &SnapshotRenderer::snapshotSaved, this, &CameraViewWidget::onSnapshotRendered);
+	connect(this->stillCapture, &StillCapture::stillSaved, this, &CameraViewWidget::onStillSaved);
+	connect(this->stillCapture, &StillCapture::error, this, &CameraViewWidget::error);
+	connect(this->frameTap, &FrameTapSurface::frameAvailable, this->focusAnalyzer, &FocusAnalyzer::submitFrame);
+	connect(this->focusAnalyzer, &FocusAnalyzer::focusMeasured, this, &CameraViewWidget::onFocusMeasured);
+	connect(this->videoWidget, &QGraphicsVideoItem::nativeSizeChanged, this, &CameraViewWidget::updateFocusRegionOfInterest);
+	this->overlayAnalysis = new OverlayAnalysisController(this, this->frameTap);
+	connect(this->overlayAnalysis, &OverlayAnalysisController::updateRequested, this->viewport(), static_cast<void (QWidget::*)()>(&QWidget::update));
+	connect(this->videoWidget, &QGraphicsVideoItem::nativeSizeChanged, this->overlayAnalysis, &OverlayAnalysisController::updateRegions);
+	connect(this->frameTap, &FrameTapSurface::frameAvailable, this->driftTracker, &DriftTracker::submitFrame);
+	connect(this->driftTracker, &DriftTracker::driftMeasured, this, &CameraViewWidget::onDriftMeasured);
+	connect(this->videoWidget, &QGraphicsVideoItem::nativeSizeChanged, this, &CameraViewWidget::updateDriftRegion);
+	this->mosaicBuilder->setDemosaic(&this->demosaic);
+	this->mosaicBuilder->setWindowLevel(&this->windowLevel);
+	connect(this->frameTap, &FrameTapSurface::frameAvailable, this->mosaicBuilder, &MosaicBuilder::submitFrame);
+	connect(this->mosaicBuilder, &MosaicBuilder::mosaicUpdated, this, &CameraViewWidget::onMosaicUpdated);
+	connect(this->videoWidget, &QGraphicsVideoItem::nativeSizeChanged, this, &CameraViewWidget::updateMosaicPlacement);
+
+	//overlays locked to the sample are moved at most once per displayed frame, frames the governor keeps from the display do not move them.
+	//the new overlay state is stored once the overlays came to rest
+	connect(this->frameTap, &FrameTapSurface::frameAvailable, this->overlayTracker, &OverlayTracker::submitFrame);
+	connect(this->overlayTracker, &OverlayTracker::overlaysMoved, this, &CameraViewWidget::onOverlaysMoved);
+	connect(this->frameTap, &FrameTapSurface::frameDisplayed, this, &CameraViewWidget::applyPendingOverlayMotion);
+	this->overlayStateSaveTimer->setSingleShot(true);
+	this->overlayStateSaveTimer->setInterval(1000);
+	connect(this->overlayStateSaveTimer, &QTimer::timeout, this, &CameraViewWidget::overlayStateChanged);
+
+	//recording gets the unmodified camera frames, recordings are played into frameTap as well
+	this->recording = new RecordingController(this, this->frameTap);
+	connect(this->recording, &RecordingController::info, this, &CameraViewWidget::info);
+	connect(this->recording, &RecordingController::error, this, &CameraViewWidget::error);
+	connect(this->recording, &RecordingController::recordingStateChanged, this->viewport(), static_cast<void (QWidget::*)()>(&QWidget::update));
+	connect(this->recording, &RecordingController::playbackStateChanged, this, &CameraViewWidget::applyDisplayInterval);
+	//frames are shared with external processes as they arrive, independent of the display
+	connect(this->frameTap, &FrameTapSurface::frameAvailable, this->exporter, &FrameExporter::submitFrame);
+	connect(this->exporter, &FrameExporter::error, this, &CameraViewWidget::error);
+	this->frameGrabber->setDemosaic(&this->demosaic);
+	this->frameGrabber->setWindowLevel(&this->windowLevel);
+	connect(this->frameTap, &FrameTapSurface::frameAvailable, this->frameGrabber, &FrameGrabber::submitFrame);
+
+	this->statisticsTimer->setInterval(500);
+	connect(this->statisticsTimer, &QTimer::timeout, this, &CameraViewWidget::updateStatistics);
+
+	//optional native capture of V4L2 devices, it delivers into frameTap like the QCamera
+	this->nativeCapture = new NativeCaptureController(this, this->frameTap);
+	connect(this->nativeCapture, &NativeCaptureController::error, this, &CameraViewWidget::error);
+	connect(this->nativeCapture, &NativeCaptureController::nativeCaptureToggled, this, &CameraViewWidget::setNativeCaptureEnabled);
+	connect(this->nativeCapture, &NativeCaptureController::controlsChanged, this, &CameraViewWidget::storeDeviceConfig);
+
+	//time from opening the camera to its first frame, shows whether the camera came up directly in its final mode
+	connect(this->frameTap, &FrameTapSurface::firstFramePresented, this, [this](QSize size) {
+		if(!this->isCameraOpen() || !this->cameraStartClock.isValid() || this->timeToFirstFrame >= 0){
+			return;
+		}
+		this->timeToFirstFrame = this->cameraStartClock.elapsed();
+		emit info(tr("%1 delivered the first frame (%2x%3) after %4 ms, started with %5.").arg(this->currentCamera.description()).arg(size.width()).arg(size.height()).arg(this->timeToFirstFrame).arg(this->cameraStartMode));
+	});
 }
 
 CameraViewWidget::~CameraViewWidget() {
+	//a running lens calibration refers to this object. it polls the cancel flag between small steps, so the wait is short
+	this->lensCalibrationCancelled.storeRelease(1);
+	this->lensCalibrationTasks.waitForAll();
+	this->finishProbe(false);
 	this->closeCamera();
+	delete this->recording;
+	this->recording = nullptr;
+	delete this->nativeCapture;
+	this->nativeCapture = nullptr;
+	delete this->exporter;
+	this->exporter = nullptr;
+	delete this->frameGrabber;
+	this->frameGrabber = nullptr;
+	delete this->snapshotRenderer;
+	this->snapshotRenderer = nullptr;
+	delete this->focusAnalyzer;
+	this->focusAnalyzer = nullptr;
+	delete this->overlayAnalysis;
+	this->overlayAnalysis = nullptr;
+	delete this->driftTracker;
+	this->driftTracker = nullptr;
+	//the canvas is shared with the mosaic item and may outlive this object
+	this->mosaicBuilder->getCanvas()->setTileLoadedCallback(nullptr);
+	delete this->mosaicBuilder;
+	this->mosaicBuilder = nullptr;
+	delete this->overlayTracker;
+	this->overlayTracker = nullptr;
 
 	if(this->videoWidget){
 		delete this->videoWidget;
@@ -43,13 +172,14 @@ qreal CameraViewWidget::getRotationAngle() {
 
 void CameraViewWidget::showEvent(QShowEvent *event) {
 	QGraphicsView::showEvent(event);
-	if(!this->currentCamera.isNull()){
+	//camera stays closed while a recording is played
+	if(!this->recording->isPlaybackActive() && !this->currentCamera.isNull()){
 #ifdef __linux__
 		this->openCamera(this->currentCamera);
 #else
 		QTimer::singleShot(0, this, [this]() { this->openCamera(this->currentCamera); }); //singleShot(0) executed as soon as all events are processed. on windows camera screen remains black when not using singleSho here
 #endif
-	}else{
+	}else if(!this->recording->isPlaybackActive()){
 #ifdef __linux__
 		this->openCamera(QCameraInfo::defaultCamera());
 #else
@@ -68,11 +198,15 @@ void CameraViewWidget::showEvent(QShowEvent *event) {
 
 void CameraViewWidget::hideEvent(QHideEvent *event) {
 	QGraphicsView::hideEvent(event);
+	this->finishProbe(false);
+	this->recording->getPlayback()->pause();
 	if (this->camera) {
+		this->stillCapture->setCamera(nullptr);
 		this->camera->stop();
 		delete this->camera;
 		this->camera = nullptr;
 	}
+	this->nativeCapture->close();
 }
 
 void CameraViewWidget::mouseDoubleClickEvent(QMouseEvent *event) {
@@ -101,6 +235,7 @@ void CameraViewWidget::wheelEvent(QWheelEvent *event) {
 		}
 		this->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
 		this->scale(1.0+scaleValue, 1.0+scaleValue);
+		this->updateDisplayMipmap();
 		event->accept();
 	}
 	if(this->underMouse() && QGuiApplication::keyboardModifiers().testFlag(Qt::ShiftModifier)){
@@ -120,9 +255,13 @@ void CameraViewWidget::wheelEvent(QWheelEvent *event) {
 }
 
 void CameraViewWidget::keyPressEvent(QKeyEvent* event) {
-	if((event->modifiers() & Qt::ControlModifier) && (event->key() == Qt::Key_S)){
+	if((event->modifiers() & Qt::ControlModifier) && (event->modifiers() & Qt::ShiftModifier) && (event->key() == Qt::Key_S)){
+		this->takeDisplayedSnapshot();
+	} else if((event->modifiers() & Qt::ControlModifier) && (event->key() == Qt::Key_S)){
 		this->takeSnapshot();
-	} else {
+	} else if(this->probe != nullptr && event->key() == Qt::Key_Escape){
+		this->cancelProbe();
+	} else if(!this->recording->handleKeyPress(event)){
 		QGraphicsView::keyPressEvent(event);
 	}
 }
@@ -142,12 +281,55 @@ void CameraViewWidget::contextMenuEvent(QContextMenuEvent *event) {
 		});
 	}
 
+	QAction *lockAction = menu.addAction(tr("Lock overlays to sample"));
+	lockAction->setCheckable(true);
+	lockAction->setChecked(this->overlayTracker->isEnabled());
+	connect(lockAction, &QAction::toggled, this, &CameraViewWidget::setOverlayLockEnabled);
+
+	//focus indicator actions
+	menu.addSeparator();
+	this->addFocusMenu(&menu);
+	this->addDriftMenu(&menu);
+	this->addMosaicMenu(&menu);
+	this->overlayAnalysis->addMenus(&menu);
+
 	//snapshot actions
 	menu.addSeparator();
 	QAction *takeSnapshotAction = menu.addAction("Take snapshot");
 	connect(takeSnapshotAction, &QAction::triggered, this, &CameraViewWidget::takeSnapshot);
+	QAction *takeDisplayedSnapshotAction = menu.addAction("Take snapshot as displayed");
+	connect(takeDisplayedSnapshotAction, &QAction::triggered, this, &CameraViewWidget::takeDisplayedSnapshot);
 	QAction *setSnapshotLocationAction = menu.addAction("Set snapshot save location...");
 	connect(setSnapshotLocationAction, &QAction::triggered, this, &CameraViewWidget::openSetSaveLocationDialog);
+	this->addRawCameraMenu(&menu);
+	this->addWindowLevelMenu(&menu);
+	this->addReferenceMenu(&menu);
+	this->addLensMenu(&menu);
+	QAction *mipmapAction = menu.addAction(tr("Smooth downscaling when zoomed out"));
+	mipmapAction->setCheckable(true);
+	mipmapAction->setChecked(this->displayMipmap.isEnabled());
+	connect(mipmapAction, &QAction::toggled, this, &CameraViewWidget::setDisplayMipmapEnabled);
+
+	//recording actions
+	menu.addSeparator();
+	this->recording->addMenu(&menu);
+	QAction *exportAction = menu.addAction(tr("Share frames with other processes"));
+	exportAction->setCheckable(true);
+	exportAction->setChecked(this->exporter->isEnabled());
+	exportAction->setEnabled(FrameExporter::isSupported());
+	connect(exportAction, &QAction::toggled, this, &CameraViewWidget::setFrameExportEnabled);
+	if(this->probe != nullptr){
+		QAction *cancelProbeAction = menu.addAction(tr("Cancel measuring camera modes"));
+		connect(cancelProbeAction, &QAction::triggered, this, &CameraViewWidget::cancelProbe);
+	} else {
+		QAction *probeAction = menu.addAction(tr("Measure camera modes"));
+		probeAction->setEnabled(!this->currentCamera.isNull() && !this->recording->isRecording() && !this->recording->isPlaybackActive());
+		connect(probeAction, &QAction::triggered, this, &CameraViewWidget::probeCapabilities);
+	}
+	this->nativeCapture->addMenu(&menu, this->deviceConfig.nativeCapture, !this->currentCamera.isNull() && !this->recording->isRecording() && !this->recording->isPlaybackActive() && this->probe == nullptr);
+	this->addGovernorMenu(&menu);
+	QAction *statisticsAction = menu.addAction(tr("Statistics..."));
+	connect(statisticsAction, &QAction::triggered, this, &CameraViewWidget::openStatisticsView);
 
 	menu.exec(event->globalPos());
 }
@@ -178,6 +360,9 @@ void CameraViewWidget::initOverlays() {
 			connect(overlayItem, &OverlayItem::visibilityChanged, this, &CameraViewWidget::onOverlayChanged);
 		}
 	}
+	if(this->overlayTracker->isEnabled()){
+		this->updateOverlayTrackerTargets();
+	}
 }
 
 void CameraViewWidget::fitCameraViewToWindow() {
@@ -185,6 +370,7 @@ void CameraViewWidget::fitCameraViewToWindow() {
 	this->ensureVisible(this->videoWidget->boundingRect());
 	this->centerOn(this->videoWidget);
 	this->scene->setSceneRect(this->scene->itemsBoundingRect());
+	this->updateDisplayMipmap();
 }
 
 void CameraViewWidget::setCamera(const QCameraInfo &camera) {
@@ -198,16 +384,60 @@ void CameraViewWidget::openCamera(const QCameraInfo& cameraInfo) {
 	}
 
 	//do nothing if camera is already selected and running
-	if(this->camera && this->currentCamera == cameraInfo && this->camera->state() == QCamera::ActiveState){
+	if(this->currentCamera == cameraInfo && ((this->camera && this->camera->state() == QCamera::ActiveState) || this->nativeCapture->isOpen())){
 		return;
 	}
 
-	//stop and delete camera to be able to create newly selected camera
+	//stop and delete camera (or playback or a running mode measurement) to be able to create newly selected camera
+	this->finishProbe(false);
+	this->recording->closePlayback();
 	this->closeCamera();
 
+	//the stored configuration of this device is applied before the camera is started, so it comes up directly in its final mode instead of
+	//starting with the backend default and renegotiating. without stored configuration the fastest measured mode is used, if the modes were measured
+	this->deviceConfig = this->deviceConfigs ? this->deviceConfigs->getConfig(cameraInfo.deviceName()) : CameraDeviceConfig();
+	this->imageAdjustment.setSettings(this->deviceConfig.softwareAdjustment);
+	this->demosaic.setSettings(this->deviceConfig.demosaic);
+	this->windowLevel.setSettings(this->deviceConfig.windowLevel);
+	this->lensUndistortion.setSettings(this->deviceConfig.lens);
+	this->updateOverlayDependentRegions();
+
+	//the native V4L2 capture bypasses the GStreamer camerabin, Qt Multimedia is only used if it is off or the device can not be opened with it
+	if(this->deviceConfig.nativeCapture && V4l2Source::isSupported()){
+		if(this->openNativeCamera(cameraInfo)){
+			return;
+		}
+		emit info(tr("Native capture of %1 failed, Qt Multimedia is used instead.").arg(cameraInfo.description()));
+	}
+
 	//create new camera and start live view
 	this->camera = new QCamera(cameraInfo, this);
-	this->camera->setViewfinder(this->videoWidget);
+	this->camera->setViewfinder(this->frameTap);
+	const DeviceCapabilities capabilities = CameraCapabilities::load(cameraInfo.deviceName());
+	const ProbedMode* fastestMode = capabilities.fastestMode();
+	if(!this->deviceConfig.viewfinder.isNull()){
+		this->deviceConfig.applyViewfinder(this->camera);
+		this->cameraStartMode = tr("stored configuration %1").arg(CameraCapabilities::modeToString(this->deviceConfig.viewfinder));
+	} else if(fastestMode != nullptr){
+		this->camera->setViewfinderSettings(fastestMode->settings);
+		this->cameraStartMode = tr("fastest measured mode %1").arg(CameraCapabilities::modeToString(fastestMode->settings));
+	} else {
+		this->cameraStartMode = tr("backend default mode");
+	}
+
+	//image processing and zoom can only be set once the camera is loaded, they are applied before the camera becomes active if possible
+	this->deviceControlsPending = this->deviceConfig.imageProcessingValid || this->deviceConfig.zoomValid;
+	connect(this->camera, &QCamera::statusChanged, this, [this](QCamera::Status status) {
+		if(this->deviceControlsPending && (status == QCamera::LoadedStatus || status == QCamera::StartingStatus || status == QCamera::ActiveStatus)){
+			this->deviceControlsPending = false;
+			this->deviceConfig.applyControls(this->camera);
+		}
+	});
+	this->timeToFirstFrame = -1;
+	this->cameraStartClock.start();
+
+	//the still capture path is set up before the camera is loaded, so taking a full resolution still never restarts the live view
+	this->stillCapture->setCamera(this->camera);
 
 	//connect stateChanged signal to a lambda function to get supported camera settings while camera is in loaded state
 	connect(this->camera, &QCamera::stateChanged, this, [this](QCamera::State newState) {
@@ -242,9 +472,16 @@ void CameraViewWidget::openCamera(const QCameraInfo& cameraInfo) {
 }
 
 void CameraViewWidget::closeCamera() {
+	//a recording contains frames of a single camera
+	this->recording->getRecorder()->stop();
+	this->cameraStartClock.invalidate();
+	this->deviceControlsPending = false;
+	this->nativeCapture->close();
 	if (this->camera) {
+		this->stillCapture->setCamera(nullptr);
 		this->camera->stop();
 		this->camera->unload();
+		this->camera->setViewfinder(static_cast<QAbstractVideoSurface*>(nullptr));
 		this->camera->deleteLater();
 		this->camera = nullptr;
 	}
@@ -256,36 +493,934 @@ void CameraViewWidget::rotateAbsolute(qreal angle) {
 	emit rotationAngleChanged(this->oldRotationAngle);
 }
 
-void CameraViewWidget::takeSnapshot() {
-	if(!this->camera || this->camera->status() != QCamera::ActiveStatus){
+QString CameraViewWidget::takeSnapshot() {
+	if(!this->isCameraActive()){
+		return QString();
+	}
+	QDir saveDir(this->getSaveDir());
+
+	//the mosaic of raw cameras and the frames of 16 bit cameras are saved losslessly as they come from the sensor, the still capture path
+	//would only deliver a processed 8 bit image
+	DemosaicSettings demosaicSettings = this->demosaic.getSettings();
+	bool rawSnapshot = this->isRawSource() && demosaicSettings.saveRawSnapshots;
+	bool fullDepthSnapshot = this->isSixteenBitSource() && this->windowLevel.getSettings().fullDepthSnapshots;
+	if(rawSnapshot || fullDepthSnapshot){
+		SnapshotRequest request;
+		request.filePath = saveDir.filePath(this->timestampedFileName(rawSnapshot ? "snapshot_raw.png" : "snapshot_16bit.png"));
+		request.unprocessed = true;
+		this->previewStillPaths.insert(request.filePath);
+		this->snapshotRenderer->requestSnapshot(request);
+		return request.filePath;
+	}
+
+	//full resolution still from the still capture path while the preview keeps running in its own resolution
+	if(this->stillCapture->isAvailable()){
+		QString savePath = saveDir.filePath(this->timestampedFileName("snapshot." + this->stillCapture->getFileSuffix()));
+		if(this->stillCapture->capture(savePath)){
+			return savePath;
+		}
+	}
+
+	//without still capture path the next preview frame is saved unchanged. switching the viewfinder to full resolution is avoided on purpose,
+	//as it would restart the live view
+	SnapshotRequest request;
+	request.filePath = saveDir.filePath(this->timestampedFileName("snapshot.png"));
+	request.demosaic = demosaicSettings;
+	this->windowLevel.getWindow(&request.windowLow, &request.windowHigh);
+	this->previewStillPaths.insert(request.filePath);
+	this->snapshotRenderer->requestSnapshot(request);
+	return request.filePath;
+}
+
+QString CameraViewWidget::takeDisplayedSnapshot() {
+	if(!this->hasActiveSource()){
+		return QString();
+	}
+	SnapshotRequest request;
+	QDir saveDir(this->getSaveDir());
+	request.filePath = saveDir.filePath(this->timestampedFileName("snapshot_displayed.png"));
+	request.videoRect = this->videoWidget->boundingRect();
+
+	//rotation of the view, independent of the current zoom level
+	QTransform viewTransform = this->transform();
+	request.rotation = qRadiansToDegrees(qAtan2(viewTransform.m12(), viewTransform.m11()));
+	QVideoSurfaceFormat surfaceFormat = this->frameTap->surfaceFormat();
+	request.mirrored = surfaceFormat.isMirrored();
+	request.bottomToTop = surfaceFormat.scanLineDirection() == QVideoSurfaceFormat::BottomToTop;
+	request.demosaic = this->demosaic.getSettings();
+	this->windowLevel.getWindow(&request.windowLow, &request.windowHigh);
+	if(this->lensUndistortion.isActive()){
+		request.lens = this->lensUndistortion.getSettings().model;
+	}
+
+	//only the overlay states are passed to the renderer, the overlay items themselves stay on the gui thread
+	for(auto &overlayPair : this->overlays){
+		OverlayItem* overlay = overlayPair.first;
+		if(overlay->isVisible()){
+			SnapshotOverlay snapshotOverlay;
+			snapshotOverlay.state = overlay->saveState();
+			snapshotOverlay.paintShape = overlay->getShapePainter();
+			request.overlays.append(snapshotOverlay);
+		}
+	}
+	this->snapshotRenderer->requestSnapshot(request);
+	return request.filePath;
+}
+
+void CameraViewWidget::onSnapshotRendered(QString filePath, bool success, qint64 latencyMs) {
+	if(!this->snapshotRenderer->hasPendingRequests()){
+		this->snapshotRenderer->setEnabled(false);
+	}
+	if(this->previewStillPaths.remove(filePath)){
+		this->stillCapture->recordPreviewStill(latencyMs, success);
+	}
+	if(success){
+		emit info("Snapshot saved to " + filePath);
+	} else {
+		emit error("Failed to save snapshot to " + filePath);
+	}
+}
+
+void CameraViewWidget::onStillSaved(QString filePath, bool success, qint64 latencyMs, QSize size) {
+	if(success){
+		emit info(tr("Snapshot saved to %1 (%2x%3, captured after %4 ms)").arg(filePath).arg(size.width()).arg(size.height()).arg(latencyMs));
+	} else {
+		emit error("Failed to save snapshot to " + filePath);
+	}
+}
+
+void CameraViewWidget::setFrameExportEnabled(bool enabled) {
+	if(this->exporter->isEnabled() == enabled){
+		return;
+	}
+	if(enabled){
+		QString name = FrameExporter::ringName(this->viewTag);
+		if(!this->exporter->start(name)){
+			return;
+		}
+		emit info(tr("Sharing camera frames via shared memory ") + name);
+	} else {
+		this->exporter->stop();
+	}
+	emit frameExportChanged(this->exporter->isEnabled());
+}
+
+void CameraViewWidget::setGovernor(AcquisitionGovernor* governor) {
+	if(this->governor){
+		disconnect(this->governor, nullptr, this, nullptr);
+	}
+	this->governor = governor;
+	if(governor != nullptr){
+		connect(governor, &AcquisitionGovernor::displayIntervalChanged, this, &CameraViewWidget::setDisplayInterval);
+		this->setDisplayInterval(governor->getPolicy().displayInterval);
+	}
+}
+
+void CameraViewWidget::setDisplayInterval(int ms) {
+	this->displayInterval = qMax(0, ms);
+	this->applyDisplayInterval();
+}
+
+void CameraViewWidget::applyDisplayInterval() {
+	//recordings are not throttled, otherwise a single frame step while paused could be dropped from the display
+	this->frameTap->setDisplayInterval(this->recording->isPlaybackActive() ? 0 : this->displayInterval);
+}
+
+void CameraViewWidget::addGovernorMenu(QMenu* menu) {
+	if(this->governor == nullptr){
+		return;
+	}
+	QPointer<AcquisitionGovernor> governor = this->governor;
+	GovernorSettings settings = governor->getSettings();
+	QMenu* governorMenu = menu->addMenu(tr("During OCTproZ acquisition"));
+
+	QAction* enabledAction = governorMenu->addAction(tr("Reduce camera load"));
+	enabledAction->setCheckable(true);
+	enabledAction->setChecked(settings.enabled);
+	connect(enabledAction, &QAction::toggled, this, [governor](bool checked) {
+		if(governor){
+			GovernorSettings settings = governor->getSettings();
+			settings.enabled = checked;
+			governor->setSettings(settings);
+		}
+	});
+
+	QMenu* rateMenu = governorMenu->addMenu(tr("Display rate"));
+	rateMenu->setEnabled(settings.enabled);
+	QActionGroup* rateGroup = new QActionGroup(rateMenu);
+	const QList<int> rates = {0, 5, 10, 15, 30};
+	for(int rate : rates){
+		QAction* rateAction = rateMenu->addAction(rate == 0 ? tr("Unlimited") : tr("%1 fps").arg(rate));
+		rateAction->setCheckable(true);
+		rateAction->setChecked(settings.displayRateLimit == rate);
+		rateGroup->addAction(rateAction);
+		connect(rateAction, &QAction::triggered, this, [governor, rate]() {
+			if(governor){
+				GovernorSettings settings = governor->getSettings();
+				settings.displayRateLimit = rate;
+				governor->setSettings(settings);
+			}
+		});
+	}
+
+	QAction* priorityAction = governorMenu->addAction(tr("Run analysis at idle priority"));
+	priorityAction->setCheckable(true);
+	priorityAction->setChecked(settings.idlePriority);
+	priorityAction->setEnabled(settings.enabled);
+	connect(priorityAction, &QAction::toggled, this, [governor](bool checked) {
+		if(governor){
+			GovernorSettings settings = governor->getSettings();
+			settings.idlePriority = checked;
+			governor->setSettings(settings);
+		}
+	});
+
+	QAction* coresAction = governorMenu->addAction(tr("Keep analysis off CPU cores..."));
+	coresAction->setEnabled(settings.enabled && WorkStealingPool::isAffinitySupported());
+	connect(coresAction, &QAction::triggered, this, [this, governor]() {
+		if(!governor){
+			return;
+		}
+		GovernorSettings settings = governor->getSettings();
+		bool ok = false;
+		QString cores = QInputDialog::getText(this, tr("Excluded CPU cores"),
+			tr("CPU cores used by OCTproZ processing (e.g. 0,2-3).\nAnalysis workers of the camera views avoid them while OCTproZ acquires:"),
+			QLineEdit::Normal, AcquisitionGovernor::coresToString(settings.excludedCores), &ok);
+		if(ok && governor){
+			settings = governor->getSettings();
+			settings.excludedCores = AcquisitionGovernor::coresFromString(cores);
+			governor->setSettings(settings);
+		}
+	});
+}
+
+void CameraViewWidget::addRawCameraMenu(QMenu* menu) {
+	if(!this->isRawSource()){
+		return;
+	}
+	DemosaicSettings settings = this->demosaic.getSettings();
+	QMenu* rawMenu = menu->addMenu(tr("Raw camera"));
+
+	QMenu* patternMenu = rawMenu->addMenu(tr("Bayer pattern"));
+	QActionGroup* patternGroup = new QActionGroup(patternMenu);
+	const QStringList patterns = Demosaic::patternNames();
+	for(int pattern = 0; pattern < patterns.size(); pattern++){
+		QAction* patternAction = patternMenu->addAction(patterns.at(pattern));
+		patternAction->setCheckable(true);
+		patternAction->setChecked(settings.pattern == pattern);
+		patternGroup->addAction(patternAction);
+		connect(patternAction, &QAction::triggered, this, [this, pattern]() {
+			DemosaicSettings settings = this->demosaic.getSettings();
+			settings.pattern = pattern;
+			this->setDemosaicSettings(settings);
+		});
+	}
+
+	QMenu* methodMenu = rawMenu->addMenu(tr("Demosaicing"));
+	QActionGroup* methodGroup = new QActionGroup(methodMenu);
+	const QStringList methods = Demosaic::methodNames();
+	for(int method = 0; method < methods.size(); method++){
+		QAction* methodAction = methodMenu->addAction(methods.at(method));
+		methodAction->setCheckable(true);
+		methodAction->setChecked(settings.method == method);
+		methodGroup->addAction(methodAction);
+		connect(methodAction, &QAction::triggered, this, [this, method]() {
+			DemosaicSettings settings = this->demosaic.getSettings();
+			settings.method = method;
+			this->setDemosaicSettings(settings);
+		});
+	}
+
+	QMenu* bitDepthMenu = rawMenu->addMenu(tr("Bits per sample (16 bit mosaics)"));
+	QActionGroup* bitDepthGroup = new QActionGroup(bitDepthMenu);
+	const QList<int> bitDepths = {10, 12, 14, 16};
+	for(int bitDepth : bitDepths){
+		QAction* bitDepthAction = bitDepthMenu->addAction(QString::number(bitDepth));
+		bitDepthAction->setCheckable(true);
+		bitDepthAction->setChecked(settings.bitDepth == bitDepth);
+		bitDepthGroup->addAction(bitDepthAction);
+		connect(bitDepthAction, &QAction::triggered, this, [this, bitDepth]() {
+			DemosaicSettings settings = this->demosaic.getSettings();
+			settings.bitDepth = bitDepth;
+			this->setDemosaicSettings(settings);
+		});
+	}
+
+	QAction* whiteBalanceAction = rawMenu->addAction(tr("Auto white balance (once)"));
+	connect(whiteBalanceAction, &QAction::triggered, this, &CameraViewWidget::estimateWhiteBalance);
+	QAction* resetWhiteBalanceAction = rawMenu->addAction(tr("Reset white balance"));
+	resetWhiteBalanceAction->setEnabled(!qFuzzyCompare(settings.redGain, 1.0) || !qFuzzyCompare(settings.blueGain, 1.0));
+	connect(resetWhiteBalanceAction, &QAction::triggered, this, [this]() {
+		DemosaicSettings settings = this->demosaic.getSettings();
+		settings.redGain = 1.0;
+		settings.blueGain = 1.0;
+		this->setDemosaicSettings(settings);
+	});
+
+	QAction* rawSnapshotAction = rawMenu->addAction(tr("Save snapshots as raw mosaic (lossless)"));
+	rawSnapshotAction->setCheckable(true);
+	rawSnapshotAction->setChecked(settings.saveRawSnapshots);
+	connect(rawSnapshotAction, &QAction::toggled, this, [this](bool checked) {
+		DemosaicSettings settings = this->demosaic.getSettings();
+		settings.saveRawSnapshots = checked;
+		this->setDemosaicSettings(settings);
+	});
+}
+
+void CameraViewWidget::setDemosaicSettings(const DemosaicSettings& settings) {
+	this->demosaic.setSettings(settings);
+	this->storeDeviceConfig();
+}
+
+void CameraViewWidget::estimateWhiteBalance() {
+	//the gains are estimated from the next frame. the connection is removed by the first frame, also if it is not a raw frame
+	disconnect(this->whiteBalanceConnection);
+	this->whiteBalanceConnection = connect(this->frameTap, &FrameTapSurface::frameAvailable, this, [this](const QVideoFrame& frame) {
+		disconnect(this->whiteBalanceConnection);
+		DemosaicSettings settings = this->demosaic.getSettings();
+		if(Demosaic::estimateWhiteBalance(frame, &settings)){
+			this->setDemosaicSettings(settings);
+			emit info(tr("White balance set to red %1, blue %2").arg(settings.redGain, 0, 'f', 2).arg(settings.blueGain, 0, 'f', 2));
+		} else {
+			emit error(tr("White balance could not be estimated, the camera does not deliver raw frames."));
+		}
+	});
+}
+
+void CameraViewWidget::addWindowLevelMenu(QMenu* menu) {
+	if(!this->isSixteenBitSource()){
+		return;
+	}
+	WindowLevelSettings settings = this->windowLevel.getSettings();
+	QMenu* windowMenu = menu->addMenu(tr("16 bit display"));
+
+	QAction* autoAction = windowMenu->addAction(tr("Automatic window"));
+	autoAction->setCheckable(true);
+	autoAction->setChecked(settings.autoWindow);
+	connect(autoAction, &QAction::toggled, this, [this](bool checked) {
+		//switching to the manual window keeps the window that is currently displayed
+		WindowLevelSettings settings = this->windowLevel.getSettings();
+		settings.autoWindow = checked;
+		if(!checked){
+			this->windowLevel.getWindow(&settings.low, &settings.high);
+		}
+		this->setWindowLevelSettings(settings);
+	});
+
+	QMenu* clipMenu = windowMenu->addMenu(tr("Saturated pixels (automatic window)"));
+	clipMenu->setEnabled(settings.autoWindow);
+	QActionGroup* clipGroup = new QActionGroup(clipMenu);
+	const QList<qreal> clipPercents = {0.0, 0.1, 0.5, 1.0, 2.0};
+	for(qreal clipPercent : clipPercents){
+		QAction* clipAction = clipMenu->addAction(tr("%1 %").arg(clipPercent));
+		clipAction->setCheckable(true);
+		clipAction->setChecked(qFuzzyCompare(settings.clipPercent + 1.0, clipPercent + 1.0));
+		clipGroup->addAction(clipAction);
+		connect(clipAction, &QAction::triggered, this, [this, clipPercent]() {
+			WindowLevelSettings settings = this->windowLevel.getSettings();
+			settings.clipPercent = clipPercent;
+			this->setWindowLevelSettings(settings);
+		});
+	}
+
+	QAction* windowAction = windowMenu->addAction(tr("Set window..."));
+	connect(windowAction, &QAction::triggered, this, &CameraViewWidget::openWindowDialog);
+
+	QAction* fullDepthAction = windowMenu->addAction(tr("Save snapshots with 16 bit"));
+	fullDepthAction->setCheckable(true);
+	fullDepthAction->setChecked(settings.fullDepthSnapshots);
+	connect(fullDepthAction, &QAction::toggled, this, [this](bool checked) {
+		WindowLevelSettings settings = this->windowLevel.getSettings();
+		settings.fullDepthSnapshots = checked;
+		this->setWindowLevelSettings(settings);
+	});
+}
+
+void CameraViewWidget::setWindowLevelSettings(const WindowLevelSettings& settings) {
+	this->windowLevel.setSettings(settings);
+	this->storeDeviceConfig();
+}
+
+void CameraViewWidget::openWindowDialog() {
+	int low = 0;
+	int high = 0;
+	this->windowLevel.getWindow(&low, &high);
+	bool ok = false;
+	QString window = QInputDialog::getText(this, tr("16 bit display window"), tr("Displayed range of the 16 bit values (low - high):"),
+		QLineEdit::Normal, QString("%1 - %2").arg(low).arg(high), &ok);
+	if(!ok){
+		return;
+	}
+	QStringList values = window.split('-', QString::SkipEmptyParts);
+	bool lowValid = false;
+	bool highValid = false;
+	if(values.size() == 2){
+		low = values.at(0).trimmed().toInt(&lowValid);
+		high = values.at(1).trimmed().toInt(&highValid);
+	}
+	if(!lowValid || !highValid || low < 0 || high > 65535 || low >= high){
+		emit error(tr("Invalid display window \"%1\", expected two values between 0 and 65535, e.g. 200 - 4000.").arg(window));
+		return;
+	}
+	WindowLevelSettings settings = this->windowLevel.getSettings();
+	settings.autoWindow = false;
+	settings.low = low;
+	settings.high = high;
+	this->setWindowLevelSettings(settings);
+}
+
+void CameraViewWidget::addReferenceMenu(QMenu* menu) {
+	ReferenceComparisonSettings settings = this->referenceComparison.getSettings();
+	bool hasReference = this->referenceComparison.hasReference();
+	QMenu* referenceMenu = menu->addMenu(tr("Reference frame"));
+
+	QAction* loadAction = referenceMenu->addAction(tr("Load reference image..."));
+	connect(loadAction, &QAction::triggered, this, &CameraViewWidget::openReferenceDialog);
+	QAction* captureAction = referenceMenu->addAction(tr("Use current frame as reference"));
+	captureAction->setEnabled(this->hasActiveSource());
+	connect(captureAction, &QAction::triggered, this, &CameraViewWidget::useCurrentFrameAsReference);
+	QAction* clearAction = referenceMenu->addAction(tr("Clear reference"));
+	clearAction->setEnabled(hasReference);
+	connect(clearAction, &QAction::triggered, this, &CameraViewWidget::clearReference);
+
+	//display of the reference
+	referenceMenu->addSeparator();
+	QActionGroup* modeGroup = new QActionGroup(referenceMenu);
+	const QList<QPair<int, QString>> modes = {
+		qMakePair(static_cast<int>(ReferenceComparison::OFF), tr("Live image only")),
+		qMakePair(static_cast<int>(ReferenceComparison::ONION_SKIN), tr("Onion skin")),
+		qMakePair(static_cast<int>(ReferenceComparison::DIFFERENCE), tr("Absolute difference"))
+	};
+	for(const auto& mode : modes){
+		QAction* action = referenceMenu->addAction(mode.second);
+		action->setCheckable(true);
+		action->setChecked(settings.mode == mode.first);
+		action->setEnabled(hasReference);
+		modeGroup->addAction(action);
+		int value = mode.first;
+		connect(action, &QAction::triggered, this, [this, value]() {
+			ReferenceComparisonSettings settings = this->referenceComparison.getSettings();
+			settings.mode = value;
+			this->setReferenceComparisonSettings(settings);
+		});
+	}
+
+	QMenu* opacityMenu = referenceMenu->addMenu(tr("Onion skin opacity"));
+	opacityMenu->setEnabled(hasReference && settings.mode == ReferenceComparison::ONION_SKIN);
+	QActionGroup* opacityGroup = new QActionGroup(opacityMenu);
+	const QList<int> opacities = {25, 50, 75};
+	for(int opacity : opacities){
+		QAction* action = opacityMenu->addAction(tr("%1 % reference").arg(opacity));
+		action->setCheckable(true);
+		action->setChecked(qRound(settings.opacity*100) == opacity);
+		opacityGroup->addAction(action);
+		connect(action, &QAction::triggered, this, [this, opacity]() {
+			ReferenceComparisonSettings settings = this->referenceComparison.getSettings();
+			settings.opacity = opacity/100.0;
+			this->setReferenceComparisonSettings(settings);
+		});
+	}
+
+	//small differences are amplified, the false colour maps of the camera settings apply to the difference image as well
+	QMenu* gainMenu = referenceMenu->addMenu(tr("Difference gain"));
+	gainMenu->setEnabled(hasReference && settings.mode == ReferenceComparison::DIFFERENCE);
+	QActionGroup* gainGroup = new QActionGroup(gainMenu);
+	const QList<int> gains = {1, 2, 4, 8};
+	for(int gain : gains){
+		QAction* action = gainMenu->addAction(QString("%1x").arg(gain));
+		action->setCheckable(true);
+		action->setChecked(settings.gain == gain);
+		gainGroup->addAction(action);
+		connect(action, &QAction::triggered, this, [this, gain]() {
+			ReferenceComparisonSettings settings = this->referenceComparison.getSettings();
+			settings.gain = gain;
+			this->setReferenceComparisonSettings(settings);
+		});
+	}
+}
+
+bool CameraViewWidget::loadReference(const QString& filePath) {
+	QImage image(filePath);
+	if(image.isNull()){
+		emit error(tr("Could not load reference image ") + filePath);
+		return false;
+	}
+	this->referencePath = filePath;
+	this->referenceComparison.setReference(image);
+	emit info(tr("Reference image loaded from %1 (%2x%3)").arg(filePath).arg(image.width()).arg(image.height()));
+	emit referenceSettingsChanged();
+	return true;
+}
+
+void CameraViewWidget::openReferenceDialog() {
+	QString filePath = QFileDialog::getOpenFileName(this, tr("Load reference image"), this->getSaveDir(), tr("Images (*.png *.jpg *.jpeg *.bmp *.tif *.tiff)"));
+	if(filePath.isEmpty() || !this->loadReference(filePath)){
+		return;
+	}
+	//a newly loaded reference is shown right away
+	ReferenceComparisonSettings settings = this->referenceComparison.getSettings();
+	if(settings.mode == ReferenceComparison::OFF){
+		settings.mode = ReferenceComparison::ONION_SKIN;
+		this->setReferenceComparisonSettings(settings);
+	}
+}
+
+void CameraViewWidget::useCurrentFrameAsReference() {
+	//full resolution copy of the next frame, converted like the display (demosaicing, 16 bit window)
+	this->frameGrabber->requestFrame(QSize(1 << 16, 1 << 16), false, [this](const QImage& image, qint64 timestamp) {
+		Q_UNUSED(timestamp)
+		if(image.isNull()){
+			emit error(tr("Could not capture a reference frame."));
+			return;
+		}
+		this->referencePath.clear();
+		this->referenceComparison.setReference(image);
+		ReferenceComparisonSettings settings = this->referenceComparison.getSettings();
+		if(settings.mode == ReferenceComparison::OFF){
+			settings.mode = ReferenceComparison::ONION_SKIN;
+			this->referenceComparison.setSettings(settings);
+		}
+		emit info(tr("Current frame is used as reference (%1x%2).").arg(image.width()).arg(image.height()));
+		emit referenceSettingsChanged();
+	});
+}
+
+void CameraViewWidget::clearReference() {
+	this->referencePath.clear();
+	this->referenceComparison.setReference(QImage());
+	emit referenceSettingsChanged();
+}
+
+void CameraViewWidget::setReferenceComparisonSettings(const ReferenceComparisonSettings& settings) {
+	if(this->referenceComparison.getSettings() == settings){
+		return;
+	}
+	this->referenceComparison.setSettings(settings);
+	emit referenceSettingsChanged();
+}
+
+void CameraViewWidget::addLensMenu(QMenu* menu) {
+	LensUndistortionSettings settings = this->lensUndistortion.getSettings();
+	bool calibrating = this->isLensCalibrationRunning();
+	QMenu* lensMenu = menu->addMenu(tr("Lens correction"));
+
+	QAction* undistortAction = lensMenu->addAction(tr("Undistort live image"));
+	undistortAction->setCheckable(true);
+	undistortAction->setChecked(settings.enabled);
+	undistortAction->setEnabled(settings.model.isValid());
+	connect(undistortAction, &QAction::toggled, this, &CameraViewWidget::setLensUndistortionEnabled);
+
+	//the calibration is stored with the configuration of the camera, so a camera has to be open
+	QAction* calibrateAction = lensMenu->addAction(calibrating ? tr("Calibration running...") : tr("Calibrate from checkerboard images..."));
+	calibrateAction->setEnabled(this->isCameraOpen() && !calibrating);
+	connect(calibrateAction, &QAction::triggered, this, &CameraViewWidget::openLensCalibrationDialog);
+	QAction* clearAction = lensMenu->addAction(tr("Remove calibration"));
+	clearAction->setEnabled(settings.model.isValid() && !calibrating);
+	connect(clearAction, &QAction::triggered, this, &CameraViewWidget::clearLensCalibration);
+}
+
+void CameraViewWidget::openLensCalibrationDialog() {
+	if(!this->isCameraOpen() || this->currentCamera.isNull() || this->isLensCalibrationRunning()){
+		return;
+	}
+	QStringList filePaths = QFileDialog::getOpenFileNames(this, tr("Select snapshots of a checkerboard"), this->getSaveDir(), tr("Images (*.png *.jpg *.jpeg *.bmp *.tif *.tiff)"));
+	if(filePaths.isEmpty()){
+		return;
+	}
+	if(filePaths.size() < LensCalibration::MIN_VIEWS){
+		emit error(tr("Select at least %1 snapshots that show the checkerboard at different positions and tilts.").arg(LensCalibration::MIN_VIEWS));
+		return;
+	}
+	bool ok = false;
+	QString pattern = QInputDialog::getText(this, tr("Lens calibration"), tr("Inner corners of the checkerboard (columns x rows):"),
+		QLineEdit::Normal, QString("9x6"), &ok);
+	if(!ok){
+		return;
+	}
+	QStringList values = pattern.split('x', QString::SkipEmptyParts);
+	bool columnsValid = false;
+	bool rowsValid = false;
+	QSize patternSize;
+	if(values.size() == 2){
+		patternSize = QSize(values.at(0).trimmed().toInt(&columnsValid), values.at(1).trimmed().toInt(&rowsValid));
+	}
+	if(!columnsValid || !rowsValid || patternSize.width() < 3 || patternSize.height() < 3){
+		emit error(tr("Invalid checkerboard size \"%1\", expected the number of inner corners, e.g. 9x6.").arg(pattern));
+		return;
+	}
+
+	//corner search and optimization take up to a few seconds, they run on the pool and are cancelled if the view is closed
+	QString deviceName = this->currentCamera.deviceName();
+	this->lensCalibrationCancelled.storeRelease(0);
+	this->lensCalibrationTasks.add();
+	bool accepted = WorkStealingPool::globalInstance()->trySubmit([this, filePaths, patternSize, deviceName]() {
+		LensCalibrationResult result = LensCalibration::calibrateImages(filePaths, patternSize, &this->lensCalibrationCancelled);
+		QMetaObject::invokeMethod(this, [this, result, deviceName]() {
+			this->finishLensCalibration(result, deviceName);
+		}, Qt::QueuedConnection);
+		this->lensCalibrationTasks.done();
+	});
+	if(!accepted){
+		this->lensCalibrationTasks.done();
+		emit error(tr("Lens calibration could not be started, the processing threads are busy."));
+		return;
+	}
+	emit info(tr("Searching checkerboards with %1x%2 inner corners in %3 images...").arg(patternSize.width()).arg(patternSize.height()).arg(filePaths.size()));
+}
+
+void CameraViewWidget::finishLensCalibration(const LensCalibrationResult& result, const QString& deviceName) {
+	if(!result.success){
+		emit error(tr("Lens calibration failed: %1").arg(result.error));
+		return;
+	}
+	if(!this->isCameraOpen() || this->currentCamera.deviceName() != deviceName){
+		emit error(tr("The camera was changed during the lens calibration, the calibration is discarded."));
+		return;
+	}
+	const LensModel& model = result.model;
+	LensUndistortionSettings settings;
+	settings.enabled = true;
+	settings.model = model;
+	this->setLensUndistortionSettings(settings);
+	emit info(tr("Lens calibrated from %1 of %2 images: reprojection error %3 px, k1 %4, k2 %5.").arg(result.usedImages.size())
+		.arg(result.usedImages.size() + result.rejectedImages.size()).arg(model.rmsError, 0, 'f', 2).arg(model.k1, 0, 'f', 4).arg(model.k2, 0, 'f', 4));
+	if(!result.rejectedImages.isEmpty()){
+		QStringList names;
+		for(const QString& filePath : result.rejectedImages){
+			names.append(QFileInfo(filePath).fileName());
+		}
+		emit info(tr("Not used for the lens calibration: %1").arg(names.join(", ")));
+	}
+	QSize frameSize = this->getFrameSize();
+	if(!frameSize.isEmpty() && !model.isApplicableTo(frameSize)){
+		emit error(tr("The calibration images (%1x%2) have another aspect ratio than the live image (%3x%4), the live image is not undistorted.")
+			.arg(model.imageSize.width()).arg(model.imageSize.height()).arg(frameSize.width()).arg(frameSize.height()));
+	}
+}
+
+void CameraViewWidget::setLensUndistortionSettings(const LensUndistortionSettings& settings) {
+	this->lensUndistortion.setSettings(settings);
+	//the overlays now lie on another area of the camera frames
+	this->updateOverlayDependentRegions();
+	this->storeDeviceConfig();
+}
+
+void CameraViewWidget::setLensUndistortionEnabled(bool enabled) {
+	LensUndistortionSettings settings = this->lensUndistortion.getSettings();
+	if(settings.enabled == enabled || (enabled && !settings.model.isValid())){
+		return;
+	}
+	settings.enabled = enabled;
+	this->setLensUndistortionSettings(settings);
+}
+
+void CameraViewWidget::clearLensCalibration() {
+	this->setLensUndistortionSettings(LensUndistortionSettings());
+}
+
+bool CameraViewWidget::openNativeCamera(const QCameraInfo& cameraInfo) {
+	this->timeToFirstFrame = -1;
+	this->cameraStartClock.start();
+	if(!this->nativeCapture->open(cameraInfo, this->deviceConfig, &this->cameraStartMode)){
+		this->cameraStartClock.invalidate();
+		return false;
+	}
+	this->currentSupportedSettings.clear();
+
+	//remember current camera selection
+	this->currentCamera = cameraInfo;
+	emit currentCameraChanged(this->currentCamera.deviceName());
+
+	//all Bayer mosaics are Format_CameraRaw for Qt, with native capture their pattern and bit depth are known from the fourcc of the driver
+	DemosaicSettings demosaicSettings = this->demosaic.getSettings();
+	if(this->nativeCapture->getRawLayout(&demosaicSettings.pattern, &demosaicSettings.bitDepth) && demosaicSettings != this->demosaic.getSettings()){
+		this->setDemosaicSettings(demosaicSettings);
+	}
+	return true;
+}
+
+void CameraViewWidget::setNativeCaptureEnabled(bool enabled) {
+	if(this->deviceConfig.nativeCapture == enabled || this->currentCamera.isNull() || this->recording->isRecording() || this->recording->isPlaybackActive()){
+		return;
+	}
+	//the setting is stored before the camera is reopened, openCamera() loads the configuration of the device again
+	QCameraInfo cameraInfo = this->currentCamera;
+	if(this->isCameraOpen()){
+		this->deviceConfig.nativeCapture = enabled;
+		this->storeDeviceConfig();
+	} else if(this->deviceConfigs){
+		CameraDeviceConfig config = this->deviceConfigs->getConfig(cameraInfo.deviceName());
+		config.nativeCapture = enabled;
+		this->deviceConfigs->setConfig(cameraInfo.deviceName(), config);
+	}
+	this->closeCamera();
+	this->openCamera(cameraInfo);
+}
+
+void CameraViewWidget::setDisplayMipmapEnabled(bool enabled) {
+	if(this->displayMipmap.isEnabled() == enabled){
+		return;
+	}
+	this->displayMipmap.setEnabled(enabled);
+	emit displayMipmapChanged(enabled);
+}
+
+void CameraViewWidget::updateDisplayMipmap() {
+	//screen pixels per camera pixel: the video item fits the camera frame into its size, the view transform then applies zoom and rotation.
+	//the fitted size is computed from the camera frame size instead of taken from the bounding rect of the item, which follows the size of the
+	//displayed (possibly reduced) frames
+	QSize frameSize = this->getFrameSize();
+	QSizeF fittedSize = QSizeF(frameSize).scaled(this->videoWidget->size(), Qt::KeepAspectRatio);
+	if(frameSize.isEmpty() || fittedSize.isEmpty()){
+		this->displayMipmap.setViewScale(1.0);
+		return;
+	}
+	QTransform transform = this->videoWidget->sceneTransform()*this->viewportTransform();
+	qreal viewScale = qSqrt(qAbs(transform.determinant()))*fittedSize.width()/frameSize.width();
+	this->displayMipmap.setViewScale(viewScale*this->devicePixelRatioF());
+}
+
+void CameraViewWidget::storeDeviceConfig() {
+	if(!this->isCameraOpen() || this->deviceConfigs.isNull() || this->currentCamera.isNull()){
 		return;
 	}
-	QCameraImageCapture *imageCapture = new QCameraImageCapture(this->camera);
-	connect(imageCapture, &QCameraImageCapture::imageCaptured, this, &CameraViewWidget::saveSnapshot);
-	connect(imageCapture, &QCameraImageCapture::imageCaptured, imageCapture, &QObject::deleteLater); //this will delete imageCaputer after the image was saved
-	imageCapture->capture();
+	//the native capture has no QCamera, the mode and the controls of QCamera are kept as they were stored
+	if(this->camera != nullptr){
+		CameraDeviceConfig cameraConfig = CameraDeviceConfig::fromCamera(this->camera);
+		cameraConfig.nativeCapture = this->deviceConfig.nativeCapture;
+		cameraConfig.nativeControls = this->deviceConfig.nativeControls;
+		this->deviceConfig = cameraConfig;
+	} else if(this->nativeCapture->isOpen()){
+		this->deviceConfig.nativeControls = this->nativeCapture->getControlValues();
+	}
+	this->deviceConfig.softwareAdjustment = this->imageAdjustment.getSettings();
+	this->deviceConfig.demosaic = this->demosaic.getSettings();
+	this->deviceConfig.windowLevel = this->windowLevel.getSettings();
+	this->deviceConfig.lens = this->lensUndistortion.getSettings();
+	this->deviceConfigs->setConfig(this->currentCamera.deviceName(), this->deviceConfig);
 }
 
-void CameraViewWidget::saveSnapshot(int id, const QImage &image) {
-	Q_UNUSED(id);
-	QString fileName = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + "_snapshot.png";
+void CameraViewWidget::probeCapabilities() {
+	if(this->probe != nullptr){
+		return;
+	}
+	if(this->currentCamera.isNull()){
+		emit error(tr("No camera selected."));
+		return;
+	}
+	if(this->recording->isRecording() || this->recording->isPlaybackActive()){
+		emit error(tr("Camera modes can not be measured while recording or playing a recording."));
+		return;
+	}
 
-	//check if the snapshot save directory is set, otherwise use a default directory
-	QString saveDirPath = this->snapshotSaveDir.isEmpty() ? QDir::homePath() : this->snapshotSaveDir;
+	//the camera can only be opened once, so the live view is stopped while its modes are measured
+	this->closeCamera();
+	this->probe = new CapabilityProbe(this->currentCamera, this);
+	connect(this->probe, &CapabilityProbe::info, this, &CameraViewWidget::info);
+	connect(this->probe, &CapabilityProbe::progress, this, [this](int current, int total) {
+		this->probeProgress = tr("Measuring camera mode %1 of %2").arg(current).arg(total);
+		this->viewport()->update();
+	});
+	connect(this->probe, &CapabilityProbe::finished, this, [this](DeviceCapabilities capabilities) {
+		int validModes = 0;
+		for(const ProbedMode& mode : capabilities.modes){
+			validModes += mode.valid ? 1 : 0;
+		}
+		if(!CameraCapabilities::store(capabilities)){
+			emit error(tr("Could not store measured camera modes in ") + CameraCapabilities::filePath());
+		}
+		const ProbedMode* fastestMode = capabilities.fastestMode();
+		emit info(tr("%1 of %2 camera modes of %3 deliver frames").arg(validModes).arg(capabilities.modes.size()).arg(capabilities.description)
+			+ (fastestMode != nullptr ? tr(", fastest: %1 at %2 FPS measured").arg(CameraCapabilities::modeToString(fastestMode->settings)).arg(fastestMode->measuredFps, 0, 'f', 1) : QString()));
+		emit capabilitiesProbed(capabilities.deviceName);
+		this->finishProbe(true);
+	});
+	connect(this->probe, &CapabilityProbe::canceled, this, [this]() {
+		this->finishProbe(true);
+	});
+	this->probeProgress.clear();
+	this->viewport()->update();
+	this->probe->start();
+}
 
-	//ensure the directory separator is handled correctly
-	QDir saveDir(saveDirPath);
-	QString savePath = saveDir.filePath(fileName);
+void CameraViewWidget::cancelProbe() {
+	if(this->probe == nullptr){
+		return;
+	}
+	emit info(tr("Measuring camera modes canceled."));
+	this->finishProbe(true);
+}
+
+void CameraViewWidget::finishProbe(bool reopenCamera) {
+	if(this->probe == nullptr){
+		return;
+	}
+	CapabilityProbe* finishedProbe = this->probe;
+	this->probe = nullptr;
+	finishedProbe->disconnect(this);
+	finishedProbe->cancel();
+	finishedProbe->deleteLater();
+	this->probeProgress.clear();
+	this->viewport()->update();
+	if(reopenCamera && this->isVisible()){
+		this->openCamera(this->currentCamera);
+	}
+}
 
-	if (image.save(savePath))
-		emit info("Snapshot saved to " + savePath);
-	else
-		emit error("Failed to save snapshot to " + savePath);
+void CameraViewWidget::openStatisticsView() {
+	if(this->statisticsView == nullptr){
+		this->statisticsView = new StatisticsView(this);
+		this->statisticsView->setWindowTitle(tr("Camera statistics") + (this->viewTag.isEmpty() ? QString() : " (" + this->viewTag + ")"));
+	}
+	this->updateStatistics();
+	this->statisticsView->show();
+	this->statisticsView->raise();
+	this->statisticsTimer->start();
+}
+
+void CameraViewWidget::updateStatistics() {
+	//statistics are only collected while somebody looks at them
+	if(this->statisticsView == nullptr || !this->statisticsView->isVisible()){
+		this->statisticsTimer->stop();
+		return;
+	}
+
+	StatisticsValues cameraValues;
+	QCameraViewfinderSettings viewfinder = this->camera ? this->camera->viewfinderSettings() : this->nativeCapture->getSettings();
+	cameraValues << qMakePair(tr("Device"), this->currentCamera.isNull() ? QString("-") : this->currentCamera.description());
+	cameraValues << qMakePair(tr("Mode"), viewfinder.isNull() ? QString("-") : CameraCapabilities::modeToString(viewfinder));
+	cameraValues << qMakePair(tr("Started with"), this->isCameraOpen() ? this->cameraStartMode : QString("-"));
+	cameraValues << qMakePair(tr("Time to first frame"), this->timeToFirstFrame >= 0 ? QString("%1 ms").arg(this->timeToFirstFrame) : QString("-"));
+	this->statisticsView->setSection(tr("Camera"), cameraValues);
+	this->nativeCapture->updateStatistics(this->statisticsView);
+
+	if(this->isRawSource()){
+		DemosaicSettings demosaicSettings = this->demosaic.getSettings();
+		int processingTime = this->demosaic.getLastProcessingTimeUs();
+		StatisticsValues rawValues;
+		rawValues << qMakePair(tr("Bayer pattern"), Demosaic::patternNames().value(demosaicSettings.pattern));
+		rawValues << qMakePair(tr("Demosaicing"), Demosaic::methodNames().value(demosaicSettings.method));
+		rawValues << qMakePair(tr("White balance"), QString("red %1, blue %2").arg(demosaicSettings.redGain, 0, 'f', 2).arg(demosaicSettings.blueGain, 0, 'f', 2));
+		rawValues << qMakePair(tr("Demosaicing time"), processingTime >= 0 ? QString("%1 ms").arg(processingTime/1000.0, 0, 'f', 2) : QString("-"));
+		this->statisticsView->setSection(tr("Raw camera"), rawValues);
+	}
+	if(this->isSixteenBitSource()){
+		int low = 0;
+		int high = 0;
+		this->windowLevel.getWindow(&low, &high);
+		int processingTime = this->windowLevel.getLastProcessingTimeUs();
+		StatisticsValues windowValues;
+		windowValues << qMakePair(tr("Window"), QString("%1 - %2 (%3)").arg(low).arg(high).arg(this->windowLevel.getSettings().autoWindow ? tr("automatic") : tr("manual")));
+		windowValues << qMakePair(tr("Mapping time"), processingTime >= 0 ? QString("%1 ms").arg(processingTime/1000.0, 0, 'f', 2) : QString("-"));
+		this->statisticsView->setSection(tr("16 bit display"), windowValues);
+	}
+	if(this->referenceComparison.isActive()){
+		ReferenceComparisonSettings referenceSettings = this->referenceComparison.getSettings();
+		QSize referenceSize = this->referenceComparison.getReference().size();
+		int processingTime = this->referenceComparison.getLastProcessingTimeUs();
+		StatisticsValues referenceValues;
+		referenceValues << qMakePair(tr("Reference"), QString("%1 (%2x%3)").arg(this->referencePath.isEmpty() ? tr("captured frame") : QFileInfo(this->referencePath).fileName())
+			.arg(referenceSize.width()).arg(referenceSize.height()));
+		referenceValues << qMakePair(tr("Mode"), referenceSettings.mode == ReferenceComparison::ONION_SKIN ? tr("onion skin, %1 % reference").arg(qRound(referenceSettings.opacity*100))
+			: tr("difference, gain %1").arg(referenceSettings.gain));
+		referenceValues << qMakePair(tr("Comparison time"), QString("%1 ms").arg(processingTime/1000.0, 0, 'f', 2));
+		this->statisticsView->setSection(tr("Reference comparison"), referenceValues);
+	}
+	if(this->lensUndistortion.isActive()){
+		LensModel model = this->lensUndistortion.getSettings().model;
+		bool applied = model.isApplicableTo(this->getFrameSize());
+		int processingTime = this->lensUndistortion.getLastProcessingTimeUs();
+		int buildTime = this->lensUndistortion.getLastBuildTimeUs();
+		StatisticsValues lensValues;
+		lensValues << qMakePair(tr("Calibration"), tr("%1x%2, %3 images, error %4 px").arg(model.imageSize.width()).arg(model.imageSize.height())
+			.arg(model.imageCount).arg(model.rmsError, 0, 'f', 2));
+		lensValues << qMakePair(tr("Distortion"), QString("k1 %1, k2 %2, p1 %3, p2 %4").arg(model.k1, 0, 'f', 4).arg(model.k2, 0, 'f', 4)
+			.arg(model.p1, 0, 'f', 5).arg(model.p2, 0, 'f', 5));
+		lensValues << qMakePair(tr("Undistortion time"), !applied ? tr("not applied, other aspect ratio") : (processingTime >= 0 ? QString("%1 ms").arg(processingTime/1000.0, 0, 'f', 2) : QString("-")));
+		lensValues << qMakePair(tr("Table build time"), buildTime >= 0 ? QString("%1 ms").arg(buildTime/1000.0, 0, 'f', 1) : QString("-"));
+		this->statisticsView->setSection(tr("Lens correction"), lensValues);
+	}
+	if(this->displayMipmap.isActive()){
+		int level = this->displayMipmap.getLevel();
+		int processingTime = this->displayMipmap.getLastProcessingTimeUs();
+		StatisticsValues mipmapValues;
+		mipmapValues << qMakePair(tr("Displayed resolution"), level > 0 ? tr("1/%1").arg(1 << level) : tr("full"));
+		mipmapValues << qMakePair(tr("Downscaling time"), QString("%1 ms").arg(processingTime/1000.0, 0, 'f', 2));
+		this->statisticsView->setSection(tr("Display downscaling"), mipmapValues);
+	}
+	if(this->mosaicBuilder->isEnabled()){
+		const MosaicStatus& mosaic = this->mosaicStatus;
+		StatisticsValues mosaicValues;
+		mosaicValues << qMakePair(tr("State"), mosaic.frameCount == 0 ? tr("Waiting for the first frame") : (mosaic.tracking ? tr("Tracking") : tr("Lost, move back to a known area")));
+		mosaicValues << qMakePair(tr("Registration peak"), QString::number(mosaic.confidence, 'f', 3));
+		mosaicValues << qMakePair(tr("Size"), QString("%1x%2 px, %3 frames").arg(mosaic.bounds.width()).arg(mosaic.bounds.height()).arg(mosaic.frameCount));
+		mosaicValues << qMakePair(tr("Tiles"), tr("%1 (%2 in memory, %3 MB)").arg(mosaic.canvas.tileCount).arg(mosaic.canvas.residentTiles)
+			.arg(mosaic.canvas.residentBytes/(1024.0*1024.0), 0, 'f', 0));
+		mosaicValues << qMakePair(tr("Spill file"), mosaic.canvas.spillError.isEmpty() ? QString("%1 MB").arg(mosaic.canvas.spillFileBytes/(1024.0*1024.0), 0, 'f', 0)
+			: mosaic.canvas.spillError);
+		this->statisticsView->setSection(tr("Mosaic"), mosaicValues);
+	}
+	if(this->overlayAnalysis->isRoiStatisticsEnabled()){
+		this->statisticsView->setSection(tr("Overlay intensity"), this->overlayAnalysis->getRoiStatisticsValues());
+	}
+
+	StillCaptureStatistics still = this->stillCapture->getStatistics();
+	StatisticsValues stillValues;
+	stillValues << qMakePair(tr("Still capture path"), still.stillPathAvailable ? tr("Available") : tr("Not available, preview frames are saved"));
+	stillValues << qMakePair(tr("Still resolution"), still.stillResolution.isValid() ? QString("%1x%2").arg(still.stillResolution.width()).arg(still.stillResolution.height()) : QString("-"));
+	stillValues << qMakePair(tr("Preview resolution"), this->getFrameSize().isValid() ? QString("%1x%2").arg(this->getFrameSize().width()).arg(this->getFrameSize().height()) : QString("-"));
+	stillValues << qMakePair(tr("Stills captured"), QString::number(still.stillsCaptured));
+	stillValues << qMakePair(tr("Stills from preview"), QString::number(still.previewStills));
+	stillValues << qMakePair(tr("Stills failed"), QString::number(still.stillsFailed));
+	stillValues << qMakePair(tr("Live view restarts"), still.singleStream ? tr("%1, single stream, stills at preview resolution").arg(still.liveViewRestarts) : QString::number(still.liveViewRestarts));
+	stillValues << qMakePair(tr("Capture latency"), still.lastLatencyMs >= 0 ? QString("%1 ms (average %2 ms, max %3 ms)").arg(still.lastLatencyMs).arg(still.averageLatencyMs, 0, 'f', 0).arg(still.maxLatencyMs) : QString("-"));
+	this->statisticsView->setSection(tr("Still capture"), stillValues);
+
+	this->recording->updateStatistics(this->statisticsView);
+
+	FrameExportStatistics frameExport = this->exporter->getStatistics();
+	StatisticsValues exportValues;
+	exportValues << qMakePair(tr("Enabled"), frameExport.enabled ? tr("Yes") : tr("No"));
+	exportValues << qMakePair(tr("Shared memory"), frameExport.name.isEmpty() ? QString("-") : frameExport.name);
+	exportValues << qMakePair(tr("Frames published"), QString::number(frameExport.framesPublished));
+	exportValues << qMakePair(tr("Frames skipped"), QString::number(frameExport.framesSkipped));
+	exportValues << qMakePair(tr("Attached readers"), QString::number(frameExport.attachedReaders));
+	exportValues << qMakePair(tr("Ring size"), QString("%1 x %2 MB").arg(frameExport.slotCount).arg(frameExport.slotSize/(1024.0*1024.0), 0, 'f', 1));
+	this->statisticsView->setSection(tr("Frame export"), exportValues);
+
+	if(this->governor){
+		GovernorSettings governorSettings = this->governor->getSettings();
+		GovernorPolicy policy = this->governor->getPolicy();
+		StatisticsValues governorValues;
+		governorValues << qMakePair(tr("Enabled"), governorSettings.enabled ? tr("Yes") : tr("No"));
+		governorValues << qMakePair(tr("OCTproZ acquisition"), policy.acquisitionActive ? tr("Running") : tr("Stopped"));
+		governorValues << qMakePair(tr("Raw buffers"), QString("%1 /s").arg(policy.rawBufferRate, 0, 'f', 1));
+		governorValues << qMakePair(tr("Processed buffers"), QString("%1 /s").arg(policy.processedBufferRate, 0, 'f', 1));
+		governorValues << qMakePair(tr("Display rate limit"), this->frameTap->getDisplayInterval() > 0 ? QString("%1 fps").arg(1000/this->frameTap->getDisplayInterval()) : tr("Unlimited"));
+		governorValues << qMakePair(tr("Frames displayed"), QString::number(this->frameTap->getDisplayedFrames()));
+		governorValues << qMakePair(tr("Frames not displayed"), QString::number(this->frameTap->getSkippedFrames()));
+		governorValues << qMakePair(tr("Analysis priority"), policy.workerPriority == QThread::IdlePriority ? tr("Idle") : tr("Low"));
+		governorValues << qMakePair(tr("Excluded CPU cores"), policy.excludedCores.isEmpty() ? QString("-") : AcquisitionGovernor::coresToString(policy.excludedCores));
+		this->statisticsView->setSection(tr("Acquisition governor"), governorValues);
+	}
+}
+
+QString CameraViewWidget::timestampedFileName(const QString& suffix) const {
+	//the view tag keeps files of different camera views apart if they are created at the same time
+	QString fileName = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + "_";
+	if(!this->viewTag.isEmpty()){
+		fileName += this->viewTag + "_";
+	}
+	return fileName + suffix;
+}
+
+QString CameraViewWidget::getSaveDir() const {
+	//home directory if no save location was set
+	return this->snapshotSaveDir.isEmpty() ? QDir::homePath() : this->snapshotSaveDir;
 }
 
 void CameraViewWidget::openSetSaveLocationDialog() {
-	QString defaultDirPath = this->snapshotSaveDir.isEmpty() ? QDir::homePath() : this->snapshotSaveDir;
-	QString dir = QFileDialog::getExistingDirectory(this, tr("Select Save Location"), defaultDirPath);
+	QString dir = QFileDialog::getExistingDirectory(this, tr("Select Save Location"), this->getSaveDir());
 	if (!dir.isEmpty()) {
 		if(this->snapshotSaveDir != dir){
 			this->snapshotSaveDir = dir;
@@ -294,6 +1429,26 @@ void CameraViewWidget::openSetSaveLocationDialog() {
 	}
 }
 
+OverlayItem* CameraViewWidget::getOverlay(const QString& name) const {
+	for(const auto& overlay : this->overlays){
+		if(overlay.second == name){
+			return overlay.first;
+		}
+	}
+	return nullptr;
+}
+
+bool CameraViewWidget::setOverlayState(const QString& name, const QVariantMap& state) {
+	OverlayItem* overlay = this->getOverlay(name);
+	if(overlay == nullptr || state.value("anchors").toList().size() != overlay->getAnchorPoints().size()){
+		return false;
+	}
+	overlay->loadState(state);
+	this->scene->update();
+	this->onOverlayChanged(overlay);
+	return true;
+}
+
 void CameraViewWidget::onOverlayChanged(OverlayItem *overlay) {
 	QString overlayName = overlay->getName();
 	bool isVisible = overlay->isVisible();
@@ -312,4 +1467,517 @@ void CameraViewWidget::onOverlayChanged(OverlayItem *overlay) {
 	}
 	emit info(infoMsg);
 	emit overlayStateChanged();
+
+	if(overlayName == this->focusRegion){
+		this->updateFocusRegionOfInterest();
+	}
+	this->overlayAnalysis->updateRegions();
+	if(overlayName == this->driftRegion){
+		this->updateDriftRegion();
+	}
+
+	//overlay was moved or shown/hidden by the user, lock it again at its new position
+	if(this->overlayTracker->isEnabled()){
+		this->pendingOverlayMotion.remove(overlayName);
+		this->updateOverlayTrackerTargets();
+	}
+}
+
+QPolygonF CameraViewWidget::overlayOutlineInFrame(OverlayItem* overlay) const {
+	//the video item keeps the aspect ratio of the frame, its bounding rect is the area actually covered by the frame
+	QRectF videoRect = this->videoWidget->boundingRect();
+	QPolygonF normalizedOutline;
+	if(videoRect.isEmpty()){
+		return normalizedOutline;
+	}
+	QPolygonF outline = overlay->mapToItem(this->videoWidget, overlay->getOutline());
+	for(const QPointF& p : outline){
+		normalizedOutline.append(QPointF((p.x() - videoRect.left())/videoRect.width(), (p.y() - videoRect.top())/videoRect.height()));
+	}
+	return normalizedOutline;
+}
+
+QPolygonF CameraViewWidget::overlayRegionInFrame(OverlayItem* overlay) const {
+	QPolygonF outline = this->overlayOutlineInFrame(overlay);
+	const LensModel model = this->getDisplayLensModel();
+	const QSize frameSize = this->getFrameSize();
+	if(!model.isApplicableTo(frameSize) || outline.size() < 2){
+		return outline;
+	}
+	//straight edges of the undistorted display are curved in the camera frame, every point of the subdivided edges is moved to its source position
+	QPolygonF region;
+	const int edges = outline.size() > 2 ? outline.size() : 1;
+	for(int i = 0; i < edges; i++){
+		const QPointF start = outline.at(i);
+		const QPointF end = outline.at((i + 1) % outline.size());
+		const QPointF delta(end - start);
+		const qreal dx = delta.x()*frameSize.width();
+		const qreal dy = delta.y()*frameSize.height();
+		const qreal length = qSqrt(dx*dx + dy*dy);
+		const int pieces = qMax(1, qCeil(length/REGION_EDGE_STEP));
+		for(int k = 0; k < pieces; k++){
+			region.append(model.distortNormalizedPosition(start + delta*(static_cast<qreal>(k)/pieces)));
+		}
+	}
+	if(outline.size() == 2){
+		region.append(model.distortNormalizedPosition(outline.at(1)));
+	}
+	return region;
+}
+
+LensModel CameraViewWidget::getDisplayLensModel() const {
+	return this->lensUndistortion.isActive() ? this->lensUndistortion.getSettings().model : LensModel();
+}
+
+QPointF CameraViewWidget::scenePosInFrame(const QPointF& scenePos) const {
+	QRectF videoRect = this->videoWidget->boundingRect();
+	if(videoRect.isEmpty()){
+		return QPointF();
+	}
+	QPointF p = this->videoWidget->mapFromScene(scenePos);
+	return QPointF((p.x() - videoRect.left())/videoRect.width(), (p.y() - videoRect.top())/videoRect.height());
+}
+
+void CameraViewWidget::setFocusIndicatorEnabled(bool enabled) {
+	if(this->focusAnalyzer->isEnabled() == enabled){
+		return;
+	}
+	this->focusAnalyzer->setEnabled(enabled);
+	if(!enabled){
+		this->focusResult = FocusResult();
+	}
+	this->viewport()->update(this->indicatorRect());
+	emit focusSettingsChanged();
+}
+
+void CameraViewWidget::setFocusMethod(FocusMetric::Method method) {
+	if(this->focusAnalyzer->getMethod() == method){
+		return;
+	}
+	this->focusAnalyzer->setMethod(method);
+	emit focusSettingsChanged();
+}
+
+void CameraViewWidget::setFocusRegion(QString overlayName) {
+	if(this->focusRegion == overlayName){
+		return;
+	}
+	this->focusRegion = overlayName;
+	this->updateFocusRegionOfInterest();
+	this->focusAnalyzer->resetPeak();
+	emit focusSettingsChanged();
+}
+
+void CameraViewWidget::addFocusMenu(QMenu* menu) {
+	QMenu* focusMenu = menu->addMenu(tr("Focus indicator"));
+
+	QAction* enableAction = focusMenu->addAction(tr("Show focus indicator"));
+	enableAction->setCheckable(true);
+	enableAction->setChecked(this->focusAnalyzer->isEnabled());
+	connect(enableAction, &QAction::toggled, this, &CameraViewWidget::setFocusIndicatorEnabled);
+
+	//metric selection
+	focusMenu->addSeparator();
+	QActionGroup* methodGroup = new QActionGroup(focusMenu);
+	QList<QPair<FocusMetric::Method, QString>> methods = {
+		qMakePair(FocusMetric::LAPLACIAN_VARIANCE, tr("Variance of Laplacian")),
+		qMakePair(FocusMetric::TENENGRAD, tr("Tenengrad"))
+	};
+	for(const auto& method : methods){
+		QAction* action = focusMenu->addAction(method.second);
+		action->setCheckable(true);
+		action->setChecked(this->focusAnalyzer->getMethod() == method.first);
+		methodGroup->addAction(action);
+		FocusMetric::Method value = method.first;
+		connect(action, &QAction::triggered, this, [this, value]() { this->setFocusMethod(value); });
+	}
+
+	//region selection. only area overlays can be used as region of interest
+	focusMenu->addSeparator();
+	QActionGroup* regionGroup = new QActionGroup(focusMenu);
+	QStringList regions = {QString(), QString("Rect overlay"), QString("Polygon overlay")};
+	for(const QString& region : regions){
+		QAction* action = focusMenu->addAction(region.isEmpty() ? tr("Whole frame") : tr("Inside %1").arg(region.toLower()));
+		action->setCheckable(true);
+		action->setChecked(this->focusRegion == region);
+		regionGroup->addAction(action);
+		connect(action, &QAction::triggered, this, [this, region]() { this->setFocusRegion(region); });
+	}
+
+	focusMenu->addSeparator();
+	QAction* resetPeakAction = focusMenu->addAction(tr("Reset peak"));
+	connect(resetPeakAction, &QAction::triggered, this->focusAnalyzer, &FocusAnalyzer::resetPeak);
+}
+
+void CameraViewWidget::updateFocusRegionOfInterest() {
+	QPolygonF roi;
+	for(const auto& overlay : this->overlays){
+		//a hidden overlay does not restrict the region
+		if(overlay.second == this->focusRegion && overlay.first->isVisible()){
+			roi = this->overlayRegionInFrame(overlay.first);
+			break;
+		}
+	}
+	this->focusAnalyzer->setRegionOfInterest(roi);
+}
+
+QRect CameraViewWidget::indicatorRect() const {
+	//area in viewport coordinates that contains all indicator boxes
+	return QRect(0, 0, 216, 96);
+}
+
+void CameraViewWidget::onFocusMeasured(FocusResult result) {
+	if(!this->focusAnalyzer->isEnabled()){
+		return;
+	}
+	this->focusResult = result;
+	this->viewport()->update(this->indicatorRect());
+}
+
+void CameraViewWidget::setDriftTrackingEnabled(bool enabled) {
+	if(this->driftTracker->isEnabled() == enabled){
+		return;
+	}
+	if(enabled){
+		this->driftTracker->resetReference();
+	} else {
+		this->driftEstimate = DriftEstimate();
+		this->driftLogger.updateDrift(this->driftEstimate);
+	}
+	this->driftTracker->setEnabled(enabled);
+	this->viewport()->update();
+	emit driftSettingsChanged();
+}
+
+void CameraViewWidget::setDriftRotationEnabled(bool enabled) {
+	if(this->driftTracker->isRotationEnabled() == enabled){
+		return;
+	}
+	this->driftTracker->setRotationEnabled(enabled);
+	emit driftSettingsChanged();
+}
+
+void CameraViewWidget::setDriftRegion(QString overlayName) {
+	if(this->driftRegion == overlayName){
+		return;
+	}
+	this->driftRegion = overlayName;
+	this->updateDriftRegion();
+	emit driftSettingsChanged();
+}
+
+void CameraViewWidget::setDriftLoggingEnabled(bool enabled) {
+	if(this->driftLogger.isActive() == enabled){
+		return;
+	}
+	if(enabled){
+		QString fileName = this->timestampedFileName("drift_log.csv");
+		QDir saveDir(this->getSaveDir());
+		QString filePath = saveDir.filePath(fileName);
+		if(this->driftLogger.start(filePath)){
+			emit info(tr("Logging drift of each OCT buffer to ") + filePath);
+		} else {
+			emit error(tr("Could not create drift log file ") + filePath);
+		}
+	} else {
+		this->driftLogger.stop();
+		emit info(tr("Drift log saved to ") + this->driftLogger.getFilePath());
+	}
+}
+
+void CameraViewWidget::addDriftMenu(QMenu* menu) {
+	QMenu* driftMenu = menu->addMenu(tr("Drift tracking"));
+
+	QAction* enableAction = driftMenu->addAction(tr("Track sample drift"));
+	enableAction->setCheckable(true);
+	enableAction->setChecked(this->driftTracker->isEnabled());
+	connect(enableAction, &QAction::toggled, this, &CameraViewWidget::setDriftTrackingEnabled);
+
+	QAction* rotationAction = driftMenu->addAction(tr("Estimate rotation"));
+	rotationAction->setCheckable(true);
+	rotationAction->setChecked(this->driftTracker->isRotationEnabled());
+	connect(rotationAction, &QAction::toggled, this, &CameraViewWidget::setDriftRotationEnabled);
+
+	QAction* referenceAction = driftMenu->addAction(tr("Use current frame as reference"));
+	referenceAction->setEnabled(this->driftTracker->isEnabled());
+	connect(referenceAction, &QAction::triggered, this->driftTracker, &DriftTracker::resetReference);
+
+	//region selection
+	driftMenu->addSeparator();
+	QActionGroup* regionGroup = new QActionGroup(driftMenu);
+	QStringList regions = {QString(), QString("Rect overlay")};
+	for(const QString& region : regions){
+		QAction* action = driftMenu->addAction(region.isEmpty() ? tr("Central region") : tr("Inside %1").arg(region.toLower()));
+		action->setCheckable(true);
+		action->setChecked(this->driftRegion == region);
+		regionGroup->addAction(action);
+		connect(action, &QAction::triggered, this, [this, region]() { this->setDriftRegion(region); });
+	}
+
+	driftMenu->addSeparator();
+	QAction* logAction = driftMenu->addAction(tr("Log drift for each OCT buffer"));
+	logAction->setCheckable(true);
+	logAction->setChecked(this->driftLogger.isActive());
+	connect(logAction, &QAction::toggled, this, &CameraViewWidget::setDriftLoggingEnabled);
+}
+
+void CameraViewWidget::updateDriftRegion() {
+	QRectF region;
+	for(const auto& overlay : this->overlays){
+		if(overlay.second == this->driftRegion && overlay.first->isVisible()){
+			region = this->overlayRegionInFrame(overlay.first).boundingRect();
+			break;
+		}
+	}
+	this->driftTracker->setRegion(region);
+}
+
+void CameraViewWidget::setMosaicEnabled(bool enabled) {
+	if(this->mosaicBuilder->isEnabled() == enabled){
+		return;
+	}
+	this->mosaicBuilder->setEnabled(enabled);
+	//a disabled mosaic releases its tiles and spill file, enabling starts a new mosaic
+	this->resetMosaic();
+}
+
+void CameraViewWidget::resetMosaic() {
+	this->mosaicBuilder->reset();
+	this->mosaicStatus = MosaicStatus();
+	this->updateMosaicPlacement();
+	this->scene->setSceneRect(this->scene->itemsBoundingRect());
+}
+
+void CameraViewWidget::fitMosaicToWindow() {
+	if(!this->mosaicItem->isVisible()){
+		this->fitCameraViewToWindow();
+		return;
+	}
+	QRectF mosaicRect = this->mosaicItem->sceneBoundingRect();
+	this->scene->setSceneRect(this->scene->itemsBoundingRect());
+	this->fitInView(mosaicRect, Qt::KeepAspectRatio);
+	this->centerOn(mosaicRect.center());
+	this->updateDisplayMipmap();
+}
+
+void CameraViewWidget::addMosaicMenu(QMenu* menu) {
+	QMenu* mosaicMenu = menu->addMenu(tr("Mosaic"));
+
+	QAction* enableAction = mosaicMenu->addAction(tr("Build mosaic while moving the sample"));
+	enableAction->setCheckable(true);
+	enableAction->setChecked(this->mosaicBuilder->isEnabled());
+	connect(enableAction, &QAction::toggled, this, &CameraViewWidget::setMosaicEnabled);
+
+	QAction* resetAction = mosaicMenu->addAction(tr("Start new mosaic"));
+	resetAction->setEnabled(this->mosaicBuilder->isEnabled());
+	connect(resetAction, &QAction::triggered, this, &CameraViewWidget::resetMosaic);
+
+	QAction* fitAction = mosaicMenu->addAction(tr("Fit mosaic to window"));
+	fitAction->setEnabled(this->mosaicItem->isVisible());
+	connect(fitAction, &QAction::triggered, this, &CameraViewWidget::fitMosaicToWindow);
+}
+
+void CameraViewWidget::updateMosaicPlacement() {
+	//mosaic pixels are frame pixels, the item is scaled and moved so that the last registered frame lies exactly below the live frame
+	QRectF videoRect = this->videoWidget->boundingRect();
+	const MosaicStatus& status = this->mosaicStatus;
+	if(!this->mosaicBuilder->isEnabled() || videoRect.isEmpty() || status.frameSize.isEmpty() || status.bounds.isEmpty()){
+		this->mosaicItem->setMosaicRect(QRect());
+		this->mosaicItem->setVisible(false);
+		return;
+	}
+	qreal scale = videoRect.width()/status.frameSize.width();
+	this->mosaicItem->setMosaicRect(status.bounds);
+	this->mosaicItem->setTransform(QTransform::fromScale(scale, scale));
+	this->mosaicItem->setPos(videoRect.topLeft() - QPointF(status.framePosition)*scale);
+	this->mosaicItem->setVisible(true);
+	this->mosaicItem->update();
+	//the scene grows with the mosaic, so the whole mosaic can be reached by scrolling and zooming out
+	this->scene->setSceneRect(this->scene->sceneRect().united(this->mosaicItem->sceneBoundingRect()));
+}
+
+void CameraViewWidget::onMosaicUpdated(MosaicStatus status) {
+	if(!this->mosaicBuilder->isEnabled()){
+		return;
+	}
+	this->mosaicStatus = status;
+	this->updateMosaicPlacement();
+}
+
+void CameraViewWidget::onDriftMeasured(DriftEstimate estimate) {
+	if(!this->driftTracker->isEnabled()){
+		return;
+	}
+	this->driftEstimate = estimate;
+	this->driftLogger.updateDrift(estimate);
+	//the drift vector is drawn in scene coordinates and can be anywhere in the viewport
+	this->viewport()->update();
+	emit driftMeasured(estimate);
+}
+
+void CameraViewWidget::drawForeground(QPainter* painter, const QRectF& rect) {
+	QGraphicsView::drawForeground(painter, rect);
+
+	//drift vector is drawn in scene coordinates so it rotates and scales with the camera image
+	if(this->driftTracker->isEnabled() && this->driftEstimate.valid){
+		this->drawDriftVector(painter);
+	}
+
+	//indicator boxes are drawn in viewport coordinates so they neither rotate nor scale with the camera image
+	painter->save();
+	painter->resetTransform();
+	if(this->recording->isRecording()){
+		this->recording->drawRecordingIndicator(painter);
+	}
+	if(this->probe != nullptr){
+		this->drawProbeIndicator(painter);
+	}
+	painter->setRenderHint(QPainter::Antialiasing, false);
+	if(this->overlayAnalysis->isRoiStatisticsEnabled()){
+		this->overlayAnalysis->drawRoiStatistics(painter);
+	}
+	QRect box(8, 8, 200, 42);
+	if(this->focusAnalyzer->isEnabled() && this->focusResult.valid){
+		this->drawFocusIndicator(painter, box);
+		box.translate(0, box.height() + 4);
+	}
+	if(this->driftTracker->isEnabled() && this->driftEstimate.valid){
+		this->drawDriftIndicator(painter, QRect(box.topLeft(), QSize(box.width(), 38)));
+	}
+	painter->restore();
+}
+
+void CameraViewWidget::drawProbeIndicator(QPainter* painter) {
+	QString text = this->probeProgress.isEmpty() ? tr("Opening camera...") : this->probeProgress;
+	text += "  " + tr("(Esc cancels)");
+	QFontMetrics metrics(painter->font());
+	int width = metrics.horizontalAdvance(text) + 16;
+	QRect box((this->viewport()->width() - width)/2, this->viewport()->height()/2 - 14, width, 28);
+	painter->fillRect(box, QColor(0, 0, 0, 160));
+	painter->setPen(Qt::white);
+	painter->drawText(box, Qt::AlignCenter, text);
+}
+
+void CameraViewWidget::drawFocusIndicator(QPainter* painter, const QRect& box) {
+	painter->fillRect(box, QColor(0, 0, 0, 160));
+
+	painter->setPen(Qt::white);
+	QString methodName = this->focusResult.method == FocusMetric::TENENGRAD ? tr("Tenengrad") : tr("Var. of Laplacian");
+	painter->drawText(box.adjusted(6, 2, -6, -20), Qt::AlignLeft | Qt::AlignVCenter, tr("Focus: %1").arg(this->focusResult.score, 0, 'f', 1));
+	painter->drawText(box.adjusted(6, 2, -6, -20), Qt::AlignRight | Qt::AlignVCenter, methodName);
+
+	//bar with peak hold marker. the scale leaves some headroom above the peak so the bar can grow visibly
+	QRect barRect = box.adjusted(6, 26, -6, -6);
+	double scale = qMax(this->focusResult.peak*1.2, 1e-6);
+	int barWidth = static_cast<int>(barRect.width()*qBound(0.0, this->focusResult.score/scale, 1.0));
+	int peakPos = barRect.left() + static_cast<int>(barRect.width()*qBound(0.0, this->focusResult.peak/scale, 1.0));
+	painter->fillRect(barRect, QColor(255, 255, 255, 40));
+	painter->fillRect(QRect(barRect.left(), barRect.top(), barWidth, barRect.height()), QColor(0, 200, 0, 220));
+	painter->setPen(QPen(QColor(255, 0, 0), 2));
+	painter->drawLine(peakPos, barRect.top() - 2, peakPos, barRect.bottom() + 2);
+}
+
+void CameraViewWidget::drawDriftIndicator(QPainter* painter, const QRect& box) {
+	painter->fillRect(box, QColor(0, 0, 0, 160));
+	//low correlation peaks mean the estimate is not reliable (e.g. featureless region or drift larger than half the region)
+	painter->setPen(this->driftEstimate.reliable ? Qt::white : QColor(255, 160, 0));
+	QString driftText = tr("Drift: %1, %2 px").arg(this->driftEstimate.dx, 0, 'f', 1).arg(this->driftEstimate.dy, 0, 'f', 1);
+	if(this->driftTracker->isRotationEnabled()){
+		driftText += tr(", %1°").arg(this->driftEstimate.rotation, 0, 'f', 1);
+	}
+	painter->drawText(box.adjusted(6, 2, -6, -18), Qt::AlignLeft | Qt::AlignVCenter, driftText);
+	painter->drawText(box.adjusted(6, 18, -6, -2), Qt::AlignLeft | Qt::AlignVCenter, tr("Confidence: %1").arg(this->driftEstimate.confidence, 0, 'f', 2));
+}
+
+void CameraViewWidget::drawDriftVector(QPainter* painter) {
+	QRectF videoRect = this->videoWidget->boundingRect();
+	QSize frameSize = this->driftEstimate.frameSize;
+	if(videoRect.isEmpty() || frameSize.isEmpty()){
+		return;
+	}
+	const QRectF& region = this->driftEstimate.region;
+	QRectF regionInItem(videoRect.left() + region.x()*videoRect.width(), videoRect.top() + region.y()*videoRect.height(),
+						region.width()*videoRect.width(), region.height()*videoRect.height());
+	QPointF drift(this->driftEstimate.dx*videoRect.width()/frameSize.width(), this->driftEstimate.dy*videoRect.height()/frameSize.height());
+	QPointF start = this->videoWidget->mapToScene(regionInItem.center());
+	QPointF end = this->videoWidget->mapToScene(regionInItem.center() + drift);
+
+	painter->save();
+	painter->setRenderHint(QPainter::Antialiasing, true);
+	QPen regionPen(QColor(0, 200, 255, 160), 1, Qt::DashLine);
+	regionPen.setCosmetic(true);
+	painter->setPen(regionPen);
+	painter->drawPolygon(this->videoWidget->mapToScene(regionInItem));
+
+	//a frame that does not match the reference has no meaningful drift
+	if(!this->driftEstimate.reliable){
+		painter->restore();
+		return;
+	}
+	QPen vectorPen(QColor(0, 200, 255), 2, Qt::SolidLine, Qt::RoundCap);
+	vectorPen.setCosmetic(true);
+	painter->setPen(vectorPen);
+	painter->drawLine(start, end);
+	painter->drawEllipse(end, 2.0, 2.0);
+	painter->restore();
+}
+
+void CameraViewWidget::setOverlayLockEnabled(bool enabled) {
+	if(this->overlayTracker->isEnabled() == enabled){
+		return;
+	}
+	this->pendingOverlayMotion.clear();
+	if(enabled){
+		this->updateOverlayTrackerTargets();
+	}
+	this->overlayTracker->setEnabled(enabled);
+	emit overlayLockChanged(enabled);
+}
+
+void CameraViewWidget::updateOverlayTrackerTargets() {
+	QHash<QString, QPointF> targets;
+	for(const auto& overlay : this->overlays){
+		if(overlay.first->isVisible()){
+			targets.insert(overlay.second, this->overlayOutlineInFrame(overlay.first).boundingRect().center());
+		}
+	}
+	this->overlayTracker->setTargets(targets);
+}
+
+void CameraViewWidget::onOverlaysMoved(OverlayDisplacements displacements) {
+	if(!this->overlayTracker->isEnabled()){
+		return;
+	}
+	//several tracker results may arrive between two displayed frames, they are accumulated and applied together
+	for(const OverlayDisplacement& displacement : displacements){
+		this->pendingOverlayMotion[displacement.name] += displacement.delta;
+	}
+}
+
+void CameraViewWidget::applyPendingOverlayMotion() {
+	if(this->pendingOverlayMotion.isEmpty()){
+		return;
+	}
+	QRectF videoRect = this->videoWidget->boundingRect();
+	for(const auto& overlay : this->overlays){
+		auto it = this->pendingOverlayMotion.constFind(overlay.second);
+		if(it != this->pendingOverlayMotion.constEnd() && overlay.first->scene() != nullptr){
+			QPointF delta(it.value().x()*videoRect.width(), it.value().y()*videoRect.height());
+			//overlays are children of the video item, so item coordinates of the video item are parent coordinates of the overlays
+			overlay.first->setPos(overlay.first->pos() + delta);
+		}
+	}
+	this->pendingOverlayMotion.clear();
+	this->updateOverlayDependentRegions();
+	this->overlayStateSaveTimer->start();
+}
+
+void CameraViewWidget::updateOverlayDependentRegions() {
+	if(!this->focusRegion.isEmpty()){
+		this->updateFocusRegionOfInterest();
+	}
+	this->overlayAnalysis->updateRegions();
+	if(!this->driftRegion.isEmpty()){
+		this->updateDriftRegion();
+	}
 }
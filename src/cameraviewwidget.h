@@ -4,15 +4,37 @@
 #include <QVideoWidget>
 #include <QCameraInfo>
 #include <QCamera>
-#include <QMediaRecorder>
 #include <QGraphicsScene>
 #include <QGraphicsView>
 #include <QGraphicsVideoItem>
 #include <QGuiApplication>
+#include <QMenu>
+#include <QTimer>
 #include "lineoverlay.h"
 #include "rectoverlay.h"
 #include "polygonoverlay.h"
 #include "circleoverlay.h"
+#include "frametapsurface.h"
+#include "focusanalyzer.h"
+#include "drifttracker.h"
+#include "driftlogger.h"
+#include "mosaicbuilder.h"
+#include "mosaicitem.h"
+#include "overlaytracker.h"
+#include "snapshotrenderer.h"
+#include "frameexporter.h"
+#include "framegrabber.h"
+#include "statisticsview.h"
+#include "acquisitiongovernor.h"
+#include "capabilityprobe.h"
+#include "cameradeviceconfig.h"
+#include "stillcapture.h"
+#include "overlayanalysiscontroller.h"
+#include "recordingcontroller.h"
+#include "nativecapturecontroller.h"
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QSet>
 
 
 class CameraViewWidget : public QGraphicsView
@@ -25,9 +47,62 @@ public:
 	qreal getRotationAngle();
 	void rotateAbsolute(qreal angle);
 	QCamera* getCamera() const {return this->camera;}
+	QCameraInfo getCurrentCamera() const {return this->currentCamera;}
+	QSize getFrameSize() const {return this->frameTap->surfaceFormat().frameSize();}
+	bool isCameraActive() const {return (this->camera && this->camera->status() == QCamera::ActiveStatus) || this->nativeCapture->isOpen();}
+	//a QCamera or the native V4L2 capture is open
+	bool isCameraOpen() const {return this->camera != nullptr || this->nativeCapture->isOpen();}
+	bool isNativeCaptureActive() const {return this->nativeCapture->isOpen();}
+	bool hasActiveSource() const {return this->isCameraActive() || this->recording->isPlaybackActive();}
 	QList<QCameraViewfinderSettings> getSupportedSettings() const {return this->currentSupportedSettings;}
 	QList<QPair<OverlayItem*, QString>>& getOverlays() {return this->overlays;}
+	OverlayItem* getOverlay(const QString& name) const;
+	bool setOverlayState(const QString& name, const QVariantMap& state);
 	void setSnapshotSaveDir(QString dir) {this->snapshotSaveDir = dir;}
+	//directory of snapshots, recordings and logs
+	QString getSaveDir() const;
+	QString timestampedFileName(const QString& suffix) const;
+	void setViewTag(QString tag) {this->viewTag = tag;}
+	FocusResult getFocusResult() const {return this->focusResult;}
+	bool isFocusIndicatorEnabled() const {return this->focusAnalyzer->isEnabled();}
+	FocusMetric::Method getFocusMethod() const {return this->focusAnalyzer->getMethod();}
+	QString getFocusRegion() const {return this->focusRegion;}
+	QPolygonF overlayOutlineInFrame(OverlayItem* overlay) const;
+	//outline of the area in the camera frame that lies below the overlay. it differs from overlayOutlineInFrame() while the lens distortion
+	//is removed from the display, the analysis stages that get the raw camera frames measure this area
+	QPolygonF overlayRegionInFrame(OverlayItem* overlay) const;
+	//normalized frame coordinates (0..1) of a scene position
+	QPointF scenePosInFrame(const QPointF& scenePos) const;
+	OverlayAnalysisController* getOverlayAnalysis() const {return this->overlayAnalysis;}
+	DriftEstimate getDriftEstimate() const {return this->driftEstimate;}
+	bool isDriftTrackingEnabled() const {return this->driftTracker->isEnabled();}
+	bool isDriftRotationEnabled() const {return this->driftTracker->isRotationEnabled();}
+	QString getDriftRegion() const {return this->driftRegion;}
+	bool isMosaicEnabled() const {return this->mosaicBuilder->isEnabled();}
+	MosaicStatus getMosaicStatus() const {return this->mosaicStatus;}
+	DriftLogger* getDriftLogger() {return &this->driftLogger;}
+	bool isOverlayLockEnabled() const {return this->overlayTracker->isEnabled();}
+	RecordingController* getRecordingControl() const {return this->recording;}
+	bool isRecording() const {return this->recording->isRecording();}
+	bool isPlaybackActive() const {return this->recording->isPlaybackActive();}
+	bool isFrameExportEnabled() const {return this->exporter->isEnabled();}
+	FrameGrabber* getFrameGrabber() const {return this->frameGrabber;}
+	ImageAdjustment* getImageAdjustment() {return &this->imageAdjustment;}
+	Demosaic* getDemosaic() {return &this->demosaic;}
+	bool isRawSource() const {return Demosaic::isRawFormat(this->frameTap->surfaceFormat().pixelFormat());}
+	WindowLevel* getWindowLevel() {return &this->windowLevel;}
+	bool isSixteenBitSource() const {return WindowLevel::isWindowedFormat(this->frameTap->surfaceFormat().pixelFormat());}
+	ReferenceComparisonSettings getReferenceComparisonSettings() const {return this->referenceComparison.getSettings();}
+	QString getReferencePath() const {return this->referencePath;}
+	bool isDisplayMipmapEnabled() const {return this->displayMipmap.isEnabled();}
+	LensUndistortionSettings getLensUndistortionSettings() const {return this->lensUndistortion.getSettings();}
+	//model of the lens distortion that is removed from the display, an invalid model if the camera frames are displayed as they are
+	LensModel getDisplayLensModel() const;
+	bool isLensCalibrationRunning() const {return this->lensCalibrationTasks.getCount() != 0;}
+	void setGovernor(AcquisitionGovernor* governor);
+	bool isProbing() const {return this->probe != nullptr;}
+	void setDeviceConfigStore(CameraDeviceConfigStore* store) {this->deviceConfigs = store;}
+	qint64 getTimeToFirstFrame() const {return this->timeToFirstFrame;}
 
 protected:
 	void showEvent(QShowEvent* event) override;
@@ -36,6 +111,7 @@ protected:
 	void wheelEvent(QWheelEvent* event) override;
 	void keyPressEvent(QKeyEvent* event) override;
 	void contextMenuEvent(QContextMenuEvent* event) override;
+	void drawForeground(QPainter* painter, const QRectF& rect) override;
 
 private:
 	QCamera* camera;
@@ -47,17 +123,118 @@ private:
 	bool isFirstShowEvent;
 	QList<QPair<OverlayItem*, QString>> overlays;
 	QString snapshotSaveDir;
+	QString viewTag;
+	FrameTapSurface* frameTap;
+	ImageAdjustment imageAdjustment;
+	Demosaic demosaic;
+	WindowLevel windowLevel;
+	ReferenceComparison referenceComparison;
+	LensUndistortion lensUndistortion;
+	WorkStealingPool::TaskCounter lensCalibrationTasks;
+	QAtomicInt lensCalibrationCancelled;
+	DisplayMipmap displayMipmap;
+	QString referencePath;
+	QMetaObject::Connection whiteBalanceConnection;
+	SnapshotRenderer* snapshotRenderer;
+	FocusAnalyzer* focusAnalyzer;
+	FocusResult focusResult;
+	QString focusRegion;
+	OverlayAnalysisController* overlayAnalysis;
+	DriftTracker* driftTracker;
+	DriftEstimate driftEstimate;
+	QString driftRegion;
+	DriftLogger driftLogger;
+	MosaicBuilder* mosaicBuilder;
+	MosaicItem* mosaicItem;
+	MosaicStatus mosaicStatus;
+	OverlayTracker* overlayTracker;
+	QHash<QString, QPointF> pendingOverlayMotion;
+	QTimer* overlayStateSaveTimer;
+	RecordingController* recording;
+	NativeCaptureController* nativeCapture;
+	FrameExporter* exporter;
+	FrameGrabber* frameGrabber;
+	StillCapture* stillCapture;
+	QSet<QString> previewStillPaths;
+	StatisticsView* statisticsView;
+	QTimer* statisticsTimer;
+	QPointer<AcquisitionGovernor> governor;
+	int displayInterval;
+	CapabilityProbe* probe;
+	QString probeProgress;
+	QPointer<CameraDeviceConfigStore> deviceConfigs;
+	CameraDeviceConfig deviceConfig;
+	bool deviceControlsPending;
+	QString cameraStartMode;
+	QElapsedTimer cameraStartClock;
+	qint64 timeToFirstFrame;
 
 	void createOverlays();
 	void initOverlays();
+	void addFocusMenu(QMenu* menu);
+	void updateFocusRegionOfInterest();
+	void addDriftMenu(QMenu* menu);
+	void updateDriftRegion();
+	void addMosaicMenu(QMenu* menu);
+	void updateMosaicPlacement();
+	QRect indicatorRect() const;
+	void drawFocusIndicator(QPainter* painter, const QRect& box);
+	void drawDriftIndicator(QPainter* painter, const QRect& box);
+	void drawDriftVector(QPainter* painter);
+	void updateOverlayTrackerTargets();
+	void updateOverlayDependentRegions();
+	void addGovernorMenu(QMenu* menu);
+	void addRawCameraMenu(QMenu* menu);
+	void setDemosaicSettings(const DemosaicSettings& settings);
+	void addWindowLevelMenu(QMenu* menu);
+	void setWindowLevelSettings(const WindowLevelSettings& settings);
+	void addReferenceMenu(QMenu* menu);
+	void addLensMenu(QMenu* menu);
+	void setLensUndistortionSettings(const LensUndistortionSettings& settings);
+	void finishLensCalibration(const LensCalibrationResult& result, const QString& deviceName);
+	bool openNativeCamera(const QCameraInfo& cameraInfo);
+	void updateDisplayMipmap();
+	void applyDisplayInterval();
+	void drawProbeIndicator(QPainter* painter);
+	void finishProbe(bool reopenCamera);
 
 public slots:
 	void fitCameraViewToWindow();
 	void setCamera(const QCameraInfo& camera);
 	void openCamera(const QCameraInfo& camera);
 	void closeCamera();
-	void takeSnapshot();
+	QString takeSnapshot();
+	QString takeDisplayedSnapshot();
 	void openSetSaveLocationDialog();
+	void setFocusIndicatorEnabled(bool enabled);
+	void setFocusMethod(FocusMetric::Method method);
+	void setFocusRegion(QString overlayName);
+	void setDriftTrackingEnabled(bool enabled);
+	void setDriftRotationEnabled(bool enabled);
+	void setDriftRegion(QString overlayName);
+	void setDriftLoggingEnabled(bool enabled);
+	void setMosaicEnabled(bool enabled);
+	void resetMosaic();
+	void fitMosaicToWindow();
+	void setOverlayLockEnabled(bool enabled);
+	void openStatisticsView();
+	void setFrameExportEnabled(bool enabled);
+	void setDisplayInterval(int ms);
+	void probeCapabilities();
+	void cancelProbe();
+	void storeDeviceConfig();
+	void estimateWhiteBalance();
+	void openWindowDialog();
+	bool loadReference(const QString& filePath);
+	void openReferenceDialog();
+	void useCurrentFrameAsReference();
+	void clearReference();
+	void setReferenceComparisonSettings(const ReferenceComparisonSettings& settings);
+	void setDisplayMipmapEnabled(bool enabled);
+	void openLensCalibrationDialog();
+	void setLensUndistortionEnabled(bool enabled);
+	void clearLensCalibration();
+	void setNativeCaptureEnabled(bool enabled);
 
 signals:
 	void error(QString);
@@ -66,10 +243,25 @@ signals:
 	void currentCameraChanged(QString cameraName);
 	void snapshotDirChanged(QString dir);
 	void overlayStateChanged();
+	void focusSettingsChanged();
+	void driftSettingsChanged();
+	void driftMeasured(DriftEstimate estimate);
+	void overlayLockChanged(bool enabled);
+	void frameExportChanged(bool enabled);
+	void capabilitiesProbed(QString deviceName);
+	void referenceSettingsChanged();
+	void displayMipmapChanged(bool enabled);
 	
 private slots:
-	void saveSnapshot(int id, const QImage &image);
+	void onSnapshotRendered(QString filePath, bool success, qint64 latencyMs);
+	void onStillSaved(QString filePath, bool success, qint64 latencyMs, QSize size);
 	void onOverlayChanged(OverlayItem* overlay);
+	void onFocusMeasured(FocusResult result);
+	void onDriftMeasured(DriftEstimate estimate);
+	void onMosaicUpdated(MosaicStatus status);
+	void onOverlaysMoved(OverlayDisplacements displacements);
+	void applyPendingOverlayMotion();
+	void updateStatistics();
 };
 
 #endif //CAMERAVIEWWIDGET_H
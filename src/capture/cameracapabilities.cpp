@@ -0,0 +1,209 @@
+#include "cameracapabilities.h"
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QHash>
+#include <QtMath>
+
+
+namespace {
+	const int CACHE_VERSION = 1;
+
+	QHash<QString, DeviceCapabilities>& cache() {
+		static QHash<QString, DeviceCapabilities> devices;
+		return devices;
+	}
+
+	bool& cacheLoaded() {
+		static bool loaded = false;
+		return loaded;
+	}
+
+	QJsonObject modeToJson(const ProbedMode& mode) {
+		QJsonObject object;
+		object.insert("width", mode.settings.resolution().width());
+		object.insert("height", mode.settings.resolution().height());
+		object.insert("pixel_format", static_cast<int>(mode.settings.pixelFormat()));
+		object.insert("min_fps", mode.settings.minimumFrameRate());
+		object.insert("max_fps", mode.settings.maximumFrameRate());
+		object.insert("valid", mode.valid);
+		object.insert("measured_fps", mode.measuredFps);
+		object.insert("first_frame_ms", static_cast<double>(mode.firstFrameMs));
+		object.insert("delivered_width", mode.deliveredSize.width());
+		object.insert("delivered_height", mode.deliveredSize.height());
+		return object;
+	}
+
+	ProbedMode modeFromJson(const QJsonObject& object) {
+		ProbedMode mode;
+		mode.settings.setResolution(object.value("width").toInt(), object.value("height").toInt());
+		mode.settings.setPixelFormat(static_cast<QVideoFrame::PixelFormat>(object.value("pixel_format").toInt()));
+		mode.settings.setMinimumFrameRate(object.value("min_fps").toDouble());
+		mode.settings.setMaximumFrameRate(object.value("max_fps").toDouble());
+		mode.valid = object.value("valid").toBool();
+		mode.measuredFps = object.value("measured_fps").toDouble();
+		mode.firstFrameMs = static_cast<qint64>(object.value("first_frame_ms").toDouble(-1));
+		mode.deliveredSize = QSize(object.value("delivered_width").toInt(), object.value("delivered_height").toInt());
+		return mode;
+	}
+
+	void loadCache() {
+		if(cacheLoaded()){
+			return;
+		}
+		cacheLoaded() = true;
+		QFile file(CameraCapabilities::filePath());
+		if(!file.open(QIODevice::ReadOnly)){
+			return;
+		}
+		QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+		if(root.value("version").toInt() != CACHE_VERSION){
+			return;
+		}
+		const QJsonArray devices = root.value("devices").toArray();
+		for(const QJsonValue& deviceValue : devices){
+			QJsonObject device = deviceValue.toObject();
+			DeviceCapabilities capabilities;
+			capabilities.deviceName = device.value("device").toString();
+			capabilities.description = device.value("description").toString();
+			capabilities.probed = QDateTime::fromString(device.value("probed").toString(), Qt::ISODate);
+			const QJsonArray modes = device.value("modes").toArray();
+			for(const QJsonValue& modeValue : modes){
+				capabilities.modes.append(modeFromJson(modeValue.toObject()));
+			}
+			if(!capabilities.deviceName.isEmpty()){
+				cache().insert(capabilities.deviceName, capabilities);
+			}
+		}
+	}
+
+	bool saveCache() {
+		QJsonArray devices;
+		for(const DeviceCapabilities& capabilities : cache()){
+			QJsonObject device;
+			device.insert("device", capabilities.deviceName);
+			device.insert("description", capabilities.description);
+			device.insert("probed", capabilities.probed.toString(Qt::ISODate));
+			QJsonArray modes;
+			for(const ProbedMode& mode : capabilities.modes){
+				modes.append(modeToJson(mode));
+			}
+			device.insert("modes", modes);
+			devices.append(device);
+		}
+		QJsonObject root;
+		root.insert("version", CACHE_VERSION);
+		root.insert("devices", devices);
+
+		QString path = CameraCapabilities::filePath();
+		QDir().mkpath(QFileInfo(path).absolutePath());
+		QSaveFile file(path);
+		if(!file.open(QIODevice::WriteOnly)){
+			return false;
+		}
+		file.write(QJsonDocument(root).toJson());
+		return file.commit();
+	}
+}
+
+
+const ProbedMode* DeviceCapabilities::find(const QCameraViewfinderSettings& settings) const {
+	for(const ProbedMode& mode : this->modes){
+		if(CameraCapabilities::isSameMode(mode.settings, settings)){
+			return &mode;
+		}
+	}
+	return nullptr;
+}
+
+const ProbedMode* DeviceCapabilities::fastestMode() const {
+	qreal maxFps = 0.0;
+	for(const ProbedMode& mode : this->modes){
+		if(mode.valid){
+			maxFps = qMax(maxFps, mode.measuredFps);
+		}
+	}
+	const ProbedMode* best = nullptr;
+	for(const ProbedMode& mode : this->modes){
+		if(!mode.valid || mode.measuredFps < 0.9*maxFps){
+			continue;
+		}
+		if(best == nullptr){
+			best = &mode;
+			continue;
+		}
+		QSize size = mode.settings.resolution();
+		QSize bestSize = best->settings.resolution();
+		qint64 pixels = static_cast<qint64>(size.width())*size.height();
+		qint64 bestPixels = static_cast<qint64>(bestSize.width())*bestSize.height();
+		if(pixels > bestPixels || (pixels == bestPixels && mode.firstFrameMs < best->firstFrameMs)){
+			best = &mode;
+		}
+	}
+	return best;
+}
+
+DeviceCapabilities CameraCapabilities::load(const QString& deviceName) {
+	loadCache();
+	return cache().value(deviceName);
+}
+
+bool CameraCapabilities::store(const DeviceCapabilities& capabilities) {
+	if(capabilities.deviceName.isEmpty()){
+		return false;
+	}
+	loadCache();
+	cache().insert(capabilities.deviceName, capabilities);
+	return saveCache();
+}
+
+void CameraCapabilities::remove(const QString& deviceName) {
+	loadCache();
+	if(cache().remove(deviceName) > 0){
+		saveCache();
+	}
+}
+
+QString CameraCapabilities::filePath() {
+	return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("camera_capabilities.json");
+}
+
+QList<QCameraViewfinderSettings> CameraCapabilities::fallbackModes() {
+	struct ResolutionFps { int width; int height; qreal fps; };
+	const QList<ResolutionFps> standardSettings = {
+		{320, 240, 20},
+		{640, 480, 20},
+		{640, 480, 5},
+		{960, 720, 20},
+		{1280, 720, 20}
+	};
+
+	QList<QCameraViewfinderSettings> modes;
+	for(const auto& setting : standardSettings){
+		QCameraViewfinderSettings standardSetting;
+		standardSetting.setResolution(setting.width, setting.height);
+		standardSetting.setMinimumFrameRate(setting.fps);
+		standardSetting.setMaximumFrameRate(setting.fps);
+		modes.append(standardSetting);
+	}
+	return modes;
+}
+
+bool CameraCapabilities::isSameMode(const QCameraViewfinderSettings& a, const QCameraViewfinderSettings& b) {
+	return a.resolution() == b.resolution()
+		&& a.pixelFormat() == b.pixelFormat()
+		&& qFuzzyCompare(a.minimumFrameRate() + 1.0, b.minimumFrameRate() + 1.0)
+		&& qFuzzyCompare(a.maximumFrameRate() + 1.0, b.maximumFrameRate() + 1.0);
+}
+
+QString CameraCapabilities::modeToString(const QCameraViewfinderSettings& settings) {
+	return QString("%1x%2, %3 FPS")
+		.arg(settings.resolution().width())
+		.arg(settings.resolution().height())
+		.arg(settings.minimumFrameRate());
+}
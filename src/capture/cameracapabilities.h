@@ -0,0 +1,48 @@
+#ifndef CAMERACAPABILITIES_H
+#define CAMERACAPABILITIES_H
+
+#include <QCameraViewfinderSettings>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+
+//result of opening a camera with one viewfinder mode
+struct ProbedMode {
+	QCameraViewfinderSettings settings; //mode as requested (advertised by the camera or taken from the fallback list)
+	bool valid = false; //frames with the requested resolution were delivered
+	qreal measuredFps = 0.0;
+	qint64 firstFrameMs = -1; //time from start() to the first frame
+	QSize deliveredSize;
+};
+
+struct DeviceCapabilities {
+	QString deviceName;
+	QString description;
+	QDateTime probed;
+	QList<ProbedMode> modes;
+
+	bool isEmpty() const {return this->modes.isEmpty();}
+	const ProbedMode* find(const QCameraViewfinderSettings& settings) const;
+	//valid mode with the highest measured frame rate. modes within 10 % of it are considered equally fast, of those the highest resolution
+	//and then the shortest time to first frame wins. returns nullptr if no mode is valid
+	const ProbedMode* fastestMode() const;
+};
+
+//measured camera modes are cached per device in AppDataLocation/camera_capabilities.json, keyed by the device name.
+//the cache is read once and kept in memory, all functions are meant to be used from the gui thread
+class CameraCapabilities
+{
+public:
+	static DeviceCapabilities load(const QString& deviceName);
+	static bool store(const DeviceCapabilities& capabilities);
+	static void remove(const QString& deviceName);
+	static QString filePath();
+
+	//resolution/fps combinations tried if a camera does not advertise any viewfinder settings (seen on Jetson Nano)
+	static QList<QCameraViewfinderSettings> fallbackModes();
+	static bool isSameMode(const QCameraViewfinderSettings& a, const QCameraViewfinderSettings& b);
+	static QString modeToString(const QCameraViewfinderSettings& settings);
+};
+
+#endif //CAMERACAPABILITIES_H
@@ -0,0 +1,226 @@
+#include "cameradeviceconfig.h"
+#include <QCameraFocus>
+
+
+QVariantMap CameraDeviceConfig::toVariantMap() const {
+	QVariantMap map;
+	if(!this->viewfinder.isNull()){
+		map.insert("width", this->viewfinder.resolution().width());
+		map.insert("height", this->viewfinder.resolution().height());
+		map.insert("pixel_format", static_cast<int>(this->viewfinder.pixelFormat()));
+		map.insert("min_fps", this->viewfinder.minimumFrameRate());
+		map.insert("max_fps", this->viewfinder.maximumFrameRate());
+	}
+	if(this->imageProcessingValid){
+		map.insert("brightness", this->brightness);
+		map.insert("contrast", this->contrast);
+		map.insert("saturation", this->saturation);
+		map.insert("sharpening", this->sharpening);
+		map.insert("color_filter", static_cast<int>(this->colorFilter));
+	}
+	if(this->zoomValid){
+		map.insert("optical_zoom", this->opticalZoom);
+		map.insert("digital_zoom", this->digitalZoom);
+	}
+	if(!this->softwareAdjustment.isIdentity()){
+		map.insert("software_brightness", this->softwareAdjustment.brightness);
+		map.insert("software_contrast", this->softwareAdjustment.contrast);
+		map.insert("software_gamma", this->softwareAdjustment.gamma);
+		map.insert("software_sharpening", this->softwareAdjustment.sharpening);
+		map.insert("software_false_color", this->softwareAdjustment.falseColor);
+	}
+	if(!this->demosaic.isDefault()){
+		map.insert("bayer_pattern", this->demosaic.pattern);
+		map.insert("demosaic_method", this->demosaic.method);
+		map.insert("red_gain", this->demosaic.redGain);
+		map.insert("blue_gain", this->demosaic.blueGain);
+		map.insert("raw_bit_depth", this->demosaic.bitDepth);
+		map.insert("raw_snapshots", this->demosaic.saveRawSnapshots);
+	}
+	if(!this->windowLevel.isDefault()){
+		map.insert("auto_window", this->windowLevel.autoWindow);
+		map.insert("window_low", this->windowLevel.low);
+		map.insert("window_high", this->windowLevel.high);
+		map.insert("window_clip_percent", this->windowLevel.clipPercent);
+		map.insert("full_depth_snapshots", this->windowLevel.fullDepthSnapshots);
+	}
+	if(!this->lens.isDefault()){
+		const LensModel& model = this->lens.model;
+		map.insert("lens_undistortion", this->lens.enabled);
+		map.insert("lens_width", model.imageSize.width());
+		map.insert("lens_height", model.imageSize.height());
+		map.insert("lens_fx", model.fx);
+		map.insert("lens_fy", model.fy);
+		map.insert("lens_cx", model.cx);
+		map.insert("lens_cy", model.cy);
+		map.insert("lens_k1", model.k1);
+		map.insert("lens_k2", model.k2);
+		map.insert("lens_p1", model.p1);
+		map.insert("lens_p2", model.p2);
+		map.insert("lens_rms_error", model.rmsError);
+		map.insert("lens_images", model.imageCount);
+	}
+	if(this->nativeCapture){
+		map.insert("native_capture", true);
+	}
+	if(!this->nativeControls.isEmpty()){
+		QVariantMap controls;
+		for(auto it = this->nativeControls.constBegin(); it != this->nativeControls.constEnd(); ++it){
+			controls.insert(QString::number(it.key()), it.value());
+		}
+		map.insert("v4l2_controls", controls);
+	}
+	return map;
+}
+
+CameraDeviceConfig CameraDeviceConfig::fromVariantMap(const QVariantMap& map) {
+	CameraDeviceConfig config;
+	if(map.contains("width") && map.contains("height")){
+		config.viewfinder.setResolution(map.value("width").toInt(), map.value("height").toInt());
+		config.viewfinder.setPixelFormat(static_cast<QVideoFrame::PixelFormat>(map.value("pixel_format").toInt()));
+		config.viewfinder.setMinimumFrameRate(map.value("min_fps").toReal());
+		config.viewfinder.setMaximumFrameRate(map.value("max_fps").toReal());
+	}
+	if(map.contains("brightness")){
+		config.imageProcessingValid = true;
+		config.brightness = map.value("brightness").toReal();
+		config.contrast = map.value("contrast").toReal();
+		config.saturation = map.value("saturation").toReal();
+		config.sharpening = map.value("sharpening").toReal();
+		config.colorFilter = static_cast<QCameraImageProcessing::ColorFilter>(map.value("color_filter").toInt());
+	}
+	if(map.contains("optical_zoom")){
+		config.zoomValid = true;
+		config.opticalZoom = map.value("optical_zoom", 1.0).toReal();
+		config.digitalZoom = map.value("digital_zoom", 1.0).toReal();
+	}
+	config.softwareAdjustment.brightness = map.value("software_brightness", 0.0).toReal();
+	config.softwareAdjustment.contrast = map.value("software_contrast", 0.0).toReal();
+	config.softwareAdjustment.gamma = map.value("software_gamma", 1.0).toReal();
+	config.softwareAdjustment.sharpening = map.value("software_sharpening", 0.0).toReal();
+	config.softwareAdjustment.falseColor = map.value("software_false_color", 0).toInt();
+	config.demosaic.pattern = map.value("bayer_pattern", Demosaic::RGGB).toInt();
+	config.demosaic.method = map.value("demosaic_method", Demosaic::BILINEAR).toInt();
+	config.demosaic.redGain = map.value("red_gain", 1.0).toReal();
+	config.demosaic.blueGain = map.value("blue_gain", 1.0).toReal();
+	config.demosaic.bitDepth = map.value("raw_bit_depth", 16).toInt();
+	config.demosaic.saveRawSnapshots = map.value("raw_snapshots", false).toBool();
+	config.windowLevel.autoWindow = map.value("auto_window", true).toBool();
+	config.windowLevel.low = map.value("window_low", 0).toInt();
+	config.windowLevel.high = map.value("window_high", 65535).toInt();
+	config.windowLevel.clipPercent = map.value("window_clip_percent", 0.5).toReal();
+	config.windowLevel.fullDepthSnapshots = map.value("full_depth_snapshots", true).toBool();
+	if(map.contains("lens_fx")){
+		LensModel& model = config.lens.model;
+		model.imageSize = QSize(map.value("lens_width").toInt(), map.value("lens_height").toInt());
+		model.fx = map.value("lens_fx").toDouble();
+		model.fy = map.value("lens_fy").toDouble();
+		model.cx = map.value("lens_cx").toDouble();
+		model.cy = map.value("lens_cy").toDouble();
+		model.k1 = map.value("lens_k1").toDouble();
+		model.k2 = map.value("lens_k2").toDouble();
+		model.p1 = map.value("lens_p1").toDouble();
+		model.p2 = map.value("lens_p2").toDouble();
+		model.rmsError = map.value("lens_rms_error").toDouble();
+		model.imageCount = map.value("lens_images").toInt();
+		config.lens.enabled = map.value("lens_undistortion", false).toBool() && model.isValid();
+	}
+	config.nativeCapture = map.value("native_capture", false).toBool();
+	const QVariantMap controls = map.value("v4l2_controls").toMap();
+	for(auto it = controls.constBegin(); it != controls.constEnd(); ++it){
+		bool ok = false;
+		quint32 id = it.key().toUInt(&ok);
+		if(ok){
+			config.nativeControls.insert(id, it.value().toInt());
+		}
+	}
+	return config;
+}
+
+CameraDeviceConfig CameraDeviceConfig::fromCamera(QCamera* camera) {
+	CameraDeviceConfig config;
+	if(camera == nullptr){
+		return config;
+	}
+	config.viewfinder = camera->viewfinderSettings();
+	QCameraImageProcessing* imageProcessing = camera->imageProcessing();
+	if(imageProcessing != nullptr && imageProcessing->isAvailable()){
+		config.imageProcessingValid = true;
+		config.brightness = imageProcessing->brightness();
+		config.contrast = imageProcessing->contrast();
+		config.saturation = imageProcessing->saturation();
+		config.sharpening = imageProcessing->sharpeningLevel();
+		config.colorFilter = imageProcessing->colorFilter();
+	}
+	QCameraFocus* focus = camera->focus();
+	if(focus != nullptr && (focus->maximumOpticalZoom() > 1.0 || focus->maximumDigitalZoom() > 1.0)){
+		config.zoomValid = true;
+		config.opticalZoom = focus->opticalZoom();
+		config.digitalZoom = focus->digitalZoom();
+	}
+	return config;
+}
+
+void CameraDeviceConfig::applyViewfinder(QCamera* camera) const {
+	if(camera != nullptr && !this->viewfinder.isNull()){
+		camera->setViewfinderSettings(this->viewfinder);
+	}
+}
+
+void CameraDeviceConfig::applyControls(QCamera* camera) const {
+	if(camera == nullptr){
+		return;
+	}
+	QCameraImageProcessing* imageProcessing = camera->imageProcessing();
+	if(this->imageProcessingValid && imageProcessing != nullptr && imageProcessing->isAvailable()){
+		imageProcessing->setBrightness(this->brightness);
+		imageProcessing->setContrast(this->contrast);
+		imageProcessing->setSaturation(this->saturation);
+		imageProcessing->setSharpeningLevel(this->sharpening);
+		if(imageProcessing->isColorFilterSupported(this->colorFilter)){
+			imageProcessing->setColorFilter(this->colorFilter);
+		}
+	}
+	QCameraFocus* focus = camera->focus();
+	if(this->zoomValid && focus != nullptr){
+		focus->zoomTo(qBound(1.0, this->opticalZoom, qMax(1.0, focus->maximumOpticalZoom())), qBound(1.0, this->digitalZoom, qMax(1.0, focus->maximumDigitalZoom())));
+	}
+}
+
+
+CameraDeviceConfigStore::CameraDeviceConfigStore(QObject* parent)
+	: QObject(parent)
+{
+}
+
+void CameraDeviceConfigStore::setConfig(const QString& deviceName, const CameraDeviceConfig& config) {
+	if(deviceName.isEmpty()){
+		return;
+	}
+	if(this->configs.contains(deviceName) && this->configs.value(deviceName).toVariantMap() == config.toVariantMap()){
+		return;
+	}
+	this->configs.insert(deviceName, config);
+	emit configChanged(deviceName);
+}
+
+void CameraDeviceConfigStore::removeConfig(const QString& deviceName) {
+	if(this->configs.remove(deviceName) > 0){
+		emit configChanged(deviceName);
+	}
+}
+
+void CameraDeviceConfigStore::setSettings(const QVariantMap& settings) {
+	this->configs.clear();
+	for(auto it = settings.constBegin(); it != settings.constEnd(); ++it){
+		this->configs.insert(it.key(), CameraDeviceConfig::fromVariantMap(it.value().toMap()));
+	}
+}
+
+QVariantMap CameraDeviceConfigStore::getSettings() const {
+	QVariantMap settings;
+	for(auto it = this->configs.constBegin(); it != this->configs.constEnd(); ++it){
+		settings.insert(it.key(), it.value().toVariantMap());
+	}
+	return settings;
+}
@@ -0,0 +1,69 @@
+#ifndef CAMERADEVICECONFIG_H
+#define CAMERADEVICECONFIG_H
+
+#include <QObject>
+#include <QCamera>
+#include <QCameraViewfinderSettings>
+#include <QCameraImageProcessing>
+#include <QVariantMap>
+#include <QHash>
+#include <QMap>
+#include "imageadjustment.h"
+#include "demosaic.h"
+#include "windowlevel.h"
+#include "lensundistortion.h"
+
+
+//everything the user can change in the camera settings dialog for one camera device
+struct CameraDeviceConfig {
+	QCameraViewfinderSettings viewfinder;
+	bool imageProcessingValid = false;
+	qreal brightness = 0.0;
+	qreal contrast = 0.0;
+	qreal saturation = 0.0;
+	qreal sharpening = 0.0;
+	QCameraImageProcessing::ColorFilter colorFilter = QCameraImageProcessing::ColorFilterNone;
+	bool zoomValid = false;
+	qreal opticalZoom = 1.0;
+	qreal digitalZoom = 1.0;
+	ImageAdjustmentSettings softwareAdjustment; //display only, for cameras without image processing controls
+	DemosaicSettings demosaic; //only used for cameras that deliver Bayer mosaics
+	WindowLevelSettings windowLevel; //only used for cameras that deliver 16 bit monochrome frames
+	LensUndistortionSettings lens; //calibrated lens model, display only
+	bool nativeCapture = false; //capture via V4l2Source instead of QCamera, linux only
+	QMap<quint32, qint32> nativeControls; //V4L2 control id and value, set via the native backend
+
+	bool isEmpty() const {return this->viewfinder.isNull() && !this->imageProcessingValid && !this->zoomValid && this->softwareAdjustment.isIdentity() && this->demosaic.isDefault() && this->windowLevel.isDefault() && this->lens.isDefault() && !this->nativeCapture && this->nativeControls.isEmpty();}
+	QVariantMap toVariantMap() const;
+	static CameraDeviceConfig fromVariantMap(const QVariantMap& map);
+	static CameraDeviceConfig fromCamera(QCamera* camera);
+
+	//viewfinder settings have to be applied before start(), so the camera is started in its final mode and does not renegotiate
+	void applyViewfinder(QCamera* camera) const;
+	//image processing and zoom are only available once the camera is loaded
+	void applyControls(QCamera* camera) const;
+};
+
+//stored configurations of all camera devices, shared by all camera views. a device used in two views has one configuration
+class CameraDeviceConfigStore : public QObject
+{
+	Q_OBJECT
+public:
+	explicit CameraDeviceConfigStore(QObject* parent = nullptr);
+
+	CameraDeviceConfig getConfig(const QString& deviceName) const {return this->configs.value(deviceName);}
+	bool hasConfig(const QString& deviceName) const {return this->configs.contains(deviceName);}
+	void setConfig(const QString& deviceName, const CameraDeviceConfig& config);
+	void removeConfig(const QString& deviceName);
+
+	void setSettings(const QVariantMap& settings);
+	QVariantMap getSettings() const;
+
+private:
+	QHash<QString, CameraDeviceConfig> configs;
+
+signals:
+	void configChanged(QString deviceName);
+};
+
+#endif //CAMERADEVICECONFIG_H
@@ -0,0 +1,195 @@
+#include "capabilityprobe.h"
+
+
+ProbeSurface::ProbeSurface(QObject* parent)
+	: QAbstractVideoSurface(parent),
+	  frames(0),
+	  generation(0)
+{
+}
+
+QList<QVideoFrame::PixelFormat> ProbeSurface::supportedPixelFormats(QAbstractVideoBuffer::HandleType type) const {
+	//frames are never mapped, so every memory format can be accepted. this keeps the backend from inserting a conversion that would distort the measurement
+	if(type != QAbstractVideoBuffer::NoHandle){
+		return QList<QVideoFrame::PixelFormat>();
+	}
+	return QList<QVideoFrame::PixelFormat>()
+		<< QVideoFrame::Format_ARGB32
+		<< QVideoFrame::Format_RGB32
+		<< QVideoFrame::Format_RGB24
+		<< QVideoFrame::Format_RGB565
+		<< QVideoFrame::Format_BGRA32
+		<< QVideoFrame::Format_BGR32
+		<< QVideoFrame::Format_BGR24
+		<< QVideoFrame::Format_YUV420P
+		<< QVideoFrame::Format_YV12
+		<< QVideoFrame::Format_UYVY
+		<< QVideoFrame::Format_YUYV
+		<< QVideoFrame::Format_NV12
+		<< QVideoFrame::Format_NV21
+		<< QVideoFrame::Format_Y8
+		<< QVideoFrame::Format_Y16
+		<< QVideoFrame::Format_Jpeg;
+}
+
+bool ProbeSurface::present(const QVideoFrame& frame) {
+	if(this->frames.fetchAndAddOrdered(1) == 0){
+		emit firstFrameArrived(frame.size(), this->generation.loadAcquire());
+	}
+	return true;
+}
+
+
+CapabilityProbe::CapabilityProbe(const QCameraInfo& cameraInfo, QObject* parent)
+	: QObject(parent),
+	  cameraInfo(cameraInfo),
+	  camera(nullptr),
+	  surface(new ProbeSurface(this)),
+	  currentIndex(-1),
+	  measuring(false),
+	  modesRequested(false),
+	  firstFrameMs(-1),
+	  modeGeneration(0),
+	  timer(new QTimer(this))
+{
+	this->timer->setSingleShot(true);
+	connect(this->timer, &QTimer::timeout, this, &CapabilityProbe::onTimeout);
+	connect(this->surface, &ProbeSurface::firstFrameArrived, this, &CapabilityProbe::onFirstFrame);
+}
+
+CapabilityProbe::~CapabilityProbe() {
+	this->releaseCamera();
+}
+
+void CapabilityProbe::start(const QList<QCameraViewfinderSettings>& modes) {
+	if(this->isRunning() || this->cameraInfo.isNull()){
+		return;
+	}
+	this->modes = modes;
+	this->modesRequested = !modes.isEmpty();
+	this->currentIndex = -1;
+	this->result = DeviceCapabilities();
+	this->result.deviceName = this->cameraInfo.deviceName();
+	this->result.description = this->cameraInfo.description();
+
+	this->camera = new QCamera(this->cameraInfo, this);
+	this->camera->setViewfinder(this->surface);
+	connect(this->camera, &QCamera::stateChanged, this, &CapabilityProbe::onStateChanged);
+	connect(this->camera, &QCamera::errorOccurred, this, &CapabilityProbe::onCameraError);
+	this->camera->load();
+}
+
+void CapabilityProbe::cancel() {
+	if(!this->isRunning()){
+		return;
+	}
+	this->timer->stop();
+	this->releaseCamera();
+	emit canceled();
+}
+
+void CapabilityProbe::releaseCamera() {
+	if(this->camera == nullptr){
+		return;
+	}
+	this->timer->stop();
+	this->camera->disconnect(this);
+	this->camera->stop();
+	this->camera->unload();
+	this->camera->setViewfinder(static_cast<QAbstractVideoSurface*>(nullptr));
+	this->camera->deleteLater();
+	this->camera = nullptr;
+}
+
+void CapabilityProbe::onStateChanged(QCamera::State state) {
+	//the advertised modes are only known once the camera is loaded
+	if(state != QCamera::LoadedState || this->currentIndex >= 0){
+		return;
+	}
+	if(!this->modesRequested){
+		this->modes = this->camera->supportedViewfinderSettings();
+		if(this->modes.isEmpty()){
+			this->modes = CameraCapabilities::fallbackModes();
+		}
+	}
+	emit info(tr("Measuring %1 camera modes of %2").arg(this->modes.size()).arg(this->cameraInfo.description()));
+	this->probeNext();
+}
+
+void CapabilityProbe::probeNext() {
+	this->currentIndex++;
+	if(this->currentIndex >= this->modes.size()){
+		this->releaseCamera();
+		this->result.probed = QDateTime::currentDateTime();
+		emit finished(this->result);
+		return;
+	}
+	emit progress(this->currentIndex + 1, this->modes.size());
+
+	//modes are applied while the camera is stopped, a mode change of a running camera is not supported by all backends
+	this->camera->stop();
+	this->camera->setViewfinderSettings(this->modes.at(this->currentIndex));
+	this->modeGeneration++;
+	this->surface->setGeneration(this->modeGeneration);
+	this->surface->resetCount();
+	this->measuring = false;
+	this->firstFrameMs = -1;
+	this->deliveredSize = QSize();
+	this->clock.start();
+	this->camera->start();
+	this->timer->start(FIRST_FRAME_TIMEOUT_MS);
+}
+
+void CapabilityProbe::onFirstFrame(QSize size, int generation) {
+	//a first frame of the previous mode may still be queued when the next mode starts, it would shorten firstFrameMs of the new mode
+	if(!this->isRunning() || this->measuring || generation != this->modeGeneration){
+		return;
+	}
+	//frames counted from here on are delivered at the steady state rate
+	this->firstFrameMs = this->clock.elapsed();
+	this->deliveredSize = size;
+	this->measuring = true;
+	this->surface->resetCount();
+	this->clock.start();
+	this->timer->start(MEASUREMENT_MS);
+}
+
+void CapabilityProbe::onTimeout() {
+	if(!this->isRunning()){
+		return;
+	}
+	//no frame within FIRST_FRAME_TIMEOUT_MS means the mode does not work
+	this->finishMode(this->measuring);
+}
+
+void CapabilityProbe::onCameraError(QCamera::Error error) {
+	Q_UNUSED(error)
+	if(!this->isRunning()){
+		return;
+	}
+	if(this->currentIndex < 0){
+		//the camera could not even be loaded
+		emit info(tr("Camera %1 could not be opened for measuring: %2").arg(this->cameraInfo.description()).arg(this->camera->errorString()));
+		this->releaseCamera();
+		emit canceled();
+		return;
+	}
+	this->timer->stop();
+	this->finishMode(false);
+}
+
+void CapabilityProbe::finishMode(bool valid) {
+	ProbedMode mode;
+	mode.settings = this->modes.at(this->currentIndex);
+	mode.firstFrameMs = this->firstFrameMs;
+	mode.deliveredSize = this->deliveredSize;
+	if(valid){
+		qint64 elapsed = qMax(Q_INT64_C(1), this->clock.elapsed());
+		mode.measuredFps = this->surface->getFrameCount()*1000.0/elapsed;
+		//some backends silently fall back to another resolution if the requested one is not supported
+		QSize requested = mode.settings.resolution();
+		mode.valid = mode.measuredFps > 0.0 && (requested.isEmpty() || requested == this->deliveredSize);
+	}
+	this->result.modes.append(mode);
+	this->probeNext();
+}
@@ -0,0 +1,89 @@
+#ifndef CAPABILITYPROBE_H
+#define CAPABILITYPROBE_H
+
+#include <QObject>
+#include <QCamera>
+#include <QCameraInfo>
+#include <QAbstractVideoSurface>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QAtomicInteger>
+#include "cameracapabilities.h"
+
+
+//video surface that only counts the delivered frames. the first frame after resetCount() is signaled with the mode generation that was set
+//before, so a signal that was still queued from the previous mode can be told apart
+class ProbeSurface : public QAbstractVideoSurface
+{
+	Q_OBJECT
+public:
+	explicit ProbeSurface(QObject* parent = nullptr);
+
+	QList<QVideoFrame::PixelFormat> supportedPixelFormats(QAbstractVideoBuffer::HandleType type = QAbstractVideoBuffer::NoHandle) const override;
+	bool present(const QVideoFrame& frame) override;
+
+	void resetCount() {this->frames.storeRelease(0);}
+	int getFrameCount() const {return this->frames.loadAcquire();}
+	void setGeneration(int generation) {this->generation.storeRelease(generation);}
+
+private:
+	QAtomicInteger<int> frames;
+	QAtomicInteger<int> generation;
+
+signals:
+	void firstFrameArrived(QSize size, int generation);
+};
+
+
+//opens a camera with one viewfinder mode after the other and measures time to first frame and the frame rate that is actually delivered.
+//runs asynchronously on the gui thread (QCamera is not thread safe), the camera can not be used by a camera view while it is probed
+class CapabilityProbe : public QObject
+{
+	Q_OBJECT
+public:
+	explicit CapabilityProbe(const QCameraInfo& cameraInfo, QObject* parent = nullptr);
+	~CapabilityProbe();
+
+	//modes to measure. if empty the advertised modes of the camera are measured, or the fallback modes if it does not advertise any
+	void start(const QList<QCameraViewfinderSettings>& modes = QList<QCameraViewfinderSettings>());
+	void cancel();
+	bool isRunning() const {return this->camera != nullptr;}
+	int getCurrentIndex() const {return this->currentIndex;}
+	int getModeCount() const {return this->modes.size();}
+
+	static const int FIRST_FRAME_TIMEOUT_MS = 4000;
+	static const int MEASUREMENT_MS = 1500;
+
+private:
+	QCameraInfo cameraInfo;
+	QCamera* camera;
+	ProbeSurface* surface;
+	QList<QCameraViewfinderSettings> modes;
+	DeviceCapabilities result;
+	int currentIndex;
+	bool measuring;
+	bool modesRequested;
+	QSize deliveredSize;
+	qint64 firstFrameMs;
+	int modeGeneration; //incremented for every mode, first frame signals of other generations are ignored
+	QElapsedTimer clock;
+	QTimer* timer;
+
+	void probeNext();
+	void finishMode(bool valid);
+	void releaseCamera();
+
+private slots:
+	void onStateChanged(QCamera::State state);
+	void onFirstFrame(QSize size, int generation);
+	void onTimeout();
+	void onCameraError(QCamera::Error error);
+
+signals:
+	void progress(int current, int total);
+	void finished(DeviceCapabilities capabilities);
+	void canceled();
+	void info(QString);
+};
+
+#endif //CAPABILITYPROBE_H
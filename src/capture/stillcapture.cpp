@@ -0,0 +1,271 @@
+#include "stillcapture.h"
+#include <QImageEncoderSettings>
+
+#define SAVE_RETRY_INTERVAL_MS 20
+
+StillCapture::StillCapture(QObject* parent)
+	: QObject(parent),
+	  imageCapture(nullptr),
+	  toBuffer(false),
+	  configured(false),
+	  singleStream(false),
+	  lastStatus(QCamera::UnloadedStatus),
+	  latencySamples(0)
+{
+	this->saveRetryTimer.setSingleShot(true);
+	this->saveRetryTimer.setInterval(SAVE_RETRY_INTERVAL_MS);
+	connect(&this->saveRetryTimer, &QTimer::timeout, this, &StillCapture::retrySaves);
+}
+
+StillCapture::~StillCapture() {
+	this->releaseCapture();
+	//save tasks refer to this object
+	this->pendingTasks.waitForAll();
+}
+
+void StillCapture::setCamera(QCamera* camera) {
+	if(this->camera == camera){
+		return;
+	}
+	this->releaseCapture();
+	this->camera = camera;
+	if(camera == nullptr){
+		return;
+	}
+	this->lastStatus = camera->status();
+	this->imageCapture = new QCameraImageCapture(camera, this);
+	connect(this->imageCapture, &QCameraImageCapture::readyForCaptureChanged, this, &StillCapture::onReadyForCaptureChanged);
+	connect(this->imageCapture, &QCameraImageCapture::imageAvailable, this, &StillCapture::onImageAvailable);
+	connect(this->imageCapture, &QCameraImageCapture::imageSaved, this, &StillCapture::onImageSaved);
+	connect(this->imageCapture, QOverload<int, QCameraImageCapture::Error, const QString&>::of(&QCameraImageCapture::error), this, &StillCapture::onCaptureError);
+	connect(camera, &QCamera::statusChanged, this, &StillCapture::onCameraStatusChanged);
+
+	//stills are kept in memory and saved by the extension if possible, this avoids a jpeg round trip through the file system
+	this->toBuffer = this->imageCapture->isCaptureDestinationSupported(QCameraImageCapture::CaptureToBuffer);
+	this->imageCapture->setCaptureDestination(this->toBuffer ? QCameraImageCapture::CaptureToBuffer : QCameraImageCapture::CaptureToFile);
+}
+
+void StillCapture::releaseCapture() {
+	if(this->camera){
+		disconnect(this->camera, nullptr, this, nullptr);
+	}
+	if(this->imageCapture != nullptr){
+		this->imageCapture->disconnect(this);
+		delete this->imageCapture;
+		this->imageCapture = nullptr;
+	}
+	//stills that were requested but not delivered are lost with the camera
+	for(const PendingStill& still : this->pendingStills){
+		emit stillSaved(still.filePath, false, -1, QSize());
+	}
+	for(const PendingStill& still : this->waitingStills){
+		emit stillSaved(still.filePath, false, -1, QSize());
+	}
+	for(const UnsavedStill& still : this->unsavedStills){
+		emit stillSaved(still.filePath, false, -1, QSize());
+	}
+	this->statistics.stillsFailed += this->pendingStills.size() + this->waitingStills.size() + this->unsavedStills.size();
+	this->pendingStills.clear();
+	this->waitingStills.clear();
+	this->unsavedStills.clear();
+	this->saveRetryTimer.stop();
+	this->resolution = QSize();
+	this->configured = false;
+	this->singleStream = false;
+	this->lastStatus = QCamera::UnloadedStatus;
+	this->statistics.stillPathAvailable = false;
+	this->statistics.stillResolution = QSize();
+	this->statistics.singleStream = false;
+	this->camera = nullptr;
+}
+
+bool StillCapture::isAvailable() const {
+	return this->imageCapture != nullptr && this->imageCapture->isAvailable();
+}
+
+void StillCapture::onCameraStatusChanged(QCamera::Status status) {
+	//the capture resolution is set while the camera is loaded and before it streams, so the backend can set up both streams at once
+	if(!this->configured && (status == QCamera::LoadedStatus || status == QCamera::StartingStatus || status == QCamera::ActiveStatus)){
+		this->configure();
+	}
+
+	//a backend with a single stream stops streaming to reconfigure it for the still, while the camera itself stays in the active state.
+	//from then on stills are taken at the viewfinder resolution, the backend does not have to reconfigure the stream for them
+	bool wasActive = this->lastStatus == QCamera::ActiveStatus;
+	this->lastStatus = status;
+	if(wasActive && status != QCamera::ActiveStatus && !this->pendingStills.isEmpty() && this->camera->state() == QCamera::ActiveState){
+		this->statistics.liveViewRestarts++;
+		if(!this->singleStream){
+			this->singleStream = true;
+			this->statistics.singleStream = true;
+			this->applyResolution(this->camera->viewfinderSettings().resolution());
+		}
+	}
+}
+
+void StillCapture::configure() {
+	if(this->imageCapture == nullptr){
+		return;
+	}
+	this->configured = true;
+	bool continuous = false;
+	const QList<QSize> resolutions = this->imageCapture->supportedResolutions(QImageEncoderSettings(), &continuous);
+	QSize largest;
+	for(const QSize& size : resolutions){
+		if(static_cast<qint64>(size.width())*size.height() > static_cast<qint64>(largest.width())*largest.height()){
+			largest = size;
+		}
+	}
+	this->applyResolution(largest);
+	this->statistics.stillPathAvailable = this->imageCapture->isAvailable();
+}
+
+void StillCapture::applyResolution(const QSize& size) {
+	if(size.isValid()){
+		QImageEncoderSettings settings = this->imageCapture->encodingSettings();
+		settings.setResolution(size);
+		settings.setQuality(QMultimedia::VeryHighQuality);
+		this->imageCapture->setEncodingSettings(settings);
+	}
+	//if the backend does not report its resolutions it captures in its default still resolution, the actual size is known with the first still
+	this->resolution = size;
+	this->statistics.stillResolution = size;
+}
+
+bool StillCapture::capture(const QString& filePath) {
+	if(!this->isAvailable()){
+		return false;
+	}
+	if(!this->configured){
+		this->configure();
+	}
+	PendingStill still;
+	still.filePath = filePath;
+	still.timer.start();
+	if(this->imageCapture->isReadyForCapture()){
+		this->captureNow(still);
+	} else if(this->waitingStills.size() < MAX_WAITING_STILLS){
+		//the backend is still busy with the previous still, requests are captured in order as soon as it is ready
+		this->waitingStills.enqueue(still);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void StillCapture::captureNow(const PendingStill& still) {
+	int id = this->imageCapture->capture(this->toBuffer ? QString() : still.filePath);
+	if(id < 0){
+		this->statistics.stillsFailed++;
+		emit stillSaved(still.filePath, false, -1, QSize());
+		return;
+	}
+	this->pendingStills.insert(id, still);
+}
+
+void StillCapture::onReadyForCaptureChanged(bool ready) {
+	if(ready && !this->waitingStills.isEmpty()){
+		this->captureNow(this->waitingStills.dequeue());
+	}
+}
+
+void StillCapture::onImageAvailable(int id, const QVideoFrame& frame) {
+	if(!this->toBuffer || !this->pendingStills.contains(id)){
+		return;
+	}
+	PendingStill still = this->pendingStills.take(id);
+	qint64 latency = still.timer.elapsed();
+	this->recordLatency(latency);
+
+	//decoding (usually jpeg) and png encoding of a full resolution image takes too long for the gui thread
+	UnsavedStill unsaved;
+	unsaved.filePath = still.filePath;
+	unsaved.frame = frame;
+	unsaved.latency = latency;
+	if(!this->unsavedStills.isEmpty() || !this->submitSave(unsaved)){
+		//the pool is saturated, the still is saved once it accepts tasks again. stills beyond MAX_WAITING_STILLS are dropped
+		if(this->unsavedStills.size() >= MAX_WAITING_STILLS){
+			this->statistics.stillsFailed++;
+			emit this->error(tr("Still dropped, the processing threads are busy: ") + unsaved.filePath);
+			emit stillSaved(unsaved.filePath, false, latency, QSize());
+			return;
+		}
+		this->unsavedStills.enqueue(unsaved);
+		this->saveRetryTimer.start();
+	}
+}
+
+bool StillCapture::submitSave(const UnsavedStill& still) {
+	QVideoFrame frame = still.frame;
+	QString filePath = still.filePath;
+	qint64 latency = still.latency;
+	this->pendingTasks.add();
+	bool accepted = WorkStealingPool::globalInstance()->trySubmit([this, frame, filePath, latency]() {
+		QImage image = frame.image();
+		bool success = !image.isNull() && image.save(filePath);
+		QSize size = image.size();
+		QMetaObject::invokeMethod(this, [this, filePath, success, latency, size]() {
+			if(!success){
+				this->statistics.stillsFailed++;
+			} else {
+				this->statistics.stillsCaptured++;
+				this->resolution = size;
+				this->statistics.stillResolution = size;
+			}
+			emit stillSaved(filePath, success, latency, size);
+		}, Qt::QueuedConnection);
+		this->pendingTasks.done();
+	});
+	if(!accepted){
+		this->pendingTasks.done();
+	}
+	return accepted;
+}
+
+void StillCapture::retrySaves() {
+	//stills are saved in the order they were taken
+	while(!this->unsavedStills.isEmpty() && this->submitSave(this->unsavedStills.head())){
+		this->unsavedStills.dequeue();
+	}
+	if(!this->unsavedStills.isEmpty()){
+		this->saveRetryTimer.start();
+	}
+}
+
+void StillCapture::onImageSaved(int id, const QString& fileName) {
+	if(this->toBuffer || !this->pendingStills.contains(id)){
+		return;
+	}
+	PendingStill still = this->pendingStills.take(id);
+	qint64 latency = still.timer.elapsed();
+	this->recordLatency(latency);
+	this->statistics.stillsCaptured++;
+	emit stillSaved(fileName, true, latency, this->resolution);
+}
+
+void StillCapture::onCaptureError(int id, QCameraImageCapture::Error error, const QString& errorString) {
+	Q_UNUSED(error)
+	if(!this->pendingStills.contains(id)){
+		return;
+	}
+	PendingStill still = this->pendingStills.take(id);
+	this->statistics.stillsFailed++;
+	emit this->error(tr("Still capture failed: ") + errorString);
+	emit stillSaved(still.filePath, false, -1, QSize());
+}
+
+void StillCapture::recordPreviewStill(qint64 latencyMs, bool success) {
+	if(!success){
+		this->statistics.stillsFailed++;
+		return;
+	}
+	this->statistics.previewStills++;
+	this->recordLatency(latencyMs);
+}
+
+void StillCapture::recordLatency(qint64 latencyMs) {
+	quint64 count = ++this->latencySamples;
+	this->statistics.lastLatencyMs = latencyMs;
+	this->statistics.maxLatencyMs = qMax(this->statistics.maxLatencyMs, latencyMs);
+	this->statistics.averageLatencyMs += (latencyMs - this->statistics.averageLatencyMs)/count;
+}
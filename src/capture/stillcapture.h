@@ -0,0 +1,103 @@
+#ifndef STILLCAPTURE_H
+#define STILLCAPTURE_H
+
+#include <QObject>
+#include <QCamera>
+#include <QCameraImageCapture>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QQueue>
+#include <QTimer>
+#include <QVideoFrame>
+#include "workstealingpool.h"
+
+
+struct StillCaptureStatistics {
+	bool stillPathAvailable = false;
+	QSize stillResolution;
+	quint64 stillsCaptured = 0; //via the still capture path
+	quint64 previewStills = 0; //taken from the preview stream because the still path was not available
+	quint64 stillsFailed = 0;
+	quint64 liveViewRestarts = 0; //stills that made the backend restart the live view
+	bool singleStream = false; //stills are taken at the viewfinder resolution because the backend has only one stream
+	qint64 lastLatencyMs = -1;
+	qint64 maxLatencyMs = -1;
+	double averageLatencyMs = 0.0;
+};
+
+//full resolution stills of a camera whose preview runs at a lower resolution. the still path (QCameraImageCapture) is configured for the
+//highest supported resolution once while the camera is loaded, before the viewfinder stream starts, so backends with a separate still
+//stream take stills without touching the viewfinder. backends with a single stream have to reconfigure it for a still, they leave the
+//active status while a still is pending although the camera was not stopped. this restart of the live view is counted and all further
+//stills of the camera are taken at the viewfinder resolution, so only the first still restarts the live view.
+//captured images are converted and saved on the WorkStealingPool, stills the saturated pool rejects wait for a retry.
+//latency is measured from the request until the still image is in memory (or written by the backend if it can only capture to file)
+class StillCapture : public QObject
+{
+	Q_OBJECT
+public:
+	explicit StillCapture(QObject* parent = nullptr);
+	~StillCapture();
+
+	//has to be called before the camera is loaded or started, nullptr detaches from the current camera
+	void setCamera(QCamera* camera);
+	bool isAvailable() const;
+	QSize getResolution() const {return this->resolution;}
+	//file suffix of the stills, backends that can only capture to file write jpeg
+	QString getFileSuffix() const {return this->toBuffer ? QStringLiteral("png") : QStringLiteral("jpg");}
+	bool capture(const QString& filePath);
+
+	//stills that were taken elsewhere (e.g. from the preview stream) are counted as well, so the statistics cover all snapshots
+	void recordPreviewStill(qint64 latencyMs, bool success);
+	StillCaptureStatistics getStatistics() const {return this->statistics;}
+
+	static const int MAX_WAITING_STILLS = 8;
+
+private:
+	struct PendingStill {
+		QString filePath;
+		QElapsedTimer timer;
+	};
+	struct UnsavedStill {
+		QString filePath;
+		QVideoFrame frame;
+		qint64 latency;
+	};
+
+	QPointer<QCamera> camera;
+	QCameraImageCapture* imageCapture;
+	QSize resolution;
+	bool toBuffer;
+	bool configured;
+	bool singleStream;
+	QCamera::Status lastStatus;
+	QHash<int, PendingStill> pendingStills;
+	QQueue<PendingStill> waitingStills;
+	QQueue<UnsavedStill> unsavedStills;
+	QTimer saveRetryTimer;
+	WorkStealingPool::TaskCounter pendingTasks;
+	StillCaptureStatistics statistics;
+	quint64 latencySamples;
+
+	void configure();
+	void applyResolution(const QSize& size);
+	bool submitSave(const UnsavedStill& still);
+	void captureNow(const PendingStill& still);
+	void recordLatency(qint64 latencyMs);
+	void releaseCapture();
+
+private slots:
+	void onCameraStatusChanged(QCamera::Status status);
+	void onReadyForCaptureChanged(bool ready);
+	void onImageAvailable(int id, const QVideoFrame& frame);
+	void retrySaves();
+	void onImageSaved(int id, const QString& fileName);
+	void onCaptureError(int id, QCameraImageCapture::Error error, const QString& errorString);
+
+signals:
+	void stillSaved(QString filePath, bool success, qint64 latencyMs, QSize size);
+	void error(QString);
+};
+
+#endif //STILLCAPTURE_H
@@ -0,0 +1,107 @@
+#include "v4l2device.h"
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+
+V4l2SystemDevice::V4l2SystemDevice()
+	: fd(-1)
+{
+}
+
+V4l2SystemDevice::~V4l2SystemDevice() {
+	this->close();
+}
+
+bool V4l2SystemDevice::open(const QString& path) {
+	this->close();
+#ifdef __linux__
+	this->fd = ::open(path.toLocal8Bit().constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	return this->fd >= 0;
+#else
+	Q_UNUSED(path)
+	errno = ENOSYS;
+	return false;
+#endif
+}
+
+void V4l2SystemDevice::close() {
+#ifdef __linux__
+	if(this->fd >= 0){
+		::close(this->fd);
+	}
+#endif
+	this->fd = -1;
+}
+
+int V4l2SystemDevice::ioctl(unsigned long request, void* argument) {
+#ifdef __linux__
+	//ioctls of V4L2 drivers may be interrupted by signals and have to be repeated then
+	int result;
+	do {
+		result = ::ioctl(this->fd, request, argument);
+	} while(result == -1 && errno == EINTR);
+	return result;
+#else
+	Q_UNUSED(request)
+	Q_UNUSED(argument)
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+void* V4l2SystemDevice::map(quint32 length, quint32 offset) {
+#ifdef __linux__
+	void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, static_cast<off_t>(offset));
+	return address == MAP_FAILED ? nullptr : address;
+#else
+	Q_UNUSED(length)
+	Q_UNUSED(offset)
+	return nullptr;
+#endif
+}
+
+void V4l2SystemDevice::unmap(void* address, quint32 length) {
+#ifdef __linux__
+	munmap(address, length);
+#else
+	Q_UNUSED(address)
+	Q_UNUSED(length)
+#endif
+}
+
+int V4l2SystemDevice::waitForFrame(int timeoutMs) {
+#ifdef __linux__
+	pollfd request;
+	request.fd = this->fd;
+	request.events = POLLIN;
+	request.revents = 0;
+	int result = poll(&request, 1, timeoutMs);
+	if(result < 0){
+		return errno == EINTR ? 0 : -1;
+	}
+	if(result == 0){
+		return 0;
+	}
+	return (request.revents & POLLERR) ? -1 : 1;
+#else
+	Q_UNUSED(timeoutMs)
+	return -1;
+#endif
+}
+
+void V4l2SystemDevice::closeExported(int fd) {
+#ifdef __linux__
+	if(fd >= 0){
+		::close(fd);
+	}
+#else
+	Q_UNUSED(fd)
+#endif
+}
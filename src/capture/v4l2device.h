@@ -0,0 +1,49 @@
+#ifndef V4L2DEVICE_H
+#define V4L2DEVICE_H
+
+#include <QString>
+
+
+//system calls of a V4L2 video device. V4l2Source talks to the device only through this interface, so the streaming logic can be run against a
+//simulated device without camera hardware (see tools/v4l2). the calls follow the semantics of the system calls they replace: ioctl() returns -1
+//and sets errno on failure, map() returns nullptr on failure. ioctl() and unmap() may be called from any thread
+class V4l2Device
+{
+public:
+	virtual ~V4l2Device() {}
+
+	//the device is opened non-blocking, buffers are only dequeued after waitForFrame() reported a frame
+	virtual bool open(const QString& path) = 0;
+	virtual void close() = 0;
+	virtual bool isOpen() const = 0;
+	virtual int ioctl(unsigned long request, void* argument) = 0;
+	virtual void* map(quint32 length, quint32 offset) = 0;
+	//mappings stay valid after close(), frames may still reference them
+	virtual void unmap(void* address, quint32 length) = 0;
+	//returns 1 if a buffer can be dequeued, 0 on timeout and -1 on error (e.g. the stream was switched off)
+	virtual int waitForFrame(int timeoutMs) = 0;
+	//closes a DMABUF file descriptor exported with VIDIOC_EXPBUF
+	virtual void closeExported(int fd) = 0;
+};
+
+//the device node of the kernel driver, not available on other systems than linux
+class V4l2SystemDevice : public V4l2Device
+{
+public:
+	V4l2SystemDevice();
+	~V4l2SystemDevice() override;
+
+	bool open(const QString& path) override;
+	void close() override;
+	bool isOpen() const override {return this->fd >= 0;}
+	int ioctl(unsigned long request, void* argument) override;
+	void* map(quint32 length, quint32 offset) override;
+	void unmap(void* address, quint32 length) override;
+	int waitForFrame(int timeoutMs) override;
+	void closeExported(int fd) override;
+
+private:
+	int fd;
+};
+
+#endif //V4L2DEVICE_H
@@ -0,0 +1,690 @@
+#include "v4l2source.h"
+#include <QAbstractVideoBuffer>
+#include <QVideoSurfaceFormat>
+#include <QMutexLocker>
+#include <QVector>
+#include <QWeakPointer>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/videodev2.h>
+#include <fcntl.h>
+#include <time.h>
+#endif
+
+
+//buffers of a running stream. shared by the source and by all frames that reference a buffer, so the mappings stay valid as long as a frame is
+//held, even if the source was closed in the meantime
+class V4l2Stream
+{
+public:
+	struct Buffer {
+		uchar* data;
+		quint32 length;
+		int dmabufFd;
+	};
+
+	explicit V4l2Stream(QSharedPointer<V4l2Device> device)
+		: device(device),
+		  streaming(false),
+		  queuedBuffers(0)
+	{
+	}
+
+	~V4l2Stream() {
+		for(const Buffer& buffer : this->buffers){
+			if(buffer.dmabufFd >= 0){
+				this->device->closeExported(buffer.dmabufFd);
+			}
+			this->device->unmap(buffer.data, buffer.length);
+		}
+	}
+
+	bool queue(int index) {
+#ifdef __linux__
+		v4l2_buffer buffer;
+		memset(&buffer, 0, sizeof(buffer));
+		buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buffer.memory = V4L2_MEMORY_MMAP;
+		buffer.index = static_cast<quint32>(index);
+		if(this->device->ioctl(VIDIOC_QBUF, &buffer) < 0){
+			return false;
+		}
+		this->queuedBuffers.ref();
+		return true;
+#else
+		Q_UNUSED(index)
+		return false;
+#endif
+	}
+
+	//called when the last frame that references the buffer was released. the buffer goes back to the driver unless the stream was stopped
+	void release(int index) {
+		QMutexLocker locker(&this->mutex);
+		if(this->streaming){
+			this->queue(index);
+		}
+	}
+
+	QSharedPointer<V4l2Device> device;
+	QVector<Buffer> buffers;
+	QMutex mutex;
+	bool streaming;
+	QAtomicInt queuedBuffers;
+};
+
+
+//video buffer that references a driver buffer of the stream. the buffer is queued again when the last frame that uses it is destroyed.
+//handleType() is NoHandle although handle() returns the DMABUF file descriptor (an int, invalid QVariant without export): the frames are
+//negotiated with the surface as mapped memory, and surfaces such as QPainterVideoSurface stop on frames with a different handle type.
+//the descriptor is an addition for consumers that know this source, every other one uses map()
+class V4l2VideoBuffer : public QAbstractVideoBuffer
+{
+public:
+	V4l2VideoBuffer(QSharedPointer<V4l2Stream> stream, int index, int size, int bytesPerLine)
+		: QAbstractVideoBuffer(QAbstractVideoBuffer::NoHandle),
+		  stream(stream),
+		  index(index),
+		  size(size),
+		  lineBytes(bytesPerLine),
+		  mode(QAbstractVideoBuffer::NotMapped)
+	{
+	}
+
+	~V4l2VideoBuffer() override {
+		this->stream->release(this->index);
+	}
+
+	MapMode mapMode() const override {return this->mode;}
+
+	uchar* map(MapMode mode, int* numBytes, int* bytesPerLine) override {
+		//the buffer is filled by the driver again once it is queued, the frame data must not be modified
+		if(mode != QAbstractVideoBuffer::ReadOnly || this->mode != QAbstractVideoBuffer::NotMapped){
+			return nullptr;
+		}
+		this->mode = mode;
+		if(numBytes != nullptr){
+			*numBytes = this->size;
+		}
+		if(bytesPerLine != nullptr){
+			*bytesPerLine = this->lineBytes;
+		}
+		return this->stream->buffers.at(this->index).data;
+	}
+
+	void unmap() override {
+		this->mode = QAbstractVideoBuffer::NotMapped;
+	}
+
+	QVariant handle() const override {
+		int fd = this->stream->buffers.at(this->index).dmabufFd;
+		return fd >= 0 ? QVariant(fd) : QVariant();
+	}
+
+private:
+	QSharedPointer<V4l2Stream> stream;
+	int index;
+	int size;
+	int lineBytes;
+	MapMode mode;
+};
+
+
+namespace {
+#ifdef __linux__
+	//the name arrays of the driver are not necessarily terminated
+	QString driverString(const __u8* text, int size) {
+		return QString::fromLatin1(reinterpret_cast<const char*>(text), static_cast<int>(qstrnlen(reinterpret_cast<const char*>(text), static_cast<uint>(size))));
+	}
+
+	qint64 monotonicTimeUs() {
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<qint64>(now.tv_sec)*1000000 + now.tv_nsec/1000;
+	}
+#endif
+}
+
+
+V4l2Source::V4l2Source(QAbstractVideoSurface* surface, QObject *parent)
+	: QObject(parent),
+	  surface(surface),
+	  captureThread(nullptr),
+	  stopping(0),
+	  fourcc(0),
+	  pixelFormat(QVideoFrame::Format_Invalid),
+	  bytesPerLine(0),
+	  framePending(false),
+	  lastSequence(0),
+	  lastTimestamp(-1),
+	  latencySum(0.0),
+	  latencyCount(0)
+{
+}
+
+V4l2Source::~V4l2Source() {
+	this->close();
+}
+
+bool V4l2Source::isSupported() {
+#ifdef __linux__
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool V4l2Source::open(const QString& devicePath, const QCameraViewfinderSettings& settings) {
+	return this->open(QSharedPointer<V4l2Device>(new V4l2SystemDevice()), devicePath, settings);
+}
+
+bool V4l2Source::open(QSharedPointer<V4l2Device> device, const QString& devicePath, const QCameraViewfinderSettings& settings) {
+	this->close();
+#ifdef __linux__
+	if(this->surface.isNull()){
+		return false;
+	}
+	if(!device->open(devicePath)){
+		emit error(tr("Could not open %1: %2").arg(devicePath).arg(QString::fromLocal8Bit(strerror(errno))));
+		return false;
+	}
+	this->device = device;
+	this->devicePath = devicePath;
+
+	v4l2_capability capability;
+	memset(&capability, 0, sizeof(capability));
+	if(device->ioctl(VIDIOC_QUERYCAP, &capability) < 0){
+		return this->fail(tr("%1 is not a V4L2 device.").arg(devicePath));
+	}
+	quint32 capabilities = (capability.capabilities & V4L2_CAP_DEVICE_CAPS) ? capability.device_caps : capability.capabilities;
+	if(!(capabilities & V4L2_CAP_VIDEO_CAPTURE) || !(capabilities & V4L2_CAP_STREAMING)){
+		return this->fail(tr("%1 does not support single-planar video capture with streaming I/O.").arg(devicePath));
+	}
+
+	//formats of the driver that the surface accepts as they are
+	QList<QVideoFrame::PixelFormat> surfaceFormats = this->surface->supportedPixelFormats(QAbstractVideoBuffer::NoHandle);
+	QList<quint32> fourccs;
+	v4l2_fmtdesc description;
+	memset(&description, 0, sizeof(description));
+	description.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	while(device->ioctl(VIDIOC_ENUM_FMT, &description) == 0){
+		if(!(description.flags & V4L2_FMT_FLAG_COMPRESSED) && surfaceFormats.contains(toPixelFormat(description.pixelformat))){
+			fourccs.append(description.pixelformat);
+		}
+		description.index++;
+	}
+	if(fourccs.isEmpty()){
+		return this->fail(tr("%1 offers no uncompressed pixel format that can be displayed.").arg(devicePath));
+	}
+
+	//the requested pixel format if the driver offers it, otherwise the current format of the driver, otherwise the first usable one. the current
+	//format is kept if it is the requested one, e.g. the Bayer mosaic of a raw camera among other mosaics that are all Format_CameraRaw
+	v4l2_format format;
+	memset(&format, 0, sizeof(format));
+	format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if(device->ioctl(VIDIOC_G_FMT, &format) < 0){
+		return this->fail(tr("Could not read the format of %1.").arg(devicePath));
+	}
+	quint32 fourcc = fourccs.contains(format.fmt.pix.pixelformat) ? format.fmt.pix.pixelformat : fourccs.first();
+	if(toPixelFormat(fourcc) != settings.pixelFormat()){
+		for(quint32 candidate : fourccs){
+			if(toPixelFormat(candidate) == settings.pixelFormat()){
+				fourcc = candidate;
+				break;
+			}
+		}
+	}
+	format.fmt.pix.pixelformat = fourcc;
+	if(settings.resolution().isValid()){
+		format.fmt.pix.width = static_cast<quint32>(settings.resolution().width());
+		format.fmt.pix.height = static_cast<quint32>(settings.resolution().height());
+	}
+	format.fmt.pix.field = V4L2_FIELD_NONE;
+	format.fmt.pix.bytesperline = 0;
+	if(device->ioctl(VIDIOC_S_FMT, &format) < 0){
+		return this->fail(errno == EBUSY ? tr("%1 is busy, it is used by another application or camera view.").arg(devicePath)
+			: tr("%1 does not accept the format %2 %3x%4.").arg(devicePath).arg(fourccToString(fourcc)).arg(format.fmt.pix.width).arg(format.fmt.pix.height));
+	}
+	//the driver may have adjusted the request
+	this->fourcc = format.fmt.pix.pixelformat;
+	this->pixelFormat = toPixelFormat(format.fmt.pix.pixelformat);
+	this->frameSize = QSize(static_cast<int>(format.fmt.pix.width), static_cast<int>(format.fmt.pix.height));
+	this->bytesPerLine = static_cast<int>(format.fmt.pix.bytesperline);
+	if(!surfaceFormats.contains(this->pixelFormat) || this->frameSize.isEmpty()){
+		return this->fail(tr("%1 switched to the unsupported format %2.").arg(devicePath).arg(fourccToString(format.fmt.pix.pixelformat)));
+	}
+
+	//the frame rate can only be set by drivers that support it, the driver default is kept otherwise
+	qreal frameRate = 0.0;
+	v4l2_streamparm parameters;
+	memset(&parameters, 0, sizeof(parameters));
+	parameters.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if(device->ioctl(VIDIOC_G_PARM, &parameters) == 0 && (parameters.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)){
+		if(settings.maximumFrameRate() > 0.0){
+			parameters.parm.capture.timeperframe.numerator = 1000;
+			parameters.parm.capture.timeperframe.denominator = static_cast<quint32>(qRound(settings.maximumFrameRate()*1000.0));
+			device->ioctl(VIDIOC_S_PARM, &parameters);
+		}
+		const v4l2_fract& interval = parameters.parm.capture.timeperframe;
+		if(interval.numerator > 0){
+			frameRate = static_cast<qreal>(interval.denominator)/interval.numerator;
+		}
+	}
+
+	//buffers are memory mapped once, frames reference them directly
+	v4l2_requestbuffers request;
+	memset(&request, 0, sizeof(request));
+	request.count = BUFFER_COUNT;
+	request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	request.memory = V4L2_MEMORY_MMAP;
+	if(device->ioctl(VIDIOC_REQBUFS, &request) < 0 || request.count < static_cast<quint32>(MIN_QUEUED_BUFFERS)){
+		return this->fail(tr("%1 could not allocate capture buffers.").arg(devicePath));
+	}
+	QSharedPointer<V4l2Stream> newStream(new V4l2Stream(device));
+	bool dmabufExported = true;
+	for(int i = 0; i < static_cast<int>(request.count); i++){
+		v4l2_buffer buffer;
+		memset(&buffer, 0, sizeof(buffer));
+		buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buffer.memory = V4L2_MEMORY_MMAP;
+		buffer.index = static_cast<quint32>(i);
+		if(device->ioctl(VIDIOC_QUERYBUF, &buffer) < 0){
+			return this->fail(tr("%1 could not provide capture buffer %2.").arg(devicePath).arg(i));
+		}
+		uchar* data = static_cast<uchar*>(device->map(buffer.length, buffer.m.offset));
+		if(data == nullptr){
+			return this->fail(tr("Capture buffer %1 of %2 could not be mapped.").arg(i).arg(devicePath));
+		}
+		V4l2Stream::Buffer mapped = {data, buffer.length, -1};
+		v4l2_exportbuffer exported;
+		memset(&exported, 0, sizeof(exported));
+		exported.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		exported.index = static_cast<quint32>(i);
+		exported.flags = O_RDONLY | O_CLOEXEC;
+		if(device->ioctl(VIDIOC_EXPBUF, &exported) == 0){
+			mapped.dmabufFd = exported.fd;
+		} else {
+			dmabufExported = false;
+		}
+		newStream->buffers.append(mapped);
+	}
+	for(int i = 0; i < newStream->buffers.size(); i++){
+		if(!newStream->queue(i)){
+			return this->fail(tr("Capture buffer %1 of %2 could not be queued.").arg(i).arg(devicePath));
+		}
+	}
+
+	QVideoSurfaceFormat surfaceFormat(this->frameSize, this->pixelFormat);
+	surfaceFormat.setProperty("fourcc", this->fourcc);
+	if(!this->surface->start(surfaceFormat)){
+		return this->fail(tr("Format %1 %2x%3 of %4 can not be displayed.").arg(fourccToString(format.fmt.pix.pixelformat))
+			.arg(this->frameSize.width()).arg(this->frameSize.height()).arg(devicePath));
+	}
+	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if(device->ioctl(VIDIOC_STREAMON, &type) < 0){
+		this->surface->stop();
+		return this->fail(tr("Streaming of %1 could not be started.").arg(devicePath));
+	}
+	newStream->streaming = true;
+	this->stream = newStream;
+
+	this->settings = QCameraViewfinderSettings();
+	this->settings.setResolution(this->frameSize);
+	this->settings.setPixelFormat(this->pixelFormat);
+	this->settings.setMinimumFrameRate(frameRate);
+	this->settings.setMaximumFrameRate(frameRate);
+	{
+		QMutexLocker locker(&this->mutex);
+		this->statistics = V4l2Statistics();
+		this->statistics.driver = driverString(capability.driver, sizeof(capability.driver));
+		this->statistics.card = driverString(capability.card, sizeof(capability.card));
+		this->statistics.fourcc = fourccToString(format.fmt.pix.pixelformat);
+		this->statistics.resolution = this->frameSize;
+		this->statistics.frameRate = frameRate;
+		this->statistics.bufferCount = newStream->buffers.size();
+		this->statistics.dmabufExported = dmabufExported;
+		this->lastTimestamp = -1;
+		this->latencySum = 0.0;
+		this->latencyCount = 0;
+	}
+	this->stopping.storeRelease(0);
+	this->captureThread = new CaptureThread(this);
+	this->captureThread->start(QThread::HighPriority);
+	return true;
+#else
+	Q_UNUSED(device)
+	Q_UNUSED(settings)
+	emit error(tr("Native V4L2 capture of %1 is only available on linux.").arg(devicePath));
+	return false;
+#endif
+}
+
+void V4l2Source::close() {
+	if(!this->stream.isNull()){
+		//switching the stream off wakes up the capture thread, buffers released afterwards are not queued again
+		this->stopping.storeRelease(1);
+		{
+			QMutexLocker locker(&this->stream->mutex);
+			this->stream->streaming = false;
+#ifdef __linux__
+			int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			this->device->ioctl(VIDIOC_STREAMOFF, &type);
+#endif
+		}
+		this->captureThread->wait();
+		delete this->captureThread;
+		this->captureThread = nullptr;
+		{
+			QMutexLocker locker(&this->mutex);
+			this->latestFrame = QVideoFrame();
+			this->framePending = false;
+		}
+		this->stream.clear();
+		if(!this->surface.isNull()){
+			this->surface->stop();
+		}
+	}
+	//frames that are still held keep their mappings, the device itself is closed right away so it can be opened again
+	if(!this->device.isNull()){
+		this->device->close();
+		this->device.clear();
+	}
+	this->devicePath.clear();
+	this->settings = QCameraViewfinderSettings();
+	this->fourcc = 0;
+	this->pixelFormat = QVideoFrame::Format_Invalid;
+	this->frameSize = QSize();
+	this->bytesPerLine = 0;
+}
+
+bool V4l2Source::fail(const QString& message) {
+	emit error(message);
+	this->close();
+	return false;
+}
+
+V4l2Statistics V4l2Source::getStatistics() const {
+	QMutexLocker locker(&this->mutex);
+	return this->statistics;
+}
+
+void V4l2Source::capture() {
+#ifdef __linux__
+	QSharedPointer<V4l2Stream> stream = this->stream;
+	QSharedPointer<V4l2Device> device = this->device;
+	QString failure;
+	while(this->stopping.loadAcquire() == 0){
+		int ready = device->waitForFrame(WAIT_TIMEOUT_MS);
+		if(ready == 0){
+			continue;
+		}
+		v4l2_buffer buffer;
+		memset(&buffer, 0, sizeof(buffer));
+		buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buffer.memory = V4L2_MEMORY_MMAP;
+		if(ready < 0 || device->ioctl(VIDIOC_DQBUF, &buffer) < 0){
+			if(ready > 0 && errno == EAGAIN){
+				continue;
+			}
+			//switching the stream off in close() ends up here as well
+			if(this->stopping.loadAcquire() != 0){
+				break;
+			}
+			failure = tr("Capturing from %1 stopped, the device was disconnected or failed.").arg(this->devicePath);
+			break;
+		}
+		stream->queuedBuffers.deref();
+		int index = static_cast<int>(buffer.index);
+		//an index without a mapped buffer can not be queued again, it is skipped without VIDIOC_QBUF
+		if(index < 0 || index >= stream->buffers.size()){
+			continue;
+		}
+		//a buffer with corrupted data goes back to the driver right away
+		if(buffer.flags & V4L2_BUF_FLAG_ERROR){
+			stream->release(index);
+			continue;
+		}
+
+		//the driver buffer is passed on unless too few buffers are left with the driver
+		int size = buffer.bytesused > 0 ? static_cast<int>(buffer.bytesused) : static_cast<int>(stream->buffers.at(index).length);
+		bool copy = stream->queuedBuffers.loadAcquire() < MIN_QUEUED_BUFFERS;
+		QVideoFrame frame;
+		if(copy){
+			frame = QVideoFrame(size, this->frameSize, this->bytesPerLine, this->pixelFormat);
+			bool mapped = frame.map(QAbstractVideoBuffer::WriteOnly);
+			if(mapped){
+				memcpy(frame.bits(), stream->buffers.at(index).data, static_cast<size_t>(qMin(size, frame.mappedBytes())));
+				frame.unmap();
+			}
+			stream->release(index);
+			if(!mapped){
+				continue;
+			}
+		} else {
+			frame = QVideoFrame(new V4l2VideoBuffer(stream, index, size, this->bytesPerLine), this->frameSize, this->pixelFormat);
+		}
+		qint64 timestamp = static_cast<qint64>(buffer.timestamp.tv_sec)*1000000 + buffer.timestamp.tv_usec;
+		frame.setStartTime(timestamp);
+		frame.setMetaData("fourcc", this->fourcc);
+
+		QVideoFrame replacedFrame;
+		bool post = false;
+		{
+			QMutexLocker locker(&this->mutex);
+			V4l2Statistics& statistics = this->statistics;
+			if(statistics.framesCaptured > 0 && buffer.sequence > this->lastSequence + 1){
+				statistics.framesDroppedByDriver += buffer.sequence - this->lastSequence - 1;
+			}
+			this->lastSequence = buffer.sequence;
+			statistics.framesCaptured++;
+			statistics.framesCopied += copy ? 1 : 0;
+			statistics.monotonicTimestamps = (buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+			if(this->lastTimestamp >= 0 && timestamp > this->lastTimestamp){
+				double interval = static_cast<double>(timestamp - this->lastTimestamp);
+				statistics.averageIntervalUs = statistics.averageIntervalUs > 0.0 ? 0.9*statistics.averageIntervalUs + 0.1*interval : interval;
+			}
+			this->lastTimestamp = timestamp;
+			if(this->latestFrame.isValid()){
+				replacedFrame = this->latestFrame;
+				statistics.framesReplaced++;
+			}
+			this->latestFrame = frame;
+			post = !this->framePending;
+			this->framePending = true;
+		}
+		//the replaced frame is released here, outside of the lock, its buffer goes back to the driver
+		replacedFrame = QVideoFrame();
+		if(post){
+			QMetaObject::invokeMethod(this, [this]() {
+				this->presentLatest();
+			}, Qt::QueuedConnection);
+		}
+	}
+	//the source may have been closed and opened again until the gui thread gets to it, only this stream is closed
+	if(!failure.isEmpty()){
+		QWeakPointer<V4l2Stream> failedStream = stream;
+		QMetaObject::invokeMethod(this, [this, failure, failedStream]() {
+			QSharedPointer<V4l2Stream> current = failedStream.toStrongRef();
+			if(!current.isNull() && current == this->stream){
+				emit error(failure);
+				this->close();
+			}
+		}, Qt::QueuedConnection);
+	}
+#endif
+}
+
+void V4l2Source::presentLatest() {
+	QVideoFrame frame;
+	{
+		QMutexLocker locker(&this->mutex);
+		frame = this->latestFrame;
+		this->latestFrame = QVideoFrame();
+		this->framePending = false;
+	}
+	if(!frame.isValid() || this->stream.isNull() || this->surface.isNull()){
+		return;
+	}
+#ifdef __linux__
+	{
+		QMutexLocker locker(&this->mutex);
+		if(this->statistics.monotonicTimestamps){
+			qint64 latency = monotonicTimeUs() - frame.startTime();
+			this->latencySum += static_cast<double>(latency);
+			this->latencyCount++;
+			this->statistics.averageLatencyUs = this->latencySum/this->latencyCount;
+			this->statistics.maxLatencyUs = qMax(this->statistics.maxLatencyUs, latency);
+		}
+	}
+#endif
+	this->surface->present(frame);
+}
+
+QList<V4l2Control> V4l2Source::getControls() const {
+	QList<V4l2Control> controls;
+#ifdef __linux__
+	if(this->device.isNull() || !this->device->isOpen()){
+		return controls;
+	}
+	v4l2_queryctrl query;
+	memset(&query, 0, sizeof(query));
+	query.id = V4L2_CTRL_FLAG_NEXT_CTRL;
+	while(this->device->ioctl(VIDIOC_QUERYCTRL, &query) == 0){
+		quint32 id = query.id;
+		bool supportedType = query.type == V4L2_CTRL_TYPE_INTEGER || query.type == V4L2_CTRL_TYPE_BOOLEAN || query.type == V4L2_CTRL_TYPE_MENU
+			|| query.type == V4L2_CTRL_TYPE_INTEGER_MENU;
+		if(supportedType && !(query.flags & V4L2_CTRL_FLAG_DISABLED)){
+			V4l2Control control;
+			control.id = id;
+			control.name = driverString(query.name, sizeof(query.name));
+			control.type = query.type == V4L2_CTRL_TYPE_BOOLEAN ? V4l2Control::BOOLEAN : (query.type == V4L2_CTRL_TYPE_INTEGER ? V4l2Control::INTEGER : V4l2Control::MENU);
+			control.minimum = query.minimum;
+			control.maximum = query.maximum;
+			control.step = qMax(1, query.step);
+			control.defaultValue = query.default_value;
+			control.value = query.default_value;
+			control.enabled = !(query.flags & (V4L2_CTRL_FLAG_READ_ONLY | V4L2_CTRL_FLAG_INACTIVE | V4L2_CTRL_FLAG_GRABBED));
+			v4l2_control value;
+			memset(&value, 0, sizeof(value));
+			value.id = id;
+			if(this->device->ioctl(VIDIOC_G_CTRL, &value) == 0){
+				control.value = value.value;
+			}
+			//menus may have gaps, entries the driver does not know are skipped
+			for(qint32 i = query.minimum; control.type == V4l2Control::MENU && i <= query.maximum; i++){
+				v4l2_querymenu item;
+				memset(&item, 0, sizeof(item));
+				item.id = id;
+				item.index = static_cast<quint32>(i);
+				if(this->device->ioctl(VIDIOC_QUERYMENU, &item) == 0){
+					QString name = query.type == V4L2_CTRL_TYPE_INTEGER_MENU ? QString::number(item.value) : driverString(item.name, sizeof(item.name));
+					control.menuItems.append(qMakePair(i, name));
+				}
+			}
+			controls.append(control);
+		}
+		memset(&query, 0, sizeof(query));
+		query.id = id | V4L2_CTRL_FLAG_NEXT_CTRL;
+	}
+#endif
+	return controls;
+}
+
+bool V4l2Source::setControl(quint32 id, qint32 value) {
+#ifdef __linux__
+	if(this->device.isNull() || !this->device->isOpen()){
+		return false;
+	}
+	v4l2_control control;
+	memset(&control, 0, sizeof(control));
+	control.id = id;
+	control.value = value;
+	return this->device->ioctl(VIDIOC_S_CTRL, &control) == 0;
+#else
+	Q_UNUSED(id)
+	Q_UNUSED(value)
+	return false;
+#endif
+}
+
+QVideoFrame::PixelFormat V4l2Source::toPixelFormat(quint32 fourcc) {
+#ifdef __linux__
+	switch(fourcc){
+		case V4L2_PIX_FMT_YUYV: return QVideoFrame::Format_YUYV;
+		case V4L2_PIX_FMT_UYVY: return QVideoFrame::Format_UYVY;
+		case V4L2_PIX_FMT_NV12: return QVideoFrame::Format_NV12;
+		case V4L2_PIX_FMT_NV21: return QVideoFrame::Format_NV21;
+		case V4L2_PIX_FMT_YUV420: return QVideoFrame::Format_YUV420P;
+		case V4L2_PIX_FMT_YVU420: return QVideoFrame::Format_YV12;
+		case V4L2_PIX_FMT_GREY: return QVideoFrame::Format_Y8;
+		//10 and 12 bit samples are stored in the low bits of 16 bit samples, window/level finds their range
+		case V4L2_PIX_FMT_Y16:
+		case V4L2_PIX_FMT_Y10:
+		case V4L2_PIX_FMT_Y12: return QVideoFrame::Format_Y16;
+		//b, g, r, x in memory, the byte order of Format_RGB32 on little endian systems
+		case V4L2_PIX_FMT_BGR32:
+		case V4L2_PIX_FMT_XBGR32: return QVideoFrame::Format_RGB32;
+		case V4L2_PIX_FMT_ABGR32: return QVideoFrame::Format_ARGB32;
+		case V4L2_PIX_FMT_RGB24: return QVideoFrame::Format_RGB24;
+		case V4L2_PIX_FMT_BGR24: return QVideoFrame::Format_BGR24;
+		//Bayer mosaics, the pattern and the bit depth are given by the fourcc (see bayerLayout())
+		case V4L2_PIX_FMT_SBGGR8:
+		case V4L2_PIX_FMT_SGBRG8:
+		case V4L2_PIX_FMT_SGRBG8:
+		case V4L2_PIX_FMT_SRGGB8:
+		case V4L2_PIX_FMT_SBGGR10:
+		case V4L2_PIX_FMT_SGBRG10:
+		case V4L2_PIX_FMT_SGRBG10:
+		case V4L2_PIX_FMT_SRGGB10:
+		case V4L2_PIX_FMT_SBGGR12:
+		case V4L2_PIX_FMT_SGBRG12:
+		case V4L2_PIX_FMT_SGRBG12:
+		case V4L2_PIX_FMT_SRGGB12:
+		case V4L2_PIX_FMT_SBGGR16:
+		case V4L2_PIX_FMT_SGBRG16:
+		case V4L2_PIX_FMT_SGRBG16:
+		case V4L2_PIX_FMT_SRGGB16: return QVideoFrame::Format_CameraRaw;
+		default: return QVideoFrame::Format_Invalid;
+	}
+#else
+	Q_UNUSED(fourcc)
+	return QVideoFrame::Format_Invalid;
+#endif
+}
+
+bool V4l2Source::bayerLayout(quint32 fourcc, int* pattern, int* bitDepth) {
+#ifdef __linux__
+	//pattern in the order of Demosaic::BayerPattern: RGGB, BGGR, GRBG, GBRG
+	static const quint32 layouts[4][4] = {
+		{V4L2_PIX_FMT_SRGGB8, V4L2_PIX_FMT_SRGGB10, V4L2_PIX_FMT_SRGGB12, V4L2_PIX_FMT_SRGGB16},
+		{V4L2_PIX_FMT_SBGGR8, V4L2_PIX_FMT_SBGGR10, V4L2_PIX_FMT_SBGGR12, V4L2_PIX_FMT_SBGGR16},
+		{V4L2_PIX_FMT_SGRBG8, V4L2_PIX_FMT_SGRBG10, V4L2_PIX_FMT_SGRBG12, V4L2_PIX_FMT_SGRBG16},
+		{V4L2_PIX_FMT_SGBRG8, V4L2_PIX_FMT_SGBRG10, V4L2_PIX_FMT_SGBRG12, V4L2_PIX_FMT_SGBRG16}
+	};
+	static const int bitDepths[4] = {8, 10, 12, 16};
+	for(int i = 0; i < 4; i++){
+		for(int j = 0; j < 4; j++){
+			if(layouts[i][j] == fourcc){
+				*pattern = i;
+				*bitDepth = bitDepths[j];
+				return true;
+			}
+		}
+	}
+#else
+	Q_UNUSED(fourcc)
+	Q_UNUSED(pattern)
+	Q_UNUSED(bitDepth)
+#endif
+	return false;
+}
+
+QString V4l2Source::fourccToString(quint32 fourcc) {
+	QString text;
+	for(int i = 0; i < 4; i++){
+		char c = static_cast<char>((fourcc >> (8*i)) & 0xff);
+		text.append(c >= 32 && c < 127 ? QChar(c) : QChar('?'));
+	}
+	return text.trimmed();
+}
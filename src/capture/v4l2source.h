@@ -0,0 +1,141 @@
+#ifndef V4L2SOURCE_H
+#define V4L2SOURCE_H
+
+#include <QObject>
+#include <QAbstractVideoSurface>
+#include <QCameraViewfinderSettings>
+#include <QVideoFrame>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QList>
+#include <QPair>
+#include "v4l2device.h"
+
+
+//a control of the driver (brightness, exposure, gain, white balance, ...), integer, boolean and menu controls are supported
+struct V4l2Control {
+	enum Type {
+		INTEGER,
+		BOOLEAN,
+		MENU
+	};
+
+	quint32 id = 0;
+	QString name;
+	Type type = INTEGER;
+	qint32 minimum = 0;
+	qint32 maximum = 0;
+	qint32 step = 1;
+	qint32 defaultValue = 0;
+	qint32 value = 0;
+	bool enabled = true; //false while read-only or inactive, e.g. the exposure time in automatic exposure mode
+	QList<QPair<qint32, QString>> menuItems; //value and name of every menu entry
+};
+
+struct V4l2Statistics {
+	QString driver;
+	QString card;
+	QString fourcc;
+	QSize resolution;
+	qreal frameRate = 0.0; //as configured in the driver, 0 if the driver does not report it
+	int bufferCount = 0;
+	bool dmabufExported = false;
+	bool monotonicTimestamps = false;
+	quint64 framesCaptured = 0;
+	quint64 framesDroppedByDriver = 0; //gaps in the sequence numbers of the driver
+	quint64 framesReplaced = 0; //not displayed because a newer frame arrived before the gui thread took it
+	quint64 framesCopied = 0; //copied because too few buffers were left with the driver
+	double averageIntervalUs = 0.0; //between the driver timestamps of consecutive frames
+	double averageLatencyUs = 0.0; //from the driver timestamp until the frame is passed to the surface
+	qint64 maxLatencyUs = 0;
+};
+
+class V4l2Stream;
+
+//native capture of V4L2 devices, bypassing the GStreamer camerabin of Qt Multimedia. the driver fills memory mapped buffers (streaming I/O),
+//a capture thread dequeues them and hands them to the surface (usually the FrameTapSurface of a camera view) on the gui thread without copying:
+//every frame references its driver buffer, which is queued again as soon as the last copy of the frame is released. if the stages hold on to
+//so many frames that fewer than MIN_QUEUED_BUFFERS buffers are left with the driver, frames are copied instead, so the driver never runs dry.
+//only the latest frame waits for the gui thread, older ones are released right away. frames carry the timestamp of the driver (us, usually
+//CLOCK_MONOTONIC) as start time. buffers are exported as DMABUF where the driver supports it, the file descriptor is available as handle() of
+//the frames while they are held (handleType() stays NoHandle, the frames are mapped memory for the surface). Qt has a single pixel format for
+//all Bayer mosaics (Format_CameraRaw), so the fourcc of the driver is kept as meta data "fourcc" of every frame and as property "fourcc" of the
+//surface format. only single-planar capture devices with uncompressed formats the surface accepts are supported, linux only
+class V4l2Source : public QObject
+{
+	Q_OBJECT
+public:
+	explicit V4l2Source(QAbstractVideoSurface* surface, QObject *parent = nullptr);
+	~V4l2Source();
+
+	//a null resolution, pixel format or frame rate in settings keeps the current setting of the driver
+	bool open(const QString& devicePath, const QCameraViewfinderSettings& settings = QCameraViewfinderSettings());
+	//same on the given device, e.g. a simulated one
+	bool open(QSharedPointer<V4l2Device> device, const QString& devicePath, const QCameraViewfinderSettings& settings);
+	void close();
+	bool isOpen() const {return !this->stream.isNull();}
+	QString getDevicePath() const {return this->devicePath;}
+	//the mode negotiated with the driver
+	QCameraViewfinderSettings getSettings() const {return this->settings;}
+	//the fourcc negotiated with the driver, 0 while closed
+	quint32 getFourcc() const {return this->fourcc;}
+	V4l2Statistics getStatistics() const;
+
+	//queried from the driver on every call, so the values and the enabled states are current
+	QList<V4l2Control> getControls() const;
+	bool setControl(quint32 id, qint32 value);
+
+	static bool isSupported();
+	static QVideoFrame::PixelFormat toPixelFormat(quint32 fourcc);
+	static QString fourccToString(quint32 fourcc);
+	//Bayer pattern (Demosaic::BayerPattern) and significant bits of the samples of a raw fourcc. returns false for other formats
+	static bool bayerLayout(quint32 fourcc, int* pattern, int* bitDepth);
+
+	static const int BUFFER_COUNT = 6;
+	static const int MIN_QUEUED_BUFFERS = 2;
+	static const int WAIT_TIMEOUT_MS = 100;
+
+private:
+	class CaptureThread : public QThread {
+	public:
+		explicit CaptureThread(V4l2Source* source) : source(source) {}
+	protected:
+		void run() override {this->source->capture();}
+	private:
+		V4l2Source* source;
+	};
+
+	QPointer<QAbstractVideoSurface> surface;
+	QSharedPointer<V4l2Device> device;
+	QSharedPointer<V4l2Stream> stream;
+	CaptureThread* captureThread;
+	QAtomicInt stopping;
+	QString devicePath;
+	QCameraViewfinderSettings settings;
+	quint32 fourcc;
+	QVideoFrame::PixelFormat pixelFormat;
+	QSize frameSize;
+	int bytesPerLine;
+
+	//shared with the capture thread
+	mutable QMutex mutex;
+	QVideoFrame latestFrame;
+	bool framePending;
+	V4l2Statistics statistics;
+	quint32 lastSequence;
+	qint64 lastTimestamp;
+	double latencySum;
+	quint64 latencyCount;
+
+	bool fail(const QString& message);
+	void capture();
+	void presentLatest();
+
+signals:
+	void error(QString);
+};
+
+#endif //V4L2SOURCE_H
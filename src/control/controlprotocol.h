@@ -0,0 +1,129 @@
+#ifndef CONTROLPROTOCOL_H
+#define CONTROLPROTOCOL_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QDataStream>
+#include <QString>
+
+
+//binary protocol of the local socket control API. all values are little endian.
+//
+//every message starts with a 12 byte header: u32 payload size, u32 request id, u8 command, u8 view index (request) or status (response),
+//u16 reserved (0). requests can be pipelined, the server answers every request with exactly one response with the same id and command,
+//responses are sent in request order.
+//strings are u16 byte count + utf-8, coordinates are f64.
+//
+//command         request payload                                 response payload
+//PING            any bytes                                       the same bytes
+//GET_INFO        -                                               u16 protocol version, u8 view count, string camera device, u16 frame width,
+//                                                                u16 frame height, u8 flags (1 = camera active, 2 = playback, 4 = recording),
+//                                                                u8 overlay count, overlay count x string overlay name
+//TAKE_SNAPSHOT   u8 mode (SnapshotMode)                          string file path the snapshot is saved to
+//GET_OVERLAY     string overlay name                             u8 visible, f64 x, f64 y, u8 anchor count, anchor count x (f64 x, f64 y)
+//SET_OVERLAY     string overlay name + GET_OVERLAY response      -
+//SET_CAMERA      string device name (empty: default camera)      -
+//GET_FRAME       u16 max width, u16 max height, u8 FrameFormat   u16 width, u16 height, u8 FrameFormat, i64 timestamp (us), pixel data
+//                                                                without line padding
+//GET_ROI_STATISTICS string overlay name                          u32 pixel count, f64 mean, f64 standard deviation, u8 min, u8 max,
+//                                                                i64 timestamp (ms since epoch), 256 x u32 histogram of the luma.
+//                                                                NOT_AVAILABLE if the statistics are not enabled or not measured yet
+//overlay coordinates are the ones stored in the settings: position of the overlay and anchors relative to it in video item coordinates
+namespace ControlProtocol
+{
+	const char SERVER_NAME[] = "octproz_camera_control";
+	const quint16 VERSION = 1;
+	const int HEADER_SIZE = 12;
+	const quint32 MAX_PAYLOAD_SIZE = 16*1024*1024;
+	const int FRAME_TIMEOUT_MS = 2000;
+
+	enum Command {
+		PING = 0,
+		GET_INFO = 1,
+		TAKE_SNAPSHOT = 2,
+		GET_OVERLAY = 3,
+		SET_OVERLAY = 4,
+		SET_CAMERA = 5,
+		GET_FRAME = 6,
+		GET_ROI_STATISTICS = 7
+	};
+
+	enum Status {
+		OK = 0,
+		UNKNOWN_COMMAND = 1,
+		INVALID_REQUEST = 2,
+		INVALID_VIEW = 3,
+		NOT_FOUND = 4,
+		NOT_AVAILABLE = 5
+	};
+
+	enum SnapshotMode {
+		SNAPSHOT_CAMERA = 0,
+		SNAPSHOT_DISPLAYED = 1
+	};
+
+	enum FrameFormat {
+		FRAME_GRAY8 = 0,
+		FRAME_RGB888 = 1
+	};
+
+	enum InfoFlags {
+		CAMERA_ACTIVE = 1,
+		PLAYBACK_ACTIVE = 2,
+		RECORDING_ACTIVE = 4
+	};
+
+	struct MessageHeader {
+		quint32 payloadSize = 0;
+		quint32 id = 0;
+		quint8 command = 0;
+		quint8 viewOrStatus = 0;
+	};
+
+	inline void writeHeader(QByteArray* buffer, const MessageHeader& header) {
+		uchar bytes[HEADER_SIZE] = {};
+		for(int i = 0; i < 4; i++){
+			bytes[i] = static_cast<uchar>(header.payloadSize >> (8*i));
+			bytes[4 + i] = static_cast<uchar>(header.id >> (8*i));
+		}
+		bytes[8] = header.command;
+		bytes[9] = header.viewOrStatus;
+		buffer->append(reinterpret_cast<const char*>(bytes), HEADER_SIZE);
+	}
+
+	inline MessageHeader readHeader(const char* data) {
+		const uchar* bytes = reinterpret_cast<const uchar*>(data);
+		MessageHeader header;
+		for(int i = 0; i < 4; i++){
+			header.payloadSize |= static_cast<quint32>(bytes[i]) << (8*i);
+			header.id |= static_cast<quint32>(bytes[4 + i]) << (8*i);
+		}
+		header.command = bytes[8];
+		header.viewOrStatus = bytes[9];
+		return header;
+	}
+
+	inline void initStream(QDataStream& stream) {
+		stream.setByteOrder(QDataStream::LittleEndian);
+		stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+	}
+
+	inline void writeString(QDataStream& stream, const QString& string) {
+		QByteArray utf8 = string.toUtf8().left(0xFFFF);
+		stream << static_cast<quint16>(utf8.size());
+		stream.writeRawData(utf8.constData(), utf8.size());
+	}
+
+	inline bool readString(QDataStream& stream, QString* string) {
+		quint16 size = 0;
+		stream >> size;
+		QByteArray utf8(size, Qt::Uninitialized);
+		if(stream.readRawData(utf8.data(), size) != size){
+			return false;
+		}
+		*string = QString::fromUtf8(utf8);
+		return stream.status() == QDataStream::Ok;
+	}
+}
+
+#endif //CONTROLPROTOCOL_H
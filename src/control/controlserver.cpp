@@ -0,0 +1,332 @@
+#include "controlserver.h"
+#include "cameraextensionform.h"
+#include "cameraviewwidget.h"
+#include <QCameraInfo>
+#include <QPointer>
+#include <QTimer>
+
+
+ControlServer::ControlServer(CameraExtensionForm* form, QObject *parent)
+	: QObject(parent),
+	  form(form),
+	  server(new QLocalServer(this))
+{
+	//only processes of the same user may connect
+	this->server->setSocketOptions(QLocalServer::UserAccessOption);
+	connect(this->server, &QLocalServer::newConnection, this, &ControlServer::onNewConnection);
+}
+
+ControlServer::~ControlServer() {
+	this->stop();
+}
+
+bool ControlServer::start(const QString& name) {
+	if(this->server->isListening()){
+		return true;
+	}
+	if(!this->server->listen(name) && this->server->serverError() == QAbstractSocket::AddressInUseError){
+		//the socket file may be left over from a crashed instance. it is only removed if nobody answers on it
+		QLocalSocket probe;
+		probe.connectToServer(name);
+		if(probe.waitForConnected(200)){
+			emit error(tr("Control API not available, ") + name + tr(" is used by another instance."));
+			return false;
+		}
+		QLocalServer::removeServer(name);
+		this->server->listen(name);
+	}
+	if(!this->server->isListening()){
+		emit error(tr("Control API not available: ") + this->server->errorString());
+		return false;
+	}
+	emit info(tr("Control API listening on ") + this->server->fullServerName());
+	return true;
+}
+
+void ControlServer::stop() {
+	this->server->close();
+	QList<QLocalSocket*> sockets = this->connections.keys();
+	this->connections.clear();
+	for(QLocalSocket* socket : sockets){
+		disconnect(socket, nullptr, this, nullptr);
+		socket->abort();
+		socket->deleteLater();
+	}
+}
+
+void ControlServer::onNewConnection() {
+	while(this->server->hasPendingConnections()){
+		QLocalSocket* socket = this->server->nextPendingConnection();
+		this->connections.insert(socket, Connection());
+		connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { this->readRequests(socket); });
+		connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+			this->connections.remove(socket);
+			socket->deleteLater();
+		});
+	}
+}
+
+void ControlServer::readRequests(QLocalSocket* socket) {
+	if(!this->connections.contains(socket)){
+		return;
+	}
+	QByteArray& input = this->connections[socket].input;
+	input.append(socket->readAll());
+
+	//every complete request is handled right away, the responses are collected and written at once
+	int offset = 0;
+	while(input.size() - offset >= ControlProtocol::HEADER_SIZE){
+		ControlProtocol::MessageHeader header = ControlProtocol::readHeader(input.constData() + offset);
+		if(header.payloadSize > ControlProtocol::MAX_PAYLOAD_SIZE){
+			emit error(tr("Control API: request too large, closing connection"));
+			socket->abort();
+			return;
+		}
+		int messageSize = ControlProtocol::HEADER_SIZE + static_cast<int>(header.payloadSize);
+		if(input.size() - offset < messageSize){
+			break;
+		}
+		QByteArray payload = input.mid(offset + ControlProtocol::HEADER_SIZE, static_cast<int>(header.payloadSize));
+		offset += messageSize;
+
+		QSharedPointer<Response> response(new Response());
+		response->header.id = header.id;
+		response->header.command = header.command;
+		this->connections[socket].pending.append(response);
+		this->handleRequest(socket, header, payload, response);
+	}
+	this->connections[socket].input.remove(0, offset);
+	this->writeResponses(socket);
+}
+
+void ControlServer::handleRequest(QLocalSocket* socket, const ControlProtocol::MessageHeader& header, const QByteArray& payload, QSharedPointer<Response> response) {
+	QDataStream in(payload);
+	QDataStream out(&response->payload, QIODevice::WriteOnly);
+	ControlProtocol::initStream(in);
+	ControlProtocol::initStream(out);
+
+	CameraViewWidget* view = this->form->getView(header.viewOrStatus);
+	int status = ControlProtocol::OK;
+	if(header.command == ControlProtocol::PING){
+		response->payload = payload;
+	} else if(header.command > ControlProtocol::GET_ROI_STATISTICS){
+		status = ControlProtocol::UNKNOWN_COMMAND;
+	} else if(view == nullptr){
+		status = ControlProtocol::INVALID_VIEW;
+	} else {
+		switch(header.command){
+		case ControlProtocol::GET_INFO: status = this->getInfo(view, out); break;
+		case ControlProtocol::TAKE_SNAPSHOT: status = this->takeSnapshot(view, in, out); break;
+		case ControlProtocol::GET_OVERLAY: status = this->getOverlay(view, in, out); break;
+		case ControlProtocol::SET_OVERLAY: status = this->setOverlay(view, in); break;
+		case ControlProtocol::SET_CAMERA: status = this->setCamera(view, in); break;
+		case ControlProtocol::GET_FRAME: status = this->getFrame(socket, view, in, response); break;
+		case ControlProtocol::GET_ROI_STATISTICS: status = this->getRoiStatistics(view, in, out); break;
+		}
+	}
+	if(status == PENDING){
+		return;
+	}
+	if(status != ControlProtocol::OK){
+		response->payload.clear();
+	}
+	response->header.viewOrStatus = static_cast<quint8>(status);
+	response->ready = true;
+}
+
+void ControlServer::writeResponses(QLocalSocket* socket) {
+	if(!this->connections.contains(socket)){
+		return;
+	}
+	//responses are sent in request order, a pending response holds back all later ones
+	QList<QSharedPointer<Response>>& pending = this->connections[socket].pending;
+	QByteArray output;
+	while(!pending.isEmpty() && pending.first()->ready){
+		QSharedPointer<Response> response = pending.takeFirst();
+		response->header.payloadSize = static_cast<quint32>(response->payload.size());
+		ControlProtocol::writeHeader(&output, response->header);
+		output.append(response->payload);
+	}
+	if(!output.isEmpty()){
+		socket->write(output);
+	}
+}
+
+int ControlServer::getInfo(CameraViewWidget* view, QDataStream& out) {
+	QSize frameSize = view->getFrameSize();
+	quint8 flags = 0;
+	flags |= view->isCameraActive() ? ControlProtocol::CAMERA_ACTIVE : 0;
+	flags |= view->isPlaybackActive() ? ControlProtocol::PLAYBACK_ACTIVE : 0;
+	flags |= view->isRecording() ? ControlProtocol::RECORDING_ACTIVE : 0;
+	out << ControlProtocol::VERSION << static_cast<quint8>(this->form->getViewCount());
+	ControlProtocol::writeString(out, view->getCurrentCamera().deviceName());
+	out << static_cast<quint16>(frameSize.width()) << static_cast<quint16>(frameSize.height()) << flags;
+	const auto& overlays = view->getOverlays();
+	out << static_cast<quint8>(overlays.size());
+	for(const auto& overlay : overlays){
+		ControlProtocol::writeString(out, overlay.second);
+	}
+	return ControlProtocol::OK;
+}
+
+int ControlServer::takeSnapshot(CameraViewWidget* view, QDataStream& in, QDataStream& out) {
+	quint8 mode = 0;
+	in >> mode;
+	if(in.status() != QDataStream::Ok || mode > ControlProtocol::SNAPSHOT_DISPLAYED){
+		return ControlProtocol::INVALID_REQUEST;
+	}
+	QString filePath = mode == ControlProtocol::SNAPSHOT_DISPLAYED ? view->takeDisplayedSnapshot() : view->takeSnapshot();
+	if(filePath.isEmpty()){
+		return ControlProtocol::NOT_AVAILABLE;
+	}
+	ControlProtocol::writeString(out, filePath);
+	return ControlProtocol::OK;
+}
+
+int ControlServer::getOverlay(CameraViewWidget* view, QDataStream& in, QDataStream& out) {
+	QString name;
+	if(!ControlProtocol::readString(in, &name)){
+		return ControlProtocol::INVALID_REQUEST;
+	}
+	OverlayItem* overlay = view->getOverlay(name);
+	if(overlay == nullptr){
+		return ControlProtocol::NOT_FOUND;
+	}
+	QVariantMap state = overlay->saveState();
+	const QVariantList anchors = state.value("anchors").toList();
+	out << static_cast<quint8>(state.value("isVisible").toBool()) << state.value("x_position").toDouble() << state.value("y_position").toDouble();
+	out << static_cast<quint8>(anchors.size());
+	for(const QVariant& anchor : anchors){
+		QVariantMap anchorData = anchor.toMap();
+		out << anchorData.value("x").toDouble() << anchorData.value("y").toDouble();
+	}
+	return ControlProtocol::OK;
+}
+
+int ControlServer::setOverlay(CameraViewWidget* view, QDataStream& in) {
+	QString name;
+	quint8 visible = 0;
+	double x = 0.0;
+	double y = 0.0;
+	quint8 anchorCount = 0;
+	if(!ControlProtocol::readString(in, &name)){
+		return ControlProtocol::INVALID_REQUEST;
+	}
+	in >> visible >> x >> y >> anchorCount;
+	QVariantList anchors;
+	for(int i = 0; i < anchorCount; i++){
+		double anchorX = 0.0;
+		double anchorY = 0.0;
+		in >> anchorX >> anchorY;
+		QVariantMap anchorData;
+		anchorData["x"] = anchorX;
+		anchorData["y"] = anchorY;
+		anchors.append(anchorData);
+	}
+	if(in.status() != QDataStream::Ok){
+		return ControlProtocol::INVALID_REQUEST;
+	}
+	if(view->getOverlay(name) == nullptr){
+		return ControlProtocol::NOT_FOUND;
+	}
+	QVariantMap state;
+	state["anchors"] = anchors;
+	state["isVisible"] = visible != 0;
+	state["x_position"] = x;
+	state["y_position"] = y;
+	return view->setOverlayState(name, state) ? ControlProtocol::OK : ControlProtocol::INVALID_REQUEST;
+}
+
+int ControlServer::setCamera(CameraViewWidget* view, QDataStream& in) {
+	QString deviceName;
+	if(!ControlProtocol::readString(in, &deviceName)){
+		return ControlProtocol::INVALID_REQUEST;
+	}
+	QCameraInfo cameraInfo = deviceName.isEmpty() ? QCameraInfo::defaultCamera() : QCameraInfo();
+	if(!deviceName.isEmpty()){
+		const QList<QCameraInfo> cameras = QCameraInfo::availableCameras();
+		for(const QCameraInfo& camera : cameras){
+			if(camera.deviceName() == deviceName){
+				cameraInfo = camera;
+				break;
+			}
+		}
+	}
+	if(cameraInfo.isNull()){
+		return ControlProtocol::NOT_FOUND;
+	}
+	//same as selecting the camera in the combo box of the view, a hidden view opens the camera when it is shown
+	if(view->isVisible()){
+		view->openCamera(cameraInfo);
+	} else {
+		view->setCamera(cameraInfo);
+	}
+	return ControlProtocol::OK;
+}
+
+int ControlServer::getFrame(QLocalSocket* socket, CameraViewWidget* view, QDataStream& in, QSharedPointer<Response> response) {
+	quint16 maxWidth = 0;
+	quint16 maxHeight = 0;
+	quint8 format = 0;
+	in >> maxWidth >> maxHeight >> format;
+	if(in.status() != QDataStream::Ok || maxWidth == 0 || maxHeight == 0 || format > ControlProtocol::FRAME_RGB888){
+		return ControlProtocol::INVALID_REQUEST;
+	}
+	if(!view->hasActiveSource()){
+		return ControlProtocol::NOT_AVAILABLE;
+	}
+
+	//answered with the next frame of the view. if no frame arrives in time, the request fails instead of blocking all later responses
+	QPointer<ControlServer> self(this);
+	QPointer<QLocalSocket> target(socket);
+	view->getFrameGrabber()->requestFrame(QSize(maxWidth, maxHeight), format == ControlProtocol::FRAME_GRAY8, [self, target, response, format](const QImage& image, qint64 timestamp) {
+		if(self.isNull() || response->ready){
+			return;
+		}
+		if(image.isNull()){
+			response->header.viewOrStatus = ControlProtocol::NOT_AVAILABLE;
+		} else {
+			QDataStream out(&response->payload, QIODevice::WriteOnly);
+			ControlProtocol::initStream(out);
+			out << static_cast<quint16>(image.width()) << static_cast<quint16>(image.height()) << format << timestamp;
+			int lineBytes = image.width()*(format == ControlProtocol::FRAME_GRAY8 ? 1 : 3);
+			for(int y = 0; y < image.height(); y++){
+				out.writeRawData(reinterpret_cast<const char*>(image.constScanLine(y)), lineBytes);
+			}
+			response->header.viewOrStatus = ControlProtocol::OK;
+		}
+		response->ready = true;
+		if(!target.isNull()){
+			self->writeResponses(target);
+		}
+	});
+	QTimer::singleShot(ControlProtocol::FRAME_TIMEOUT_MS, socket, [this, target, response]() {
+		if(response->ready || target.isNull()){
+			return;
+		}
+		response->header.viewOrStatus = ControlProtocol::NOT_AVAILABLE;
+		response->ready = true;
+		this->writeResponses(target);
+	});
+	return PENDING;
+}
+
+int ControlServer::getRoiStatistics(CameraViewWidget* view, QDataStream& in, QDataStream& out) {
+	QString name;
+	if(!ControlProtocol::readString(in, &name)){
+		return ControlProtocol::INVALID_REQUEST;
+	}
+	if(view->getOverlay(name) == nullptr){
+		return ControlProtocol::NOT_FOUND;
+	}
+	RoiStatistics statistics = view->getOverlayAnalysis()->getRoiStatistics().value(name);
+	if(!view->getOverlayAnalysis()->isRoiStatisticsEnabled() || !statistics.valid){
+		return ControlProtocol::NOT_AVAILABLE;
+	}
+	out << static_cast<quint32>(statistics.pixelCount) << statistics.mean << statistics.stdDev;
+	out << static_cast<quint8>(statistics.min) << static_cast<quint8>(statistics.max) << statistics.timestamp;
+	for(quint32 count : statistics.histogram){
+		out << count;
+	}
+	return ControlProtocol::OK;
+}
@@ -0,0 +1,68 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSharedPointer>
+#include <QHash>
+#include <QList>
+#include "controlprotocol.h"
+
+class CameraExtensionForm;
+class CameraViewWidget;
+
+
+//local socket server of the control API (see controlprotocol.h), used to automate snapshots, overlay placement and camera selection from scripts.
+//requests are handled on the gui thread in the order they arrive. all requests that are already received are processed in one go and their
+//responses are written with a single write, so pipelined batches cost one round trip. responses that need a frame (GET_FRAME) are completed
+//asynchronously, later responses wait for them to keep the order
+class ControlServer : public QObject
+{
+	Q_OBJECT
+public:
+	explicit ControlServer(CameraExtensionForm* form, QObject *parent = nullptr);
+	~ControlServer();
+
+	bool start(const QString& name = ControlProtocol::SERVER_NAME);
+	void stop();
+	bool isListening() const {return this->server->isListening();}
+
+private:
+	struct Response {
+		ControlProtocol::MessageHeader header;
+		QByteArray payload;
+		bool ready = false;
+	};
+	struct Connection {
+		QByteArray input;
+		QList<QSharedPointer<Response>> pending;
+	};
+
+	CameraExtensionForm* form;
+	QLocalServer* server;
+	QHash<QLocalSocket*, Connection> connections;
+
+	void readRequests(QLocalSocket* socket);
+	void handleRequest(QLocalSocket* socket, const ControlProtocol::MessageHeader& header, const QByteArray& payload, QSharedPointer<Response> response);
+	void writeResponses(QLocalSocket* socket);
+
+	//return a ControlProtocol::Status, or PENDING if the response is completed later
+	static const int PENDING = -1;
+	int getInfo(CameraViewWidget* view, QDataStream& out);
+	int takeSnapshot(CameraViewWidget* view, QDataStream& in, QDataStream& out);
+	int getOverlay(CameraViewWidget* view, QDataStream& in, QDataStream& out);
+	int setOverlay(CameraViewWidget* view, QDataStream& in);
+	int setCamera(CameraViewWidget* view, QDataStream& in);
+	int getFrame(QLocalSocket* socket, CameraViewWidget* view, QDataStream& in, QSharedPointer<Response> response);
+	int getRoiStatistics(CameraViewWidget* view, QDataStream& in, QDataStream& out);
+
+private slots:
+	void onNewConnection();
+
+signals:
+	void info(QString);
+	void error(QString);
+};
+
+#endif //CONTROLSERVER_H
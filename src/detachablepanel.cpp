@@ -0,0 +1,53 @@
+#include "detachablepanel.h"
+#include <QCloseEvent>
+#include <QStyle>
+
+
+DetachablePanel::DetachablePanel(QWidget *parent)
+	: QWidget(parent),
+	floatButton(new QToolButton(this))
+{
+	this->floatButton->setAutoRaise(true);
+	this->floatButton->setIcon(this->style()->standardIcon(QStyle::SP_TitleBarNormalButton));
+	this->floatButton->setToolTip(tr("Detach/attach"));
+	connect(this->floatButton, &QToolButton::clicked, this, [this]() {
+		this->setFloating(!this->isFloating());
+	});
+}
+
+DetachablePanel::~DetachablePanel() {
+}
+
+void DetachablePanel::setFloating(bool floating) {
+	if(floating == this->isFloating()){
+		return;
+	}
+	QPoint position = this->mapToGlobal(QPoint(0, 0));
+	QSize size = this->size();
+	this->setWindowFlags(floating ? Qt::Tool : Qt::Widget);
+	if(floating){
+		this->move(position);
+		this->resize(size);
+	}
+	this->show();
+}
+
+QRect DetachablePanel::titleRect() const {
+	return QRect(4, 0, this->width() - this->floatButton->width() - 8, TITLE_HEIGHT);
+}
+
+void DetachablePanel::resizeEvent(QResizeEvent* event) {
+	QWidget::resizeEvent(event);
+	QSize buttonSize = this->floatButton->sizeHint();
+	this->floatButton->setGeometry(this->width() - buttonSize.width() - 2, 1, buttonSize.width(), qMin(buttonSize.height(), TITLE_HEIGHT - 2));
+}
+
+void DetachablePanel::closeEvent(QCloseEvent* event) {
+	//the panel is hidden with the option of the camera view that shows it, closing the tool window only docks it
+	if(this->isFloating()){
+		event->ignore();
+		this->setFloating(false);
+		return;
+	}
+	QWidget::closeEvent(event);
+}
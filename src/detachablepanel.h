@@ -0,0 +1,35 @@
+#ifndef DETACHABLEPANEL_H
+#define DETACHABLEPANEL_H
+
+#include <QWidget>
+#include <QToolButton>
+
+
+//base of the live plots below a camera view (line profile, polar unwrap). the panel sits in the layout of the camera view panel and can
+//be detached into a tool window with the button in its top right corner, closing the tool window docks it again.
+//a widget that is a window is skipped by the layout of its parent, so the camera view gets the space back while the panel is detached
+class DetachablePanel : public QWidget {
+	Q_OBJECT
+
+public:
+	explicit DetachablePanel(QWidget *parent = nullptr);
+	~DetachablePanel();
+
+	bool isFloating() const {return this->isWindow();}
+
+public slots:
+	void setFloating(bool floating);
+
+protected:
+	void resizeEvent(QResizeEvent* event) override;
+	void closeEvent(QCloseEvent* event) override;
+	//area next to the float button that can be used for a title line
+	QRect titleRect() const;
+
+	static const int TITLE_HEIGHT = 20;
+
+private:
+	QToolButton* floatButton;
+};
+
+#endif //DETACHABLEPANEL_H
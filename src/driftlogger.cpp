@@ -0,0 +1,59 @@
+#include "driftlogger.h"
+#include <QDateTime>
+#include <QMutexLocker>
+
+
+DriftLogger::DriftLogger() {
+}
+
+DriftLogger::~DriftLogger() {
+	this->stop();
+}
+
+bool DriftLogger::start(const QString& filePath) {
+	QMutexLocker locker(&this->mutex);
+	if(this->file.isOpen()){
+		this->stream.flush();
+		this->file.close();
+	}
+	this->file.setFileName(filePath);
+	if(!this->file.open(QIODevice::WriteOnly | QIODevice::Text)){
+		return false;
+	}
+	this->stream.setDevice(&this->file);
+	this->stream << "buffer_nr,timestamp_ms,drift_timestamp_ms,drift_frame_nr,dx_px,dy_px,rotation_deg,confidence\n";
+	return true;
+}
+
+void DriftLogger::stop() {
+	QMutexLocker locker(&this->mutex);
+	if(this->file.isOpen()){
+		this->stream.flush();
+		this->stream.setDevice(nullptr);
+		this->file.close();
+	}
+}
+
+bool DriftLogger::isActive() {
+	QMutexLocker locker(&this->mutex);
+	return this->file.isOpen();
+}
+
+void DriftLogger::updateDrift(const DriftEstimate& estimate) {
+	QMutexLocker locker(&this->mutex);
+	this->latestEstimate = estimate;
+}
+
+void DriftLogger::logBuffer(unsigned int currentBufferNr) {
+	QMutexLocker locker(&this->mutex);
+	if(!this->file.isOpen()){
+		return;
+	}
+	const DriftEstimate& e = this->latestEstimate;
+	this->stream << currentBufferNr << ',' << QDateTime::currentMSecsSinceEpoch() << ',';
+	if(e.valid){
+		this->stream << e.timestamp << ',' << e.frameNumber << ',' << e.dx << ',' << e.dy << ',' << e.rotation << ',' << e.confidence << '\n';
+	} else {
+		this->stream << ",,,,,\n";
+	}
+}
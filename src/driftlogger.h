@@ -0,0 +1,33 @@
+#ifndef DRIFTLOGGER_H
+#define DRIFTLOGGER_H
+
+#include <QFile>
+#include <QTextStream>
+#include <QMutex>
+#include "drifttracker.h"
+
+
+//writes the most recent drift estimate together with the number of each OCT buffer processed by OCTproZ to a csv file.
+//updateDrift() is called from the gui thread, logBuffer() from the thread that delivers the processed OCT data
+class DriftLogger
+{
+public:
+	DriftLogger();
+	~DriftLogger();
+
+	bool start(const QString& filePath);
+	void stop();
+	bool isActive();
+	QString getFilePath() const {return this->file.fileName();}
+
+	void updateDrift(const DriftEstimate& estimate);
+	void logBuffer(unsigned int currentBufferNr);
+
+private:
+	QMutex mutex;
+	QFile file;
+	QTextStream stream;
+	DriftEstimate latestEstimate;
+};
+
+#endif //DRIFTLOGGER_H
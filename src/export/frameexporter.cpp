@@ -0,0 +1,191 @@
+#include "frameexporter.h"
+#include <cstring>
+#include <cerrno>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <climits>
+#endif
+
+
+FrameExporter::FrameExporter(QObject *parent)
+	: QObject(parent),
+	  enabled(false),
+	  segment(nullptr),
+	  segmentSize(0),
+	  header(nullptr),
+	  framesPublished(0),
+	  framesSkipped(0)
+{
+}
+
+FrameExporter::~FrameExporter() {
+	this->stop();
+}
+
+QString FrameExporter::ringName(const QString& viewTag) {
+	return QString(FrameRing::NAME_PREFIX) + (viewTag.isEmpty() ? QString() : "_" + viewTag);
+}
+
+bool FrameExporter::isSupported() {
+#ifdef Q_OS_UNIX
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool FrameExporter::start(const QString& name) {
+	if(!isSupported()){
+		emit error(tr("Frame export via shared memory is not supported on this platform."));
+		return false;
+	}
+	this->stop();
+	this->name = name;
+	this->framesPublished = 0;
+	this->framesSkipped = 0;
+	this->clock.start();
+	this->enabled = true;
+	return true;
+}
+
+void FrameExporter::stop() {
+	this->enabled = false;
+	this->destroyRing();
+}
+
+FrameExportStatistics FrameExporter::getStatistics() const {
+	FrameExportStatistics statistics;
+	statistics.enabled = this->enabled;
+	statistics.name = this->name;
+	statistics.framesPublished = this->framesPublished;
+	statistics.framesSkipped = this->framesSkipped;
+	statistics.attachedReaders = this->header != nullptr ? this->header->attachedReaders.load(std::memory_order_relaxed) : 0;
+	statistics.slotCount = this->header != nullptr ? this->header->slotCount : 0;
+	statistics.slotSize = this->header != nullptr ? this->header->slotSize : 0;
+	return statistics;
+}
+
+void FrameExporter::submitFrame(const QVideoFrame& frame) {
+	if(!this->enabled || !frame.isValid()){
+		return;
+	}
+	QVideoFrame mappedFrame(frame);
+	if(!mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		this->framesSkipped++;
+		return;
+	}
+	int size = mappedFrame.mappedBytes();
+	if(this->header == nullptr || FrameRing::SLOT_HEADER_SIZE + static_cast<quint64>(size) > this->header->slotSize){
+		//first frame or the frame size grew (e.g. other resolution), readers notice the closed ring and reopen it
+		this->destroyRing();
+		if(!this->createRing(static_cast<quint64>(size))){
+			mappedFrame.unmap();
+			this->stop();
+			return;
+		}
+	}
+	this->publish(mappedFrame.bits(), size, mappedFrame);
+	mappedFrame.unmap();
+}
+
+bool FrameExporter::createRing(quint64 frameSize) {
+#ifdef Q_OS_UNIX
+	quint64 slotSize = FrameRing::alignSlot(FrameRing::SLOT_HEADER_SIZE + frameSize);
+	quint64 size = FrameRing::HEADER_SIZE + slotSize*FrameRing::DEFAULT_SLOT_COUNT;
+	QByteArray shmName = this->name.toLocal8Bit();
+
+	//a ring left behind by a crashed instance is replaced
+	shm_unlink(shmName.constData());
+	int fd = shm_open(shmName.constData(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+	if(fd < 0){
+		emit error(tr("Could not create shared memory ") + this->name + ": " + QString::fromLocal8Bit(strerror(errno)));
+		return false;
+	}
+	if(ftruncate(fd, static_cast<off_t>(size)) != 0){
+		emit error(tr("Could not allocate shared memory ") + this->name + ": " + QString::fromLocal8Bit(strerror(errno)));
+		::close(fd);
+		shm_unlink(shmName.constData());
+		return false;
+	}
+	void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(address == MAP_FAILED){
+		emit error(tr("Could not map shared memory ") + this->name + ": " + QString::fromLocal8Bit(strerror(errno)));
+		shm_unlink(shmName.constData());
+		return false;
+	}
+
+	//the segment is zero filled by ftruncate, the magic is written last so readers never see a partially initialized header
+	this->segment = static_cast<uchar*>(address);
+	this->segmentSize = size;
+	this->header = reinterpret_cast<FrameRingHeader*>(this->segment);
+	this->header->version = FrameRing::VERSION;
+	this->header->headerSize = FrameRing::HEADER_SIZE;
+	this->header->slotCount = FrameRing::DEFAULT_SLOT_COUNT;
+	this->header->slotHeaderSize = FrameRing::SLOT_HEADER_SIZE;
+	this->header->slotSize = slotSize;
+	this->header->writerPid = static_cast<int64_t>(getpid());
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(this->header->magic, FrameRing::MAGIC, sizeof(FrameRing::MAGIC));
+	return true;
+#else
+	Q_UNUSED(frameSize)
+	return false;
+#endif
+}
+
+void FrameExporter::destroyRing() {
+#ifdef Q_OS_UNIX
+	if(this->segment == nullptr){
+		return;
+	}
+	//wake up waiting readers, so they notice that the ring was closed. the memory stays valid for them until they unmap it
+	this->header->closed.store(1, std::memory_order_release);
+	this->header->notifySequence.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+	syscall(SYS_futex, &this->header->notifySequence, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+	munmap(this->segment, this->segmentSize);
+	shm_unlink(this->name.toLocal8Bit().constData());
+	this->segment = nullptr;
+	this->segmentSize = 0;
+	this->header = nullptr;
+#endif
+}
+
+void FrameExporter::publish(const uchar* data, int size, const QVideoFrame& frame) {
+	quint64 frameIndex = this->header->publishedFrames.load(std::memory_order_relaxed);
+	FrameRingSlot* slot = reinterpret_cast<FrameRingSlot*>(this->segment + FrameRing::HEADER_SIZE + (frameIndex % this->header->slotCount)*this->header->slotSize);
+
+	//sequence lock: odd while the slot is written
+	slot->sequence.store(2*frameIndex + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot->frameIndex = frameIndex;
+	slot->timestamp = frame.startTime() >= 0 ? frame.startTime() : this->clock.nsecsElapsed()/1000;
+	slot->width = static_cast<uint32_t>(frame.width());
+	slot->height = static_cast<uint32_t>(frame.height());
+	slot->pixelFormat = static_cast<int32_t>(frame.pixelFormat());
+	slot->bytesPerLine = static_cast<uint32_t>(frame.bytesPerLine());
+	slot->size = static_cast<uint32_t>(size);
+	memcpy(reinterpret_cast<uchar*>(slot) + FrameRing::SLOT_HEADER_SIZE, data, static_cast<size_t>(size));
+	slot->sequence.store(2*frameIndex + 2, std::memory_order_release);
+	this->header->publishedFrames.store(frameIndex + 1, std::memory_order_release);
+	this->framesPublished++;
+
+	//notification costs a syscall only if a reader actually waits. sequentially consistent, so a reader that registers as waiter
+	//either sees the new notifySequence or is seen by the writer
+	this->header->notifySequence.fetch_add(1);
+#ifdef __linux__
+	if(this->header->waitingReaders.load() > 0){
+		syscall(SYS_futex, &this->header->notifySequence, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+	}
+#endif
+}
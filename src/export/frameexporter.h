@@ -0,0 +1,61 @@
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+#include <QObject>
+#include <QVideoFrame>
+#include <QElapsedTimer>
+#include "framering.h"
+
+
+struct FrameExportStatistics {
+	bool enabled;
+	QString name;
+	quint64 framesPublished;
+	quint64 framesSkipped;
+	quint32 attachedReaders;
+	quint32 slotCount;
+	quint64 slotSize;
+};
+
+//publishes every camera frame into a POSIX shared memory ring (see framering.h), so external analysis tools can use the frames without
+//opening the camera themselves. publishing is a single copy into the ring on the gui thread, the writer never waits for readers.
+//the ring is created with the first frame and recreated if a larger frame does not fit into a slot. not available on windows
+class FrameExporter : public QObject
+{
+	Q_OBJECT
+public:
+	explicit FrameExporter(QObject *parent = nullptr);
+	~FrameExporter();
+
+	bool start(const QString& name);
+	void stop();
+	bool isEnabled() const {return this->enabled;}
+	QString getName() const {return this->name;}
+	FrameExportStatistics getStatistics() const;
+
+	//shared memory name of the ring of a camera view, the view tag keeps rings of several views apart
+	static QString ringName(const QString& viewTag);
+	static bool isSupported();
+
+private:
+	bool enabled;
+	QString name;
+	uchar* segment;
+	quint64 segmentSize;
+	FrameRingHeader* header;
+	quint64 framesPublished;
+	quint64 framesSkipped;
+	QElapsedTimer clock;
+
+	bool createRing(quint64 frameSize);
+	void destroyRing();
+	void publish(const uchar* data, int size, const QVideoFrame& frame);
+
+public slots:
+	void submitFrame(const QVideoFrame& frame);
+
+signals:
+	void error(QString);
+};
+
+#endif //FRAMEEXPORTER_H
@@ -0,0 +1,61 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+
+//layout of the shared memory frame ring used to export camera frames to other processes. this header is shared with the reader library
+//in tools/framering and must not depend on Qt.
+//
+//the segment starts with a FrameRingHeader followed by slotCount slots of slotSize bytes. every slot starts with a FrameRingSlot followed by
+//the frame data. the writer never waits for readers, slots are protected by a sequence lock instead: the sequence of a slot is odd while
+//the slot is written and 2*(frameIndex+1) once frame frameIndex is complete. a reader checks the sequence before and after it used the
+//frame data, if it changed the writer overtook the reader and the data must be discarded.
+//readers are notified of new frames by a change of notifySequence (futex on linux, polling elsewhere)
+namespace FrameRing
+{
+	const char MAGIC[8] = {'O', 'C', 'T', 'F', 'R', 'I', 'N', 'G'};
+	const uint32_t VERSION = 1;
+	const uint32_t HEADER_SIZE = 4096;
+	const uint32_t SLOT_HEADER_SIZE = 64;
+	const uint32_t SLOT_ALIGNMENT = 4096;
+	const uint32_t DEFAULT_SLOT_COUNT = 4;
+	const char NAME_PREFIX[] = "/octproz_camera";
+
+	inline uint64_t alignSlot(uint64_t size) {return (size + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;}
+}
+
+struct FrameRingHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t slotCount;
+	uint32_t slotHeaderSize;
+	uint64_t slotSize; //slot header + maximum frame size, multiple of SLOT_ALIGNMENT
+	int64_t writerPid;
+	std::atomic<uint32_t> closed; //1 once the writer left the ring, readers have to reopen the segment to get further frames
+	std::atomic<uint32_t> notifySequence; //incremented for every published frame, futex word
+	std::atomic<uint32_t> waitingReaders; //readers that currently wait on notifySequence, the writer skips the wake up syscall if 0
+	std::atomic<uint32_t> attachedReaders;
+	std::atomic<uint64_t> publishedFrames; //number of frames published so far, the latest frame is publishedFrames-1
+	uint8_t reserved[4096 - 64];
+};
+static_assert(sizeof(FrameRingHeader) == FrameRing::HEADER_SIZE, "FrameRingHeader has to fill the header page");
+
+struct FrameRingSlot {
+	std::atomic<uint64_t> sequence;
+	uint64_t frameIndex; //index of the frame within the ring, frames not read in time are visible as gaps
+	int64_t timestamp; //us, QVideoFrame::startTime() of the camera frame or steady clock if not available
+	uint32_t width;
+	uint32_t height;
+	int32_t pixelFormat; //QVideoFrame::PixelFormat
+	uint32_t bytesPerLine;
+	uint32_t size; //bytes of frame data following the slot header
+	uint8_t reserved[20];
+};
+static_assert(sizeof(FrameRingSlot) == FrameRing::SLOT_HEADER_SIZE, "unexpected FrameRingSlot size");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "frame ring requires lock free atomics to work across processes");
+
+#endif //FRAMERING_H
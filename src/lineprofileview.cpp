@@ -0,0 +1,114 @@
+#include "lineprofileview.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QMouseEvent>
+
+#define PLOT_MARGIN_LEFT 30
+#define PLOT_MARGIN_RIGHT 8
+#define PLOT_MARGIN_BOTTOM 18
+
+
+LineProfileView::LineProfileView(QWidget *parent)
+	: DetachablePanel(parent),
+	cursorX(-1)
+{
+	this->setWindowTitle(tr("Line profile"));
+	this->setMinimumHeight(100);
+	this->setMouseTracking(true);
+}
+
+LineProfileView::~LineProfileView() {
+}
+
+void LineProfileView::setProfile(LineProfile profile) {
+	this->profile = profile;
+	this->update();
+}
+
+QRect LineProfileView::plotRect() const {
+	return this->rect().adjusted(PLOT_MARGIN_LEFT, TITLE_HEIGHT, -PLOT_MARGIN_RIGHT, -PLOT_MARGIN_BOTTOM);
+}
+
+void LineProfileView::paintEvent(QPaintEvent* event) {
+	Q_UNUSED(event)
+	QPainter painter(this);
+	painter.fillRect(this->rect(), QColor(30, 30, 30));
+	QRect plot = this->plotRect();
+	if(plot.width() < 2 || plot.height() < 2){
+		return;
+	}
+
+	//intensity grid at 0, 64, 128, 192, 255
+	const int levels[] = {0, 64, 128, 192, 255};
+	for(int level : levels){
+		int y = plot.bottom() - level*plot.height()/255;
+		painter.setPen(QColor(70, 70, 70));
+		painter.drawLine(plot.left(), y, plot.right(), y);
+		painter.setPen(QColor(150, 150, 150));
+		painter.drawText(QRect(0, y - 8, PLOT_MARGIN_LEFT - 4, 16), Qt::AlignRight | Qt::AlignVCenter, QString::number(level));
+	}
+
+	painter.setPen(Qt::white);
+	QRect titleRect = this->titleRect().adjusted(PLOT_MARGIN_LEFT - 4, 0, 0, 0);
+	if(!this->profile.valid || this->profile.values.size() < 2){
+		painter.drawText(titleRect, Qt::AlignLeft | Qt::AlignVCenter, tr("Show the line overlay to measure a profile"));
+		return;
+	}
+	const QVector<float>& values = this->profile.values;
+	const int count = values.size();
+	QString title = tr("Length %1 px, averaged over %2 px").arg(this->profile.length, 0, 'f', 1).arg(this->profile.averagingWidth);
+
+	//long profiles are drawn as min/max envelope per pixel column, short ones as polyline
+	painter.setRenderHint(QPainter::Antialiasing, true);
+	painter.setPen(QPen(QColor(0, 200, 255), 1.0));
+	auto yOf = [&plot](float value) {return plot.bottom() - value*plot.height()/255.0;};
+	if(count > plot.width()){
+		QPainterPath path;
+		for(int column = 0; column < plot.width(); column++){
+			int i0 = column*count/plot.width();
+			int i1 = qMax(i0 + 1, (column + 1)*count/plot.width());
+			float low = values.at(i0);
+			float high = values.at(i0);
+			for(int i = i0 + 1; i < i1; i++){
+				low = qMin(low, values.at(i));
+				high = qMax(high, values.at(i));
+			}
+			path.moveTo(plot.left() + column + 0.5, yOf(low) + 0.5);
+			path.lineTo(plot.left() + column + 0.5, yOf(high) - 0.5);
+		}
+		painter.drawPath(path);
+	} else {
+		QPolygonF polyline;
+		for(int i = 0; i < count; i++){
+			polyline << QPointF(plot.left() + i*(plot.width() - 1.0)/(count - 1), yOf(values.at(i)));
+		}
+		painter.drawPolyline(polyline);
+	}
+	painter.setRenderHint(QPainter::Antialiasing, false);
+
+	//distance axis and cursor readout
+	painter.setPen(QColor(150, 150, 150));
+	painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), PLOT_MARGIN_BOTTOM - 2), Qt::AlignLeft | Qt::AlignVCenter, "0");
+	painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), PLOT_MARGIN_BOTTOM - 2), Qt::AlignRight | Qt::AlignVCenter,
+		QString("%1 px").arg(this->profile.length, 0, 'f', 0));
+	if(this->cursorX >= plot.left() && this->cursorX <= plot.right()){
+		int index = qBound(0, qRound((this->cursorX - plot.left())*(count - 1.0)/(plot.width() - 1)), count - 1);
+		painter.setPen(QPen(QColor(255, 255, 255, 120), 1, Qt::DashLine));
+		painter.drawLine(this->cursorX, plot.top(), this->cursorX, plot.bottom());
+		title = tr("%1 px: %2").arg(index*this->profile.length/(count - 1), 0, 'f', 1).arg(values.at(index), 0, 'f', 1);
+	}
+	painter.setPen(Qt::white);
+	painter.drawText(titleRect, Qt::AlignLeft | Qt::AlignVCenter, title);
+}
+
+void LineProfileView::mouseMoveEvent(QMouseEvent* event) {
+	this->cursorX = event->pos().x();
+	this->update();
+	QWidget::mouseMoveEvent(event);
+}
+
+void LineProfileView::leaveEvent(QEvent* event) {
+	this->cursorX = -1;
+	this->update();
+	QWidget::leaveEvent(event);
+}
@@ -0,0 +1,34 @@
+#ifndef LINEPROFILEVIEW_H
+#define LINEPROFILEVIEW_H
+
+#include "detachablepanel.h"
+#include "lineprofile.h"
+
+
+//plot of the intensity profile along the line overlay. repaints are coalesced by the widget, so profiles that arrive faster than the display
+//are dropped. the cursor position is shown as distance along the line and intensity
+class LineProfileView : public DetachablePanel {
+	Q_OBJECT
+
+public:
+	explicit LineProfileView(QWidget *parent = nullptr);
+	~LineProfileView();
+
+	QSize sizeHint() const override {return QSize(400, 140);}
+
+public slots:
+	void setProfile(LineProfile profile);
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+	void mouseMoveEvent(QMouseEvent* event) override;
+	void leaveEvent(QEvent* event) override;
+
+private:
+	LineProfile profile;
+	int cursorX;
+
+	QRect plotRect() const;
+};
+
+#endif //LINEPROFILEVIEW_H
@@ -0,0 +1,52 @@
+#include "mosaicitem.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+
+MosaicItem::MosaicItem(QSharedPointer<MosaicCanvas> canvas, QGraphicsItem* parent)
+	: QGraphicsItem(parent),
+	  canvas(canvas)
+{
+	this->setFlag(QGraphicsItem::ItemStacksBehindParent, true);
+	//exposedRect is needed to draw only the visible tiles
+	this->setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+	this->setAcceptedMouseButtons(Qt::NoButton);
+}
+
+void MosaicItem::setMosaicRect(const QRect& rect) {
+	if(this->mosaicRect != rect){
+		this->prepareGeometryChange();
+		this->mosaicRect = rect;
+	}
+}
+
+QRectF MosaicItem::boundingRect() const {
+	return QRectF(this->mosaicRect);
+}
+
+void MosaicItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+	Q_UNUSED(widget)
+	if(this->mosaicRect.isEmpty()){
+		return;
+	}
+	//coarsest level whose pixels are drawn at most 2 screen pixels wide
+	const qreal levelOfDetail = option->levelOfDetailFromTransform(painter->worldTransform());
+	int level = 0;
+	qreal levelScale = MosaicCanvas::LEVEL_FACTOR;
+	while(level + 1 < MosaicCanvas::LEVELS && levelOfDetail*levelScale <= 2.0){
+		level++;
+		levelScale *= MosaicCanvas::LEVEL_FACTOR;
+	}
+
+	const QRectF exposed = option->exposedRect.intersected(this->boundingRect());
+	painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+	const QList<QPair<QRect, QImage>> tiles = this->canvas->tiles(level, exposed);
+	for(const auto& tile : tiles){
+		if(tile.second.isNull()){
+			//still being loaded from the spill file and no coarser level in memory, the canvas requests a repaint when it arrives
+			painter->fillRect(QRectF(tile.first), QColor(128, 128, 128, 64));
+		}else{
+			painter->drawImage(QRectF(tile.first), tile.second);
+		}
+	}
+}
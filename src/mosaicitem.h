@@ -0,0 +1,30 @@
+#ifndef MOSAICITEM_H
+#define MOSAICITEM_H
+
+#include <QGraphicsItem>
+#include <QSharedPointer>
+#include "mosaiccanvas.h"
+
+
+//draws the mosaic of a MosaicBuilder. item coordinates are mosaic pixels, the item is placed behind the video item by the view so the
+//live frame covers its own position in the mosaic and the overlays stay on top. only the exposed tiles are drawn, from the coarsest
+//level of the canvas that still has about one pixel per screen pixel, so zooming out never reads more than a screen full of tiles.
+//tiles that are not in memory are drawn from a coarser level or as a placeholder while the canvas loads them in the background
+class MosaicItem : public QGraphicsItem
+{
+public:
+	explicit MosaicItem(QSharedPointer<MosaicCanvas> canvas, QGraphicsItem* parent = nullptr);
+
+	//area covered by the mosaic in mosaic pixels, an empty rect hides the mosaic
+	void setMosaicRect(const QRect& rect);
+	QRect getMosaicRect() const {return this->mosaicRect;}
+
+	QRectF boundingRect() const override;
+	void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
+private:
+	QSharedPointer<MosaicCanvas> canvas;
+	QRect mosaicRect;
+};
+
+#endif //MOSAICITEM_H
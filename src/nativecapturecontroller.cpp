@@ -0,0 +1,150 @@
+#include "nativecapturecontroller.h"
+#include "cameraviewwidget.h"
+#include "cameracapabilities.h"
+
+#include <QAction>
+#include <QActionGroup>
+#include <QInputDialog>
+
+
+NativeCaptureController::NativeCaptureController(CameraViewWidget* view, FrameTapSurface* frameTap)
+	: QObject(view),
+	  view(view)
+{
+	this->source = new V4l2Source(frameTap, this);
+	connect(this->source, &V4l2Source::error, this, &NativeCaptureController::error);
+}
+
+NativeCaptureController::~NativeCaptureController() {
+	this->source->close();
+}
+
+bool NativeCaptureController::open(const QCameraInfo& cameraInfo, const CameraDeviceConfig& config, QString* startMode) {
+	QCameraViewfinderSettings settings = config.viewfinder;
+	QString mode = tr("stored configuration");
+	const DeviceCapabilities capabilities = CameraCapabilities::load(cameraInfo.deviceName());
+	const ProbedMode* fastestMode = capabilities.fastestMode();
+	if(settings.isNull() && fastestMode != nullptr){
+		settings = fastestMode->settings;
+		mode = tr("fastest measured mode");
+	} else if(settings.isNull()){
+		mode = tr("driver default mode");
+	}
+
+	if(!this->source->open(cameraInfo.deviceName(), settings)){
+		return false;
+	}
+	this->controlValues = config.nativeControls;
+	for(auto it = this->controlValues.constBegin(); it != this->controlValues.constEnd(); ++it){
+		this->source->setControl(it.key(), it.value());
+	}
+	if(startMode != nullptr){
+		*startMode = tr("native V4L2, %1 %2").arg(mode).arg(CameraCapabilities::modeToString(this->source->getSettings()));
+	}
+	return true;
+}
+
+void NativeCaptureController::close() {
+	this->source->close();
+}
+
+void NativeCaptureController::addMenu(QMenu* menu, bool selected, bool switchable) {
+	if(!V4l2Source::isSupported()){
+		return;
+	}
+	QMenu* nativeMenu = menu->addMenu(tr("Native V4L2 capture"));
+	QAction* nativeAction = nativeMenu->addAction(tr("Capture directly via V4L2 (bypass GStreamer)"));
+	nativeAction->setCheckable(true);
+	nativeAction->setChecked(selected);
+	nativeAction->setEnabled(switchable);
+	connect(nativeAction, &QAction::toggled, this, &NativeCaptureController::nativeCaptureToggled);
+	if(!this->source->isOpen()){
+		return;
+	}
+
+	//controls of the driver, queried when the menu is opened so inactive controls (e.g. exposure time in automatic mode) are disabled
+	QList<V4l2Control> controls = this->source->getControls();
+	if(!controls.isEmpty()){
+		nativeMenu->addSeparator();
+	}
+	for(const V4l2Control& control : controls){
+		quint32 id = control.id;
+		if(control.type == V4l2Control::BOOLEAN){
+			QAction* controlAction = nativeMenu->addAction(control.name);
+			controlAction->setCheckable(true);
+			controlAction->setChecked(control.value != 0);
+			controlAction->setEnabled(control.enabled);
+			connect(controlAction, &QAction::toggled, this, [this, id](bool checked) {
+				this->setControl(id, checked ? 1 : 0);
+			});
+		} else if(control.type == V4l2Control::MENU){
+			QMenu* controlMenu = nativeMenu->addMenu(control.name);
+			controlMenu->setEnabled(control.enabled);
+			QActionGroup* itemGroup = new QActionGroup(controlMenu);
+			itemGroup->setExclusive(true);
+			for(const QPair<qint32, QString>& item : control.menuItems){
+				qint32 value = item.first;
+				QAction* itemAction = controlMenu->addAction(item.second);
+				itemAction->setCheckable(true);
+				itemAction->setChecked(control.value == value);
+				itemAction->setActionGroup(itemGroup);
+				connect(itemAction, &QAction::triggered, this, [this, id, value]() {
+					this->setControl(id, value);
+				});
+			}
+		} else {
+			QAction* controlAction = nativeMenu->addAction(tr("%1: %2...").arg(control.name).arg(control.value));
+			controlAction->setEnabled(control.enabled);
+			connect(controlAction, &QAction::triggered, this, [this, control]() {
+				bool ok = false;
+				int value = QInputDialog::getInt(this->view, tr("Native V4L2 capture"), tr("%1 (%2 to %3):").arg(control.name).arg(control.minimum).arg(control.maximum),
+					control.value, control.minimum, control.maximum, qMax(1, control.step), &ok);
+				if(ok){
+					this->setControl(control.id, value);
+				}
+			});
+		}
+	}
+	QAction* resetAction = nativeMenu->addAction(tr("Reset controls to defaults"));
+	resetAction->setEnabled(!controls.isEmpty());
+	connect(resetAction, &QAction::triggered, this, &NativeCaptureController::resetControls);
+}
+
+void NativeCaptureController::setControl(quint32 id, qint32 value) {
+	if(!this->source->setControl(id, value)){
+		emit error(tr("The driver did not accept the value %1 for the control.").arg(value));
+		return;
+	}
+	this->controlValues.insert(id, value);
+	emit controlsChanged();
+}
+
+void NativeCaptureController::resetControls() {
+	if(!this->source->isOpen()){
+		return;
+	}
+	for(const V4l2Control& control : this->source->getControls()){
+		this->source->setControl(control.id, control.defaultValue);
+	}
+	this->controlValues.clear();
+	emit controlsChanged();
+}
+
+void NativeCaptureController::updateStatistics(StatisticsView* statisticsView) {
+	if(!this->source->isOpen()){
+		return;
+	}
+	V4l2Statistics native = this->source->getStatistics();
+	StatisticsValues nativeValues;
+	nativeValues << qMakePair(tr("Driver"), QString("%1 (%2)").arg(native.card).arg(native.driver));
+	nativeValues << qMakePair(tr("Format"), QString("%1 %2x%3 @ %4 fps").arg(native.fourcc).arg(native.resolution.width()).arg(native.resolution.height())
+		.arg(native.frameRate, 0, 'f', 1));
+	nativeValues << qMakePair(tr("Buffers"), tr("%1 mmap, %2").arg(native.bufferCount).arg(native.dmabufExported ? tr("exported as DMABUF") : tr("no DMABUF export")));
+	nativeValues << qMakePair(tr("Timestamps"), native.monotonicTimestamps ? tr("driver, monotonic clock") : tr("driver, other clock"));
+	nativeValues << qMakePair(tr("Frame interval"), native.averageIntervalUs > 0.0 ? QString("%1 ms").arg(native.averageIntervalUs/1000.0, 0, 'f', 2) : QString("-"));
+	nativeValues << qMakePair(tr("Latency"), native.averageLatencyUs > 0.0 ? tr("%1 ms (max %2 ms)").arg(native.averageLatencyUs/1000.0, 0, 'f', 2)
+		.arg(native.maxLatencyUs/1000.0, 0, 'f', 2) : QString("-"));
+	nativeValues << qMakePair(tr("Frames"), tr("%1 captured, %2 dropped by driver, %3 replaced, %4 copied").arg(native.framesCaptured)
+		.arg(native.framesDroppedByDriver).arg(native.framesReplaced).arg(native.framesCopied));
+	statisticsView->setSection(tr("Native V4L2 capture"), nativeValues);
+}
@@ -0,0 +1,57 @@
+#ifndef NATIVECAPTURECONTROLLER_H
+#define NATIVECAPTURECONTROLLER_H
+
+#include <QObject>
+#include <QMenu>
+#include <QMap>
+#include <QCameraInfo>
+#include "v4l2source.h"
+#include "cameradeviceconfig.h"
+#include "frametapsurface.h"
+#include "statisticsview.h"
+
+class CameraViewWidget;
+
+
+//optional native V4L2 capture of a camera view. the V4l2Source delivers into the FrameTapSurface of the view like the QCamera. the controller
+//selects the mode, applies and keeps the control values of the driver that are stored with the device configuration and provides the
+//context menu with the driver controls. switching between native capture and Qt Multimedia reopens the camera and is left to the view
+class NativeCaptureController : public QObject
+{
+	Q_OBJECT
+public:
+	explicit NativeCaptureController(CameraViewWidget* view, FrameTapSurface* frameTap);
+	~NativeCaptureController();
+
+	//same mode selection as with QCamera: stored configuration, otherwise the fastest measured mode, otherwise the current mode of the driver.
+	//the stored controls are applied once the device is open, startMode describes the selected mode
+	bool open(const QCameraInfo& cameraInfo, const CameraDeviceConfig& config, QString* startMode);
+	void close();
+	bool isOpen() const {return this->source->isOpen();}
+	QCameraViewfinderSettings getSettings() const {return this->source->getSettings();}
+	//Bayer pattern and bit depth of the raw format delivered by the driver, false if the frames are not a Bayer mosaic
+	bool getRawLayout(int* pattern, int* bitDepth) const {return V4l2Source::bayerLayout(this->source->getFourcc(), pattern, bitDepth);}
+	//control values set by the user, every change is reported by controlsChanged() so they can be stored with the device configuration
+	QMap<quint32, qint32> getControlValues() const {return this->controlValues;}
+
+	//selected is the stored native capture setting of the device, switchable is false while it can not be changed (recording, playback, ...)
+	void addMenu(QMenu* menu, bool selected, bool switchable);
+	void updateStatistics(StatisticsView* statisticsView);
+
+private:
+	CameraViewWidget* view;
+	V4l2Source* source;
+	QMap<quint32, qint32> controlValues;
+
+	void setControl(quint32 id, qint32 value);
+
+public slots:
+	void resetControls();
+
+signals:
+	void error(QString);
+	void nativeCaptureToggled(bool enabled);
+	void controlsChanged();
+};
+
+#endif //NATIVECAPTURECONTROLLER_H
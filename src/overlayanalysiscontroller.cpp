@@ -0,0 +1,274 @@
+#include "overlayanalysiscontroller.h"
+#include "cameraviewwidget.h"
+
+#include <QAction>
+#include <QActionGroup>
+
+
+OverlayAnalysisController::OverlayAnalysisController(CameraViewWidget* view, FrameTapSurface* frameTap)
+	: QObject(view),
+	  view(view),
+	  roiStatisticsAnalyzer(new RoiStatisticsAnalyzer(this)),
+	  lineProfileAnalyzer(new LineProfileAnalyzer(this)),
+	  polarUnwrapper(new PolarUnwrapper(this)),
+	  polarStripValid(false)
+{
+	connect(frameTap, &FrameTapSurface::frameAvailable, this->roiStatisticsAnalyzer, &RoiStatisticsAnalyzer::submitFrame);
+	connect(this->roiStatisticsAnalyzer, &RoiStatisticsAnalyzer::roiStatisticsMeasured, this, &OverlayAnalysisController::onRoiStatisticsMeasured);
+	connect(frameTap, &FrameTapSurface::frameAvailable, this->lineProfileAnalyzer, &LineProfileAnalyzer::submitFrame);
+	connect(this->lineProfileAnalyzer, &LineProfileAnalyzer::lineProfileMeasured, this, &OverlayAnalysisController::onLineProfileMeasured);
+	connect(frameTap, &FrameTapSurface::frameAvailable, this->polarUnwrapper, &PolarUnwrapper::submitFrame);
+	connect(this->polarUnwrapper, &PolarUnwrapper::polarStripMeasured, this, &OverlayAnalysisController::onPolarStripMeasured);
+}
+
+OverlayAnalysisController::~OverlayAnalysisController() {
+	//the analyzers wait for their running tasks, which refer to them
+	delete this->roiStatisticsAnalyzer;
+	this->roiStatisticsAnalyzer = nullptr;
+	delete this->lineProfileAnalyzer;
+	this->lineProfileAnalyzer = nullptr;
+	delete this->polarUnwrapper;
+	this->polarUnwrapper = nullptr;
+}
+
+void OverlayAnalysisController::addMenus(QMenu* menu) {
+	QAction* roiStatisticsAction = menu->addAction(tr("Show intensity statistics of overlays"));
+	roiStatisticsAction->setCheckable(true);
+	roiStatisticsAction->setChecked(this->roiStatisticsAnalyzer->isEnabled());
+	connect(roiStatisticsAction, &QAction::toggled, this, &OverlayAnalysisController::setRoiStatisticsEnabled);
+
+	QMenu* profileMenu = menu->addMenu(tr("Line profile"));
+	QAction* profileAction = profileMenu->addAction(tr("Show intensity profile along line overlay"));
+	profileAction->setCheckable(true);
+	profileAction->setChecked(this->lineProfileAnalyzer->isEnabled());
+	connect(profileAction, &QAction::toggled, this, &OverlayAnalysisController::setLineProfileEnabled);
+
+	//number of parallel lines that are averaged, perpendicular to the line overlay
+	profileMenu->addSeparator();
+	QActionGroup* widthGroup = new QActionGroup(profileMenu);
+	const QList<int> widths = {1, 3, 5, 9, 15, LineProfileAnalyzer::MAX_AVERAGING_WIDTH};
+	for(int width : widths){
+		QAction* action = profileMenu->addAction(width == 1 ? tr("No averaging") : tr("Average over %1 px").arg(width));
+		action->setCheckable(true);
+		action->setChecked(this->lineProfileAnalyzer->getAveragingWidth() == width);
+		widthGroup->addAction(action);
+		connect(action, &QAction::triggered, this, [this, width]() { this->setLineProfileWidth(width); });
+	}
+
+	QMenu* unwrapMenu = menu->addMenu(tr("Polar unwrap"));
+	QAction* unwrapAction = unwrapMenu->addAction(tr("Show circle overlay unwrapped"));
+	unwrapAction->setCheckable(true);
+	unwrapAction->setChecked(this->polarUnwrapper->isEnabled());
+	connect(unwrapAction, &QAction::toggled, this, &OverlayAnalysisController::setPolarUnwrapEnabled);
+
+	//radial extent of the strip around the circle, in percent of the radius
+	unwrapMenu->addSeparator();
+	QActionGroup* bandGroup = new QActionGroup(unwrapMenu);
+	const QList<int> bands = {10, 25, 50, 100};
+	for(int band : bands){
+		QAction* action = unwrapMenu->addAction(band == 100 ? tr("From the center to twice the radius") : tr("Radius ±%1 %").arg(band));
+		action->setCheckable(true);
+		action->setChecked(this->polarUnwrapper->getBand() == band);
+		bandGroup->addAction(action);
+		connect(action, &QAction::triggered, this, [this, band]() { this->setPolarUnwrapBand(band); });
+	}
+}
+
+void OverlayAnalysisController::updateRegions() {
+	if(this->roiStatisticsAnalyzer->isEnabled()){
+		this->updateRoiStatisticsRegions();
+	}
+	if(this->lineProfileAnalyzer->isEnabled()){
+		this->updateLineProfileLine();
+	}
+	if(this->polarUnwrapper->isEnabled()){
+		this->updatePolarUnwrapCircle();
+	}
+}
+
+void OverlayAnalysisController::setRoiStatisticsEnabled(bool enabled) {
+	if(this->roiStatisticsAnalyzer->isEnabled() == enabled){
+		return;
+	}
+	if(enabled){
+		this->updateRoiStatisticsRegions();
+	} else {
+		this->roiStatistics.clear();
+	}
+	this->roiStatisticsAnalyzer->setEnabled(enabled);
+	emit updateRequested();
+	emit roiStatisticsChanged(enabled);
+}
+
+void OverlayAnalysisController::updateRoiStatisticsRegions() {
+	//only area overlays enclose pixels, hidden overlays are not measured
+	QHash<QString, QPolygonF> regions;
+	for(const auto& overlay : this->view->getOverlays()){
+		if(overlay.first->isVisible() && (overlay.second == "Rect overlay" || overlay.second == "Polygon overlay" || overlay.second == "Circle overlay")){
+			regions.insert(overlay.second, this->view->overlayRegionInFrame(overlay.first));
+		}
+	}
+	this->roiStatisticsAnalyzer->setRegions(regions);
+}
+
+void OverlayAnalysisController::onRoiStatisticsMeasured(RoiStatisticsMap statistics) {
+	if(!this->roiStatisticsAnalyzer->isEnabled()){
+		return;
+	}
+	this->roiStatistics = statistics;
+	emit updateRequested();
+}
+
+StatisticsValues OverlayAnalysisController::getRoiStatisticsValues() const {
+	StatisticsValues values;
+	for(const auto& overlay : this->view->getOverlays()){
+		auto it = this->roiStatistics.constFind(overlay.second);
+		if(it != this->roiStatistics.constEnd() && it.value().valid){
+			values << qMakePair(overlay.second, QString("mean %1, SD %2, min %3, max %4, %5 px").arg(it.value().mean, 0, 'f', 1)
+				.arg(it.value().stdDev, 0, 'f', 1).arg(it.value().min).arg(it.value().max).arg(it.value().pixelCount));
+		}
+	}
+	return values;
+}
+
+void OverlayAnalysisController::drawRoiStatistics(QPainter* painter) {
+	QWidget* viewport = this->view->viewport();
+	for(const auto& overlay : this->view->getOverlays()){
+		auto it = this->roiStatistics.constFind(overlay.second);
+		if(it == this->roiStatistics.constEnd() || !it.value().valid || !overlay.first->isVisible()){
+			continue;
+		}
+		const RoiStatistics& statistics = it.value();
+
+		//box next to the top right corner of the overlay as it appears in the viewport, kept inside the viewport
+		QRect overlayRect = this->view->mapFromScene(overlay.first->sceneBoundingRect()).boundingRect();
+		QRect box(overlayRect.right() + 6, overlayRect.top(), 150, 58);
+		if(box.right() > viewport->width() - 4){
+			box.moveRight(overlayRect.left() - 6);
+		}
+		box.moveTop(qBound(4, box.top(), qMax(4, viewport->height() - box.height() - 4)));
+		painter->fillRect(box, QColor(0, 0, 0, 160));
+		painter->setPen(Qt::white);
+		painter->drawText(box.adjusted(6, 2, -6, -40), Qt::AlignLeft | Qt::AlignVCenter, tr("Mean %1  SD %2").arg(statistics.mean, 0, 'f', 1).arg(statistics.stdDev, 0, 'f', 1));
+		painter->drawText(box.adjusted(6, 18, -6, -24), Qt::AlignLeft | Qt::AlignVCenter, tr("Min %1  Max %2").arg(statistics.min).arg(statistics.max));
+
+		//histogram with 4 intensity values per column, scaled to the highest column
+		QRect histogramRect = box.adjusted(6, 36, -6, -4);
+		const int columns = 64;
+		quint32 columnSums[columns] = {};
+		quint32 highest = 1;
+		for(int i = 0; i < statistics.histogram.size(); i++){
+			columnSums[i*columns/statistics.histogram.size()] += statistics.histogram.at(i);
+		}
+		for(int i = 0; i < columns; i++){
+			highest = qMax(highest, columnSums[i]);
+		}
+		painter->fillRect(histogramRect, QColor(255, 255, 255, 40));
+		for(int i = 0; i < columns; i++){
+			int x0 = histogramRect.left() + i*histogramRect.width()/columns;
+			int x1 = histogramRect.left() + (i + 1)*histogramRect.width()/columns;
+			int h = static_cast<int>(static_cast<qint64>(columnSums[i])*histogramRect.height()/highest);
+			painter->fillRect(QRect(x0, histogramRect.bottom() + 1 - h, qMax(1, x1 - x0), h), QColor(255, 255, 255, 200));
+		}
+	}
+}
+
+void OverlayAnalysisController::setLineProfileEnabled(bool enabled) {
+	if(this->lineProfileAnalyzer->isEnabled() == enabled){
+		return;
+	}
+	if(enabled){
+		this->updateLineProfileLine();
+	} else {
+		this->lineProfile = LineProfile();
+	}
+	this->lineProfileAnalyzer->setEnabled(enabled);
+	emit lineProfileSettingsChanged();
+}
+
+void OverlayAnalysisController::setLineProfileWidth(int width) {
+	if(this->lineProfileAnalyzer->getAveragingWidth() == width){
+		return;
+	}
+	this->lineProfileAnalyzer->setAveragingWidth(width);
+	emit lineProfileSettingsChanged();
+}
+
+void OverlayAnalysisController::updateLineProfileLine() {
+	QLineF line;
+	OverlayItem* overlay = this->view->getOverlay("Line overlay");
+	if(overlay != nullptr && overlay->isVisible()){
+		QPolygonF outline = this->view->overlayOutlineInFrame(overlay);
+		if(outline.size() == 2){
+			line = QLineF(outline.at(0), outline.at(1));
+		}
+	}
+	this->lineProfileAnalyzer->setLine(line);
+	this->lineProfileAnalyzer->setLensModel(this->view->getDisplayLensModel());
+	//the plot shows a hint instead of a stale profile while the line overlay is hidden
+	if(line.isNull() && this->lineProfile.valid){
+		this->lineProfile = LineProfile();
+		emit lineProfileMeasured(this->lineProfile);
+	}
+}
+
+void OverlayAnalysisController::onLineProfileMeasured(LineProfile profile) {
+	//a profile of a line that was hidden in the meantime may still arrive
+	OverlayItem* overlay = this->view->getOverlay("Line overlay");
+	if(!this->lineProfileAnalyzer->isEnabled() || overlay == nullptr || !overlay->isVisible()){
+		return;
+	}
+	this->lineProfile = profile;
+	emit lineProfileMeasured(profile);
+}
+
+void OverlayAnalysisController::setPolarUnwrapEnabled(bool enabled) {
+	if(this->polarUnwrapper->isEnabled() == enabled){
+		return;
+	}
+	if(enabled){
+		this->updatePolarUnwrapCircle();
+	} else {
+		this->polarStripValid = false;
+	}
+	this->polarUnwrapper->setEnabled(enabled);
+	emit polarUnwrapSettingsChanged();
+}
+
+void OverlayAnalysisController::setPolarUnwrapBand(int percent) {
+	if(this->polarUnwrapper->getBand() == percent){
+		return;
+	}
+	this->polarUnwrapper->setBand(percent);
+	emit polarUnwrapSettingsChanged();
+}
+
+void OverlayAnalysisController::updatePolarUnwrapCircle() {
+	QPointF center;
+	QPointF peripheral;
+	OverlayItem* overlay = this->view->getOverlay("Circle overlay");
+	if(overlay != nullptr && overlay->isVisible()){
+		//the anchors are the center and a point on the circle
+		const auto& anchorPoints = overlay->getAnchorPoints();
+		if(anchorPoints.size() == 2){
+			center = this->view->scenePosInFrame(anchorPoints.at(0)->scenePos());
+			peripheral = this->view->scenePosInFrame(anchorPoints.at(1)->scenePos());
+		}
+	}
+	//the table of the unwrapper is only rebuilt if one of the anchors has moved
+	this->polarUnwrapper->setCircle(center, peripheral);
+	this->polarUnwrapper->setLensModel(this->view->getDisplayLensModel());
+	if(center == peripheral && this->polarStripValid){
+		this->polarStripValid = false;
+		emit polarStripMeasured(PolarStrip());
+	}
+}
+
+void OverlayAnalysisController::onPolarStripMeasured(PolarStrip strip) {
+	OverlayItem* overlay = this->view->getOverlay("Circle overlay");
+	if(!this->polarUnwrapper->isEnabled() || overlay == nullptr || !overlay->isVisible()){
+		return;
+	}
+	this->polarStripValid = true;
+	emit polarStripMeasured(strip);
+}
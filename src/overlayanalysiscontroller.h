@@ -0,0 +1,76 @@
+#ifndef OVERLAYANALYSISCONTROLLER_H
+#define OVERLAYANALYSISCONTROLLER_H
+
+#include <QObject>
+#include <QMenu>
+#include <QPainter>
+#include "roistatistics.h"
+#include "lineprofile.h"
+#include "polarunwrap.h"
+#include "frametapsurface.h"
+#include "statisticsview.h"
+
+class CameraViewWidget;
+
+
+//analysis stages that measure inside the overlays of a camera view: intensity statistics of the area overlays, the intensity profile along
+//the line overlay and the polar unwrap of the circle overlay. the controller keeps the regions of the stages in sync with the overlays,
+//adds their context menu entries, draws the statistics boxes and forwards the results
+class OverlayAnalysisController : public QObject
+{
+	Q_OBJECT
+public:
+	explicit OverlayAnalysisController(CameraViewWidget* view, FrameTapSurface* frameTap);
+	~OverlayAnalysisController();
+
+	bool isRoiStatisticsEnabled() const {return this->roiStatisticsAnalyzer->isEnabled();}
+	RoiStatisticsMap getRoiStatistics() const {return this->roiStatistics;}
+	StatisticsValues getRoiStatisticsValues() const;
+	bool isLineProfileEnabled() const {return this->lineProfileAnalyzer->isEnabled();}
+	int getLineProfileWidth() const {return this->lineProfileAnalyzer->getAveragingWidth();}
+	LineProfile getLineProfile() const {return this->lineProfile;}
+	bool isPolarUnwrapEnabled() const {return this->polarUnwrapper->isEnabled();}
+	int getPolarUnwrapBand() const {return this->polarUnwrapper->getBand();}
+
+	void addMenus(QMenu* menu);
+	//viewport coordinates, next to each measured overlay
+	void drawRoiStatistics(QPainter* painter);
+
+private:
+	CameraViewWidget* view;
+	RoiStatisticsAnalyzer* roiStatisticsAnalyzer;
+	RoiStatisticsMap roiStatistics;
+	LineProfileAnalyzer* lineProfileAnalyzer;
+	LineProfile lineProfile;
+	PolarUnwrapper* polarUnwrapper;
+	bool polarStripValid;
+
+	void updateRoiStatisticsRegions();
+	void updateLineProfileLine();
+	void updatePolarUnwrapCircle();
+
+public slots:
+	//regions of all enabled stages, called when overlays were moved, shown or hidden and when the frame size changed
+	void updateRegions();
+	void setRoiStatisticsEnabled(bool enabled);
+	void setLineProfileEnabled(bool enabled);
+	void setLineProfileWidth(int width);
+	void setPolarUnwrapEnabled(bool enabled);
+	void setPolarUnwrapBand(int percent);
+
+private slots:
+	void onRoiStatisticsMeasured(RoiStatisticsMap statistics);
+	void onLineProfileMeasured(LineProfile profile);
+	void onPolarStripMeasured(PolarStrip strip);
+
+signals:
+	void roiStatisticsChanged(bool enabled);
+	void lineProfileSettingsChanged();
+	void lineProfileMeasured(LineProfile profile);
+	void polarUnwrapSettingsChanged();
+	void polarStripMeasured(PolarStrip strip);
+	//the statistics boxes have to be redrawn
+	void updateRequested();
+};
+
+#endif //OVERLAYANALYSISCONTROLLER_H
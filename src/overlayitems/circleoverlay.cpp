@@ -26,6 +26,13 @@ QRectF CircleOverlay::boundingRect() const {
 void CircleOverlay::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
 	Q_UNUSED(option)
 	Q_UNUSED(widget)
+	paintShape(painter, this->getAnchorPositions(), this->penWidth);
+}
+
+void CircleOverlay::paintShape(QPainter* painter, const QVector<QPointF>& anchors, qreal penWidth) {
+	if(anchors.size() < 2){
+		return;
+	}
 
 	painter->setRenderHint(QPainter::Antialiasing, true);
 	QColor fillColor(255, 0, 0, 128);
@@ -34,6 +41,24 @@ void CircleOverlay::paint(QPainter *painter, const QStyleOptionGraphicsItem *opt
 	QPen pen(outlineColor, penWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
 	painter->setPen(pen);
 
+	//first anchor is the center, second one is on the circle
+	qreal radius = QLineF(anchors.at(0), anchors.at(1)).length();
+	painter->drawEllipse(anchors.at(0), radius, radius);
+}
+
+OverlayItem::ShapePainter CircleOverlay::getShapePainter() const {
+	qreal penWidth = this->penWidth;
+	return [penWidth](QPainter* painter, const QVector<QPointF>& anchors) { paintShape(painter, anchors, penWidth); };
+}
+
+QPolygonF CircleOverlay::getOutline() const {
+	//approximate circle by a regular polygon, fine enough for region of interest rasterization
+	const int segments = 64;
 	qreal radius = QLineF(centerAnchor->pos(), peripheralAnchor->pos()).length();
-	painter->drawEllipse(centerAnchor->pos(), radius, radius);
+	QPolygonF outline;
+	for(int i = 0; i < segments; i++){
+		qreal angle = 2.0*M_PI*i/segments;
+		outline << this->centerAnchor->pos() + QPointF(radius*qCos(angle), radius*qSin(angle));
+	}
+	return outline;
 }
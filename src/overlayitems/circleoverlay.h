@@ -12,6 +12,10 @@ public:
 
 	QRectF boundingRect() const override;
 	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+	QPolygonF getOutline() const override;
+	ShapePainter getShapePainter() const override;
+
+	static void paintShape(QPainter* painter, const QVector<QPointF>& anchors, qreal penWidth);
 
 private:
 	AnchorPoint *centerAnchor;
@@ -34,17 +34,32 @@ QRectF LineOverlay::boundingRect() const {
 void LineOverlay::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
 	Q_UNUSED(option)
 	Q_UNUSED(widget)
+	paintShape(painter, this->getAnchorPositions(), this->penWidth);
+}
 
-	QPointF startPoint = startAnchor->scenePos();
-	QPointF endPoint = endAnchor->scenePos();
+void LineOverlay::paintShape(QPainter* painter, const QVector<QPointF>& anchors, qreal penWidth) {
+	if(anchors.size() < 2){
+		return;
+	}
 
 	painter->setRenderHint(QPainter::Antialiasing, true);
 	QColor lineColor(255, 0, 0, 128);
-	QPen pen(lineColor, this->penWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+	QPen pen(lineColor, penWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
 	painter->setPen(pen);
 
-	painter->drawLine(startAnchor->pos(), endAnchor->pos());
+	painter->drawLine(anchors.at(0), anchors.at(1));
+}
+
+OverlayItem::ShapePainter LineOverlay::getShapePainter() const {
+	qreal penWidth = this->penWidth;
+	return [penWidth](QPainter* painter, const QVector<QPointF>& anchors) { paintShape(painter, anchors, penWidth); };
 }
 
 void LineOverlay::adjustAnchors() {
 	update(boundingRect());}
+
+QPolygonF LineOverlay::getOutline() const {
+	QPolygonF outline;
+	outline << this->startAnchor->pos() << this->endAnchor->pos();
+	return outline;
+}
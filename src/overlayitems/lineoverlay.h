@@ -11,6 +11,10 @@ public:
 	//override QGraphicsItem methods
 	QRectF boundingRect() const override;
 	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+	QPolygonF getOutline() const override;
+	ShapePainter getShapePainter() const override;
+
+	static void paintShape(QPainter* painter, const QVector<QPointF>& anchors, qreal penWidth);
 
 	//additional functionality for line overlay
 	void adjustAnchors();
@@ -21,6 +21,25 @@ void OverlayItem::onAnchorPointPositionChanged() {
 	emit this->positionChanged(this);
 }
 
+QVector<QPointF> OverlayItem::getAnchorPositions() const {
+	QVector<QPointF> positions;
+	positions.reserve(this->anchorPoints.size());
+	for (const AnchorPoint* anchor : this->anchorPoints) {
+		positions.append(anchor->pos());
+	}
+	return positions;
+}
+
+QVector<QPointF> OverlayItem::anchorPositionsFromState(const QVariantMap& state) {
+	QVector<QPointF> positions;
+	const QVariantList anchorsList = state["anchors"].toList();
+	for (const QVariant& data : anchorsList) {
+		QVariantMap anchorData = data.toMap();
+		positions.append(QPointF(anchorData["x"].toReal(), anchorData["y"].toReal()));
+	}
+	return positions;
+}
+
 QVariantMap OverlayItem::saveState() const {
 	QVariantMap state;
 	QVariantList anchorsList;
@@ -3,6 +3,8 @@
 
 #include <QGraphicsItem>
 #include <QGraphicsSceneMouseEvent>
+#include <QPolygonF>
+#include <functional>
 #include "anchorpoint.h"
 
 class OverlayItem : public QObject,  public QGraphicsItem {
@@ -13,12 +15,23 @@ public:
 
 	virtual QRectF boundingRect() const override = 0;
 	virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override = 0;
+	//outline of the overlay shape in item coordinates. area overlays return a closed polygon, the line overlay returns its two end points
+	virtual QPolygonF getOutline() const = 0;
+
+	//draws the overlay shape for the given anchor positions (in the order of getAnchorPoints()). the returned function does not reference the item,
+	//so it can be used on worker threads and after the item has been deleted, e.g. to burn overlays into snapshots
+	typedef std::function<void(QPainter*, const QVector<QPointF>&)> ShapePainter;
+	virtual ShapePainter getShapePainter() const = 0;
+
+	//anchor positions of a state created by saveState()
+	static QVector<QPointF> anchorPositionsFromState(const QVariantMap& state);
 
 	QVariantMap saveState() const;
 	void loadState(const QVariantMap& state);
 
 	void addAnchorPoint(AnchorPoint *anchor);
 	QList<AnchorPoint *> getAnchorPoints() const { return this->anchorPoints; }
+	QVector<QPointF> getAnchorPositions() const;
 
 	QString getName() const { return this->name; }
 	void setName(const QString &name) { this->name = name; }
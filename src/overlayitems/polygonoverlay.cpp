@@ -34,14 +34,32 @@ QRectF PolygonOverlay::boundingRect() const {
 void PolygonOverlay::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
 	Q_UNUSED(option)
 	Q_UNUSED(widget)
+	paintShape(painter, this->getAnchorPositions(), this->penWidth);
+}
+
+void PolygonOverlay::paintShape(QPainter* painter, const QVector<QPointF>& anchors, qreal penWidth) {
+	if(anchors.size() < 4){
+		return;
+	}
 
 	painter->setRenderHint(QPainter::Antialiasing, true);
 	QColor polygonColor(255, 0, 0, 128);
 	QPen pen(polygonColor, penWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
 	painter->setPen(pen);
 
-	//draw the polygon based on the anchor positions
+	//draw the polygon based on the anchor positions (first, second, fourth, third corner)
 	QPolygonF polygon;
-	polygon << firstCorner->pos() << secondCorner->pos() << fourthCorner->pos() << thirdCorner->pos();
+	polygon << anchors.at(0) << anchors.at(1) << anchors.at(3) << anchors.at(2);
 	painter->drawPolygon(polygon);
 }
+
+OverlayItem::ShapePainter PolygonOverlay::getShapePainter() const {
+	qreal penWidth = this->penWidth;
+	return [penWidth](QPainter* painter, const QVector<QPointF>& anchors) { paintShape(painter, anchors, penWidth); };
+}
+
+QPolygonF PolygonOverlay::getOutline() const {
+	QPolygonF outline;
+	outline << firstCorner->pos() << secondCorner->pos() << fourthCorner->pos() << thirdCorner->pos();
+	return outline;
+}
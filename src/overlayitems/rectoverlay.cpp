@@ -32,14 +32,30 @@ QRectF RectOverlay::boundingRect() const {
 void RectOverlay::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
 	Q_UNUSED(option)
 	Q_UNUSED(widget)
+	paintShape(painter, this->getAnchorPositions(), this->penWidth);
+}
+
+void RectOverlay::paintShape(QPainter* painter, const QVector<QPointF>& anchors, qreal penWidth) {
+	if(anchors.size() < 2){
+		return;
+	}
 
 	//set painting properties
 	painter->setRenderHint(QPainter::Antialiasing, true);
 	QColor rectColor(255, 0, 0, 128);
-	QPen pen(rectColor, this->penWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+	QPen pen(rectColor, penWidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
 	painter->setPen(pen);
 
 	//sraw the rectangle based on the anchor positions
-	QRectF rect = QRectF(this->topLeftAnchor->pos(), this->bottomRightAnchor->pos()).normalized();
+	QRectF rect = QRectF(anchors.at(0), anchors.at(1)).normalized();
 	painter->drawRect(rect);
 }
+
+OverlayItem::ShapePainter RectOverlay::getShapePainter() const {
+	qreal penWidth = this->penWidth;
+	return [penWidth](QPainter* painter, const QVector<QPointF>& anchors) { paintShape(painter, anchors, penWidth); };
+}
+
+QPolygonF RectOverlay::getOutline() const {
+	return QPolygonF(QRectF(this->topLeftAnchor->pos(), this->bottomRightAnchor->pos()).normalized());
+}
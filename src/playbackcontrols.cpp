@@ -0,0 +1,93 @@
+#include "playbackcontrols.h"
+#include <QStyle>
+
+
+PlaybackControls::PlaybackControls(QWidget *parent)
+	: QWidget(parent),
+	layout(new QHBoxLayout(this)),
+	playButton(new QToolButton(this)),
+	slider(new QSlider(Qt::Horizontal, this)),
+	positionLabel(new QLabel(this)),
+	speedComboBox(new QComboBox(this))
+{
+	this->playButton->setAutoRaise(true);
+	this->playButton->setToolTip(tr("Play/pause (Space)"));
+	this->updatePlayButton(false);
+	this->slider->setToolTip(tr("Position (Left/Right: step one frame, Shift: ten frames)"));
+	this->positionLabel->setMinimumWidth(this->positionLabel->fontMetrics().horizontalAdvance("0000000/0000000  00:00:00.000"));
+	const QList<qreal> speeds = {0.1, 0.25, 0.5, 1.0, 2.0, 4.0, 8.0};
+	for(qreal speed : speeds){
+		this->speedComboBox->addItem(QString("%1x").arg(speed), speed);
+	}
+	this->speedComboBox->setCurrentIndex(speeds.indexOf(1.0));
+	this->speedComboBox->setToolTip(tr("Playback speed"));
+
+	this->layout->setContentsMargins(0, 0, 0, 0);
+	this->layout->addWidget(this->playButton);
+	this->layout->addWidget(this->slider, 1);
+	this->layout->addWidget(this->positionLabel);
+	this->layout->addWidget(this->speedComboBox);
+
+	connect(this->playButton, &QToolButton::clicked, this, [this]() {
+		if(!this->source.isNull()){
+			this->source->setPlaying(!this->source->isPlaying());
+		}
+	});
+	//the slider tracks, so scrubbing seeks continuously. frames that are not decoded in time are skipped by the source
+	connect(this->slider, &QSlider::valueChanged, this, [this](int value) {
+		if(!this->source.isNull()){
+			this->source->seek(static_cast<quint64>(value));
+		}
+	});
+	connect(this->speedComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, [this](int index) {
+		if(!this->source.isNull()){
+			this->source->setSpeed(this->speedComboBox->itemData(index).toReal());
+		}
+	});
+}
+
+PlaybackControls::~PlaybackControls() {
+}
+
+void PlaybackControls::setSource(PlaybackSource* source) {
+	if(!this->source.isNull()){
+		disconnect(this->source, nullptr, this, nullptr);
+	}
+	this->source = source;
+	if(source != nullptr){
+		connect(source, &PlaybackSource::positionChanged, this, &PlaybackControls::updatePosition);
+		connect(source, &PlaybackSource::playingChanged, this, &PlaybackControls::updatePlayButton);
+		source->setSpeed(this->speedComboBox->currentData().toReal());
+	}
+	this->updateRange();
+}
+
+void PlaybackControls::updateRange() {
+	quint64 frameCount = this->source.isNull() ? 0 : this->source->getFrameCount();
+	QSignalBlocker blocker(this->slider);
+	this->slider->setRange(0, static_cast<int>(qMax(Q_UINT64_C(1), frameCount) - 1));
+	this->slider->setPageStep(qMax(1, this->slider->maximum()/20));
+	this->updatePosition(this->source.isNull() ? 0 : this->source->getPosition());
+	this->updatePlayButton(!this->source.isNull() && this->source->isPlaying());
+}
+
+void PlaybackControls::updatePosition(quint64 frameNr) {
+	quint64 frameCount = this->source.isNull() ? 0 : this->source->getFrameCount();
+	qint64 timestamp = this->source.isNull() ? 0 : this->source->getFrameTimestamp(frameNr);
+	this->positionLabel->setText(QString("%1/%2  %3").arg(frameNr + 1).arg(frameCount).arg(this->formatTime(timestamp)));
+
+	//the slider is not moved while the user drags it, the shown frame may lag behind during scrubbing
+	if(!this->slider->isSliderDown()){
+		QSignalBlocker blocker(this->slider);
+		this->slider->setValue(static_cast<int>(frameNr));
+	}
+}
+
+void PlaybackControls::updatePlayButton(bool playing) {
+	this->playButton->setIcon(this->style()->standardIcon(playing ? QStyle::SP_MediaPause : QStyle::SP_MediaPlay));
+}
+
+QString PlaybackControls::formatTime(qint64 us) const {
+	qint64 ms = us/1000;
+	return QString("%1:%2:%3.%4").arg(ms/3600000, 2, 10, QChar('0')).arg((ms/60000)%60, 2, 10, QChar('0')).arg((ms/1000)%60, 2, 10, QChar('0')).arg(ms%1000, 3, 10, QChar('0'));
+}
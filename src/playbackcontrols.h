@@ -0,0 +1,42 @@
+#ifndef PLAYBACKCONTROLS_H
+#define PLAYBACKCONTROLS_H
+
+#include <QWidget>
+#include <QToolButton>
+#include <QSlider>
+#include <QLabel>
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QPointer>
+#include "playbacksource.h"
+
+
+//transport bar for a PlaybackSource: play/pause, frame accurate position slider, position display and playback speed
+class PlaybackControls : public QWidget {
+	Q_OBJECT
+
+public:
+	explicit PlaybackControls(QWidget *parent = nullptr);
+	~PlaybackControls();
+
+	void setSource(PlaybackSource* source);
+
+public slots:
+	void updateRange();
+
+private:
+	QPointer<PlaybackSource> source;
+	QHBoxLayout* layout;
+	QToolButton* playButton;
+	QSlider* slider;
+	QLabel* positionLabel;
+	QComboBox* speedComboBox;
+
+	QString formatTime(qint64 us) const;
+
+private slots:
+	void updatePosition(quint64 frameNr);
+	void updatePlayButton(bool playing);
+};
+
+#endif //PLAYBACKCONTROLS_H
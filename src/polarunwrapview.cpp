@@ -0,0 +1,91 @@
+#include "polarunwrapview.h"
+#include <QPainter>
+#include <QMouseEvent>
+
+#define STRIP_MARGIN_LEFT 36
+#define STRIP_MARGIN_RIGHT 8
+#define STRIP_MARGIN_BOTTOM 18
+
+
+PolarUnwrapView::PolarUnwrapView(QWidget *parent)
+	: DetachablePanel(parent),
+	cursor(-1, -1)
+{
+	this->setWindowTitle(tr("Polar unwrap"));
+	this->setMinimumHeight(100);
+	this->setMouseTracking(true);
+}
+
+PolarUnwrapView::~PolarUnwrapView() {
+}
+
+void PolarUnwrapView::setStrip(PolarStrip strip) {
+	this->strip = strip;
+	this->update();
+}
+
+QRect PolarUnwrapView::stripRect() const {
+	return this->rect().adjusted(STRIP_MARGIN_LEFT, TITLE_HEIGHT, -STRIP_MARGIN_RIGHT, -STRIP_MARGIN_BOTTOM);
+}
+
+void PolarUnwrapView::paintEvent(QPaintEvent* event) {
+	Q_UNUSED(event)
+	QPainter painter(this);
+	painter.fillRect(this->rect(), QColor(30, 30, 30));
+	QRect area = this->stripRect();
+	QRect titleRect = this->titleRect().adjusted(STRIP_MARGIN_LEFT - 4, 0, 0, 0);
+	if(area.width() < 2 || area.height() < 2){
+		return;
+	}
+	painter.setPen(Qt::white);
+	if(!this->strip.valid || this->strip.image.isNull()){
+		painter.drawText(titleRect, Qt::AlignLeft | Qt::AlignVCenter, tr("Show the circle overlay to unwrap it"));
+		return;
+	}
+	painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+	painter.drawImage(area, this->strip.image);
+
+	//radius axis, the overlay radius is marked with a dashed line
+	const double radiusRange = this->strip.outerRadius - this->strip.innerRadius;
+	auto yOf = [&](double radius) {return qRound(area.top() + (radius - this->strip.innerRadius)*(area.height() - 1)/radiusRange);};
+	painter.setPen(QColor(150, 150, 150));
+	painter.drawText(QRect(0, area.top() - 8, STRIP_MARGIN_LEFT - 4, 16), Qt::AlignRight | Qt::AlignVCenter, QString::number(this->strip.innerRadius, 'f', 0));
+	painter.drawText(QRect(0, area.bottom() - 8, STRIP_MARGIN_LEFT - 4, 16), Qt::AlignRight | Qt::AlignVCenter, QString::number(this->strip.outerRadius, 'f', 0));
+	painter.setPen(QPen(QColor(255, 200, 0, 160), 1, Qt::DashLine));
+	painter.drawLine(area.left(), yOf(this->strip.radius), area.right(), yOf(this->strip.radius));
+
+	//angle axis with ticks every 90 degrees
+	for(int angle = 0; angle <= 360; angle += 90){
+		int x = area.left() + angle*(area.width() - 1)/360;
+		painter.setPen(QColor(150, 150, 150));
+		painter.drawLine(x, area.bottom() + 1, x, area.bottom() + 4);
+		int align = angle == 0 ? Qt::AlignLeft : (angle == 360 ? Qt::AlignRight : Qt::AlignHCenter);
+		painter.drawText(QRect(x - 30, area.bottom() + 2, 60, STRIP_MARGIN_BOTTOM - 2).intersected(QRect(area.left(), 0, area.width(), this->height())),
+			align | Qt::AlignVCenter, QString("%1°").arg(angle));
+	}
+
+	QString title = tr("Radius %1 px, unwrapped from %2 to %3 px").arg(this->strip.radius, 0, 'f', 1)
+		.arg(this->strip.innerRadius, 0, 'f', 0).arg(this->strip.outerRadius, 0, 'f', 0);
+	if(area.contains(this->cursor)){
+		const QImage& image = this->strip.image;
+		int column = qBound(0, (this->cursor.x() - area.left())*image.width()/area.width(), image.width() - 1);
+		int row = qBound(0, (this->cursor.y() - area.top())*image.height()/area.height(), image.height() - 1);
+		double angle = 360.0*(column + 0.5)/image.width();
+		double radius = this->strip.innerRadius + row*radiusRange/qMax(1, image.height() - 1);
+		title = tr("%1°, %2 px: %3").arg(angle, 0, 'f', 1).arg(radius, 0, 'f', 1).arg(image.constScanLine(row)[column]);
+	}
+	painter.setPen(Qt::white);
+	painter.drawText(titleRect, Qt::AlignLeft | Qt::AlignVCenter, title);
+}
+
+void PolarUnwrapView::mouseMoveEvent(QMouseEvent* event) {
+	this->cursor = event->pos();
+	this->update();
+	QWidget::mouseMoveEvent(event);
+}
+
+void PolarUnwrapView::leaveEvent(QEvent* event) {
+	this->cursor = QPoint(-1, -1);
+	this->update();
+	QWidget::leaveEvent(event);
+}
@@ -0,0 +1,34 @@
+#ifndef POLARUNWRAPVIEW_H
+#define POLARUNWRAPVIEW_H
+
+#include "detachablepanel.h"
+#include "polarunwrap.h"
+
+
+//shows the unwrapped band around the circle overlay, stretched to the size of the panel. the dashed line marks the radius of the overlay,
+//the cursor position is shown as angle, radius and intensity
+class PolarUnwrapView : public DetachablePanel {
+	Q_OBJECT
+
+public:
+	explicit PolarUnwrapView(QWidget *parent = nullptr);
+	~PolarUnwrapView();
+
+	QSize sizeHint() const override {return QSize(400, 160);}
+
+public slots:
+	void setStrip(PolarStrip strip);
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+	void mouseMoveEvent(QMouseEvent* event) override;
+	void leaveEvent(QEvent* event) override;
+
+private:
+	PolarStrip strip;
+	QPoint cursor;
+
+	QRect stripRect() const;
+};
+
+#endif //POLARUNWRAPVIEW_H
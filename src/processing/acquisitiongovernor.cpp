@@ -0,0 +1,144 @@
+#include "acquisitiongovernor.h"
+#include "workstealingpool.h"
+#include <QStringList>
+#include <QRegExp>
+#include <algorithm>
+
+
+AcquisitionGovernor::AcquisitionGovernor(QObject *parent)
+	: QObject(parent),
+	  evaluationTimer(new QTimer(this)),
+	  rawBuffers(0),
+	  processedBuffers(0),
+	  lastBufferTime(0),
+	  lastRawBuffers(0),
+	  lastProcessedBuffers(0),
+	  lastEvaluationTime(0),
+	  buffersSinceIdle(0)
+{
+	this->clock.start();
+	this->evaluationTimer->setInterval(EVALUATION_INTERVAL_MS);
+	connect(this->evaluationTimer, &QTimer::timeout, this, &AcquisitionGovernor::evaluate);
+}
+
+AcquisitionGovernor::~AcquisitionGovernor() {
+	this->policy.acquisitionActive = false;
+	this->applyPolicy();
+}
+
+void AcquisitionGovernor::notifyRawData() {
+	this->rawBuffers.fetchAndAddRelaxed(1);
+	this->lastBufferTime.storeRelease(this->clock.elapsed());
+}
+
+void AcquisitionGovernor::notifyProcessedData() {
+	this->processedBuffers.fetchAndAddRelaxed(1);
+	this->lastBufferTime.storeRelease(this->clock.elapsed());
+}
+
+void AcquisitionGovernor::setExtensionActive(bool active) {
+	if(active){
+		this->lastRawBuffers = this->rawBuffers.loadAcquire();
+		this->lastProcessedBuffers = this->processedBuffers.loadAcquire();
+		this->lastEvaluationTime = this->clock.elapsed();
+		this->buffersSinceIdle = 0;
+		this->evaluationTimer->start();
+	} else {
+		//OCTproZ does not send data to inactive extensions, so acquisition can not be detected anymore
+		this->evaluationTimer->stop();
+		this->setAcquisitionActive(false);
+	}
+}
+
+void AcquisitionGovernor::setSettings(const GovernorSettings& settings) {
+	this->settings = settings;
+	this->applyPolicy();
+	emit settingsChanged();
+}
+
+void AcquisitionGovernor::evaluate() {
+	qint64 now = this->clock.elapsed();
+	quint64 raw = this->rawBuffers.loadAcquire();
+	quint64 processed = this->processedBuffers.loadAcquire();
+	double seconds = qMax(Q_INT64_C(1), now - this->lastEvaluationTime)/1000.0;
+
+	//rates are smoothed, a single late buffer does not change the state
+	const double smoothing = 0.5;
+	this->policy.rawBufferRate = smoothing*this->policy.rawBufferRate + (1.0 - smoothing)*(raw - this->lastRawBuffers)/seconds;
+	this->policy.processedBufferRate = smoothing*this->policy.processedBufferRate + (1.0 - smoothing)*(processed - this->lastProcessedBuffers)/seconds;
+	this->buffersSinceIdle += (raw - this->lastRawBuffers) + (processed - this->lastProcessedBuffers);
+	this->lastRawBuffers = raw;
+	this->lastProcessedBuffers = processed;
+	this->lastEvaluationTime = now;
+
+	double bufferRate = qMax(this->policy.rawBufferRate, this->policy.processedBufferRate);
+	qint64 timeout = MIN_ACQUISITION_TIMEOUT_MS;
+	if(bufferRate > 0.0){
+		timeout = qMax(timeout, static_cast<qint64>(4000.0/bufferRate));
+	}
+	bool receiving = this->buffersSinceIdle > 0 && now - this->lastBufferTime.loadAcquire() < timeout;
+	if(!receiving){
+		this->buffersSinceIdle = 0;
+	}
+	bool acquiring = receiving && this->buffersSinceIdle >= MIN_BUFFERS_TO_ACTIVATE;
+	this->setAcquisitionActive(acquiring);
+}
+
+void AcquisitionGovernor::setAcquisitionActive(bool active) {
+	if(this->policy.acquisitionActive == active){
+		return;
+	}
+	this->policy.acquisitionActive = active;
+	this->applyPolicy();
+	emit acquisitionStateChanged(active);
+}
+
+void AcquisitionGovernor::applyPolicy() {
+	bool acquisitionActive = this->policy.acquisitionActive && this->settings.enabled;
+	int displayInterval = acquisitionActive && this->settings.displayRateLimit > 0 ? 1000/this->settings.displayRateLimit : 0;
+	QThread::Priority priority = acquisitionActive && this->settings.idlePriority ? QThread::IdlePriority : QThread::LowPriority;
+	QList<int> excludedCores = acquisitionActive ? this->settings.excludedCores : QList<int>();
+
+	WorkStealingPool* pool = WorkStealingPool::globalInstance();
+	if(pool->getThreadPriority() != priority){
+		pool->setThreadPriority(priority);
+	}
+	pool->setExcludedCores(excludedCores);
+	this->policy.workerPriority = priority;
+	this->policy.excludedCores = excludedCores;
+	if(this->policy.displayInterval != displayInterval){
+		this->policy.displayInterval = displayInterval;
+		emit displayIntervalChanged(displayInterval);
+	}
+}
+
+QList<int> AcquisitionGovernor::coresFromString(const QString& cores) {
+	QList<int> result;
+	const QStringList parts = cores.split(QRegExp("[,;\\s]+"), QString::SkipEmptyParts);
+	for(const QString& part : parts){
+		//ranges like 2-5 are expanded
+		QStringList range = part.split('-');
+		bool firstValid = false;
+		bool lastValid = false;
+		int first = range.first().toInt(&firstValid);
+		int last = range.size() == 2 ? range.last().toInt(&lastValid) : first;
+		if(!firstValid || (range.size() == 2 && !lastValid) || range.size() > 2){
+			continue;
+		}
+		for(int core = qMax(0, first); core <= last && core < 1024; core++){
+			if(!result.contains(core)){
+				result.append(core);
+			}
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+QString AcquisitionGovernor::coresToString(const QList<int>& cores) {
+	QStringList parts;
+	for(int core : cores){
+		parts.append(QString::number(core));
+	}
+	return parts.join(",");
+}
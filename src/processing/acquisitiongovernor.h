@@ -0,0 +1,82 @@
+#ifndef ACQUISITIONGOVERNOR_H
+#define ACQUISITIONGOVERNOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+#include <QList>
+#include <QThread>
+
+
+struct GovernorSettings {
+	bool enabled = true;
+	int displayRateLimit = 10; //fps while OCTproZ acquires, 0 = no limit
+	bool idlePriority = true; //analysis workers only get cpu time nobody else needs while OCTproZ acquires
+	QList<int> excludedCores; //cpu cores the workers must not use while OCTproZ acquires
+};
+
+struct GovernorPolicy {
+	bool acquisitionActive = false; //detected from the buffers, independent of whether the governor is enabled
+	double rawBufferRate = 0.0; //buffers per second
+	double processedBufferRate = 0.0;
+	int displayInterval = 0; //ms, 0 = every frame is displayed
+	QThread::Priority workerPriority = QThread::LowPriority;
+	QList<int> excludedCores;
+};
+
+//detects whether OCTproZ is acquiring from the cadence of the raw and processed data buffers and reduces the load of the camera views while it does:
+//the display rate of the views is limited, the analysis workers run at idle priority and optionally keep off the configured cpu cores.
+//everything is restored once no buffer arrived for a while or the extension is deactivated. recording and analysis keep getting every frame
+class AcquisitionGovernor : public QObject
+{
+	Q_OBJECT
+public:
+	explicit AcquisitionGovernor(QObject *parent = nullptr);
+	~AcquisitionGovernor();
+
+	//called for every buffer, thread safe and cheap
+	void notifyRawData();
+	void notifyProcessedData();
+
+	void setSettings(const GovernorSettings& settings);
+	GovernorSettings getSettings() const {return this->settings;}
+	GovernorPolicy getPolicy() const {return this->policy;}
+	bool isAcquisitionActive() const {return this->policy.acquisitionActive;}
+
+	static QList<int> coresFromString(const QString& cores);
+	static QString coresToString(const QList<int>& cores);
+
+	static const int EVALUATION_INTERVAL_MS = 250;
+	static const int MIN_ACQUISITION_TIMEOUT_MS = 1000; //acquisition is considered stopped if no buffer arrived for max(this, 4 buffer intervals)
+	static const int MIN_BUFFERS_TO_ACTIVATE = 3;
+
+private:
+	GovernorSettings settings;
+	GovernorPolicy policy;
+	QTimer* evaluationTimer;
+	QElapsedTimer clock;
+	QAtomicInteger<quint64> rawBuffers;
+	QAtomicInteger<quint64> processedBuffers;
+	QAtomicInteger<qint64> lastBufferTime;
+	quint64 lastRawBuffers;
+	quint64 lastProcessedBuffers;
+	qint64 lastEvaluationTime;
+	quint64 buffersSinceIdle;
+
+	void setAcquisitionActive(bool active);
+	void applyPolicy();
+
+public slots:
+	void setExtensionActive(bool active);
+
+private slots:
+	void evaluate();
+
+signals:
+	void displayIntervalChanged(int ms);
+	void acquisitionStateChanged(bool active);
+	void settingsChanged();
+};
+
+#endif //ACQUISITIONGOVERNOR_H
@@ -0,0 +1,431 @@
+#include "demosaic.h"
+#include "workstealingpool.h"
+#include "simd.h"
+#include <QElapsedTimer>
+#include <cstring>
+
+
+namespace {
+	//position of the pattern relative to RGGB. the colour of a sample at (x, y) is the RGGB colour at (x + xOffset, y + yOffset)
+	struct PatternLayout {
+		int xOffset;
+		int yOffset;
+		bool swapRedBlue;
+	};
+
+	PatternLayout layoutOf(int pattern) {
+		switch(pattern){
+			case Demosaic::BGGR: return {0, 0, true};
+			case Demosaic::GRBG: return {1, 0, false};
+			case Demosaic::GBRG: return {0, 1, false};
+			default: return {0, 0, false};
+		}
+	}
+
+	//mirrors at the border without repeating the border sample, which keeps the colour of the mirrored sample
+	inline int reflect(int i, int n) {
+		if(i < 0){
+			i = -i;
+		}
+		if(i >= n){
+			i = 2*n - 2 - i;
+		}
+		return qBound(0, i, n - 1);
+	}
+
+	//the scalar kernel uses the same rounding as the SSE2 instructions, so both paths produce identical images
+	inline int avg(int a, int b) {
+		return (a + b + 1) >> 1;
+	}
+
+	inline int addSaturated(int a, int b) {
+		return qMin(255, a + b);
+	}
+
+	inline int applyGain(int value, int gain) {
+		return qMin(255, (value*gain) >> 8);
+	}
+
+	//direction of the smaller gradient, both gradients equal falls back to the average of all four neighbours
+	inline int directionalGreen(int horizontal, int vertical, int cross, int gradientH, int gradientV) {
+		if(gradientV > gradientH){
+			return horizontal;
+		}
+		if(gradientH > gradientV){
+			return vertical;
+		}
+		return cross;
+	}
+
+#ifdef CAMERAEXTENSION_SSE2
+	inline __m128i load(const quint8* p) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	}
+
+	inline __m128i absDiff(__m128i a, __m128i b) {
+		return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+	}
+
+	inline __m128i blend(__m128i mask, __m128i a, __m128i b) {
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	inline __m128i gain16(__m128i value, __m128i gain) {
+		//the byte in the upper half of a 16 bit lane is value*256, the upper half of the product is (value*gain) >> 8
+		const __m128i zero = _mm_setzero_si128();
+		__m128i lo = _mm_mulhi_epu16(_mm_unpacklo_epi8(zero, value), gain);
+		__m128i hi = _mm_mulhi_epu16(_mm_unpackhi_epi8(zero, value), gain);
+		return _mm_packus_epi16(lo, hi);
+	}
+#endif
+}
+
+
+bool DemosaicSettings::operator==(const DemosaicSettings& other) const {
+	return this->pattern == other.pattern
+		&& this->method == other.method
+		&& qFuzzyCompare(this->redGain, other.redGain)
+		&& qFuzzyCompare(this->blueGain, other.blueGain)
+		&& this->bitDepth == other.bitDepth
+		&& this->saveRawSnapshots == other.saveRawSnapshots;
+}
+
+
+Demosaic::Demosaic()
+	: lastProcessingTimeUs(-1)
+{
+}
+
+void Demosaic::setSettings(const DemosaicSettings& settings) {
+	QMutexLocker locker(&this->mutex);
+	this->settings = settings;
+}
+
+DemosaicSettings Demosaic::getSettings() const {
+	QMutexLocker locker(&this->mutex);
+	return this->settings;
+}
+
+QStringList Demosaic::patternNames() {
+	return QStringList() << "RGGB" << "BGGR" << "GRBG" << "GBRG";
+}
+
+QStringList Demosaic::methodNames() {
+	return QStringList() << QObject::tr("Fast (bilinear)") << QObject::tr("Edge-aware");
+}
+
+int Demosaic::fixedPointGain(qreal gain) {
+	//at most 16, so gain*256 fits into the upper half of a 16 bit lane
+	return qBound(0, qRound(gain*GAIN_ONE), 16*GAIN_ONE);
+}
+
+QImage Demosaic::takeOutputBuffer(const QSize& size) {
+	for(int i = 0; i < this->outputBuffers.size(); i++){
+		if(this->outputBuffers.at(i).size() == size && this->outputBuffers.at(i).isDetached()){
+			return this->outputBuffers.takeAt(i);
+		}
+	}
+	return QImage(size, QImage::Format_RGB32);
+}
+
+void Demosaic::recycleOutputBuffer(const QImage& buffer) {
+	this->outputBuffers.append(buffer);
+	while(this->outputBuffers.size() > OUTPUT_BUFFERS){
+		this->outputBuffers.removeFirst();
+	}
+}
+
+QVideoFrame Demosaic::process(const QVideoFrame& frame) {
+	if(!isRawFormat(frame.pixelFormat())){
+		return QVideoFrame();
+	}
+	DemosaicSettings currentSettings = this->getSettings();
+	QElapsedTimer timer;
+	timer.start();
+	QImage output = this->takeOutputBuffer(frame.size());
+	bool converted = convert(frame, currentSettings, output, this->reducedMosaic);
+	//the frame shares the buffer with the list, the buffer becomes reusable as soon as the display drops the frame
+	this->recycleOutputBuffer(output);
+	if(!converted){
+		return QVideoFrame();
+	}
+	this->lastProcessingTimeUs.storeRelease(static_cast<int>(timer.nsecsElapsed()/1000));
+	return QVideoFrame(output);
+}
+
+QImage Demosaic::toImage(const QVideoFrame& frame, const DemosaicSettings& settings) {
+	QImage image(frame.size(), QImage::Format_RGB32);
+	QByteArray reducedMosaic;
+	if(!convert(frame, settings, image, reducedMosaic)){
+		return QImage();
+	}
+	return image;
+}
+
+bool Demosaic::convert(const QVideoFrame& frame, const DemosaicSettings& settings, QImage& dst, QByteArray& reducedMosaic) {
+	if(!isRawFormat(frame.pixelFormat()) || dst.isNull()){
+		return false;
+	}
+	QVideoFrame mappedFrame(frame);
+	if(!mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		return false;
+	}
+	const int width = frame.width();
+	const int height = frame.height();
+	const int stride = mappedFrame.bytesPerLine();
+	const int sampleSize = bytesPerSample(width, stride);
+	if(stride <= 0 || mappedFrame.mappedBytes() < stride*(height - 1) + width*sampleSize){
+		mappedFrame.unmap();
+		return false;
+	}
+
+	const quint8* mosaic = mappedFrame.bits();
+	int mosaicStride = stride;
+	if(sampleSize == 2){
+		reducedMosaic.resize(width*height);
+		quint8* reduced = reinterpret_cast<quint8*>(reducedMosaic.data());
+		reduceTo8Bit(mappedFrame.bits(), stride, width, height, settings.bitDepth, reduced, width);
+		mosaic = reduced;
+		mosaicStride = width;
+	}
+	demosaic(mosaic, mosaicStride, width, height, settings.pattern, settings.method, fixedPointGain(settings.redGain), fixedPointGain(settings.blueGain),
+		reinterpret_cast<quint32*>(dst.bits()), dst.bytesPerLine());
+	mappedFrame.unmap();
+	return true;
+}
+
+QImage Demosaic::rawImage(const QVideoFrame& frame) {
+	if(!isRawFormat(frame.pixelFormat())){
+		return QImage();
+	}
+	QVideoFrame mappedFrame(frame);
+	if(!mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		return QImage();
+	}
+	const int width = frame.width();
+	const int height = frame.height();
+	const int stride = mappedFrame.bytesPerLine();
+	const int sampleSize = bytesPerSample(width, stride);
+	QImage image;
+	if(stride > 0 && mappedFrame.mappedBytes() >= stride*(height - 1) + width*sampleSize){
+		image = QImage(width, height, sampleSize == 2 ? QImage::Format_Grayscale16 : QImage::Format_Grayscale8);
+		for(int y = 0; y < height; y++){
+			memcpy(image.scanLine(y), mappedFrame.bits() + y*stride, width*sampleSize);
+		}
+	}
+	mappedFrame.unmap();
+	return image;
+}
+
+bool Demosaic::estimateWhiteBalance(const QVideoFrame& frame, DemosaicSettings* settings) {
+	if(!isRawFormat(frame.pixelFormat()) || settings == nullptr){
+		return false;
+	}
+	QVideoFrame mappedFrame(frame);
+	if(!mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		return false;
+	}
+	const int width = frame.width() & ~1;
+	const int height = frame.height() & ~1;
+	const int stride = mappedFrame.bytesPerLine();
+	const int sampleSize = bytesPerSample(frame.width(), stride);
+	const uchar* bits = mappedFrame.bits();
+	const int maxValue = sampleSize == 2 ? (1 << qBound(9, settings->bitDepth, 16)) - 1 : 255;
+	const PatternLayout layout = layoutOf(settings->pattern);
+
+	//gray world on about 256x256 2x2 cells. cells with a clipped sample are left out, they would pull the gains towards the clipped channel
+	const int stepX = qMax(1, width/512)*2;
+	const int stepY = qMax(1, height/512)*2;
+	double sum[3] = {0.0, 0.0, 0.0};
+	for(int y = 0; y + 1 < height; y += stepY){
+		for(int x = 0; x + 1 < width; x += stepX){
+			int values[2][2];
+			bool clipped = false;
+			for(int dy = 0; dy < 2; dy++){
+				for(int dx = 0; dx < 2; dx++){
+					const uchar* p = bits + (y + dy)*stride + (x + dx)*sampleSize;
+					int value = sampleSize == 2 ? (p[0] | (p[1] << 8)) : p[0];
+					clipped = clipped || value >= maxValue - maxValue/64;
+					values[dy][dx] = value;
+				}
+			}
+			if(clipped){
+				continue;
+			}
+			for(int dy = 0; dy < 2; dy++){
+				for(int dx = 0; dx < 2; dx++){
+					int px = (x + dx + layout.xOffset) & 1;
+					int py = (y + dy + layout.yOffset) & 1;
+					int channel = px == py ? (px == 0 ? 0 : 2) : 1;
+					if(layout.swapRedBlue && channel != 1){
+						channel = 2 - channel;
+					}
+					sum[channel] += channel == 1 ? values[dy][dx]*0.5 : values[dy][dx];
+				}
+			}
+		}
+	}
+	mappedFrame.unmap();
+	if(sum[0] <= 0.0 || sum[1] <= 0.0 || sum[2] <= 0.0){
+		return false;
+	}
+	settings->redGain = qBound(0.25, sum[1]/sum[0], 8.0);
+	settings->blueGain = qBound(0.25, sum[1]/sum[2], 8.0);
+	return true;
+}
+
+void Demosaic::reduceTo8Bit(const uchar* src, int srcStride, int width, int height, int bitDepth, quint8* dst, int dstStride) {
+	//at least 9 bits, so the shifted samples stay positive for the signed saturation of packus
+	const int shift = qBound(9, bitDepth, 16) - 8;
+	const int bands = (height + BAND_HEIGHT - 1)/BAND_HEIGHT;
+	WorkStealingPool::globalInstance()->parallelFor(bands, [&](int band) {
+		int y1 = qMin(height, (band + 1)*BAND_HEIGHT);
+		for(int y = band*BAND_HEIGHT; y < y1; y++){
+			const quint16* in = reinterpret_cast<const quint16*>(src + y*srcStride);
+			quint8* out = dst + y*dstStride;
+			int x = 0;
+#ifdef CAMERAEXTENSION_SSE2
+			const __m128i count = _mm_cvtsi32_si128(shift);
+			for(; x + 16 <= width; x += 16){
+				__m128i lo = _mm_srl_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x)), count);
+				__m128i hi = _mm_srl_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x + 8)), count);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for(; x < width; x++){
+				out[x] = static_cast<quint8>(qMin(255, in[x] >> shift));
+			}
+		}
+	});
+}
+
+void Demosaic::demosaic(const quint8* mosaic, int stride, int width, int height, int pattern, int method, int redGain, int blueGain,
+		quint32* dst, int dstStride, bool vectorized) {
+	if(width <= 0 || height <= 0){
+		return;
+	}
+	const int bands = (height + BAND_HEIGHT - 1)/BAND_HEIGHT;
+	WorkStealingPool::globalInstance()->parallelFor(bands, [&](int band) {
+		demosaicRows(mosaic, stride, width, height, band*BAND_HEIGHT, qMin(height, (band + 1)*BAND_HEIGHT), pattern, method, redGain, blueGain,
+			dst, dstStride, vectorized);
+	});
+}
+
+void Demosaic::demosaicRows(const quint8* mosaic, int stride, int width, int height, int y0, int y1, int pattern, int method, int redGain, int blueGain,
+		quint32* dst, int dstStride, bool vectorized) {
+	const PatternLayout layout = layoutOf(pattern);
+	const bool edgeAware = method == EDGE_AWARE;
+#ifndef CAMERAEXTENSION_SSE2
+	Q_UNUSED(vectorized)
+#endif
+
+	for(int y = y0; y < y1; y++){
+		//rows y-2..y+2, mirrored at the top and bottom border, so only the left and right border need the scalar path
+		const quint8* rows[5];
+		for(int i = 0; i < 5; i++){
+			rows[i] = mosaic + reflect(y + i - 2, height)*stride;
+		}
+		const bool redRow = ((y + layout.yOffset) & 1) == 0;
+		quint32* out = reinterpret_cast<quint32*>(reinterpret_cast<uchar*>(dst) + y*dstStride);
+
+		auto scalarPixel = [&](int x) {
+			const int xl = reflect(x - 1, width);
+			const int xr = reflect(x + 1, width);
+			const int c = rows[2][x];
+			const int horizontal = avg(rows[2][xl], rows[2][xr]);
+			const int vertical = avg(rows[1][x], rows[3][x]);
+			const int cross = avg(horizontal, vertical);
+			const int diagonal = avg(avg(rows[1][xl], rows[1][xr]), avg(rows[3][xl], rows[3][xr]));
+			int green = cross;
+			if(edgeAware){
+				const int gradientH = addSaturated(qAbs(rows[2][xl] - rows[2][xr]), qAbs(c - avg(rows[2][reflect(x - 2, width)], rows[2][reflect(x + 2, width)])));
+				const int gradientV = addSaturated(qAbs(rows[1][x] - rows[3][x]), qAbs(c - avg(rows[0][x], rows[4][x])));
+				green = directionalGreen(horizontal, vertical, cross, gradientH, gradientV);
+			}
+			const bool evenSite = ((x + layout.xOffset) & 1) == 0;
+			int r, g, b;
+			if(redRow){
+				r = evenSite ? c : horizontal;
+				g = evenSite ? green : c;
+				b = evenSite ? diagonal : vertical;
+			} else {
+				r = evenSite ? vertical : diagonal;
+				g = evenSite ? c : green;
+				b = evenSite ? horizontal : c;
+			}
+			if(layout.swapRedBlue){
+				qSwap(r, b);
+			}
+			out[x] = 0xff000000u | (static_cast<quint32>(applyGain(r, redGain)) << 16) | (static_cast<quint32>(g) << 8) | static_cast<quint32>(applyGain(b, blueGain));
+		};
+
+		int x = 0;
+#ifdef CAMERAEXTENSION_SSE2
+		if(vectorized){
+			//the first vector starts at an even column, so the colour of every lane is the same for all vectors of a row
+			for(; x < 2 && x < width; x++){
+				scalarPixel(x);
+			}
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i ones = _mm_cmpeq_epi8(zero, zero);
+			const __m128i evenMask = layout.xOffset == 0 ? _mm_set1_epi16(0x00ff) : _mm_set1_epi16(static_cast<short>(0xff00));
+			const __m128i redGain16 = _mm_set1_epi16(static_cast<short>(redGain));
+			const __m128i blueGain16 = _mm_set1_epi16(static_cast<short>(blueGain));
+			const bool applyRedGain = redGain != GAIN_ONE;
+			const bool applyBlueGain = blueGain != GAIN_ONE;
+			for(; x + 18 <= width; x += 16){
+				const __m128i c = load(rows[2] + x);
+				const __m128i left = load(rows[2] + x - 1);
+				const __m128i right = load(rows[2] + x + 1);
+				const __m128i up = load(rows[1] + x);
+				const __m128i down = load(rows[3] + x);
+				const __m128i horizontal = _mm_avg_epu8(left, right);
+				const __m128i vertical = _mm_avg_epu8(up, down);
+				const __m128i cross = _mm_avg_epu8(horizontal, vertical);
+				const __m128i diagonal = _mm_avg_epu8(_mm_avg_epu8(load(rows[1] + x - 1), load(rows[1] + x + 1)), _mm_avg_epu8(load(rows[3] + x - 1), load(rows[3] + x + 1)));
+				__m128i green = cross;
+				if(edgeAware){
+					const __m128i gradientH = _mm_adds_epu8(absDiff(left, right), absDiff(c, _mm_avg_epu8(load(rows[2] + x - 2), load(rows[2] + x + 2))));
+					const __m128i gradientV = _mm_adds_epu8(absDiff(up, down), absDiff(c, _mm_avg_epu8(load(rows[0] + x), load(rows[4] + x))));
+					const __m128i takeHorizontal = _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(gradientV, gradientH), zero), ones);
+					const __m128i takeVertical = _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(gradientH, gradientV), zero), ones);
+					green = blend(takeHorizontal, horizontal, blend(takeVertical, vertical, cross));
+				}
+				__m128i r, g, b;
+				if(redRow){
+					r = blend(evenMask, c, horizontal);
+					g = blend(evenMask, green, c);
+					b = blend(evenMask, diagonal, vertical);
+				} else {
+					r = blend(evenMask, vertical, diagonal);
+					g = blend(evenMask, c, green);
+					b = blend(evenMask, horizontal, c);
+				}
+				if(layout.swapRedBlue){
+					qSwap(r, b);
+				}
+				if(applyRedGain){
+					r = gain16(r, redGain16);
+				}
+				if(applyBlueGain){
+					b = gain16(b, blueGain16);
+				}
+
+				//interleave to B, G, R, A bytes (RGB32 in little endian memory order)
+				const __m128i bgLo = _mm_unpacklo_epi8(b, g);
+				const __m128i bgHi = _mm_unpackhi_epi8(b, g);
+				const __m128i raLo = _mm_unpacklo_epi8(r, ones);
+				const __m128i raHi = _mm_unpackhi_epi8(r, ones);
+				__m128i* target = reinterpret_cast<__m128i*>(out + x);
+				_mm_storeu_si128(target, _mm_unpacklo_epi16(bgLo, raLo));
+				_mm_storeu_si128(target + 1, _mm_unpackhi_epi16(bgLo, raLo));
+				_mm_storeu_si128(target + 2, _mm_unpacklo_epi16(bgHi, raHi));
+				_mm_storeu_si128(target + 3, _mm_unpackhi_epi16(bgHi, raHi));
+			}
+		}
+#endif
+		for(; x < width; x++){
+			scalarPixel(x);
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef DEMOSAIC_H
+#define DEMOSAIC_H
+
+#include <QVideoFrame>
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QStringList>
+
+
+struct DemosaicSettings {
+	int pattern = 0; //Demosaic::BayerPattern
+	int method = 0; //Demosaic::Method
+	qreal redGain = 1.0; //white balance, relative to green
+	qreal blueGain = 1.0;
+	int bitDepth = 16; //significant bits of 16 bit samples, 8 bit mosaics are used as they are
+	bool saveRawSnapshots = false; //snapshots store the mosaic itself instead of the demosaiced image
+
+	bool isDefault() const {return *this == DemosaicSettings();}
+	bool operator==(const DemosaicSettings& other) const;
+	bool operator!=(const DemosaicSettings& other) const {return !(*this == other);}
+};
+
+//converts Bayer mosaics (Format_CameraRaw, 8 bit or 16 bit little endian samples) of machine vision cameras to RGB32 for the display and for snapshots.
+//all patterns are mapped to RGGB by a row/column offset and a red/blue swap, so there is a single kernel per method. the bilinear kernel averages
+//the nearest samples of each colour, the edge-aware kernel interpolates green along the direction of the smaller gradient (first and second order,
+//as proposed by Hamilton and Adams) and uses the bilinear estimate for red and blue. both kernels work on 16 pixels at once with SSE2 and
+//run on row bands of the shared WorkStealingPool. the white balance gains are applied in the same pass.
+//16 bit mosaics are reduced to 8 bit first, the display and the snapshots are 8 bit per channel anyway
+class Demosaic
+{
+public:
+	enum BayerPattern {
+		RGGB,
+		BGGR,
+		GRBG,
+		GBRG
+	};
+
+	enum Method {
+		BILINEAR,
+		EDGE_AWARE
+	};
+
+	Demosaic();
+
+	//thread safe, may be called while process() runs on another thread
+	void setSettings(const DemosaicSettings& settings);
+	DemosaicSettings getSettings() const;
+
+	//returns a demosaiced RGB32 frame, or an invalid frame if the frame is not a Bayer mosaic
+	QVideoFrame process(const QVideoFrame& frame);
+	int getLastProcessingTimeUs() const {return this->lastProcessingTimeUs.loadAcquire();}
+
+	static bool isRawFormat(QVideoFrame::PixelFormat format) {return format == QVideoFrame::Format_CameraRaw;}
+	//1 or 2 bytes per sample. Qt does not describe the layout of raw frames, 16 bit samples are assumed if a line holds two bytes per pixel
+	static int bytesPerSample(int width, int bytesPerLine) {return bytesPerLine >= 2*width ? 2 : 1;}
+	static QImage toImage(const QVideoFrame& frame, const DemosaicSettings& settings);
+	//lossless copy of the mosaic as Format_Grayscale8 or Format_Grayscale16 (not scaled), e.g. to be saved as png
+	static QImage rawImage(const QVideoFrame& frame);
+	//gray world estimate of the white balance gains from the mosaic of frame. returns false if frame is not a Bayer mosaic
+	static bool estimateWhiteBalance(const QVideoFrame& frame, DemosaicSettings* settings);
+
+	//the kernels, public to be benchmarked and verified on synthetic mosaics (tools/demosaic). gains are 8.8 fixed point
+	static void demosaic(const quint8* mosaic, int stride, int width, int height, int pattern, int method, int redGain, int blueGain,
+		quint32* dst, int dstStride, bool vectorized = true);
+	static void reduceTo8Bit(const uchar* src, int srcStride, int width, int height, int bitDepth, quint8* dst, int dstStride);
+
+	static QStringList patternNames();
+	static QStringList methodNames();
+	static int fixedPointGain(qreal gain);
+
+	static const int BAND_HEIGHT = 32;
+	static const int OUTPUT_BUFFERS = 3;
+	static const int GAIN_ONE = 256;
+
+private:
+	mutable QMutex mutex;
+	DemosaicSettings settings;
+	QAtomicInt lastProcessingTimeUs;
+	QList<QImage> outputBuffers; //only used by the thread that calls process()
+	QByteArray reducedMosaic; //8 bit copy of 16 bit mosaics, only used by the thread that calls process()
+
+	QImage takeOutputBuffer(const QSize& size);
+	void recycleOutputBuffer(const QImage& buffer);
+	static bool convert(const QVideoFrame& frame, const DemosaicSettings& settings, QImage& dst, QByteArray& reducedMosaic);
+	static void demosaicRows(const quint8* mosaic, int stride, int width, int height, int y0, int y1, int pattern, int method, int redGain, int blueGain,
+		quint32* dst, int dstStride, bool vectorized);
+};
+
+#endif //DEMOSAIC_H
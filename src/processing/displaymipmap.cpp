@@ -0,0 +1,313 @@
+#include "displaymipmap.h"
+#include "workstealingpool.h"
+#include "simd.h"
+#include <QElapsedTimer>
+
+
+static inline uchar average(int a, int b) {
+	return static_cast<uchar>((a + b + 1) >> 1);
+}
+
+static inline int unitBytes(DisplayMipmap::Layout layout) {
+	switch(layout){
+		case DisplayMipmap::BYTES_1:
+			return 1;
+		case DisplayMipmap::BYTES_2:
+			return 2;
+		default:
+			return 4;
+	}
+}
+
+
+DisplayMipmap::DisplayMipmap()
+	: enabled(1),
+	  requestedLevel(0),
+	  lastLevel(0),
+	  lastProcessingTimeUs(-1)
+{
+}
+
+void DisplayMipmap::setEnabled(bool enabled) {
+	this->enabled.storeRelease(enabled ? 1 : 0);
+}
+
+void DisplayMipmap::setViewScale(qreal screenPixelsPerFramePixel) {
+	this->requestedLevel.storeRelease(levelForScale(screenPixelsPerFramePixel));
+}
+
+int DisplayMipmap::levelForScale(qreal screenPixelsPerFramePixel) {
+	if(!(screenPixelsPerFramePixel > 0.0)){
+		return 0;
+	}
+	int level = 0;
+	while(level < MAX_LEVEL && screenPixelsPerFramePixel*(1 << (level + 1)) <= 1.0){
+		level++;
+	}
+	return level;
+}
+
+bool DisplayMipmap::isSupportedFormat(QVideoFrame::PixelFormat format) {
+	switch(format){
+		case QVideoFrame::Format_ARGB32:
+		case QVideoFrame::Format_ARGB32_Premultiplied:
+		case QVideoFrame::Format_RGB32:
+		case QVideoFrame::Format_BGRA32:
+		case QVideoFrame::Format_BGRA32_Premultiplied:
+		case QVideoFrame::Format_BGR32:
+		case QVideoFrame::Format_ABGR32:
+		case QVideoFrame::Format_Y8:
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY:
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21:
+			return true;
+		default:
+			return false;
+	}
+}
+
+QSize DisplayMipmap::levelSize(QVideoFrame::PixelFormat format, const QSize& size) {
+	//chroma subsampled formats need even widths (4:2:2, 4:2:0) and heights (4:2:0)
+	QSize half(size.width()/2, size.height()/2);
+	switch(format){
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY:
+			half.setWidth(half.width() & ~1);
+			break;
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21:
+			half = QSize(half.width() & ~1, half.height() & ~1);
+			break;
+		default:
+			break;
+	}
+	return half;
+}
+
+QVideoFrame DisplayMipmap::allocateFrame(QVideoFrame::PixelFormat format, const QSize& size) {
+	//memory frames, Qt derives the chroma planes of planar formats from bytesPerLine and height like for camera frames
+	int bytesPerPixel = 4;
+	int planeFactor = 2; //total size in half planes of bytesPerLine*height
+	switch(format){
+		case QVideoFrame::Format_Y8:
+			bytesPerPixel = 1;
+			break;
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY:
+			bytesPerPixel = 2;
+			break;
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21:
+			bytesPerPixel = 1;
+			planeFactor = 3;
+			break;
+		default:
+			break;
+	}
+	const int bytesPerLine = (size.width()*bytesPerPixel + 3) & ~3;
+	return QVideoFrame(bytesPerLine*size.height()*planeFactor/2, size, bytesPerLine, format);
+}
+
+bool DisplayMipmap::planeLayout(QVideoFrame::PixelFormat format, int plane, const QSize& size, Layout* layout, int* units, int* rows) {
+	*units = size.width();
+	*rows = size.height();
+	switch(format){
+		case QVideoFrame::Format_Y8:
+			*layout = BYTES_1;
+			return plane == 0;
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY:
+			*layout = format == QVideoFrame::Format_YUYV ? YUYV : UYVY;
+			*units = size.width()/2;
+			return plane == 0;
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21:
+			*layout = BYTES_1;
+			if(plane > 0){
+				*units = size.width()/2;
+				*rows = size.height()/2;
+				if(format == QVideoFrame::Format_NV12 || format == QVideoFrame::Format_NV21){
+					*layout = BYTES_2;
+					return plane == 1;
+				}
+			}
+			return plane < 3;
+		default:
+			*layout = BYTES_4;
+			return plane == 0 && isSupportedFormat(format);
+	}
+}
+
+QVideoFrame DisplayMipmap::process(const QVideoFrame& frame) {
+	const int level = this->isEnabled() ? this->requestedLevel.loadAcquire() : 0;
+	const QVideoFrame::PixelFormat format = frame.pixelFormat();
+	if(level <= 0 || !isSupportedFormat(format)){
+		this->lastLevel.storeRelease(0);
+		return QVideoFrame();
+	}
+	QElapsedTimer timer;
+	timer.start();
+	QVideoFrame current(frame);
+	if(!current.map(QAbstractVideoBuffer::ReadOnly)){
+		this->lastLevel.storeRelease(0);
+		return QVideoFrame();
+	}
+
+	//every level is built from the one above, the intermediate levels are released as soon as the next one is done
+	int reached = 0;
+	while(reached < level){
+		const QSize size = levelSize(format, current.size());
+		if(size.width() < MIN_SIZE || size.height() < MIN_SIZE){
+			break;
+		}
+		QVideoFrame target = allocateFrame(format, size);
+		if(!target.map(QAbstractVideoBuffer::ReadWrite)){
+			break;
+		}
+		if(!reduce(current, target)){
+			target.unmap();
+			break;
+		}
+		current.unmap();
+		current = target;
+		reached++;
+	}
+	current.unmap();
+	this->lastLevel.storeRelease(reached);
+	if(reached == 0){
+		return QVideoFrame();
+	}
+	current.setStartTime(frame.startTime());
+	this->lastProcessingTimeUs.storeRelease(static_cast<int>(timer.nsecsElapsed()/1000));
+	return current;
+}
+
+bool DisplayMipmap::reduce(const QVideoFrame& mappedSource, QVideoFrame& mappedTarget) {
+	const QVideoFrame::PixelFormat format = mappedSource.pixelFormat();
+	const int planeCount = mappedSource.planeCount();
+	if(planeCount != mappedTarget.planeCount() || planeCount > MAX_PLANES){
+		return false;
+	}
+	for(int plane = 0; plane < planeCount; plane++){
+		Layout layout = BYTES_1;
+		int sourceUnits = 0;
+		int sourceRows = 0;
+		int targetUnits = 0;
+		int targetRows = 0;
+		if(!planeLayout(format, plane, mappedSource.size(), &layout, &sourceUnits, &sourceRows)
+				|| !planeLayout(format, plane, mappedTarget.size(), &layout, &targetUnits, &targetRows)
+				|| targetUnits <= 0 || targetRows <= 0 || 2*targetUnits > sourceUnits || 2*targetRows > sourceRows){
+			return false;
+		}
+		const uchar* sourceBits = mappedSource.bits(plane);
+		const int sourceStride = mappedSource.bytesPerLine(plane);
+		uchar* targetBits = mappedTarget.bits(plane);
+		const int targetStride = mappedTarget.bytesPerLine(plane);
+		const int bytes = unitBytes(layout);
+		//rows of a plane that ends before the mapped buffer would be read (or written) past the end
+		if(sourceStride < sourceUnits*bytes || targetStride < targetUnits*bytes
+				|| sourceBits + (2*targetRows - 1)*sourceStride + 2*targetUnits*bytes > mappedSource.bits() + mappedSource.mappedBytes()
+				|| targetBits + (targetRows - 1)*targetStride + targetUnits*bytes > mappedTarget.bits() + mappedTarget.mappedBytes()){
+			return false;
+		}
+		const int bands = (targetRows + BAND_HEIGHT - 1)/BAND_HEIGHT;
+		WorkStealingPool::globalInstance()->parallelFor(bands, [&](int band) {
+			const int y1 = qMin(targetRows, (band + 1)*BAND_HEIGHT);
+			for(int y = band*BAND_HEIGHT; y < y1; y++){
+				const uchar* a = sourceBits + 2*y*sourceStride;
+				downsampleRow(a, a + sourceStride, targetBits + y*targetStride, targetUnits, layout);
+			}
+		});
+	}
+	return true;
+}
+
+void DisplayMipmap::downsampleRow(const uchar* a, const uchar* b, uchar* dst, int count, Layout layout, bool vectorized) {
+	int i = 0;
+#ifdef CAMERAEXTENSION_SSE2
+	if(vectorized){
+		//every iteration reads 32 bytes of both rows and writes 16 bytes
+		const int unitsPerStep = 16/unitBytes(layout);
+		const __m128i lowWords = _mm_set1_epi32(0x0000ffff);
+		const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+		//4:2:2: luma pairs are averaged within a macro pixel, chroma across two macro pixels. chromaMask selects the bytes of a 16 bit
+		//word that come from the odd macro pixel in the first output word
+		const __m128i chromaMask = _mm_set1_epi32(layout == YUYV ? 0x00ff : 0xff00);
+		const __m128i lumaMask = _mm_xor_si128(chromaMask, lowWords);
+		for(; i + unitsPerStep <= count; i += unitsPerStep){
+			const uchar* pa = a + 2*i*unitBytes(layout);
+			const uchar* pb = b + 2*i*unitBytes(layout);
+			const __m128i v0 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb)));
+			const __m128i v1 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + 16)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + 16)));
+			__m128i result;
+			if(layout == BYTES_1){
+				const __m128i h0 = _mm_avg_epu16(_mm_and_si128(v0, lowBytes), _mm_srli_epi16(v0, 8));
+				const __m128i h1 = _mm_avg_epu16(_mm_and_si128(v1, lowBytes), _mm_srli_epi16(v1, 8));
+				result = _mm_packus_epi16(h0, h1);
+			}else if(layout == BYTES_2){
+				//the average sits in the low word of every dword, sign extension keeps it intact through the signed pack
+				__m128i h0 = _mm_avg_epu8(_mm_and_si128(v0, lowWords), _mm_srli_epi32(v0, 16));
+				__m128i h1 = _mm_avg_epu8(_mm_and_si128(v1, lowWords), _mm_srli_epi32(v1, 16));
+				h0 = _mm_srai_epi32(_mm_slli_epi32(h0, 16), 16);
+				h1 = _mm_srai_epi32(_mm_slli_epi32(h1, 16), 16);
+				result = _mm_packs_epi32(h0, h1);
+			}else{
+				const __m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(v0), _mm_castsi128_ps(v1), _MM_SHUFFLE(2, 0, 2, 0)));
+				const __m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(v0), _mm_castsi128_ps(v1), _MM_SHUFFLE(3, 1, 3, 1)));
+				if(layout == BYTES_4){
+					result = _mm_avg_epu8(even, odd);
+				}else{
+					const __m128i even0 = _mm_and_si128(even, lowWords);
+					const __m128i even1 = _mm_srli_epi32(even, 16);
+					const __m128i odd0 = _mm_and_si128(odd, lowWords);
+					const __m128i odd1 = _mm_srli_epi32(odd, 16);
+					const __m128i first = _mm_or_si128(even0, _mm_slli_epi32(_mm_or_si128(_mm_and_si128(odd0, chromaMask), _mm_and_si128(even1, lumaMask)), 16));
+					const __m128i second = _mm_or_si128(_mm_or_si128(_mm_and_si128(even1, chromaMask), _mm_and_si128(odd0, lumaMask)), _mm_slli_epi32(odd1, 16));
+					result = _mm_avg_epu8(first, second);
+				}
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i*unitBytes(layout)), result);
+		}
+	}
+#else
+	Q_UNUSED(vectorized)
+#endif
+	if(layout == YUYV || layout == UYVY){
+		for(; i < count; i++){
+			uchar v[8];
+			for(int k = 0; k < 8; k++){
+				v[k] = average(a[8*i + k], b[8*i + k]);
+			}
+			uchar* out = dst + 4*i;
+			if(layout == YUYV){
+				out[0] = average(v[0], v[2]);
+				out[1] = average(v[1], v[5]);
+				out[2] = average(v[4], v[6]);
+				out[3] = average(v[3], v[7]);
+			}else{
+				out[0] = average(v[0], v[4]);
+				out[1] = average(v[1], v[3]);
+				out[2] = average(v[2], v[6]);
+				out[3] = average(v[5], v[7]);
+			}
+		}
+		return;
+	}
+	const int bytes = unitBytes(layout);
+	for(; i < count; i++){
+		for(int c = 0; c < bytes; c++){
+			const int left = 2*i*bytes + c;
+			const int right = left + bytes;
+			dst[i*bytes + c] = average(average(a[left], b[left]), average(a[right], b[right]));
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef DISPLAYMIPMAP_H
+#define DISPLAYMIPMAP_H
+
+#include <QVideoFrame>
+#include <QAtomicInt>
+
+
+//reduces the displayed frames to the mip level that fits the current zoom of the view. when a frame pixel covers less than half a screen
+//pixel, the frame is halved with a 2x2 box filter (SSE2 averages) as often as needed, so the display never scales down by more than 2 and
+//fine sample textures do not alias into moire. only the levels down to the needed one are built, every level reads a quarter of the bytes
+//of the one above. the frames keep their pixel format, so the following display stages (reference comparison, image adjustment) also work
+//on fewer pixels. frames published via FrameTapSurface::frameAvailable() are not affected
+class DisplayMipmap
+{
+public:
+	//how the bytes of a plane are combined horizontally
+	enum Layout {
+		BYTES_1, //8 bit samples (luma or planar chroma)
+		BYTES_2, //interleaved 8 bit chroma pairs (NV12, NV21)
+		BYTES_4, //32 bit pixels
+		YUYV, //packed 4:2:2, Y0 U Y1 V
+		UYVY //packed 4:2:2, U Y0 V Y1
+	};
+
+	DisplayMipmap();
+
+	//thread safe, may be called while process() runs on another thread
+	void setEnabled(bool enabled);
+	bool isEnabled() const {return this->enabled.loadAcquire() != 0;}
+	//screen pixels per frame pixel of the current view transform
+	void setViewScale(qreal screenPixelsPerFramePixel);
+	//level of the last processed frame, 0 is the full resolution
+	int getLevel() const {return this->lastLevel.loadAcquire();}
+	bool isActive() const {return this->isEnabled() && this->requestedLevel.loadAcquire() > 0;}
+
+	//returns the reduced frame in the format of frame, or an invalid frame if no reduction is needed or the format is not supported
+	QVideoFrame process(const QVideoFrame& frame);
+	int getLastProcessingTimeUs() const {return this->lastProcessingTimeUs.loadAcquire();}
+
+	static bool isSupportedFormat(QVideoFrame::PixelFormat format);
+	//largest level at which a level pixel still covers at most one screen pixel
+	static int levelForScale(qreal screenPixelsPerFramePixel);
+
+	//the kernel, public to be verified against the scalar path. rows a and b of a plane are reduced to count output units
+	//(pixels, chroma pairs or 4:2:2 macro pixels). rounding is that of two successive SSE2 byte averages, vertically then horizontally
+	static void downsampleRow(const uchar* a, const uchar* b, uchar* dst, int count, Layout layout, bool vectorized = true);
+
+	static const int MAX_LEVEL = 5;
+	static const int MIN_SIZE = 64; //levels are not reduced below this width or height
+	static const int BAND_HEIGHT = 32;
+	static const int MAX_PLANES = 3;
+
+private:
+	QAtomicInt enabled;
+	QAtomicInt requestedLevel;
+	QAtomicInt lastLevel;
+	QAtomicInt lastProcessingTimeUs;
+
+	static QSize levelSize(QVideoFrame::PixelFormat format, const QSize& size);
+	static QVideoFrame allocateFrame(QVideoFrame::PixelFormat format, const QSize& size);
+	static bool planeLayout(QVideoFrame::PixelFormat format, int plane, const QSize& size, Layout* layout, int* units, int* rows);
+	static bool reduce(const QVideoFrame& mappedSource, QVideoFrame& mappedTarget);
+};
+
+#endif //DISPLAYMIPMAP_H
@@ -0,0 +1,115 @@
+#include "drifttracker.h"
+#include "frameconversion.h"
+#include <QDateTime>
+#include <QMutexLocker>
+
+//side length of the correlated patch. 128x128 keeps a full correlation (including rotation) well below 5 ms on a laptop cpu
+#define DRIFT_PATCH_SIZE 128
+
+
+DriftTracker::DriftTracker(QObject *parent)
+	: FrameAnalyzer(parent),
+	  rotationEnabled(false),
+	  referenceResetRequested(true),
+	  correlator(DRIFT_PATCH_SIZE),
+	  frameCounter(0)
+{
+	qRegisterMetaType<DriftEstimate>("DriftEstimate");
+}
+
+DriftTracker::~DriftTracker() {
+	this->stopWorker();
+}
+
+void DriftTracker::setRegion(const QRectF& normalizedRegion) {
+	QMutexLocker locker(&this->mutex);
+	if(this->normalizedRegion != normalizedRegion){
+		this->normalizedRegion = normalizedRegion;
+		//drift is always measured against a reference of the same region
+		this->referenceResetRequested = true;
+	}
+}
+
+bool DriftTracker::isRotationEnabled() {
+	QMutexLocker locker(&this->mutex);
+	return this->rotationEnabled;
+}
+
+void DriftTracker::setRotationEnabled(bool enabled) {
+	QMutexLocker locker(&this->mutex);
+	if(this->rotationEnabled != enabled){
+		this->rotationEnabled = enabled;
+		this->referenceResetRequested = true;
+	}
+}
+
+void DriftTracker::resetReference() {
+	QMutexLocker locker(&this->mutex);
+	this->referenceResetRequested = true;
+}
+
+QRect DriftTracker::sourceRectForFrame(const QSize& frameSize, const QRectF& region) const {
+	QRect frameRect(QPoint(0, 0), frameSize);
+	if(region.isNull()){
+		int side = qMin(frameSize.width(), frameSize.height())/2;
+		return QRect((frameSize.width() - side)/2, (frameSize.height() - side)/2, side, side);
+	}
+	QRectF pixelRegion(region.x()*frameSize.width(), region.y()*frameSize.height(), region.width()*frameSize.width(), region.height()*frameSize.height());
+	return pixelRegion.toAlignedRect().intersected(frameRect);
+}
+
+void DriftTracker::analyzeFrame(const QVideoFrame& frame) {
+	this->mutex.lock();
+	QRectF region = this->normalizedRegion;
+	bool rotation = this->rotationEnabled;
+	bool resetRequested = this->referenceResetRequested;
+	this->referenceResetRequested = false;
+	this->mutex.unlock();
+
+	QRect sourceRect = this->sourceRectForFrame(frame.size(), region);
+	if(resetRequested || sourceRect != this->referenceSourceRect){
+		this->referenceSpectrum.clear();
+		this->referenceRotationSpectrum.clear();
+	}
+	if(sourceRect.width() < DRIFT_PATCH_SIZE/4 || sourceRect.height() < DRIFT_PATCH_SIZE/4){
+		return;
+	}
+
+	//decimate during extraction to roughly twice the patch size, the final bilinear resampling then averages the remaining samples
+	int decimation = qMax(1, qMin(sourceRect.width(), sourceRect.height())/(2*DRIFT_PATCH_SIZE));
+	LumaImage luma = FrameConversion::toLuma(frame, decimation, sourceRect);
+	if(luma.isNull()){
+		return;
+	}
+	std::vector<float> patch = PhaseCorrelator::toPatch(luma, DRIFT_PATCH_SIZE);
+
+	if(this->referenceSpectrum.empty()){
+		this->referenceSpectrum = this->correlator.spectrum(patch);
+		if(rotation){
+			this->referenceRotationSpectrum = this->correlator.rotationSpectrum(patch);
+		}
+		this->referenceSourceRect = sourceRect;
+		this->frameCounter = 0;
+	}
+
+	DriftEstimate estimate;
+	if(rotation && !this->referenceRotationSpectrum.empty()){
+		estimate.rotation = this->correlator.estimateRotation(this->correlator.rotationSpectrum(patch), this->referenceRotationSpectrum);
+		//undo rotation so that the translation is measured on aligned patches
+		patch = PhaseCorrelator::rotatePatch(patch, DRIFT_PATCH_SIZE, -estimate.rotation);
+	}
+	PhaseCorrelationResult result = this->correlator.correlate(this->correlator.spectrum(patch), this->referenceSpectrum);
+
+	estimate.valid = true;
+	estimate.dx = result.dx*sourceRect.width()/DRIFT_PATCH_SIZE;
+	estimate.dy = result.dy*sourceRect.height()/DRIFT_PATCH_SIZE;
+	estimate.confidence = result.peak;
+	estimate.reliable = result.peak >= this->correlator.getMinReliablePeak();
+	estimate.frameSize = frame.size();
+	estimate.region = QRectF(static_cast<double>(sourceRect.x())/frame.width(), static_cast<double>(sourceRect.y())/frame.height(),
+							 static_cast<double>(sourceRect.width())/frame.width(), static_cast<double>(sourceRect.height())/frame.height());
+	estimate.timestamp = QDateTime::currentMSecsSinceEpoch();
+	estimate.frameNumber = this->frameCounter++;
+
+	emit driftMeasured(estimate);
+}
@@ -0,0 +1,66 @@
+#ifndef DRIFTTRACKER_H
+#define DRIFTTRACKER_H
+
+#include <QMutex>
+#include <QRectF>
+#include <QSize>
+#include <QMetaType>
+#include "frameanalyzer.h"
+#include "phasecorrelator.h"
+
+
+struct DriftEstimate {
+	bool valid = false;
+	double dx = 0.0; //displacement relative to the reference frame in frame pixels
+	double dy = 0.0;
+	double rotation = 0.0; //degrees, positive is clockwise on screen. only estimated if rotation tracking is enabled
+	double confidence = 0.0; //height of the phase correlation peak, 0..1
+	bool reliable = false; //confidence reaches PhaseCorrelator::getMinReliablePeak(), otherwise the frame does not match the reference
+	QRectF region; //tracked region in normalized frame coordinates
+	QSize frameSize;
+	qint64 timestamp = 0; //ms since epoch
+	quint64 frameNumber = 0; //number of analyzed frames since the reference was set
+};
+Q_DECLARE_METATYPE(DriftEstimate)
+
+
+//tracks the translation (and optionally rotation) of the sample by phase correlation of a downsampled, windowed region of each frame against a reference frame.
+//the reference is taken from the first analyzed frame after enabling the tracker or after resetReference()
+class DriftTracker : public FrameAnalyzer
+{
+	Q_OBJECT
+public:
+	explicit DriftTracker(QObject *parent = nullptr);
+	~DriftTracker();
+
+	//region in normalized frame coordinates. a null rect selects a centered square covering half of the shorter frame side
+	void setRegion(const QRectF& normalizedRegion);
+	bool isRotationEnabled();
+
+protected:
+	void analyzeFrame(const QVideoFrame& frame) override;
+
+private:
+	QMutex mutex;
+	QRectF normalizedRegion;
+	bool rotationEnabled;
+	bool referenceResetRequested;
+
+	//worker thread state
+	PhaseCorrelator correlator;
+	std::vector<PhaseCorrelator::Complex> referenceSpectrum;
+	std::vector<PhaseCorrelator::Complex> referenceRotationSpectrum;
+	QRect referenceSourceRect;
+	quint64 frameCounter;
+
+	QRect sourceRectForFrame(const QSize& frameSize, const QRectF& region) const;
+
+public slots:
+	void setRotationEnabled(bool enabled);
+	void resetReference();
+
+signals:
+	void driftMeasured(DriftEstimate estimate);
+};
+
+#endif //DRIFTTRACKER_H
@@ -0,0 +1,95 @@
+#include "fft.h"
+#include <cmath>
+
+
+Fft2D::Fft2D(int size) :
+	size(0)
+{
+	this->setSize(size);
+}
+
+void Fft2D::setSize(int size) {
+	if(size == this->size || !isPowerOfTwo(size)){
+		return;
+	}
+	this->size = size;
+
+	const double pi = 3.14159265358979323846;
+	this->twiddles.resize(size/2);
+	for(int i = 0; i < size/2; i++){
+		double angle = -2.0*pi*i/size;
+		this->twiddles[i] = Complex(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+	}
+
+	int bits = 0;
+	while((1 << bits) < size){
+		bits++;
+	}
+	this->bitReversal.resize(size);
+	for(int i = 0; i < size; i++){
+		int reversed = 0;
+		for(int b = 0; b < bits; b++){
+			reversed |= ((i >> b) & 1) << (bits - 1 - b);
+		}
+		this->bitReversal[i] = reversed;
+	}
+	this->column.resize(size);
+}
+
+void Fft2D::forward(std::vector<Complex>& data) {
+	this->transform2D(data, false);
+}
+
+void Fft2D::inverse(std::vector<Complex>& data) {
+	this->transform2D(data, true);
+	const float scale = 1.0f/(static_cast<float>(this->size)*this->size);
+	for(Complex& value : data){
+		value *= scale;
+	}
+}
+
+void Fft2D::transform1D(Complex* data, bool inverse) const {
+	const int n = this->size;
+	for(int i = 0; i < n; i++){
+		int j = this->bitReversal[i];
+		if(j > i){
+			std::swap(data[i], data[j]);
+		}
+	}
+	for(int length = 2; length <= n; length <<= 1){
+		int half = length/2;
+		int step = n/length;
+		for(int start = 0; start < n; start += length){
+			for(int k = 0; k < half; k++){
+				Complex w = this->twiddles[k*step];
+				if(inverse){
+					w = std::conj(w);
+				}
+				Complex even = data[start + k];
+				Complex odd = data[start + k + half]*w;
+				data[start + k] = even + odd;
+				data[start + k + half] = even - odd;
+			}
+		}
+	}
+}
+
+void Fft2D::transform2D(std::vector<Complex>& data, bool inverse) {
+	const int n = this->size;
+	if(n == 0 || static_cast<int>(data.size()) != n*n){
+		return;
+	}
+	for(int y = 0; y < n; y++){
+		this->transform1D(&data[y*n], inverse);
+	}
+	//columns are gathered into a contiguous buffer to keep the butterflies cache friendly
+	for(int x = 0; x < n; x++){
+		for(int y = 0; y < n; y++){
+			this->column[y] = data[y*n + x];
+		}
+		this->transform1D(this->column.data(), inverse);
+		for(int y = 0; y < n; y++){
+			data[y*n + x] = this->column[y];
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <vector>
+
+
+//radix-2 complex fft for square power of two images. twiddle factors and bit reversal table are computed once per size
+class Fft2D
+{
+public:
+	typedef std::complex<float> Complex;
+
+	explicit Fft2D(int size = 0);
+
+	int getSize() const {return this->size;}
+	void setSize(int size);
+	static bool isPowerOfTwo(int value) {return value > 0 && (value & (value - 1)) == 0;}
+
+	//in-place transform of size*size row-major data. the inverse transform is scaled by 1/(size*size)
+	void forward(std::vector<Complex>& data);
+	void inverse(std::vector<Complex>& data);
+
+private:
+	int size;
+	std::vector<Complex> twiddles;
+	std::vector<int> bitReversal;
+	std::vector<Complex> column;
+
+	void transform1D(Complex* data, bool inverse) const;
+	void transform2D(std::vector<Complex>& data, bool inverse);
+};
+
+#endif //FFT_H
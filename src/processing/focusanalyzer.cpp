@@ -0,0 +1,111 @@
+#include "focusanalyzer.h"
+#include "frameconversion.h"
+#include "scanlinespans.h"
+#include <QDateTime>
+#include <QMutexLocker>
+
+//the decimated copy is about this wide. 1080p frames are analyzed at 480x270
+#define FOCUS_ANALYSIS_WIDTH 480
+#define PEAK_HOLD_MS 3000
+#define PEAK_DECAY_PER_UPDATE 0.98
+
+
+FocusAnalyzer::FocusAnalyzer(QObject *parent)
+	: FrameAnalyzer(parent),
+	  method(FocusMetric::LAPLACIAN_VARIANCE),
+	  peakResetRequested(false),
+	  peak(0.0)
+{
+	qRegisterMetaType<FocusResult>("FocusResult");
+}
+
+FocusAnalyzer::~FocusAnalyzer() {
+	this->stopWorker();
+}
+
+FocusMetric::Method FocusAnalyzer::getMethod() {
+	QMutexLocker locker(&this->mutex);
+	return this->method;
+}
+
+void FocusAnalyzer::setRegionOfInterest(const QPolygonF& normalizedRoi) {
+	QMutexLocker locker(&this->mutex);
+	this->normalizedRoi = normalizedRoi;
+}
+
+void FocusAnalyzer::setMethod(FocusMetric::Method method) {
+	QMutexLocker locker(&this->mutex);
+	if(this->method != method){
+		this->method = method;
+		//scores of different methods are not comparable
+		this->peakResetRequested = true;
+	}
+}
+
+void FocusAnalyzer::resetPeak() {
+	QMutexLocker locker(&this->mutex);
+	this->peakResetRequested = true;
+}
+
+void FocusAnalyzer::analyzeFrame(const QVideoFrame& frame) {
+	this->mutex.lock();
+	FocusMetric::Method currentMethod = this->method;
+	QPolygonF roi = this->normalizedRoi;
+	bool resetRequested = this->peakResetRequested;
+	this->peakResetRequested = false;
+	this->mutex.unlock();
+
+	//determine source rect of roi in frame pixels
+	QSize frameSize = frame.size();
+	QRect sourceRect(QPoint(0, 0), frameSize);
+	QPolygonF roiInPixels;
+	if(!roi.isEmpty()){
+		for(const QPointF& p : roi){
+			roiInPixels.append(QPointF(p.x()*frameSize.width(), p.y()*frameSize.height()));
+		}
+		sourceRect = roiInPixels.boundingRect().toAlignedRect().intersected(sourceRect);
+		if(sourceRect.width() < 8 || sourceRect.height() < 8){
+			return;
+		}
+	}
+
+	int decimation = FrameConversion::decimationForWidth(frameSize.width(), FOCUS_ANALYSIS_WIDTH);
+	LumaImage luma = FrameConversion::toLuma(frame, decimation, sourceRect);
+	if(luma.isNull()){
+		return;
+	}
+
+	//rasterize roi in coordinates of the decimated copy
+	QVector<ScanlineSpan> spans;
+	if(!roiInPixels.isEmpty()){
+		QPolygonF roiInLuma;
+		for(const QPointF& p : roiInPixels){
+			roiInLuma.append(QPointF((p.x() - sourceRect.left())/decimation, (p.y() - sourceRect.top())/decimation));
+		}
+		spans = ScanlineSpans::fromPolygon(roiInLuma, QRect(0, 0, luma.width, luma.height));
+		if(spans.isEmpty()){
+			return;
+		}
+	}
+
+	FocusResult result;
+	result.valid = true;
+	result.method = currentMethod;
+	result.score = FocusMetric::compute(currentMethod, luma, spans);
+	result.timestamp = QDateTime::currentMSecsSinceEpoch();
+
+	//peak hold with decay
+	if(resetRequested || !this->peakTimer.isValid()){
+		this->peak = 0.0;
+		this->peakTimer.start();
+	}
+	if(result.score >= this->peak){
+		this->peak = result.score;
+		this->peakTimer.restart();
+	} else if(this->peakTimer.elapsed() > PEAK_HOLD_MS){
+		this->peak = qMax(result.score, this->peak*PEAK_DECAY_PER_UPDATE);
+	}
+	result.peak = this->peak;
+
+	emit focusMeasured(result);
+}
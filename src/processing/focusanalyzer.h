@@ -0,0 +1,54 @@
+#ifndef FOCUSANALYZER_H
+#define FOCUSANALYZER_H
+
+#include <QMutex>
+#include <QPolygonF>
+#include <QElapsedTimer>
+#include <QMetaType>
+#include "frameanalyzer.h"
+#include "focusmetric.h"
+
+
+struct FocusResult {
+	bool valid = false;
+	double score = 0.0;
+	double peak = 0.0;
+	int method = FocusMetric::LAPLACIAN_VARIANCE;
+	qint64 timestamp = 0; //ms since epoch
+};
+Q_DECLARE_METATYPE(FocusResult)
+
+
+//computes a focus score on a decimated luma copy of each analyzed frame, optionally restricted to a polygonal region of interest.
+//the peak value is held for PEAK_HOLD_MS and decays afterwards, so the operator can turn the focus knob past the optimum and return to it
+class FocusAnalyzer : public FrameAnalyzer
+{
+	Q_OBJECT
+public:
+	explicit FocusAnalyzer(QObject *parent = nullptr);
+	~FocusAnalyzer();
+
+	FocusMetric::Method getMethod();
+	//roi in normalized frame coordinates (0..1). an empty polygon means whole frame
+	void setRegionOfInterest(const QPolygonF& normalizedRoi);
+
+protected:
+	void analyzeFrame(const QVideoFrame& frame) override;
+
+private:
+	QMutex mutex;
+	FocusMetric::Method method;
+	QPolygonF normalizedRoi;
+	bool peakResetRequested;
+	double peak;
+	QElapsedTimer peakTimer;
+
+public slots:
+	void setMethod(FocusMetric::Method method);
+	void resetPeak();
+
+signals:
+	void focusMeasured(FocusResult result);
+};
+
+#endif //FOCUSANALYZER_H
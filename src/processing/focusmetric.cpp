@@ -0,0 +1,152 @@
+#include "focusmetric.h"
+#include "simd.h"
+
+
+namespace {
+	struct Accumulator {
+		qint64 sum = 0;
+		qint64 sumSq = 0;
+		qint64 count = 0;
+	};
+
+	//number of 8 pixel blocks after which the 32 bit lanes are flushed into the 64 bit accumulator. worst case per lane and block is 4*1020^2 (tenengrad)
+	const int FLUSH_INTERVAL = 128;
+
+	void laplacianRow(const quint8* above, const quint8* row, const quint8* below, int x0, int x1, Accumulator& acc) {
+		int x = x0;
+#ifdef CAMERAEXTENSION_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i ones = _mm_set1_epi16(1);
+		__m128i sum32 = _mm_setzero_si128();
+		__m128i sumSq32 = _mm_setzero_si128();
+		int blocks = 0;
+		for(; x + 8 <= x1; x += 8){
+			__m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)), zero);
+			__m128i l = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x - 1)), zero);
+			__m128i r = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x + 1)), zero);
+			__m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(above + x)), zero);
+			__m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(below + x)), zero);
+			__m128i neighbours = _mm_add_epi16(_mm_add_epi16(l, r), _mm_add_epi16(u, d));
+			__m128i lap = _mm_sub_epi16(_mm_slli_epi16(c, 2), neighbours);
+			sum32 = _mm_add_epi32(sum32, _mm_madd_epi16(lap, ones));
+			sumSq32 = _mm_add_epi32(sumSq32, _mm_madd_epi16(lap, lap));
+			if(++blocks == FLUSH_INTERVAL){
+				alignas(16) qint32 s[4], sq[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(s), sum32);
+				_mm_store_si128(reinterpret_cast<__m128i*>(sq), sumSq32);
+				acc.sum += static_cast<qint64>(s[0]) + s[1] + s[2] + s[3];
+				acc.sumSq += static_cast<qint64>(sq[0]) + sq[1] + sq[2] + sq[3];
+				sum32 = _mm_setzero_si128();
+				sumSq32 = _mm_setzero_si128();
+				blocks = 0;
+			}
+		}
+		alignas(16) qint32 s[4], sq[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(s), sum32);
+		_mm_store_si128(reinterpret_cast<__m128i*>(sq), sumSq32);
+		acc.sum += static_cast<qint64>(s[0]) + s[1] + s[2] + s[3];
+		acc.sumSq += static_cast<qint64>(sq[0]) + sq[1] + sq[2] + sq[3];
+#endif
+		for(; x < x1; x++){
+			int lap = 4*row[x] - row[x-1] - row[x+1] - above[x] - below[x];
+			acc.sum += lap;
+			acc.sumSq += lap*lap;
+		}
+		acc.count += qMax(0, x1 - x0);
+	}
+
+	void tenengradRow(const quint8* above, const quint8* row, const quint8* below, int x0, int x1, Accumulator& acc) {
+		int x = x0;
+#ifdef CAMERAEXTENSION_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		__m128i sumSq32 = _mm_setzero_si128();
+		int blocks = 0;
+		for(; x + 8 <= x1; x += 8){
+			__m128i al = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(above + x - 1)), zero);
+			__m128i ac = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(above + x)), zero);
+			__m128i ar = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(above + x + 1)), zero);
+			__m128i rl = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x - 1)), zero);
+			__m128i rr = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x + 1)), zero);
+			__m128i bl = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(below + x - 1)), zero);
+			__m128i bc = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(below + x)), zero);
+			__m128i br = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(below + x + 1)), zero);
+			__m128i right = _mm_add_epi16(_mm_add_epi16(ar, br), _mm_slli_epi16(rr, 1));
+			__m128i left = _mm_add_epi16(_mm_add_epi16(al, bl), _mm_slli_epi16(rl, 1));
+			__m128i bottom = _mm_add_epi16(_mm_add_epi16(bl, br), _mm_slli_epi16(bc, 1));
+			__m128i top = _mm_add_epi16(_mm_add_epi16(al, ar), _mm_slli_epi16(ac, 1));
+			__m128i gx = _mm_sub_epi16(right, left);
+			__m128i gy = _mm_sub_epi16(bottom, top);
+			sumSq32 = _mm_add_epi32(sumSq32, _mm_add_epi32(_mm_madd_epi16(gx, gx), _mm_madd_epi16(gy, gy)));
+			if(++blocks == FLUSH_INTERVAL){
+				alignas(16) qint32 sq[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(sq), sumSq32);
+				acc.sumSq += static_cast<qint64>(sq[0]) + sq[1] + sq[2] + sq[3];
+				sumSq32 = _mm_setzero_si128();
+				blocks = 0;
+			}
+		}
+		alignas(16) qint32 sq[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(sq), sumSq32);
+		acc.sumSq += static_cast<qint64>(sq[0]) + sq[1] + sq[2] + sq[3];
+#endif
+		for(; x < x1; x++){
+			int gx = (above[x+1] + 2*row[x+1] + below[x+1]) - (above[x-1] + 2*row[x-1] + below[x-1]);
+			int gy = (below[x-1] + 2*below[x] + below[x+1]) - (above[x-1] + 2*above[x] + above[x+1]);
+			acc.sumSq += gx*gx + gy*gy;
+		}
+		acc.count += qMax(0, x1 - x0);
+	}
+
+	//runs rowKernel on the interior part (3x3 neighbourhood inside the image) of every span
+	template <typename RowKernel>
+	Accumulator accumulate(const LumaImage& image, const QVector<ScanlineSpan>& spans, RowKernel rowKernel) {
+		Accumulator acc;
+		if(image.width < 3 || image.height < 3){
+			return acc;
+		}
+		if(spans.isEmpty()){
+			for(int y = 1; y < image.height - 1; y++){
+				rowKernel(image.constLine(y-1), image.constLine(y), image.constLine(y+1), 1, image.width - 1, acc);
+			}
+		} else {
+			for(const ScanlineSpan& span : spans){
+				if(span.y < 1 || span.y >= image.height - 1){
+					continue;
+				}
+				int x0 = qMax(1, span.x0);
+				int x1 = qMin(image.width - 1, span.x1);
+				if(x1 > x0){
+					rowKernel(image.constLine(span.y-1), image.constLine(span.y), image.constLine(span.y+1), x0, x1, acc);
+				}
+			}
+		}
+		return acc;
+	}
+}
+
+double FocusMetric::laplacianVariance(const LumaImage& image, const QVector<ScanlineSpan>& spans) {
+	Accumulator acc = accumulate(image, spans, laplacianRow);
+	if(acc.count == 0){
+		return 0.0;
+	}
+	double mean = static_cast<double>(acc.sum)/acc.count;
+	return static_cast<double>(acc.sumSq)/acc.count - mean*mean;
+}
+
+double FocusMetric::tenengrad(const LumaImage& image, const QVector<ScanlineSpan>& spans) {
+	Accumulator acc = accumulate(image, spans, tenengradRow);
+	if(acc.count == 0){
+		return 0.0;
+	}
+	return static_cast<double>(acc.sumSq)/acc.count;
+}
+
+double FocusMetric::compute(Method method, const LumaImage& image, const QVector<ScanlineSpan>& spans) {
+	switch(method){
+		case TENENGRAD:
+			return tenengrad(image, spans);
+		case LAPLACIAN_VARIANCE:
+		default:
+			return laplacianVariance(image, spans);
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef FOCUSMETRIC_H
+#define FOCUSMETRIC_H
+
+#include <QVector>
+#include "lumaimage.h"
+#include "scanlinespans.h"
+
+
+class FocusMetric
+{
+public:
+	enum Method {
+		LAPLACIAN_VARIANCE,
+		TENENGRAD
+	};
+
+	//variance of the 4-neighbour laplacian over all pixels of spans (whole image if spans is empty). border pixels are skipped
+	static double laplacianVariance(const LumaImage& image, const QVector<ScanlineSpan>& spans = QVector<ScanlineSpan>());
+	//mean squared sobel gradient magnitude over all pixels of spans (whole image if spans is empty). border pixels are skipped
+	static double tenengrad(const LumaImage& image, const QVector<ScanlineSpan>& spans = QVector<ScanlineSpan>());
+	static double compute(Method method, const LumaImage& image, const QVector<ScanlineSpan>& spans = QVector<ScanlineSpan>());
+};
+
+#endif //FOCUSMETRIC_H
@@ -0,0 +1,42 @@
+#include "frameanalyzer.h"
+
+
+FrameAnalyzer::FrameAnalyzer(QObject *parent)
+	: QObject(parent),
+	  pool(WorkStealingPool::globalInstance()),
+	  enabled(false),
+	  stopped(false)
+{
+}
+
+FrameAnalyzer::~FrameAnalyzer() {
+	this->stopWorker();
+}
+
+void FrameAnalyzer::stopWorker() {
+	this->enabled = false;
+	this->stopped = true;
+	//a task that was accepted by the pool always runs, so the wait ends after at most one analyzeFrame() call
+	this->busy.waitForAll();
+}
+
+void FrameAnalyzer::setEnabled(bool enabled) {
+	this->enabled = enabled && !this->stopped;
+}
+
+void FrameAnalyzer::submitFrame(const QVideoFrame& frame) {
+	if(!this->enabled || !frame.isValid()){
+		return;
+	}
+	//drop frame if the previous one is still being analyzed
+	if(!this->busy.tryAdd(1)){
+		return;
+	}
+	bool accepted = this->pool->trySubmit([this, frame]() {
+		this->analyzeFrame(frame);
+		this->busy.done();
+	});
+	if(!accepted){
+		this->busy.done();
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef FRAMEANALYZER_H
+#define FRAMEANALYZER_H
+
+#include <QObject>
+#include <QVideoFrame>
+#include "workstealingpool.h"
+
+
+//base class for all per-frame analysis stages. frames are submitted from the gui thread and analyzed as tasks on the shared WorkStealingPool.
+//while a frame is being analyzed (or if the pool is saturated) every newly submitted frame is dropped, so analysis never queues up and never slows down the live view.
+//derived classes implement analyzeFrame() and must call stopWorker() in their destructor
+class FrameAnalyzer : public QObject
+{
+	Q_OBJECT
+public:
+	explicit FrameAnalyzer(QObject *parent = nullptr);
+	~FrameAnalyzer();
+
+	bool isEnabled() const {return this->enabled;}
+
+protected:
+	//called on a pool thread, never concurrently for the same analyzer
+	virtual void analyzeFrame(const QVideoFrame& frame) = 0;
+	//disables the analyzer and waits until a running analyzeFrame() call has returned
+	void stopWorker();
+
+private:
+	WorkStealingPool* pool;
+	WorkStealingPool::TaskCounter busy;
+	bool enabled;
+	bool stopped;
+
+public slots:
+	void setEnabled(bool enabled);
+	void submitFrame(const QVideoFrame& frame);
+};
+
+#endif //FRAMEANALYZER_H
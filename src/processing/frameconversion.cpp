@@ -0,0 +1,206 @@
+#include "frameconversion.h"
+#include "demosaic.h"
+#include <QImage>
+
+
+namespace {
+	inline quint8 rgbToLuma(int r, int g, int b) {
+		//ITU-R BT.601 weights in 8 bit fixed point
+		return static_cast<quint8>((77*r + 150*g + 29*b) >> 8);
+	}
+
+	//samples luma at (x, y) for all supported pixel formats. bits and stride refer to plane 0
+	template <typename Sampler>
+	void decimate(LumaImage& dst, const QRect& rect, int decimation, Sampler sample) {
+		int outWidth = rect.width()/decimation;
+		int outHeight = rect.height()/decimation;
+		dst.resize(outWidth, outHeight);
+		for(int y = 0; y < outHeight; y++){
+			quint8* out = dst.line(y);
+			int sy = rect.top() + y*decimation;
+			if(decimation == 1){
+				for(int x = 0; x < outWidth; x++){
+					out[x] = sample(rect.left() + x, sy);
+				}
+			} else {
+				//2x2 box average suppresses noise and most of the aliasing of the decimated copy
+				for(int x = 0; x < outWidth; x++){
+					int sx = rect.left() + x*decimation;
+					out[x] = static_cast<quint8>((sample(sx, sy) + sample(sx+1, sy) + sample(sx, sy+1) + sample(sx+1, sy+1) + 2) >> 2);
+				}
+			}
+		}
+	}
+}
+
+bool FrameConversion::isLumaSupported(QVideoFrame::PixelFormat format) {
+	switch(format){
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY:
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21:
+		case QVideoFrame::Format_IMC1:
+		case QVideoFrame::Format_IMC2:
+		case QVideoFrame::Format_IMC3:
+		case QVideoFrame::Format_IMC4:
+		case QVideoFrame::Format_Y8:
+		case QVideoFrame::Format_Y16:
+		case QVideoFrame::Format_ARGB32:
+		case QVideoFrame::Format_ARGB32_Premultiplied:
+		case QVideoFrame::Format_RGB32:
+		case QVideoFrame::Format_BGRA32:
+		case QVideoFrame::Format_BGRA32_Premultiplied:
+		case QVideoFrame::Format_BGR32:
+		case QVideoFrame::Format_RGB24:
+		case QVideoFrame::Format_BGR24:
+		case QVideoFrame::Format_RGB565:
+		case QVideoFrame::Format_Jpeg:
+		case QVideoFrame::Format_CameraRaw:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool FrameConversion::lumaLayout(QVideoFrame::PixelFormat format, int* pixelStep, int* byteOffset) {
+	switch(format){
+		case QVideoFrame::Format_YUYV:
+			*pixelStep = 2;
+			*byteOffset = 0;
+			return true;
+		case QVideoFrame::Format_UYVY:
+		case QVideoFrame::Format_Y16:
+			//the high byte of little endian 16 bit samples, as in toLuma()
+			*pixelStep = 2;
+			*byteOffset = 1;
+			return true;
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21:
+		case QVideoFrame::Format_IMC1:
+		case QVideoFrame::Format_IMC2:
+		case QVideoFrame::Format_IMC3:
+		case QVideoFrame::Format_IMC4:
+		case QVideoFrame::Format_Y8:
+			*pixelStep = 1;
+			*byteOffset = 0;
+			return true;
+		default:
+			return false;
+	}
+}
+
+int FrameConversion::decimationForWidth(int width, int targetWidth) {
+	if(targetWidth <= 0){
+		return 1;
+	}
+	return qMax(1, (width + targetWidth - 1)/targetWidth);
+}
+
+LumaImage FrameConversion::toLuma(const QVideoFrame& frame, int decimation, QRect sourceRect) {
+	LumaImage luma;
+	QVideoFrame::PixelFormat format = frame.pixelFormat();
+	if(!isLumaSupported(format)){
+		return luma;
+	}
+
+	QRect frameRect(QPoint(0, 0), frame.size());
+	QRect rect = sourceRect.isNull() ? frameRect : sourceRect.intersected(frameRect);
+	decimation = qMax(1, decimation);
+	//the 2x2 average reads one pixel beyond every sample position
+	if(decimation > 1){
+		rect.setWidth(qMin(rect.width(), frameRect.right() - rect.left()));
+		rect.setHeight(qMin(rect.height(), frameRect.bottom() - rect.top()));
+	}
+	if(rect.width() < decimation || rect.height() < decimation){
+		return luma;
+	}
+
+	QVideoFrame mappedFrame(frame);
+	if(!mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		return luma;
+	}
+	const uchar* bits = mappedFrame.bits();
+	const int stride = mappedFrame.bytesPerLine();
+
+	switch(format){
+		case QVideoFrame::Format_YUYV:
+			decimate(luma, rect, decimation, [bits, stride](int x, int y) {return bits[y*stride + 2*x];});
+			break;
+		case QVideoFrame::Format_UYVY:
+			decimate(luma, rect, decimation, [bits, stride](int x, int y) {return bits[y*stride + 2*x + 1];});
+			break;
+		case QVideoFrame::Format_Y16:
+			decimate(luma, rect, decimation, [bits, stride](int x, int y) {return bits[y*stride + 2*x + 1];});
+			break;
+		case QVideoFrame::Format_ARGB32:
+		case QVideoFrame::Format_ARGB32_Premultiplied:
+		case QVideoFrame::Format_RGB32:
+			decimate(luma, rect, decimation, [bits, stride](int x, int y) {
+				quint32 p = reinterpret_cast<const quint32*>(bits + y*stride)[x];
+				return rgbToLuma((p >> 16) & 0xff, (p >> 8) & 0xff, p & 0xff);
+			});
+			break;
+		case QVideoFrame::Format_BGRA32:
+		case QVideoFrame::Format_BGRA32_Premultiplied:
+		case QVideoFrame::Format_BGR32:
+			decimate(luma, rect, decimation, [bits, stride](int x, int y) {
+				quint32 p = reinterpret_cast<const quint32*>(bits + y*stride)[x];
+				return rgbToLuma((p >> 8) & 0xff, (p >> 16) & 0xff, (p >> 24) & 0xff);
+			});
+			break;
+		case QVideoFrame::Format_RGB24:
+			decimate(luma, rect, decimation, [bits, stride](int x, int y) {
+				const uchar* p = bits + y*stride + 3*x;
+				return rgbToLuma(p[0], p[1], p[2]);
+			});
+			break;
+		case QVideoFrame::Format_BGR24:
+			decimate(luma, rect, decimation, [bits, stride](int x, int y) {
+				const uchar* p = bits + y*stride + 3*x;
+				return rgbToLuma(p[2], p[1], p[0]);
+			});
+			break;
+		case QVideoFrame::Format_RGB565:
+			decimate(luma, rect, decimation, [bits, stride](int x, int y) {
+				quint16 p = reinterpret_cast<const quint16*>(bits + y*stride)[x];
+				return rgbToLuma(((p >> 11) & 0x1f) << 3, ((p >> 5) & 0x3f) << 2, (p & 0x1f) << 3);
+			});
+			break;
+		case QVideoFrame::Format_CameraRaw: {
+			//every 2x2 window of a Bayer mosaic holds one red, two green and one blue sample, their average is close to luma and free of the
+			//pattern. 16 bit samples contribute their high byte, like Y16
+			const int right = frame.width() - 1;
+			const int bottom = frame.height() - 1;
+			const int sampleSize = Demosaic::bytesPerSample(frame.width(), stride);
+			const int offset = sampleSize - 1;
+			decimate(luma, rect, decimation, [bits, stride, right, bottom, sampleSize, offset](int x, int y) {
+				const uchar* row0 = bits + y*stride + offset;
+				const uchar* row1 = bits + qMin(y + 1, bottom)*stride + offset;
+				int x1 = qMin(x + 1, right);
+				return static_cast<quint8>((row0[x*sampleSize] + row0[x1*sampleSize] + row1[x*sampleSize] + row1[x1*sampleSize] + 2) >> 2);
+			});
+			break;
+		}
+		case QVideoFrame::Format_Jpeg: {
+			QImage image = QImage::fromData(bits, mappedFrame.mappedBytes(), "JPG").convertToFormat(QImage::Format_Grayscale8);
+			if(!image.isNull()){
+				const uchar* grayBits = image.constBits();
+				const int grayStride = image.bytesPerLine();
+				rect = rect.intersected(image.rect());
+				decimate(luma, rect, decimation, [grayBits, grayStride](int x, int y) {return grayBits[y*grayStride + x];});
+			}
+			break;
+		}
+		default:
+			//all remaining supported formats are planar or semi-planar with a full resolution 8 bit Y plane first
+			decimate(luma, rect, decimation, [bits, stride](int x, int y) {return bits[y*stride + x];});
+			break;
+	}
+
+	mappedFrame.unmap();
+	return luma;
+}
@@ -0,0 +1,27 @@
+#ifndef FRAMECONVERSION_H
+#define FRAMECONVERSION_H
+
+#include <QVideoFrame>
+#include <QRect>
+#include "lumaimage.h"
+
+
+class FrameConversion
+{
+public:
+	//returns true if the pixel format can be converted by toLuma()
+	static bool isLumaSupported(QVideoFrame::PixelFormat format);
+
+	//extracts the luma channel of sourceRect (frame pixel coordinates, whole frame if null) and decimates it by averaging 2x2 pixels every decimation-th pixel.
+	//the frame is mapped read only for the duration of the call. returns a null image for unsupported formats
+	static LumaImage toLuma(const QVideoFrame& frame, int decimation = 1, QRect sourceRect = QRect());
+
+	//returns true if the luma of the pixel format can be read in place: 8 bit at y*bytesPerLine + x*pixelStep + byteOffset of plane 0.
+	//sparse samplers use this to avoid a luma copy of the whole area they touch
+	static bool lumaLayout(QVideoFrame::PixelFormat format, int* pixelStep, int* byteOffset);
+
+	//smallest decimation factor that brings width down to at most targetWidth
+	static int decimationForWidth(int width, int targetWidth);
+};
+
+#endif //FRAMECONVERSION_H
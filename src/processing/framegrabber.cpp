@@ -0,0 +1,102 @@
+#include "framegrabber.h"
+#include "frameconversion.h"
+
+
+FrameGrabber::FrameGrabber(QObject *parent)
+	: FrameAnalyzer(parent),
+	  demosaic(nullptr),
+	  windowLevel(nullptr)
+{
+}
+
+FrameGrabber::~FrameGrabber() {
+	this->stopWorker();
+}
+
+void FrameGrabber::requestFrame(QSize maxSize, bool grayscale, Callback callback) {
+	Request request;
+	request.maxSize = maxSize;
+	request.grayscale = grayscale;
+	request.callback = callback;
+	QMutexLocker locker(&this->mutex);
+	this->pendingRequests.append(request);
+	locker.unlock();
+	this->setEnabled(true);
+}
+
+void FrameGrabber::analyzeFrame(const QVideoFrame& frame) {
+	QList<Request> requests;
+	{
+		QMutexLocker locker(&this->mutex);
+		requests.swap(this->pendingRequests);
+	}
+	if(requests.isEmpty()){
+		return;
+	}
+
+	//the full resolution rgb conversion is done at most once per frame, even for many requests
+	QImage rgbFrame;
+	for(const Request& request : requests){
+		QImage image = this->grab(frame, &rgbFrame, request.maxSize, request.grayscale);
+		Callback callback = request.callback;
+		qint64 timestamp = frame.startTime();
+		QMetaObject::invokeMethod(this, [callback, image, timestamp]() { callback(image, timestamp); }, Qt::QueuedConnection);
+	}
+
+	//stay enabled only if new requests came in while converting
+	QMutexLocker locker(&this->mutex);
+	if(this->pendingRequests.isEmpty()){
+		locker.unlock();
+		QMetaObject::invokeMethod(this, [this]() {
+			QMutexLocker locker(&this->mutex);
+			if(this->pendingRequests.isEmpty()){
+				locker.unlock();
+				this->setEnabled(false);
+			}
+		}, Qt::QueuedConnection);
+	}
+}
+
+QImage FrameGrabber::toRgb(const QVideoFrame& frame, const Demosaic* demosaic, const WindowLevel* windowLevel) {
+	if(Demosaic::isRawFormat(frame.pixelFormat())){
+		return Demosaic::toImage(frame, demosaic != nullptr ? demosaic->getSettings() : DemosaicSettings());
+	}
+	if(WindowLevel::isWindowedFormat(frame.pixelFormat())){
+		int low = 0;
+		int high = 65535;
+		if(windowLevel != nullptr){
+			windowLevel->getWindow(&low, &high);
+		}
+		return WindowLevel::toImage(frame, low, high);
+	}
+	return frame.image();
+}
+
+QImage FrameGrabber::grab(const QVideoFrame& frame, QImage* rgbFrame, QSize maxSize, bool grayscale) const {
+	QSize targetSize = frame.size().scaled(maxSize.boundedTo(frame.size()), Qt::KeepAspectRatio);
+	if(targetSize.isEmpty()){
+		return QImage();
+	}
+
+	//grayscale is taken from the luma channel with decimation, which avoids the rgb conversion of the full frame
+	if(grayscale && FrameConversion::isLumaSupported(frame.pixelFormat())){
+		LumaImage luma = FrameConversion::toLuma(frame, qMax(1, frame.width()/targetSize.width()));
+		if(!luma.isNull()){
+			//lumaImage only references the luma data, the returned image has to be a deep copy
+			QImage lumaImage(luma.data.constData(), luma.width, luma.height, luma.width, QImage::Format_Grayscale8);
+			if(lumaImage.size() == targetSize){
+				return lumaImage.copy();
+			}
+			return lumaImage.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+		}
+	}
+
+	if(rgbFrame->isNull()){
+		*rgbFrame = toRgb(frame, this->demosaic, this->windowLevel);
+		if(rgbFrame->isNull()){
+			return QImage();
+		}
+	}
+	QImage scaled = rgbFrame->scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	return scaled.convertToFormat(grayscale ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+}
@@ -0,0 +1,51 @@
+#ifndef FRAMEGRABBER_H
+#define FRAMEGRABBER_H
+
+#include <QMutex>
+#include <QList>
+#include <QImage>
+#include <functional>
+#include "frameanalyzer.h"
+#include "demosaic.h"
+#include "windowlevel.h"
+
+
+//delivers downscaled copies of the next frame on request (e.g. for the control API). all requests that are pending when a frame arrives
+//are answered from this frame, the conversion runs on the shared WorkStealingPool. callbacks are called on the thread of the grabber
+class FrameGrabber : public FrameAnalyzer
+{
+	Q_OBJECT
+public:
+	typedef std::function<void(const QImage& image, qint64 timestamp)> Callback;
+
+	explicit FrameGrabber(QObject *parent = nullptr);
+	~FrameGrabber();
+
+	//image is Format_Grayscale8 or Format_RGB888 and fits into maxSize, keeping the aspect ratio
+	void requestFrame(QSize maxSize, bool grayscale, Callback callback);
+	//settings for the conversion of raw frames are taken from demosaic, which has to outlive the grabber
+	void setDemosaic(const Demosaic* demosaic) {this->demosaic = demosaic;}
+	//16 bit monochrome frames are converted with the current display window of windowLevel, which has to outlive the grabber
+	void setWindowLevel(const WindowLevel* windowLevel) {this->windowLevel = windowLevel;}
+
+	//full resolution rgb image of any frame format, raw and 16 bit frames are converted with the settings of demosaic and windowLevel (may be nullptr)
+	static QImage toRgb(const QVideoFrame& frame, const Demosaic* demosaic, const WindowLevel* windowLevel);
+
+protected:
+	void analyzeFrame(const QVideoFrame& frame) override;
+
+private:
+	struct Request {
+		QSize maxSize;
+		bool grayscale;
+		Callback callback;
+	};
+	QMutex mutex;
+	QList<Request> pendingRequests;
+	const Demosaic* demosaic;
+	const WindowLevel* windowLevel;
+
+	QImage grab(const QVideoFrame& frame, QImage* rgbFrame, QSize maxSize, bool grayscale) const;
+};
+
+#endif //FRAMEGRABBER_H
@@ -0,0 +1,178 @@
+#include "frametapsurface.h"
+
+
+FrameTapSurface::FrameTapSurface(QAbstractVideoSurface* displaySurface, QObject *parent)
+	: QAbstractVideoSurface(parent),
+	  displaySurface(displaySurface),
+	  displayInterval(0),
+	  displayedFrames(0),
+	  skippedFrames(0),
+	  firstFramePending(false),
+	  displayFilter(nullptr),
+	  demosaic(nullptr),
+	  windowLevel(nullptr),
+	  referenceComparison(nullptr),
+	  lensUndistortion(nullptr),
+	  displayMipmap(nullptr)
+{
+}
+
+FrameTapSurface::~FrameTapSurface() {
+	this->stop();
+}
+
+QList<QVideoFrame::PixelFormat> FrameTapSurface::supportedPixelFormats(QAbstractVideoBuffer::HandleType type) const {
+	if(type != QAbstractVideoBuffer::NoHandle || this->displaySurface.isNull()){
+		return QList<QVideoFrame::PixelFormat>();
+	}
+	QList<QVideoFrame::PixelFormat> formats = this->displaySurface->supportedPixelFormats(type);
+	if(this->demosaic != nullptr && !formats.contains(QVideoFrame::Format_CameraRaw)){
+		formats.append(QVideoFrame::Format_CameraRaw);
+	}
+	if(this->windowLevel != nullptr && !formats.contains(QVideoFrame::Format_Y16)){
+		formats.append(QVideoFrame::Format_Y16);
+	}
+	return formats;
+}
+
+bool FrameTapSurface::isFormatSupported(const QVideoSurfaceFormat& format) const {
+	if(format.handleType() != QAbstractVideoBuffer::NoHandle || this->displaySurface.isNull()){
+		return false;
+	}
+	if(this->isConvertedFormat(format.pixelFormat())){
+		return true;
+	}
+	return this->displaySurface->isFormatSupported(format);
+}
+
+bool FrameTapSurface::start(const QVideoSurfaceFormat& format) {
+	if(this->displaySurface.isNull() || !this->isFormatSupported(format)){
+		this->setError(QAbstractVideoSurface::UnsupportedFormatError);
+		return false;
+	}
+	if(this->displaySurface->isActive()){
+		this->displaySurface->stop();
+	}
+	QVideoSurfaceFormat displayFormat = format;
+	if(this->isConvertedFormat(format.pixelFormat())){
+		displayFormat = QVideoSurfaceFormat(format.frameSize(), QVideoFrame::Format_RGB32);
+		displayFormat.setScanLineDirection(format.scanLineDirection());
+		displayFormat.setMirrored(format.isMirrored());
+	}
+	if(!this->displaySurface->start(displayFormat)){
+		this->setError(this->displaySurface->error());
+		return false;
+	}
+	this->firstFramePending = true;
+	return QAbstractVideoSurface::start(format);
+}
+
+void FrameTapSurface::stop() {
+	if(!this->displaySurface.isNull() && this->displaySurface->isActive()){
+		this->displaySurface->stop();
+	}
+	QAbstractVideoSurface::stop();
+}
+
+bool FrameTapSurface::present(const QVideoFrame& frame) {
+	if(this->firstFramePending){
+		this->firstFramePending = false;
+		emit firstFramePresented(frame.size());
+	}
+	if(this->displayInterval > 0 && this->displayTimer.isValid() && this->displayTimer.elapsed() < this->displayInterval){
+		this->skippedFrames++;
+		emit frameAvailable(frame);
+		return true;
+	}
+	this->displayTimer.start();
+	this->displayedFrames++;
+	if(!this->presentToDisplay(frame)){
+		return false;
+	}
+	emit frameAvailable(frame);
+	emit frameDisplayed();
+	return true;
+}
+
+bool FrameTapSurface::presentToDisplay(const QVideoFrame& frame) {
+	if(this->displaySurface.isNull()){
+		this->setError(QAbstractVideoSurface::StoppedError);
+		return false;
+	}
+	QVideoFrame displayFrame = frame;
+	QVideoSurfaceFormat displayFormat = this->surfaceFormat();
+	if(this->isConvertedFormat(frame.pixelFormat())){
+		QVideoFrame convertedFrame = this->convertForDisplay(frame);
+		if(!convertedFrame.isValid()){
+			//the display surface can not show the frame as it is. the frame is still published for recording and analysis
+			return true;
+		}
+		displayFrame = convertedFrame;
+		displayFormat = this->displayFormatFor(convertedFrame.pixelFormat(), convertedFrame.size());
+	}
+	if(this->lensUndistortion != nullptr && this->lensUndistortion->isActive()){
+		QVideoFrame undistortedFrame = this->lensUndistortion->process(displayFrame);
+		if(undistortedFrame.isValid()){
+			displayFrame = undistortedFrame;
+			displayFormat = this->displayFormatFor(undistortedFrame.pixelFormat(), undistortedFrame.size());
+		}
+	}
+	if(this->displayMipmap != nullptr && this->displayMipmap->isActive()){
+		QVideoFrame reducedFrame = this->displayMipmap->process(displayFrame);
+		if(reducedFrame.isValid()){
+			displayFrame = reducedFrame;
+			displayFormat = this->displayFormatFor(reducedFrame.pixelFormat(), reducedFrame.size());
+		}
+	}
+	if(this->referenceComparison != nullptr && this->referenceComparison->isActive()){
+		QVideoFrame comparedFrame = this->referenceComparison->process(displayFrame);
+		if(comparedFrame.isValid()){
+			displayFrame = comparedFrame;
+			displayFormat = this->displayFormatFor(comparedFrame.pixelFormat(), comparedFrame.size());
+		}
+	}
+	if(this->displayFilter != nullptr && this->displayFilter->isActive()){
+		QVideoFrame adjustedFrame = this->displayFilter->process(displayFrame);
+		if(adjustedFrame.isValid()){
+			displayFrame = adjustedFrame;
+			displayFormat = this->displayFormatFor(adjustedFrame.pixelFormat(), adjustedFrame.size());
+		}
+	}
+
+	//the display surface is restarted when format or size of the displayed frames change, e.g. when the filter is switched on or off
+	//(the filtered frames are always RGB32) or when the mip level changes
+	QVideoSurfaceFormat currentFormat = this->displaySurface->surfaceFormat();
+	if(currentFormat.pixelFormat() != displayFormat.pixelFormat() || currentFormat.frameSize() != displayFormat.frameSize()){
+		this->displaySurface->stop();
+		if(!this->displaySurface->start(displayFormat)){
+			this->setError(this->displaySurface->error());
+			return false;
+		}
+	}
+	if(!this->displaySurface->present(displayFrame)){
+		this->setError(this->displaySurface->error());
+		return false;
+	}
+	return true;
+}
+
+bool FrameTapSurface::isConvertedFormat(QVideoFrame::PixelFormat pixelFormat) const {
+	return (this->demosaic != nullptr && Demosaic::isRawFormat(pixelFormat)) || (this->windowLevel != nullptr && WindowLevel::isWindowedFormat(pixelFormat));
+}
+
+QVideoFrame FrameTapSurface::convertForDisplay(const QVideoFrame& frame) {
+	if(this->demosaic != nullptr && Demosaic::isRawFormat(frame.pixelFormat())){
+		return this->demosaic->process(frame);
+	}
+	if(this->windowLevel != nullptr && WindowLevel::isWindowedFormat(frame.pixelFormat())){
+		return this->windowLevel->process(frame);
+	}
+	return frame;
+}
+
+QVideoSurfaceFormat FrameTapSurface::displayFormatFor(QVideoFrame::PixelFormat pixelFormat, const QSize& size) const {
+	QVideoSurfaceFormat displayFormat(size, pixelFormat);
+	displayFormat.setScanLineDirection(this->surfaceFormat().scanLineDirection());
+	displayFormat.setMirrored(this->surfaceFormat().isMirrored());
+	return displayFormat;
+}
@@ -0,0 +1,80 @@
+#ifndef FRAMETAPSURFACE_H
+#define FRAMETAPSURFACE_H
+
+#include <QAbstractVideoSurface>
+#include <QVideoSurfaceFormat>
+#include <QPointer>
+#include <QElapsedTimer>
+#include "imageadjustment.h"
+#include "demosaic.h"
+#include "windowlevel.h"
+#include "referencecomparison.h"
+#include "displaymipmap.h"
+#include "lensundistortion.h"
+
+
+//video surface that is set as viewfinder of the camera. every frame is forwarded unchanged to the display surface (the surface of the QGraphicsVideoItem)
+//and additionally published via frameAvailable() so that analysis stages can work on the same frames without a second capture path.
+//only frames in system memory are negotiated (NoHandle), as analysis stages need to map the frame data.
+//Bayer mosaics (Format_CameraRaw) and 16 bit monochrome frames (Format_Y16) are accepted in addition to the formats of the display surface if
+//a demosaic or window/level stage is set, they are converted to RGB32 for the display.
+//the conversion and scaling stages run on the gui thread but split every frame into bands on the shared WorkStealingPool (parallelFor).
+//the final color conversion and scaling of the display surface is done by the renderer of Qt Multimedia and stays on the gui thread
+class FrameTapSurface : public QAbstractVideoSurface
+{
+	Q_OBJECT
+public:
+	explicit FrameTapSurface(QAbstractVideoSurface* displaySurface, QObject *parent = nullptr);
+	~FrameTapSurface();
+
+	QList<QVideoFrame::PixelFormat> supportedPixelFormats(QAbstractVideoBuffer::HandleType type = QAbstractVideoBuffer::NoHandle) const override;
+	bool isFormatSupported(const QVideoSurfaceFormat& format) const override;
+	bool start(const QVideoSurfaceFormat& format) override;
+	void stop() override;
+	bool present(const QVideoFrame& frame) override;
+
+	//minimum time between two displayed frames, 0 displays every frame. frames that are not displayed are still published via frameAvailable()
+	void setDisplayInterval(int ms) {this->displayInterval = ms;}
+	int getDisplayInterval() const {return this->displayInterval;}
+	quint64 getDisplayedFrames() const {return this->displayedFrames;}
+	quint64 getSkippedFrames() const {return this->skippedFrames;}
+	//optional software processing of the displayed frames. frames published via frameAvailable() are not affected
+	void setDisplayFilter(ImageAdjustment* filter) {this->displayFilter = filter;}
+	//conversion of raw frames for the display. frames published via frameAvailable() stay raw
+	void setDemosaic(Demosaic* demosaic) {this->demosaic = demosaic;}
+	void setWindowLevel(WindowLevel* windowLevel) {this->windowLevel = windowLevel;}
+	//comparison of the displayed frames with a reference image, applied before the display filter
+	void setReferenceComparison(ReferenceComparison* comparison) {this->referenceComparison = comparison;}
+	//removal of the lens distortion, applied first so the following stages and the overlays see the corrected geometry
+	void setLensUndistortion(LensUndistortion* undistortion) {this->lensUndistortion = undistortion;}
+	//reduction of the displayed frames to the resolution of the view, applied right after the undistortion so the following stages work on fewer pixels
+	void setDisplayMipmap(DisplayMipmap* mipmap) {this->displayMipmap = mipmap;}
+
+private:
+	QPointer<QAbstractVideoSurface> displaySurface;
+	int displayInterval;
+	QElapsedTimer displayTimer;
+	quint64 displayedFrames;
+	quint64 skippedFrames;
+	bool firstFramePending;
+	ImageAdjustment* displayFilter;
+	Demosaic* demosaic;
+	WindowLevel* windowLevel;
+	ReferenceComparison* referenceComparison;
+	LensUndistortion* lensUndistortion;
+	DisplayMipmap* displayMipmap;
+
+	bool isConvertedFormat(QVideoFrame::PixelFormat pixelFormat) const;
+	QVideoFrame convertForDisplay(const QVideoFrame& frame);
+	bool presentToDisplay(const QVideoFrame& frame);
+	QVideoSurfaceFormat displayFormatFor(QVideoFrame::PixelFormat pixelFormat, const QSize& size) const;
+
+signals:
+	void frameAvailable(const QVideoFrame& frame);
+	//emitted after frameAvailable() for the frames that were shown, not for the frames kept from the display by the display interval
+	void frameDisplayed();
+	//emitted for the first frame after each start(), e.g. to measure how long a camera needs to deliver frames
+	void firstFramePresented(QSize size);
+};
+
+#endif //FRAMETAPSURFACE_H
@@ -0,0 +1,299 @@
+#include "imageadjustment.h"
+#include "workstealingpool.h"
+#include "simd.h"
+#include <QtMath>
+#include <cstring>
+
+
+namespace {
+	inline int clamp8(int value) {
+		return value < 0 ? 0 : (value > 255 ? 255 : value);
+	}
+
+	//piecewise linear colour map from evenly spaced stops
+	quint32 interpolateStops(const quint8 stops[][3], int count, int value) {
+		int scaled = value*(count - 1);
+		int index = qMin(scaled/255, count - 2);
+		int fraction = scaled - index*255;
+		int r = stops[index][0] + (stops[index + 1][0] - stops[index][0])*fraction/255;
+		int g = stops[index][1] + (stops[index + 1][1] - stops[index][1])*fraction/255;
+		int b = stops[index][2] + (stops[index + 1][2] - stops[index][2])*fraction/255;
+		return 0xff000000u | (static_cast<quint32>(r) << 16) | (static_cast<quint32>(g) << 8) | static_cast<quint32>(b);
+	}
+}
+
+
+bool ImageAdjustmentSettings::isIdentity() const {
+	return qFuzzyIsNull(this->brightness) && qFuzzyIsNull(this->contrast) && qFuzzyCompare(this->gamma, 1.0)
+		&& this->sharpening <= 0.0 && this->falseColor == ImageAdjustment::NO_FALSE_COLOR;
+}
+
+bool ImageAdjustmentSettings::operator==(const ImageAdjustmentSettings& other) const {
+	return qFuzzyCompare(this->brightness + 2.0, other.brightness + 2.0)
+		&& qFuzzyCompare(this->contrast + 2.0, other.contrast + 2.0)
+		&& qFuzzyCompare(this->gamma, other.gamma)
+		&& qFuzzyCompare(this->sharpening + 2.0, other.sharpening + 2.0)
+		&& this->falseColor == other.falseColor;
+}
+
+
+ImageAdjustment::ImageAdjustment()
+	: tables(buildTables(ImageAdjustmentSettings())),
+	  active(0)
+{
+}
+
+void ImageAdjustment::setSettings(const ImageAdjustmentSettings& settings) {
+	QMutexLocker locker(&this->mutex);
+	if(settings == this->settings){
+		return;
+	}
+	this->settings = settings;
+	this->tables = buildTables(settings);
+	this->active.storeRelease(settings.isIdentity() ? 0 : 1);
+}
+
+ImageAdjustmentSettings ImageAdjustment::getSettings() const {
+	QMutexLocker locker(&this->mutex);
+	return this->settings;
+}
+
+QStringList ImageAdjustment::falseColorNames() {
+	return QStringList() << QObject::tr("None") << QObject::tr("Hot") << QObject::tr("Jet") << QObject::tr("Inferno");
+}
+
+QSharedPointer<const ImageAdjustment::Tables> ImageAdjustment::buildTables(const ImageAdjustmentSettings& settings) {
+	QSharedPointer<Tables> tables(new Tables);
+
+	//contrast -1..1 maps to a slope of 0..inf around mid gray, brightness shifts by up to half the range, gamma is applied last
+	qreal contrast = qBound(-1.0, settings.contrast, 0.99);
+	qreal slope = contrast < 0.0 ? 1.0 + contrast : 1.0/(1.0 - contrast);
+	qreal inverseGamma = 1.0/qBound(0.2, settings.gamma, 5.0);
+	quint8 curve[256];
+	for(int i = 0; i < 256; i++){
+		qreal value = (i/255.0 - 0.5)*slope + 0.5 + 0.5*settings.brightness;
+		value = qBound(0.0, value, 1.0);
+		curve[i] = static_cast<quint8>(clamp8(qRound(qPow(value, inverseGamma)*255.0)));
+	}
+
+	tables->useFalseColor = settings.falseColor != NO_FALSE_COLOR;
+	for(int i = 0; i < 256; i++){
+		if(tables->useFalseColor){
+			//rgb is reduced to BT.601 luma first, the curve is applied to the luma in the false colour table
+			tables->red[i] = static_cast<quint32>(77*i);
+			tables->green[i] = static_cast<quint32>(150*i);
+			tables->blue[i] = static_cast<quint32>(29*i);
+			tables->falseColor[i] = falseColorValue(settings.falseColor, curve[i]);
+		} else {
+			tables->red[i] = 0xff000000u | (static_cast<quint32>(curve[i]) << 16);
+			tables->green[i] = static_cast<quint32>(curve[i]) << 8;
+			tables->blue[i] = curve[i];
+			tables->falseColor[i] = 0;
+		}
+	}
+	tables->sharpenAmount = settings.sharpening > 0.0 ? qMin(32767, qRound(qMin(settings.sharpening, 1.0)*2.0*4096.0)) : 0;
+	return tables;
+}
+
+quint32 ImageAdjustment::falseColorValue(int map, int value) {
+	switch(map){
+		case HOT: {
+			int r = clamp8(3*value);
+			int g = clamp8(3*value - 255);
+			int b = clamp8(3*value - 510);
+			return 0xff000000u | (static_cast<quint32>(r) << 16) | (static_cast<quint32>(g) << 8) | static_cast<quint32>(b);
+		}
+		case JET: {
+			static const quint8 stops[][3] = {{0, 0, 128}, {0, 0, 255}, {0, 255, 255}, {255, 255, 0}, {255, 0, 0}, {128, 0, 0}};
+			return interpolateStops(stops, 6, value);
+		}
+		case INFERNO: {
+			static const quint8 stops[][3] = {{0, 0, 4}, {40, 11, 84}, {101, 21, 110}, {159, 42, 99}, {212, 72, 66}, {245, 125, 21}, {250, 193, 39}, {252, 255, 164}};
+			return interpolateStops(stops, 8, value);
+		}
+		default:
+			return 0xff000000u | (static_cast<quint32>(value) << 16) | (static_cast<quint32>(value) << 8) | static_cast<quint32>(value);
+	}
+}
+
+QImage ImageAdjustment::takeOutputBuffer(const QSize& size) {
+	//a buffer can be reused once the display released the frame that wrapped it. it is taken out of the list, so writing to it does not detach
+	for(int i = 0; i < this->outputBuffers.size(); i++){
+		if(this->outputBuffers.at(i).size() == size && this->outputBuffers.at(i).isDetached()){
+			return this->outputBuffers.takeAt(i);
+		}
+	}
+	return QImage(size, QImage::Format_RGB32);
+}
+
+void ImageAdjustment::recycleOutputBuffer(const QImage& buffer) {
+	this->outputBuffers.append(buffer);
+	while(this->outputBuffers.size() > OUTPUT_BUFFERS){
+		this->outputBuffers.removeFirst();
+	}
+}
+
+QVideoFrame ImageAdjustment::process(const QVideoFrame& frame) {
+	QSharedPointer<const Tables> currentTables;
+	{
+		QMutexLocker locker(&this->mutex);
+		currentTables = this->tables;
+	}
+
+	//32 bit rgb frames are read directly, everything else is converted by Qt first
+	QVideoFrame mappedFrame(frame);
+	QImage converted;
+	const uchar* src = nullptr;
+	int srcStride = 0;
+	int redShift = 16;
+	int greenShift = 8;
+	int blueShift = 0;
+	bool mapped = false;
+	switch(frame.pixelFormat()){
+		case QVideoFrame::Format_RGB32:
+		case QVideoFrame::Format_ARGB32:
+		case QVideoFrame::Format_ARGB32_Premultiplied:
+		case QVideoFrame::Format_BGR32:
+		case QVideoFrame::Format_BGRA32:
+		case QVideoFrame::Format_BGRA32_Premultiplied:
+			if(mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+				mapped = true;
+				src = mappedFrame.bits();
+				srcStride = mappedFrame.bytesPerLine();
+				if(frame.pixelFormat() != QVideoFrame::Format_RGB32 && frame.pixelFormat() != QVideoFrame::Format_ARGB32 && frame.pixelFormat() != QVideoFrame::Format_ARGB32_Premultiplied){
+					redShift = 8;
+					greenShift = 16;
+					blueShift = 24;
+				}
+			}
+			break;
+		default:
+			break;
+	}
+	if(!mapped){
+		converted = frame.image();
+		if(converted.isNull()){
+			return QVideoFrame();
+		}
+		if(converted.format() != QImage::Format_RGB32 && converted.format() != QImage::Format_ARGB32){
+			converted = converted.convertToFormat(QImage::Format_RGB32);
+		}
+		src = converted.constBits();
+		srcStride = converted.bytesPerLine();
+	}
+
+	QSize size = frame.size();
+	QImage adjusted = this->takeOutputBuffer(size);
+	applyTables(src, srcStride, redShift, greenShift, blueShift, adjusted, *currentTables);
+	if(mapped){
+		mappedFrame.unmap();
+	}
+	if(currentTables->sharpenAmount > 0){
+		QImage sharpened = this->takeOutputBuffer(size);
+		unsharpMask(adjusted, sharpened, currentTables->sharpenAmount);
+		this->recycleOutputBuffer(adjusted);
+		adjusted = sharpened;
+	}
+	//the frame shares the buffer with the list, the buffer becomes reusable as soon as the display drops the frame
+	this->recycleOutputBuffer(adjusted);
+	return QVideoFrame(adjusted);
+}
+
+void ImageAdjustment::applyTables(const uchar* src, int srcStride, int redShift, int greenShift, int blueShift, QImage& dst, const Tables& tables) {
+	const int width = dst.width();
+	const int height = dst.height();
+	uchar* dstBits = dst.bits();
+	const int dstStride = dst.bytesPerLine();
+	const int bands = (height + BAND_HEIGHT - 1)/BAND_HEIGHT;
+	WorkStealingPool::globalInstance()->parallelFor(bands, [&](int band) {
+		int y1 = qMin(height, (band + 1)*BAND_HEIGHT);
+		for(int y = band*BAND_HEIGHT; y < y1; y++){
+			const quint32* in = reinterpret_cast<const quint32*>(src + y*srcStride);
+			quint32* out = reinterpret_cast<quint32*>(dstBits + y*dstStride);
+			if(tables.useFalseColor){
+				for(int x = 0; x < width; x++){
+					quint32 p = in[x];
+					quint32 luma = (tables.red[(p >> redShift) & 0xff] + tables.green[(p >> greenShift) & 0xff] + tables.blue[(p >> blueShift) & 0xff]) >> 8;
+					out[x] = tables.falseColor[luma];
+				}
+			} else {
+				//unrolled by 4, the lookups of neighbouring pixels are independent and can be issued in parallel
+				int x = 0;
+				for(; x + 4 <= width; x += 4){
+					quint32 p0 = in[x];
+					quint32 p1 = in[x + 1];
+					quint32 p2 = in[x + 2];
+					quint32 p3 = in[x + 3];
+					out[x] = tables.red[(p0 >> redShift) & 0xff] | tables.green[(p0 >> greenShift) & 0xff] | tables.blue[(p0 >> blueShift) & 0xff];
+					out[x + 1] = tables.red[(p1 >> redShift) & 0xff] | tables.green[(p1 >> greenShift) & 0xff] | tables.blue[(p1 >> blueShift) & 0xff];
+					out[x + 2] = tables.red[(p2 >> redShift) & 0xff] | tables.green[(p2 >> greenShift) & 0xff] | tables.blue[(p2 >> blueShift) & 0xff];
+					out[x + 3] = tables.red[(p3 >> redShift) & 0xff] | tables.green[(p3 >> greenShift) & 0xff] | tables.blue[(p3 >> blueShift) & 0xff];
+				}
+				for(; x < width; x++){
+					quint32 p = in[x];
+					out[x] = tables.red[(p >> redShift) & 0xff] | tables.green[(p >> greenShift) & 0xff] | tables.blue[(p >> blueShift) & 0xff];
+				}
+			}
+		}
+	});
+}
+
+void ImageAdjustment::unsharpMask(const QImage& src, QImage& dst, int amount) {
+	const int width = src.width();
+	const int height = src.height();
+	const int rowBytes = width*4;
+	const uchar* srcBits = src.constBits();
+	const int srcStride = src.bytesPerLine();
+	uchar* dstBits = dst.bits();
+	const int dstStride = dst.bytesPerLine();
+	const int bands = (height + BAND_HEIGHT - 1)/BAND_HEIGHT;
+
+	//out = in + amount*(in - box3x3(in)), applied to every byte. alpha is 255 everywhere and therefore not changed. border pixels are copied
+	WorkStealingPool::globalInstance()->parallelFor(bands, [&](int band) {
+		int y1 = qMin(height, (band + 1)*BAND_HEIGHT);
+		for(int y = band*BAND_HEIGHT; y < y1; y++){
+			const uchar* row = srcBits + y*srcStride;
+			uchar* out = dstBits + y*dstStride;
+			if(y == 0 || y == height - 1 || width < 3){
+				memcpy(out, row, rowBytes);
+				continue;
+			}
+			const uchar* above = row - srcStride;
+			const uchar* below = row + srcStride;
+			memcpy(out, row, 4);
+			int i = 4;
+#ifdef CAMERAEXTENSION_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i ninth = _mm_set1_epi16(7282); //65536/9
+			const __m128i gain = _mm_set1_epi16(static_cast<short>(amount));
+			for(; i + 16 <= rowBytes - 4; i += 16){
+				__m128i sumLo = zero;
+				__m128i sumHi = zero;
+				const uchar* rows[3] = {above, row, below};
+				for(const uchar* r : rows){
+					__m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i - 4));
+					__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i));
+					__m128i rr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i + 4));
+					sumLo = _mm_add_epi16(sumLo, _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(l, zero), _mm_unpacklo_epi8(c, zero)), _mm_unpacklo_epi8(rr, zero)));
+					sumHi = _mm_add_epi16(sumHi, _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(l, zero), _mm_unpackhi_epi8(c, zero)), _mm_unpackhi_epi8(rr, zero)));
+				}
+				__m128i center = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+				__m128i centerLo = _mm_unpacklo_epi8(center, zero);
+				__m128i centerHi = _mm_unpackhi_epi8(center, zero);
+				__m128i diffLo = _mm_sub_epi16(centerLo, _mm_mulhi_epu16(sumLo, ninth));
+				__m128i diffHi = _mm_sub_epi16(centerHi, _mm_mulhi_epu16(sumHi, ninth));
+				//(diff*16*amount) >> 16 == diff*amount/4096
+				__m128i resultLo = _mm_add_epi16(centerLo, _mm_mulhi_epi16(_mm_slli_epi16(diffLo, 4), gain));
+				__m128i resultHi = _mm_add_epi16(centerHi, _mm_mulhi_epi16(_mm_slli_epi16(diffHi, 4), gain));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(resultLo, resultHi));
+			}
+#endif
+			for(; i < rowBytes - 4; i++){
+				int sum = above[i - 4] + above[i] + above[i + 4] + row[i - 4] + row[i] + row[i + 4] + below[i - 4] + below[i] + below[i + 4];
+				int diff = row[i] - ((sum*7282) >> 16);
+				out[i] = static_cast<uchar>(clamp8(row[i] + ((diff*16*amount) >> 16)));
+			}
+			memcpy(out + rowBytes - 4, row + rowBytes - 4, 4);
+		}
+	});
+}
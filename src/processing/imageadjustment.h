@@ -0,0 +1,78 @@
+#ifndef IMAGEADJUSTMENT_H
+#define IMAGEADJUSTMENT_H
+
+#include <QVideoFrame>
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QStringList>
+
+
+struct ImageAdjustmentSettings {
+	qreal brightness = 0.0; //-1..1, same range as QCameraImageProcessing
+	qreal contrast = 0.0; //-1..1
+	qreal gamma = 1.0; //0.2..5
+	qreal sharpening = 0.0; //0..1, amount of the unsharp mask
+	int falseColor = 0; //ImageAdjustment::FalseColorMap
+
+	bool isIdentity() const;
+	bool operator==(const ImageAdjustmentSettings& other) const;
+	bool operator!=(const ImageAdjustmentSettings& other) const {return !(*this == other);}
+};
+
+//software image processing for the display of cameras without (or with insufficient) image processing controls.
+//brightness, contrast and gamma are applied with per-channel lookup tables that hold pre-shifted 32 bit values, so a pixel costs three
+//table lookups and two ORs. the tables are only rebuilt when a value changes. false colour maps are applied to the luma of the adjusted pixel.
+//the optional unsharp mask (3x3 box blur) runs with SSE2 on row bands of the shared WorkStealingPool. the result is a new RGB32 frame,
+//the camera frame itself is not modified
+class ImageAdjustment
+{
+public:
+	enum FalseColorMap {
+		NO_FALSE_COLOR,
+		HOT,
+		JET,
+		INFERNO
+	};
+
+	ImageAdjustment();
+
+	//thread safe, may be called while process() runs on another thread
+	void setSettings(const ImageAdjustmentSettings& settings);
+	ImageAdjustmentSettings getSettings() const;
+	bool isActive() const {return this->active.loadAcquire() != 0;}
+
+	//returns an adjusted RGB32 copy of frame, or an invalid frame if the frame can not be converted
+	QVideoFrame process(const QVideoFrame& frame);
+
+	static QStringList falseColorNames();
+
+	static const int BAND_HEIGHT = 32;
+	static const int OUTPUT_BUFFERS = 3;
+
+private:
+	struct Tables {
+		quint32 red[256];
+		quint32 green[256];
+		quint32 blue[256];
+		quint32 falseColor[256];
+		bool useFalseColor;
+		int sharpenAmount; //4.12 fixed point, 0 disables the unsharp mask
+	};
+
+	mutable QMutex mutex;
+	ImageAdjustmentSettings settings;
+	QSharedPointer<const Tables> tables;
+	QAtomicInt active;
+	QList<QImage> outputBuffers; //only used by the thread that calls process()
+
+	QImage takeOutputBuffer(const QSize& size);
+	void recycleOutputBuffer(const QImage& buffer);
+	static QSharedPointer<const Tables> buildTables(const ImageAdjustmentSettings& settings);
+	static quint32 falseColorValue(int map, int value);
+	static void applyTables(const uchar* src, int srcStride, int redShift, int greenShift, int blueShift, QImage& dst, const Tables& tables);
+	static void unsharpMask(const QImage& src, QImage& dst, int amount);
+};
+
+#endif //IMAGEADJUSTMENT_H
@@ -0,0 +1,1116 @@
+#include "lenscalibration.h"
+#include "workstealingpool.h"
+#include <QImage>
+#include <QHash>
+#include <QQueue>
+#include <QObject>
+#include <QtMath>
+#include <algorithm>
+
+
+namespace {
+	const int INTRINSICS = 8; //fx, fy, cx, cy, k1, k2, p1, p2
+	const int POSE = 6; //rotation vector, translation
+	const int SECTOR_SAMPLES = 24;
+	const float MIN_SECTOR_CONTRAST = 16.0f;
+	const double MIN_SADDLE_RESPONSE = 0.01; //relative to the strongest saddle of the image
+	const int LATTICE_OFFSET = 512; //cell coordinates of the lattice are stored as (i + offset)*2*offset + j + offset
+	const double OUTLIER_FACTOR = 3.0; //views with a larger error than this times the median error are left out once
+	const double MIN_OUTLIER_ERROR = 1.0;
+
+	struct Saddle {
+		QPointF position;
+		double strength;
+	};
+
+	struct LatticeCell {
+		int saddle;
+		QPointF u; //local lattice vectors
+		QPointF v;
+	};
+
+	//polled often enough that closing the view during a calibration only waits for a few milliseconds
+	inline bool isCancelled(const QAtomicInt* cancelled) {
+		return cancelled != nullptr && cancelled->loadAcquire() != 0;
+	}
+
+	inline double distance(const QPointF& a, const QPointF& b) {
+		const QPointF d = a - b;
+		return qSqrt(d.x()*d.x() + d.y()*d.y());
+	}
+
+	inline void distortNormalized(const double* intrinsics, double x, double y, double* xd, double* yd) {
+		const double r2 = x*x + y*y;
+		const double radial = 1.0 + intrinsics[4]*r2 + intrinsics[5]*r2*r2;
+		*xd = x*radial + 2.0*intrinsics[6]*x*y + intrinsics[7]*(r2 + 2.0*x*x);
+		*yd = y*radial + intrinsics[6]*(r2 + 2.0*y*y) + 2.0*intrinsics[7]*x*y;
+	}
+
+	//eigen decomposition of the symmetric n x n matrix a (row major, destroyed) by cyclic Jacobi rotations. the eigenvectors are the columns of vectors
+	void symmetricEigen(QVector<double>& a, int n, QVector<double>* values, QVector<double>* vectors) {
+		vectors->fill(0.0, n*n);
+		double scale = 0.0;
+		for(int i = 0; i < n; i++){
+			(*vectors)[i*n + i] = 1.0;
+			for(int j = 0; j < n; j++){
+				scale += a.at(i*n + j)*a.at(i*n + j);
+			}
+		}
+		for(int sweep = 0; sweep < 64; sweep++){
+			double offDiagonal = 0.0;
+			for(int p = 0; p < n; p++){
+				for(int q = p + 1; q < n; q++){
+					offDiagonal += a.at(p*n + q)*a.at(p*n + q);
+				}
+			}
+			if(offDiagonal <= 1e-28*scale){
+				break;
+			}
+			for(int p = 0; p < n; p++){
+				for(int q = p + 1; q < n; q++){
+					const double apq = a.at(p*n + q);
+					if(apq == 0.0){
+						continue;
+					}
+					const double theta = (a.at(q*n + q) - a.at(p*n + p))/(2.0*apq);
+					const double t = (theta >= 0.0 ? 1.0 : -1.0)/(qAbs(theta) + qSqrt(theta*theta + 1.0));
+					const double c = 1.0/qSqrt(t*t + 1.0);
+					const double s = t*c;
+					for(int k = 0; k < n; k++){
+						const double akp = a.at(k*n + p);
+						const double akq = a.at(k*n + q);
+						a[k*n + p] = c*akp - s*akq;
+						a[k*n + q] = s*akp + c*akq;
+					}
+					for(int k = 0; k < n; k++){
+						const double apk = a.at(p*n + k);
+						const double aqk = a.at(q*n + k);
+						a[p*n + k] = c*apk - s*aqk;
+						a[q*n + k] = s*apk + c*aqk;
+					}
+					for(int k = 0; k < n; k++){
+						const double vkp = vectors->at(k*n + p);
+						const double vkq = vectors->at(k*n + q);
+						(*vectors)[k*n + p] = c*vkp - s*vkq;
+						(*vectors)[k*n + q] = s*vkp + c*vkq;
+					}
+				}
+			}
+		}
+		values->resize(n);
+		for(int i = 0; i < n; i++){
+			(*values)[i] = a.at(i*n + i);
+		}
+	}
+
+	//solves a*x = b for the symmetric positive definite n x n matrix a. returns false if a is not positive definite
+	bool solveCholesky(QVector<double> a, const QVector<double>& b, int n, QVector<double>* x) {
+		for(int j = 0; j < n; j++){
+			double sum = a.at(j*n + j);
+			for(int k = 0; k < j; k++){
+				sum -= a.at(j*n + k)*a.at(j*n + k);
+			}
+			if(!(sum > 0.0)){
+				return false;
+			}
+			a[j*n + j] = qSqrt(sum);
+			for(int i = j + 1; i < n; i++){
+				double s = a.at(i*n + j);
+				for(int k = 0; k < j; k++){
+					s -= a.at(i*n + k)*a.at(j*n + k);
+				}
+				a[i*n + j] = s/a.at(j*n + j);
+			}
+		}
+		x->resize(n);
+		for(int i = 0; i < n; i++){
+			double sum = b.at(i);
+			for(int k = 0; k < i; k++){
+				sum -= a.at(i*n + k)*x->at(k);
+			}
+			(*x)[i] = sum/a.at(i*n + i);
+		}
+		for(int i = n - 1; i >= 0; i--){
+			double sum = x->at(i);
+			for(int k = i + 1; k < n; k++){
+				sum -= a.at(k*n + i)*x->at(k);
+			}
+			(*x)[i] = sum/a.at(i*n + i);
+		}
+		return true;
+	}
+
+	void rotationMatrix(const double* r, double* R) {
+		const double theta = qSqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]);
+		if(theta < 1e-12){
+			R[0] = 1.0;   R[1] = -r[2]; R[2] = r[1];
+			R[3] = r[2];  R[4] = 1.0;   R[5] = -r[0];
+			R[6] = -r[1]; R[7] = r[0];  R[8] = 1.0;
+			return;
+		}
+		const double kx = r[0]/theta;
+		const double ky = r[1]/theta;
+		const double kz = r[2]/theta;
+		const double c = qCos(theta);
+		const double s = qSin(theta);
+		const double t = 1.0 - c;
+		R[0] = c + t*kx*kx;    R[1] = t*kx*ky - s*kz; R[2] = t*kx*kz + s*ky;
+		R[3] = t*kx*ky + s*kz; R[4] = c + t*ky*ky;    R[5] = t*ky*kz - s*kx;
+		R[6] = t*kx*kz - s*ky; R[7] = t*ky*kz + s*kx; R[8] = c + t*kz*kz;
+	}
+
+	void rotationVector(const double* R, double* r) {
+		const double c = qBound(-1.0, (R[0] + R[4] + R[8] - 1.0)/2.0, 1.0);
+		const double wx = (R[7] - R[5])/2.0;
+		const double wy = (R[2] - R[6])/2.0;
+		const double wz = (R[3] - R[1])/2.0;
+		const double s = qSqrt(wx*wx + wy*wy + wz*wz);
+		if(s > 1e-6){
+			const double theta = qAtan2(s, c);
+			r[0] = wx/s*theta;
+			r[1] = wy/s*theta;
+			r[2] = wz/s*theta;
+		} else if(c > 0.0){
+			r[0] = wx;
+			r[1] = wy;
+			r[2] = wz;
+		} else {
+			//rotation by pi: the axis is the largest column of R + I
+			int column = 0;
+			double best = -1.0;
+			for(int j = 0; j < 3; j++){
+				const double x = R[j] + (j == 0 ? 1.0 : 0.0);
+				const double y = R[3 + j] + (j == 1 ? 1.0 : 0.0);
+				const double z = R[6 + j] + (j == 2 ? 1.0 : 0.0);
+				if(x*x + y*y + z*z > best){
+					best = x*x + y*y + z*z;
+					column = j;
+				}
+			}
+			const double norm = qSqrt(best);
+			r[0] = (R[column] + (column == 0 ? 1.0 : 0.0))/norm*M_PI;
+			r[1] = (R[3 + column] + (column == 1 ? 1.0 : 0.0))/norm*M_PI;
+			r[2] = (R[6 + column] + (column == 2 ? 1.0 : 0.0))/norm*M_PI;
+		}
+	}
+
+	//reprojection residuals (projected minus detected, x and y of every corner) of one view
+	void viewResiduals(const double* intrinsics, const double* pose, const QVector<QPointF>& model, const QVector<QPointF>& image, double* residuals) {
+		double R[9];
+		rotationMatrix(pose, R);
+		for(int i = 0; i < model.size(); i++){
+			const double X = model.at(i).x();
+			const double Y = model.at(i).y();
+			const double z = R[6]*X + R[7]*Y + pose[5];
+			const double x = (R[0]*X + R[1]*Y + pose[3])/z;
+			const double y = (R[3]*X + R[4]*Y + pose[4])/z;
+			double xd = 0.0;
+			double yd = 0.0;
+			distortNormalized(intrinsics, x, y, &xd, &yd);
+			residuals[2*i] = intrinsics[0]*xd + intrinsics[2] - image.at(i).x();
+			residuals[2*i + 1] = intrinsics[1]*yd + intrinsics[3] - image.at(i).y();
+		}
+	}
+
+	double sumOfSquares(const QVector<double>& parameters, const QVector<QPointF>& model, const QVector<QVector<QPointF>>& views, QVector<double>& residuals) {
+		double sum = 0.0;
+		for(int v = 0; v < views.size(); v++){
+			viewResiduals(parameters.constData(), parameters.constData() + INTRINSICS + POSE*v, model, views.at(v), residuals.data());
+			for(int i = 0; i < 2*model.size(); i++){
+				sum += residuals.at(i)*residuals.at(i);
+			}
+		}
+		return sum;
+	}
+
+	//normalized direct linear transform, maps the model points to the image points
+	bool findHomography(const QVector<QPointF>& from, const QVector<QPointF>& to, double* H) {
+		const int n = from.size();
+		double transforms[2][3]; //scale and center of both point sets
+		const QVector<QPointF>* sets[2] = {&from, &to};
+		for(int s = 0; s < 2; s++){
+			QPointF center;
+			for(const QPointF& p : *sets[s]){
+				center += p;
+			}
+			center /= n;
+			double meanDistance = 0.0;
+			for(const QPointF& p : *sets[s]){
+				meanDistance += distance(p, center);
+			}
+			meanDistance /= n;
+			if(meanDistance <= 0.0){
+				return false;
+			}
+			transforms[s][0] = M_SQRT2/meanDistance;
+			transforms[s][1] = center.x();
+			transforms[s][2] = center.y();
+		}
+		QVector<double> m(81, 0.0);
+		for(int i = 0; i < n; i++){
+			const double X = (from.at(i).x() - transforms[0][1])*transforms[0][0];
+			const double Y = (from.at(i).y() - transforms[0][2])*transforms[0][0];
+			const double u = (to.at(i).x() - transforms[1][1])*transforms[1][0];
+			const double v = (to.at(i).y() - transforms[1][2])*transforms[1][0];
+			const double rows[2][9] = {{X, Y, 1.0, 0.0, 0.0, 0.0, -u*X, -u*Y, -u}, {0.0, 0.0, 0.0, X, Y, 1.0, -v*X, -v*Y, -v}};
+			for(int r = 0; r < 2; r++){
+				for(int j = 0; j < 9; j++){
+					for(int k = j; k < 9; k++){
+						m[j*9 + k] += rows[r][j]*rows[r][k];
+					}
+				}
+			}
+		}
+		for(int j = 0; j < 9; j++){
+			for(int k = 0; k < j; k++){
+				m[j*9 + k] = m.at(k*9 + j);
+			}
+		}
+		QVector<double> values;
+		QVector<double> vectors;
+		symmetricEigen(m, 9, &values, &vectors);
+		const int smallest = static_cast<int>(std::min_element(values.constBegin(), values.constEnd()) - values.constBegin());
+		double h[9];
+		for(int j = 0; j < 9; j++){
+			h[j] = vectors.at(j*9 + smallest);
+		}
+		//H = inverse(T_to)*h*T_from
+		const double sf = transforms[0][0];
+		const double st = transforms[1][0];
+		double hT[9];
+		for(int r = 0; r < 3; r++){
+			hT[r*3] = h[r*3]*sf;
+			hT[r*3 + 1] = h[r*3 + 1]*sf;
+			hT[r*3 + 2] = h[r*3 + 2] - sf*(h[r*3]*transforms[0][1] + h[r*3 + 1]*transforms[0][2]);
+		}
+		for(int c = 0; c < 3; c++){
+			H[c] = hT[c]/st + transforms[1][1]*hT[6 + c];
+			H[3 + c] = hT[3 + c]/st + transforms[1][2]*hT[6 + c];
+			H[6 + c] = hT[6 + c];
+		}
+		if(qAbs(H[8]) < 1e-12){
+			return false;
+		}
+		for(int j = 0; j < 9; j++){
+			H[j] /= H[8];
+		}
+		return true;
+	}
+
+	//focal lengths from the homographies of the boards (orthogonal rotation columns of equal length), the principal point is assumed at the center
+	void initialIntrinsics(const QVector<QVector<double>>& homographies, const QSize& imageSize, double* intrinsics) {
+		const double cx = (imageSize.width() - 1)/2.0;
+		const double cy = (imageSize.height() - 1)/2.0;
+		double ata[3] = {0.0, 0.0, 0.0}; //a11, a12, a22 of the normal equations for 1/fx^2 and 1/fy^2
+		double atb[2] = {0.0, 0.0};
+		double commonA = 0.0; //the same for a common focal length
+		double commonB = 0.0;
+		for(const QVector<double>& H : homographies){
+			double hc[9];
+			for(int c = 0; c < 3; c++){
+				hc[c] = H.at(c) - cx*H.at(6 + c);
+				hc[3 + c] = H.at(3 + c) - cy*H.at(6 + c);
+				hc[6 + c] = H.at(6 + c);
+			}
+			double norm = 0.0;
+			for(int j = 0; j < 9; j++){
+				norm += hc[j]*hc[j];
+			}
+			norm = qSqrt(norm);
+			for(int j = 0; j < 9; j++){
+				hc[j] /= norm;
+			}
+			const double h[3] = {hc[0], hc[3], hc[6]};
+			const double v[3] = {hc[1], hc[4], hc[7]};
+			const double rows[2][3] = {{h[0]*v[0], h[1]*v[1], -h[2]*v[2]}, {h[0]*h[0] - v[0]*v[0], h[1]*h[1] - v[1]*v[1], -(h[2]*h[2] - v[2]*v[2])}};
+			for(int r = 0; r < 2; r++){
+				ata[0] += rows[r][0]*rows[r][0];
+				ata[1] += rows[r][0]*rows[r][1];
+				ata[2] += rows[r][1]*rows[r][1];
+				atb[0] += rows[r][0]*rows[r][2];
+				atb[1] += rows[r][1]*rows[r][2];
+				commonA += (rows[r][0] + rows[r][1])*(rows[r][0] + rows[r][1]);
+				commonB += (rows[r][0] + rows[r][1])*rows[r][2];
+			}
+		}
+		double fx = 0.0;
+		double fy = 0.0;
+		const double det = ata[0]*ata[2] - ata[1]*ata[1];
+		if(qAbs(det) > 1e-30){
+			const double a = (ata[2]*atb[0] - ata[1]*atb[1])/det;
+			const double b = (ata[0]*atb[1] - ata[1]*atb[0])/det;
+			if(a > 0.0 && b > 0.0){
+				fx = 1.0/qSqrt(a);
+				fy = 1.0/qSqrt(b);
+			}
+		}
+		if(fx <= 0.0 || fy <= 0.0 || fx > 2.0*fy || fy > 2.0*fx){
+			const double a = commonA > 0.0 ? commonB/commonA : 0.0;
+			fx = fy = a > 0.0 ? 1.0/qSqrt(a) : qMax(imageSize.width(), imageSize.height());
+		}
+		intrinsics[0] = fx;
+		intrinsics[1] = fy;
+		intrinsics[2] = cx;
+		intrinsics[3] = cy;
+		for(int j = 4; j < INTRINSICS; j++){
+			intrinsics[j] = 0.0;
+		}
+	}
+
+	//pose of a board from its homography and the intrinsics, the rotation is the closest rotation matrix to the columns of inverse(K)*H
+	void initialPose(const QVector<double>& H, const double* intrinsics, double* pose) {
+		double m[3][3]; //columns of inverse(K)*H
+		for(int c = 0; c < 3; c++){
+			m[c][0] = (H.at(c) - intrinsics[2]*H.at(6 + c))/intrinsics[0];
+			m[c][1] = (H.at(3 + c) - intrinsics[3]*H.at(6 + c))/intrinsics[1];
+			m[c][2] = H.at(6 + c);
+		}
+		const double n0 = qSqrt(m[0][0]*m[0][0] + m[0][1]*m[0][1] + m[0][2]*m[0][2]);
+		const double n1 = qSqrt(m[1][0]*m[1][0] + m[1][1]*m[1][1] + m[1][2]*m[1][2]);
+		double lambda = 2.0/(n0 + n1);
+		if(m[2][2]*lambda < 0.0){
+			//the board has to be in front of the camera
+			lambda = -lambda;
+		}
+		double r1[3];
+		double r2[3];
+		for(int k = 0; k < 3; k++){
+			r1[k] = lambda*m[0][k];
+			r2[k] = lambda*m[1][k];
+			pose[3 + k] = lambda*m[2][k];
+		}
+		const double r3[3] = {r1[1]*r2[2] - r1[2]*r2[1], r1[2]*r2[0] - r1[0]*r2[2], r1[0]*r2[1] - r1[1]*r2[0]};
+		const double R[9] = {r1[0], r2[0], r3[0], r1[1], r2[1], r3[1], r1[2], r2[2], r3[2]};
+		//polar decomposition R*inverse(sqrt(transpose(R)*R))
+		QVector<double> rtr(9, 0.0);
+		for(int i = 0; i < 3; i++){
+			for(int j = 0; j < 3; j++){
+				for(int k = 0; k < 3; k++){
+					rtr[i*3 + j] += R[k*3 + i]*R[k*3 + j];
+				}
+			}
+		}
+		QVector<double> values;
+		QVector<double> vectors;
+		symmetricEigen(rtr, 3, &values, &vectors);
+		double inverseRoot[9];
+		for(int i = 0; i < 3; i++){
+			for(int j = 0; j < 3; j++){
+				double sum = 0.0;
+				for(int k = 0; k < 3; k++){
+					sum += vectors.at(i*3 + k)*vectors.at(j*3 + k)/qSqrt(qMax(values.at(k), 1e-12));
+				}
+				inverseRoot[i*3 + j] = sum;
+			}
+		}
+		double rotation[9];
+		for(int i = 0; i < 3; i++){
+			for(int j = 0; j < 3; j++){
+				double sum = 0.0;
+				for(int k = 0; k < 3; k++){
+					sum += R[i*3 + k]*inverseRoot[k*3 + j];
+				}
+				rotation[i*3 + j] = sum;
+			}
+		}
+		rotationVector(rotation, pose);
+	}
+
+	//Levenberg-Marquardt on the reprojection error of all views. the jacobian is taken by central differences, it is sparse: the residuals of a
+	//view only depend on the intrinsics and the pose of that view, so every view adds a 14 x 14 block pattern to the normal equations
+	double refine(QVector<double>* parameters, const QVector<QPointF>& model, const QVector<QVector<QPointF>>& views, const QAtomicInt* cancelled) {
+		const int n = parameters->size();
+		const int residualCount = 2*model.size();
+		const int local = INTRINSICS + POSE;
+		QVector<double> residuals(residualCount);
+		QVector<double> plus(residualCount);
+		QVector<double> minus(residualCount);
+		QVector<double> jacobian(residualCount*local);
+		QVector<double> jtj(n*n);
+		QVector<double> jtr(n);
+		double cost = sumOfSquares(*parameters, model, views, residuals);
+		double lambda = 1e-3;
+		for(int iteration = 0; iteration < LensCalibration::MAX_ITERATIONS; iteration++){
+			if(isCancelled(cancelled)){
+				break;
+			}
+			jtj.fill(0.0);
+			jtr.fill(0.0);
+			for(int v = 0; v < views.size(); v++){
+				if(isCancelled(cancelled)){
+					return cost;
+				}
+				int index[INTRINSICS + POSE];
+				for(int j = 0; j < local; j++){
+					index[j] = j < INTRINSICS ? j : INTRINSICS + POSE*v + j - INTRINSICS;
+				}
+				QVector<double> p = *parameters;
+				viewResiduals(p.constData(), p.constData() + INTRINSICS + POSE*v, model, views.at(v), residuals.data());
+				for(int j = 0; j < local; j++){
+					const double value = p.at(index[j]);
+					const double step = 1e-6*qMax(1.0, qAbs(value));
+					p[index[j]] = value + step;
+					viewResiduals(p.constData(), p.constData() + INTRINSICS + POSE*v, model, views.at(v), plus.data());
+					p[index[j]] = value - step;
+					viewResiduals(p.constData(), p.constData() + INTRINSICS + POSE*v, model, views.at(v), minus.data());
+					p[index[j]] = value;
+					for(int i = 0; i < residualCount; i++){
+						jacobian[i*local + j] = (plus.at(i) - minus.at(i))/(2.0*step);
+					}
+				}
+				for(int a = 0; a < local; a++){
+					for(int b = a; b < local; b++){
+						double sum = 0.0;
+						for(int i = 0; i < residualCount; i++){
+							sum += jacobian.at(i*local + a)*jacobian.at(i*local + b);
+						}
+						jtj[index[a]*n + index[b]] += sum;
+					}
+					double sum = 0.0;
+					for(int i = 0; i < residualCount; i++){
+						sum += jacobian.at(i*local + a)*residuals.at(i);
+					}
+					jtr[index[a]] += sum;
+				}
+			}
+			for(int a = 0; a < n; a++){
+				for(int b = 0; b < a; b++){
+					jtj[a*n + b] = jtj.at(b*n + a);
+				}
+			}
+
+			//increase the damping until a step reduces the error
+			bool improved = false;
+			double newCost = cost;
+			QVector<double> step;
+			QVector<double> negativeGradient(n);
+			for(int j = 0; j < n; j++){
+				negativeGradient[j] = -jtr.at(j);
+			}
+			while(lambda < 1e12){
+				QVector<double> damped = jtj;
+				for(int j = 0; j < n; j++){
+					damped[j*n + j] += lambda*qMax(jtj.at(j*n + j), 1e-12);
+				}
+				if(solveCholesky(damped, negativeGradient, n, &step)){
+					QVector<double> candidate = *parameters;
+					for(int j = 0; j < n; j++){
+						candidate[j] += step.at(j);
+					}
+					newCost = sumOfSquares(candidate, model, views, residuals);
+					if(newCost < cost){
+						*parameters = candidate;
+						improved = true;
+						break;
+					}
+				}
+				lambda *= 10.0;
+			}
+			if(!improved){
+				break;
+			}
+			lambda = qMax(lambda/10.0, 1e-12);
+			const bool converged = cost - newCost <= 1e-12*cost;
+			cost = newCost;
+			if(converged){
+				break;
+			}
+		}
+		return cost;
+	}
+
+	QVector<float> smooth(const LumaImage& image) {
+		//binomial 1 4 6 4 1, edges are repeated
+		const int w = image.width;
+		const int h = image.height;
+		QVector<float> horizontal(w*h);
+		for(int y = 0; y < h; y++){
+			const quint8* line = image.constLine(y);
+			for(int x = 0; x < w; x++){
+				const int x0 = qMax(x - 2, 0);
+				const int x1 = qMax(x - 1, 0);
+				const int x3 = qMin(x + 1, w - 1);
+				const int x4 = qMin(x + 2, w - 1);
+				horizontal[y*w + x] = (line[x0] + 4*line[x1] + 6*line[x] + 4*line[x3] + line[x4])/16.0f;
+			}
+		}
+		QVector<float> result(w*h);
+		for(int y = 0; y < h; y++){
+			const float* l0 = horizontal.constData() + qMax(y - 2, 0)*w;
+			const float* l1 = horizontal.constData() + qMax(y - 1, 0)*w;
+			const float* l2 = horizontal.constData() + y*w;
+			const float* l3 = horizontal.constData() + qMin(y + 1, h - 1)*w;
+			const float* l4 = horizontal.constData() + qMin(y + 2, h - 1)*w;
+			for(int x = 0; x < w; x++){
+				result[y*w + x] = (l0[x] + 4.0f*l1[x] + 6.0f*l2[x] + 4.0f*l3[x] + l4[x])/16.0f;
+			}
+		}
+		return result;
+	}
+
+	inline float sampleBilinear(const QVector<float>& image, int w, double x, double y) {
+		const int x0 = static_cast<int>(x);
+		const int y0 = static_cast<int>(y);
+		const float fx = static_cast<float>(x - x0);
+		const float fy = static_cast<float>(y - y0);
+		const float* p = image.constData() + y0*w + x0;
+		return (p[0]*(1.0f - fx) + p[1]*fx)*(1.0f - fy) + (p[w]*(1.0f - fx) + p[w + 1]*fx)*fy;
+	}
+
+	//a checkerboard corner has four sectors of alternating brightness around it, opposite sectors alike. this rejects edges, blobs and the
+	//L-shaped corners at the border of the board
+	bool isCheckerboardCorner(const QVector<float>& image, int w, int x, int y) {
+		float values[SECTOR_SAMPLES];
+		float minValue = 255.0f;
+		float maxValue = 0.0f;
+		for(int k = 0; k < SECTOR_SAMPLES; k++){
+			const double angle = 2.0*M_PI*k/SECTOR_SAMPLES;
+			values[k] = sampleBilinear(image, w, x + LensCalibration::SECTOR_RADIUS*qCos(angle), y + LensCalibration::SECTOR_RADIUS*qSin(angle));
+			minValue = qMin(minValue, values[k]);
+			maxValue = qMax(maxValue, values[k]);
+		}
+		if(maxValue - minValue < MIN_SECTOR_CONTRAST){
+			return false;
+		}
+		const float threshold = (minValue + maxValue)/2.0f;
+		int transitions = 0;
+		int symmetric = 0;
+		for(int k = 0; k < SECTOR_SAMPLES; k++){
+			const bool bright = values[k] > threshold;
+			transitions += bright != (values[(k + 1)%SECTOR_SAMPLES] > threshold) ? 1 : 0;
+			if(k < SECTOR_SAMPLES/2){
+				symmetric += bright == (values[k + SECTOR_SAMPLES/2] > threshold) ? 1 : 0;
+			}
+		}
+		return transitions == 4 && symmetric >= SECTOR_SAMPLES*3/8;
+	}
+
+	//local maxima of the saddle response (negative determinant of the hessian) that pass the sector test
+	QVector<Saddle> findSaddles(const QVector<float>& image, int w, int h) {
+		QVector<Saddle> saddles;
+		const int border = LensCalibration::SECTOR_RADIUS + 2;
+		if(w <= 2*border || h <= 2*border){
+			return saddles;
+		}
+		QVector<float> response(w*h, 0.0f);
+		float maxResponse = 0.0f;
+		for(int y = 1; y < h - 1; y++){
+			const float* above = image.constData() + (y - 1)*w;
+			const float* line = image.constData() + y*w;
+			const float* below = image.constData() + (y + 1)*w;
+			for(int x = 1; x < w - 1; x++){
+				const float ixx = line[x + 1] - 2.0f*line[x] + line[x - 1];
+				const float iyy = below[x] - 2.0f*line[x] + above[x];
+				const float ixy = (below[x + 1] - below[x - 1] - above[x + 1] + above[x - 1])/4.0f;
+				const float value = ixy*ixy - ixx*iyy;
+				if(value > 0.0f){
+					response[y*w + x] = value;
+					maxResponse = qMax(maxResponse, value);
+				}
+			}
+		}
+		const float threshold = static_cast<float>(MIN_SADDLE_RESPONSE)*maxResponse;
+		for(int y = border; y < h - border; y++){
+			for(int x = border; x < w - border; x++){
+				const float value = response.at(y*w + x);
+				if(value <= threshold){
+					continue;
+				}
+				//ties are resolved in favor of the first pixel in scan order
+				bool isMaximum = true;
+				for(int dy = -3; dy <= 3 && isMaximum; dy++){
+					for(int dx = -3; dx <= 3; dx++){
+						const float other = response.at((y + dy)*w + x + dx);
+						if(other > value || (other == value && (dy < 0 || (dy == 0 && dx < 0)))){
+							isMaximum = false;
+							break;
+						}
+					}
+				}
+				if(isMaximum && isCheckerboardCorner(image, w, x, y)){
+					saddles.append({QPointF(x, y), value});
+				}
+			}
+		}
+		return saddles;
+	}
+
+	int nearestSaddle(const QVector<Saddle>& saddles, const QVector<bool>& used, const QPointF& position, double maxDistance) {
+		int nearest = -1;
+		double nearestDistance = maxDistance;
+		for(int i = 0; i < saddles.size(); i++){
+			if(used.at(i)){
+				continue;
+			}
+			const double d = distance(saddles.at(i).position, position);
+			if(d < nearestDistance){
+				nearestDistance = d;
+				nearest = i;
+			}
+		}
+		return nearest;
+	}
+
+	inline int cellKey(int i, int j) {
+		return (i + LATTICE_OFFSET)*2*LATTICE_OFFSET + j + LATTICE_OFFSET;
+	}
+
+	//grows a lattice of saddles from the seed: the neighbors of every cell are predicted with the local lattice vectors, which follow the
+	//perspective and the distortion of the board. the lattice is then cropped to the pattern, dropping the weaker border rows and columns
+	bool growLattice(const QVector<Saddle>& saddles, int seed, const QSize& pattern, QVector<QPointF>* corners) {
+		const QPointF origin = saddles.at(seed).position;
+		QVector<int> neighbors;
+		for(int i = 0; i < saddles.size(); i++){
+			if(i != seed){
+				neighbors.append(i);
+			}
+		}
+		std::sort(neighbors.begin(), neighbors.end(), [&](int a, int b) {
+			return distance(saddles.at(a).position, origin) < distance(saddles.at(b).position, origin);
+		});
+		if(neighbors.size() < 2){
+			return false;
+		}
+		const QPointF u = saddles.at(neighbors.first()).position - origin;
+		const double uLength = qSqrt(u.x()*u.x() + u.y()*u.y());
+		QPointF v;
+		for(int k = 1; k < qMin(neighbors.size(), 8); k++){
+			const QPointF candidate = saddles.at(neighbors.at(k)).position - origin;
+			const double length = qSqrt(candidate.x()*candidate.x() + candidate.y()*candidate.y());
+			const double cosine = (u.x()*candidate.x() + u.y()*candidate.y())/(uLength*length);
+			if(qAbs(cosine) < 0.5 && length < 2.0*uLength){
+				v = candidate;
+				break;
+			}
+		}
+		if(v.isNull()){
+			return false;
+		}
+
+		QHash<int, LatticeCell> cells;
+		QVector<bool> used(saddles.size(), false);
+		QQueue<QPoint> queue;
+		cells.insert(cellKey(0, 0), {seed, u, v});
+		used[seed] = true;
+		queue.enqueue(QPoint(0, 0));
+		const int maxCells = 4*pattern.width()*pattern.height() + 16;
+		const QPoint directions[4] = {QPoint(1, 0), QPoint(-1, 0), QPoint(0, 1), QPoint(0, -1)};
+		while(!queue.isEmpty() && cells.size() < maxCells){
+			const QPoint cell = queue.dequeue();
+			const LatticeCell current = cells.value(cellKey(cell.x(), cell.y()));
+			const QPointF position = saddles.at(current.saddle).position;
+			for(const QPoint& direction : directions){
+				const QPoint next = cell + direction;
+				if(qAbs(next.x()) >= LATTICE_OFFSET || qAbs(next.y()) >= LATTICE_OFFSET || cells.contains(cellKey(next.x(), next.y()))){
+					continue;
+				}
+				const QPointF step = direction.x()*current.u + direction.y()*current.v;
+				const double stepLength = qSqrt(step.x()*step.x() + step.y()*step.y());
+				const int found = nearestSaddle(saddles, used, position + step, 0.35*stepLength);
+				if(found < 0){
+					continue;
+				}
+				const QPointF actual = saddles.at(found).position - position;
+				LatticeCell neighbor = current;
+				neighbor.saddle = found;
+				if(direction.x() != 0){
+					neighbor.u = direction.x()*actual;
+				} else {
+					neighbor.v = direction.y()*actual;
+				}
+				cells.insert(cellKey(next.x(), next.y()), neighbor);
+				used[found] = true;
+				queue.enqueue(next);
+			}
+		}
+
+		int minI = 0;
+		int maxI = 0;
+		int minJ = 0;
+		int maxJ = 0;
+		for(auto it = cells.constBegin(); it != cells.constEnd(); ++it){
+			const int i = it.key()/(2*LATTICE_OFFSET) - LATTICE_OFFSET;
+			const int j = it.key()%(2*LATTICE_OFFSET) - LATTICE_OFFSET;
+			minI = qMin(minI, i);
+			maxI = qMax(maxI, i);
+			minJ = qMin(minJ, j);
+			maxJ = qMax(maxJ, j);
+		}
+		//the columns of the pattern run along i or along j, whichever fits with fewer surplus cells
+		const int width = maxI - minI + 1;
+		const int height = maxJ - minJ + 1;
+		const bool fitsAlongI = width >= pattern.width() && height >= pattern.height();
+		const bool fitsAlongJ = width >= pattern.height() && height >= pattern.width();
+		if(!fitsAlongI && !fitsAlongJ){
+			return false;
+		}
+		const bool columnsAlongI = fitsAlongI && (!fitsAlongJ || width - pattern.width() + height - pattern.height() <= width - pattern.height() + height - pattern.width());
+		const int targetI = columnsAlongI ? pattern.width() : pattern.height();
+		const int targetJ = columnsAlongI ? pattern.height() : pattern.width();
+		auto lineStrength = [&](bool alongJ, int index, int from, int to) {
+			double sum = 0.0;
+			for(int k = from; k <= to; k++){
+				const int key = alongJ ? cellKey(index, k) : cellKey(k, index);
+				if(cells.contains(key)){
+					sum += saddles.at(cells.value(key).saddle).strength;
+				}
+			}
+			return sum;
+		};
+		while(maxI - minI + 1 > targetI){
+			if(lineStrength(true, minI, minJ, maxJ) < lineStrength(true, maxI, minJ, maxJ)){
+				minI++;
+			} else {
+				maxI--;
+			}
+		}
+		while(maxJ - minJ + 1 > targetJ){
+			if(lineStrength(false, minJ, minI, maxI) < lineStrength(false, maxJ, minI, maxI)){
+				minJ++;
+			} else {
+				maxJ--;
+			}
+		}
+
+		corners->clear();
+		for(int row = 0; row < pattern.height(); row++){
+			for(int column = 0; column < pattern.width(); column++){
+				const int key = columnsAlongI ? cellKey(minI + column, minJ + row) : cellKey(minI + row, minJ + column);
+				if(!cells.contains(key)){
+					return false;
+				}
+				corners->append(saddles.at(cells.value(key).saddle).position);
+			}
+		}
+		return true;
+	}
+
+	//subpixel position of a corner: the gradients in a window around the corner are orthogonal to the vectors from the corner to them
+	QPointF refineCorner(const LumaImage& image, const QPointF& start, int halfWindow) {
+		QPointF corner = start;
+		const double sigma = halfWindow/2.0;
+		for(int iteration = 0; iteration < 20; iteration++){
+			const int x0 = qRound(corner.x());
+			const int y0 = qRound(corner.y());
+			if(x0 - halfWindow < 1 || y0 - halfWindow < 1 || x0 + halfWindow >= image.width - 1 || y0 + halfWindow >= image.height - 1){
+				return start;
+			}
+			double g11 = 0.0;
+			double g12 = 0.0;
+			double g22 = 0.0;
+			double b1 = 0.0;
+			double b2 = 0.0;
+			for(int y = y0 - halfWindow; y <= y0 + halfWindow; y++){
+				const quint8* above = image.constLine(y - 1);
+				const quint8* line = image.constLine(y);
+				const quint8* below = image.constLine(y + 1);
+				for(int x = x0 - halfWindow; x <= x0 + halfWindow; x++){
+					const double gx = (above[x + 1] + 2*line[x + 1] + below[x + 1] - above[x - 1] - 2*line[x - 1] - below[x - 1])/8.0;
+					const double gy = (below[x - 1] + 2*below[x] + below[x + 1] - above[x - 1] - 2*above[x] - above[x + 1])/8.0;
+					const double dx = x - corner.x();
+					const double dy = y - corner.y();
+					const double weight = qExp(-(dx*dx + dy*dy)/(2.0*sigma*sigma));
+					const double a11 = weight*gx*gx;
+					const double a12 = weight*gx*gy;
+					const double a22 = weight*gy*gy;
+					g11 += a11;
+					g12 += a12;
+					g22 += a22;
+					b1 += a11*x + a12*y;
+					b2 += a12*x + a22*y;
+				}
+			}
+			const double det = g11*g22 - g12*g12;
+			if(det <= 1e-9*(g11 + g22)*(g11 + g22)){
+				return start;
+			}
+			const QPointF next((g22*b1 - g12*b2)/det, (g11*b2 - g12*b1)/det);
+			const double shift = distance(next, corner);
+			corner = next;
+			if(distance(corner, start) > halfWindow){
+				return start;
+			}
+			if(shift < 0.01){
+				break;
+			}
+		}
+		return corner;
+	}
+
+	LumaImage decimate(const LumaImage& image, int factor) {
+		LumaImage result;
+		result.resize(image.width/factor, image.height/factor);
+		const int area = factor*factor;
+		for(int y = 0; y < result.height; y++){
+			quint8* target = result.line(y);
+			for(int x = 0; x < result.width; x++){
+				int sum = 0;
+				for(int dy = 0; dy < factor; dy++){
+					const quint8* source = image.constLine(y*factor + dy) + x*factor;
+					for(int dx = 0; dx < factor; dx++){
+						sum += source[dx];
+					}
+				}
+				target[x] = static_cast<quint8>((sum + area/2)/area);
+			}
+		}
+		return result;
+	}
+}
+
+
+bool LensModel::operator==(const LensModel& other) const {
+	return this->imageSize == other.imageSize && this->fx == other.fx && this->fy == other.fy && this->cx == other.cx && this->cy == other.cy
+		&& this->k1 == other.k1 && this->k2 == other.k2 && this->p1 == other.p1 && this->p2 == other.p2
+		&& this->rmsError == other.rmsError && this->imageCount == other.imageCount;
+}
+
+bool LensModel::isApplicableTo(const QSize& size) const {
+	if(!this->isValid() || size.isEmpty()){
+		return false;
+	}
+	const double aspect = static_cast<double>(this->imageSize.width())/this->imageSize.height();
+	const double otherAspect = static_cast<double>(size.width())/size.height();
+	return qAbs(aspect - otherAspect) <= 0.01*aspect;
+}
+
+LensModel LensModel::scaledTo(const QSize& size) const {
+	//pixel centers: x' = (x + 0.5)*scale - 0.5
+	LensModel scaled = *this;
+	const double sx = static_cast<double>(size.width())/this->imageSize.width();
+	const double sy = static_cast<double>(size.height())/this->imageSize.height();
+	scaled.imageSize = size;
+	scaled.fx = this->fx*sx;
+	scaled.fy = this->fy*sy;
+	scaled.cx = (this->cx + 0.5)*sx - 0.5;
+	scaled.cy = (this->cy + 0.5)*sy - 0.5;
+	scaled.rmsError = this->rmsError*qSqrt(sx*sy);
+	return scaled;
+}
+
+QPointF LensModel::distort(const QPointF& position) const {
+	const double intrinsics[INTRINSICS] = {this->fx, this->fy, this->cx, this->cy, this->k1, this->k2, this->p1, this->p2};
+	double xd = 0.0;
+	double yd = 0.0;
+	distortNormalized(intrinsics, (position.x() - this->cx)/this->fx, (position.y() - this->cy)/this->fy, &xd, &yd);
+	return QPointF(this->fx*xd + this->cx, this->fy*yd + this->cy);
+}
+
+QPointF LensModel::distortNormalizedPosition(const QPointF& normalizedPosition) const {
+	//pixel centers of imageSize, like scaledTo()
+	const QPointF source = this->distort(QPointF(normalizedPosition.x()*this->imageSize.width() - 0.5, normalizedPosition.y()*this->imageSize.height() - 0.5));
+	return QPointF((source.x() + 0.5)/this->imageSize.width(), (source.y() + 0.5)/this->imageSize.height());
+}
+
+
+bool LensCalibration::findCheckerboard(const LumaImage& image, const QSize& pattern, QVector<QPointF>* corners, const QAtomicInt* cancelled) {
+	corners->clear();
+	if(image.isNull() || pattern.width() < 2 || pattern.height() < 2){
+		return false;
+	}
+	const int factor = qMax(1, (image.width + DETECTION_WIDTH - 1)/DETECTION_WIDTH);
+	const LumaImage search = factor > 1 ? decimate(image, factor) : image;
+	const QVector<float> smoothed = smooth(search);
+	if(isCancelled(cancelled)){
+		return false;
+	}
+	const QVector<Saddle> saddles = findSaddles(smoothed, search.width, search.height);
+	if(saddles.size() < pattern.width()*pattern.height() || isCancelled(cancelled)){
+		return false;
+	}
+	QVector<int> seeds(saddles.size());
+	for(int i = 0; i < seeds.size(); i++){
+		seeds[i] = i;
+	}
+	std::sort(seeds.begin(), seeds.end(), [&](int a, int b) {return saddles.at(a).strength > saddles.at(b).strength;});
+
+	QVector<QPointF> lattice;
+	for(int k = 0; k < qMin(seeds.size(), MAX_SEEDS); k++){
+		if(isCancelled(cancelled)){
+			return false;
+		}
+		if(!growLattice(saddles, seeds.at(k), pattern, &lattice)){
+			continue;
+		}
+		//window of the subpixel refinement: a quarter of the square size, so the neighboring corners stay outside
+		double squareSize = 0.0;
+		for(int i = 0; i + 1 < lattice.size(); i++){
+			if((i + 1)%pattern.width() != 0){
+				squareSize += distance(lattice.at(i), lattice.at(i + 1));
+			}
+		}
+		squareSize = squareSize*factor/((pattern.width() - 1)*pattern.height());
+		const int halfWindow = qBound(2, qRound(0.25*squareSize), 12);
+		for(const QPointF& position : lattice){
+			const QPointF start((position.x() + 0.5)*factor - 0.5, (position.y() + 0.5)*factor - 0.5);
+			corners->append(refineCorner(image, start, halfWindow));
+		}
+		return true;
+	}
+	return false;
+}
+
+LensCalibrationResult LensCalibration::calibrate(const QVector<QVector<QPointF>>& imagePoints, const QSize& pattern, const QSize& imageSize,
+		const QAtomicInt* cancelled) {
+	LensCalibrationResult result;
+	const int cornerCount = pattern.width()*pattern.height();
+	QVector<QPointF> model;
+	for(int row = 0; row < pattern.height(); row++){
+		for(int column = 0; column < pattern.width(); column++){
+			model.append(QPointF(column, row));
+		}
+	}
+
+	//initial intrinsics and poses from the homographies of the boards
+	QVector<QVector<QPointF>> views;
+	QVector<QVector<double>> homographies;
+	for(int v = 0; v < imagePoints.size(); v++){
+		QVector<double> H(9);
+		if(imagePoints.at(v).size() == cornerCount && findHomography(model, imagePoints.at(v), H.data())){
+			views.append(imagePoints.at(v));
+			homographies.append(H);
+			result.usedViews.append(v);
+		}
+	}
+	if(views.size() < MIN_VIEWS || imageSize.isEmpty()){
+		result.error = QObject::tr("At least %1 images with a checkerboard are needed, %2 found.").arg(MIN_VIEWS).arg(views.size());
+		return result;
+	}
+	QVector<double> parameters(INTRINSICS + POSE*views.size());
+	initialIntrinsics(homographies, imageSize, parameters.data());
+	for(int v = 0; v < views.size(); v++){
+		initialPose(homographies.at(v), parameters.constData(), parameters.data() + INTRINSICS + POSE*v);
+	}
+
+	//a view with a wrong lattice (e.g. a reflection that was taken for a corner) would bend the model, such views are left out once
+	QVector<double> residuals(2*cornerCount);
+	for(int pass = 0; pass < 2; pass++){
+		refine(&parameters, model, views, cancelled);
+		result.viewErrors.clear();
+		for(int v = 0; v < views.size(); v++){
+			viewResiduals(parameters.constData(), parameters.constData() + INTRINSICS + POSE*v, model, views.at(v), residuals.data());
+			double sum = 0.0;
+			for(double residual : residuals){
+				sum += residual*residual;
+			}
+			result.viewErrors.append(qSqrt(sum/cornerCount));
+		}
+		if(pass > 0 || views.size() <= MIN_VIEWS){
+			break;
+		}
+		QVector<double> sortedErrors = result.viewErrors;
+		std::sort(sortedErrors.begin(), sortedErrors.end());
+		const double limit = qMax(MIN_OUTLIER_ERROR, OUTLIER_FACTOR*sortedErrors.at(sortedErrors.size()/2));
+		QVector<int> keep;
+		for(int v = 0; v < views.size(); v++){
+			if(result.viewErrors.at(v) <= limit){
+				keep.append(v);
+			}
+		}
+		if(keep.size() == views.size() || keep.size() < MIN_VIEWS){
+			break;
+		}
+		QVector<QVector<QPointF>> keptViews;
+		QVector<int> keptIndices;
+		QVector<double> keptParameters = parameters.mid(0, INTRINSICS);
+		for(int v : keep){
+			keptViews.append(views.at(v));
+			keptIndices.append(result.usedViews.at(v));
+			keptParameters += parameters.mid(INTRINSICS + POSE*v, POSE);
+		}
+		views = keptViews;
+		result.usedViews = keptIndices;
+		parameters = keptParameters;
+	}
+	if(isCancelled(cancelled)){
+		result.error = QObject::tr("Calibration cancelled.");
+		return result;
+	}
+
+	double sum = 0.0;
+	for(double error : result.viewErrors){
+		sum += error*error;
+	}
+	LensModel& lens = result.model;
+	lens.imageSize = imageSize;
+	lens.fx = parameters.at(0);
+	lens.fy = parameters.at(1);
+	lens.cx = parameters.at(2);
+	lens.cy = parameters.at(3);
+	lens.k1 = parameters.at(4);
+	lens.k2 = parameters.at(5);
+	lens.p1 = parameters.at(6);
+	lens.p2 = parameters.at(7);
+	lens.rmsError = qSqrt(sum/views.size());
+	lens.imageCount = views.size();
+	for(double value : parameters){
+		if(!qIsFinite(value)){
+			result.error = QObject::tr("Calibration did not converge, use images with differently tilted boards.");
+			return result;
+		}
+	}
+	if(!lens.isValid() || lens.cx < 0.0 || lens.cy < 0.0 || lens.cx >= imageSize.width() || lens.cy >= imageSize.height()){
+		result.error = QObject::tr("Calibration did not converge, use images with differently tilted boards.");
+		return result;
+	}
+	result.success = true;
+	return result;
+}
+
+LensCalibrationResult LensCalibration::calibrateImages(const QStringList& filePaths, const QSize& pattern, const QAtomicInt* cancelled) {
+	const int count = filePaths.size();
+	QVector<QVector<QPointF>> corners(count);
+	QVector<QSize> sizes(count);
+	QVector<bool> found(count, false);
+	WorkStealingPool::globalInstance()->parallelFor(count, [&](int i) {
+		if(isCancelled(cancelled)){
+			return;
+		}
+		const QImage image = QImage(filePaths.at(i)).convertToFormat(QImage::Format_Grayscale8);
+		if(image.isNull() || isCancelled(cancelled)){
+			return;
+		}
+		LumaImage luma;
+		luma.resize(image.width(), image.height());
+		for(int y = 0; y < luma.height; y++){
+			memcpy(luma.line(y), image.constScanLine(y), luma.width);
+		}
+		sizes[i] = image.size();
+		found[i] = findCheckerboard(luma, pattern, &corners[i], cancelled);
+	});
+	if(isCancelled(cancelled)){
+		LensCalibrationResult result;
+		result.error = QObject::tr("Calibration cancelled.");
+		return result;
+	}
+
+	//all views have to be taken with the same resolution, the first image with a checkerboard determines it
+	QSize imageSize;
+	QVector<QVector<QPointF>> views;
+	QVector<int> viewImages;
+	QStringList rejected;
+	for(int i = 0; i < count; i++){
+		if(found.at(i) && imageSize.isEmpty()){
+			imageSize = sizes.at(i);
+		}
+		if(found.at(i) && sizes.at(i) == imageSize){
+			views.append(corners.at(i));
+			viewImages.append(i);
+		} else {
+			rejected.append(filePaths.at(i));
+		}
+	}
+	LensCalibrationResult result = calibrate(views, pattern, imageSize, cancelled);
+	QVector<bool> used(views.size(), false);
+	for(int v : result.usedViews){
+		used[v] = true;
+		result.usedImages.append(filePaths.at(viewImages.at(v)));
+	}
+	for(int v = 0; v < views.size(); v++){
+		if(!used.at(v)){
+			rejected.append(filePaths.at(viewImages.at(v)));
+		}
+	}
+	result.rejectedImages = rejected;
+	return result;
+}
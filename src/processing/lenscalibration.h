@@ -0,0 +1,73 @@
+#ifndef LENSCALIBRATION_H
+#define LENSCALIBRATION_H
+
+#include <QVector>
+#include <QPointF>
+#include <QSize>
+#include <QStringList>
+#include <QAtomicInt>
+#include "lumaimage.h"
+
+
+//pinhole camera with radial (k1, k2) and tangential (p1, p2) distortion, the model of OpenCV with k3 = 0. all values are in pixels of imageSize,
+//pixel (0, 0) is centered at (0, 0)
+struct LensModel {
+	QSize imageSize; //resolution of the calibration images
+	double fx = 0.0; //focal length
+	double fy = 0.0;
+	double cx = 0.0; //principal point
+	double cy = 0.0;
+	double k1 = 0.0;
+	double k2 = 0.0;
+	double p1 = 0.0;
+	double p2 = 0.0;
+	double rmsError = 0.0; //reprojection error of the calibration in pixels
+	int imageCount = 0; //number of checkerboard images the model was estimated from
+
+	bool isValid() const {return !this->imageSize.isEmpty() && this->fx > 0.0 && this->fy > 0.0;}
+	bool operator==(const LensModel& other) const;
+	bool operator!=(const LensModel& other) const {return !(*this == other);}
+	//the model can be used for frames of another resolution with the same aspect ratio, assuming the camera bins or scales the same sensor area
+	bool isApplicableTo(const QSize& size) const;
+	LensModel scaledTo(const QSize& size) const;
+	//position in the camera frame of a position in the undistorted frame
+	QPointF distort(const QPointF& position) const;
+	//the same for positions normalized to the frame size (0..1, pixel edges), valid for every resolution the model is applicable to
+	QPointF distortNormalizedPosition(const QPointF& normalizedPosition) const;
+};
+
+struct LensCalibrationResult {
+	bool success = false;
+	QString error;
+	LensModel model;
+	QVector<int> usedViews; //indices of the views the model was estimated from, views with a much larger error than the others are left out
+	QVector<double> viewErrors; //rms reprojection error of every used view
+	QStringList usedImages; //only set by calibrateImages(), in the order of usedViews
+	QStringList rejectedImages; //checkerboard not found, other resolution than the first image or left out because of a large error
+};
+
+
+//estimates a LensModel from images of a planar checkerboard with Zhang's method. the inner corners are found as saddle points of the smoothed
+//image that pass a four sector test, grown into a lattice from a seed corner and refined to subpixel accuracy with the gradient orthogonality
+//criterion. initial intrinsics are derived from the homographies of the boards with the principal point at the image center, then intrinsics,
+//distortion and the poses of all boards are refined together by Levenberg-Marquardt minimization of the reprojection error
+class LensCalibration
+{
+public:
+	//pattern is the number of inner corners (columns x rows). the corners are returned row by row. a cancelled search returns false
+	static bool findCheckerboard(const LumaImage& image, const QSize& pattern, QVector<QPointF>* corners, const QAtomicInt* cancelled = nullptr);
+	//imagePoints holds the corners of every view as returned by findCheckerboard()
+	static LensCalibrationResult calibrate(const QVector<QVector<QPointF>>& imagePoints, const QSize& pattern, const QSize& imageSize,
+		const QAtomicInt* cancelled = nullptr);
+	//loads the images, searches the checkerboards in parallel on the WorkStealingPool and calibrates. blocks, has to be called from a worker.
+	//cancelled is polled between the steps, a cancelled calibration returns an unsuccessful result
+	static LensCalibrationResult calibrateImages(const QStringList& filePaths, const QSize& pattern, const QAtomicInt* cancelled = nullptr);
+
+	static const int MIN_VIEWS = 3;
+	static const int DETECTION_WIDTH = 1280; //wider images are decimated for the corner search, the corners are refined at full resolution
+	static const int SECTOR_RADIUS = 5; //radius of the four sector test in pixels of the search image, squares have to be larger than twice this
+	static const int MAX_SEEDS = 32;
+	static const int MAX_ITERATIONS = 100;
+};
+
+#endif //LENSCALIBRATION_H
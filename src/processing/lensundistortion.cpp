@@ -0,0 +1,294 @@
+#include "lensundistortion.h"
+#include "workstealingpool.h"
+#include <QElapsedTimer>
+#include <cstring>
+
+
+namespace {
+	//bytes of a plane with the given stride that the units of the pass cover, from the start of the plane
+	inline qint64 passExtent(const LensUndistortion::Pass& pass, int stride) {
+		return static_cast<qint64>(pass.rows - 1)*stride + (pass.units - 1)*pass.pixelStep + (pass.channels - 1)*pass.channelStep + pass.byteOffset + 1;
+	}
+
+	void fillUnits(uchar* dst, int from, int to, const LensUndistortion::Pass& pass) {
+		for(int i = from; i < to; i++){
+			for(int c = 0; c < pass.channels; c++){
+				dst[i*pass.pixelStep + c*pass.channelStep] = pass.fill[c];
+			}
+		}
+	}
+}
+
+
+LensUndistortion::LensUndistortion()
+	: active(0),
+	  lastProcessingTimeUs(-1),
+	  lastBuildTimeUs(-1)
+{
+}
+
+void LensUndistortion::setSettings(const LensUndistortionSettings& settings) {
+	QMutexLocker locker(&this->mutex);
+	this->settings = settings;
+	this->active.storeRelease(settings.enabled && settings.model.isValid() ? 1 : 0);
+}
+
+LensUndistortionSettings LensUndistortion::getSettings() const {
+	QMutexLocker locker(&this->mutex);
+	return this->settings;
+}
+
+bool LensUndistortion::isSupportedFormat(QVideoFrame::PixelFormat format) {
+	switch(format){
+		case QVideoFrame::Format_ARGB32:
+		case QVideoFrame::Format_ARGB32_Premultiplied:
+		case QVideoFrame::Format_RGB32:
+		case QVideoFrame::Format_BGRA32:
+		case QVideoFrame::Format_BGRA32_Premultiplied:
+		case QVideoFrame::Format_BGR32:
+		case QVideoFrame::Format_ABGR32:
+		case QVideoFrame::Format_Y8:
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY:
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21:
+			return true;
+		default:
+			return false;
+	}
+}
+
+int LensUndistortion::passes(QVideoFrame::PixelFormat format, const QSize& size, Pass* passes) {
+	const int width = size.width();
+	const int height = size.height();
+	for(int i = 0; i < MAX_PASSES; i++){
+		passes[i] = Pass();
+		passes[i].units = width;
+		passes[i].rows = height;
+	}
+	int count = 0;
+	switch(format){
+		case QVideoFrame::Format_Y8:
+			count = 1;
+			break;
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY: {
+			//luma and chroma of the packed plane are sampled separately, chroma per macro pixel
+			const bool yuyv = format == QVideoFrame::Format_YUYV;
+			passes[0].byteOffset = yuyv ? 0 : 1;
+			passes[0].pixelStep = 2;
+			passes[0].fill[0] = 16;
+			passes[1].byteOffset = yuyv ? 1 : 0;
+			passes[1].units = width/2;
+			passes[1].pixelStep = 4;
+			passes[1].channels = 2;
+			passes[1].channelStep = 2;
+			passes[1].scaleX = 2;
+			passes[1].fill[0] = passes[1].fill[1] = 128;
+			count = 2;
+			break;
+		}
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21: {
+			const bool planar = format == QVideoFrame::Format_YUV420P || format == QVideoFrame::Format_YV12;
+			count = planar ? 3 : 2;
+			passes[0].fill[0] = 16;
+			for(int plane = 1; plane < count; plane++){
+				Pass& chroma = passes[plane];
+				chroma.plane = plane;
+				chroma.units = width/2;
+				chroma.rows = height/2;
+				chroma.scaleX = 2;
+				chroma.scaleY = 2;
+				chroma.pixelStep = planar ? 1 : 2;
+				chroma.channels = planar ? 1 : 2;
+				chroma.fill[0] = chroma.fill[1] = 128;
+			}
+			break;
+		}
+		default: {
+			if(!isSupportedFormat(format)){
+				return 0;
+			}
+			//black, the alpha (or unused) byte is opaque. the formats are 32 bit words in native byte order
+			const bool alphaInLowByte = format == QVideoFrame::Format_BGRA32 || format == QVideoFrame::Format_BGRA32_Premultiplied
+				|| format == QVideoFrame::Format_BGR32;
+			const bool littleEndian = Q_BYTE_ORDER == Q_LITTLE_ENDIAN;
+			passes[0].pixelStep = 4;
+			passes[0].channels = 4;
+			passes[0].fill[alphaInLowByte == littleEndian ? 0 : 3] = 0xff;
+			count = 1;
+			break;
+		}
+	}
+	for(int i = 0; i < count; i++){
+		//the right and lower tap have to exist
+		if(passes[i].units < 2 || passes[i].rows < 2){
+			return 0;
+		}
+	}
+	return count;
+}
+
+LensUndistortion::PassTable LensUndistortion::buildTable(const LensModel& model, const Pass& pass, int sourceStride) {
+	PassTable table;
+	table.pass = pass;
+	const int count = pass.units*pass.rows;
+	QVector<quint8> inside(count);
+	quint8* insideData = inside.data();
+	const LensModel scaled = model.scaledTo(QSize(pass.units*pass.scaleX, pass.rows*pass.scaleY));
+	table.remap.build(QSize(pass.units, pass.rows), [&](int u, int y) {
+		//unit centers in frame pixels and back, chroma units cover scaleX x scaleY frame pixels
+		const QPointF source = scaled.distort(QPointF((u + 0.5)*pass.scaleX - 0.5, (y + 0.5)*pass.scaleY - 0.5));
+		const double sx = (source.x() + 0.5)/pass.scaleX - 0.5;
+		const double sy = (source.y() + 0.5)/pass.scaleY - 0.5;
+		//sources up to half a unit outside the plane still get the edge units
+		insideData[y*pass.units + u] = sx >= -0.5 && sy >= -0.5 && sx <= pass.units - 0.5 && sy <= pass.rows - 0.5 ? 1 : 0;
+		return QPointF(sx, sy);
+	}, QSize(pass.units, pass.rows), RemapTable::CLAMP);
+	table.remap.setLayout(pass.pixelStep, sourceStride, pass.byteOffset);
+	table.spans.resize(2*pass.rows);
+	for(int y = 0; y < pass.rows; y++){
+		const quint8* row = insideData + y*pass.units;
+		int first = 0;
+		while(first < pass.units && row[first] == 0){
+			first++;
+		}
+		int end = pass.units;
+		while(end > first && row[end - 1] == 0){
+			end--;
+		}
+		table.spans[2*y] = first;
+		table.spans[2*y + 1] = end;
+	}
+	return table;
+}
+
+void LensUndistortion::apply(const PassTable& table, const uchar* source, int sourceStride, uchar* dst, int dstStride) {
+	const Pass& pass = table.pass;
+	const RemapTable& remap = table.remap;
+	const int bands = (pass.rows + BAND_HEIGHT - 1)/BAND_HEIGHT;
+	WorkStealingPool::globalInstance()->parallelFor(bands, [&](int band) {
+		const int y1 = qMin(pass.rows, (band + 1)*BAND_HEIGHT);
+		for(int y = band*BAND_HEIGHT; y < y1; y++){
+			uchar* row = dst + y*dstStride + pass.byteOffset;
+			const int first = table.spans.at(2*y);
+			const int end = table.spans.at(2*y + 1);
+			const int index = y*pass.units + first;
+			fillUnits(row, 0, first, pass);
+			RemapTable::remap(source, remap.offsetsAt(index), remap.weightsAt(index), end - first, pass.pixelStep, sourceStride,
+				pass.channels, pass.channelStep, row + first*pass.pixelStep, pass.pixelStep);
+			fillUnits(row, end, pass.units, pass);
+		}
+	});
+}
+
+QVideoFrame LensUndistortion::process(const QVideoFrame& frame) {
+	QElapsedTimer timer;
+	timer.start();
+	const LensUndistortionSettings settings = this->getSettings();
+	const QVideoFrame::PixelFormat format = frame.pixelFormat();
+	if(!settings.enabled || !settings.model.isApplicableTo(frame.size()) || !isSupportedFormat(format)){
+		return QVideoFrame();
+	}
+	QVideoFrame source(frame);
+	if(!source.map(QAbstractVideoBuffer::ReadOnly)){
+		return QVideoFrame();
+	}
+	const int planeCount = source.planeCount();
+	QVideoFrame output(source.mappedBytes(), source.size(), source.bytesPerLine(), format);
+	if(planeCount > MAX_PLANES || !output.map(QAbstractVideoBuffer::WriteOnly) || output.planeCount() != planeCount){
+		if(output.isMapped()){
+			output.unmap();
+		}
+		source.unmap();
+		return QVideoFrame();
+	}
+
+	//the tables bake in the strides of the source planes
+	QSharedPointer<const Tables> tables;
+	for(int i = 0; i < this->tables.size() && tables.isNull(); i++){
+		const QSharedPointer<const Tables>& cached = this->tables.at(i);
+		bool matches = cached->model == settings.model && cached->format == format && cached->size == source.size();
+		for(int plane = 0; plane < planeCount && matches; plane++){
+			matches = cached->strides[plane] == source.bytesPerLine(plane);
+		}
+		if(matches){
+			tables = cached;
+			this->tables.move(i, 0);
+		}
+	}
+	if(tables.isNull()){
+		QElapsedTimer buildTimer;
+		buildTimer.start();
+		QSharedPointer<Tables> built(new Tables());
+		built->model = settings.model;
+		built->format = format;
+		built->size = source.size();
+		for(int plane = 0; plane < planeCount; plane++){
+			built->strides[plane] = source.bytesPerLine(plane);
+		}
+		Pass framePasses[MAX_PASSES];
+		const int passCount = passes(format, source.size(), framePasses);
+		for(int i = 0; i < passCount; i++){
+			if(framePasses[i].plane < planeCount){
+				built->passes.append(buildTable(settings.model, framePasses[i], source.bytesPerLine(framePasses[i].plane)));
+			}
+		}
+		tables = built;
+		this->tables.prepend(tables);
+		while(this->tables.size() > MAX_CACHED_TABLES){
+			this->tables.removeLast();
+		}
+		this->lastBuildTimeUs.storeRelease(static_cast<int>(buildTimer.nsecsElapsed()/1000));
+	}
+	bool complete = !tables->passes.isEmpty();
+	for(const PassTable& table : tables->passes){
+		const int plane = table.pass.plane;
+		const uchar* sourceBits = source.bits(plane);
+		uchar* outputBits = output.bits(plane);
+		const int outputStride = output.bytesPerLine(plane);
+		//planes that end before the mapped buffer would be read (or written) past the end
+		if(sourceBits + passExtent(table.pass, source.bytesPerLine(plane)) > source.bits() + source.mappedBytes()
+				|| outputBits + passExtent(table.pass, outputStride) > output.bits() + output.mappedBytes()){
+			complete = false;
+			break;
+		}
+		apply(table, sourceBits, source.bytesPerLine(plane), outputBits, outputStride);
+	}
+	output.unmap();
+	source.unmap();
+	if(!complete){
+		return QVideoFrame();
+	}
+	output.setStartTime(frame.startTime());
+	this->lastProcessingTimeUs.storeRelease(static_cast<int>(timer.nsecsElapsed()/1000));
+	return output;
+}
+
+QImage LensUndistortion::undistort(const QImage& image, const LensModel& model) {
+	if(!model.isApplicableTo(image.size()) || image.width() < 2 || image.height() < 2){
+		return image;
+	}
+	const QImage::Format format = image.format();
+	const QImage source = format == QImage::Format_RGB32 || format == QImage::Format_ARGB32 || format == QImage::Format_ARGB32_Premultiplied
+		? image : image.convertToFormat(QImage::Format_RGB32);
+	QImage result(source.size(), source.format());
+	if(result.isNull()){
+		return image;
+	}
+	Pass pass;
+	pass.units = source.width();
+	pass.rows = source.height();
+	pass.pixelStep = 4;
+	pass.channels = 4;
+	const quint32 black = 0xff000000u;
+	memcpy(pass.fill, &black, 4);
+	const PassTable table = buildTable(model, pass, source.bytesPerLine());
+	apply(table, source.constBits(), source.bytesPerLine(), result.bits(), result.bytesPerLine());
+	return result;
+}
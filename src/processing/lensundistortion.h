@@ -0,0 +1,98 @@
+#ifndef LENSUNDISTORTION_H
+#define LENSUNDISTORTION_H
+
+#include <QVideoFrame>
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QList>
+#include <QAtomicInt>
+#include "lenscalibration.h"
+#include "remaptable.h"
+
+
+struct LensUndistortionSettings {
+	bool enabled = false;
+	LensModel model;
+
+	bool isDefault() const {return !this->enabled && !this->model.isValid();}
+	bool operator==(const LensUndistortionSettings& other) const {return this->enabled == other.enabled && this->model == other.model;}
+	bool operator!=(const LensUndistortionSettings& other) const {return !(*this == other);}
+};
+
+//removes the lens distortion of a calibrated camera from the displayed frames, so straight edges of the sample appear straight and
+//measurements with the overlays are not bent towards the image corners. the source position of every output sample only depends on the
+//lens model and the frame layout, it is computed once into a RemapTable per plane (luma and chroma of packed 4:2:2 separately). every frame
+//is then remapped with the RemapTable kernels on row bands of the shared WorkStealingPool. the frames keep their pixel format and size,
+//output samples without a source inside the frame are black. frames published via FrameTapSurface::frameAvailable() are not affected
+class LensUndistortion
+{
+public:
+	//one plane (or the luma or chroma samples of a packed 4:2:2 plane) of a frame
+	struct Pass {
+		int plane = 0;
+		int byteOffset = 0; //of the first sample of a row
+		int units = 0; //pixels, chroma pairs or 4:2:2 macro pixels per row
+		int rows = 0;
+		int pixelStep = 1; //bytes between two units
+		int channels = 1; //samples per unit
+		int channelStep = 1; //bytes between the samples of a unit
+		int scaleX = 1; //frame pixels per unit
+		int scaleY = 1;
+		quint8 fill[4] = {}; //per channel, written where the source lies outside the frame
+	};
+
+	LensUndistortion();
+
+	//thread safe, may be called while process() runs on another thread
+	void setSettings(const LensUndistortionSettings& settings);
+	LensUndistortionSettings getSettings() const;
+	bool isActive() const {return this->active.loadAcquire() != 0;}
+
+	//returns the undistorted frame in the format of frame, or an invalid frame if the format is not supported, the model does not fit the
+	//aspect ratio of the frame or the frame can not be read
+	QVideoFrame process(const QVideoFrame& frame);
+	int getLastProcessingTimeUs() const {return this->lastProcessingTimeUs.loadAcquire();}
+	//time of the last table build. tables are built for the first frame of every model, format and layout, the last MAX_CACHED_TABLES are kept,
+	//so switching back to a resolution or camera does not build them again
+	int getLastBuildTimeUs() const {return this->lastBuildTimeUs.loadAcquire();}
+
+	static bool isSupportedFormat(QVideoFrame::PixelFormat format);
+	//undistorted copy of a 32 bit image (other formats are converted to RGB32), used for snapshots of the displayed image
+	static QImage undistort(const QImage& image, const LensModel& model);
+
+	static const int BAND_HEIGHT = 32;
+	static const int MAX_PLANES = 3;
+	static const int MAX_PASSES = 3;
+	static const int MAX_CACHED_TABLES = 4;
+
+private:
+	struct PassTable {
+		Pass pass;
+		RemapTable remap; //unit by unit, row by row. the offsets include byteOffset
+		QVector<int> spans; //first and end of the units of every row whose source lies inside the frame
+	};
+
+	struct Tables {
+		LensModel model;
+		QVideoFrame::PixelFormat format = QVideoFrame::Format_Invalid;
+		QSize size;
+		int strides[MAX_PLANES] = {};
+		QVector<PassTable> passes;
+	};
+
+	mutable QMutex mutex;
+	LensUndistortionSettings settings;
+	QAtomicInt active;
+	QAtomicInt lastProcessingTimeUs;
+	QAtomicInt lastBuildTimeUs;
+
+	//tables of the last used models, formats and resolutions, most recently used first. only used by the thread that calls process()
+	QList<QSharedPointer<const Tables>> tables;
+
+	static int passes(QVideoFrame::PixelFormat format, const QSize& size, Pass* passes);
+	static PassTable buildTable(const LensModel& model, const Pass& pass, int sourceStride);
+	static void apply(const PassTable& table, const uchar* source, int sourceStride, uchar* dst, int dstStride);
+};
+
+#endif //LENSUNDISTORTION_H
@@ -0,0 +1,114 @@
+#include "lineprofile.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <cmath>
+
+
+LineProfileAnalyzer::LineProfileAnalyzer(QObject *parent)
+	: FrameAnalyzer(parent),
+	  averagingWidth(1)
+{
+	qRegisterMetaType<LineProfile>("LineProfile");
+}
+
+LineProfileAnalyzer::~LineProfileAnalyzer() {
+	this->stopWorker();
+}
+
+void LineProfileAnalyzer::setLine(const QLineF& normalizedLine) {
+	QMutexLocker locker(&this->mutex);
+	this->normalizedLine = normalizedLine;
+}
+
+void LineProfileAnalyzer::setAveragingWidth(int width) {
+	QMutexLocker locker(&this->mutex);
+	this->averagingWidth = qBound(1, width, MAX_AVERAGING_WIDTH);
+}
+
+int LineProfileAnalyzer::getAveragingWidth() {
+	QMutexLocker locker(&this->mutex);
+	return this->averagingWidth;
+}
+
+void LineProfileAnalyzer::setLensModel(const LensModel& model) {
+	QMutexLocker locker(&this->mutex);
+	this->lensModel = model;
+}
+
+void LineProfileAnalyzer::analyzeFrame(const QVideoFrame& frame) {
+	this->mutex.lock();
+	QLineF line = this->normalizedLine;
+	int width = this->averagingWidth;
+	LensModel lensModel = this->lensModel;
+	this->mutex.unlock();
+	if(line.isNull()){
+		return;
+	}
+
+	this->updateTable(line, width, lensModel, frame.size());
+	SampleTable& table = this->table;
+	QVideoFrame mappedFrame;
+	LumaImage luma;
+	const uchar* base = table.remap.attach(frame, &mappedFrame, &luma);
+	if(base == nullptr){
+		return;
+	}
+	const int count = table.count;
+	this->sums.fill(0, count);
+	for(int k = 0; k < table.averagingWidth; k++){
+		RemapTable::accumulate(base, table.remap.offsetsAt(k*count), table.remap.weightsAt(k*count), count, table.remap.getPixelStep(),
+			table.remap.getRowStep(), this->sums.data());
+	}
+	if(mappedFrame.isMapped()){
+		mappedFrame.unmap();
+	}
+
+	LineProfile profile;
+	profile.valid = true;
+	profile.length = table.length;
+	profile.averagingWidth = table.averagingWidth;
+	profile.values.resize(count);
+	const float scale = 1.0f/(RemapTable::WEIGHT_ONE*table.averagingWidth);
+	for(int i = 0; i < count; i++){
+		profile.values[i] = this->sums.at(i)*scale;
+	}
+	profile.timestamp = QDateTime::currentMSecsSinceEpoch();
+	emit lineProfileMeasured(profile);
+}
+
+void LineProfileAnalyzer::updateTable(const QLineF& normalizedLine, int averagingWidth, const LensModel& lensModel, const QSize& frameSize) {
+	SampleTable& table = this->table;
+	if(table.normalizedLine == normalizedLine && table.averagingWidth == averagingWidth && table.lensModel == lensModel && table.frameSize == frameSize){
+		return;
+	}
+	table.normalizedLine = normalizedLine;
+	table.averagingWidth = averagingWidth;
+	table.lensModel = lensModel;
+	table.frameSize = frameSize;
+
+	//positions in pixel center coordinates
+	const QPointF start(normalizedLine.x1()*frameSize.width() - 0.5, normalizedLine.y1()*frameSize.height() - 0.5);
+	const QPointF end(normalizedLine.x2()*frameSize.width() - 0.5, normalizedLine.y2()*frameSize.height() - 0.5);
+	const QPointF delta = end - start;
+	table.length = std::hypot(delta.x(), delta.y());
+	table.count = qMax(2, qRound(table.length) + 1);
+	const QPointF step = delta/(table.count - 1);
+	const QPointF normal = table.length > 0.0 ? QPointF(-delta.y()/table.length, delta.x()/table.length) : QPointF(0.0, 1.0);
+
+	QVector<QPointF> positions;
+	positions.reserve(table.count*averagingWidth);
+	for(int k = 0; k < averagingWidth; k++){
+		const QPointF lineStart = start + normal*(k - (averagingWidth - 1)/2.0);
+		for(int i = 0; i < table.count; i++){
+			positions.append(lineStart + step*i);
+		}
+	}
+	//the samples are spaced along the undistorted line, only their source positions move
+	if(lensModel.isApplicableTo(frameSize)){
+		const LensModel scaledModel = lensModel.scaledTo(frameSize);
+		for(QPointF& position : positions){
+			position = scaledModel.distort(position);
+		}
+	}
+	table.remap.build(positions, frameSize, RemapTable::CLAMP);
+}
@@ -0,0 +1,73 @@
+#ifndef LINEPROFILE_H
+#define LINEPROFILE_H
+
+#include <QMutex>
+#include <QLineF>
+#include <QVector>
+#include <QMetaType>
+#include "frameanalyzer.h"
+#include "remaptable.h"
+#include "lenscalibration.h"
+
+
+struct LineProfile {
+	bool valid = false;
+	QVector<float> values; //luma (0..255) from the start to the end of the line, samples are about 1 px apart
+	double length = 0.0; //length of the line in frame pixels
+	int averagingWidth = 1; //number of parallel lines (1 px apart) that are averaged
+	qint64 timestamp = 0; //ms since epoch
+};
+Q_DECLARE_METATYPE(LineProfile)
+
+
+//samples the luma along a line (e.g. the line overlay) with bilinear interpolation, optionally averaged over parallel lines perpendicular
+//to it. the sample positions are turned into a RemapTable once when the line, the averaging width or the frame size changes, so a frame
+//costs one gather of four taps per sample. the luma is read in place for formats with a plain luma plane (see FrameConversion::lumaLayout),
+//other formats are converted for the bounding rect of the samples only
+class LineProfileAnalyzer : public FrameAnalyzer
+{
+	Q_OBJECT
+public:
+	explicit LineProfileAnalyzer(QObject *parent = nullptr);
+	~LineProfileAnalyzer();
+
+	//line in normalized frame coordinates (0..1). a null line disables the measurement
+	void setLine(const QLineF& normalizedLine);
+	void setAveragingWidth(int width);
+	int getAveragingWidth();
+	//lens distortion that is removed from the displayed frames. the line is then given in the undistorted frame and sampled along its
+	//(curved) image in the camera frame. an invalid model, or one that does not fit the frame, samples the frame as it is
+	void setLensModel(const LensModel& model);
+
+	static const int MAX_AVERAGING_WIDTH = 31;
+
+protected:
+	void analyzeFrame(const QVideoFrame& frame) override;
+
+private:
+	struct SampleTable {
+		QLineF normalizedLine;
+		QSize frameSize;
+		int averagingWidth = 0;
+		LensModel lensModel;
+		int count = 0; //samples along the line
+		double length = 0.0;
+		RemapTable remap; //averagingWidth rows of count samples
+	};
+
+	QMutex mutex;
+	QLineF normalizedLine;
+	int averagingWidth;
+	LensModel lensModel;
+
+	//only used by analyzeFrame()
+	SampleTable table;
+	QVector<qint32> sums;
+
+	void updateTable(const QLineF& normalizedLine, int averagingWidth, const LensModel& lensModel, const QSize& frameSize);
+
+signals:
+	void lineProfileMeasured(LineProfile profile);
+};
+
+#endif //LINEPROFILE_H
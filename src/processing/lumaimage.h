@@ -0,0 +1,21 @@
+#ifndef LUMAIMAGE_H
+#define LUMAIMAGE_H
+
+#include <QVector>
+#include <QtGlobal>
+
+
+//8-bit single channel image with stride == width. used as input for all analysis kernels
+struct LumaImage {
+	int width = 0;
+	int height = 0;
+	QVector<quint8> data;
+
+	bool isNull() const {return this->width <= 0 || this->height <= 0;}
+	void resize(int w, int h) {this->width = w; this->height = h; this->data.resize(w*h);}
+	quint8* line(int y) {return this->data.data() + y*this->width;}
+	const quint8* constLine(int y) const {return this->data.constData() + y*this->width;}
+};
+
+
+#endif //LUMAIMAGE_H
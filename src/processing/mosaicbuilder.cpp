@@ -0,0 +1,118 @@
+#include "mosaicbuilder.h"
+#include "framegrabber.h"
+#include <QDateTime>
+#include <QMutexLocker>
+
+//side length of the correlated patch. the whole frame is registered, so the patch is larger than the one of the drift tracker
+#define MOSAIC_PATCH_SIZE 256
+//minimum covered share of the mosaic below the predicted frame position, with less overlap the correlation is dominated by the empty area
+#define MOSAIC_MIN_OVERLAP 0.3
+//frames fade into the mosaic within this distance (frame pixels) from their border to hide seams
+#define MOSAIC_FEATHER_WIDTH 32
+//256 kB per tile, i.e. at most 128 MB of mosaic tiles in memory. everything else is spilled to disk
+#define MOSAIC_MAX_RESIDENT_TILES 512
+
+
+MosaicBuilder::MosaicBuilder(QObject *parent)
+	: FrameAnalyzer(parent),
+	  resetRequested(true),
+	  canvas(new MosaicCanvas(MOSAIC_MAX_RESIDENT_TILES)),
+	  demosaic(nullptr),
+	  windowLevel(nullptr),
+	  correlator(MOSAIC_PATCH_SIZE),
+	  placed(false),
+	  frameCount(0)
+{
+	qRegisterMetaType<MosaicStatus>("MosaicStatus");
+}
+
+MosaicBuilder::~MosaicBuilder() {
+	this->stopWorker();
+}
+
+void MosaicBuilder::reset() {
+	QMutexLocker locker(&this->mutex);
+	this->resetRequested = true;
+	locker.unlock();
+	//frees memory and spill file right away, a frame that is blended concurrently is removed by the reset of the worker
+	this->canvas->clear();
+}
+
+LumaImage MosaicBuilder::toLuma(const QImage& image, int step) {
+	//same sampling and weights as MosaicCanvas::sampleLuma, so frame and mosaic are compared on equal terms
+	LumaImage luma;
+	luma.resize((image.width() + step - 1)/step, (image.height() + step - 1)/step);
+	for(int j = 0; j < luma.height; j++){
+		const quint32* line = reinterpret_cast<const quint32*>(image.constScanLine(j*step));
+		quint8* lumaLine = luma.line(j);
+		for(int i = 0; i < luma.width; i++){
+			const quint32 pixel = line[i*step];
+			lumaLine[i] = static_cast<quint8>((77*((pixel >> 16) & 0xff) + 150*((pixel >> 8) & 0xff) + 29*(pixel & 0xff)) >> 8);
+		}
+	}
+	return luma;
+}
+
+void MosaicBuilder::analyzeFrame(const QVideoFrame& frame) {
+	this->mutex.lock();
+	bool resetRequested = this->resetRequested;
+	this->resetRequested = false;
+	this->mutex.unlock();
+
+	QImage image = FrameGrabber::toRgb(frame, this->demosaic, this->windowLevel);
+	if(image.isNull()){
+		return;
+	}
+	image = image.convertToFormat(QImage::Format_RGB32);
+
+	//a mosaic is built from frames of a single resolution
+	if(resetRequested || (this->placed && image.size() != this->frameSize)){
+		this->canvas->clear();
+		this->placed = false;
+		this->frameCount = 0;
+	}
+
+	MosaicStatus status;
+	if(!this->placed){
+		this->position = QPoint(0, 0);
+		this->motion = QPoint(0, 0);
+		this->frameSize = image.size();
+		this->placed = true;
+		status.tracking = true;
+		status.confidence = 1.0;
+	}else{
+		const int step = qMax(1, qMin(image.width(), image.height())/(2*MOSAIC_PATCH_SIZE));
+		const QPoint predicted = this->position + this->motion;
+		double coverage = 0.0;
+		LumaImage reference = this->canvas->sampleLuma(QRect(predicted, image.size()), step, &coverage);
+		if(coverage >= MOSAIC_MIN_OVERLAP){
+			std::vector<PhaseCorrelator::Complex> referenceSpectrum = this->correlator.spectrum(PhaseCorrelator::toPatch(reference, MOSAIC_PATCH_SIZE));
+			PhaseCorrelationResult result = this->correlator.correlate(this->correlator.spectrum(PhaseCorrelator::toPatch(toLuma(image, step), MOSAIC_PATCH_SIZE)), referenceSpectrum);
+			status.confidence = result.peak;
+			//registrations with a lower correlation peak do not match the mosaic and are rejected
+			if(result.peak >= this->correlator.getMinReliablePeak()){
+				//content that moved by d within the frame means that the frame moved by -d over the sample
+				const QPoint offset(qRound(result.dx*image.width()/MOSAIC_PATCH_SIZE), qRound(result.dy*image.height()/MOSAIC_PATCH_SIZE));
+				const QPoint measured = predicted - offset;
+				this->motion = measured - this->position;
+				this->position = measured;
+				status.tracking = true;
+			}
+		}
+		if(!status.tracking){
+			this->motion = QPoint(0, 0);
+		}
+	}
+
+	if(status.tracking){
+		this->canvas->blend(image, this->position, MOSAIC_FEATHER_WIDTH);
+		this->frameCount++;
+	}
+	status.framePosition = this->position;
+	status.frameSize = this->frameSize;
+	status.bounds = this->canvas->getBounds();
+	status.frameCount = this->frameCount;
+	status.canvas = this->canvas->getStatistics();
+	status.timestamp = QDateTime::currentMSecsSinceEpoch();
+	emit mosaicUpdated(status);
+}
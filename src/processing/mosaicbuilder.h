@@ -0,0 +1,74 @@
+#ifndef MOSAICBUILDER_H
+#define MOSAICBUILDER_H
+
+#include <QMutex>
+#include <QPoint>
+#include <QSize>
+#include <QSharedPointer>
+#include <QMetaType>
+#include "frameanalyzer.h"
+#include "phasecorrelator.h"
+#include "mosaiccanvas.h"
+#include "demosaic.h"
+#include "windowlevel.h"
+
+
+struct MosaicStatus {
+	bool tracking = false; //the last analyzed frame was registered and blended into the mosaic
+	QPoint framePosition; //top left corner of the last registered frame in mosaic pixels
+	QSize frameSize;
+	QRect bounds; //area covered by the mosaic in mosaic pixels
+	double confidence = 0.0; //phase correlation peak of the last registration, 0..1
+	int frameCount = 0; //frames blended since the last reset
+	MosaicCanvasStatistics canvas;
+	qint64 timestamp = 0; //ms since epoch
+};
+Q_DECLARE_METATYPE(MosaicStatus)
+
+
+//stitches the live frames into a mosaic while the sample is moved. the first frame is placed at the origin, every following frame is registered
+//by phase correlation of the downsampled frame against the mosaic around the predicted position (last position plus last motion) and blended
+//in at the measured position. frames that can not be registered (too little overlap or no clear correlation peak) are not blended, the builder
+//keeps trying at the last position, so moving the sample back to a known area resumes the mosaic
+class MosaicBuilder : public FrameAnalyzer
+{
+	Q_OBJECT
+public:
+	explicit MosaicBuilder(QObject *parent = nullptr);
+	~MosaicBuilder();
+
+	//shared with the display, which reads the tiles of the canvas
+	QSharedPointer<MosaicCanvas> getCanvas() const {return this->canvas;}
+	//settings for the conversion of raw and 16 bit frames, see FrameGrabber::toRgb. both have to outlive the builder
+	void setDemosaic(const Demosaic* demosaic) {this->demosaic = demosaic;}
+	void setWindowLevel(const WindowLevel* windowLevel) {this->windowLevel = windowLevel;}
+
+protected:
+	void analyzeFrame(const QVideoFrame& frame) override;
+
+private:
+	QMutex mutex;
+	bool resetRequested;
+	QSharedPointer<MosaicCanvas> canvas;
+	const Demosaic* demosaic;
+	const WindowLevel* windowLevel;
+
+	//worker thread state
+	PhaseCorrelator correlator;
+	bool placed;
+	QPoint position;
+	QPoint motion;
+	QSize frameSize;
+	int frameCount;
+
+	static LumaImage toLuma(const QImage& image, int step);
+
+public slots:
+	//clears the mosaic, the next frame starts a new one
+	void reset();
+
+signals:
+	void mosaicUpdated(MosaicStatus status);
+};
+
+#endif //MOSAICBUILDER_H
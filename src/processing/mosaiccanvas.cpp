@@ -0,0 +1,648 @@
+#include "mosaiccanvas.h"
+#include "workstealingpool.h"
+#include "simd.h"
+#include <QMutexLocker>
+#include <QVector>
+#include <QDir>
+
+#define TILE_BYTES (MosaicCanvas::TILE_SIZE*MosaicCanvas::TILE_SIZE*4)
+
+
+//integer division that rounds towards minus infinity, tile coordinates of the canvas are negative left of and above the first frame
+static inline int floorDiv(int value, int divisor) {
+	return value >= 0 ? value/divisor : -((-value + divisor - 1)/divisor);
+}
+
+//tile range of a rect given in pixels of the level, tiles are TILE_SIZE pixels wide on every level
+static inline QRect tileRange(const QRect& rect, int tileSize) {
+	return QRect(QPoint(floorDiv(rect.left(), tileSize), floorDiv(rect.top(), tileSize)),
+				 QPoint(floorDiv(rect.right(), tileSize), floorDiv(rect.bottom(), tileSize)));
+}
+
+//weight of a frame pixel that is distance pixels away from the frame border, 0..256
+static inline quint16 featherWeight(int distance, int featherWidth) {
+	if(distance >= featherWidth){
+		return 256;
+	}
+	return static_cast<quint16>((distance + 1)*256/(featherWidth + 1));
+}
+
+
+MosaicCanvas::MosaicCanvas(int maxResidentTiles)
+	: maxResidentTiles(qMax(16, maxResidentTiles)),
+	  newestTile(nullptr),
+	  oldestTile(nullptr),
+	  writing(false),
+	  loaderRunning(false),
+	  loadingKey(0),
+	  loadingKeyChanged(false),
+	  spillFile(QDir::tempPath() + "/octproz_mosaic_XXXXXX.tiles"),
+	  spillFileSize(0),
+	  generation(0)
+{
+}
+
+MosaicCanvas::~MosaicCanvas() {
+	this->mutex.lock();
+	this->loadQueue.clear();
+	this->tileLoadedCallback = nullptr;
+	this->mutex.unlock();
+	this->loadTasks.waitForAll();
+	qDeleteAll(this->residentTiles);
+}
+
+void MosaicCanvas::clear() {
+	QMutexLocker locker(&this->mutex);
+	QMutexLocker spillLocker(&this->spillMutex);
+	//tiles pinned by a concurrent blend() are deleted when it releases them
+	for(auto it = this->residentTiles.constBegin(); it != this->residentTiles.constEnd(); ++it){
+		if(it.value()->pins > 0){
+			it.value()->removed = true;
+		}else{
+			delete it.value();
+		}
+	}
+	this->residentTiles.clear();
+	this->newestTile = nullptr;
+	this->oldestTile = nullptr;
+	this->evictedTiles.clear();
+	this->writeQueue.clear();
+	this->loadQueue.clear();
+	this->loadingKeyChanged = true;
+	this->spillSlots.clear();
+	this->generation++;
+	if(this->spillFile.isOpen()){
+		this->spillFile.resize(0);
+	}
+	this->spillFileSize = 0;
+	this->spillError.clear();
+	this->bounds = QRect();
+}
+
+void MosaicCanvas::setTileLoadedCallback(std::function<void()> callback) {
+	QMutexLocker locker(&this->mutex);
+	this->tileLoadedCallback = callback;
+}
+
+QRect MosaicCanvas::blend(const QImage& frame, const QPoint& position, int featherWidth) {
+	if(frame.isNull() || frame.depth() != 32){
+		return QRect();
+	}
+	const QRect frameRect(position, frame.size());
+	QVector<quint16> columnWeights(frame.width());
+	for(int x = 0; x < frame.width(); x++){
+		columnWeights[x] = featherWeight(qMin(x, frame.width() - 1 - x), featherWidth);
+	}
+
+	QMutexLocker locker(&this->mutex);
+	//all tiles are acquired and pinned before the parallel part, which runs without the mutex. the frame is blended into detached copies
+	//of the tile images that replace them afterwards, so tiles() keeps handing out the previous content in the meantime. level 0 tiles
+	//are only written here and blend() is called by a single analyzer task, so no other change of the targets can get lost
+	QVector<Tile*> targets;
+	QVector<QImage> images;
+	QVector<uchar*> targetBits;
+	QVector<QRect> targetRects;
+	const QRect range = tileRange(frameRect, TILE_SIZE);
+	for(int ty = range.top(); ty <= range.bottom(); ty++){
+		for(int tx = range.left(); tx <= range.right(); tx++){
+			Tile* tile = this->acquireTile(0, tx, ty, true);
+			targets.append(tile);
+			images.append(tile->image);
+			targetBits.append(images.last().bits());
+			targetRects.append(QRect(tx*TILE_SIZE, ty*TILE_SIZE, TILE_SIZE, TILE_SIZE));
+		}
+	}
+	const int generation = this->generation;
+	locker.unlock();
+
+	WorkStealingPool::globalInstance()->parallelFor(targets.size(), [&](int i) {
+		const QRect tileRect = targetRects.at(i);
+		const QRect part = tileRect.intersected(frameRect);
+		uchar* bits = targetBits.at(i);
+		const int stride = images.at(i).bytesPerLine();
+		const int frameX = part.left() - position.x();
+		for(int y = part.top(); y <= part.bottom(); y++){
+			const int frameY = y - position.y();
+			const int rowWeight = featherWeight(qMin(frameY, frame.height() - 1 - frameY), featherWidth);
+			const quint32* src = reinterpret_cast<const quint32*>(frame.constScanLine(frameY)) + frameX;
+			quint32* dst = reinterpret_cast<quint32*>(bits + (y - tileRect.top())*stride) + (part.left() - tileRect.left());
+			blendRow(src, dst, columnWeights.constData() + frameX, rowWeight, part.width());
+		}
+	});
+
+	locker.relock();
+	for(int i = 0; i < targets.size(); i++){
+		targets.at(i)->image = images.at(i);
+		targets.at(i)->dirty = true;
+		this->releaseTile(targets.at(i));
+	}
+	//a clear() while the frame was blended removed the targets, the frame is not part of the new canvas
+	if(generation == this->generation){
+		this->bounds = this->bounds.united(frameRect);
+		QRect levelRect = frameRect;
+		for(int level = 1; level < LEVELS; level++){
+			levelRect = this->updateLevel(level, levelRect);
+		}
+		this->evictTiles();
+	}
+	locker.unlock();
+	this->writeEvictedTiles();
+	return frameRect;
+}
+
+QRect MosaicCanvas::updateLevel(int level, const QRect& sourceRect) {
+	//every target pixel is the average of a LEVEL_FACTOR x LEVEL_FACTOR block of the level below. tiles are multiples of LEVEL_FACTOR
+	//wide, so no block crosses a tile border and the blocks of one source tile go to exactly one target tile
+	const QRect targetRect(QPoint(floorDiv(sourceRect.left(), LEVEL_FACTOR), floorDiv(sourceRect.top(), LEVEL_FACTOR)),
+						   QPoint(floorDiv(sourceRect.right(), LEVEL_FACTOR), floorDiv(sourceRect.bottom(), LEVEL_FACTOR)));
+	const QRect range = tileRange(targetRect, TILE_SIZE);
+	for(int ty = range.top(); ty <= range.bottom(); ty++){
+		for(int tx = range.left(); tx <= range.right(); tx++){
+			const QRect tileRect(tx*TILE_SIZE, ty*TILE_SIZE, TILE_SIZE, TILE_SIZE);
+			const QRect part = tileRect.intersected(targetRect);
+			const QRect sourcePart(part.left()*LEVEL_FACTOR, part.top()*LEVEL_FACTOR, part.width()*LEVEL_FACTOR, part.height()*LEVEL_FACTOR);
+			Tile* target = this->acquireTile(level, tx, ty, true);
+			uchar* targetBits = target->image.bits();
+			const int stride = target->image.bytesPerLine();
+			target->dirty = true;
+
+			const QRect sourceRange = tileRange(sourcePart, TILE_SIZE);
+			for(int sy = sourceRange.top(); sy <= sourceRange.bottom(); sy++){
+				for(int sx = sourceRange.left(); sx <= sourceRange.right(); sx++){
+					//missing source tiles are empty, the target pixels they cover stay empty as well
+					Tile* source = this->acquireTile(level - 1, sx, sy, false);
+					if(source == nullptr){
+						continue;
+					}
+					const QRect sourceTileRect(sx*TILE_SIZE, sy*TILE_SIZE, TILE_SIZE, TILE_SIZE);
+					const QRect block = sourceTileRect.intersected(sourcePart);
+					const uchar* sourceBits = source->image.constBits();
+					const int sourceStride = source->image.bytesPerLine();
+					for(int y = block.top(); y <= block.bottom(); y += LEVEL_FACTOR){
+						const uchar* src = sourceBits + (y - sourceTileRect.top())*sourceStride + (block.left() - sourceTileRect.left())*4;
+						quint32* dst = reinterpret_cast<quint32*>(targetBits + (y/LEVEL_FACTOR - tileRect.top())*stride) + (block.left()/LEVEL_FACTOR - tileRect.left());
+						downsampleRow(src, sourceStride, dst, block.width()/LEVEL_FACTOR);
+					}
+					this->releaseTile(source);
+				}
+			}
+			this->releaseTile(target);
+		}
+	}
+	return targetRect;
+}
+
+LumaImage MosaicCanvas::sampleLuma(const QRect& rect, int step, double* coverage) {
+	LumaImage luma;
+	step = qMax(1, step);
+	const int width = (rect.width() + step - 1)/step;
+	const int height = (rect.height() + step - 1)/step;
+	if(coverage != nullptr){
+		*coverage = 0.0;
+	}
+	if(width <= 0 || height <= 0){
+		return luma;
+	}
+	luma.resize(width, height);
+	QVector<quint8> covered(width*height, 0);
+	qint64 sum = 0;
+	int count = 0;
+
+	QMutexLocker locker(&this->mutex);
+	const QRect range = tileRange(rect, TILE_SIZE);
+	for(int ty = range.top(); ty <= range.bottom(); ty++){
+		for(int tx = range.left(); tx <= range.right(); tx++){
+			Tile* tile = this->acquireTile(0, tx, ty, false);
+			if(tile == nullptr){
+				continue;
+			}
+			const QRect tileRect(tx*TILE_SIZE, ty*TILE_SIZE, TILE_SIZE, TILE_SIZE);
+			//samples of this tile, sample i is at rect.left() + i*step
+			const int i0 = qMax(0, (qMax(0, tileRect.left() - rect.left()) + step - 1)/step);
+			const int i1 = qMin(width - 1, (tileRect.right() - rect.left())/step);
+			const int j0 = qMax(0, (qMax(0, tileRect.top() - rect.top()) + step - 1)/step);
+			const int j1 = qMin(height - 1, (tileRect.bottom() - rect.top())/step);
+			for(int j = j0; j <= j1; j++){
+				const quint32* line = reinterpret_cast<const quint32*>(tile->image.constScanLine(rect.top() + j*step - tileRect.top()));
+				quint8* lumaLine = luma.line(j);
+				quint8* coveredLine = covered.data() + j*width;
+				for(int i = i0; i <= i1; i++){
+					const quint32 pixel = line[rect.left() + i*step - tileRect.left()];
+					if((pixel >> 24) == 0){
+						continue;
+					}
+					const int value = (77*((pixel >> 16) & 0xff) + 150*((pixel >> 8) & 0xff) + 29*(pixel & 0xff)) >> 8;
+					lumaLine[i] = static_cast<quint8>(value);
+					coveredLine[i] = 1;
+					sum += value;
+					count++;
+				}
+			}
+			this->releaseTile(tile);
+		}
+	}
+	this->evictTiles();
+	locker.unlock();
+	this->writeEvictedTiles();
+
+	//empty parts are filled with the mean so they add no structure to the correlation
+	const quint8 mean = count > 0 ? static_cast<quint8>(sum/count) : 0;
+	for(int i = 0; i < width*height; i++){
+		if(covered.at(i) == 0){
+			luma.data[i] = mean;
+		}
+	}
+	if(coverage != nullptr){
+		*coverage = static_cast<double>(count)/(width*height);
+	}
+	return luma;
+}
+
+QList<QPair<QRect, QImage>> MosaicCanvas::tiles(int level, const QRectF& rect) {
+	QList<QPair<QRect, QImage>> result;
+	level = qBound(0, level, LEVELS - 1);
+	int scale = 1;
+	for(int i = 0; i < level; i++){
+		scale *= LEVEL_FACTOR;
+	}
+	const int tileSpan = TILE_SIZE*scale;
+	QMutexLocker locker(&this->mutex);
+	const QRect visible = rect.toAlignedRect().intersected(this->bounds);
+	if(visible.isEmpty()){
+		return result;
+	}
+	//only tiles in memory are handed out, this runs in the gui thread and must not wait for the spill file
+	const QRect range = tileRange(visible, tileSpan);
+	for(int ty = range.top(); ty <= range.bottom(); ty++){
+		for(int tx = range.left(); tx <= range.right(); tx++){
+			const quint64 key = tileKey(level, tx, ty);
+			const QRect tileRect(tx*tileSpan, ty*tileSpan, tileSpan, tileSpan);
+			Tile* tile = this->residentTiles.value(key, nullptr);
+			if(tile != nullptr){
+				this->unlinkTile(tile);
+				this->linkTile(tile);
+				result.append(qMakePair(tileRect, tile->image));
+			}else if(this->evictedTiles.contains(key)){
+				result.append(qMakePair(tileRect, this->evictedTiles.value(key)));
+			}else if(this->spillSlots.contains(key)){
+				this->loadQueue.removeOne(key);
+				this->loadQueue.append(key);
+				result.append(qMakePair(tileRect, this->coarserTile(level, tx, ty)));
+			}
+		}
+	}
+	//requests of areas that were scrolled past long ago are dropped
+	while(this->loadQueue.size() > this->maxResidentTiles/4){
+		this->loadQueue.removeFirst();
+	}
+	this->startLoader();
+	return result;
+}
+
+QImage MosaicCanvas::coarserTile(int level, int x, int y) {
+	int factor = 1;
+	for(int coarser = level + 1; coarser < LEVELS; coarser++){
+		factor *= LEVEL_FACTOR;
+		const int coarserX = floorDiv(x, factor);
+		const int coarserY = floorDiv(y, factor);
+		const quint64 key = tileKey(coarser, coarserX, coarserY);
+		Tile* tile = this->residentTiles.value(key, nullptr);
+		const QImage image = tile != nullptr ? tile->image : this->evictedTiles.value(key);
+		if(!image.isNull()){
+			const int size = TILE_SIZE/factor;
+			return image.copy((x - coarserX*factor)*size, (y - coarserY*factor)*size, size, size);
+		}
+	}
+	return QImage();
+}
+
+void MosaicCanvas::startLoader() {
+	//a single loader task reads the requested tiles one after another and picks up the requests made while it runs
+	if(this->loaderRunning || this->loadQueue.isEmpty()){
+		return;
+	}
+	this->loaderRunning = true;
+	this->loadTasks.add();
+	bool accepted = WorkStealingPool::globalInstance()->trySubmit([this]() {
+		this->loadTiles();
+		this->loadTasks.done();
+	});
+	if(!accepted){
+		//the requests stay queued, the next call of tiles() tries again
+		this->loaderRunning = false;
+		this->loadTasks.done();
+	}
+}
+
+void MosaicCanvas::loadTiles() {
+	QMutexLocker locker(&this->mutex);
+	while(!this->loadQueue.isEmpty()){
+		const quint64 key = this->loadQueue.takeLast();
+		const qint64 offset = this->spillSlots.value(key, -1);
+		if(offset < 0 || this->residentTiles.contains(key) || this->evictedTiles.contains(key)){
+			continue;
+		}
+		this->loadingKey = key;
+		this->loadingKeyChanged = false;
+		const int generation = this->generation;
+		locker.unlock();
+		QImage image(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+		QString error;
+		const bool loaded = this->readSlot(offset, generation, image.bits(), &error);
+		locker.relock();
+		if(!error.isEmpty()){
+			this->spillError = error;
+		}
+		if(!loaded || this->loadingKeyChanged){
+			continue;
+		}
+		Tile* tile = new Tile();
+		tile->key = key;
+		tile->image = image;
+		this->residentTiles.insert(key, tile);
+		this->linkTile(tile);
+		this->evictTiles();
+		if(this->tileLoadedCallback){
+			this->tileLoadedCallback();
+		}
+	}
+	this->loaderRunning = false;
+	locker.unlock();
+	this->writeEvictedTiles();
+}
+
+QRect MosaicCanvas::getBounds() {
+	QMutexLocker locker(&this->mutex);
+	return this->bounds;
+}
+
+MosaicCanvasStatistics MosaicCanvas::getStatistics() {
+	QMutexLocker locker(&this->mutex);
+	MosaicCanvasStatistics statistics;
+	statistics.tileCount = this->spillSlots.size();
+	for(auto it = this->residentTiles.constBegin(); it != this->residentTiles.constEnd(); ++it){
+		if(!this->spillSlots.contains(it.key())){
+			statistics.tileCount++;
+		}
+	}
+	for(auto it = this->evictedTiles.constBegin(); it != this->evictedTiles.constEnd(); ++it){
+		if(!this->spillSlots.contains(it.key())){
+			statistics.tileCount++;
+		}
+	}
+	statistics.residentTiles = this->residentTiles.size() + this->evictedTiles.size();
+	statistics.residentBytes = static_cast<qint64>(statistics.residentTiles)*TILE_BYTES;
+	statistics.spillFileBytes = this->spillFileSize;
+	statistics.spillError = this->spillError;
+	return statistics;
+}
+
+quint64 MosaicCanvas::tileKey(int level, int x, int y) {
+	//28 bits per coordinate, i.e. +-2^27 tiles of TILE_SIZE pixels in every direction
+	return (static_cast<quint64>(level) << 56) | ((static_cast<quint64>(static_cast<quint32>(x)) & 0xfffffff) << 28)
+		| (static_cast<quint64>(static_cast<quint32>(y)) & 0xfffffff);
+}
+
+MosaicCanvas::Tile* MosaicCanvas::acquireTile(int level, int x, int y, bool create) {
+	const quint64 key = tileKey(level, x, y);
+	Tile* tile = this->residentTiles.value(key, nullptr);
+	if(tile == nullptr){
+		const bool evicted = this->evictedTiles.contains(key);
+		const bool spilled = this->spillSlots.contains(key);
+		if(!evicted && !spilled && !create){
+			return nullptr;
+		}
+		tile = new Tile();
+		tile->key = key;
+		if(evicted){
+			//whether or not it was written already, the tile is written again on its next eviction
+			tile->image = this->evictedTiles.take(key);
+			tile->dirty = true;
+		}else{
+			tile->image = QImage(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+			if(!spilled || !this->readSlot(this->spillSlots.value(key), this->generation, tile->image.bits(), &this->spillError)){
+				tile->image.fill(0);
+			}
+		}
+		this->residentTiles.insert(key, tile);
+		//a background load of this tile may read a slot that is rewritten before the load finishes
+		if(key == this->loadingKey){
+			this->loadingKeyChanged = true;
+		}
+	}else{
+		this->unlinkTile(tile);
+	}
+	this->linkTile(tile);
+	tile->pins++;
+	return tile;
+}
+
+void MosaicCanvas::releaseTile(Tile* tile) {
+	tile->pins--;
+	if(tile->pins == 0 && tile->removed){
+		delete tile;
+	}
+}
+
+void MosaicCanvas::linkTile(Tile* tile) {
+	tile->older = this->newestTile;
+	tile->newer = nullptr;
+	if(this->newestTile != nullptr){
+		this->newestTile->newer = tile;
+	}
+	this->newestTile = tile;
+	if(this->oldestTile == nullptr){
+		this->oldestTile = tile;
+	}
+}
+
+void MosaicCanvas::unlinkTile(Tile* tile) {
+	if(tile->newer != nullptr){
+		tile->newer->older = tile->older;
+	}else{
+		this->newestTile = tile->older;
+	}
+	if(tile->older != nullptr){
+		tile->older->newer = tile->newer;
+	}else{
+		this->oldestTile = tile->newer;
+	}
+	tile->newer = nullptr;
+	tile->older = nullptr;
+}
+
+void MosaicCanvas::evictTiles() {
+	//from the least recently used end, pinned tiles are skipped. they are the ones of the current frame near the other end, so a single frame
+	//that covers more than maxResidentTiles tiles temporarily exceeds the limit
+	Tile* tile = this->oldestTile;
+	while(this->residentTiles.size() > this->maxResidentTiles && tile != nullptr){
+		Tile* newer = tile->newer;
+		if(tile->pins == 0){
+			if(tile->dirty || !this->spillSlots.contains(tile->key)){
+				this->evictedTiles.insert(tile->key, tile->image);
+				this->writeQueue.append(tile->key);
+			}
+			this->unlinkTile(tile);
+			this->residentTiles.remove(tile->key);
+			delete tile;
+		}
+		tile = newer;
+	}
+}
+
+void MosaicCanvas::writeEvictedTiles() {
+	QMutexLocker locker(&this->mutex);
+	//a single writer keeps the writes of a tile that is evicted several times in order
+	if(this->writing){
+		return;
+	}
+	this->writing = true;
+	while(!this->writeQueue.isEmpty()){
+		const quint64 key = this->writeQueue.takeFirst();
+		//taken back by acquireTile() in the meantime
+		if(!this->evictedTiles.contains(key)){
+			continue;
+		}
+		const QImage image = this->evictedTiles.value(key);
+		qint64 offset = this->spillSlots.value(key, -1);
+		const bool newSlot = offset < 0;
+		if(newSlot){
+			offset = this->spillFileSize;
+			this->spillFileSize += TILE_BYTES;
+			this->spillSlots.insert(key, offset);
+		}
+		const int generation = this->generation;
+		locker.unlock();
+		QString error;
+		const bool written = this->writeSlot(offset, generation, image.constBits(), &error);
+		locker.relock();
+		if(generation != this->generation){
+			continue;
+		}
+		if(!written){
+			//a tile that can not be written is lost, memory stays bounded in any case
+			this->spillError = error;
+			if(newSlot){
+				this->spillSlots.remove(key);
+				if(offset + TILE_BYTES == this->spillFileSize){
+					this->spillFileSize = offset;
+				}
+			}
+		}
+		//unless it was taken back and evicted again with new content, which is queued again
+		if(this->evictedTiles.value(key).cacheKey() == image.cacheKey()){
+			this->evictedTiles.remove(key);
+		}
+	}
+	this->writing = false;
+}
+
+bool MosaicCanvas::writeSlot(qint64 offset, int generation, const uchar* bits, QString* error) {
+	QMutexLocker locker(&this->spillMutex);
+	if(generation != this->generation){
+		return false;
+	}
+	if(!this->spillFile.isOpen() && !this->spillFile.open()){
+		*error = this->spillFile.errorString();
+		return false;
+	}
+	if(!this->spillFile.seek(offset) || this->spillFile.write(reinterpret_cast<const char*>(bits), TILE_BYTES) != TILE_BYTES){
+		*error = this->spillFile.errorString();
+		return false;
+	}
+	return true;
+}
+
+bool MosaicCanvas::readSlot(qint64 offset, int generation, uchar* bits, QString* error) {
+	QMutexLocker locker(&this->spillMutex);
+	if(generation != this->generation){
+		return false;
+	}
+	if(!this->spillFile.seek(offset) || this->spillFile.read(reinterpret_cast<char*>(bits), TILE_BYTES) != TILE_BYTES){
+		*error = this->spillFile.errorString();
+		return false;
+	}
+	return true;
+}
+
+void MosaicCanvas::blendRow(const quint32* src, quint32* dst, const quint16* columnWeights, int rowWeight, int count, bool vectorized) {
+	int x = 0;
+#ifdef CAMERAEXTENSION_SSE2
+	if(vectorized){
+		//a*w + b*(256 - w) + 128 <= 255*256 + 128 fits into an unsigned 16 bit lane
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rowWeights = _mm_set1_epi16(static_cast<short>(rowWeight));
+		const __m128i fullWeights = _mm_set1_epi32(256);
+		const __m128i one = _mm_set1_epi16(256);
+		const __m128i half = _mm_set1_epi16(128);
+		for(; x + 4 <= count; x += 4){
+			const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+			const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + x));
+			__m128i weights = _mm_min_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(columnWeights + x)), rowWeights);
+			weights = _mm_unpacklo_epi16(weights, zero);
+			const __m128i empty = _mm_cmpeq_epi32(_mm_srli_epi32(d, 24), zero);
+			weights = _mm_or_si128(_mm_andnot_si128(empty, weights), _mm_and_si128(empty, fullWeights));
+			//the weight of every pixel into the four 16 bit lanes of its channels
+			weights = _mm_or_si128(weights, _mm_slli_epi32(weights, 16));
+			const __m128i lowWeights = _mm_shuffle_epi32(weights, _MM_SHUFFLE(1, 1, 0, 0));
+			const __m128i highWeights = _mm_shuffle_epi32(weights, _MM_SHUFFLE(3, 3, 2, 2));
+			__m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), lowWeights), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(one, lowWeights)));
+			__m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), highWeights), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(one, highWeights)));
+			low = _mm_srli_epi16(_mm_add_epi16(low, half), 8);
+			high = _mm_srli_epi16(_mm_add_epi16(high, half), 8);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(low, high));
+		}
+	}
+#else
+	Q_UNUSED(vectorized)
+#endif
+	for(; x < count; x++){
+		const quint32 s = src[x];
+		const quint32 d = dst[x];
+		const int weight = (d >> 24) == 0 ? 256 : qMin(static_cast<int>(columnWeights[x]), rowWeight);
+		quint32 out = 0;
+		for(int shift = 0; shift < 32; shift += 8){
+			const int a = (s >> shift) & 0xff;
+			const int b = (d >> shift) & 0xff;
+			out |= static_cast<quint32>((a*weight + b*(256 - weight) + 128) >> 8) << shift;
+		}
+		dst[x] = out;
+	}
+}
+
+void MosaicCanvas::downsampleRow(const uchar* src, int srcStride, quint32* dst, int count, bool vectorized) {
+	int x = 0;
+#ifdef CAMERAEXTENSION_SSE2
+	if(vectorized){
+		//one block of 4x4 pixels per iteration, the sum of 16 channel values fits into a 16 bit lane
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rounding = _mm_set1_epi16(8);
+		for(; x < count; x++){
+			__m128i low = zero;
+			__m128i high = zero;
+			for(int row = 0; row < LEVEL_FACTOR; row++){
+				const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + row*srcStride + x*16));
+				low = _mm_add_epi16(low, _mm_unpacklo_epi8(pixels, zero));
+				high = _mm_add_epi16(high, _mm_unpackhi_epi8(pixels, zero));
+			}
+			__m128i sum = _mm_add_epi16(low, high);
+			sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+			sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 4);
+			dst[x] = static_cast<quint32>(_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+		}
+	}
+#else
+	Q_UNUSED(vectorized)
+#endif
+	for(; x < count; x++){
+		uchar* out = reinterpret_cast<uchar*>(dst + x);
+		for(int channel = 0; channel < 4; channel++){
+			int sum = 0;
+			for(int row = 0; row < LEVEL_FACTOR; row++){
+				const uchar* block = src + row*srcStride + x*16 + channel;
+				sum += block[0] + block[4] + block[8] + block[12];
+			}
+			out[channel] = static_cast<uchar>((sum + 8) >> 4);
+		}
+	}
+}
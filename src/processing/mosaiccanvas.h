@@ -0,0 +1,119 @@
+#ifndef MOSAICCANVAS_H
+#define MOSAICCANVAS_H
+
+#include <QMutex>
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QList>
+#include <QPair>
+#include <QTemporaryFile>
+#include <functional>
+#include "lumaimage.h"
+#include "workstealingpool.h"
+
+
+struct MosaicCanvasStatistics {
+	int tileCount = 0; //tiles of all levels, in memory or on disk
+	int residentTiles = 0;
+	qint64 residentBytes = 0;
+	qint64 spillFileBytes = 0;
+	QString spillError;
+};
+
+//unbounded canvas of the mosaic builder, made of TILE_SIZE x TILE_SIZE tiles (ARGB32 premultiplied, alpha 0 where nothing was blended yet).
+//tiles are created on first use and exist in LEVELS resolutions (level n is scaled down by LEVEL_FACTOR^n) so the display can show any zoom
+//level from a bounded number of tiles. at most maxResidentTiles tiles are kept in memory, the least recently used ones are written to a
+//temporary spill file (one fixed size slot per tile) and read back when they are needed again. memory use is therefore bounded by
+//maxResidentTiles, independent of the size of the mosaic (apart from the slot index of a few bytes per tile). evicted tiles are written after
+//the mutex is released, tiles() never touches the spill file but loads missing tiles on the WorkStealingPool, so painting does not wait for the disk.
+//all methods are thread safe; tile images handed out to the display are shallow copies, blend() detaches a tile before writing to it
+class MosaicCanvas
+{
+public:
+	explicit MosaicCanvas(int maxResidentTiles = 512);
+	~MosaicCanvas();
+
+	void clear();
+	//blends an opaque RGB32 frame with its top left corner at position (level 0 pixels) into the canvas and updates the coarser levels.
+	//within featherWidth pixels of the frame border the frame fades into the existing content, pixels that were empty are always taken
+	//from the frame. returns the updated rect
+	QRect blend(const QImage& frame, const QPoint& position, int featherWidth);
+	//luma of rect (level 0 pixels), every step-th pixel. empty pixels are set to the mean of the covered ones, coverage is the covered fraction 0..1
+	LumaImage sampleLuma(const QRect& rect, int step, double* coverage);
+	//tiles of level that intersect rect (level 0 pixels) with their rect in level 0 pixels. tiles that are only in the spill file are loaded in
+	//the background, until then the enlarged part of a coarser level in memory is returned in their place, or a null image if there is none
+	QList<QPair<QRect, QImage>> tiles(int level, const QRectF& rect);
+	//called from a pool thread whenever a tile requested by tiles() has been loaded, e.g. to schedule a repaint. must not call into the canvas
+	void setTileLoadedCallback(std::function<void()> callback);
+	//rect (level 0 pixels) that contains everything blended so far
+	QRect getBounds();
+	MosaicCanvasStatistics getStatistics();
+
+	//the kernels, public to be verified against the scalar path.
+	//blendRow: weight of pixel x is min(columnWeights[x], rowWeight) out of 256, empty dst pixels get weight 256
+	static void blendRow(const quint32* src, quint32* dst, const quint16* columnWeights, int rowWeight, int count, bool vectorized = true);
+	//downsampleRow: dst[x] is the average of the LEVEL_FACTOR x LEVEL_FACTOR block at src column LEVEL_FACTOR*x, rows src .. src + 3*srcStride
+	static void downsampleRow(const uchar* src, int srcStride, quint32* dst, int count, bool vectorized = true);
+
+	static const int TILE_SIZE = 256;
+	static const int LEVELS = 3;
+	static const int LEVEL_FACTOR = 4;
+
+private:
+	//resident tiles are linked in the order of their last use, newest first
+	struct Tile {
+		quint64 key = 0;
+		QImage image;
+		Tile* newer = nullptr;
+		Tile* older = nullptr;
+		int pins = 0;
+		bool dirty = false;
+		bool removed = false; //removed by clear() while pinned, deleted by the last releaseTile()
+	};
+
+	QMutex mutex;
+	int maxResidentTiles;
+	QHash<quint64, Tile*> residentTiles;
+	Tile* newestTile;
+	Tile* oldestTile;
+	QHash<quint64, qint64> spillSlots; //byte offset of the slot of every tile that was written to the spill file
+	QHash<quint64, QImage> evictedTiles; //evicted but not written yet, still taken from here instead of the spill file
+	QList<quint64> writeQueue;
+	bool writing;
+	QList<quint64> loadQueue; //tiles requested by tiles(), the newest request is loaded first
+	bool loaderRunning;
+	quint64 loadingKey;
+	bool loadingKeyChanged; //loadingKey was acquired or the canvas cleared while it was read, the read data is discarded
+	WorkStealingPool::TaskCounter loadTasks;
+	std::function<void()> tileLoadedCallback;
+	QMutex spillMutex; //serializes the file access, taken after mutex if both are needed
+	QTemporaryFile spillFile;
+	qint64 spillFileSize;
+	int generation; //incremented by clear() with both mutexes held, writes and reads of an older generation are dropped
+	QString spillError;
+	QRect bounds;
+
+	static quint64 tileKey(int level, int x, int y);
+	//returns the tile (taken from evictedTiles, read from the spill file or created), pinned. create == false returns nullptr for tiles that
+	//never existed
+	Tile* acquireTile(int level, int x, int y, bool create);
+	void releaseTile(Tile* tile);
+	void linkTile(Tile* tile);
+	void unlinkTile(Tile* tile);
+	//moves the least recently used unpinned tiles to evictedTiles until at most maxResidentTiles are resident
+	void evictTiles();
+	//writes evictedTiles to the spill file. called without the mutex, returns at once if another thread is already writing
+	void writeEvictedTiles();
+	//copy of the part of the nearest coarser level in memory that covers tile (x, y) of level, null if there is none
+	QImage coarserTile(int level, int x, int y);
+	void startLoader();
+	void loadTiles();
+	//file access with spillMutex, nothing is done if the canvas was cleared after generation
+	bool writeSlot(qint64 offset, int generation, const uchar* bits, QString* error);
+	bool readSlot(qint64 offset, int generation, uchar* bits, QString* error);
+	//updates level from the pixels of level - 1 inside sourceRect (pixels of level - 1), returns the updated rect in pixels of level
+	QRect updateLevel(int level, const QRect& sourceRect);
+};
+
+#endif //MOSAICCANVAS_H
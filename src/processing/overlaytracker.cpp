@@ -0,0 +1,206 @@
+#include "overlaytracker.h"
+#include "frameconversion.h"
+#include <QMutexLocker>
+#include <QtMath>
+
+//width of the level 0 analysis image
+#define TRACKER_ANALYSIS_WIDTH 640
+#define TRACKER_PYRAMID_LEVELS 3
+//template side length at level 0, halved on every level
+#define TRACKER_TEMPLATE_SIZE 48
+//search radius on the coarsest level. with 3 levels this covers +-32 px at level 0 per frame
+#define TRACKER_COARSE_RADIUS 8
+#define TRACKER_REFINE_RADIUS 2
+//matches below this correlation are considered lost and do not move the overlay
+#define TRACKER_MIN_SCORE 0.6
+
+
+OverlayTracker::OverlayTracker(QObject *parent)
+	: FrameAnalyzer(parent),
+	  targetsChanged(false)
+{
+	qRegisterMetaType<OverlayDisplacements>("OverlayDisplacements");
+}
+
+OverlayTracker::~OverlayTracker() {
+	this->stopWorker();
+}
+
+void OverlayTracker::setTargets(const QHash<QString, QPointF>& normalizedCenters) {
+	QMutexLocker locker(&this->mutex);
+	this->pendingTargets = normalizedCenters;
+	this->targetsChanged = true;
+}
+
+LumaImage OverlayTracker::downsample(const LumaImage& image) {
+	LumaImage result;
+	result.resize(image.width/2, image.height/2);
+	for(int y = 0; y < result.height; y++){
+		const quint8* row0 = image.constLine(2*y);
+		const quint8* row1 = image.constLine(2*y + 1);
+		quint8* out = result.line(y);
+		for(int x = 0; x < result.width; x++){
+			out[x] = static_cast<quint8>((row0[2*x] + row0[2*x + 1] + row1[2*x] + row1[2*x + 1] + 2) >> 2);
+		}
+	}
+	return result;
+}
+
+OverlayTracker::PatchTemplate OverlayTracker::extractTemplate(const LumaImage& image, const QPoint& center, int size) {
+	PatchTemplate patch;
+	int left = center.x() - size/2;
+	int top = center.y() - size/2;
+	if(left < 0 || top < 0 || left + size > image.width || top + size > image.height){
+		return patch;
+	}
+	patch.size = size;
+	patch.values.resize(size*size);
+	double mean = 0.0;
+	for(int y = 0; y < size; y++){
+		const quint8* row = image.constLine(top + y) + left;
+		for(int x = 0; x < size; x++){
+			patch.values[y*size + x] = row[x];
+			mean += row[x];
+		}
+	}
+	mean /= size*size;
+	double sumSq = 0.0;
+	for(float& value : patch.values){
+		value -= static_cast<float>(mean);
+		sumSq += value*value;
+	}
+	patch.norm = qSqrt(sumSq);
+	return patch;
+}
+
+double OverlayTracker::correlate(const LumaImage& image, const QPoint& center, const PatchTemplate& patch) {
+	const int size = patch.size;
+	int left = center.x() - size/2;
+	int top = center.y() - size/2;
+	if(size == 0 || patch.norm < 1e-6 || left < 0 || top < 0 || left + size > image.width || top + size > image.height){
+		return -1.0;
+	}
+	//as the template is mean free, the mean of the image window cancels out of the cross term
+	float cross = 0.0f;
+	quint32 sum = 0;
+	quint64 sumSq = 0;
+	for(int y = 0; y < size; y++){
+		const quint8* row = image.constLine(top + y) + left;
+		const float* t = patch.values.constData() + y*size;
+		float rowCross = 0.0f;
+		quint32 rowSumSq = 0;
+		for(int x = 0; x < size; x++){
+			rowCross += t[x]*row[x];
+			sum += row[x];
+			rowSumSq += row[x]*row[x];
+		}
+		cross += rowCross;
+		sumSq += rowSumSq;
+	}
+	double n = static_cast<double>(size)*size;
+	double variance = static_cast<double>(sumSq) - static_cast<double>(sum)*sum/n;
+	if(variance < 1e-6){
+		return -1.0;
+	}
+	return cross/(patch.norm*qSqrt(variance));
+}
+
+void OverlayTracker::updateTemplates(Target& target, const QVector<LumaImage>& pyramid) {
+	target.templates.clear();
+	for(int level = 0; level < pyramid.size(); level++){
+		double scale = 1.0/(1 << level);
+		QPoint center(qRound(target.position.x()*scale), qRound(target.position.y()*scale));
+		target.templates.append(extractTemplate(pyramid.at(level), center, TRACKER_TEMPLATE_SIZE >> level));
+	}
+}
+
+void OverlayTracker::analyzeFrame(const QVideoFrame& frame) {
+	int decimation = FrameConversion::decimationForWidth(frame.width(), TRACKER_ANALYSIS_WIDTH);
+	QVector<LumaImage> pyramid;
+	pyramid.append(FrameConversion::toLuma(frame, decimation));
+	if(pyramid.first().isNull()){
+		return;
+	}
+	for(int level = 1; level < TRACKER_PYRAMID_LEVELS; level++){
+		pyramid.append(downsample(pyramid.last()));
+	}
+	const LumaImage& base = pyramid.first();
+
+	//lock new targets on this frame
+	this->mutex.lock();
+	if(this->targetsChanged){
+		this->targets.clear();
+		for(auto it = this->pendingTargets.constBegin(); it != this->pendingTargets.constEnd(); ++it){
+			Target target;
+			target.position = QPointF(it.value().x()*base.width, it.value().y()*base.height);
+			this->updateTemplates(target, pyramid);
+			this->targets.insert(it.key(), target);
+		}
+		this->targetsChanged = false;
+		this->mutex.unlock();
+		return;
+	}
+	this->mutex.unlock();
+
+	OverlayDisplacements displacements;
+	for(auto it = this->targets.begin(); it != this->targets.end(); ++it){
+		Target& target = it.value();
+		if(target.templates.size() != pyramid.size() || target.templates.first().size == 0){
+			//target was too close to the border when locked, try again on this frame
+			this->updateTemplates(target, pyramid);
+			continue;
+		}
+
+		//coarse to fine search around the template center
+		int topLevel = pyramid.size() - 1;
+		double topScale = 1.0/(1 << topLevel);
+		QPoint templateCenter(qRound(target.position.x()*topScale), qRound(target.position.y()*topScale));
+		QPoint best = templateCenter;
+		double bestScore = -1.0;
+		for(int level = topLevel; level >= 0; level--){
+			int radius = level == topLevel ? TRACKER_COARSE_RADIUS : TRACKER_REFINE_RADIUS;
+			QPoint searchCenter = level == topLevel ? best : best*2;
+			bestScore = -1.0;
+			for(int dy = -radius; dy <= radius; dy++){
+				for(int dx = -radius; dx <= radius; dx++){
+					QPoint candidate = searchCenter + QPoint(dx, dy);
+					double score = correlate(pyramid.at(level), candidate, target.templates.at(level));
+					if(score > bestScore){
+						bestScore = score;
+						best = candidate;
+					}
+				}
+			}
+		}
+		if(bestScore < TRACKER_MIN_SCORE){
+			continue;
+		}
+
+		//sub-pixel refinement on level 0
+		auto parabolicOffset = [](double left, double center, double right) {
+			double denominator = left - 2.0*center + right;
+			return qAbs(denominator) < 1e-9 ? 0.0 : qBound(-0.5, 0.5*(left - right)/denominator, 0.5);
+		};
+		const PatchTemplate& patch = target.templates.first();
+		double subX = parabolicOffset(correlate(base, best - QPoint(1, 0), patch), bestScore, correlate(base, best + QPoint(1, 0), patch));
+		double subY = parabolicOffset(correlate(base, best - QPoint(0, 1), patch), bestScore, correlate(base, best + QPoint(0, 1), patch));
+
+		//the template was taken at the rounded position, so the displacement is measured relative to that
+		QPointF levelZeroTemplateCenter(qRound(target.position.x()), qRound(target.position.y()));
+		QPointF delta = QPointF(best.x() + subX, best.y() + subY) - levelZeroTemplateCenter;
+		target.position += delta;
+		this->updateTemplates(target, pyramid);
+
+		if(!qFuzzyIsNull(delta.x()) || !qFuzzyIsNull(delta.y())){
+			OverlayDisplacement displacement;
+			displacement.name = it.key();
+			displacement.delta = QPointF(delta.x()*decimation/frame.width(), delta.y()*decimation/frame.height());
+			displacement.score = bestScore;
+			displacements.append(displacement);
+		}
+	}
+
+	if(!displacements.isEmpty()){
+		emit overlaysMoved(displacements);
+	}
+}
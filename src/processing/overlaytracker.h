@@ -0,0 +1,62 @@
+#ifndef OVERLAYTRACKER_H
+#define OVERLAYTRACKER_H
+
+#include <QMutex>
+#include <QHash>
+#include <QPointF>
+#include <QVector>
+#include <QMetaType>
+#include "frameanalyzer.h"
+#include "lumaimage.h"
+
+
+struct OverlayDisplacement {
+	QString name;
+	QPointF delta; //frame-to-frame displacement in normalized frame coordinates
+	double score = 0.0; //normalized cross correlation of the best match
+};
+typedef QVector<OverlayDisplacement> OverlayDisplacements;
+Q_DECLARE_METATYPE(OverlayDisplacements)
+
+
+//tracks a feature patch at the center of each target overlay from frame to frame with coarse-to-fine normalized cross correlation template matching on an image pyramid.
+//the final position is refined to sub-pixel accuracy by a parabolic fit of the correlation surface
+class OverlayTracker : public FrameAnalyzer
+{
+	Q_OBJECT
+public:
+	explicit OverlayTracker(QObject *parent = nullptr);
+	~OverlayTracker();
+
+	//(re)locks all targets at the given centers in normalized frame coordinates. templates are taken from the next analyzed frame
+	void setTargets(const QHash<QString, QPointF>& normalizedCenters);
+
+protected:
+	void analyzeFrame(const QVideoFrame& frame) override;
+
+private:
+	struct PatchTemplate {
+		int size = 0;
+		QVector<float> values; //mean free
+		double norm = 0.0; //sqrt of sum of squared values
+	};
+	struct Target {
+		QPointF position; //level 0 pixel coordinates
+		QVector<PatchTemplate> templates; //one per pyramid level
+	};
+
+	QMutex mutex;
+	QHash<QString, QPointF> pendingTargets;
+	bool targetsChanged;
+	QHash<QString, Target> targets;
+
+	static LumaImage downsample(const LumaImage& image);
+	static PatchTemplate extractTemplate(const LumaImage& image, const QPoint& center, int size);
+	static double correlate(const LumaImage& image, const QPoint& center, const PatchTemplate& patch);
+	void updateTemplates(Target& target, const QVector<LumaImage>& pyramid);
+
+signals:
+	void overlaysMoved(OverlayDisplacements displacements);
+};
+
+#endif //OVERLAYTRACKER_H
@@ -0,0 +1,219 @@
+#include "phasecorrelator.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+	const double PI = 3.14159265358979323846;
+
+	inline float sampleBilinear(const std::vector<float>& data, int size, double x, double y) {
+		if(x < 0.0 || y < 0.0 || x > size - 1 || y > size - 1){
+			return 0.0f;
+		}
+		int x0 = std::min(static_cast<int>(x), size - 2);
+		int y0 = std::min(static_cast<int>(y), size - 2);
+		float fx = static_cast<float>(x - x0);
+		float fy = static_cast<float>(y - y0);
+		const float* row0 = &data[y0*size + x0];
+		const float* row1 = row0 + size;
+		float top = row0[0] + fx*(row0[1] - row0[0]);
+		float bottom = row1[0] + fx*(row1[1] - row1[0]);
+		return top + fy*(bottom - top);
+	}
+
+	//vertex of the parabola through (-1, left), (0, center), (1, right)
+	inline double parabolicOffset(double left, double center, double right) {
+		double denominator = left - 2.0*center + right;
+		if(std::abs(denominator) < 1e-12){
+			return 0.0;
+		}
+		return std::max(-0.5, std::min(0.5, 0.5*(left - right)/denominator));
+	}
+}
+
+
+PhaseCorrelator::PhaseCorrelator(int size) :
+	size(0)
+{
+	this->setSize(size);
+}
+
+void PhaseCorrelator::setSize(int size) {
+	if(size == this->size || !Fft2D::isPowerOfTwo(size)){
+		return;
+	}
+	this->size = size;
+	this->fft.setSize(size);
+	this->updateTables();
+}
+
+void PhaseCorrelator::updateTables() {
+	const int n = this->size;
+	this->window.resize(n*n);
+	this->highPass.resize(n*n);
+	this->buffer.resize(n*n);
+	std::vector<double> hann(n);
+	for(int i = 0; i < n; i++){
+		hann[i] = 0.5 - 0.5*std::cos(2.0*PI*i/n);
+	}
+	for(int y = 0; y < n; y++){
+		//frequency coordinates of the fft-shifted spectrum in [-0.5, 0.5)
+		double fy = static_cast<double>(y - n/2)/n;
+		for(int x = 0; x < n; x++){
+			double fx = static_cast<double>(x - n/2)/n;
+			this->window[y*n + x] = static_cast<float>(hann[x]*hann[y]);
+			//emphasizes high frequencies, removes the dominant dc/low frequency content that carries no rotation information
+			double h = std::cos(PI*fx)*std::cos(PI*fy);
+			this->highPass[y*n + x] = static_cast<float>((1.0 - h)*(2.0 - h));
+		}
+	}
+}
+
+std::vector<float> PhaseCorrelator::toPatch(const LumaImage& image, int size) {
+	std::vector<float> patch(size*size, 0.0f);
+	if(image.isNull() || size <= 0){
+		return patch;
+	}
+	double scaleX = static_cast<double>(image.width)/size;
+	double scaleY = static_cast<double>(image.height)/size;
+	for(int y = 0; y < size; y++){
+		double sy = std::max(0.0, std::min((y + 0.5)*scaleY - 0.5, image.height - 1.0));
+		int y0 = std::min(static_cast<int>(sy), image.height - 1);
+		int y1 = std::min(y0 + 1, image.height - 1);
+		float fy = static_cast<float>(sy - y0);
+		const quint8* row0 = image.constLine(y0);
+		const quint8* row1 = image.constLine(y1);
+		for(int x = 0; x < size; x++){
+			double sx = std::max(0.0, std::min((x + 0.5)*scaleX - 0.5, image.width - 1.0));
+			int x0 = std::min(static_cast<int>(sx), image.width - 1);
+			int x1 = std::min(x0 + 1, image.width - 1);
+			float fx = static_cast<float>(sx - x0);
+			float top = row0[x0] + fx*(row0[x1] - row0[x0]);
+			float bottom = row1[x0] + fx*(row1[x1] - row1[x0]);
+			patch[y*size + x] = top + fy*(bottom - top);
+		}
+	}
+	return patch;
+}
+
+std::vector<float> PhaseCorrelator::rotatePatch(const std::vector<float>& patch, int size, double angleDegrees) {
+	std::vector<float> rotated(patch.size(), 0.0f);
+	double angle = angleDegrees*PI/180.0;
+	double c = std::cos(angle);
+	double s = std::sin(angle);
+	double center = (size - 1)/2.0;
+	for(int y = 0; y < size; y++){
+		for(int x = 0; x < size; x++){
+			//inverse mapping: source position of destination pixel
+			double dx = x - center;
+			double dy = y - center;
+			double sx = center + c*dx + s*dy;
+			double sy = center - s*dx + c*dy;
+			rotated[y*size + x] = sampleBilinear(patch, size, sx, sy);
+		}
+	}
+	return rotated;
+}
+
+std::vector<PhaseCorrelator::Complex> PhaseCorrelator::spectrum(const std::vector<float>& patch) {
+	const int n = this->size;
+	std::vector<Complex> result(n*n);
+	if(static_cast<int>(patch.size()) != n*n){
+		return result;
+	}
+	double mean = 0.0;
+	for(float value : patch){
+		mean += value;
+	}
+	mean /= patch.size();
+	for(int i = 0; i < n*n; i++){
+		result[i] = Complex(static_cast<float>((patch[i] - mean)*this->window[i]), 0.0f);
+	}
+	this->fft.forward(result);
+	return result;
+}
+
+PhaseCorrelationResult PhaseCorrelator::correlate(const std::vector<Complex>& currentSpectrum, const std::vector<Complex>& referenceSpectrum) {
+	const int n = this->size;
+	if(static_cast<int>(currentSpectrum.size()) != n*n || currentSpectrum.size() != referenceSpectrum.size()){
+		return PhaseCorrelationResult();
+	}
+	//normalized cross power spectrum
+	for(int i = 0; i < n*n; i++){
+		Complex crossPower = currentSpectrum[i]*std::conj(referenceSpectrum[i]);
+		float magnitude = std::abs(crossPower);
+		this->buffer[i] = magnitude > 1e-12f ? crossPower/magnitude : Complex(0.0f, 0.0f);
+	}
+	this->fft.inverse(this->buffer);
+	return this->findPeak(this->buffer);
+}
+
+PhaseCorrelationResult PhaseCorrelator::findPeak(const std::vector<Complex>& correlation) const {
+	const int n = this->size;
+	int peakIndex = 0;
+	float peakValue = correlation[0].real();
+	for(int i = 1; i < n*n; i++){
+		if(correlation[i].real() > peakValue){
+			peakValue = correlation[i].real();
+			peakIndex = i;
+		}
+	}
+	int px = peakIndex % n;
+	int py = peakIndex / n;
+	auto value = [&correlation, n](int x, int y) {
+		return static_cast<double>(correlation[((y + n) % n)*n + ((x + n) % n)].real());
+	};
+
+	PhaseCorrelationResult result;
+	result.peak = peakValue;
+	result.dx = px + parabolicOffset(value(px - 1, py), peakValue, value(px + 1, py));
+	result.dy = py + parabolicOffset(value(px, py - 1), peakValue, value(px, py + 1));
+	//correlation is circular, peaks in the upper half correspond to negative shifts
+	if(result.dx >= n/2.0){
+		result.dx -= n;
+	}
+	if(result.dy >= n/2.0){
+		result.dy -= n;
+	}
+	return result;
+}
+
+std::vector<PhaseCorrelator::Complex> PhaseCorrelator::rotationSpectrum(const std::vector<float>& patch) {
+	const int n = this->size;
+	std::vector<Complex> transformed = this->spectrum(patch);
+
+	//high-pass filtered magnitude in fft-shifted layout (dc in the center)
+	std::vector<float> magnitude(n*n);
+	for(int y = 0; y < n; y++){
+		int sy = (y + n/2) % n;
+		for(int x = 0; x < n; x++){
+			int sx = (x + n/2) % n;
+			magnitude[y*n + x] = std::abs(transformed[sy*n + sx])*this->highPass[y*n + x];
+		}
+	}
+
+	//log-polar resampling. rows: angle in [0, pi) as the magnitude spectrum of a real signal is point symmetric, columns: log radius in [1, n/2)
+	std::vector<float> logPolar(n*n);
+	double center = n/2.0;
+	double logBase = std::log(n/2.0)/n;
+	for(int a = 0; a < n; a++){
+		double theta = PI*a/n;
+		double c = std::cos(theta);
+		double s = std::sin(theta);
+		for(int r = 0; r < n; r++){
+			double rho = std::exp(r*logBase);
+			logPolar[a*n + r] = sampleBilinear(magnitude, n, center + rho*c, center + rho*s);
+		}
+	}
+
+	//no window along the periodic angle axis would be ideal, but windowing both axes is robust enough for small rotations
+	return this->spectrum(logPolar);
+}
+
+double PhaseCorrelator::estimateRotation(const std::vector<Complex>& currentRotationSpectrum, const std::vector<Complex>& referenceRotationSpectrum, double* peak) {
+	PhaseCorrelationResult result = this->correlate(currentRotationSpectrum, referenceRotationSpectrum);
+	if(peak != nullptr){
+		*peak = result.peak;
+	}
+	//one row of the log-polar image corresponds to 180/n degrees
+	return result.dy*180.0/this->size;
+}
@@ -0,0 +1,55 @@
+#ifndef PHASECORRELATOR_H
+#define PHASECORRELATOR_H
+
+#include <vector>
+#include "fft.h"
+#include "lumaimage.h"
+
+
+struct PhaseCorrelationResult {
+	double dx = 0.0;
+	double dy = 0.0;
+	double peak = 0.0; //height of the normalized correlation peak, 0..1. see PhaseCorrelator::getMinReliablePeak()
+};
+
+//estimates the translation (and optionally the rotation) between square power of two patches by fft-based phase correlation.
+//patches are mean-free hann-windowed before the transform to suppress the edge discontinuities of the implicit periodic continuation
+class PhaseCorrelator
+{
+public:
+	typedef Fft2D::Complex Complex;
+
+	explicit PhaseCorrelator(int size = 128);
+
+	int getSize() const {return this->size;}
+	//lowest correlation peak of a reliable match, 0.2 for 128 px patches. the peaks of unrelated patches fall with the patch size (up to 0.11
+	//at 128 px, 0.04 at 256 px), the threshold scales with it so that matching noisy frames of larger patches still pass (tools/phasecorrelation)
+	double getMinReliablePeak() const {return 0.2*128.0/this->size;}
+	void setSize(int size);
+
+	//bilinear resampling of the whole image to a size*size patch
+	static std::vector<float> toPatch(const LumaImage& image, int size);
+	//rotates a patch around its center, angle in degrees. positive angles rotate clockwise on screen (image y axis pointing down)
+	static std::vector<float> rotatePatch(const std::vector<float>& patch, int size, double angleDegrees);
+
+	std::vector<Complex> spectrum(const std::vector<float>& patch);
+	//displacement of the current patch relative to the reference patch in patch pixels, with sub-pixel refinement
+	PhaseCorrelationResult correlate(const std::vector<Complex>& currentSpectrum, const std::vector<Complex>& referenceSpectrum);
+
+	//log-polar resampled magnitude spectrum. rotation between two patches shows up as a shift along the angle axis (rows) of this image
+	std::vector<Complex> rotationSpectrum(const std::vector<float>& patch);
+	//rotation of the current patch relative to the reference patch in degrees within [-90, 90), i.e. rotatePatch(reference, angle) matches current
+	double estimateRotation(const std::vector<Complex>& currentRotationSpectrum, const std::vector<Complex>& referenceRotationSpectrum, double* peak = nullptr);
+
+private:
+	int size;
+	Fft2D fft;
+	std::vector<float> window;
+	std::vector<float> highPass;
+	std::vector<Complex> buffer;
+
+	void updateTables();
+	PhaseCorrelationResult findPeak(const std::vector<Complex>& correlation) const;
+};
+
+#endif //PHASECORRELATOR_H
@@ -0,0 +1,139 @@
+#include "polarunwrap.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QtMath>
+#include <cmath>
+
+
+PolarUnwrapper::PolarUnwrapper(QObject *parent)
+	: FrameAnalyzer(parent),
+	  band(50)
+{
+	qRegisterMetaType<PolarStrip>("PolarStrip");
+}
+
+PolarUnwrapper::~PolarUnwrapper() {
+	this->stopWorker();
+}
+
+void PolarUnwrapper::setCircle(const QPointF& normalizedCenter, const QPointF& normalizedPeripheral) {
+	QMutexLocker locker(&this->mutex);
+	this->normalizedCenter = normalizedCenter;
+	this->normalizedPeripheral = normalizedPeripheral;
+}
+
+void PolarUnwrapper::setBand(int percent) {
+	QMutexLocker locker(&this->mutex);
+	this->band = qBound(1, percent, 100);
+}
+
+int PolarUnwrapper::getBand() {
+	QMutexLocker locker(&this->mutex);
+	return this->band;
+}
+
+void PolarUnwrapper::setLensModel(const LensModel& model) {
+	QMutexLocker locker(&this->mutex);
+	this->lensModel = model;
+}
+
+void PolarUnwrapper::analyzeFrame(const QVideoFrame& frame) {
+	this->mutex.lock();
+	QPointF center = this->normalizedCenter;
+	QPointF peripheral = this->normalizedPeripheral;
+	int band = this->band;
+	LensModel lensModel = this->lensModel;
+	this->mutex.unlock();
+	if(center == peripheral){
+		return;
+	}
+
+	this->updateTable(center, peripheral, band, lensModel, frame.size());
+	SampleTable& table = this->table;
+	QVideoFrame mappedFrame;
+	LumaImage luma;
+	const uchar* base = table.remap.attach(frame, &mappedFrame, &luma);
+	if(base == nullptr){
+		return;
+	}
+	const int width = table.stripSize.width();
+	const int height = table.stripSize.height();
+	QImage image(table.stripSize, QImage::Format_Grayscale8);
+	uchar* bits = image.bits();
+	const int stride = image.bytesPerLine();
+	const RemapTable& remap = table.remap;
+	const int tiles = (width + TILE_WIDTH - 1)/TILE_WIDTH;
+	WorkStealingPool::globalInstance()->parallelFor(tiles, [&](int tile) {
+		//all tiles before this one are full
+		const int x0 = tile*TILE_WIDTH;
+		const int tileWidth = qMin(TILE_WIDTH, width - x0);
+		const int tileStart = x0*height;
+		for(int y = 0; y < height; y++){
+			const int index = tileStart + y*tileWidth;
+			RemapTable::remap(base, remap.offsetsAt(index), remap.weightsAt(index), tileWidth, remap.getPixelStep(), remap.getRowStep(),
+				bits + y*stride + x0);
+		}
+	});
+	if(mappedFrame.isMapped()){
+		mappedFrame.unmap();
+	}
+
+	PolarStrip strip;
+	strip.valid = true;
+	strip.image = image;
+	strip.radius = table.radius;
+	strip.innerRadius = table.innerRadius;
+	strip.outerRadius = table.outerRadius;
+	strip.timestamp = QDateTime::currentMSecsSinceEpoch();
+	emit polarStripMeasured(strip);
+}
+
+void PolarUnwrapper::updateTable(const QPointF& normalizedCenter, const QPointF& normalizedPeripheral, int band, const LensModel& lensModel, const QSize& frameSize) {
+	SampleTable& table = this->table;
+	if(table.normalizedCenter == normalizedCenter && table.normalizedPeripheral == normalizedPeripheral && table.band == band
+			&& table.lensModel == lensModel && table.frameSize == frameSize){
+		return;
+	}
+	table.normalizedCenter = normalizedCenter;
+	table.normalizedPeripheral = normalizedPeripheral;
+	table.band = band;
+	table.lensModel = lensModel;
+	table.frameSize = frameSize;
+
+	//positions in pixel center coordinates
+	const QPointF center(normalizedCenter.x()*frameSize.width() - 0.5, normalizedCenter.y()*frameSize.height() - 0.5);
+	const QPointF peripheral(normalizedPeripheral.x()*frameSize.width() - 0.5, normalizedPeripheral.y()*frameSize.height() - 0.5);
+	table.radius = std::hypot(peripheral.x() - center.x(), peripheral.y() - center.y());
+	table.innerRadius = table.radius*(100 - band)/100.0;
+	table.outerRadius = table.radius*(100 + band)/100.0;
+
+	//about one column per pixel of circumference and one row per pixel of radius
+	const int width = qBound(TILE_WIDTH/8, qCeil(2.0*M_PI*table.radius), MAX_STRIP_WIDTH);
+	const int height = qBound(2, qRound(table.outerRadius - table.innerRadius) + 1, MAX_STRIP_PIXELS/width);
+	table.stripSize = QSize(width, height);
+
+	QVector<double> cosines(width);
+	QVector<double> sines(width);
+	for(int x = 0; x < width; x++){
+		const double angle = 2.0*M_PI*(x + 0.5)/width;
+		cosines[x] = std::cos(angle);
+		sines[x] = std::sin(angle);
+	}
+	QVector<QPointF> positions;
+	positions.reserve(width*height);
+	const double radiusStep = (table.outerRadius - table.innerRadius)/(height - 1);
+	const bool distorted = lensModel.isApplicableTo(frameSize);
+	const LensModel scaledModel = distorted ? lensModel.scaledTo(frameSize) : LensModel();
+	for(int x0 = 0; x0 < width; x0 += TILE_WIDTH){
+		const int x1 = qMin(width, x0 + TILE_WIDTH);
+		for(int y = 0; y < height; y++){
+			const double radius = table.innerRadius + y*radiusStep;
+			for(int x = x0; x < x1; x++){
+				//the circle is round in the undistorted frame, its pixels are read at their source positions in the camera frame
+				const QPointF position = center + QPointF(radius*cosines.at(x), radius*sines.at(x));
+				positions.append(distorted ? scaledModel.distort(position) : position);
+			}
+		}
+	}
+	table.remap.build(positions, frameSize, RemapTable::ZERO);
+}
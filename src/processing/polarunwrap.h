@@ -0,0 +1,82 @@
+#ifndef POLARUNWRAP_H
+#define POLARUNWRAP_H
+
+#include <QMutex>
+#include <QPointF>
+#include <QImage>
+#include <QMetaType>
+#include "frameanalyzer.h"
+#include "remaptable.h"
+#include "lenscalibration.h"
+
+
+//luma around a circle unwrapped into a rectangular strip: the columns are the angle (0 at 3 o'clock, clockwise, like the image y axis),
+//the rows the distance from the center, innerRadius in the top row and outerRadius in the bottom row
+struct PolarStrip {
+	bool valid = false;
+	QImage image; //Format_Grayscale8
+	double radius = 0.0; //radius of the circle in frame pixels
+	double innerRadius = 0.0;
+	double outerRadius = 0.0;
+	qint64 timestamp = 0; //ms since epoch
+};
+Q_DECLARE_METATYPE(PolarStrip)
+
+
+//unwraps a band around a circle (e.g. the circle overlay) with bilinear interpolation. the sample positions are turned into a RemapTable
+//only when the circle, the band or the frame size changes, so a frame costs one gather of four taps per strip pixel.
+//the table is ordered in tiles of TILE_WIDTH angles (all radii of a tile are consecutive), the taps of a tile lie in a narrow wedge of the frame
+//that stays in cache while the tile is gathered. the tiles are distributed over the WorkStealingPool
+class PolarUnwrapper : public FrameAnalyzer
+{
+	Q_OBJECT
+public:
+	explicit PolarUnwrapper(QObject *parent = nullptr);
+	~PolarUnwrapper();
+
+	//center and a point on the circle in normalized frame coordinates (0..1). center == peripheral disables the unwrapping
+	void setCircle(const QPointF& normalizedCenter, const QPointF& normalizedPeripheral);
+	//the strip covers radius*(1 - band) .. radius*(1 + band), band in percent of the radius (1..100)
+	void setBand(int percent);
+	int getBand();
+	//lens distortion that is removed from the displayed frames. the circle is then given in the undistorted frame and every strip pixel
+	//is sampled at its source position in the camera frame. an invalid model, or one that does not fit the frame, samples the frame as it is
+	void setLensModel(const LensModel& model);
+
+	static const int TILE_WIDTH = 64;
+	static const int MAX_STRIP_WIDTH = 4096;
+	static const int MAX_STRIP_PIXELS = 1 << 20;
+
+protected:
+	void analyzeFrame(const QVideoFrame& frame) override;
+
+private:
+	struct SampleTable {
+		QPointF normalizedCenter;
+		QPointF normalizedPeripheral;
+		int band = 0;
+		LensModel lensModel;
+		QSize frameSize;
+		QSize stripSize;
+		double radius = 0.0;
+		double innerRadius = 0.0;
+		double outerRadius = 0.0;
+		RemapTable remap; //tile by tile, row by row within a tile
+	};
+
+	QMutex mutex;
+	QPointF normalizedCenter;
+	QPointF normalizedPeripheral;
+	int band;
+	LensModel lensModel;
+
+	//only used by analyzeFrame()
+	SampleTable table;
+
+	void updateTable(const QPointF& normalizedCenter, const QPointF& normalizedPeripheral, int band, const LensModel& lensModel, const QSize& frameSize);
+
+signals:
+	void polarStripMeasured(PolarStrip strip);
+};
+
+#endif //POLARUNWRAP_H
@@ -0,0 +1,441 @@
+#include "referencecomparison.h"
+#include "workstealingpool.h"
+#include "simd.h"
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <cstring>
+
+
+namespace {
+	//BT.601 with limited range, as used by Qt for the display of yuv frames
+	inline quint8 rgbToY(int r, int g, int b) {
+		return static_cast<quint8>(16 + ((66*r + 129*g + 25*b + 128) >> 8));
+	}
+
+	inline quint8 rgbToU(int r, int g, int b) {
+		return static_cast<quint8>(128 + ((-38*r - 74*g + 112*b + 128) >> 8));
+	}
+
+	inline quint8 rgbToV(int r, int g, int b) {
+		return static_cast<quint8>(128 + ((112*r - 94*g - 18*b + 128) >> 8));
+	}
+
+	//average colour of the pixels (x, y) .. (x + 1, y + rows - 1), clamped at the right and bottom border
+	inline void averageRgb(const QImage& image, int x, int y, int rows, int* r, int* g, int* b) {
+		const int x1 = qMin(x + 1, image.width() - 1);
+		int sumR = 0;
+		int sumG = 0;
+		int sumB = 0;
+		for(int i = 0; i < rows; i++){
+			const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(qMin(y + i, image.height() - 1)));
+			sumR += qRed(line[x]) + qRed(line[x1]);
+			sumG += qGreen(line[x]) + qGreen(line[x1]);
+			sumB += qBlue(line[x]) + qBlue(line[x1]);
+		}
+		const int count = 2*rows;
+		*r = (sumR + count/2)/count;
+		*g = (sumG + count/2)/count;
+		*b = (sumB + count/2)/count;
+	}
+}
+
+
+bool ReferenceComparisonSettings::operator==(const ReferenceComparisonSettings& other) const {
+	return this->mode == other.mode && qFuzzyCompare(this->opacity + 1.0, other.opacity + 1.0) && this->gain == other.gain;
+}
+
+
+ReferenceComparison::ReferenceComparison()
+	: referenceGeneration(0),
+	  active(0),
+	  lastProcessingTimeUs(0)
+{
+}
+
+void ReferenceComparison::setSettings(const ReferenceComparisonSettings& settings) {
+	QMutexLocker locker(&this->mutex);
+	this->settings = settings;
+	this->updateActive();
+}
+
+ReferenceComparisonSettings ReferenceComparison::getSettings() const {
+	QMutexLocker locker(&this->mutex);
+	return this->settings;
+}
+
+void ReferenceComparison::setReference(const QImage& image) {
+	QMutexLocker locker(&this->mutex);
+	this->reference = image;
+	this->referenceGeneration++;
+	this->updateActive();
+}
+
+QImage ReferenceComparison::getReference() const {
+	QMutexLocker locker(&this->mutex);
+	return this->reference;
+}
+
+bool ReferenceComparison::hasReference() const {
+	QMutexLocker locker(&this->mutex);
+	return !this->reference.isNull();
+}
+
+void ReferenceComparison::updateActive() {
+	this->active.storeRelease(this->settings.mode != OFF && !this->reference.isNull() ? 1 : 0);
+}
+
+bool ReferenceComparison::isSupportedFormat(QVideoFrame::PixelFormat format) {
+	switch(format){
+		case QVideoFrame::Format_RGB32:
+		case QVideoFrame::Format_ARGB32:
+		case QVideoFrame::Format_ARGB32_Premultiplied:
+		case QVideoFrame::Format_BGR32:
+		case QVideoFrame::Format_BGRA32:
+		case QVideoFrame::Format_BGRA32_Premultiplied:
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY:
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21:
+		case QVideoFrame::Format_Y8:
+			return true;
+		default:
+			return false;
+	}
+}
+
+QVideoFrame ReferenceComparison::process(const QVideoFrame& frame) {
+	QElapsedTimer timer;
+	timer.start();
+	ReferenceComparisonSettings settings;
+	QImage image;
+	int generation = 0;
+	{
+		QMutexLocker locker(&this->mutex);
+		settings = this->settings;
+		image = this->reference;
+		generation = this->referenceGeneration;
+	}
+	const QVideoFrame::PixelFormat format = frame.pixelFormat();
+	if(settings.mode == OFF || image.isNull() || !isSupportedFormat(format)){
+		return QVideoFrame();
+	}
+
+	//the output frame gets the layout of the live frame, so live, reference and output rows line up byte by byte
+	QVideoFrame liveFrame(frame);
+	if(!liveFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		return QVideoFrame();
+	}
+	QVideoFrame output(liveFrame.mappedBytes(), liveFrame.size(), liveFrame.bytesPerLine(), format);
+	const int planeCount = liveFrame.planeCount();
+	if(!output.map(QAbstractVideoBuffer::WriteOnly) || output.planeCount() != planeCount || planeCount > MAX_PLANES
+			|| !this->prepare(image, generation, output)){
+		if(output.isMapped()){
+			output.unmap();
+		}
+		liveFrame.unmap();
+		return QVideoFrame();
+	}
+
+	const int height = liveFrame.height();
+	for(int plane = 0; plane < planeCount; plane++){
+		const Pass pass = makePass(settings, format, plane);
+		const int rows = planeRows(format, plane, height);
+		const uchar* liveBits = liveFrame.bits(plane);
+		const int liveStride = liveFrame.bytesPerLine(plane);
+		uchar* outputBits = output.bits(plane);
+		const int outputStride = output.bytesPerLine(plane);
+		const uchar* referenceBits = reinterpret_cast<const uchar*>(this->prepared.data.constData()) + this->prepared.planeOffsets[plane];
+		const int rowBytes = qMin(liveStride, outputStride);
+		//rows of a plane that ends before the mapped buffer would be read past the end
+		if(liveBits + (rows - 1)*liveStride + rowBytes > liveFrame.bits() + liveFrame.mappedBytes()){
+			output.unmap();
+			liveFrame.unmap();
+			return QVideoFrame();
+		}
+		const int bands = (rows + BAND_HEIGHT - 1)/BAND_HEIGHT;
+		WorkStealingPool::globalInstance()->parallelFor(bands, [&](int band) {
+			const int y1 = qMin(rows, (band + 1)*BAND_HEIGHT);
+			for(int y = band*BAND_HEIGHT; y < y1; y++){
+				compare(liveBits + y*liveStride, referenceBits + y*outputStride, outputBits + y*outputStride, rowBytes, pass);
+			}
+		});
+	}
+	output.unmap();
+	liveFrame.unmap();
+	output.setStartTime(frame.startTime());
+	this->lastProcessingTimeUs.storeRelease(static_cast<int>(timer.nsecsElapsed()/1000));
+	return output;
+}
+
+bool ReferenceComparison::prepare(const QImage& image, int generation, QVideoFrame& mappedOutput) {
+	PreparedReference& prepared = this->prepared;
+	if(prepared.generation == generation && prepared.format == mappedOutput.pixelFormat() && prepared.size == mappedOutput.size()
+			&& prepared.bytesPerLine == mappedOutput.bytesPerLine()){
+		return true;
+	}
+
+	//the reference is encoded into the output frame, which is overwritten by the comparison afterwards
+	prepared = PreparedReference();
+	QImage scaled = image.size() == mappedOutput.size() ? image : image.scaled(mappedOutput.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	if(!encode(scaled.convertToFormat(QImage::Format_RGB32), mappedOutput)){
+		return false;
+	}
+	for(int plane = 0; plane < mappedOutput.planeCount(); plane++){
+		prepared.planeOffsets[plane] = static_cast<int>(mappedOutput.bits(plane) - mappedOutput.bits());
+		if(prepared.planeOffsets[plane] < 0 || prepared.planeOffsets[plane] >= mappedOutput.mappedBytes()){
+			return false;
+		}
+	}
+	prepared.data = QByteArray(reinterpret_cast<const char*>(mappedOutput.bits()), mappedOutput.mappedBytes());
+	prepared.planeCount = mappedOutput.planeCount();
+	prepared.format = mappedOutput.pixelFormat();
+	prepared.size = mappedOutput.size();
+	prepared.bytesPerLine = mappedOutput.bytesPerLine();
+	prepared.generation = generation;
+	return true;
+}
+
+bool ReferenceComparison::encode(const QImage& image, QVideoFrame& mappedOutput) {
+	const int width = mappedOutput.width();
+	const int height = mappedOutput.height();
+	if(image.width() != width || image.height() != height || image.format() != QImage::Format_RGB32){
+		return false;
+	}
+	const QVideoFrame::PixelFormat format = mappedOutput.pixelFormat();
+	switch(format){
+		case QVideoFrame::Format_RGB32:
+		case QVideoFrame::Format_ARGB32:
+		case QVideoFrame::Format_ARGB32_Premultiplied:
+			for(int y = 0; y < height; y++){
+				memcpy(mappedOutput.bits() + y*mappedOutput.bytesPerLine(), image.constScanLine(y), width*4);
+			}
+			return true;
+		case QVideoFrame::Format_BGR32:
+		case QVideoFrame::Format_BGRA32:
+		case QVideoFrame::Format_BGRA32_Premultiplied:
+			//same pixels with the byte order reversed
+			for(int y = 0; y < height; y++){
+				const quint32* in = reinterpret_cast<const quint32*>(image.constScanLine(y));
+				quint32* out = reinterpret_cast<quint32*>(mappedOutput.bits() + y*mappedOutput.bytesPerLine());
+				for(int x = 0; x < width; x++){
+					out[x] = qbswap(in[x]);
+				}
+			}
+			return true;
+		case QVideoFrame::Format_Y8:
+			for(int y = 0; y < height; y++){
+				const QRgb* in = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+				uchar* out = mappedOutput.bits() + y*mappedOutput.bytesPerLine();
+				for(int x = 0; x < width; x++){
+					out[x] = static_cast<uchar>((77*qRed(in[x]) + 150*qGreen(in[x]) + 29*qBlue(in[x]) + 128) >> 8);
+				}
+			}
+			return true;
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY: {
+			const int lumaOffset = format == QVideoFrame::Format_YUYV ? 0 : 1;
+			const int chromaOffset = 1 - lumaOffset;
+			for(int y = 0; y < height; y++){
+				const QRgb* in = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+				uchar* out = mappedOutput.bits() + y*mappedOutput.bytesPerLine();
+				for(int x = 0; x < width; x += 2){
+					const int x1 = qMin(x + 1, width - 1);
+					int r = 0;
+					int g = 0;
+					int b = 0;
+					averageRgb(image, x, y, 1, &r, &g, &b);
+					out[2*x + lumaOffset] = rgbToY(qRed(in[x]), qGreen(in[x]), qBlue(in[x]));
+					out[2*x + chromaOffset] = rgbToU(r, g, b);
+					if(x + 1 < width){
+						out[2*x + 2 + lumaOffset] = rgbToY(qRed(in[x1]), qGreen(in[x1]), qBlue(in[x1]));
+						out[2*x + 2 + chromaOffset] = rgbToV(r, g, b);
+					}
+				}
+			}
+			return true;
+		}
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21: {
+			if(mappedOutput.planeCount() < (format == QVideoFrame::Format_NV12 || format == QVideoFrame::Format_NV21 ? 2 : 3)){
+				return false;
+			}
+			for(int y = 0; y < height; y++){
+				const QRgb* in = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+				uchar* out = mappedOutput.bits(0) + y*mappedOutput.bytesPerLine(0);
+				for(int x = 0; x < width; x++){
+					out[x] = rgbToY(qRed(in[x]), qGreen(in[x]), qBlue(in[x]));
+				}
+			}
+			//chroma of 2x2 pixels
+			for(int y = 0; y < (height + 1)/2; y++){
+				for(int x = 0; x < (width + 1)/2; x++){
+					int r = 0;
+					int g = 0;
+					int b = 0;
+					averageRgb(image, 2*x, 2*y, 2, &r, &g, &b);
+					const quint8 u = rgbToU(r, g, b);
+					const quint8 v = rgbToV(r, g, b);
+					switch(format){
+						case QVideoFrame::Format_YUV420P:
+							mappedOutput.bits(1)[y*mappedOutput.bytesPerLine(1) + x] = u;
+							mappedOutput.bits(2)[y*mappedOutput.bytesPerLine(2) + x] = v;
+							break;
+						case QVideoFrame::Format_YV12:
+							mappedOutput.bits(1)[y*mappedOutput.bytesPerLine(1) + x] = v;
+							mappedOutput.bits(2)[y*mappedOutput.bytesPerLine(2) + x] = u;
+							break;
+						default: {
+							uchar* pair = mappedOutput.bits(1) + y*mappedOutput.bytesPerLine(1) + 2*x;
+							pair[0] = format == QVideoFrame::Format_NV12 ? u : v;
+							pair[1] = format == QVideoFrame::Format_NV12 ? v : u;
+							break;
+						}
+					}
+				}
+			}
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+int ReferenceComparison::planeRows(QVideoFrame::PixelFormat format, int plane, int height) {
+	if(plane == 0){
+		return height;
+	}
+	switch(format){
+		case QVideoFrame::Format_YUV420P:
+		case QVideoFrame::Format_YV12:
+		case QVideoFrame::Format_NV12:
+		case QVideoFrame::Format_NV21:
+			return (height + 1)/2;
+		default:
+			return height;
+	}
+}
+
+void ReferenceComparison::planeClasses(QVideoFrame::PixelFormat format, int plane, ByteClass classes[4], int* period) {
+	classes[0] = INTENSITY;
+	*period = 1;
+	switch(format){
+		case QVideoFrame::Format_RGB32:
+		case QVideoFrame::Format_ARGB32:
+		case QVideoFrame::Format_ARGB32_Premultiplied:
+			//b, g, r, a in memory
+			classes[1] = INTENSITY;
+			classes[2] = INTENSITY;
+			classes[3] = ALPHA;
+			*period = 4;
+			break;
+		case QVideoFrame::Format_BGR32:
+		case QVideoFrame::Format_BGRA32:
+		case QVideoFrame::Format_BGRA32_Premultiplied:
+			classes[0] = ALPHA;
+			classes[1] = INTENSITY;
+			classes[2] = INTENSITY;
+			classes[3] = INTENSITY;
+			*period = 4;
+			break;
+		case QVideoFrame::Format_YUYV:
+			classes[1] = CHROMA;
+			*period = 2;
+			break;
+		case QVideoFrame::Format_UYVY:
+			classes[0] = CHROMA;
+			classes[1] = INTENSITY;
+			*period = 2;
+			break;
+		default:
+			//planar formats: luma in plane 0, chroma in the other planes
+			classes[0] = plane == 0 ? INTENSITY : CHROMA;
+			break;
+	}
+}
+
+ReferenceComparison::Pass ReferenceComparison::makePass(const ReferenceComparisonSettings& settings, QVideoFrame::PixelFormat format, int plane) {
+	Pass pass;
+	pass.mode = settings.mode;
+	pass.weight = qRound(qBound(0.0, settings.opacity, 1.0)*WEIGHT_ONE);
+	while(pass.gainShift < 3 && (1 << pass.gainShift) < settings.gain){
+		pass.gainShift++;
+	}
+	ByteClass classes[4];
+	int period = 1;
+	planeClasses(format, plane, classes, &period);
+	for(int i = 0; i < 16; i++){
+		switch(classes[i % period]){
+			case INTENSITY:
+				pass.mask[i] = 0xff;
+				pass.fill[i] = 0;
+				break;
+			case CHROMA:
+				pass.mask[i] = 0;
+				pass.fill[i] = 128;
+				break;
+			case ALPHA:
+				pass.mask[i] = 0;
+				pass.fill[i] = 0xff;
+				break;
+		}
+	}
+	return pass;
+}
+
+void ReferenceComparison::compare(const uchar* live, const uchar* reference, uchar* dst, int count, const Pass& pass, bool vectorized) {
+	int i = 0;
+	if(pass.mode == ONION_SKIN){
+		const int referenceWeight = pass.weight;
+		const int liveWeight = WEIGHT_ONE - pass.weight;
+#ifdef CAMERAEXTENSION_SSE2
+		if(vectorized){
+			//255*WEIGHT_ONE fits into an unsigned 16 bit lane
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i liveWeights = _mm_set1_epi16(static_cast<short>(liveWeight));
+			const __m128i referenceWeights = _mm_set1_epi16(static_cast<short>(referenceWeight));
+			const __m128i half = _mm_set1_epi16(WEIGHT_ONE/2);
+			for(; i + 16 <= count; i += 16){
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(live + i));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(reference + i));
+				__m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), liveWeights), _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), referenceWeights));
+				__m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), liveWeights), _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), referenceWeights));
+				low = _mm_srli_epi16(_mm_add_epi16(low, half), 7);
+				high = _mm_srli_epi16(_mm_add_epi16(high, half), 7);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(low, high));
+			}
+		}
+#else
+		Q_UNUSED(vectorized)
+#endif
+		for(; i < count; i++){
+			dst[i] = static_cast<uchar>((live[i]*liveWeight + reference[i]*referenceWeight + WEIGHT_ONE/2) >> 7);
+		}
+		return;
+	}
+
+#ifdef CAMERAEXTENSION_SSE2
+	if(vectorized){
+		const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pass.mask));
+		const __m128i fill = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pass.fill));
+		for(; i + 16 <= count; i += 16){
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(live + i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(reference + i));
+			__m128i difference = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+			for(int k = 0; k < pass.gainShift; k++){
+				difference = _mm_adds_epu8(difference, difference);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_and_si128(difference, mask), fill));
+		}
+	}
+#else
+	Q_UNUSED(vectorized)
+#endif
+	for(; i < count; i++){
+		const int difference = qMin(255, qAbs(live[i] - reference[i]) << pass.gainShift);
+		dst[i] = static_cast<uchar>((difference & pass.mask[i & 15]) | pass.fill[i & 15]);
+	}
+}
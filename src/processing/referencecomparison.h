@@ -0,0 +1,104 @@
+#ifndef REFERENCECOMPARISON_H
+#define REFERENCECOMPARISON_H
+
+#include <QVideoFrame>
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QByteArray>
+
+
+struct ReferenceComparisonSettings {
+	int mode = 0; //ReferenceComparison::Mode
+	qreal opacity = 0.5; //share of the reference in onion skin mode, 0..1
+	int gain = 1; //amplification of the difference, 1, 2, 4 or 8
+
+	bool operator==(const ReferenceComparisonSettings& other) const;
+	bool operator!=(const ReferenceComparisonSettings& other) const {return !(*this == other);}
+};
+
+//compares the live view with a reference image (e.g. a snapshot of an earlier session) to bring a sample back to the same position.
+//the reference is converted once to the pixel format, resolution and memory layout of the displayed frames, so every frame costs a single
+//SSE2 pass over the bytes of live and reference, independent of the format: onion skin blends every byte, the difference mode writes
+//the absolute difference of luma/colour bytes and neutral chroma/opaque alpha. the result is a new frame in the format of the live frame,
+//the camera frame itself is not modified. the false colour maps of ImageAdjustment are applied afterwards, so the difference can be shown in false colour
+class ReferenceComparison
+{
+public:
+	enum Mode {
+		OFF,
+		ONION_SKIN,
+		DIFFERENCE
+	};
+
+	//per byte of a frame: how it is treated by the difference mode
+	enum ByteClass {
+		INTENSITY, //luma or rgb component
+		CHROMA,
+		ALPHA
+	};
+
+	//one pass of the kernel. onion skin uses weight (0..WEIGHT_ONE), the difference gainShift, mask and fill (repeating every 16 bytes from the row start)
+	struct Pass {
+		int mode = OFF;
+		int weight = 0;
+		int gainShift = 0;
+		quint8 mask[16];
+		quint8 fill[16];
+	};
+
+	ReferenceComparison();
+
+	//thread safe, may be called while process() runs on another thread
+	void setSettings(const ReferenceComparisonSettings& settings);
+	ReferenceComparisonSettings getSettings() const;
+	//any image that Qt can read, it is scaled to the frame size. a null image removes the reference
+	void setReference(const QImage& image);
+	QImage getReference() const;
+	bool hasReference() const;
+	bool isActive() const {return this->active.loadAcquire() != 0;}
+
+	//returns the compared frame in the format of frame, or an invalid frame if the format is not supported or the frame can not be read
+	QVideoFrame process(const QVideoFrame& frame);
+	int getLastProcessingTimeUs() const {return this->lastProcessingTimeUs.loadAcquire();}
+
+	static bool isSupportedFormat(QVideoFrame::PixelFormat format);
+
+	//the kernel, public to be verified against the scalar path. count bytes of live and reference are combined into dst
+	static void compare(const uchar* live, const uchar* reference, uchar* dst, int count, const Pass& pass, bool vectorized = true);
+
+	static const int WEIGHT_ONE = 128;
+	static const int BAND_HEIGHT = 32;
+	static const int MAX_PLANES = 3;
+
+private:
+	//the reference in the layout of the output frames (planes at planeOffsets, strides of the mapped output frame)
+	struct PreparedReference {
+		QVideoFrame::PixelFormat format = QVideoFrame::Format_Invalid;
+		QSize size;
+		int bytesPerLine = 0;
+		int generation = -1;
+		int planeCount = 0;
+		int planeOffsets[MAX_PLANES] = {};
+		QByteArray data;
+	};
+
+	mutable QMutex mutex;
+	ReferenceComparisonSettings settings;
+	QImage reference;
+	int referenceGeneration;
+	QAtomicInt active;
+	QAtomicInt lastProcessingTimeUs;
+
+	//only used by the thread that calls process()
+	PreparedReference prepared;
+
+	void updateActive();
+	bool prepare(const QImage& image, int generation, QVideoFrame& mappedOutput);
+	static bool encode(const QImage& image, QVideoFrame& mappedOutput);
+	static int planeRows(QVideoFrame::PixelFormat format, int plane, int height);
+	static void planeClasses(QVideoFrame::PixelFormat format, int plane, ByteClass classes[4], int* period);
+	static Pass makePass(const ReferenceComparisonSettings& settings, QVideoFrame::PixelFormat format, int plane);
+};
+
+#endif //REFERENCECOMPARISON_H
@@ -0,0 +1,287 @@
+#include "remaptable.h"
+#include "frameconversion.h"
+#include "workstealingpool.h"
+#include "simd.h"
+#include <cstring>
+
+
+namespace {
+#ifdef CAMERAEXTENSION_SSE2
+	//weighted sums of the positions i..i+3, taps of two positions per register in the order of their weights
+	inline __m128i weightedSums(const uchar* base, const qint32* offsets, const qint16* weights, int i, int pixelStep, int rowStep) {
+		const int diagonalStep = rowStep + pixelStep;
+		const uchar* p0 = base + offsets[i];
+		const uchar* p1 = base + offsets[i + 1];
+		const uchar* p2 = base + offsets[i + 2];
+		const uchar* p3 = base + offsets[i + 3];
+		const __m128i taps01 = _mm_setr_epi16(p0[0], p0[pixelStep], p0[rowStep], p0[diagonalStep], p1[0], p1[pixelStep], p1[rowStep], p1[diagonalStep]);
+		const __m128i taps23 = _mm_setr_epi16(p2[0], p2[pixelStep], p2[rowStep], p2[diagonalStep], p3[0], p3[pixelStep], p3[rowStep], p3[diagonalStep]);
+		//upper and lower row of each position
+		const __m128 rows01 = _mm_castsi128_ps(_mm_madd_epi16(taps01, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + 4*i))));
+		const __m128 rows23 = _mm_castsi128_ps(_mm_madd_epi16(taps23, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + 4*i + 8))));
+		const __m128i upper = _mm_castps_si128(_mm_shuffle_ps(rows01, rows23, _MM_SHUFFLE(2, 0, 2, 0)));
+		const __m128i lower = _mm_castps_si128(_mm_shuffle_ps(rows01, rows23, _MM_SHUFFLE(3, 1, 3, 1)));
+		return _mm_add_epi32(upper, lower);
+	}
+
+	inline __m128i load32(const uchar* p) {
+		qint32 value;
+		memcpy(&value, p, 4);
+		return _mm_cvtsi32_si128(value);
+	}
+
+	//weighted sums of the interleaved channels of one position, channel c in word c*channelStep. the taps of a row are two 4 byte loads, the
+	//first starting at the left tap, the second ending at the last channel of the right tap (32 bit pixels, 2 channels of 4:2:2 or NV12)
+	inline __m128i weightedChannels(const uchar* p, const qint16* weights, int rowStep, int rightLoad, int shift, const __m128i& mask) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i w = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(weights));
+		const __m128i upperWeights = _mm_and_si128(mask,
+			_mm_unpacklo_epi64(_mm_shufflelo_epi16(w, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shufflelo_epi16(w, _MM_SHUFFLE(1, 1, 1, 1))));
+		const __m128i lowerWeights = _mm_and_si128(mask,
+			_mm_unpacklo_epi64(_mm_shufflelo_epi16(w, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shufflelo_epi16(w, _MM_SHUFFLE(3, 3, 3, 3))));
+		const __m128i upper = _mm_unpacklo_epi8(_mm_unpacklo_epi32(load32(p), load32(p + rightLoad)), zero);
+		const __m128i lower = _mm_unpacklo_epi8(_mm_unpacklo_epi32(load32(p + rowStep), load32(p + rowStep + rightLoad)), zero);
+		//at most 255*WEIGHT_ONE, the products and their sums fit into unsigned 16 bit words
+		const __m128i sums = _mm_add_epi16(_mm_mullo_epi16(upper, upperWeights), _mm_mullo_epi16(lower, lowerWeights));
+		//the right tap onto the left one
+		switch(shift){
+			case 4: return _mm_add_epi16(sums, _mm_srli_si128(sums, 8));
+			case 5: return _mm_add_epi16(sums, _mm_srli_si128(sums, 10));
+			default: return _mm_add_epi16(sums, _mm_srli_si128(sums, 12));
+		}
+	}
+#endif
+
+	inline int weightedSum(const uchar* base, const qint32* offsets, const qint16* weights, int i, int pixelStep, int rowStep) {
+		const uchar* p = base + offsets[i];
+		const qint16* w = weights + 4*i;
+		return p[0]*w[0] + p[pixelStep]*w[1] + p[rowStep]*w[2] + p[rowStep + pixelStep]*w[3];
+	}
+}
+
+
+RemapTable::RemapTable()
+	: pixelStep(0),
+	  rowStep(0),
+	  byteOffset(0)
+{
+}
+
+void RemapTable::build(const QVector<QPointF>& positions, const QSize& frameSize, Border border) {
+	this->build(QSize(positions.size(), 1), [&positions](int x, int) {return positions.at(x);}, frameSize, border);
+}
+
+void RemapTable::build(const QSize& grid, const std::function<QPointF(int, int)>& position, const QSize& frameSize, Border border) {
+	this->clear();
+	const int frameWidth = frameSize.width();
+	const int frameHeight = frameSize.height();
+	const int columns = grid.width();
+	const int rows = grid.height();
+	if(frameWidth < 2 || frameHeight < 2 || frameWidth > 0xffff || frameHeight > 0xffff || columns <= 0 || rows <= 0){
+		return;
+	}
+	this->taps.resize(columns*rows);
+	this->weights.resize(4*columns*rows);
+	const int bandRows = qMax(1, BUILD_BAND/columns);
+	const int bands = (rows + bandRows - 1)/bandRows;
+	QVector<QRect> bandBounds(bands);
+	WorkStealingPool::globalInstance()->parallelFor(bands, [&](int band) {
+		int minX = frameWidth;
+		int minY = frameHeight;
+		int maxX = 0;
+		int maxY = 0;
+		const int endRow = qMin(rows, (band + 1)*bandRows);
+		for(int row = band*bandRows; row < endRow; row++){
+			for(int column = 0; column < columns; column++){
+				const int i = row*columns + column;
+				const QPointF p = position(column, row);
+				qint16* w = this->weights.data() + 4*i;
+				//positions up to half a pixel outside the frame still get the edge pixels
+				const bool outside = p.x() < -0.5 || p.y() < -0.5 || p.x() > frameWidth - 0.5 || p.y() > frameHeight - 0.5;
+				const double x = qBound(0.0, p.x(), frameWidth - 1.0);
+				const double y = qBound(0.0, p.y(), frameHeight - 1.0);
+				//the right and lower neighbour of the top left tap have to be inside the frame
+				const int x0 = qMin(static_cast<int>(x), frameWidth - 2);
+				const int y0 = qMin(static_cast<int>(y), frameHeight - 2);
+				this->taps[i] = static_cast<quint32>(y0) << 16 | static_cast<quint32>(x0);
+				if(border == ZERO && outside){
+					//the clamped tap keeps bounds() tight, its weights are 0
+					memset(w, 0, 4*sizeof(qint16));
+				} else {
+					const int wx = qRound((x - x0)*WEIGHT_STEPS);
+					const int wy = qRound((y - y0)*WEIGHT_STEPS);
+					w[0] = static_cast<qint16>((WEIGHT_STEPS - wx)*(WEIGHT_STEPS - wy));
+					w[1] = static_cast<qint16>(wx*(WEIGHT_STEPS - wy));
+					w[2] = static_cast<qint16>((WEIGHT_STEPS - wx)*wy);
+					w[3] = static_cast<qint16>(wx*wy);
+				}
+				minX = qMin(minX, x0);
+				minY = qMin(minY, y0);
+				maxX = qMax(maxX, x0);
+				maxY = qMax(maxY, y0);
+			}
+		}
+		bandBounds[band] = QRect(QPoint(minX, minY), QPoint(maxX + 1, maxY + 1));
+	});
+	for(const QRect& bounds : bandBounds){
+		this->tapBounds = this->tapBounds.united(bounds);
+	}
+}
+
+bool RemapTable::setLayout(int pixelStep, int rowStep, int byteOffset, const QPoint& origin) {
+	if(this->pixelStep == pixelStep && this->rowStep == rowStep && this->byteOffset == byteOffset && this->origin == origin
+			&& this->offsets.size() == this->taps.size()){
+		return false;
+	}
+	this->pixelStep = pixelStep;
+	this->rowStep = rowStep;
+	this->byteOffset = byteOffset;
+	this->origin = origin;
+	this->offsets.resize(this->taps.size());
+	for(int i = 0; i < this->taps.size(); i++){
+		const int x = static_cast<int>(this->taps.at(i) & 0xffff) - origin.x();
+		const int y = static_cast<int>(this->taps.at(i) >> 16) - origin.y();
+		this->offsets[i] = y*rowStep + x*pixelStep + byteOffset;
+	}
+	return true;
+}
+
+const uchar* RemapTable::attach(const QVideoFrame& frame, QVideoFrame* mappedFrame, LumaImage* luma) {
+	if(this->taps.isEmpty()){
+		return nullptr;
+	}
+	int pixelStep = 1;
+	int byteOffset = 0;
+	if(FrameConversion::lumaLayout(frame.pixelFormat(), &pixelStep, &byteOffset)){
+		*mappedFrame = frame;
+		if(!mappedFrame->map(QAbstractVideoBuffer::ReadOnly)){
+			return nullptr;
+		}
+		const int stride = mappedFrame->bytesPerLine();
+		if(static_cast<qint64>(stride)*this->tapBounds.bottom() + pixelStep*this->tapBounds.right() + byteOffset >= mappedFrame->mappedBytes()){
+			mappedFrame->unmap();
+			return nullptr;
+		}
+		this->setLayout(pixelStep, stride, byteOffset);
+		return mappedFrame->bits();
+	}
+	*luma = FrameConversion::toLuma(frame, 1, this->tapBounds);
+	if(luma->isNull() || luma->width != this->tapBounds.width() || luma->height != this->tapBounds.height()){
+		return nullptr;
+	}
+	this->setLayout(1, luma->width, 0, this->tapBounds.topLeft());
+	return luma->data.constData();
+}
+
+void RemapTable::clear() {
+	this->taps.clear();
+	this->weights.clear();
+	this->offsets.clear();
+	this->tapBounds = QRect();
+	this->pixelStep = 0;
+}
+
+void RemapTable::accumulate(const uchar* base, const qint32* offsets, const qint16* weights, int count, int pixelStep, int rowStep,
+		qint32* sums, bool vectorized) {
+	int i = 0;
+#ifdef CAMERAEXTENSION_SSE2
+	if(vectorized){
+		for(; i + 4 <= count; i += 4){
+			__m128i* target = reinterpret_cast<__m128i*>(sums + i);
+			_mm_storeu_si128(target, _mm_add_epi32(_mm_loadu_si128(target), weightedSums(base, offsets, weights, i, pixelStep, rowStep)));
+		}
+	}
+#else
+	Q_UNUSED(vectorized)
+#endif
+	for(; i < count; i++){
+		sums[i] += weightedSum(base, offsets, weights, i, pixelStep, rowStep);
+	}
+}
+
+void RemapTable::remap(const uchar* base, const qint32* offsets, const qint16* weights, int count, int pixelStep, int rowStep,
+		quint8* dst, bool vectorized) {
+	int i = 0;
+#ifdef CAMERAEXTENSION_SSE2
+	if(vectorized){
+		const __m128i half = _mm_set1_epi32(WEIGHT_ONE/2);
+		for(; i + 4 <= count; i += 4){
+			__m128i values = _mm_srli_epi32(_mm_add_epi32(weightedSums(base, offsets, weights, i, pixelStep, rowStep), half), 8);
+			values = _mm_packs_epi32(values, values);
+			values = _mm_packus_epi16(values, values);
+			const qint32 packed = _mm_cvtsi128_si32(values);
+			memcpy(dst + i, &packed, 4);
+		}
+	}
+#else
+	Q_UNUSED(vectorized)
+#endif
+	for(; i < count; i++){
+		dst[i] = static_cast<quint8>((weightedSum(base, offsets, weights, i, pixelStep, rowStep) + WEIGHT_ONE/2) >> 8);
+	}
+}
+
+void RemapTable::remap(const uchar* base, const qint32* offsets, const qint16* weights, int count, int pixelStep, int rowStep,
+		int channels, int channelStep, uchar* dst, int dstStep, bool vectorized) {
+	if(channels == 1 && dstStep == 1){
+		remap(base, offsets, weights, count, pixelStep, rowStep, dst, vectorized);
+		return;
+	}
+	int i = 0;
+#ifdef CAMERAEXTENSION_SSE2
+	//span of the channels of a tap, the two 4 byte loads per row must neither miss nor overrun a tap
+	const int channelSpan = (channels - 1)*channelStep;
+	if(vectorized && (channels == 2 || channels == 4) && channelSpan <= 3 && pixelStep + channelSpan >= 3){
+		const int rightLoad = pixelStep + channelSpan - 3;
+		//word of the left tap of channel c: c*channelStep, of the right tap: shift + c*channelStep
+		const int shift = 4 + 3 - channelSpan;
+		qint16 maskWords[8] = {};
+		for(int c = 0; c < channels; c++){
+			maskWords[c*channelStep] = -1;
+			maskWords[shift + c*channelStep] = -1;
+		}
+		const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(maskWords));
+		const __m128i half = _mm_set1_epi16(WEIGHT_ONE/2);
+		for(; i + 2 <= count; i += 2){
+			__m128i values = _mm_unpacklo_epi64(weightedChannels(base + offsets[i], weights + 4*i, rowStep, rightLoad, shift, mask),
+				weightedChannels(base + offsets[i + 1], weights + 4*i + 4, rowStep, rightLoad, shift, mask));
+			values = _mm_srli_epi16(_mm_add_epi16(values, half), 8);
+			values = _mm_packus_epi16(values, values);
+			const quint32 packed[2] = {static_cast<quint32>(_mm_cvtsi128_si32(values)), static_cast<quint32>(_mm_cvtsi128_si32(_mm_srli_si128(values, 4)))};
+			for(int k = 0; k < 2; k++){
+				uchar* d = dst + (i + k)*dstStep;
+				if(channels == 4){
+					memcpy(d, &packed[k], 4);
+				} else {
+					d[0] = static_cast<uchar>(packed[k]);
+					d[channelStep] = static_cast<uchar>(packed[k] >> (8*channelStep));
+				}
+			}
+		}
+	} else if(vectorized){
+		//one position per channel and word, 4 positions at a time
+		const __m128i half = _mm_set1_epi32(WEIGHT_ONE/2);
+		for(; i + 4 <= count; i += 4){
+			for(int c = 0; c < channels; c++){
+				__m128i values = _mm_srli_epi32(_mm_add_epi32(weightedSums(base + c*channelStep, offsets, weights, i, pixelStep, rowStep), half), 8);
+				values = _mm_packs_epi32(values, values);
+				values = _mm_packus_epi16(values, values);
+				const quint32 packed = static_cast<quint32>(_mm_cvtsi128_si32(values));
+				uchar* d = dst + i*dstStep + c*channelStep;
+				d[0] = static_cast<uchar>(packed);
+				d[dstStep] = static_cast<uchar>(packed >> 8);
+				d[2*dstStep] = static_cast<uchar>(packed >> 16);
+				d[3*dstStep] = static_cast<uchar>(packed >> 24);
+			}
+		}
+	}
+#else
+	Q_UNUSED(vectorized)
+#endif
+	for(; i < count; i++){
+		for(int c = 0; c < channels; c++){
+			const int sum = weightedSum(base + c*channelStep, offsets, weights, i, pixelStep, rowStep);
+			dst[i*dstStep + c*channelStep] = static_cast<uchar>((sum + WEIGHT_ONE/2) >> 8);
+		}
+	}
+}
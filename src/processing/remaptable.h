@@ -0,0 +1,78 @@
+#ifndef REMAPTABLE_H
+#define REMAPTABLE_H
+
+#include <QVector>
+#include <QPointF>
+#include <QRect>
+#include <QSize>
+#include <QVideoFrame>
+#include <functional>
+#include "lumaimage.h"
+
+
+//precomputed bilinear sampling of a list of frame positions (line profiles, polar unwrapping, ...). build() stores the top left tap and
+//the four 1/16 px interpolation weights of every position, setLayout() turns the taps into byte offsets for the memory layout of the luma
+//that is sampled (the mapped frame or a luma copy of bounds()). both only have to be called again if the positions or the layout change,
+//applying the table is a gather of four taps per position, weighted 4 positions at a time with SSE2 (pmaddwd). tables with a position per
+//frame pixel (lens undistortion) are built on the shared WorkStealingPool and applied per plane, with several interleaved channels per position
+class RemapTable
+{
+public:
+	enum Border {
+		CLAMP, //positions outside the frame take the nearest edge pixel
+		ZERO //positions outside the frame are black
+	};
+
+	RemapTable();
+
+	//positions in pixel center coordinates, pixel (0, 0) is centered at (0, 0)
+	void build(const QVector<QPointF>& positions, const QSize& frameSize, Border border);
+	//same for a grid of positions returned by position(column, row), stored row by row. bands of rows are computed on the WorkStealingPool,
+	//position is called from several threads
+	void build(const QSize& grid, const std::function<QPointF(int, int)>& position, const QSize& frameSize, Border border);
+	//returns true if the offsets had to be computed again
+	bool setLayout(int pixelStep, int rowStep, int byteOffset, const QPoint& origin = QPoint(0, 0));
+	void clear();
+	//returns the base pointer the offsets refer to: the mapped frame if its luma can be read in place, otherwise a luma copy of bounds().
+	//sets the layout accordingly. mappedFrame stays mapped (and luma holds the copy) until the table is applied, the caller unmaps it.
+	//returns nullptr if the frame cannot be read or does not match the table
+	const uchar* attach(const QVideoFrame& frame, QVideoFrame* mappedFrame, LumaImage* luma);
+
+	int size() const {return this->taps.size();}
+	bool isEmpty() const {return this->taps.isEmpty();}
+	//all taps and their right and lower neighbours in frame pixels
+	QRect bounds() const {return this->tapBounds;}
+	int getPixelStep() const {return this->pixelStep;}
+	int getRowStep() const {return this->rowStep;}
+	const qint32* offsetsAt(int index) const {return this->offsets.constData() + index;}
+	const qint16* weightsAt(int index) const {return this->weights.constData() + 4*index;}
+
+	//the kernels, public to be verified against the scalar path. offsets[i] is the byte offset of the top left tap of position i,
+	//weights holds w00, w01, w10, w11 (sum WEIGHT_ONE, or 0 outside the frame) for every position.
+	//accumulate() adds the weighted sum (scaled by WEIGHT_ONE) of position i to sums[i], remap() writes the rounded value to dst[i]
+	static void accumulate(const uchar* base, const qint32* offsets, const qint16* weights, int count, int pixelStep, int rowStep,
+		qint32* sums, bool vectorized = true);
+	static void remap(const uchar* base, const qint32* offsets, const qint16* weights, int count, int pixelStep, int rowStep,
+		quint8* dst, bool vectorized = true);
+	//remap() of channels samples per position, channelStep bytes apart in the source and in dst, to positions dstStep bytes apart in dst:
+	//the luma or the chroma pairs of packed 4:2:2, interleaved chroma planes and 32 bit pixels (4 channels, both taps of a row in one load)
+	static void remap(const uchar* base, const qint32* offsets, const qint16* weights, int count, int pixelStep, int rowStep,
+		int channels, int channelStep, uchar* dst, int dstStep, bool vectorized = true);
+
+	static const int WEIGHT_STEPS = 16;
+	static const int WEIGHT_ONE = WEIGHT_STEPS*WEIGHT_STEPS;
+	static const int BUILD_BAND = 16384; //positions per task of build(), at least one row
+
+private:
+	//top left tap as y << 16 | x, 4 bytes per position instead of 8 for tables with millions of positions
+	QVector<quint32> taps;
+	QVector<qint16> weights;
+	QVector<qint32> offsets;
+	QRect tapBounds;
+	int pixelStep;
+	int rowStep;
+	int byteOffset;
+	QPoint origin;
+};
+
+#endif //REMAPTABLE_H
@@ -0,0 +1,180 @@
+#include "roistatistics.h"
+#include "frameconversion.h"
+#include "simd.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <cmath>
+
+//number of 16 pixel blocks after which the 32 bit sum of squares lanes are flushed. worst case per lane and block is 4*255^2
+#define SQUARES_FLUSH_INTERVAL 8192
+
+
+RoiStatisticsAnalyzer::RoiStatisticsAnalyzer(QObject *parent)
+	: FrameAnalyzer(parent)
+{
+	qRegisterMetaType<RoiStatistics>("RoiStatistics");
+	qRegisterMetaType<RoiStatisticsMap>("RoiStatisticsMap");
+}
+
+RoiStatisticsAnalyzer::~RoiStatisticsAnalyzer() {
+	this->stopWorker();
+}
+
+void RoiStatisticsAnalyzer::setRegions(const QHash<QString, QPolygonF>& normalizedRegions) {
+	QMutexLocker locker(&this->mutex);
+	this->normalizedRegions = normalizedRegions;
+}
+
+void RoiStatisticsAnalyzer::analyzeFrame(const QVideoFrame& frame) {
+	this->mutex.lock();
+	QHash<QString, QPolygonF> regions = this->normalizedRegions;
+	this->mutex.unlock();
+	if(regions.isEmpty()){
+		return;
+	}
+
+	this->updateCachedRegions(regions, frame.size());
+	QRect sourceRect;
+	for(const CachedRegion& region : this->cachedRegions){
+		sourceRect |= region.bounds;
+	}
+	if(sourceRect.isEmpty()){
+		return;
+	}
+
+	//full resolution copy of the area covered by all regions
+	LumaImage luma = FrameConversion::toLuma(frame, 1, sourceRect);
+	if(luma.isNull()){
+		return;
+	}
+
+	RoiStatisticsMap results;
+	qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+	for(auto it = this->cachedRegions.constBegin(); it != this->cachedRegions.constEnd(); ++it){
+		Accumulator accumulator;
+		for(const ScanlineSpan& span : it.value().spans){
+			accumulate(luma.constLine(span.y - sourceRect.top()) + span.x0 - sourceRect.left(), span.x1 - span.x0, &accumulator);
+		}
+		RoiStatistics statistics = finish(accumulator);
+		statistics.timestamp = timestamp;
+		results.insert(it.key(), statistics);
+	}
+	emit roiStatisticsMeasured(results);
+}
+
+void RoiStatisticsAnalyzer::updateCachedRegions(const QHash<QString, QPolygonF>& regions, const QSize& frameSize) {
+	if(frameSize != this->cachedFrameSize){
+		this->cachedRegions.clear();
+		this->cachedFrameSize = frameSize;
+	}
+	for(auto it = this->cachedRegions.begin(); it != this->cachedRegions.end();){
+		if(!regions.contains(it.key())){
+			it = this->cachedRegions.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	//spans are only rasterized again if the region has moved
+	const QRect frameRect(QPoint(0, 0), frameSize);
+	for(auto it = regions.constBegin(); it != regions.constEnd(); ++it){
+		auto cached = this->cachedRegions.constFind(it.key());
+		if(cached != this->cachedRegions.constEnd() && cached.value().normalizedPolygon == it.value()){
+			continue;
+		}
+		CachedRegion region;
+		region.normalizedPolygon = it.value();
+		QPolygonF polygonInPixels;
+		for(const QPointF& p : it.value()){
+			polygonInPixels.append(QPointF(p.x()*frameSize.width(), p.y()*frameSize.height()));
+		}
+		region.spans = ScanlineSpans::fromPolygon(polygonInPixels, frameRect);
+		for(const ScanlineSpan& span : region.spans){
+			region.bounds |= QRect(span.x0, span.y, span.x1 - span.x0, 1);
+		}
+		this->cachedRegions.insert(it.key(), region);
+	}
+}
+
+void RoiStatisticsAnalyzer::accumulate(const quint8* pixels, int count, Accumulator* accumulator, bool vectorized) {
+	int x = 0;
+#ifdef CAMERAEXTENSION_SSE2
+	if(vectorized && count >= 16){
+		const __m128i zero = _mm_setzero_si128();
+		__m128i sum64 = _mm_setzero_si128();
+		__m128i squares32 = _mm_setzero_si128();
+		__m128i minimum = _mm_cmpeq_epi8(zero, zero);
+		__m128i maximum = _mm_setzero_si128();
+		alignas(16) quint8 block[16];
+		int blocks = 0;
+		for(; x + 16 <= count; x += 16){
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+			sum64 = _mm_add_epi64(sum64, _mm_sad_epu8(v, zero));
+			const __m128i lo = _mm_unpacklo_epi8(v, zero);
+			const __m128i hi = _mm_unpackhi_epi8(v, zero);
+			squares32 = _mm_add_epi32(squares32, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+			minimum = _mm_min_epu8(minimum, v);
+			maximum = _mm_max_epu8(maximum, v);
+			//SSE2 has no scatter, the histogram is counted from the loaded block
+			_mm_store_si128(reinterpret_cast<__m128i*>(block), v);
+			for(int i = 0; i < 16; i += 4){
+				accumulator->histograms[0][block[i]]++;
+				accumulator->histograms[1][block[i + 1]]++;
+				accumulator->histograms[2][block[i + 2]]++;
+				accumulator->histograms[3][block[i + 3]]++;
+			}
+			if(++blocks == SQUARES_FLUSH_INTERVAL){
+				alignas(16) quint32 sq[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(sq), squares32);
+				accumulator->sumOfSquares += static_cast<quint64>(sq[0]) + sq[1] + sq[2] + sq[3];
+				squares32 = _mm_setzero_si128();
+				blocks = 0;
+			}
+		}
+		alignas(16) quint64 s[2];
+		alignas(16) quint32 sq[4];
+		alignas(16) quint8 mins[16];
+		alignas(16) quint8 maxs[16];
+		_mm_store_si128(reinterpret_cast<__m128i*>(s), sum64);
+		_mm_store_si128(reinterpret_cast<__m128i*>(sq), squares32);
+		_mm_store_si128(reinterpret_cast<__m128i*>(mins), minimum);
+		_mm_store_si128(reinterpret_cast<__m128i*>(maxs), maximum);
+		accumulator->sum += s[0] + s[1];
+		accumulator->sumOfSquares += static_cast<quint64>(sq[0]) + sq[1] + sq[2] + sq[3];
+		for(int i = 0; i < 16; i++){
+			accumulator->min = qMin(accumulator->min, static_cast<int>(mins[i]));
+			accumulator->max = qMax(accumulator->max, static_cast<int>(maxs[i]));
+		}
+	}
+#else
+	Q_UNUSED(vectorized)
+#endif
+	for(; x < count; x++){
+		const int value = pixels[x];
+		accumulator->sum += value;
+		accumulator->sumOfSquares += value*value;
+		accumulator->min = qMin(accumulator->min, value);
+		accumulator->max = qMax(accumulator->max, value);
+		accumulator->histograms[x & 3][value]++;
+	}
+	accumulator->count += qMax(0, count);
+}
+
+RoiStatistics RoiStatisticsAnalyzer::finish(const Accumulator& accumulator) {
+	RoiStatistics statistics;
+	if(accumulator.count <= 0){
+		return statistics;
+	}
+	statistics.valid = true;
+	statistics.pixelCount = accumulator.count;
+	statistics.min = accumulator.min;
+	statistics.max = accumulator.max;
+	statistics.mean = static_cast<double>(accumulator.sum)/accumulator.count;
+	double variance = static_cast<double>(accumulator.sumOfSquares)/accumulator.count - statistics.mean*statistics.mean;
+	statistics.stdDev = sqrt(qMax(0.0, variance));
+	statistics.histogram.resize(256);
+	for(int i = 0; i < 256; i++){
+		statistics.histogram[i] = accumulator.histograms[0][i] + accumulator.histograms[1][i] + accumulator.histograms[2][i] + accumulator.histograms[3][i];
+	}
+	return statistics;
+}
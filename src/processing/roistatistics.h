@@ -0,0 +1,79 @@
+#ifndef ROISTATISTICS_H
+#define ROISTATISTICS_H
+
+#include <QMutex>
+#include <QHash>
+#include <QPolygonF>
+#include <QVector>
+#include <QMetaType>
+#include "frameanalyzer.h"
+#include "scanlinespans.h"
+
+
+//intensity statistics of the luma inside one overlay
+struct RoiStatistics {
+	bool valid = false;
+	qint64 pixelCount = 0;
+	double mean = 0.0;
+	double stdDev = 0.0;
+	int min = 0;
+	int max = 0;
+	QVector<quint32> histogram; //256 bins
+	qint64 timestamp = 0; //ms since epoch
+};
+typedef QHash<QString, RoiStatistics> RoiStatisticsMap;
+Q_DECLARE_METATYPE(RoiStatistics)
+Q_DECLARE_METATYPE(RoiStatisticsMap)
+
+
+//measures mean, min/max, standard deviation and histogram of the full resolution luma inside each region (e.g. the area overlays).
+//every region is rasterized into a scanline span list once and the spans are reused until the region or the frame size changes.
+//sum, sum of squares and min/max are accumulated 16 pixels at a time with SSE2, the histogram is counted in four interleaved tables
+//so consecutive pixels of the same value do not wait for each other
+class RoiStatisticsAnalyzer : public FrameAnalyzer
+{
+	Q_OBJECT
+public:
+	struct Accumulator {
+		quint64 sum = 0;
+		quint64 sumOfSquares = 0;
+		qint64 count = 0;
+		int min = 255;
+		int max = 0;
+		quint32 histograms[4][256] = {};
+	};
+
+	explicit RoiStatisticsAnalyzer(QObject *parent = nullptr);
+	~RoiStatisticsAnalyzer();
+
+	//regions by name in normalized frame coordinates (0..1). regions that are not in the map are no longer measured
+	void setRegions(const QHash<QString, QPolygonF>& normalizedRegions);
+
+	//the kernel, public to be verified against the scalar path
+	static void accumulate(const quint8* pixels, int count, Accumulator* accumulator, bool vectorized = true);
+	static RoiStatistics finish(const Accumulator& accumulator);
+
+protected:
+	void analyzeFrame(const QVideoFrame& frame) override;
+
+private:
+	struct CachedRegion {
+		QPolygonF normalizedPolygon;
+		QRect bounds; //bounding rect of the spans in frame pixels
+		QVector<ScanlineSpan> spans; //in frame pixels
+	};
+
+	QMutex mutex;
+	QHash<QString, QPolygonF> normalizedRegions;
+
+	//only used by analyzeFrame()
+	QHash<QString, CachedRegion> cachedRegions;
+	QSize cachedFrameSize;
+
+	void updateCachedRegions(const QHash<QString, QPolygonF>& regions, const QSize& frameSize);
+
+signals:
+	void roiStatisticsMeasured(RoiStatisticsMap statistics);
+};
+
+#endif //ROISTATISTICS_H
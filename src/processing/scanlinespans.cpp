@@ -0,0 +1,58 @@
+#include "scanlinespans.h"
+#include <algorithm>
+#include <QtMath>
+
+
+QVector<ScanlineSpan> ScanlineSpans::fromPolygon(const QPolygonF& polygon, const QRect& bounds) {
+	QVector<ScanlineSpan> spans;
+	if(polygon.size() < 3 || bounds.isEmpty()){
+		return spans;
+	}
+
+	QRectF polygonBounds = polygon.boundingRect();
+	int yStart = qMax(bounds.top(), static_cast<int>(qFloor(polygonBounds.top())));
+	int yEnd = qMin(bounds.bottom(), static_cast<int>(qCeil(polygonBounds.bottom())));
+
+	QVector<qreal> crossings;
+	const int n = polygon.size();
+	for(int y = yStart; y <= yEnd; y++){
+		qreal yc = y + 0.5;
+		crossings.clear();
+		for(int i = 0; i < n; i++){
+			const QPointF& a = polygon.at(i);
+			const QPointF& b = polygon.at((i + 1) % n);
+			//half open interval avoids counting shared vertices twice
+			if((a.y() <= yc && b.y() > yc) || (b.y() <= yc && a.y() > yc)){
+				qreal t = (yc - a.y()) / (b.y() - a.y());
+				crossings.append(a.x() + t * (b.x() - a.x()));
+			}
+		}
+		std::sort(crossings.begin(), crossings.end());
+		for(int i = 0; i + 1 < crossings.size(); i += 2){
+			//pixel x is inside if its center x+0.5 lies in [crossing0, crossing1)
+			int x0 = qMax(bounds.left(), static_cast<int>(qCeil(crossings.at(i) - 0.5)));
+			int x1 = qMin(bounds.right() + 1, static_cast<int>(qCeil(crossings.at(i + 1) - 0.5)));
+			if(x1 > x0){
+				spans.append({y, x0, x1});
+			}
+		}
+	}
+	return spans;
+}
+
+QVector<ScanlineSpan> ScanlineSpans::fromRect(const QRect& rect) {
+	QVector<ScanlineSpan> spans;
+	spans.reserve(qMax(0, rect.height()));
+	for(int y = rect.top(); y <= rect.bottom(); y++){
+		spans.append({y, rect.left(), rect.right() + 1});
+	}
+	return spans;
+}
+
+qint64 ScanlineSpans::pixelCount(const QVector<ScanlineSpan>& spans) {
+	qint64 count = 0;
+	for(const ScanlineSpan& span : spans){
+		count += span.x1 - span.x0;
+	}
+	return count;
+}
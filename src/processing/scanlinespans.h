@@ -0,0 +1,26 @@
+#ifndef SCANLINESPANS_H
+#define SCANLINESPANS_H
+
+#include <QVector>
+#include <QPolygonF>
+#include <QRect>
+
+
+//horizontal run of pixels [x0, x1) in row y
+struct ScanlineSpan {
+	int y;
+	int x0;
+	int x1;
+};
+
+class ScanlineSpans
+{
+public:
+	//rasterizes a closed polygon (even-odd rule, sampled at pixel centers) and clips the spans to bounds
+	static QVector<ScanlineSpan> fromPolygon(const QPolygonF& polygon, const QRect& bounds);
+	//one span per row covering the whole rect
+	static QVector<ScanlineSpan> fromRect(const QRect& rect);
+	static qint64 pixelCount(const QVector<ScanlineSpan>& spans);
+};
+
+#endif //SCANLINESPANS_H
@@ -0,0 +1,11 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+//SSE2 is part of every x86-64 target, so the vectorized kernels are used whenever the extension is built for x86-64 (or for 32-bit x86 with SSE2 enabled).
+//on other architectures (e.g. Jetson/ARM) the scalar fallback paths are used
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CAMERAEXTENSION_SSE2
+#include <emmintrin.h>
+#endif
+
+#endif //SIMD_H
@@ -0,0 +1,97 @@
+#include "snapshotrenderer.h"
+#include <QPainter>
+
+
+SnapshotRenderer::SnapshotRenderer(QObject *parent)
+	: FrameAnalyzer(parent)
+{
+}
+
+SnapshotRenderer::~SnapshotRenderer() {
+	this->stopWorker();
+}
+
+void SnapshotRenderer::requestSnapshot(const SnapshotRequest& request) {
+	QMutexLocker locker(&this->mutex);
+	this->pendingRequests.enqueue(request);
+	this->pendingRequests.last().requestTimer.start();
+	locker.unlock();
+	this->setEnabled(true);
+}
+
+bool SnapshotRenderer::hasPendingRequests() {
+	QMutexLocker locker(&this->mutex);
+	return !this->pendingRequests.isEmpty();
+}
+
+void SnapshotRenderer::analyzeFrame(const QVideoFrame& frame) {
+	SnapshotRequest request;
+	{
+		QMutexLocker locker(&this->mutex);
+		if(this->pendingRequests.isEmpty()){
+			return;
+		}
+		request = this->pendingRequests.dequeue();
+	}
+
+	//conversion to rgb is done here and not on the gui thread, as it may be expensive for yuv, jpeg or raw frames in full resolution
+	bool success = false;
+	if(request.unprocessed){
+		QImage sensorImage = Demosaic::isRawFormat(frame.pixelFormat()) ? Demosaic::rawImage(frame) : WindowLevel::fullDepthImage(frame);
+		success = !sensorImage.isNull() && sensorImage.save(request.filePath);
+	} else {
+		QImage image;
+		if(Demosaic::isRawFormat(frame.pixelFormat())){
+			image = Demosaic::toImage(frame, request.demosaic);
+		} else if(WindowLevel::isWindowedFormat(frame.pixelFormat())){
+			image = WindowLevel::toImage(frame, request.windowLow, request.windowHigh);
+		} else {
+			image = frame.image();
+		}
+		if(!image.isNull()){
+			success = render(image, request).save(request.filePath);
+		}
+	}
+	emit snapshotSaved(request.filePath, success, request.requestTimer.elapsed());
+}
+
+QImage SnapshotRenderer::render(const QImage& frame, const SnapshotRequest& request) {
+	//the live view is undistorted before the video item mirrors and rotates it
+	QImage source = request.lens.isValid() ? LensUndistortion::undistort(frame, request.lens) : frame;
+	if(request.mirrored || request.bottomToTop){
+		source = source.mirrored(request.mirrored, request.bottomToTop);
+	}
+
+	//the output is large enough for the rotated frame, corners that are not covered by the frame stay transparent
+	QTransform rotation;
+	rotation.rotate(request.rotation);
+	QSize targetSize = rotation.mapRect(QRectF(source.rect())).toAlignedRect().size();
+	bool rotated = targetSize != source.size();
+	QImage result(targetSize, rotated ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+	result.fill(Qt::transparent);
+
+	QPainter painter(&result);
+	painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+	painter.translate(result.width()/2.0, result.height()/2.0);
+	painter.rotate(request.rotation);
+	painter.translate(-source.width()/2.0, -source.height()/2.0);
+	painter.drawImage(0, 0, source);
+
+	//overlays are painted in video item coordinates, scaled from the displayed size to the frame size. pen widths scale as well, so
+	//the overlays cover the same part of the sample as in the live view
+	if(!request.videoRect.isEmpty()){
+		painter.scale(source.width()/request.videoRect.width(), source.height()/request.videoRect.height());
+		painter.translate(-request.videoRect.topLeft());
+		for(const SnapshotOverlay& overlay : request.overlays){
+			if(!overlay.paintShape){
+				continue;
+			}
+			painter.save();
+			painter.translate(overlay.state.value("x_position").toReal(), overlay.state.value("y_position").toReal());
+			overlay.paintShape(&painter, OverlayItem::anchorPositionsFromState(overlay.state));
+			painter.restore();
+		}
+	}
+	painter.end();
+	return result;
+}
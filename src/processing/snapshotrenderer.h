@@ -0,0 +1,63 @@
+#ifndef SNAPSHOTRENDERER_H
+#define SNAPSHOTRENDERER_H
+
+#include <QMutex>
+#include <QQueue>
+#include <QImage>
+#include <QVariantMap>
+#include <QElapsedTimer>
+#include "frameanalyzer.h"
+#include "overlayitem.h"
+#include "demosaic.h"
+#include "windowlevel.h"
+#include "lensundistortion.h"
+
+
+struct SnapshotOverlay {
+	QVariantMap state; //as created by OverlayItem::saveState()
+	OverlayItem::ShapePainter paintShape;
+};
+
+//everything that is needed to reproduce the live view on a frame. captured on the gui thread, so the render task does not touch any graphics item
+struct SnapshotRequest {
+	QString filePath;
+	QRectF videoRect; //rect of the video item in which the frame is displayed, the overlay states are given in this coordinate system
+	qreal rotation = 0.0; //degrees, clockwise as displayed
+	bool mirrored = false;
+	bool bottomToTop = false;
+	QList<SnapshotOverlay> overlays;
+	DemosaicSettings demosaic; //conversion of raw frames
+	int windowLow = 0; //display window of 16 bit monochrome frames
+	int windowHigh = 65535;
+	LensModel lens; //undistortion of the live view, not applied if invalid
+	bool unprocessed = false; //raw and 16 bit monochrome frames are saved unchanged as 8 or 16 bit grayscale, without rotation and overlays
+	QElapsedTimer requestTimer; //started by requestSnapshot()
+};
+
+
+//renders "snapshot as displayed": the next frame after a request is rotated and overlaid with the visible overlays at full camera resolution.
+//rendering and png encoding run on the shared WorkStealingPool, the live view is never grabbed and not stalled
+class SnapshotRenderer : public FrameAnalyzer
+{
+	Q_OBJECT
+public:
+	explicit SnapshotRenderer(QObject *parent = nullptr);
+	~SnapshotRenderer();
+
+	void requestSnapshot(const SnapshotRequest& request);
+	bool hasPendingRequests();
+
+	static QImage render(const QImage& frame, const SnapshotRequest& request);
+
+protected:
+	void analyzeFrame(const QVideoFrame& frame) override;
+
+private:
+	QMutex mutex;
+	QQueue<SnapshotRequest> pendingRequests;
+
+signals:
+	void snapshotSaved(QString filePath, bool success, qint64 latencyMs);
+};
+
+#endif //SNAPSHOTRENDERER_H
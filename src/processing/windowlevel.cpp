@@ -0,0 +1,261 @@
+#include "windowlevel.h"
+#include "workstealingpool.h"
+#include "simd.h"
+#include <QElapsedTimer>
+#include <cstring>
+
+
+namespace {
+	//out = d*255/width for d = clamp(v - low, 0, width). d and width are shifted up until width fills 16 bits and the factor has 7 extra bits,
+	//so the result is less than one step below the exact value for every window size and reaches 255 at the top of the window
+	struct Mapping {
+		int low;
+		int width;
+		int shift;
+		int factor;
+	};
+
+	Mapping mappingOf(int low, int high) {
+		Mapping mapping;
+		mapping.low = qBound(0, low, 65534);
+		mapping.width = qBound(1, high - mapping.low, 65535 - mapping.low);
+		mapping.shift = 0;
+		while((mapping.width << (mapping.shift + 1)) <= 65535){
+			mapping.shift++;
+		}
+		const qint64 scaledWidth = static_cast<qint64>(mapping.width) << mapping.shift;
+		mapping.factor = static_cast<int>(((255LL << 23) + scaledWidth - 1)/scaledWidth);
+		return mapping;
+	}
+}
+
+
+bool WindowLevelSettings::operator==(const WindowLevelSettings& other) const {
+	return this->autoWindow == other.autoWindow
+		&& this->low == other.low
+		&& this->high == other.high
+		&& qFuzzyCompare(this->clipPercent + 1.0, other.clipPercent + 1.0)
+		&& this->fullDepthSnapshots == other.fullDepthSnapshots;
+}
+
+
+WindowLevel::WindowLevel()
+	: windowLow(0),
+	  windowHigh(65535),
+	  lastProcessingTimeUs(-1),
+	  phaseHistograms(ROW_PHASES*HISTOGRAM_BINS, 0),
+	  histogram(HISTOGRAM_BINS, 0),
+	  histogramPhase(0)
+{
+}
+
+void WindowLevel::setSettings(const WindowLevelSettings& settings) {
+	QMutexLocker locker(&this->mutex);
+	this->settings = settings;
+	if(!settings.autoWindow){
+		this->windowLow.storeRelease(settings.low);
+		this->windowHigh.storeRelease(settings.high);
+	}
+}
+
+WindowLevelSettings WindowLevel::getSettings() const {
+	QMutexLocker locker(&this->mutex);
+	return this->settings;
+}
+
+void WindowLevel::getWindow(int* low, int* high) const {
+	*low = this->windowLow.loadAcquire();
+	*high = this->windowHigh.loadAcquire();
+}
+
+QImage WindowLevel::takeOutputBuffer(const QSize& size) {
+	for(int i = 0; i < this->outputBuffers.size(); i++){
+		if(this->outputBuffers.at(i).size() == size && this->outputBuffers.at(i).isDetached()){
+			return this->outputBuffers.takeAt(i);
+		}
+	}
+	return QImage(size, QImage::Format_RGB32);
+}
+
+void WindowLevel::recycleOutputBuffer(const QImage& buffer) {
+	this->outputBuffers.append(buffer);
+	while(this->outputBuffers.size() > OUTPUT_BUFFERS){
+		this->outputBuffers.removeFirst();
+	}
+}
+
+QVideoFrame WindowLevel::process(const QVideoFrame& frame) {
+	if(!isWindowedFormat(frame.pixelFormat())){
+		return QVideoFrame();
+	}
+	WindowLevelSettings currentSettings = this->getSettings();
+	QVideoFrame mappedFrame(frame);
+	if(!mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		return QVideoFrame();
+	}
+	const int width = frame.width();
+	const int height = frame.height();
+	const int stride = mappedFrame.bytesPerLine();
+	if(stride < 2*width || mappedFrame.mappedBytes() < stride*(height - 1) + 2*width){
+		mappedFrame.unmap();
+		return QVideoFrame();
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	if(currentSettings.autoWindow){
+		this->updateHistogram(mappedFrame.bits(), stride, width, height);
+		this->updateAutoWindow(currentSettings.clipPercent);
+	}
+	int low = 0;
+	int high = 0;
+	this->getWindow(&low, &high);
+	QImage output = this->takeOutputBuffer(frame.size());
+	map(mappedFrame.bits(), stride, width, height, low, high, reinterpret_cast<quint32*>(output.bits()), output.bytesPerLine());
+	mappedFrame.unmap();
+	//the frame shares the buffer with the list, the buffer becomes reusable as soon as the display drops the frame
+	this->recycleOutputBuffer(output);
+	this->lastProcessingTimeUs.storeRelease(static_cast<int>(timer.nsecsElapsed()/1000));
+	return QVideoFrame(output);
+}
+
+void WindowLevel::updateHistogram(const uchar* bits, int stride, int width, int height) {
+	if(this->histogramFrameSize != QSize(width, height)){
+		this->histogramFrameSize = QSize(width, height);
+		this->phaseHistograms.fill(0);
+		this->histogram.fill(0);
+		this->histogramPhase = 0;
+	}
+
+	//the histogram of the oldest row set is replaced by the one of the current frame
+	quint32* phaseHistogram = this->phaseHistograms.data() + this->histogramPhase*HISTOGRAM_BINS;
+	quint32* total = this->histogram.data();
+	for(int i = 0; i < HISTOGRAM_BINS; i++){
+		total[i] -= phaseHistogram[i];
+		phaseHistogram[i] = 0;
+	}
+	for(int y = this->histogramPhase; y < height; y += ROW_PHASES){
+		const quint16* row = reinterpret_cast<const quint16*>(bits + y*stride);
+		for(int x = (y/ROW_PHASES) % COLUMN_STEP; x < width; x += COLUMN_STEP){
+			phaseHistogram[row[x] >> 4]++;
+		}
+	}
+	for(int i = 0; i < HISTOGRAM_BINS; i++){
+		total[i] += phaseHistogram[i];
+	}
+	this->histogramPhase = (this->histogramPhase + 1) % ROW_PHASES;
+}
+
+void WindowLevel::updateAutoWindow(qreal clipPercent) {
+	const quint32* total = this->histogram.constData();
+	quint64 count = 0;
+	for(int i = 0; i < HISTOGRAM_BINS; i++){
+		count += total[i];
+	}
+	if(count == 0){
+		return;
+	}
+	const quint64 clipCount = static_cast<quint64>(count*qBound(0.0, clipPercent, 49.0)/100.0);
+	int lowBin = 0;
+	quint64 sum = 0;
+	while(lowBin < HISTOGRAM_BINS - 1 && sum + total[lowBin] <= clipCount){
+		sum += total[lowBin];
+		lowBin++;
+	}
+	int highBin = HISTOGRAM_BINS - 1;
+	sum = 0;
+	while(highBin > lowBin && sum + total[highBin] <= clipCount){
+		sum += total[highBin];
+		highBin--;
+	}
+	//a bin covers 16 values, the window spans at least one bin
+	this->windowLow.storeRelease(lowBin << 4);
+	this->windowHigh.storeRelease((highBin << 4) + 15);
+}
+
+QImage WindowLevel::toImage(const QVideoFrame& frame, int low, int high) {
+	if(!isWindowedFormat(frame.pixelFormat())){
+		return QImage();
+	}
+	QVideoFrame mappedFrame(frame);
+	if(!mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		return QImage();
+	}
+	QImage image;
+	const int stride = mappedFrame.bytesPerLine();
+	if(stride >= 2*frame.width() && mappedFrame.mappedBytes() >= stride*(frame.height() - 1) + 2*frame.width()){
+		image = QImage(frame.size(), QImage::Format_RGB32);
+		map(mappedFrame.bits(), stride, frame.width(), frame.height(), low, high, reinterpret_cast<quint32*>(image.bits()), image.bytesPerLine());
+	}
+	mappedFrame.unmap();
+	return image;
+}
+
+QImage WindowLevel::fullDepthImage(const QVideoFrame& frame) {
+	if(!isWindowedFormat(frame.pixelFormat())){
+		return QImage();
+	}
+	QVideoFrame mappedFrame(frame);
+	if(!mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		return QImage();
+	}
+	QImage image;
+	const int stride = mappedFrame.bytesPerLine();
+	if(stride >= 2*frame.width() && mappedFrame.mappedBytes() >= stride*(frame.height() - 1) + 2*frame.width()){
+		image = QImage(frame.size(), QImage::Format_Grayscale16);
+		for(int y = 0; y < frame.height(); y++){
+			memcpy(image.scanLine(y), mappedFrame.bits() + y*stride, 2*frame.width());
+		}
+	}
+	mappedFrame.unmap();
+	return image;
+}
+
+void WindowLevel::map(const uchar* src, int srcStride, int width, int height, int low, int high, quint32* dst, int dstStride, bool vectorized) {
+	const Mapping mapping = mappingOf(low, high);
+	const int bands = (height + BAND_HEIGHT - 1)/BAND_HEIGHT;
+#ifndef CAMERAEXTENSION_SSE2
+	Q_UNUSED(vectorized)
+#endif
+	WorkStealingPool::globalInstance()->parallelFor(bands, [&](int band) {
+		int y1 = qMin(height, (band + 1)*BAND_HEIGHT);
+		for(int y = band*BAND_HEIGHT; y < y1; y++){
+			const quint16* in = reinterpret_cast<const quint16*>(src + y*srcStride);
+			quint32* out = reinterpret_cast<quint32*>(reinterpret_cast<uchar*>(dst) + y*dstStride);
+			int x = 0;
+#ifdef CAMERAEXTENSION_SSE2
+			if(vectorized){
+				const __m128i lowV = _mm_set1_epi16(static_cast<short>(mapping.low));
+				const __m128i widthV = _mm_set1_epi16(static_cast<short>(mapping.width));
+				const __m128i factorV = _mm_set1_epi16(static_cast<short>(mapping.factor));
+				const __m128i shiftV = _mm_cvtsi32_si128(mapping.shift);
+				const __m128i ones = _mm_cmpeq_epi8(lowV, lowV);
+				for(; x + 16 <= width; x += 16){
+					__m128i a = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x)), lowV);
+					__m128i b = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x + 8)), lowV);
+					//min(d, width) without SSE4.1
+					a = _mm_sub_epi16(a, _mm_subs_epu16(a, widthV));
+					b = _mm_sub_epi16(b, _mm_subs_epu16(b, widthV));
+					a = _mm_srli_epi16(_mm_mulhi_epu16(_mm_sll_epi16(a, shiftV), factorV), 7);
+					b = _mm_srli_epi16(_mm_mulhi_epu16(_mm_sll_epi16(b, shiftV), factorV), 7);
+					const __m128i gray = _mm_packus_epi16(a, b);
+					const __m128i ggLo = _mm_unpacklo_epi8(gray, gray);
+					const __m128i ggHi = _mm_unpackhi_epi8(gray, gray);
+					const __m128i gaLo = _mm_unpacklo_epi8(gray, ones);
+					const __m128i gaHi = _mm_unpackhi_epi8(gray, ones);
+					__m128i* target = reinterpret_cast<__m128i*>(out + x);
+					_mm_storeu_si128(target, _mm_unpacklo_epi16(ggLo, gaLo));
+					_mm_storeu_si128(target + 1, _mm_unpackhi_epi16(ggLo, gaLo));
+					_mm_storeu_si128(target + 2, _mm_unpacklo_epi16(ggHi, gaHi));
+					_mm_storeu_si128(target + 3, _mm_unpackhi_epi16(ggHi, gaHi));
+				}
+			}
+#endif
+			for(; x < width; x++){
+				int d = qBound(0, in[x] - mapping.low, mapping.width);
+				quint32 gray = static_cast<quint32>((static_cast<qint64>(d << mapping.shift)*mapping.factor) >> 23);
+				out[x] = 0xff000000u | (gray << 16) | (gray << 8) | gray;
+			}
+		}
+	});
+}
@@ -0,0 +1,76 @@
+#ifndef WINDOWLEVEL_H
+#define WINDOWLEVEL_H
+
+#include <QVideoFrame>
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QVector>
+
+
+struct WindowLevelSettings {
+	bool autoWindow = true; //window follows the histogram of the frames
+	int low = 0; //manual window, used if autoWindow is false
+	int high = 65535;
+	qreal clipPercent = 0.5; //percentage of the pixels that is allowed to saturate at each end of the automatic window
+	bool fullDepthSnapshots = true; //snapshots store the 16 bit frame instead of the 8 bit display
+
+	bool isDefault() const {return *this == WindowLevelSettings();}
+	bool operator==(const WindowLevelSettings& other) const;
+	bool operator!=(const WindowLevelSettings& other) const {return !(*this == other);}
+};
+
+//maps 16 bit monochrome frames (Format_Y16, e.g. of NIR cameras) to RGB32 for the display. the samples inside the window are stretched
+//to 0..255, the mapping is a single SSE2 pass (saturating subtract, clamp, fixed point multiply, gray replication) on row bands of the shared
+//WorkStealingPool. the automatic window is taken from percentiles of a subsampled histogram: every frame samples one of ROW_PHASES
+//interleaved row sets, so the histogram always covers the last ROW_PHASES frames and costs only a fraction of a full pass
+class WindowLevel
+{
+public:
+	WindowLevel();
+
+	//thread safe, may be called while process() runs on another thread
+	void setSettings(const WindowLevelSettings& settings);
+	WindowLevelSettings getSettings() const;
+	//window that is currently applied, the automatic one or the manual one
+	void getWindow(int* low, int* high) const;
+
+	//returns a windowed RGB32 frame, or an invalid frame if the frame is not Format_Y16
+	QVideoFrame process(const QVideoFrame& frame);
+	int getLastProcessingTimeUs() const {return this->lastProcessingTimeUs.loadAcquire();}
+
+	static bool isWindowedFormat(QVideoFrame::PixelFormat format) {return format == QVideoFrame::Format_Y16;}
+	static QImage toImage(const QVideoFrame& frame, int low, int high);
+	//lossless copy as Format_Grayscale16, e.g. to be saved as 16 bit png
+	static QImage fullDepthImage(const QVideoFrame& frame);
+
+	//the mapping kernel, public to be benchmarked
+	static void map(const uchar* src, int srcStride, int width, int height, int low, int high, quint32* dst, int dstStride, bool vectorized = true);
+
+	static const int BAND_HEIGHT = 32;
+	static const int OUTPUT_BUFFERS = 3;
+	static const int HISTOGRAM_BINS = 4096;
+	static const int ROW_PHASES = 8;
+	static const int COLUMN_STEP = 4;
+
+private:
+	mutable QMutex mutex;
+	WindowLevelSettings settings;
+	QAtomicInt windowLow;
+	QAtomicInt windowHigh;
+	QAtomicInt lastProcessingTimeUs;
+
+	//only used by the thread that calls process()
+	QList<QImage> outputBuffers;
+	QVector<quint32> phaseHistograms; //ROW_PHASES histograms of HISTOGRAM_BINS
+	QVector<quint32> histogram; //sum of the phase histograms
+	int histogramPhase;
+	QSize histogramFrameSize;
+
+	QImage takeOutputBuffer(const QSize& size);
+	void recycleOutputBuffer(const QImage& buffer);
+	void updateHistogram(const uchar* bits, int stride, int width, int height);
+	void updateAutoWindow(qreal clipPercent);
+};
+
+#endif //WINDOWLEVEL_H
@@ -0,0 +1,366 @@
+#include "workstealingpool.h"
+#include <QMutexLocker>
+#include <memory>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+	WorkStealingPool* sharedPool = nullptr;
+	QMutex sharedPoolMutex;
+}
+
+
+WorkStealingPool::WorkStealingPool(int threadCount, int maxQueuedTasks) :
+	queuedTasks(0),
+	nextWorker(0),
+	stopping(0),
+	maxQueuedTasks(qMax(1, maxQueuedTasks)),
+	priority(QThread::LowPriority),
+	priorityGeneration(0),
+	restarter(nullptr),
+	affinityGeneration(0)
+{
+	threadCount = qMax(1, threadCount);
+	for(int i = 0; i < threadCount; i++){
+		Worker* worker = new Worker(this, i);
+		worker->setObjectName(QString("CameraExtensionWorker%1").arg(i));
+		this->workers.append(worker);
+	}
+	for(Worker* worker : this->workers){
+		worker->start(this->priority);
+	}
+#ifdef __linux__
+	this->restarter = new Restarter(this);
+	this->restarter->setObjectName("CameraExtensionWorkerRestarter");
+	this->restarter->start();
+#endif
+}
+
+WorkStealingPool::~WorkStealingPool() {
+	this->stopping.storeRelease(1);
+	this->sleepMutex.lock();
+	this->wakeCondition.wakeAll();
+	this->sleepMutex.unlock();
+	//the restarter finishes pending restarts first, workers do not exit for a restart while the pool is stopping
+	if(this->restarter != nullptr){
+		this->restartMutex.lock();
+		this->restartCondition.wakeAll();
+		this->restartMutex.unlock();
+		this->restarter->wait();
+		delete this->restarter;
+		this->restarter = nullptr;
+	}
+	//workers that are still running steal from the deques of the others, so none is deleted before all have finished
+	for(Worker* worker : this->workers){
+		worker->wait();
+	}
+	qDeleteAll(this->workers);
+	this->workers.clear();
+}
+
+WorkStealingPool* WorkStealingPool::globalInstance() {
+	QMutexLocker locker(&sharedPoolMutex);
+	if(sharedPool == nullptr){
+		sharedPool = new WorkStealingPool();
+	}
+	return sharedPool;
+}
+
+void WorkStealingPool::shutdownGlobalInstance() {
+	QMutexLocker locker(&sharedPoolMutex);
+	delete sharedPool;
+	sharedPool = nullptr;
+}
+
+int WorkStealingPool::currentWorkerIndex() const {
+	QThread* current = QThread::currentThread();
+	for(int i = 0; i < this->workers.size(); i++){
+		if(this->workers.at(i) == current){
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool WorkStealingPool::trySubmit(Task task) {
+	if(this->stopping.loadAcquire()){
+		return false;
+	}
+	//reserve a queue slot first, so the limit holds even with concurrent submissions
+	if(this->queuedTasks.fetchAndAddOrdered(1) >= this->maxQueuedTasks){
+		this->queuedTasks.fetchAndAddOrdered(-1);
+		return false;
+	}
+
+	int index = this->currentWorkerIndex();
+	if(index < 0){
+		index = static_cast<int>(static_cast<unsigned int>(this->nextWorker.fetchAndAddRelaxed(1)) % this->workers.size());
+	}
+	Worker* worker = this->workers.at(index);
+	worker->mutex.lock();
+	worker->tasks.push_back(std::move(task));
+	worker->mutex.unlock();
+
+	this->sleepMutex.lock();
+	this->wakeCondition.wakeOne();
+	this->sleepMutex.unlock();
+	return true;
+}
+
+bool WorkStealingPool::takeTask(int index, Task& task) {
+	//own deque, newest first (its data is most likely still in cache)
+	Worker* own = this->workers.at(index);
+	own->mutex.lock();
+	if(!own->tasks.empty()){
+		task = std::move(own->tasks.back());
+		own->tasks.pop_back();
+		own->mutex.unlock();
+		return true;
+	}
+	own->mutex.unlock();
+
+	//steal oldest task from the other workers
+	const int count = this->workers.size();
+	for(int i = 1; i < count; i++){
+		Worker* victim = this->workers.at((index + i) % count);
+		if(!victim->mutex.tryLock()){
+			continue;
+		}
+		if(!victim->tasks.empty()){
+			task = std::move(victim->tasks.front());
+			victim->tasks.pop_front();
+			victim->mutex.unlock();
+			return true;
+		}
+		victim->mutex.unlock();
+	}
+	return false;
+}
+
+void WorkStealingPool::runWorker(int index) {
+	Task task;
+	Worker* worker = this->workers.at(index);
+	while(true){
+		if(worker->affinityGeneration != this->affinityGeneration.loadAcquire()){
+			this->applyAffinity(worker);
+		}
+		if(worker->priorityGeneration != this->priorityGeneration.loadAcquire() && !this->applyPriority(worker)){
+			//the thread is stuck on SCHED_IDLE, its queued tasks are stolen by the other workers until the new thread runs
+			QMutexLocker locker(&this->restartMutex);
+			this->workersToRestart.append(index);
+			this->restartCondition.wakeAll();
+			return;
+		}
+		if(this->takeTask(index, task)){
+			this->queuedTasks.fetchAndAddOrdered(-1);
+			task();
+			task = Task();
+			continue;
+		}
+		if(this->stopping.loadAcquire()){
+			//finish queued tasks before leaving, so nobody waits forever for an accepted task
+			if(this->queuedTasks.loadAcquire() <= 0){
+				return;
+			}
+			QThread::yieldCurrentThread();
+			continue;
+		}
+		this->sleepMutex.lock();
+		if(this->queuedTasks.loadAcquire() <= 0 && !this->stopping.loadAcquire()){
+			//the timeout covers tasks that were only reachable through a contended tryLock during stealing
+			this->wakeCondition.wait(&this->sleepMutex, 10);
+		}
+		this->sleepMutex.unlock();
+	}
+}
+
+void WorkStealingPool::parallelFor(int count, const std::function<void(int)>& body) {
+	if(count <= 0){
+		return;
+	}
+	if(count == 1){
+		body(0);
+		return;
+	}
+
+	struct SharedState {
+		QAtomicInt nextIndex;
+		QAtomicInt finished;
+		QMutex mutex;
+		QWaitCondition done;
+	};
+	std::shared_ptr<SharedState> state = std::make_shared<SharedState>();
+	state->nextIndex.storeRelaxed(0);
+	state->finished.storeRelaxed(0);
+
+	//every helper and the calling thread grab indices until none are left
+	auto work = [state, count, &body]() {
+		int i;
+		while((i = state->nextIndex.fetchAndAddOrdered(1)) < count){
+			body(i);
+			if(state->finished.fetchAndAddOrdered(1) + 1 == count){
+				QMutexLocker locker(&state->mutex);
+				state->done.wakeAll();
+			}
+		}
+	};
+
+	int helpers = qMin(count - 1, this->workers.size());
+	for(int i = 0; i < helpers; i++){
+		//helpers that start after all indices were taken return immediately. body is only accessed while indices are left, so it is still alive then
+		if(!this->trySubmit(work)){
+			break;
+		}
+	}
+	work();
+
+	QMutexLocker locker(&state->mutex);
+	while(state->finished.loadAcquire() < count){
+		state->done.wait(&state->mutex, 5);
+	}
+}
+
+void WorkStealingPool::TaskCounter::add() {
+	QMutexLocker locker(&this->mutex);
+	this->count++;
+}
+
+bool WorkStealingPool::TaskCounter::tryAdd(int maxTasks) {
+	QMutexLocker locker(&this->mutex);
+	if(this->count >= maxTasks){
+		return false;
+	}
+	this->count++;
+	return true;
+}
+
+void WorkStealingPool::TaskCounter::done() {
+	//the waiter can only return from waitForAll() after the mutex is released here, the counter is not touched afterwards
+	QMutexLocker locker(&this->mutex);
+	this->count--;
+	if(this->count == 0){
+		this->finished.wakeAll();
+	}
+}
+
+int WorkStealingPool::TaskCounter::getCount() const {
+	QMutexLocker locker(&this->mutex);
+	return this->count;
+}
+
+void WorkStealingPool::TaskCounter::waitForAll() {
+	QMutexLocker locker(&this->mutex);
+	while(this->count > 0){
+		this->finished.wait(&this->mutex);
+	}
+}
+
+void WorkStealingPool::setThreadPriority(QThread::Priority priority) {
+	QMutexLocker locker(&this->priorityMutex);
+	this->priority = priority;
+	this->priorityGeneration.fetchAndAddOrdered(1);
+	locker.unlock();
+
+	//sleeping workers apply the new priority right away
+	this->sleepMutex.lock();
+	this->wakeCondition.wakeAll();
+	this->sleepMutex.unlock();
+}
+
+bool WorkStealingPool::applyPriority(Worker* worker) {
+	QMutexLocker locker(&this->priorityMutex);
+	worker->priorityGeneration = this->priorityGeneration.loadAcquire();
+#ifdef __linux__
+	//IdlePriority switches to SCHED_IDLE. QThread::setPriority() keeps the current policy for the other priorities, which have no effect
+	//within SCHED_IDLE, so the worker has to return to SCHED_OTHER itself. this fails with EPERM if the nice limit of the process does not
+	//allow nice 0, the worker is replaced by a new thread then (the pool does not stop while a worker exits)
+	if(this->priority != QThread::IdlePriority && sched_getscheduler(0) == SCHED_IDLE){
+		sched_param param;
+		param.sched_priority = 0;
+		if(pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) != 0 && !this->stopping.loadAcquire()){
+			return false;
+		}
+	}
+#endif
+	worker->setPriority(this->priority);
+	return true;
+}
+
+void WorkStealingPool::runRestarter() {
+	QMutexLocker locker(&this->restartMutex);
+	while(true){
+		if(this->workersToRestart.isEmpty()){
+			if(this->stopping.loadAcquire()){
+				return;
+			}
+			this->restartCondition.wait(&this->restartMutex);
+			continue;
+		}
+		Worker* worker = this->workers.at(this->workersToRestart.takeFirst());
+		locker.unlock();
+		//the worker exits right after it requested the restart. the new thread is created by this SCHED_OTHER thread with the current
+		//priority and applies the affinity again
+		worker->wait();
+		this->priorityMutex.lock();
+		worker->priorityGeneration = this->priorityGeneration.loadAcquire();
+		QThread::Priority priority = this->priority;
+		this->priorityMutex.unlock();
+		worker->affinityGeneration = -1;
+		worker->start(priority);
+		locker.relock();
+	}
+}
+
+bool WorkStealingPool::isAffinitySupported() {
+#ifdef __linux__
+	return true;
+#else
+	return false;
+#endif
+}
+
+void WorkStealingPool::setExcludedCores(const QList<int>& cores) {
+	QMutexLocker locker(&this->affinityMutex);
+	if(this->excludedCores == cores){
+		return;
+	}
+	this->excludedCores = cores;
+	this->affinityGeneration.fetchAndAddOrdered(1);
+	locker.unlock();
+
+	//sleeping workers apply the new affinity right away
+	this->sleepMutex.lock();
+	this->wakeCondition.wakeAll();
+	this->sleepMutex.unlock();
+}
+
+QList<int> WorkStealingPool::getExcludedCores() {
+	QMutexLocker locker(&this->affinityMutex);
+	return this->excludedCores;
+}
+
+void WorkStealingPool::applyAffinity(Worker* worker) {
+	QMutexLocker locker(&this->affinityMutex);
+	worker->affinityGeneration = this->affinityGeneration.loadAcquire();
+#ifdef __linux__
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	long coreCount = qBound(1L, sysconf(_SC_NPROCESSORS_ONLN), static_cast<long>(CPU_SETSIZE));
+	for(int core = 0; core < coreCount; core++){
+		if(!this->excludedCores.contains(core)){
+			CPU_SET(core, &cpuSet);
+		}
+	}
+	//excluding every core would stall the pool, all cores are allowed in this case
+	if(CPU_COUNT(&cpuSet) == 0){
+		for(int core = 0; core < coreCount; core++){
+			CPU_SET(core, &cpuSet);
+		}
+	}
+	pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+}
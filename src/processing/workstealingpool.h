@@ -0,0 +1,121 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QVector>
+#include <QList>
+#include <deque>
+#include <functional>
+
+
+//bounded thread pool shared by all camera views. every worker owns a task deque; new tasks are distributed round robin (or pushed to the own deque
+//when submitted from a worker), a worker pops from the back of its own deque and steals from the front of the other deques when it runs dry.
+//the total number of queued tasks is limited, trySubmit() rejects tasks instead of blocking, so per-frame work is dropped rather than queued up
+class WorkStealingPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	//counts the tasks a stage has submitted and that have not finished yet, so the stage can wait for them before it is destroyed.
+	//add() before trySubmit() (and done() if the task was rejected), done() as the last statement of the task
+	class TaskCounter {
+	public:
+		TaskCounter() : count(0) {}
+		void add();
+		//adds a task only if fewer than maxTasks are running, e.g. 1 to drop work while the previous task is busy
+		bool tryAdd(int maxTasks);
+		void done();
+		int getCount() const;
+		//blocks on a wait condition until every added task called done()
+		void waitForAll();
+	private:
+		mutable QMutex mutex;
+		QWaitCondition finished;
+		int count;
+	};
+
+	explicit WorkStealingPool(int threadCount = QThread::idealThreadCount(), int maxQueuedTasks = 64);
+	~WorkStealingPool();
+
+	//shared instance used by all analysis and processing stages. created on first use, destroyed by shutdownGlobalInstance()
+	static WorkStealingPool* globalInstance();
+	static void shutdownGlobalInstance();
+
+	int getThreadCount() const {return this->workers.size();}
+	int getQueuedTaskCount() const {return this->queuedTasks.loadAcquire();}
+
+	//returns false if the queue limit is reached or the pool is shutting down, the task is not executed in this case
+	bool trySubmit(Task task);
+
+	//runs body(0) ... body(count-1) in parallel and returns when all calls have finished. the calling thread takes part in the work,
+	//so parallelFor also works (serially) when the pool is saturated and may be called from within pool tasks
+	void parallelFor(int count, const std::function<void(int)>& body);
+
+	//applied by every worker to itself before its next task, like the affinity. on linux leaving IdlePriority puts the workers back on
+	//SCHED_OTHER first, QThread::setPriority() keeps a thread on SCHED_IDLE otherwise. without CAP_SYS_NICE or a sufficient RLIMIT_NICE a
+	//thread can not leave SCHED_IDLE at all, such a worker exits after its current task and is started again as a new thread
+	void setThreadPriority(QThread::Priority priority);
+	QThread::Priority getThreadPriority() const {return this->priority;}
+
+	//keeps the workers off the given cpu cores (e.g. cores used by OCT processing), an empty list allows all cores.
+	//applied by every worker to itself before its next task. only supported on linux
+	void setExcludedCores(const QList<int>& cores);
+	QList<int> getExcludedCores();
+	static bool isAffinitySupported();
+
+private:
+	class Worker : public QThread {
+	public:
+		Worker(WorkStealingPool* pool, int index) : pool(pool), index(index), affinityGeneration(0), priorityGeneration(0) {}
+		QMutex mutex;
+		std::deque<Task> tasks;
+		int affinityGeneration;
+		int priorityGeneration;
+	protected:
+		void run() override {this->pool->runWorker(this->index);}
+	private:
+		WorkStealingPool* pool;
+		int index;
+	};
+
+	//starts workers that exited to leave SCHED_IDLE as new threads. runs on SCHED_OTHER, threads created by a SCHED_IDLE thread would
+	//inherit its policy
+	class Restarter : public QThread {
+	public:
+		explicit Restarter(WorkStealingPool* pool) : pool(pool) {}
+	protected:
+		void run() override {this->pool->runRestarter();}
+	private:
+		WorkStealingPool* pool;
+	};
+
+	QVector<Worker*> workers;
+	QMutex sleepMutex;
+	QWaitCondition wakeCondition;
+	QAtomicInt queuedTasks;
+	QAtomicInt nextWorker;
+	QAtomicInt stopping;
+	int maxQueuedTasks;
+	QThread::Priority priority;
+	QMutex priorityMutex;
+	QAtomicInt priorityGeneration;
+	Restarter* restarter;
+	QMutex restartMutex;
+	QWaitCondition restartCondition;
+	QList<int> workersToRestart;
+	QMutex affinityMutex;
+	QList<int> excludedCores;
+	QAtomicInt affinityGeneration;
+
+	void runWorker(int index);
+	void runRestarter();
+	void applyAffinity(Worker* worker);
+	bool applyPriority(Worker* worker);
+	bool takeTask(int index, Task& task);
+	int currentWorkerIndex() const;
+};
+
+#endif //WORKSTEALINGPOOL_H
@@ -0,0 +1,306 @@
+#include "framerecorder.h"
+#include <QDateTime>
+#include <cstring>
+
+//chunks are large enough for efficient sequential writes, but are closed at least once per second so recordings with a low frame rate reach the disk
+#define CHUNK_TARGET_SIZE (16*1024*1024)
+#define MAX_FRAMES_PER_CHUNK 64
+#define MAX_CHUNK_DURATION_MS 1000
+#define MAX_BACKLOG_BYTES (512LL*1024LL*1024LL)
+//frames waiting for the copy task keep their camera buffers, more are dropped
+#define MAX_PENDING_FRAMES 8
+//minimum number of chunks between two changes of the compression level, so the effect of a change can show up in the backlog
+#define LEVEL_CHANGE_INTERVAL 8
+
+
+FrameRecorder::FrameRecorder(QObject *parent)
+	: QObject(parent),
+	  recording(false),
+	  pixelFormat(QVideoFrame::Format_Invalid),
+	  sequenceNumber(0),
+	  framesRecorded(0),
+	  framesDropped(0),
+	  compressionEnabled(false),
+	  compressionLevel(RecordingCodec::DEFAULT_LEVEL),
+	  chunksSinceLevelChange(0),
+	  chunksRejected(0),
+	  copyTaskQueued(false)
+{
+}
+
+FrameRecorder::~FrameRecorder() {
+	this->stop();
+	//wait until the last recordings are finalized, otherwise their index would have to be rebuilt when the files are opened
+	for(QPointer<RecordingWriter> finishingWriter : this->finishingWriters){
+		if(finishingWriter){
+			finishingWriter->wait();
+		}
+	}
+}
+
+RecordingStatistics FrameRecorder::getStatistics() {
+	if(!this->recording){
+		return this->lastStatistics;
+	}
+	QMutexLocker locker(&this->chunkMutex);
+	RecordingStatistics statistics;
+	statistics.recording = true;
+	statistics.filePath = this->filePath;
+	statistics.framesRecorded = this->framesRecorded;
+	statistics.framesDropped = this->framesDropped;
+	statistics.durationMs = this->recordingTimer.isValid() ? this->recordingTimer.elapsed() : 0;
+	if(this->writer){
+		statistics.chunksWritten = this->writer->getChunksWritten();
+		statistics.bytesWritten = this->writer->getBytesWritten();
+		statistics.backlogBytes = this->writer->getBacklogBytes() + this->currentChunk.payload.size();
+		statistics.backlogChunks = this->writer->getBacklogChunks();
+		statistics.writeRate = this->writer->getWriteRate();
+		statistics.encodingBacklogBytes = this->writer->getEncodingBacklogBytes();
+		statistics.codec = this->writer->getCodecStatistics();
+		if(statistics.bytesWritten > 0){
+			statistics.compressionRatio = static_cast<double>(this->writer->getRawBytesWritten())/statistics.bytesWritten;
+		}
+	}
+	statistics.compressionEnabled = this->compressionEnabled;
+	statistics.compressionLevel = this->compressionEnabled ? this->compressionLevel : 0;
+	this->lastStatistics = statistics;
+	return statistics;
+}
+
+void FrameRecorder::start(const QString& filePath) {
+	if(this->recording){
+		return;
+	}
+	this->filePath = filePath;
+	this->pixelFormat = QVideoFrame::Format_Invalid;
+	this->frameSize = QSize();
+	this->sequenceNumber = 0;
+	this->framesRecorded = 0;
+	this->framesDropped = 0;
+	this->recordingTimer.invalidate();
+	this->compressionLevel = RecordingCodec::DEFAULT_LEVEL;
+	this->chunksSinceLevelChange = 0;
+	this->chunksRejected = 0;
+	this->recording = true;
+	emit recordingStateChanged(true);
+}
+
+void FrameRecorder::stop() {
+	if(!this->recording){
+		return;
+	}
+	//frames the pool did not accept a copy task for are copied here, so the statistics and the recording include every accepted frame
+	this->copyTasks.waitForAll();
+	this->copyPendingFrames();
+	this->getStatistics();
+	this->lastStatistics.recording = false;
+	this->recording = false;
+	if(this->writer){
+		this->flushChunk();
+		//the writer finalizes the file in the background and deletes itself afterwards
+		this->writer->finish();
+		this->finishingWriters.append(this->writer);
+		this->writer = nullptr;
+	}
+	emit recordingStateChanged(false);
+}
+
+bool FrameRecorder::openWriter(const QVideoFrame& frame) {
+	RecordingFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.width = static_cast<quint32>(frame.width());
+	header.height = static_cast<quint32>(frame.height());
+	header.pixelFormat = frame.pixelFormat();
+	header.bytesPerLine = static_cast<quint32>(frame.bytesPerLine());
+	header.startTime = QDateTime::currentMSecsSinceEpoch();
+
+	RecordingWriter* newWriter = new RecordingWriter();
+	if(!newWriter->open(this->filePath, header)){
+		delete newWriter;
+		return false;
+	}
+	connect(newWriter, &RecordingWriter::writeError, this, &FrameRecorder::error);
+	connect(newWriter, &RecordingWriter::writeError, this, &FrameRecorder::stop);
+	connect(newWriter, &RecordingWriter::recordingFinished, this, [this](QString filePath) {
+		this->finishingWriters.removeAll(QPointer<RecordingWriter>());
+		emit info(tr("Recording saved to ") + filePath);
+	});
+	connect(newWriter, &QThread::finished, newWriter, &QObject::deleteLater);
+	newWriter->start(QThread::HighPriority);
+	this->writer = newWriter;
+
+	this->pixelFormat = frame.pixelFormat();
+	this->frameSize = frame.size();
+	this->recordingTimer.start();
+	this->chunkTimer.start();
+	return true;
+}
+
+void FrameRecorder::submitFrame(const QVideoFrame& frame) {
+	if(!this->recording || !frame.isValid()){
+		return;
+	}
+	if(!this->writer){
+		if(!this->openWriter(frame)){
+			emit error(tr("Could not create recording file ") + this->filePath);
+			this->stop();
+			return;
+		}
+	} else if(frame.pixelFormat() != this->pixelFormat || frame.size() != this->frameSize){
+		//the container stores a single frame format
+		emit error(tr("Camera format changed, recording stopped."));
+		this->stop();
+		return;
+	}
+
+	//the frame is only referenced here, mapping and copying it is left to the copy task
+	PendingFrame pendingFrame;
+	pendingFrame.frame = frame;
+	pendingFrame.sequenceNumber = this->sequenceNumber++;
+	pendingFrame.timestamp = this->recordingTimer.nsecsElapsed()/1000;
+	{
+		QMutexLocker locker(&this->pendingMutex);
+		if(this->pendingFrames.size() >= MAX_PENDING_FRAMES){
+			locker.unlock();
+			QMutexLocker chunkLocker(&this->chunkMutex);
+			this->framesDropped++;
+			return;
+		}
+		this->pendingFrames.enqueue(pendingFrame);
+		if(this->copyTaskQueued){
+			return;
+		}
+		this->copyTaskQueued = true;
+	}
+	this->submitCopyTask();
+}
+
+void FrameRecorder::submitCopyTask() {
+	this->copyTasks.add();
+	bool accepted = WorkStealingPool::globalInstance()->trySubmit([this]() {
+		this->copyPendingFrames();
+		this->copyTasks.done();
+	});
+	if(!accepted){
+		//the frames stay queued, the next frame submits a new task. a saturated pool drops frames once MAX_PENDING_FRAMES are queued
+		this->copyTasks.done();
+		QMutexLocker locker(&this->pendingMutex);
+		this->copyTaskQueued = false;
+	}
+}
+
+void FrameRecorder::copyPendingFrames() {
+	forever {
+		PendingFrame pendingFrame;
+		{
+			QMutexLocker locker(&this->pendingMutex);
+			if(this->pendingFrames.isEmpty()){
+				this->copyTaskQueued = false;
+				return;
+			}
+			pendingFrame = this->pendingFrames.dequeue();
+		}
+		this->appendFrame(pendingFrame);
+	}
+}
+
+void FrameRecorder::appendFrame(const PendingFrame& pendingFrame) {
+	QMutexLocker locker(&this->chunkMutex);
+	if(!this->writer){
+		return;
+	}
+	QVideoFrame mappedFrame(pendingFrame.frame);
+	if(!mappedFrame.map(QAbstractVideoBuffer::ReadOnly)){
+		this->framesDropped++;
+		return;
+	}
+	int frameBytes = mappedFrame.mappedBytes();
+	if(this->writer->getBacklogBytes() + this->currentChunk.payload.size() + frameBytes > MAX_BACKLOG_BYTES){
+		mappedFrame.unmap();
+		this->framesDropped++;
+		return;
+	}
+
+	if(this->currentChunk.payload.capacity() == 0){
+		this->currentChunk.payload = this->writer->takeRecycledBuffer();
+		this->currentChunk.payload.reserve(qMax(CHUNK_TARGET_SIZE, frameBytes));
+	}
+	RecordingFrameEntry entry;
+	entry.sequenceNumber = pendingFrame.sequenceNumber;
+	entry.timestamp = pendingFrame.timestamp;
+	entry.offset = static_cast<quint64>(this->currentChunk.payload.size());
+	entry.size = static_cast<quint32>(frameBytes);
+	entry.chunk = 0;
+	this->currentChunk.payload.append(reinterpret_cast<const char*>(mappedFrame.bits()), frameBytes);
+	this->currentChunk.frames.append(entry);
+	mappedFrame.unmap();
+	this->framesRecorded++;
+
+	if(this->currentChunk.payload.size() >= CHUNK_TARGET_SIZE || this->currentChunk.frames.size() >= MAX_FRAMES_PER_CHUNK || this->chunkTimer.elapsed() >= MAX_CHUNK_DURATION_MS){
+		this->flushChunk();
+	}
+}
+
+void FrameRecorder::setCompressionEnabled(bool enabled) {
+	this->compressionEnabled = enabled;
+}
+
+void FrameRecorder::flushChunk() {
+	if(this->currentChunk.frames.isEmpty()){
+		return;
+	}
+	this->currentChunk.codec = RecordingFormat::RAW;
+	this->currentChunk.rawSize = static_cast<quint64>(this->currentChunk.payload.size());
+	this->adaptCompressionLevel();
+
+	if(this->compressionEnabled && this->compressionLevel > 0){
+		QSharedPointer<RecordingChunk> pendingChunk = this->writer->enqueuePending(this->currentChunk);
+		RecordingWriter* chunkWriter = this->writer;
+		int pixelFormat = this->pixelFormat;
+		int level = this->compressionLevel;
+		//the writer does not finish before all pending chunks are completed, so it outlives the task
+		bool accepted = WorkStealingPool::globalInstance()->trySubmit([chunkWriter, pendingChunk, pixelFormat, level]() {
+			QElapsedTimer timer;
+			timer.start();
+			QByteArray encodedPayload;
+			quint32 codec = RecordingFormat::RAW;
+			if(!RecordingCodec::encodeChunk(pendingChunk->payload, pendingChunk->frames.constData(), pendingChunk->frames.size(), pixelFormat, level, &encodedPayload, &codec)){
+				codec = RecordingFormat::RAW;
+			}
+			chunkWriter->completeChunk(pendingChunk, encodedPayload, codec, timer.nsecsElapsed());
+		});
+		if(!accepted){
+			//pool is saturated, the chunk is stored uncompressed rather than delayed
+			this->writer->completeChunk(pendingChunk, QByteArray(), RecordingFormat::RAW, 0);
+			this->chunksRejected++;
+		}
+	} else {
+		this->writer->enqueue(this->currentChunk);
+	}
+	this->currentChunk = RecordingChunk();
+	this->chunkTimer.start();
+}
+
+void FrameRecorder::adaptCompressionLevel() {
+	if(!this->compressionEnabled || ++this->chunksSinceLevelChange < LEVEL_CHANGE_INTERVAL){
+		return;
+	}
+	qint64 encodingBacklog = this->writer->getEncodingBacklogBytes();
+	qint64 writeBacklog = this->writer->getBacklogBytes() - encodingBacklog;
+	int level = this->compressionLevel;
+	//chunks rejected by a saturated pool are stored uncompressed and grow the write backlog. raising the level then would only make the
+	//encoder fall further behind, so the encoder is checked first and the write backlog counts only while the encoder keeps up
+	if(encodingBacklog > MAX_BACKLOG_BYTES/4 || this->chunksRejected > 0){
+		level--; //encoder can not keep up, level 0 stores chunks uncompressed
+	} else if(writeBacklog > MAX_BACKLOG_BYTES/4){
+		level++; //disk can not keep up, spend more cpu time to write less data
+	} else if(encodingBacklog + writeBacklog < MAX_BACKLOG_BYTES/32 && level < RecordingCodec::DEFAULT_LEVEL){
+		level++; //both caught up again
+	}
+	level = qBound(0, level, RecordingCodec::MAX_LEVEL);
+	if(level != this->compressionLevel){
+		this->compressionLevel = level;
+		this->chunksSinceLevelChange = 0;
+		this->chunksRejected = 0;
+	}
+}
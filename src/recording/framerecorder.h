@@ -0,0 +1,103 @@
+#ifndef FRAMERECORDER_H
+#define FRAMERECORDER_H
+
+#include <QObject>
+#include <QVideoFrame>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QMutex>
+#include <QQueue>
+#include "recordingwriter.h"
+#include "recordingcodec.h"
+#include "workstealingpool.h"
+
+
+struct RecordingStatistics {
+	bool recording = false;
+	QString filePath;
+	quint64 framesRecorded = 0;
+	quint64 framesDropped = 0;
+	quint64 chunksWritten = 0;
+	quint64 bytesWritten = 0;
+	qint64 backlogBytes = 0;
+	int backlogChunks = 0;
+	double writeRate = 0.0; //MB/s
+	qint64 durationMs = 0;
+	bool compressionEnabled = false;
+	int compressionLevel = 0;
+	qint64 encodingBacklogBytes = 0;
+	double compressionRatio = 1.0; //raw bytes / written bytes of the whole recording
+	RecordingCodecStatistics codec;
+};
+
+
+//records the camera frames unchanged into a chunked recording container (see recordingformat.h). the gui thread only queues the frames, a copy
+//task on the shared WorkStealingPool copies them in order into the current chunk, complete chunks are written by a RecordingWriter thread.
+//if the writer backlog exceeds MAX_BACKLOG_BYTES or too many frames wait for the copy task, frames are dropped and counted instead of growing
+//the memory usage without limit.
+//with compression enabled every chunk is encoded by RecordingCodec on the pool as well. the level follows the backlog: it is lowered if the
+//encoder falls behind or the pool rejects chunks, and raised only if the disk falls behind while the encoder keeps up
+class FrameRecorder : public QObject
+{
+	Q_OBJECT
+public:
+	explicit FrameRecorder(QObject *parent = nullptr);
+	~FrameRecorder();
+
+	bool isRecording() const {return this->recording;}
+	bool isCompressionEnabled() const {return this->compressionEnabled;}
+	RecordingStatistics getStatistics();
+
+public slots:
+	//the file is created with the first frame, as the header needs the frame format
+	void start(const QString& filePath);
+	void stop();
+	void submitFrame(const QVideoFrame& frame);
+	void setCompressionEnabled(bool enabled);
+
+private:
+	bool recording;
+	QString filePath;
+	QPointer<RecordingWriter> writer;
+	QList<QPointer<RecordingWriter>> finishingWriters;
+	RecordingChunk currentChunk;
+	QElapsedTimer recordingTimer;
+	QElapsedTimer chunkTimer;
+	QVideoFrame::PixelFormat pixelFormat;
+	QSize frameSize;
+	quint64 sequenceNumber;
+	quint64 framesRecorded;
+	quint64 framesDropped;
+	RecordingStatistics lastStatistics;
+	bool compressionEnabled;
+	int compressionLevel;
+	int chunksSinceLevelChange;
+	int chunksRejected; //chunks stored uncompressed since the last level change because the pool was saturated
+
+	//frames waiting for the copy task. at most one copy task runs, so the frames reach the chunk in recording order
+	struct PendingFrame {
+		QVideoFrame frame;
+		quint64 sequenceNumber;
+		qint64 timestamp;
+	};
+	QMutex pendingMutex;
+	QQueue<PendingFrame> pendingFrames;
+	bool copyTaskQueued;
+	//guards the current chunk, the counters and the compression level, which are updated by the copy task
+	QMutex chunkMutex;
+	WorkStealingPool::TaskCounter copyTasks;
+
+	bool openWriter(const QVideoFrame& frame);
+	void submitCopyTask();
+	void copyPendingFrames();
+	void appendFrame(const PendingFrame& pendingFrame);
+	void flushChunk();
+	void adaptCompressionLevel();
+
+signals:
+	void info(QString);
+	void error(QString);
+	void recordingStateChanged(bool recording);
+};
+
+#endif //FRAMERECORDER_H
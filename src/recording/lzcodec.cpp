@@ -0,0 +1,256 @@
+#include "lzcodec.h"
+#include <QVector>
+#include <cstring>
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5 //the last bytes of a block are always literals
+#define MF_LIMIT 12 //no match may start within the last MF_LIMIT bytes
+#define HASH_BITS 16
+#define WINDOW_SIZE 65536
+#define MAX_DISTANCE 65535
+
+
+namespace {
+	inline quint32 read32(const quint8* p) {
+		quint32 value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline quint64 read64(const quint8* p) {
+		quint64 value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline quint32 hashSequence(quint32 sequence) {
+		return (sequence*2654435761U) >> (32 - HASH_BITS);
+	}
+
+	inline int countTrailingZeroBytes(quint64 value) {
+#if defined(__GNUC__)
+		return __builtin_ctzll(value) >> 3;
+#else
+		int count = 0;
+		while((value & 0xff) == 0){
+			value >>= 8;
+			count++;
+		}
+		return count;
+#endif
+	}
+
+	//number of equal bytes of a and b, a does not pass limit
+	inline int countCommonBytes(const quint8* a, const quint8* b, const quint8* limit) {
+		const quint8* start = a;
+		while(a + 8 <= limit){
+			quint64 diff = read64(a) ^ read64(b);
+			if(diff != 0){
+				return static_cast<int>(a - start) + countTrailingZeroBytes(diff);
+			}
+			a += 8;
+			b += 8;
+		}
+		while(a < limit && *a == *b){
+			a++;
+			b++;
+		}
+		return static_cast<int>(a - start);
+	}
+
+	inline quint8* writeLength(quint8* op, int length) {
+		//lengths of 15 and more continue in extra bytes
+		length -= 15;
+		while(length >= 255){
+			*op++ = 255;
+			length -= 255;
+		}
+		*op++ = static_cast<quint8>(length);
+		return op;
+	}
+
+	inline quint8* writeLiterals(quint8* op, quint8* token, const quint8* literals, int length) {
+		if(length >= 15){
+			*token = 15 << 4;
+			op = writeLength(op, length);
+		} else {
+			*token = static_cast<quint8>(length << 4);
+		}
+		memcpy(op, literals, static_cast<size_t>(length));
+		return op + length;
+	}
+
+	//adds the extra length bytes to length. fails as soon as length would exceed limit (the bytes left in the input or output), so a corrupt
+	//run of 255 bytes ends early and can not overflow length
+	inline bool readLength(const quint8*& ip, const quint8* end, int& length, int limit) {
+		int extra;
+		do {
+			if(ip >= end){
+				return false;
+			}
+			extra = *ip++;
+			if(extra > limit - length){
+				return false;
+			}
+			length += extra;
+		} while(extra == 255);
+		return true;
+	}
+}
+
+
+int LzCodec::compress(const quint8* src, int srcSize, quint8* dst, int dstCapacity, int level) {
+	if(srcSize < 0 || dstCapacity < maxCompressedSize(srcSize)){
+		return -1;
+	}
+	const quint8* ip = src;
+	const quint8* anchor = src;
+	const quint8* end = src + srcSize;
+	quint8* op = dst;
+
+	if(srcSize > MF_LIMIT){
+		const quint8* matchLimit = end - LAST_LITERALS;
+		const quint8* mfLimit = end - MF_LIMIT;
+		const int searchDepth = level >= 3 ? 8 : 1;
+		const int skipShift = level <= 1 ? 3 : 6;
+		QVector<qint32> hashTableBuffer(1 << HASH_BITS, -1);
+		QVector<qint32> chainBuffer;
+		if(searchDepth > 1){
+			chainBuffer.fill(-1, WINDOW_SIZE);
+		}
+		//raw pointers avoid the detach check of QVector::operator[] in the inner loop
+		qint32* hashTable = hashTableBuffer.data();
+		qint32* chain = chainBuffer.data();
+
+		while(ip < mfLimit){
+			//search the next match. after every miss the step size grows slowly, so incompressible data is skipped quickly
+			const quint8* match = nullptr;
+			int matchLength = 0;
+			int misses = 0;
+			while(ip < mfLimit){
+				quint32 sequence = read32(ip);
+				quint32 hash = hashSequence(sequence);
+				qint32 pos = static_cast<qint32>(ip - src);
+				qint32 candidate = hashTable[hash];
+				hashTable[hash] = pos;
+				if(searchDepth > 1){
+					chain[pos & (WINDOW_SIZE - 1)] = candidate;
+				}
+				for(int depth = 0; depth < searchDepth && candidate >= 0 && pos - candidate <= MAX_DISTANCE; depth++){
+					const quint8* candidatePtr = src + candidate;
+					if(read32(candidatePtr) == sequence){
+						int length = MIN_MATCH + countCommonBytes(ip + MIN_MATCH, candidatePtr + MIN_MATCH, matchLimit);
+						if(length > matchLength){
+							matchLength = length;
+							match = candidatePtr;
+						}
+					}
+					if(searchDepth == 1){
+						break;
+					}
+					qint32 next = chain[candidate & (WINDOW_SIZE - 1)];
+					if(next >= candidate){
+						break; //chain entry was overwritten by a newer position
+					}
+					candidate = next;
+				}
+				if(matchLength >= MIN_MATCH){
+					break;
+				}
+				misses++;
+				ip += 1 + (misses >> skipShift);
+			}
+			if(matchLength < MIN_MATCH){
+				break;
+			}
+
+			//extend the match backwards into the pending literals
+			while(ip > anchor && match > src && ip[-1] == match[-1]){
+				ip--;
+				match--;
+				matchLength++;
+			}
+
+			quint8* token = op++;
+			op = writeLiterals(op, token, anchor, static_cast<int>(ip - anchor));
+			int offset = static_cast<int>(ip - match);
+			*op++ = static_cast<quint8>(offset & 0xff);
+			*op++ = static_cast<quint8>(offset >> 8);
+			int lengthCode = matchLength - MIN_MATCH;
+			if(lengthCode >= 15){
+				*token |= 15;
+				op = writeLength(op, lengthCode);
+			} else {
+				*token |= static_cast<quint8>(lengthCode);
+			}
+			ip += matchLength;
+			anchor = ip;
+
+			//a position inside the match is added to the hash table, this helps with repetitive data such as flat image regions
+			if(ip < mfLimit){
+				qint32 pos = static_cast<qint32>(ip - 2 - src);
+				quint32 hash = hashSequence(read32(src + pos));
+				if(searchDepth > 1){
+					chain[pos & (WINDOW_SIZE - 1)] = hashTable[hash];
+				}
+				hashTable[hash] = pos;
+			}
+		}
+	}
+
+	//last sequence only contains literals
+	quint8* token = op++;
+	op = writeLiterals(op, token, anchor, static_cast<int>(end - anchor));
+	return static_cast<int>(op - dst);
+}
+
+int LzCodec::decompress(const quint8* src, int srcSize, quint8* dst, int dstCapacity) {
+	const quint8* ip = src;
+	const quint8* end = src + srcSize;
+	quint8* op = dst;
+	quint8* outEnd = dst + dstCapacity;
+
+	while(ip < end){
+		int token = *ip++;
+		int literalLength = token >> 4;
+		if(literalLength == 15 && !readLength(ip, end, literalLength, static_cast<int>(qMin(end - ip, outEnd - op)))){
+			return -1;
+		}
+		if(literalLength > end - ip || literalLength > outEnd - op){
+			return -1;
+		}
+		memcpy(op, ip, static_cast<size_t>(literalLength));
+		op += literalLength;
+		ip += literalLength;
+		if(ip >= end){
+			break;
+		}
+
+		if(end - ip < 2){
+			return -1;
+		}
+		int offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if(offset == 0 || offset > op - dst){
+			return -1;
+		}
+		int matchLength = token & 15;
+		if(matchLength == 15 && !readLength(ip, end, matchLength, static_cast<int>(outEnd - op) - MIN_MATCH)){
+			return -1;
+		}
+		matchLength += MIN_MATCH;
+		if(matchLength > outEnd - op){
+			return -1;
+		}
+
+		//overlapping matches (offset < length) repeat the last bytes, the copied block doubles in every step
+		const quint8* match = op - offset;
+		quint8* matchEnd = op + matchLength;
+		while(op < matchEnd){
+			int count = qMin(static_cast<int>(matchEnd - op), static_cast<int>(op - match));
+			memcpy(op, match, static_cast<size_t>(count));
+			op += count;
+		}
+	}
+	return static_cast<int>(op - dst);
+}
@@ -0,0 +1,21 @@
+#ifndef LZCODEC_H
+#define LZCODEC_H
+
+#include <QtGlobal>
+
+
+//fast lossless LZ77 codec that writes the LZ4 block format (token, literals, 16 bit offset, match length).
+//level 1 uses a single hash probe and skips faster over incompressible data, level 2 is the default, level 3 additionally follows a hash chain
+//for longer matches. the decoder checks all lengths and offsets and never reads or writes outside of the given buffers
+class LzCodec
+{
+public:
+	static int maxCompressedSize(int size) {return size + size/255 + 16;}
+
+	//returns the number of bytes written to dst or -1 if dstCapacity is smaller than maxCompressedSize(srcSize)
+	static int compress(const quint8* src, int srcSize, quint8* dst, int dstCapacity, int level);
+	//returns the number of decoded bytes or -1 if the input is corrupt or does not fit into dst
+	static int decompress(const quint8* src, int srcSize, quint8* dst, int dstCapacity);
+};
+
+#endif //LZCODEC_H
@@ -0,0 +1,394 @@
+#include "playbacksource.h"
+#include <QAbstractVideoBuffer>
+#include <QVideoSurfaceFormat>
+#include <QVideoFrame>
+#include <QtMath>
+
+
+//video buffer that references frame data in the file map (uncompressed chunks) or in a decoded chunk. the reader and the chunk payload are
+//shared with the buffer, so the data stays valid as long as any stage still holds the frame, even if playback was closed in the meantime
+class PlaybackVideoBuffer : public QAbstractVideoBuffer
+{
+public:
+	PlaybackVideoBuffer(QSharedPointer<RecordingReader> reader, const QByteArray& payload, const uchar* data, int size, int bytesPerLine)
+		: QAbstractVideoBuffer(QAbstractVideoBuffer::NoHandle),
+		  reader(reader),
+		  payload(payload),
+		  data(data),
+		  size(size),
+		  lineBytes(bytesPerLine),
+		  mode(QAbstractVideoBuffer::NotMapped)
+	{
+	}
+
+	MapMode mapMode() const override {return this->mode;}
+
+	uchar* map(MapMode mode, int* numBytes, int* bytesPerLine) override {
+		//the data is shared with the file map and the chunk cache and must not be modified
+		if(mode != QAbstractVideoBuffer::ReadOnly || this->mode != QAbstractVideoBuffer::NotMapped){
+			return nullptr;
+		}
+		this->mode = mode;
+		if(numBytes != nullptr){
+			*numBytes = this->size;
+		}
+		if(bytesPerLine != nullptr){
+			*bytesPerLine = this->lineBytes;
+		}
+		return const_cast<uchar*>(this->data);
+	}
+
+	void unmap() override {
+		this->mode = QAbstractVideoBuffer::NotMapped;
+	}
+
+private:
+	QSharedPointer<RecordingReader> reader;
+	QByteArray payload;
+	const uchar* data;
+	int size;
+	int lineBytes;
+	MapMode mode;
+};
+
+
+PlaybackSource::PlaybackSource(QAbstractVideoSurface* surface, QObject *parent)
+	: QObject(parent),
+	  surface(surface),
+	  position(0),
+	  requestedFrame(0),
+	  framePending(false),
+	  playing(false),
+	  speed(1.0),
+	  playStartTimestamp(0),
+	  playTimer(new QTimer(this)),
+	  generation(0),
+	  seekGeneration(0),
+	  requestedChunk(0),
+	  decodeErrorReported(false)
+{
+	this->playTimer->setSingleShot(true);
+	this->playTimer->setTimerType(Qt::PreciseTimer);
+	connect(this->playTimer, &QTimer::timeout, this, &PlaybackSource::advance);
+}
+
+PlaybackSource::~PlaybackSource() {
+	this->close();
+}
+
+bool PlaybackSource::open(const QString& filePath) {
+	this->close();
+	QSharedPointer<RecordingReader> newReader(new RecordingReader());
+	if(!newReader->open(filePath)){
+		emit error(tr("Could not open recording ") + filePath + ": " + newReader->getErrorString());
+		return false;
+	}
+	if(newReader->getFrameCount() == 0){
+		emit error(tr("Recording does not contain any frames: ") + filePath);
+		return false;
+	}
+
+	const RecordingFileHeader& header = newReader->getHeader();
+	QVideoSurfaceFormat format(QSize(static_cast<int>(header.width), static_cast<int>(header.height)), static_cast<QVideoFrame::PixelFormat>(header.pixelFormat));
+	if(this->surface.isNull() || !this->surface->start(format)){
+		emit error(tr("Pixel format of the recording can not be displayed: ") + filePath);
+		return false;
+	}
+
+	this->reader = newReader;
+	this->filePath = filePath;
+	this->decodeErrorReported = false;
+	this->showFrame(0);
+	return true;
+}
+
+void PlaybackSource::close() {
+	if(this->reader.isNull()){
+		return;
+	}
+	this->setPlaying(false);
+
+	//results of running tasks are discarded. tasks only hold a reference to the reader, but are waited for so no decoding continues after close
+	this->generation++;
+	this->pendingTasks.waitForAll();
+	this->cachedChunks.clear();
+	this->recentChunks.clear();
+	this->loadingChunks.clear();
+	this->framePending = false;
+	this->position = 0;
+	this->requestedFrame = 0;
+	this->reader.clear();
+	this->filePath.clear();
+	if(!this->surface.isNull()){
+		this->surface->stop();
+	}
+}
+
+quint64 PlaybackSource::getFrameCount() const {
+	return this->reader.isNull() ? 0 : this->reader->getFrameCount();
+}
+
+qint64 PlaybackSource::getFrameTimestamp(quint64 frameNr) const {
+	if(this->reader.isNull() || frameNr >= this->reader->getFrameCount()){
+		return 0;
+	}
+	return this->reader->getFrameEntry(frameNr).timestamp - this->reader->getFrameEntry(0).timestamp;
+}
+
+qint64 PlaybackSource::getDuration() const {
+	return this->reader.isNull() ? 0 : this->getFrameTimestamp(this->reader->getFrameCount() - 1);
+}
+
+void PlaybackSource::play() {
+	this->setPlaying(true);
+}
+
+void PlaybackSource::pause() {
+	this->setPlaying(false);
+}
+
+void PlaybackSource::setPlaying(bool playing) {
+	if(this->reader.isNull()){
+		playing = false;
+	}
+	if(this->playing == playing){
+		return;
+	}
+	this->playing = playing;
+	if(playing){
+		//playing at the end of the recording starts over
+		if(this->requestedFrame + 1 >= this->reader->getFrameCount()){
+			this->showFrame(0);
+		}
+		this->restartPlayClock();
+		this->advance();
+	} else {
+		this->playTimer->stop();
+	}
+	emit playingChanged(playing);
+}
+
+void PlaybackSource::setSpeed(qreal speed) {
+	speed = qBound(0.01, speed, 100.0);
+	if(this->playing){
+		//continue from the current play position with the new speed
+		this->playStartTimestamp = this->playTimestamp();
+		this->playClock.restart();
+		this->speed = speed;
+		this->advance();
+	} else {
+		this->speed = speed;
+	}
+}
+
+void PlaybackSource::seek(quint64 frameNr) {
+	if(this->reader.isNull()){
+		return;
+	}
+	frameNr = qMin(frameNr, this->reader->getFrameCount() - 1);
+	this->seekGeneration.ref();
+	this->showFrame(frameNr);
+	if(this->playing){
+		this->restartPlayClock();
+		this->advance();
+	}
+}
+
+void PlaybackSource::stepFrames(int frames) {
+	if(this->reader.isNull()){
+		return;
+	}
+	this->setPlaying(false);
+	qint64 frameNr = static_cast<qint64>(this->requestedFrame) + frames;
+	this->seek(static_cast<quint64>(qMax(Q_INT64_C(0), frameNr)));
+}
+
+qint64 PlaybackSource::playTimestamp() const {
+	return this->playStartTimestamp + static_cast<qint64>(this->playClock.nsecsElapsed()/1000*this->speed);
+}
+
+void PlaybackSource::restartPlayClock() {
+	this->playStartTimestamp = this->reader->getFrameEntry(this->requestedFrame).timestamp;
+	this->playClock.start();
+}
+
+void PlaybackSource::advance() {
+	if(!this->playing || this->reader.isNull()){
+		return;
+	}
+	//the frame to show is looked up by time, so frames are skipped instead of slowing down playback if decoding can not keep up
+	qint64 timestamp = this->playTimestamp();
+	quint64 frameNr = this->reader->frameAtTimestamp(timestamp);
+	if(frameNr != this->requestedFrame){
+		this->showFrame(frameNr);
+	}
+	quint64 frameCount = this->reader->getFrameCount();
+	if(frameNr + 1 >= frameCount){
+		this->setPlaying(false);
+		return;
+	}
+
+	//wake up exactly when the next frame is due
+	qint64 nextTimestamp = this->reader->getFrameEntry(frameNr + 1).timestamp;
+	qint64 delayMs = static_cast<qint64>((nextTimestamp - timestamp)/this->speed/1000.0);
+	this->playTimer->start(static_cast<int>(qBound(Q_INT64_C(1), delayMs, Q_INT64_C(1000))));
+}
+
+void PlaybackSource::showFrame(quint64 frameNr) {
+	this->requestedFrame = frameNr;
+	quint64 chunkNr = this->reader->getFrameEntry(frameNr).chunk;
+	this->requestedChunk.storeRelease(chunkNr);
+	if(this->cachedChunks.contains(chunkNr) || this->reader->getChunkEntry(chunkNr).codec == RecordingFormat::RAW){
+		this->presentFrame(frameNr);
+	} else {
+		//shown by onChunkLoaded() unless a newer frame was requested in the meantime
+		this->framePending = true;
+		this->loadChunk(chunkNr);
+	}
+	this->prefetch(chunkNr);
+}
+
+void PlaybackSource::presentFrame(quint64 frameNr) {
+	const RecordingFileHeader& header = this->reader->getHeader();
+	const RecordingFrameEntry& entry = this->reader->getFrameEntry(frameNr);
+	const RecordingChunkEntry& chunk = this->reader->getChunkEntry(entry.chunk);
+	QByteArray payload;
+	const uchar* data = nullptr;
+	if(chunk.codec == RecordingFormat::RAW){
+		data = this->reader->frameData(frameNr);
+	} else {
+		payload = this->cachedChunks.value(entry.chunk);
+		if(entry.offset + entry.size <= static_cast<quint64>(payload.size())){
+			data = reinterpret_cast<const uchar*>(payload.constData()) + entry.offset;
+		}
+	}
+	this->framePending = false;
+	if(data == nullptr){
+		return;
+	}
+
+	//keep chunk of the shown frame at the front of the cache
+	if(this->cachedChunks.contains(entry.chunk)){
+		this->recentChunks.removeOne(entry.chunk);
+		this->recentChunks.prepend(entry.chunk);
+	}
+
+	QVideoFrame frame(new PlaybackVideoBuffer(this->reader, payload, data, static_cast<int>(entry.size), static_cast<int>(header.bytesPerLine)),
+			QSize(static_cast<int>(header.width), static_cast<int>(header.height)), static_cast<QVideoFrame::PixelFormat>(header.pixelFormat));
+	frame.setStartTime(this->getFrameTimestamp(frameNr));
+	this->position = frameNr;
+	if(!this->surface.isNull()){
+		this->surface->present(frame);
+	}
+	emit positionChanged(frameNr);
+}
+
+void PlaybackSource::loadChunk(quint64 chunkNr) {
+	if(chunkNr >= this->reader->getChunkCount() || this->cachedChunks.contains(chunkNr) || this->loadingChunks.contains(chunkNr)){
+		return;
+	}
+	QSharedPointer<RecordingReader> chunkReader = this->reader;
+	bool raw = chunkReader->getChunkEntry(chunkNr).codec == RecordingFormat::RAW;
+	int taskGeneration = this->generation;
+	int taskSeekGeneration = this->seekGeneration.loadAcquire();
+	this->loadingChunks.insert(chunkNr);
+	this->pendingTasks.add();
+	bool accepted = WorkStealingPool::globalInstance()->trySubmit([this, chunkReader, chunkNr, raw, taskGeneration, taskSeekGeneration]() {
+		//scrubbing queues tasks faster than they are decoded. tasks of an older seek are skipped, so the chunk of the latest seek is not
+		//stuck behind them, unless the chunk is the requested one or one of its prefetched successors
+		quint64 wantedChunk = this->requestedChunk.loadAcquire();
+		if(taskSeekGeneration != this->seekGeneration.loadAcquire() && (chunkNr < wantedChunk || chunkNr > wantedChunk + PREFETCH_CHUNKS)){
+			QMetaObject::invokeMethod(this, [this, taskGeneration, chunkNr]() {
+				this->onChunkSkipped(taskGeneration, chunkNr);
+			}, Qt::QueuedConnection);
+			this->pendingTasks.done();
+			return;
+		}
+		QByteArray payload;
+		bool success = true;
+		if(raw){
+			//uncompressed frames are read directly from the map, touching the pages here moves the page faults off the gui thread
+			const RecordingChunkEntry& chunk = chunkReader->getChunkEntry(chunkNr);
+			const uchar* data = chunkReader->chunkPayload(chunkNr);
+			volatile uchar sum = 0;
+			for(quint64 i = 0; i < chunk.payloadSize; i += RecordingFormat::ALIGNMENT){
+				sum += data[i];
+			}
+			Q_UNUSED(sum)
+		} else {
+			success = chunkReader->decodeChunk(chunkNr, &payload);
+		}
+		QMetaObject::invokeMethod(this, [this, taskGeneration, chunkNr, payload, success]() {
+			this->onChunkLoaded(taskGeneration, chunkNr, payload, success);
+		}, Qt::QueuedConnection);
+		this->pendingTasks.done();
+	});
+	if(!accepted){
+		//pool is saturated, the chunk is requested again with the next frame
+		this->loadingChunks.remove(chunkNr);
+		this->pendingTasks.done();
+		if(this->framePending){
+			QTimer::singleShot(5, this, [this]() {
+				if(this->framePending && !this->reader.isNull()){
+					this->showFrame(this->requestedFrame);
+				}
+			});
+		}
+	}
+}
+
+void PlaybackSource::prefetch(quint64 chunkNr) {
+	for(int i = 1; i <= PREFETCH_CHUNKS; i++){
+		this->loadChunk(chunkNr + static_cast<quint64>(i));
+	}
+}
+
+void PlaybackSource::onChunkLoaded(int generation, quint64 chunkNr, QByteArray payload, bool success) {
+	if(generation != this->generation){
+		return;
+	}
+	this->loadingChunks.remove(chunkNr);
+	if(!success){
+		if(!this->decodeErrorReported){
+			this->decodeErrorReported = true;
+			emit error(tr("Recording contains corrupt data, chunk %1 can not be decoded").arg(chunkNr));
+		}
+		if(this->framePending && this->reader->getFrameEntry(this->requestedFrame).chunk == chunkNr){
+			this->framePending = false;
+		}
+		return;
+	}
+
+	//for uncompressed chunks only an empty entry is cached to mark them as prefetched, their frames are read from the map
+	this->cachedChunks.insert(chunkNr, payload);
+	this->recentChunks.append(chunkNr);
+	quint64 requestedChunk = this->reader->getFrameEntry(this->requestedFrame).chunk;
+	if(this->framePending && requestedChunk == chunkNr){
+		this->presentFrame(this->requestedFrame);
+	}
+	this->evictChunks(requestedChunk);
+}
+
+void PlaybackSource::onChunkSkipped(int generation, quint64 chunkNr) {
+	if(generation != this->generation){
+		return;
+	}
+	this->loadingChunks.remove(chunkNr);
+	//the request may have moved back to the chunk after the task checked it
+	if(this->framePending && this->reader->getFrameEntry(this->requestedFrame).chunk == chunkNr){
+		this->loadChunk(chunkNr);
+	}
+}
+
+void PlaybackSource::evictChunks(quint64 currentChunk) {
+	//the chunk of the current frame and the prefetched chunks after it are kept, otherwise the least recently shown chunks are dropped
+	int i = this->recentChunks.size() - 1;
+	while(this->cachedChunks.size() > MAX_CACHED_CHUNKS && i >= 0){
+		quint64 chunkNr = this->recentChunks.at(i);
+		if(chunkNr < currentChunk || chunkNr > currentChunk + PREFETCH_CHUNKS){
+			this->cachedChunks.remove(chunkNr);
+			this->recentChunks.removeAt(i);
+		}
+		i--;
+	}
+}
@@ -0,0 +1,94 @@
+#ifndef PLAYBACKSOURCE_H
+#define PLAYBACKSOURCE_H
+
+#include <QObject>
+#include <QAbstractVideoSurface>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+#include "recordingreader.h"
+#include "workstealingpool.h"
+
+
+//plays a recording into a video surface (usually the FrameTapSurface of a camera view), so display and all analysis stages work on recorded frames
+//exactly as on live frames. the file is memory mapped and only the index is read on open, so seeking is O(1) regardless of the file size.
+//encoded chunks are decoded on the WorkStealingPool, the chunks following the current position are decoded ahead of time and a few decoded
+//chunks are kept for scrubbing. frames of uncompressed chunks are passed to the surface without copy. the gui thread never waits for decoding,
+//a seek to a chunk that is not decoded yet shows the frame as soon as the chunk is ready (only the latest request is shown). every seek starts
+//a new seek generation, queued decode tasks of an older generation are skipped unless their chunk is still needed for the latest request
+class PlaybackSource : public QObject
+{
+	Q_OBJECT
+public:
+	explicit PlaybackSource(QAbstractVideoSurface* surface, QObject *parent = nullptr);
+	~PlaybackSource();
+
+	bool open(const QString& filePath);
+	void close();
+	bool isOpen() const {return !this->reader.isNull();}
+	QString getFilePath() const {return this->filePath;}
+	quint64 getFrameCount() const;
+	quint64 getPosition() const {return this->position;}
+	//us since the first frame of the recording
+	qint64 getFrameTimestamp(quint64 frameNr) const;
+	qint64 getDuration() const;
+	qreal getSpeed() const {return this->speed;}
+	bool isPlaying() const {return this->playing;}
+
+	static const int PREFETCH_CHUNKS = 2;
+	static const int MAX_CACHED_CHUNKS = 6;
+
+private:
+	QPointer<QAbstractVideoSurface> surface;
+	QSharedPointer<RecordingReader> reader;
+	QString filePath;
+	quint64 position;
+	quint64 requestedFrame;
+	bool framePending;
+	bool playing;
+	qreal speed;
+	qint64 playStartTimestamp;
+	QElapsedTimer playClock;
+	QTimer* playTimer;
+	QHash<quint64, QByteArray> cachedChunks;
+	QList<quint64> recentChunks;
+	QSet<quint64> loadingChunks;
+	WorkStealingPool::TaskCounter pendingTasks;
+	int generation; //changes on close(), results of older tasks are discarded
+	QAtomicInt seekGeneration; //changes on every seek
+	QAtomicInteger<quint64> requestedChunk; //chunk of the latest requested frame, read by the decode tasks
+	bool decodeErrorReported;
+
+	qint64 playTimestamp() const;
+	void restartPlayClock();
+	void showFrame(quint64 frameNr);
+	void presentFrame(quint64 frameNr);
+	void loadChunk(quint64 chunkNr);
+	void prefetch(quint64 chunkNr);
+	void evictChunks(quint64 currentChunk);
+
+public slots:
+	void play();
+	void pause();
+	void setPlaying(bool playing);
+	void setSpeed(qreal speed);
+	void seek(quint64 frameNr);
+	void stepFrames(int frames);
+
+private slots:
+	void advance();
+	void onChunkLoaded(int generation, quint64 chunkNr, QByteArray payload, bool success);
+	void onChunkSkipped(int generation, quint64 chunkNr);
+
+signals:
+	void positionChanged(quint64 frameNr);
+	void playingChanged(bool playing);
+	void error(QString);
+};
+
+#endif //PLAYBACKSOURCE_H
@@ -0,0 +1,169 @@
+#include "recordingcodec.h"
+#include "lzcodec.h"
+#include <QVideoFrame>
+#include <cstring>
+#include <limits>
+
+//compressed chunks that save less than this are stored uncompressed, decoding them would cost time for almost no disk space
+#define MIN_COMPRESSION_GAIN 0.97
+
+
+int RecordingCodec::componentStride(int pixelFormat) {
+	switch(pixelFormat){
+		case QVideoFrame::Format_YUYV:
+		case QVideoFrame::Format_UYVY:
+		case QVideoFrame::Format_ARGB32:
+		case QVideoFrame::Format_ARGB32_Premultiplied:
+		case QVideoFrame::Format_RGB32:
+		case QVideoFrame::Format_BGRA32:
+		case QVideoFrame::Format_BGRA32_Premultiplied:
+		case QVideoFrame::Format_ABGR32:
+		case QVideoFrame::Format_BGR32:
+		case QVideoFrame::Format_AYUV444:
+		case QVideoFrame::Format_AYUV444_Premultiplied:
+			return 4;
+		case QVideoFrame::Format_RGB24:
+		case QVideoFrame::Format_BGR24:
+		case QVideoFrame::Format_YUV444:
+			return 3;
+		case QVideoFrame::Format_RGB565:
+		case QVideoFrame::Format_RGB555:
+		case QVideoFrame::Format_BGR565:
+		case QVideoFrame::Format_BGR555:
+		case QVideoFrame::Format_Y16:
+			return 2;
+		case QVideoFrame::Format_Jpeg:
+		case QVideoFrame::Format_Invalid:
+			return 0;
+		default:
+			return 1; //planar formats and Y8
+	}
+}
+
+bool RecordingCodec::encodeChunk(const QByteArray& rawPayload, const RecordingFrameEntry* frames, int frameCount, int pixelFormat, int level, QByteArray* encodedPayload, quint32* codec) {
+	if(level <= 0 || rawPayload.isEmpty()){
+		return false;
+	}
+	const quint8* source = reinterpret_cast<const quint8*>(rawPayload.constData());
+	int size = rawPayload.size();
+
+	//the preprocessing buffer is reused by every pool thread, so large chunks do not cause an allocation per chunk
+	static thread_local QByteArray preprocessed;
+	int stride = componentStride(pixelFormat);
+	bool usePreprocessing = level >= 2 && stride > 0;
+	if(usePreprocessing){
+		preprocessed.resize(size);
+		quint8* target = reinterpret_cast<quint8*>(preprocessed.data());
+		for(int i = 0; i < frameCount; i++){
+			int offset = static_cast<int>(frames[i].offset);
+			splitPlanesDelta(source + offset, target + offset, static_cast<int>(frames[i].size), stride);
+		}
+		source = target;
+	}
+
+	encodedPayload->resize(LzCodec::maxCompressedSize(size));
+	int encodedSize = LzCodec::compress(source, size, reinterpret_cast<quint8*>(encodedPayload->data()), encodedPayload->size(), level);
+	if(encodedSize < 0 || encodedSize > size*MIN_COMPRESSION_GAIN){
+		encodedPayload->clear();
+		return false;
+	}
+	encodedPayload->resize(encodedSize);
+	*codec = usePreprocessing ? RecordingFormat::LZ_PLANAR_DELTA : RecordingFormat::LZ;
+	return true;
+}
+
+bool RecordingCodec::decodeChunk(const uchar* payload, quint64 payloadSize, quint32 codec, quint64 rawSize, const RecordingFrameEntry* frames, int frameCount, int pixelFormat, QByteArray* rawPayload) {
+	if(rawSize > static_cast<quint64>(std::numeric_limits<int>::max()) || payloadSize > static_cast<quint64>(std::numeric_limits<int>::max())){
+		return false;
+	}
+	int size = static_cast<int>(rawSize);
+	for(int i = 0; i < frameCount; i++){
+		if(frames[i].size > rawSize || frames[i].offset > rawSize - frames[i].size){
+			return false;
+		}
+	}
+
+	if(codec == RecordingFormat::RAW){
+		if(payloadSize != rawSize){
+			return false;
+		}
+		*rawPayload = QByteArray(reinterpret_cast<const char*>(payload), size);
+		return true;
+	}
+	if(codec != RecordingFormat::LZ && codec != RecordingFormat::LZ_PLANAR_DELTA){
+		return false;
+	}
+
+	static thread_local QByteArray decoded;
+	QByteArray* target = codec == RecordingFormat::LZ ? rawPayload : &decoded;
+	target->resize(size);
+	int decodedSize = LzCodec::decompress(payload, static_cast<int>(payloadSize), reinterpret_cast<quint8*>(target->data()), size);
+	if(decodedSize != size){
+		return false;
+	}
+
+	if(codec == RecordingFormat::LZ_PLANAR_DELTA){
+		int stride = componentStride(pixelFormat);
+		if(stride <= 0){
+			return false;
+		}
+		rawPayload->resize(size);
+		const quint8* source = reinterpret_cast<const quint8*>(decoded.constData());
+		quint8* destination = reinterpret_cast<quint8*>(rawPayload->data());
+		for(int i = 0; i < frameCount; i++){
+			int offset = static_cast<int>(frames[i].offset);
+			mergePlanesDelta(source + offset, destination + offset, static_cast<int>(frames[i].size), stride);
+		}
+	}
+	return true;
+}
+
+void RecordingCodec::splitPlanesDelta(const quint8* src, quint8* dst, int size, int stride) {
+	//every byte component (e.g. Y0, U, Y1, V of YUYV) becomes a plane of differences to its left neighbour.
+	//neighbouring pixels are similar, so the planes consist of small values that repeat much more often than the pixel data
+	int planeSize = size/stride;
+	if(stride == 1){
+		quint8 previous = 0;
+		for(int i = 0; i < size; i++){
+			dst[i] = static_cast<quint8>(src[i] - previous);
+			previous = src[i];
+		}
+		return;
+	}
+	for(int plane = 0; plane < stride; plane++){
+		const quint8* in = src + plane;
+		quint8* out = dst + plane*planeSize;
+		quint8 previous = 0;
+		for(int i = 0; i < planeSize; i++){
+			quint8 value = in[i*stride];
+			out[i] = static_cast<quint8>(value - previous);
+			previous = value;
+		}
+	}
+	//bytes that do not form a complete pixel are kept as they are
+	int tail = size - planeSize*stride;
+	memcpy(dst + planeSize*stride, src + planeSize*stride, static_cast<size_t>(tail));
+}
+
+void RecordingCodec::mergePlanesDelta(const quint8* src, quint8* dst, int size, int stride) {
+	int planeSize = size/stride;
+	if(stride == 1){
+		quint8 value = 0;
+		for(int i = 0; i < size; i++){
+			value = static_cast<quint8>(value + src[i]);
+			dst[i] = value;
+		}
+		return;
+	}
+	for(int plane = 0; plane < stride; plane++){
+		const quint8* in = src + plane*planeSize;
+		quint8* out = dst + plane;
+		quint8 value = 0;
+		for(int i = 0; i < planeSize; i++){
+			value = static_cast<quint8>(value + in[i]);
+			out[i*stride] = value;
+		}
+	}
+	int tail = size - planeSize*stride;
+	memcpy(dst + planeSize*stride, src + planeSize*stride, static_cast<size_t>(tail));
+}
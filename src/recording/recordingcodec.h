@@ -0,0 +1,29 @@
+#ifndef RECORDINGCODEC_H
+#define RECORDINGCODEC_H
+
+#include <QByteArray>
+#include "recordingformat.h"
+
+
+//lossless encoding of recording chunks. every chunk is encoded on its own, so it can be decoded without any other chunk.
+//levels: 0 = stored uncompressed, 1 = fast LzCodec, 2 = planar delta preprocessing + LzCodec, 3 = like 2 with a more thorough match search
+class RecordingCodec
+{
+public:
+	static const int MAX_LEVEL = 3;
+	static const int DEFAULT_LEVEL = 2;
+
+	//number of interleaved byte components of a pixel format (4 for YUYV or RGB32, 2 for Y16, 1 for planar formats).
+	//0 for formats that can not be preprocessed (jpeg)
+	static int componentStride(int pixelFormat);
+
+	//returns false if the chunk should be stored uncompressed (level 0 or data not compressible)
+	static bool encodeChunk(const QByteArray& rawPayload, const RecordingFrameEntry* frames, int frameCount, int pixelFormat, int level, QByteArray* encodedPayload, quint32* codec);
+	static bool decodeChunk(const uchar* payload, quint64 payloadSize, quint32 codec, quint64 rawSize, const RecordingFrameEntry* frames, int frameCount, int pixelFormat, QByteArray* rawPayload);
+
+private:
+	static void splitPlanesDelta(const quint8* src, quint8* dst, int size, int stride);
+	static void mergePlanesDelta(const quint8* src, quint8* dst, int size, int stride);
+};
+
+#endif //RECORDINGCODEC_H
@@ -0,0 +1,103 @@
+#ifndef RECORDINGFORMAT_H
+#define RECORDINGFORMAT_H
+
+#include <QtGlobal>
+
+
+//layout of a camera recording (*.ocrec). all values are little endian, all structs have a fixed size without padding.
+//
+//  [file header, HEADER_SIZE bytes]
+//  [chunk 0][chunk 1]...[chunk n-1]   every chunk starts at a multiple of ALIGNMENT
+//  [chunk index: chunkCount * RecordingChunkEntry][frame index: frameCount * RecordingFrameEntry]
+//
+//a chunk consists of a RecordingChunkHeader, a table with one RecordingFrameEntry per frame of the chunk and the payload with the frame data.
+//the index at the end of the file is written when the recording is stopped and allows O(1) access to every frame, for example via a memory map.
+//if the recording was not finalized (crash, power loss) the index can be rebuilt by walking the chunk headers. from version 2 on every chunk
+//header carries a checksum of its frame table and payload, so the walk also detects chunks that were only partially written
+namespace RecordingFormat {
+	const char MAGIC[8] = {'O', 'C', 'T', 'C', 'R', 'E', 'C', '\0'};
+	const quint32 VERSION = 2;
+	const quint32 FIRST_CHECKSUM_VERSION = 2;
+	const quint32 CHUNK_MAGIC = 0x4b4e4843; //"CHNK"
+	const quint32 HEADER_SIZE = 4096;
+	const quint32 ALIGNMENT = 4096;
+	const char FILE_SUFFIX[] = "ocrec";
+
+	enum Codec {
+		RAW = 0,
+		LZ = 1, //LzCodec on the frame data
+		LZ_PLANAR_DELTA = 2 //frames are split into one plane per byte component and delta coded before LzCodec
+	};
+
+	inline quint64 align(quint64 value) {return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;}
+
+	//adler-32 (same value as zlib's adler32), chained over several buffers starting with 1. a zero filled payload, as left by posix_fallocate
+	//when a chunk was not written completely, does not match the checksum of the written data
+	inline quint32 checksum(quint32 adler, const uchar* data, quint64 size) {
+		quint32 a = adler & 0xffff;
+		quint32 b = adler >> 16;
+		while(size > 0){
+			//the sums can not overflow 32 bits within 5552 bytes
+			quint64 block = qMin(size, Q_UINT64_C(5552));
+			size -= block;
+			for(quint64 i = 0; i < block; i++){
+				a += data[i];
+				b += a;
+			}
+			data += block;
+			a %= 65521;
+			b %= 65521;
+		}
+		return (b << 16) | a;
+	}
+}
+
+struct RecordingFileHeader {
+	char magic[8];
+	quint32 version;
+	quint32 headerSize;
+	quint32 width;
+	quint32 height;
+	qint32 pixelFormat; //QVideoFrame::PixelFormat
+	quint32 bytesPerLine;
+	quint32 frameSize; //bytes of the largest frame
+	quint32 finalized; //1 if the index at the end of the file is valid
+	quint64 chunkCount;
+	quint64 frameCount;
+	quint64 chunkIndexOffset;
+	quint64 frameIndexOffset;
+	qint64 startTime; //ms since epoch
+	quint64 dataEnd; //end of the last chunk
+	quint8 reserved[40];
+};
+Q_STATIC_ASSERT(sizeof(RecordingFileHeader) == 128);
+
+struct RecordingChunkHeader {
+	quint32 magic;
+	quint32 frameCount;
+	quint32 codec; //RecordingFormat::Codec
+	quint32 checksum; //RecordingFormat::checksum() of the frame table and the stored payload, 0 before version 2
+	quint64 payloadSize; //stored payload bytes after the frame table
+	quint64 rawSize; //payload bytes after decoding
+};
+Q_STATIC_ASSERT(sizeof(RecordingChunkHeader) == 32);
+
+struct RecordingFrameEntry {
+	quint64 sequenceNumber; //counts all frames delivered by the camera during the recording, gaps indicate dropped frames
+	qint64 timestamp; //us since start of the recording
+	quint64 offset; //offset of the frame data in the decoded chunk payload
+	quint32 size;
+	quint32 chunk;
+};
+Q_STATIC_ASSERT(sizeof(RecordingFrameEntry) == 32);
+
+struct RecordingChunkEntry {
+	quint64 fileOffset; //position of the chunk header in the file
+	quint64 firstFrame;
+	quint32 frameCount;
+	quint32 codec;
+	quint64 payloadSize;
+};
+Q_STATIC_ASSERT(sizeof(RecordingChunkEntry) == 32);
+
+#endif //RECORDINGFORMAT_H
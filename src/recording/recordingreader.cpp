@@ -0,0 +1,255 @@
+#include "recordingreader.h"
+#include "recordingcodec.h"
+#include <QObject>
+#include <cstring>
+#include <limits>
+
+
+namespace {
+	//a chunk of frameCount frames with payloadSize stored bytes at pos must lie completely inside the file. written without sums that can wrap
+	bool chunkFits(quint64 pos, quint32 frameCount, quint64 payloadSize, quint64 fileSize) {
+		if(pos < RecordingFormat::HEADER_SIZE || pos > fileSize || fileSize - pos < sizeof(RecordingChunkHeader)
+				|| frameCount > static_cast<quint32>(std::numeric_limits<int>::max())){
+			return false;
+		}
+		quint64 remaining = fileSize - pos - sizeof(RecordingChunkHeader);
+		quint64 tableSize = static_cast<quint64>(frameCount)*sizeof(RecordingFrameEntry);
+		return tableSize <= remaining && payloadSize <= remaining - tableSize;
+	}
+
+	//the frame data must lie inside the decoded payload of its chunk
+	bool frameFits(const RecordingFrameEntry& frame, quint64 rawSize) {
+		return frame.size <= rawSize && frame.offset <= rawSize - frame.size;
+	}
+}
+
+
+RecordingReader::RecordingReader()
+	: data(nullptr),
+	  size(0),
+	  chunks(nullptr),
+	  frames(nullptr),
+	  chunkCount(0),
+	  frameCount(0),
+	  cachedChunk(-1)
+{
+	memset(&this->header, 0, sizeof(this->header));
+}
+
+RecordingReader::~RecordingReader() {
+	this->close();
+}
+
+bool RecordingReader::open(const QString& filePath) {
+	this->close();
+	this->file.setFileName(filePath);
+	if(!this->file.open(QIODevice::ReadOnly)){
+		this->errorString = this->file.errorString();
+		return false;
+	}
+	this->size = static_cast<quint64>(this->file.size());
+	if(this->size < RecordingFormat::HEADER_SIZE){
+		this->errorString = QObject::tr("File is too small for a camera recording");
+		this->file.close();
+		return false;
+	}
+	this->data = this->file.map(0, this->file.size());
+	if(this->data == nullptr){
+		this->errorString = this->file.errorString();
+		this->file.close();
+		return false;
+	}
+
+	memcpy(&this->header, this->data, sizeof(this->header));
+	if(memcmp(this->header.magic, RecordingFormat::MAGIC, sizeof(this->header.magic)) != 0 || this->header.version > RecordingFormat::VERSION){
+		this->errorString = QObject::tr("Unknown file format");
+		this->close();
+		return false;
+	}
+
+	//an index that does not fit into the file or references data outside of it is ignored, the chunks are walked instead
+	bool indexValid = this->header.finalized == 1
+			&& this->header.chunkIndexOffset % alignof(RecordingChunkEntry) == 0 && this->header.frameIndexOffset % alignof(RecordingFrameEntry) == 0
+			&& this->header.chunkIndexOffset <= this->size
+			&& this->header.chunkCount <= (this->size - this->header.chunkIndexOffset)/sizeof(RecordingChunkEntry)
+			&& this->header.frameIndexOffset <= this->size
+			&& this->header.frameCount <= (this->size - this->header.frameIndexOffset)/sizeof(RecordingFrameEntry);
+	if(indexValid){
+		this->chunks = reinterpret_cast<const RecordingChunkEntry*>(this->data + this->header.chunkIndexOffset);
+		this->frames = reinterpret_cast<const RecordingFrameEntry*>(this->data + this->header.frameIndexOffset);
+		this->chunkCount = this->header.chunkCount;
+		this->frameCount = this->header.frameCount;
+		if(this->validateIndex()){
+			return true;
+		}
+		this->chunks = nullptr;
+		this->frames = nullptr;
+		this->chunkCount = 0;
+		this->frameCount = 0;
+	}
+	return this->rebuildIndex();
+}
+
+void RecordingReader::close() {
+	if(this->data != nullptr){
+		this->file.unmap(this->data);
+		this->data = nullptr;
+	}
+	this->file.close();
+	this->size = 0;
+	this->chunks = nullptr;
+	this->frames = nullptr;
+	this->chunkCount = 0;
+	this->frameCount = 0;
+	this->rebuiltChunks.clear();
+	this->rebuiltFrames.clear();
+	this->cachedChunk = -1;
+	this->cachedPayload.clear();
+}
+
+const uchar* RecordingReader::chunkPayload(quint64 chunkNr) const {
+	const RecordingChunkEntry& chunk = this->chunks[chunkNr];
+	return this->data + chunk.fileOffset + sizeof(RecordingChunkHeader) + chunk.frameCount*sizeof(RecordingFrameEntry);
+}
+
+const uchar* RecordingReader::frameData(quint64 frameNr) const {
+	const RecordingFrameEntry& frame = this->frames[frameNr];
+	const RecordingChunkEntry& chunk = this->chunks[frame.chunk];
+	if(chunk.codec != RecordingFormat::RAW || frame.offset + frame.size > chunk.payloadSize){
+		return nullptr;
+	}
+	return this->chunkPayload(frame.chunk) + frame.offset;
+}
+
+bool RecordingReader::decodeChunk(quint64 chunkNr, QByteArray* rawPayload) const {
+	if(chunkNr >= this->chunkCount){
+		return false;
+	}
+	const RecordingChunkEntry& chunk = this->chunks[chunkNr];
+	RecordingChunkHeader chunkHeader;
+	memcpy(&chunkHeader, this->data + chunk.fileOffset, sizeof(chunkHeader));
+	const RecordingFrameEntry* chunkFrames = this->frames + chunk.firstFrame;
+	return RecordingCodec::decodeChunk(this->chunkPayload(chunkNr), chunk.payloadSize, chunk.codec, chunkHeader.rawSize, chunkFrames, static_cast<int>(chunk.frameCount), this->header.pixelFormat, rawPayload);
+}
+
+quint64 RecordingReader::frameAtTimestamp(qint64 timestamp) const {
+	//timestamps are increasing, binary search only touches a few pages of the index
+	quint64 low = 0;
+	quint64 high = this->frameCount;
+	while(high - low > 1){
+		quint64 middle = low + (high - low)/2;
+		if(this->frames[middle].timestamp <= timestamp){
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+bool RecordingReader::readChunk(quint64 chunkNr, QByteArray* rawPayload) {
+	if(static_cast<qint64>(chunkNr) == this->cachedChunk){
+		*rawPayload = this->cachedPayload;
+		return true;
+	}
+	if(!this->decodeChunk(chunkNr, rawPayload)){
+		this->errorString = QObject::tr("Chunk %1 is corrupt").arg(chunkNr);
+		return false;
+	}
+	this->cachedChunk = static_cast<qint64>(chunkNr);
+	this->cachedPayload = *rawPayload;
+	return true;
+}
+
+bool RecordingReader::readFrame(quint64 frameNr, QByteArray* data) {
+	if(frameNr >= this->frameCount){
+		return false;
+	}
+	const RecordingFrameEntry& frame = this->frames[frameNr];
+	const uchar* rawData = this->frameData(frameNr);
+	if(rawData != nullptr){
+		*data = QByteArray(reinterpret_cast<const char*>(rawData), static_cast<int>(frame.size));
+		return true;
+	}
+	QByteArray payload;
+	if(!this->readChunk(frame.chunk, &payload) || frame.offset + frame.size > static_cast<quint64>(payload.size())){
+		return false;
+	}
+	*data = payload.mid(static_cast<int>(frame.offset), static_cast<int>(frame.size));
+	return true;
+}
+
+bool RecordingReader::validateIndex() const {
+	//every entry is checked once, so chunkPayload(), frameData() and decodeChunk() never read outside of the map. chunks have to follow each
+	//other in the frame index and match the chunk header they point to
+	quint64 nextFrame = 0;
+	for(quint64 chunkNr = 0; chunkNr < this->chunkCount; chunkNr++){
+		const RecordingChunkEntry& chunk = this->chunks[chunkNr];
+		if(chunk.firstFrame != nextFrame || chunk.frameCount == 0 || chunk.frameCount > this->frameCount - nextFrame
+				|| !chunkFits(chunk.fileOffset, chunk.frameCount, chunk.payloadSize, this->size)){
+			return false;
+		}
+		RecordingChunkHeader chunkHeader;
+		memcpy(&chunkHeader, this->data + chunk.fileOffset, sizeof(chunkHeader));
+		if(chunkHeader.magic != RecordingFormat::CHUNK_MAGIC || chunkHeader.frameCount != chunk.frameCount || chunkHeader.codec != chunk.codec
+				|| chunkHeader.payloadSize != chunk.payloadSize || (chunk.codec == RecordingFormat::RAW && chunkHeader.rawSize != chunk.payloadSize)){
+			return false;
+		}
+		for(quint64 frameNr = chunk.firstFrame; frameNr < chunk.firstFrame + chunk.frameCount; frameNr++){
+			const RecordingFrameEntry& frame = this->frames[frameNr];
+			if(frame.chunk != chunkNr || !frameFits(frame, chunkHeader.rawSize)){
+				return false;
+			}
+		}
+		nextFrame += chunk.frameCount;
+	}
+	return nextFrame == this->frameCount;
+}
+
+bool RecordingReader::rebuildIndex() {
+	//the recording was not finalized or its index is corrupt. every complete chunk is still usable, the walk stops at the first chunk that was
+	//not fully written or contains entries outside of its payload. the file is preallocated, so a chunk torn by a crash can still lie inside
+	//the file with a zero filled table or payload. only the checksum detects it, which reads every chunk once
+	const bool checksums = this->header.version >= RecordingFormat::FIRST_CHECKSUM_VERSION;
+	quint64 pos = RecordingFormat::HEADER_SIZE;
+	while(pos <= this->size && this->size - pos >= sizeof(RecordingChunkHeader)){
+		RecordingChunkHeader chunkHeader;
+		memcpy(&chunkHeader, this->data + pos, sizeof(chunkHeader));
+		if(chunkHeader.magic != RecordingFormat::CHUNK_MAGIC || chunkHeader.frameCount == 0 || !chunkFits(pos, chunkHeader.frameCount, chunkHeader.payloadSize, this->size)
+				|| (chunkHeader.codec == RecordingFormat::RAW && chunkHeader.rawSize != chunkHeader.payloadSize)){
+			break;
+		}
+		const RecordingFrameEntry* table = reinterpret_cast<const RecordingFrameEntry*>(this->data + pos + sizeof(RecordingChunkHeader));
+		const quint64 storedSize = static_cast<quint64>(chunkHeader.frameCount)*sizeof(RecordingFrameEntry) + chunkHeader.payloadSize;
+		if(checksums && RecordingFormat::checksum(1, reinterpret_cast<const uchar*>(table), storedSize) != chunkHeader.checksum){
+			break;
+		}
+		bool framesValid = true;
+		for(quint32 i = 0; i < chunkHeader.frameCount && framesValid; i++){
+			framesValid = frameFits(table[i], chunkHeader.rawSize);
+		}
+		if(!framesValid){
+			break;
+		}
+		quint64 chunkEnd = pos + sizeof(RecordingChunkHeader) + storedSize;
+		RecordingChunkEntry chunkEntry;
+		chunkEntry.fileOffset = pos;
+		chunkEntry.firstFrame = static_cast<quint64>(this->rebuiltFrames.size());
+		chunkEntry.frameCount = chunkHeader.frameCount;
+		chunkEntry.codec = chunkHeader.codec;
+		chunkEntry.payloadSize = chunkHeader.payloadSize;
+		for(quint32 i = 0; i < chunkHeader.frameCount; i++){
+			RecordingFrameEntry entry = table[i];
+			entry.chunk = static_cast<quint32>(this->rebuiltChunks.size());
+			this->rebuiltFrames.append(entry);
+		}
+		this->rebuiltChunks.append(chunkEntry);
+		pos = RecordingFormat::align(chunkEnd);
+	}
+
+	this->chunks = this->rebuiltChunks.constData();
+	this->frames = this->rebuiltFrames.constData();
+	this->chunkCount = static_cast<quint64>(this->rebuiltChunks.size());
+	this->frameCount = static_cast<quint64>(this->rebuiltFrames.size());
+	return true;
+}
@@ -0,0 +1,63 @@
+#ifndef RECORDINGREADER_H
+#define RECORDINGREADER_H
+
+#include <QFile>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+#include "recordingformat.h"
+
+
+//random access to the frames of a recording (O(1) via the index). the file is memory mapped, frames of uncompressed chunks are returned as pointers into the map.
+//for finalized recordings the index is used directly from the map, otherwise it is rebuilt once by walking the chunk headers
+class RecordingReader
+{
+public:
+	RecordingReader();
+	~RecordingReader();
+
+	bool open(const QString& filePath);
+	void close();
+	bool isOpen() const {return this->data != nullptr;}
+	QString getErrorString() const {return this->errorString;}
+
+	const RecordingFileHeader& getHeader() const {return this->header;}
+	quint64 getFrameCount() const {return this->frameCount;}
+	quint64 getChunkCount() const {return this->chunkCount;}
+	const RecordingFrameEntry& getFrameEntry(quint64 frameNr) const {return this->frames[frameNr];}
+	const RecordingChunkEntry& getChunkEntry(quint64 chunkNr) const {return this->chunks[chunkNr];}
+
+	//stored (possibly encoded) payload of a chunk
+	const uchar* chunkPayload(quint64 chunkNr) const;
+	//frame data of uncompressed chunks, nullptr if the chunk of the frame is encoded
+	const uchar* frameData(quint64 frameNr) const;
+	//decodes a chunk without using the cache. thread safe, the file is only read
+	bool decodeChunk(quint64 chunkNr, QByteArray* rawPayload) const;
+	//last frame with a timestamp not after the given one (us since start of the recording)
+	quint64 frameAtTimestamp(qint64 timestamp) const;
+
+	//decoded payload of a chunk and a copy of a single frame. the last decoded chunk is cached, so reading the frames of a chunk one after
+	//another decodes the chunk only once. not thread safe, use one reader per thread
+	bool readChunk(quint64 chunkNr, QByteArray* rawPayload);
+	bool readFrame(quint64 frameNr, QByteArray* data);
+
+private:
+	QFile file;
+	uchar* data;
+	quint64 size;
+	RecordingFileHeader header;
+	const RecordingChunkEntry* chunks;
+	const RecordingFrameEntry* frames;
+	quint64 chunkCount;
+	quint64 frameCount;
+	QVector<RecordingChunkEntry> rebuiltChunks;
+	QVector<RecordingFrameEntry> rebuiltFrames;
+	QString errorString;
+	qint64 cachedChunk;
+	QByteArray cachedPayload;
+
+	bool validateIndex() const;
+	bool rebuildIndex();
+};
+
+#endif //RECORDINGREADER_H
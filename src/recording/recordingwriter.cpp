@@ -0,0 +1,317 @@
+#include "recordingwriter.h"
+#include <QElapsedTimer>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+//the file is grown in large steps, so the file system can allocate contiguous extents and the writer never waits for block allocation
+#define PREALLOCATION_STEP (1024LL*1024LL*1024LL)
+#define MAX_RECYCLED_BUFFERS 4
+
+
+RecordingWriter::RecordingWriter(QObject *parent)
+	: QThread(parent),
+	  writePos(0),
+	  allocatedSize(0),
+	  finishing(false),
+	  failed(false),
+	  backlogBytes(0),
+	  encodingBacklogBytes(0),
+	  bytesWritten(0),
+	  rawBytesWritten(0),
+	  writingTimeNs(0)
+{
+	memset(&this->header, 0, sizeof(this->header));
+}
+
+RecordingWriter::~RecordingWriter() {
+	this->finish();
+	this->wait();
+}
+
+bool RecordingWriter::open(const QString& filePath, const RecordingFileHeader& header) {
+	this->filePath = filePath;
+	this->file.setFileName(filePath);
+	if(!this->file.open(QIODevice::ReadWrite | QIODevice::Truncate | QIODevice::Unbuffered)){
+		return false;
+	}
+	this->header = header;
+	memcpy(this->header.magic, RecordingFormat::MAGIC, sizeof(this->header.magic));
+	this->header.version = RecordingFormat::VERSION;
+	this->header.headerSize = RecordingFormat::HEADER_SIZE;
+	this->header.finalized = 0;
+
+	QByteArray headerBlock(RecordingFormat::HEADER_SIZE, '\0');
+	memcpy(headerBlock.data(), &this->header, sizeof(this->header));
+	if(this->file.write(headerBlock) != headerBlock.size()){
+		this->file.close();
+		return false;
+	}
+	this->writePos = RecordingFormat::HEADER_SIZE;
+	return true;
+}
+
+void RecordingWriter::enqueue(const RecordingChunk& chunk) {
+	QMutexLocker locker(&this->mutex);
+	QSharedPointer<RecordingChunk> queuedChunk(new RecordingChunk(chunk));
+	queuedChunk->ready = true;
+	this->queue.enqueue(queuedChunk);
+	this->backlogBytes += chunk.payload.size();
+	this->condition.wakeAll();
+}
+
+QSharedPointer<RecordingChunk> RecordingWriter::enqueuePending(const RecordingChunk& chunk) {
+	QMutexLocker locker(&this->mutex);
+	QSharedPointer<RecordingChunk> queuedChunk(new RecordingChunk(chunk));
+	queuedChunk->ready = false;
+	this->queue.enqueue(queuedChunk);
+	this->backlogBytes += chunk.payload.size();
+	this->encodingBacklogBytes += chunk.payload.size();
+	return queuedChunk;
+}
+
+void RecordingWriter::completeChunk(const QSharedPointer<RecordingChunk>& chunk, const QByteArray& payload, quint32 codec, qint64 encodingTimeNs) {
+	QMutexLocker locker(&this->mutex);
+	this->encodingBacklogBytes -= chunk->payload.size();
+	this->backlogBytes -= chunk->payload.size();
+	this->codecStatistics.encodingTimeNs += encodingTimeNs;
+	if(codec == RecordingFormat::RAW){
+		this->codecStatistics.chunksStored++;
+	} else {
+		this->codecStatistics.chunksEncoded++;
+		this->codecStatistics.rawBytes += static_cast<quint64>(chunk->payload.size());
+		this->codecStatistics.encodedBytes += static_cast<quint64>(payload.size());
+		//the raw buffer is not needed anymore and can be used for one of the next chunks
+		QByteArray rawPayload = chunk->payload;
+		chunk->payload = payload;
+		this->recycleBuffer(rawPayload);
+	}
+	chunk->codec = codec;
+	chunk->ready = true;
+	this->backlogBytes += chunk->payload.size();
+	this->condition.wakeAll();
+}
+
+void RecordingWriter::finish() {
+	QMutexLocker locker(&this->mutex);
+	this->finishing = true;
+	this->condition.wakeAll();
+}
+
+qint64 RecordingWriter::getBacklogBytes() {
+	QMutexLocker locker(&this->mutex);
+	return this->backlogBytes;
+}
+
+int RecordingWriter::getBacklogChunks() {
+	QMutexLocker locker(&this->mutex);
+	return this->queue.size();
+}
+
+quint64 RecordingWriter::getBytesWritten() {
+	QMutexLocker locker(&this->mutex);
+	return this->bytesWritten;
+}
+
+quint64 RecordingWriter::getChunksWritten() {
+	QMutexLocker locker(&this->mutex);
+	return this->chunkIndex.size();
+}
+
+double RecordingWriter::getWriteRate() {
+	QMutexLocker locker(&this->mutex);
+	if(this->writingTimeNs <= 0){
+		return 0.0;
+	}
+	return (this->bytesWritten/(1024.0*1024.0)) / (this->writingTimeNs/1.0e9);
+}
+
+bool RecordingWriter::hasFailed() {
+	QMutexLocker locker(&this->mutex);
+	return this->failed;
+}
+
+qint64 RecordingWriter::getEncodingBacklogBytes() {
+	QMutexLocker locker(&this->mutex);
+	return this->encodingBacklogBytes;
+}
+
+quint64 RecordingWriter::getRawBytesWritten() {
+	QMutexLocker locker(&this->mutex);
+	return this->rawBytesWritten;
+}
+
+RecordingCodecStatistics RecordingWriter::getCodecStatistics() {
+	QMutexLocker locker(&this->mutex);
+	return this->codecStatistics;
+}
+
+QByteArray RecordingWriter::takeRecycledBuffer() {
+	QMutexLocker locker(&this->mutex);
+	if(this->recycledBuffers.isEmpty()){
+		return QByteArray();
+	}
+	return this->recycledBuffers.takeLast();
+}
+
+void RecordingWriter::run() {
+	//the first preallocation is done here and not in open(), which runs on the gui thread: without native support in the file system
+	//posix_fallocate writes every block and takes seconds. it overlaps with collecting the first chunk
+	if(!this->reserveSpace(PREALLOCATION_STEP)){
+		QMutexLocker locker(&this->mutex);
+		this->failed = true;
+		locker.unlock();
+		emit writeError(tr("Could not allocate space for recording file ") + this->filePath + ": " + this->file.errorString());
+	}
+
+	QElapsedTimer timer;
+	forever {
+		QSharedPointer<RecordingChunk> chunk;
+		bool skip;
+		{
+			//the oldest chunk is written first, even if younger chunks have been encoded already
+			QMutexLocker locker(&this->mutex);
+			while(this->queue.isEmpty() ? !this->finishing : !this->queue.head()->ready){
+				this->condition.wait(&this->mutex);
+			}
+			if(this->queue.isEmpty()){
+				break;
+			}
+			chunk = this->queue.dequeue();
+			skip = this->failed;
+		}
+
+		//after a write error the remaining chunks are discarded, so the memory of the backlog is released
+		timer.start();
+		bool success = skip || this->writeChunk(*chunk);
+		qint64 elapsed = timer.nsecsElapsed();
+
+		QMutexLocker locker(&this->mutex);
+		this->backlogBytes -= chunk->payload.size();
+		if(!skip){
+			this->writingTimeNs += elapsed;
+			if(success){
+				this->bytesWritten += chunk->payload.size();
+				this->rawBytesWritten += chunk->rawSize;
+			} else {
+				this->failed = true;
+				locker.unlock();
+				emit writeError(tr("Could not write to recording file ") + this->filePath + ": " + this->file.errorString());
+				locker.relock();
+			}
+		}
+		if(chunk->codec == RecordingFormat::RAW){
+			this->recycleBuffer(chunk->payload);
+		}
+	}
+
+	if(!this->failed && !this->writeIndex()){
+		emit writeError(tr("Could not finalize recording file ") + this->filePath + ": " + this->file.errorString());
+	}
+	this->file.close();
+	emit recordingFinished(this->filePath);
+}
+
+void RecordingWriter::recycleBuffer(QByteArray& buffer) {
+	//has to be called with locked mutex. the buffer is taken over, so it is not shared and keeps its capacity when it is cleared
+	if(this->recycledBuffers.size() < MAX_RECYCLED_BUFFERS){
+		QByteArray recycled;
+		recycled.swap(buffer);
+		recycled.resize(0);
+		this->recycledBuffers.append(recycled);
+	}
+}
+
+bool RecordingWriter::writeChunk(RecordingChunk& chunk) {
+	RecordingChunkHeader chunkHeader;
+	memset(&chunkHeader, 0, sizeof(chunkHeader));
+	chunkHeader.magic = RecordingFormat::CHUNK_MAGIC;
+	chunkHeader.frameCount = static_cast<quint32>(chunk.frames.size());
+	chunkHeader.codec = chunk.codec;
+	chunkHeader.payloadSize = static_cast<quint64>(chunk.payload.size());
+	chunkHeader.rawSize = chunk.rawSize;
+
+	quint32 chunkNr = static_cast<quint32>(this->chunkIndex.size());
+	for(RecordingFrameEntry& entry : chunk.frames){
+		entry.chunk = chunkNr;
+		this->header.frameSize = qMax(this->header.frameSize, entry.size);
+	}
+
+	//chunk header and frame table are written with a single call, followed by the payload
+	int tableSize = chunk.frames.size()*static_cast<int>(sizeof(RecordingFrameEntry));
+	chunkHeader.checksum = RecordingFormat::checksum(1, reinterpret_cast<const uchar*>(chunk.frames.constData()), static_cast<quint64>(tableSize));
+	chunkHeader.checksum = RecordingFormat::checksum(chunkHeader.checksum, reinterpret_cast<const uchar*>(chunk.payload.constData()), chunkHeader.payloadSize);
+	QByteArray head(static_cast<int>(sizeof(RecordingChunkHeader)) + tableSize, Qt::Uninitialized);
+	memcpy(head.data(), &chunkHeader, sizeof(chunkHeader));
+	memcpy(head.data() + sizeof(chunkHeader), chunk.frames.constData(), static_cast<size_t>(tableSize));
+
+	quint64 chunkSize = RecordingFormat::align(static_cast<quint64>(head.size()) + chunkHeader.payloadSize);
+	if(!this->reserveSpace(this->writePos + chunkSize) || !this->file.seek(static_cast<qint64>(this->writePos))){
+		return false;
+	}
+	if(this->file.write(head) != head.size() || this->file.write(chunk.payload) != chunk.payload.size()){
+		return false;
+	}
+
+	RecordingChunkEntry chunkEntry;
+	chunkEntry.fileOffset = this->writePos;
+	chunkEntry.firstFrame = static_cast<quint64>(this->frameIndex.size());
+	chunkEntry.frameCount = chunkHeader.frameCount;
+	chunkEntry.codec = chunkHeader.codec;
+	chunkEntry.payloadSize = chunkHeader.payloadSize;
+	{
+		QMutexLocker locker(&this->mutex);
+		this->chunkIndex.append(chunkEntry);
+	}
+	this->frameIndex += chunk.frames;
+	this->writePos += chunkSize;
+	return true;
+}
+
+bool RecordingWriter::writeIndex() {
+	this->header.dataEnd = this->writePos;
+	this->header.chunkCount = static_cast<quint64>(this->chunkIndex.size());
+	this->header.frameCount = static_cast<quint64>(this->frameIndex.size());
+	this->header.chunkIndexOffset = this->writePos;
+	this->header.frameIndexOffset = this->writePos + this->header.chunkCount*sizeof(RecordingChunkEntry);
+	quint64 end = this->header.frameIndexOffset + this->header.frameCount*sizeof(RecordingFrameEntry);
+
+	if(!this->file.seek(static_cast<qint64>(this->writePos))){
+		return false;
+	}
+	qint64 chunkIndexSize = static_cast<qint64>(this->header.chunkCount*sizeof(RecordingChunkEntry));
+	qint64 frameIndexSize = static_cast<qint64>(this->header.frameCount*sizeof(RecordingFrameEntry));
+	if(this->file.write(reinterpret_cast<const char*>(this->chunkIndex.constData()), chunkIndexSize) != chunkIndexSize){
+		return false;
+	}
+	if(this->file.write(reinterpret_cast<const char*>(this->frameIndex.constData()), frameIndexSize) != frameIndexSize){
+		return false;
+	}
+
+	//release the unused part of the preallocated space and mark the file as complete
+	if(!this->file.resize(static_cast<qint64>(end))){
+		return false;
+	}
+	this->header.finalized = 1;
+	return this->file.seek(0) && this->file.write(reinterpret_cast<const char*>(&this->header), sizeof(this->header)) == sizeof(this->header) && this->file.flush();
+}
+
+bool RecordingWriter::reserveSpace(quint64 size) {
+	if(size <= this->allocatedSize){
+		return true;
+	}
+	quint64 newSize = qMax(size, this->allocatedSize + PREALLOCATION_STEP);
+#ifdef Q_OS_LINUX
+	//unlike resize(), posix_fallocate really allocates the blocks instead of creating a sparse file
+	if(posix_fallocate(this->file.handle(), 0, static_cast<off_t>(newSize)) == 0){
+		this->allocatedSize = newSize;
+		return true;
+	}
+#endif
+	if(!this->file.resize(static_cast<qint64>(newSize))){
+		return false;
+	}
+	this->allocatedSize = newSize;
+	return true;
+}
@@ -0,0 +1,101 @@
+#ifndef RECORDINGWRITER_H
+#define RECORDINGWRITER_H
+
+#include <QThread>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QVector>
+#include <QByteArray>
+#include <QSharedPointer>
+#include "recordingformat.h"
+
+
+struct RecordingChunk {
+	QByteArray payload;
+	QVector<RecordingFrameEntry> frames;
+	quint32 codec = RecordingFormat::RAW;
+	quint64 rawSize = 0;
+	bool ready = true; //false while the payload is being encoded
+};
+
+struct RecordingCodecStatistics {
+	quint64 chunksEncoded = 0;
+	quint64 chunksStored = 0; //chunks that were stored uncompressed although compression was enabled
+	quint64 rawBytes = 0; //input of the encoded chunks
+	quint64 encodedBytes = 0;
+	qint64 encodingTimeNs = 0; //summed over all encoding threads
+};
+
+
+//dedicated thread that writes chunks sequentially into a preallocated recording file. chunks are queued by enqueue(), the queued bytes are the
+//backlog of the writer. chunks that are encoded in parallel are queued with enqueuePending() and completed by completeChunk(), the writer
+//keeps the queue order, so chunks are written in recording order even if they are encoded out of order.
+//after finish() the remaining chunks are written, followed by the index and the finalized file header
+class RecordingWriter : public QThread
+{
+	Q_OBJECT
+public:
+	explicit RecordingWriter(QObject *parent = nullptr);
+	~RecordingWriter();
+
+	//creates the file and writes a preliminary header, the space for the chunks is preallocated by the thread. has to be called before start()
+	bool open(const QString& filePath, const RecordingFileHeader& header);
+	void enqueue(const RecordingChunk& chunk);
+	QSharedPointer<RecordingChunk> enqueuePending(const RecordingChunk& chunk);
+	//called from the encoding thread. a codec of RecordingFormat::RAW keeps the original payload
+	void completeChunk(const QSharedPointer<RecordingChunk>& chunk, const QByteArray& payload, quint32 codec, qint64 encodingTimeNs);
+	//no more chunks will be enqueued. the thread finalizes the file and quits
+	void finish();
+
+	QString getFilePath() const {return this->filePath;}
+	qint64 getBacklogBytes();
+	int getBacklogChunks();
+	quint64 getBytesWritten();
+	quint64 getChunksWritten();
+	double getWriteRate(); //MB/s while writing
+	bool hasFailed();
+	qint64 getEncodingBacklogBytes(); //raw bytes of chunks that are still being encoded
+	quint64 getRawBytesWritten(); //bytes before encoding
+	RecordingCodecStatistics getCodecStatistics();
+
+	//payload buffer of an already written chunk, so the recorder does not need to allocate a new buffer for every chunk
+	QByteArray takeRecycledBuffer();
+
+protected:
+	void run() override;
+
+private:
+	QString filePath;
+	QFile file;
+	RecordingFileHeader header;
+	quint64 writePos;
+	quint64 allocatedSize;
+	QVector<RecordingChunkEntry> chunkIndex;
+	QVector<RecordingFrameEntry> frameIndex;
+
+	QMutex mutex;
+	QWaitCondition condition;
+	QQueue<QSharedPointer<RecordingChunk>> queue;
+	QList<QByteArray> recycledBuffers;
+	bool finishing;
+	bool failed;
+	qint64 backlogBytes;
+	qint64 encodingBacklogBytes;
+	quint64 bytesWritten;
+	quint64 rawBytesWritten;
+	RecordingCodecStatistics codecStatistics;
+	qint64 writingTimeNs;
+
+	void recycleBuffer(QByteArray& buffer);
+	bool writeChunk(RecordingChunk& chunk);
+	bool writeIndex();
+	bool reserveSpace(quint64 size);
+
+signals:
+	void writeError(QString message);
+	void recordingFinished(QString filePath);
+};
+
+#endif //RECORDINGWRITER_H
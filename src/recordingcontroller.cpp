@@ -0,0 +1,176 @@
+#include "recordingcontroller.h"
+#include "cameraviewwidget.h"
+#include "workstealingpool.h"
+
+#include <QAction>
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+
+
+RecordingController::RecordingController(CameraViewWidget* view, FrameTapSurface* frameTap)
+	: QObject(view),
+	  view(view),
+	  recorder(new FrameRecorder(this))
+{
+	//recording gets the unmodified camera frames
+	connect(frameTap, &FrameTapSurface::frameAvailable, this->recorder, &FrameRecorder::submitFrame);
+	connect(this->recorder, &FrameRecorder::info, this, &RecordingController::info);
+	connect(this->recorder, &FrameRecorder::error, this, &RecordingController::error);
+	connect(this->recorder, &FrameRecorder::recordingStateChanged, this, &RecordingController::recordingStateChanged);
+
+	this->playback = new PlaybackSource(frameTap, this);
+	connect(this->playback, &PlaybackSource::error, this, &RecordingController::error);
+}
+
+RecordingController::~RecordingController() {
+	this->playback->close();
+	//pending chunks of the recorder refer to it, it waits for them
+	delete this->recorder;
+	this->recorder = nullptr;
+}
+
+void RecordingController::addMenu(QMenu* menu) {
+	QAction *recordAction = menu->addAction(tr("Record camera"));
+	recordAction->setCheckable(true);
+	recordAction->setChecked(this->recorder->isRecording());
+	recordAction->setEnabled(this->recorder->isRecording() || this->view->isCameraActive());
+	connect(recordAction, &QAction::toggled, this, &RecordingController::setRecordingEnabled);
+	QAction *compressionAction = menu->addAction(tr("Compress recording (lossless)"));
+	compressionAction->setCheckable(true);
+	compressionAction->setChecked(this->recorder->isCompressionEnabled());
+	compressionAction->setEnabled(!this->recorder->isRecording());
+	connect(compressionAction, &QAction::toggled, this, &RecordingController::setRecordingCompressionEnabled);
+	if(this->playback->isOpen()){
+		QAction *closeRecordingAction = menu->addAction(tr("Close recording"));
+		connect(closeRecordingAction, &QAction::triggered, this, &RecordingController::closeRecording);
+	} else {
+		QAction *openRecordingAction = menu->addAction(tr("Open recording..."));
+		openRecordingAction->setEnabled(!this->recorder->isRecording());
+		connect(openRecordingAction, &QAction::triggered, this, &RecordingController::openRecordingDialog);
+	}
+}
+
+bool RecordingController::handleKeyPress(QKeyEvent* event) {
+	if((event->modifiers() & Qt::ControlModifier) && (event->key() == Qt::Key_R)){
+		this->setRecordingEnabled(!this->recorder->isRecording());
+	} else if(this->playback->isOpen() && event->key() == Qt::Key_Space){
+		this->playback->setPlaying(!this->playback->isPlaying());
+	} else if(this->playback->isOpen() && (event->key() == Qt::Key_Left || event->key() == Qt::Key_Right)){
+		int frames = (event->modifiers() & Qt::ShiftModifier) ? 10 : 1;
+		this->playback->stepFrames(event->key() == Qt::Key_Left ? -frames : frames);
+	} else if(this->playback->isOpen() && event->key() == Qt::Key_Home){
+		this->playback->seek(0);
+	} else if(this->playback->isOpen() && event->key() == Qt::Key_End){
+		this->playback->seek(this->playback->getFrameCount() - 1);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void RecordingController::setRecordingEnabled(bool enabled) {
+	if(this->recorder->isRecording() == enabled){
+		return;
+	}
+	if(enabled){
+		if(!this->view->isCameraActive()){
+			emit error(tr("Recording not possible, camera is not active."));
+			return;
+		}
+		QDir saveDir(this->view->getSaveDir());
+		QString filePath = saveDir.filePath(this->view->timestampedFileName(QString("recording.") + RecordingFormat::FILE_SUFFIX));
+		this->recorder->start(filePath);
+		emit info(tr("Recording camera to ") + filePath);
+	} else {
+		this->recorder->stop();
+	}
+}
+
+void RecordingController::setRecordingCompressionEnabled(bool enabled) {
+	//the compression setting is applied when the next recording starts
+	if(this->recorder->isCompressionEnabled() == enabled){
+		return;
+	}
+	this->recorder->setCompressionEnabled(enabled);
+	emit recordingCompressionChanged(enabled);
+}
+
+void RecordingController::openRecording(const QString& filePath) {
+	if(this->recorder->isRecording()){
+		emit error(tr("Playback not possible while recording."));
+		return;
+	}
+	this->view->closeCamera();
+	if(!this->playback->open(filePath)){
+		if(this->view->isVisible() && !this->view->getCurrentCamera().isNull()){
+			this->view->openCamera(this->view->getCurrentCamera());
+		}
+		return;
+	}
+	emit info(tr("Playing recording ") + filePath);
+	emit playbackStateChanged(true);
+}
+
+void RecordingController::closePlayback() {
+	if(!this->playback->isOpen()){
+		return;
+	}
+	this->playback->close();
+	emit playbackStateChanged(false);
+}
+
+void RecordingController::closeRecording() {
+	if(!this->playback->isOpen()){
+		return;
+	}
+	this->closePlayback();
+	if(this->view->isVisible() && !this->view->getCurrentCamera().isNull()){
+		this->view->openCamera(this->view->getCurrentCamera());
+	}
+}
+
+void RecordingController::openRecordingDialog() {
+	QString filePath = QFileDialog::getOpenFileName(this->view, tr("Open recording"), this->view->getSaveDir(), tr("Camera recordings (*.%1)").arg(RecordingFormat::FILE_SUFFIX));
+	if(!filePath.isEmpty()){
+		this->openRecording(filePath);
+	}
+}
+
+void RecordingController::drawRecordingIndicator(QPainter* painter) {
+	QRect box(this->view->viewport()->width() - 8 - 64, 8, 64, 22);
+	painter->fillRect(box, QColor(0, 0, 0, 160));
+	painter->setRenderHint(QPainter::Antialiasing, true);
+	painter->setPen(Qt::NoPen);
+	painter->setBrush(QColor(230, 0, 0));
+	painter->drawEllipse(QPointF(box.left() + 12, box.center().y() + 0.5), 5, 5);
+	painter->setPen(Qt::white);
+	painter->drawText(box.adjusted(22, 0, -4, 0), Qt::AlignLeft | Qt::AlignVCenter, tr("REC"));
+}
+
+void RecordingController::updateStatistics(StatisticsView* statisticsView) {
+	RecordingStatistics recording = this->recorder->getStatistics();
+	StatisticsValues values;
+	values << qMakePair(tr("State"), recording.recording ? tr("Recording") : tr("Stopped"));
+	values << qMakePair(tr("File"), recording.filePath.isEmpty() ? QString("-") : QFileInfo(recording.filePath).fileName());
+	values << qMakePair(tr("Duration"), QString("%1 s").arg(recording.durationMs/1000.0, 0, 'f', 1));
+	values << qMakePair(tr("Frames recorded"), QString::number(recording.framesRecorded));
+	values << qMakePair(tr("Frames dropped"), QString::number(recording.framesDropped));
+	values << qMakePair(tr("Chunks written"), QString::number(recording.chunksWritten));
+	values << qMakePair(tr("Data written"), QString("%1 MB").arg(recording.bytesWritten/(1024.0*1024.0), 0, 'f', 1));
+	values << qMakePair(tr("Write rate"), QString("%1 MB/s").arg(recording.writeRate, 0, 'f', 1));
+	values << qMakePair(tr("Writer backlog"), QString("%1 MB (%2 chunks)").arg(recording.backlogBytes/(1024.0*1024.0), 0, 'f', 1).arg(recording.backlogChunks));
+	statisticsView->setSection(tr("Recording"), values);
+
+	StatisticsValues compressionValues;
+	const RecordingCodecStatistics& codec = recording.codec;
+	double codecSeconds = codec.encodingTimeNs/1.0e9;
+	compressionValues << qMakePair(tr("Enabled"), recording.compressionEnabled ? tr("Yes") : tr("No"));
+	compressionValues << qMakePair(tr("Current level"), QString::number(recording.compressionLevel));
+	compressionValues << qMakePair(tr("Compression ratio"), QString("%1 : 1").arg(recording.compressionRatio, 0, 'f', 2));
+	compressionValues << qMakePair(tr("Codec throughput"), QString("%1 MB/s per thread, %2 threads").arg(codecSeconds > 0.0 ? codec.rawBytes/(1024.0*1024.0)/codecSeconds : 0.0, 0, 'f', 0).arg(WorkStealingPool::globalInstance()->getThreadCount()));
+	compressionValues << qMakePair(tr("Chunks compressed"), QString::number(codec.chunksEncoded));
+	compressionValues << qMakePair(tr("Chunks stored uncompressed"), QString::number(codec.chunksStored));
+	compressionValues << qMakePair(tr("Encoder backlog"), QString("%1 MB").arg(recording.encodingBacklogBytes/(1024.0*1024.0), 0, 'f', 1));
+	statisticsView->setSection(tr("Compression"), compressionValues);
+}
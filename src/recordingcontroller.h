@@ -0,0 +1,61 @@
+#ifndef RECORDINGCONTROLLER_H
+#define RECORDINGCONTROLLER_H
+
+#include <QObject>
+#include <QMenu>
+#include <QPainter>
+#include <QKeyEvent>
+#include "framerecorder.h"
+#include "playbacksource.h"
+#include "frametapsurface.h"
+#include "statisticsview.h"
+
+class CameraViewWidget;
+
+
+//recording of the camera of a view and playback of recordings into the same view. the recorder gets the unmodified frames of the view,
+//recordings are played into its FrameTapSurface, so display and analysis stages work on recorded frames like on live frames.
+//the camera of the view is closed while a recording is played and opened again afterwards
+class RecordingController : public QObject
+{
+	Q_OBJECT
+public:
+	explicit RecordingController(CameraViewWidget* view, FrameTapSurface* frameTap);
+	~RecordingController();
+
+	bool isRecording() const {return this->recorder->isRecording();}
+	bool isCompressionEnabled() const {return this->recorder->isCompressionEnabled();}
+	bool isPlaybackActive() const {return this->playback->isOpen();}
+	FrameRecorder* getRecorder() const {return this->recorder;}
+	PlaybackSource* getPlayback() const {return this->playback;}
+
+	void addMenu(QMenu* menu);
+	//recording shortcut (Ctrl+R) and transport keys while a recording is played, returns false if the key is not used
+	bool handleKeyPress(QKeyEvent* event);
+	//viewport coordinates, top right corner
+	void drawRecordingIndicator(QPainter* painter);
+	void updateStatistics(StatisticsView* statisticsView);
+	//closes a played recording without opening the camera again, e.g. because another camera is opened
+	void closePlayback();
+
+private:
+	CameraViewWidget* view;
+	FrameRecorder* recorder;
+	PlaybackSource* playback;
+
+public slots:
+	void setRecordingEnabled(bool enabled);
+	void setRecordingCompressionEnabled(bool enabled);
+	void openRecording(const QString& filePath);
+	void closeRecording();
+	void openRecordingDialog();
+
+signals:
+	void info(QString);
+	void error(QString);
+	void recordingStateChanged(bool recording);
+	void recordingCompressionChanged(bool enabled);
+	void playbackStateChanged(bool active);
+};
+
+#endif //RECORDINGCONTROLLER_H
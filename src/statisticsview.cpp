@@ -0,0 +1,50 @@
+#include "statisticsview.h"
+#include <QHeaderView>
+
+
+StatisticsView::StatisticsView(QWidget *parent)
+	: QWidget(parent, Qt::Tool),
+	layout(new QVBoxLayout(this)),
+	tree(new QTreeWidget(this))
+{
+	this->setWindowTitle(tr("Camera statistics"));
+	this->tree->setColumnCount(2);
+	this->tree->setHeaderLabels(QStringList() << tr("Statistic") << tr("Value"));
+	this->tree->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+	this->tree->setRootIsDecorated(false);
+	this->tree->setSelectionMode(QAbstractItemView::NoSelection);
+	this->layout->setContentsMargins(4, 4, 4, 4);
+	this->layout->addWidget(this->tree);
+	this->resize(360, 320);
+}
+
+StatisticsView::~StatisticsView() {
+}
+
+void StatisticsView::setSection(const QString& section, const StatisticsValues& values) {
+	QTreeWidgetItem* sectionItem = this->sections.value(section, nullptr);
+	if(sectionItem == nullptr){
+		sectionItem = new QTreeWidgetItem(this->tree, QStringList() << section);
+		QFont font = sectionItem->font(0);
+		font.setBold(true);
+		sectionItem->setFont(0, font);
+		sectionItem->setFirstColumnSpanned(true);
+		sectionItem->setExpanded(true);
+		this->sections.insert(section, sectionItem);
+	}
+
+	//reuse the existing rows, so the view does not flicker on every update
+	while(sectionItem->childCount() > values.size()){
+		delete sectionItem->takeChild(sectionItem->childCount() - 1);
+	}
+	for(int i = 0; i < values.size(); i++){
+		QTreeWidgetItem* item = i < sectionItem->childCount() ? sectionItem->child(i) : new QTreeWidgetItem(sectionItem);
+		item->setText(0, values.at(i).first);
+		item->setText(1, values.at(i).second);
+	}
+	sectionItem->setExpanded(true);
+}
+
+void StatisticsView::removeSection(const QString& section) {
+	delete this->sections.take(section);
+}
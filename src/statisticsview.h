@@ -0,0 +1,32 @@
+#ifndef STATISTICSVIEW_H
+#define STATISTICSVIEW_H
+
+#include <QWidget>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include <QPair>
+#include <QHash>
+
+
+typedef QList<QPair<QString, QString>> StatisticsValues;
+
+//tool window that lists statistics of a camera view (recording, compression, ...) in sections. sections are created on first update
+//and keep their position, values of a section are replaced on every update
+class StatisticsView : public QWidget {
+	Q_OBJECT
+
+public:
+	explicit StatisticsView(QWidget *parent = nullptr);
+	~StatisticsView();
+
+public slots:
+	void setSection(const QString& section, const StatisticsValues& values);
+	void removeSection(const QString& section);
+
+private:
+	QVBoxLayout* layout;
+	QTreeWidget* tree;
+	QHash<QString, QTreeWidgetItem*> sections;
+};
+
+#endif //STATISTICSVIEW_H
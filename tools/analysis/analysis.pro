@@ -0,0 +1,42 @@
+#check of the display and analysis stages of the camera extension on synthetic frames with known results
+QT = core gui multimedia
+TEMPLATE = app
+TARGET = analysischeck
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+	analysischeck.cpp \
+	../../src/processing/demosaic.cpp \
+	../../src/processing/displaymipmap.cpp \
+	../../src/processing/frameanalyzer.cpp \
+	../../src/processing/frameconversion.cpp \
+	../../src/processing/lenscalibration.cpp \
+	../../src/processing/lineprofile.cpp \
+	../../src/processing/polarunwrap.cpp \
+	../../src/processing/referencecomparison.cpp \
+	../../src/processing/remaptable.cpp \
+	../../src/processing/roistatistics.cpp \
+	../../src/processing/scanlinespans.cpp \
+	../../src/processing/windowlevel.cpp \
+	../../src/processing/workstealingpool.cpp
+
+HEADERS += \
+	../../src/processing/demosaic.h \
+	../../src/processing/displaymipmap.h \
+	../../src/processing/frameanalyzer.h \
+	../../src/processing/frameconversion.h \
+	../../src/processing/lenscalibration.h \
+	../../src/processing/lineprofile.h \
+	../../src/processing/lumaimage.h \
+	../../src/processing/polarunwrap.h \
+	../../src/processing/referencecomparison.h \
+	../../src/processing/remaptable.h \
+	../../src/processing/roistatistics.h \
+	../../src/processing/scanlinespans.h \
+	../../src/processing/simd.h \
+	../../src/processing/windowlevel.h \
+	../../src/processing/workstealingpool.h
+
+INCLUDEPATH += \
+	../../src/processing
@@ -0,0 +1,481 @@
+//check of the display and analysis stages of the camera extension on synthetic frames with known results: the window/level mapping of
+//16 bit frames and its automatic window, the ROI statistics, the line profile, the polar unwrap, the reference comparison and the display
+//mipmap. the SSE2 kernels have to match their scalar paths exactly, the stages have to reproduce the values of ramps and constant frames,
+//the line profile also through a lens model.
+//the return of the pool workers to normal scheduling after the acquisition governor is checked by tools/governor.
+//usage: analysischeck. returns 1 if a check fails
+#include "windowlevel.h"
+#include "roistatistics.h"
+#include "lineprofile.h"
+#include "polarunwrap.h"
+#include "referencecomparison.h"
+#include "displaymipmap.h"
+#include "lenscalibration.h"
+#include <QVector>
+#include <QLineF>
+#include <QPolygonF>
+#include <QRectF>
+#include <QtMath>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace {
+	int failures = 0;
+
+	void check(bool condition, const char* what) {
+		if(!condition){
+			printf("FAILED: %s\n", what);
+			failures++;
+		}
+	}
+
+	//the analysis stages are run directly instead of through the pool, so every frame is measured and the result is there on return
+	class RoiStatisticsProbe : public RoiStatisticsAnalyzer {
+	public:
+		using RoiStatisticsAnalyzer::analyzeFrame;
+	};
+
+	class LineProfileProbe : public LineProfileAnalyzer {
+	public:
+		using LineProfileAnalyzer::analyzeFrame;
+	};
+
+	class PolarUnwrapProbe : public PolarUnwrapper {
+	public:
+		using PolarUnwrapper::analyzeFrame;
+	};
+
+	//frame with the luma value(x, y) (clamped to 0..255), Y8 or packed 4:2:2 with neutral chroma
+	template<typename Value>
+	QVideoFrame createLumaFrame(QVideoFrame::PixelFormat format, int width, int height, Value value) {
+		const int pixelStep = format == QVideoFrame::Format_Y8 ? 1 : 2;
+		const int lumaOffset = format == QVideoFrame::Format_UYVY ? 1 : 0;
+		const int bytesPerLine = ((width*pixelStep + 3) & ~3) + 4;
+		QVideoFrame frame(bytesPerLine*height, QSize(width, height), bytesPerLine, format);
+		if(frame.map(QAbstractVideoBuffer::WriteOnly)){
+			memset(frame.bits(), 128, bytesPerLine*height);
+			for(int y = 0; y < height; y++){
+				uchar* line = frame.bits() + y*bytesPerLine;
+				for(int x = 0; x < width; x++){
+					line[x*pixelStep + lumaOffset] = static_cast<uchar>(qBound(0, static_cast<int>(value(x, y)), 255));
+				}
+			}
+			frame.unmap();
+		}
+		return frame;
+	}
+
+	QVideoFrame createY16Frame(int width, int height, const QVector<quint16>& values) {
+		const int bytesPerLine = 2*width + 8;
+		QVideoFrame frame(bytesPerLine*height, QSize(width, height), bytesPerLine, QVideoFrame::Format_Y16);
+		if(frame.map(QAbstractVideoBuffer::WriteOnly)){
+			for(int y = 0; y < height; y++){
+				memcpy(frame.bits() + y*bytesPerLine, values.constData() + y*width, 2*width);
+			}
+			frame.unmap();
+		}
+		return frame;
+	}
+
+	void fillRandom(QVector<uchar>& bytes) {
+		for(int i = 0; i < bytes.size(); i++){
+			bytes[i] = static_cast<uchar>(rand());
+		}
+	}
+
+	void checkWindowLevel() {
+		//kernel: SSE2 and scalar path for widths around the vector size and random windows, including inverted and empty ones
+		const int widths[] = {1, 7, 15, 16, 17, 33, 100, 333};
+		bool identical = true;
+		for(int width : widths){
+			const int height = 3;
+			const int srcStride = 2*width + 6;
+			QVector<uchar> source(srcStride*height);
+			fillRandom(source);
+			QVector<quint32> vectorized(width*height);
+			QVector<quint32> scalar(width*height);
+			for(int i = 0; i < 20; i++){
+				const int low = rand() % 65536;
+				const int high = i % 5 == 0 ? rand() % 65536 : low + rand() % (65536 - low);
+				WindowLevel::map(source.constData(), srcStride, width, height, low, high, vectorized.data(), 4*width, true);
+				WindowLevel::map(source.constData(), srcStride, width, height, low, high, scalar.data(), 4*width, false);
+				identical = identical && vectorized == scalar;
+			}
+		}
+		check(identical, "window/level: SSE2 and scalar mapping differ");
+
+		//mapping: every 16 bit value with a window of 1000..5000 within one step below d*255/width (the rounded up fixed point factor may add
+		//a few thousandths), opaque gray
+		QVector<quint16> ramp(65536);
+		for(int i = 0; i < ramp.size(); i++){
+			ramp[i] = static_cast<quint16>(i);
+		}
+		QVector<quint32> mapped(ramp.size());
+		WindowLevel::map(reinterpret_cast<const uchar*>(ramp.constData()), 2*ramp.size(), ramp.size(), 1, 1000, 5000, mapped.data(), 4*ramp.size());
+		bool exact = true;
+		for(int i = 0; i < ramp.size(); i++){
+			const quint32 pixel = mapped.at(i);
+			const int gray = pixel & 0xff;
+			const double expected = qBound(0, i - 1000, 4000)*255.0/4000.0;
+			exact = exact && (pixel >> 24) == 0xff && ((pixel >> 8) & 0xff) == static_cast<quint32>(gray) && ((pixel >> 16) & 0xff) == static_cast<quint32>(gray)
+				&& gray < expected + 0.01 && gray > expected - 1.0;
+		}
+		check(exact, "window/level: mapped values are not d*255/width");
+		check((mapped.at(1000) & 0xff) == 0 && (mapped.at(5000) & 0xff) == 255 && (mapped.at(65535) & 0xff) == 255, "window/level: window ends are not black and white");
+
+		//automatic window of a frame with values 10000..19999, 0.5 % of the samples may saturate at each end, the window is quantized to 16 values
+		const int width = 256;
+		const int height = 256;
+		QVector<quint16> values(width*height);
+		for(int i = 0; i < values.size(); i++){
+			values[i] = static_cast<quint16>(10000 + rand() % 10000);
+		}
+		WindowLevel windowLevel;
+		check(!windowLevel.process(createLumaFrame(QVideoFrame::Format_Y8, 16, 16, [](int, int) {return 0;})).isValid(), "window/level: 8 bit frame was processed");
+		QVideoFrame output = windowLevel.process(createY16Frame(width, height, values));
+		int low = 0;
+		int high = 0;
+		windowLevel.getWindow(&low, &high);
+		check(low >= 9984 && low <= 10200 && high >= 19800 && high <= 20015, "window/level: automatic window does not fit the value range");
+		check(output.isValid() && output.size() == QSize(width, height) && output.pixelFormat() == QVideoFrame::Format_RGB32, "window/level: no RGB32 frame of the frame size");
+		QVector<quint32> expected(width*height);
+		WindowLevel::map(reinterpret_cast<const uchar*>(values.constData()), 2*width, width, height, low, high, expected.data(), 4*width);
+		bool matches = false;
+		if(output.isValid() && output.map(QAbstractVideoBuffer::ReadOnly)){
+			matches = true;
+			for(int y = 0; y < height; y++){
+				matches = matches && memcmp(output.bits() + y*output.bytesPerLine(), expected.constData() + y*width, 4*width) == 0;
+			}
+			output.unmap();
+		}
+		check(matches, "window/level: processed frame differs from the mapping with the automatic window");
+	}
+
+	bool sameAccumulators(const RoiStatisticsAnalyzer::Accumulator& a, const RoiStatisticsAnalyzer::Accumulator& b) {
+		return a.sum == b.sum && a.sumOfSquares == b.sumOfSquares && a.count == b.count && a.min == b.min && a.max == b.max
+			&& memcmp(a.histograms, b.histograms, sizeof(a.histograms)) == 0;
+	}
+
+	void checkRoiStatistics() {
+		//kernel: random spans of any length, and one span of white pixels long enough to flush the 32 bit sums of squares
+		QVector<uchar> pixels(300000);
+		fillRandom(pixels);
+		RoiStatisticsAnalyzer::Accumulator vectorized;
+		RoiStatisticsAnalyzer::Accumulator scalar;
+		for(int i = 0; i < 200; i++){
+			const int count = rand() % 1000;
+			const int offset = rand() % (pixels.size() - count);
+			RoiStatisticsAnalyzer::accumulate(pixels.constData() + offset, count, &vectorized, true);
+			RoiStatisticsAnalyzer::accumulate(pixels.constData() + offset, count, &scalar, false);
+		}
+		check(sameAccumulators(vectorized, scalar), "roi statistics: SSE2 and scalar accumulation differ");
+		QVector<uchar> white(200000, 255);
+		RoiStatisticsAnalyzer::Accumulator whiteVectorized;
+		RoiStatisticsAnalyzer::Accumulator whiteScalar;
+		RoiStatisticsAnalyzer::accumulate(white.constData(), white.size(), &whiteVectorized, true);
+		RoiStatisticsAnalyzer::accumulate(white.constData(), white.size(), &whiteScalar, false);
+		check(sameAccumulators(whiteVectorized, whiteScalar) && whiteVectorized.sumOfSquares == 200000ULL*255*255, "roi statistics: sum of squares overflows");
+
+		//every value once: mean 127.5, standard deviation of the uniform distribution, one count per histogram bin
+		QVector<uchar> allValues(256);
+		for(int i = 0; i < allValues.size(); i++){
+			allValues[i] = static_cast<uchar>(i);
+		}
+		RoiStatisticsAnalyzer::Accumulator accumulator;
+		RoiStatisticsAnalyzer::accumulate(allValues.constData(), allValues.size(), &accumulator);
+		RoiStatistics statistics = RoiStatisticsAnalyzer::finish(accumulator);
+		bool flat = statistics.histogram.size() == 256;
+		for(int i = 0; flat && i < 256; i++){
+			flat = statistics.histogram.at(i) == 1;
+		}
+		check(statistics.valid && statistics.pixelCount == 256 && statistics.mean == 127.5 && qAbs(statistics.stdDev - std::sqrt((256.0*256.0 - 1.0)/12.0)) < 1e-9
+			&& statistics.min == 0 && statistics.max == 255 && flat, "roi statistics: wrong statistics of 0..255");
+
+		//region 0.25..0.75 of a 64x64 ramp x + 2y contains the pixels 16..47 (pixel centers inside)
+		const QVideoFrame::PixelFormat formats[] = {QVideoFrame::Format_Y8, QVideoFrame::Format_YUYV};
+		for(QVideoFrame::PixelFormat format : formats){
+			RoiStatisticsProbe analyzer;
+			RoiStatisticsMap measured;
+			QObject::connect(&analyzer, &RoiStatisticsAnalyzer::roiStatisticsMeasured, [&measured](RoiStatisticsMap statistics) {
+				measured = statistics;
+			});
+			QHash<QString, QPolygonF> regions;
+			regions.insert("square", QPolygonF(QRectF(0.25, 0.25, 0.5, 0.5)));
+			analyzer.setRegions(regions);
+			analyzer.analyzeFrame(createLumaFrame(format, 64, 64, [](int x, int y) {return x + 2*y;}));
+			RoiStatistics square = measured.value("square");
+			check(square.valid && square.pixelCount == 1024 && qAbs(square.mean - 94.5) < 1e-9 && square.min == 48 && square.max == 141
+				&& qAbs(square.stdDev - std::sqrt(426.25)) < 1e-9, format == QVideoFrame::Format_Y8 ? "roi statistics: wrong statistics of a Y8 region" : "roi statistics: wrong statistics of a YUYV region");
+		}
+	}
+
+	void checkLineProfile() {
+		const QVideoFrame::PixelFormat formats[] = {QVideoFrame::Format_Y8, QVideoFrame::Format_YUYV};
+		for(QVideoFrame::PixelFormat format : formats){
+			LineProfileProbe analyzer;
+			LineProfile measured;
+			QObject::connect(&analyzer, &LineProfileAnalyzer::lineProfileMeasured, [&measured](LineProfile profile) {
+				measured = profile;
+			});
+
+			//horizontal line on a ramp in x, from the center of pixel (10, 32) to the center of pixel (200, 32): one sample per pixel center
+			const QVideoFrame horizontal = createLumaFrame(format, 256, 64, [](int x, int) {return x;});
+			analyzer.setLine(QLineF((10 + 0.5)/256.0, (32 + 0.5)/64.0, (200 + 0.5)/256.0, (32 + 0.5)/64.0));
+			for(int averagingWidth : {1, 5}){
+				measured = LineProfile();
+				analyzer.setAveragingWidth(averagingWidth);
+				analyzer.analyzeFrame(horizontal);
+				bool ramp = measured.valid && measured.values.size() == 191 && measured.length == 190.0 && measured.averagingWidth == averagingWidth;
+				for(int i = 0; ramp && i < measured.values.size(); i++){
+					ramp = qAbs(measured.values.at(i) - (10 + i)) < 1e-3;
+				}
+				check(ramp, averagingWidth == 1 ? "line profile: wrong values along a horizontal line" : "line profile: averaging changes the values along a horizontal line");
+			}
+
+			//diagonal on x + y: the bilinear samples of a linear ramp are exact up to the 1/16 px weights
+			const QVideoFrame diagonal = createLumaFrame(format, 128, 128, [](int x, int y) {return x + y;});
+			analyzer.setAveragingWidth(1);
+			analyzer.setLine(QLineF((5 + 0.5)/128.0, (5 + 0.5)/128.0, (100 + 0.5)/128.0, (100 + 0.5)/128.0));
+			measured = LineProfile();
+			analyzer.analyzeFrame(diagonal);
+			const int count = qRound(95.0*std::sqrt(2.0)) + 1;
+			bool ramp = measured.valid && measured.values.size() == count;
+			for(int i = 0; ramp && i < count; i++){
+				ramp = qAbs(measured.values.at(i) - 2.0*(5.0 + 95.0*i/(count - 1))) < 0.1;
+			}
+			check(ramp, "line profile: wrong values along a diagonal line");
+
+			//while the display is undistorted the line is given in the undistorted frame and read at the source positions of its samples
+			LensModel model;
+			model.imageSize = QSize(512, 128);
+			model.fx = 400.0;
+			model.fy = 400.0;
+			model.cx = 255.5;
+			model.cy = 63.5;
+			model.k1 = 0.1;
+			const LensModel scaledModel = model.scaledTo(QSize(256, 64));
+			analyzer.setLensModel(model);
+			analyzer.setLine(QLineF((10 + 0.5)/256.0, (32 + 0.5)/64.0, (200 + 0.5)/256.0, (32 + 0.5)/64.0));
+			measured = LineProfile();
+			analyzer.analyzeFrame(horizontal);
+			ramp = measured.valid && measured.values.size() == 191;
+			for(int i = 0; ramp && i < measured.values.size(); i++){
+				ramp = qAbs(measured.values.at(i) - scaledModel.distort(QPointF(10 + i, 32)).x()) < 0.1;
+			}
+			check(ramp, "line profile: line is not read at the source positions of the lens model");
+			analyzer.setLensModel(LensModel());
+		}
+	}
+
+	void checkPolarUnwrap() {
+		//circle of radius 40 around the center of a 256x256 frame, band 50 %: rows from radius 20 to 60, one column per pixel of circumference.
+		//a ramp in x (or y) has to show up as the cosine (or sine) of the column angle, clockwise from 3 o'clock
+		PolarUnwrapProbe unwrapper;
+		PolarStrip measured;
+		QObject::connect(&unwrapper, &PolarUnwrapper::polarStripMeasured, [&measured](PolarStrip strip) {
+			measured = strip;
+		});
+		unwrapper.setCircle(QPointF(0.5, 0.5), QPointF((128.0 + 40.0)/256.0, 0.5));
+		unwrapper.setBand(50);
+		const int width = qCeil(2.0*M_PI*40.0);
+		for(int axis = 0; axis < 2; axis++){
+			measured = PolarStrip();
+			unwrapper.analyzeFrame(createLumaFrame(QVideoFrame::Format_Y8, 256, 256, [axis](int x, int y) {return axis == 0 ? x : y;}));
+			bool geometry = measured.valid && measured.image.format() == QImage::Format_Grayscale8 && measured.image.size() == QSize(width, 41)
+				&& measured.radius == 40.0 && measured.innerRadius == 20.0 && measured.outerRadius == 60.0;
+			check(geometry, "polar unwrap: wrong strip geometry");
+			if(!geometry){
+				continue;
+			}
+			bool unwrapped = true;
+			for(int y = 0; y < measured.image.height(); y++){
+				const uchar* line = measured.image.constScanLine(y);
+				const double radius = 20.0 + y;
+				for(int x = 0; x < width; x++){
+					const double angle = 2.0*M_PI*(x + 0.5)/width;
+					const double expected = 127.5 + radius*(axis == 0 ? std::cos(angle) : std::sin(angle));
+					unwrapped = unwrapped && qAbs(line[x] - expected) <= 1.0;
+				}
+			}
+			check(unwrapped, axis == 0 ? "polar unwrap: wrong values on a ramp in x" : "polar unwrap: wrong values on a ramp in y");
+		}
+	}
+
+	QVideoFrame createConstantFrame(QVideoFrame::PixelFormat format, int width, int height, const quint8 pattern[4], int period) {
+		const int bytesPerPixel = format == QVideoFrame::Format_Y8 ? 1 : (format == QVideoFrame::Format_RGB32 ? 4 : 2);
+		const int bytesPerLine = width*bytesPerPixel;
+		QVideoFrame frame(bytesPerLine*height, QSize(width, height), bytesPerLine, format);
+		if(frame.map(QAbstractVideoBuffer::WriteOnly)){
+			for(int i = 0; i < bytesPerLine*height; i++){
+				frame.bits()[i] = pattern[i % period];
+			}
+			frame.unmap();
+		}
+		return frame;
+	}
+
+	bool frameMatches(QVideoFrame frame, const quint8 pattern[4], int period) {
+		if(!frame.isValid() || !frame.map(QAbstractVideoBuffer::ReadOnly)){
+			return false;
+		}
+		bool matches = true;
+		for(int y = 0; y < frame.height(); y++){
+			const uchar* line = frame.bits() + y*frame.bytesPerLine();
+			for(int i = 0; i < frame.bytesPerLine(); i++){
+				matches = matches && line[i] == pattern[i % period];
+			}
+		}
+		frame.unmap();
+		return matches;
+	}
+
+	void checkReferenceComparison() {
+		//kernel: both modes with random weights, gains and byte classes for counts around the vector size
+		QVector<uchar> live(1000);
+		QVector<uchar> reference(1000);
+		fillRandom(live);
+		fillRandom(reference);
+		QVector<uchar> vectorized(live.size());
+		QVector<uchar> scalar(live.size());
+		bool identical = true;
+		for(int i = 0; i < 100; i++){
+			ReferenceComparison::Pass pass;
+			pass.mode = i % 2 == 0 ? ReferenceComparison::ONION_SKIN : ReferenceComparison::DIFFERENCE;
+			pass.weight = rand() % (ReferenceComparison::WEIGHT_ONE + 1);
+			pass.gainShift = rand() % 4;
+			for(int k = 0; k < 16; k++){
+				pass.mask[k] = rand() % 2 == 0 ? 0xff : 0;
+				pass.fill[k] = pass.mask[k] != 0 ? 0 : static_cast<quint8>(rand());
+			}
+			const int count = rand() % live.size();
+			ReferenceComparison::compare(live.constData(), reference.constData(), vectorized.data(), count, pass, true);
+			ReferenceComparison::compare(live.constData(), reference.constData(), scalar.data(), count, pass, false);
+			identical = identical && memcmp(vectorized.constData(), scalar.constData(), count) == 0;
+		}
+		check(identical, "reference comparison: SSE2 and scalar kernel differ");
+
+		//gray 100 as reference (Y8 100, BT.601 Y 102 with neutral chroma)
+		QImage referenceImage(40, 30, QImage::Format_RGB32);
+		referenceImage.fill(qRgb(100, 100, 100));
+		ReferenceComparison comparison;
+		comparison.setReference(referenceImage);
+		ReferenceComparisonSettings settings;
+		settings.mode = ReferenceComparison::DIFFERENCE;
+		comparison.setSettings(settings);
+		check(comparison.isActive(), "reference comparison: not active with reference and mode");
+
+		const quint8 liveY8[4] = {130};
+		const quint8 differenceY8[4] = {30};
+		check(frameMatches(comparison.process(createConstantFrame(QVideoFrame::Format_Y8, 40, 30, liveY8, 1)), differenceY8, 1), "reference comparison: wrong Y8 difference");
+		settings.gain = 2;
+		comparison.setSettings(settings);
+		const quint8 amplifiedY8[4] = {60};
+		check(frameMatches(comparison.process(createConstantFrame(QVideoFrame::Format_Y8, 40, 30, liveY8, 1)), amplifiedY8, 1), "reference comparison: wrong amplified Y8 difference");
+		settings.gain = 1;
+
+		//b, g, r, a in memory: difference per colour byte, opaque alpha
+		const quint8 liveRgb[4] = {64, 96, 128, 0};
+		const quint8 differenceRgb[4] = {36, 4, 28, 0xff};
+		comparison.setSettings(settings);
+		check(frameMatches(comparison.process(createConstantFrame(QVideoFrame::Format_RGB32, 40, 30, liveRgb, 4)), differenceRgb, 4), "reference comparison: wrong RGB32 difference");
+
+		//Y U Y V: difference of the luma, neutral chroma
+		const quint8 liveYuyv[4] = {130, 90, 130, 170};
+		const quint8 differenceYuyv[4] = {28, 128, 28, 128};
+		check(frameMatches(comparison.process(createConstantFrame(QVideoFrame::Format_YUYV, 40, 30, liveYuyv, 4)), differenceYuyv, 4), "reference comparison: wrong YUYV difference");
+
+		//half of each: (130 + 100)/2 rounded down by the 7 bit weights
+		settings.mode = ReferenceComparison::ONION_SKIN;
+		settings.opacity = 0.5;
+		comparison.setSettings(settings);
+		const quint8 blendedY8[4] = {115};
+		check(frameMatches(comparison.process(createConstantFrame(QVideoFrame::Format_Y8, 40, 30, liveY8, 1)), blendedY8, 1), "reference comparison: wrong Y8 onion skin");
+
+		settings.mode = ReferenceComparison::OFF;
+		comparison.setSettings(settings);
+		check(!comparison.isActive() && !comparison.process(createConstantFrame(QVideoFrame::Format_Y8, 40, 30, liveY8, 1)).isValid(), "reference comparison: frame was processed while off");
+	}
+
+	void checkDisplayMipmap() {
+		struct LevelCase {
+			qreal scale;
+			int level;
+		};
+		const LevelCase levels[] = {{2.0, 0}, {1.0, 0}, {0.75, 0}, {0.5, 1}, {0.3, 1}, {0.25, 2}, {0.001, DisplayMipmap::MAX_LEVEL}, {0.0, 0}, {-1.0, 0}};
+		bool levelsMatch = true;
+		for(const LevelCase& levelCase : levels){
+			levelsMatch = levelsMatch && DisplayMipmap::levelForScale(levelCase.scale) == levelCase.level;
+		}
+		check(levelsMatch, "display mipmap: wrong level for the view scale");
+
+		//kernel: every layout for counts around the vector size
+		const DisplayMipmap::Layout layouts[] = {DisplayMipmap::BYTES_1, DisplayMipmap::BYTES_2, DisplayMipmap::BYTES_4, DisplayMipmap::YUYV, DisplayMipmap::UYVY};
+		QVector<uchar> a(2048);
+		QVector<uchar> b(2048);
+		QVector<uchar> vectorized(1024);
+		QVector<uchar> scalar(1024);
+		bool identical = true;
+		for(DisplayMipmap::Layout layout : layouts){
+			const int unitBytes = layout == DisplayMipmap::BYTES_1 ? 1 : (layout == DisplayMipmap::BYTES_2 ? 2 : 4);
+			for(int count = 1; count <= 1024/unitBytes; count += 1 + count/8){
+				fillRandom(a);
+				fillRandom(b);
+				DisplayMipmap::downsampleRow(a.constData(), b.constData(), vectorized.data(), count, layout, true);
+				DisplayMipmap::downsampleRow(a.constData(), b.constData(), scalar.data(), count, layout, false);
+				identical = identical && memcmp(vectorized.constData(), scalar.constData(), count*unitBytes) == 0;
+			}
+		}
+		check(identical, "display mipmap: SSE2 and scalar kernel differ");
+
+		//level 1 of a 256x256 Y8 frame: 2x2 box filter with the rounding of two successive byte averages
+		const int width = 256;
+		const int height = 256;
+		QVector<uchar> values(width*height);
+		fillRandom(values);
+		const QVideoFrame frame = createLumaFrame(QVideoFrame::Format_Y8, width, height, [&values](int x, int y) {return values.at(y*width + x);});
+		DisplayMipmap mipmap;
+		mipmap.setViewScale(1.0);
+		check(!mipmap.isActive() && !mipmap.process(frame).isValid(), "display mipmap: frame reduced at full scale");
+		mipmap.setViewScale(0.5);
+		QVideoFrame reduced = mipmap.process(frame);
+		bool filtered = false;
+		if(reduced.isValid() && reduced.size() == QSize(width/2, height/2) && reduced.pixelFormat() == QVideoFrame::Format_Y8
+				&& reduced.map(QAbstractVideoBuffer::ReadOnly)){
+			filtered = true;
+			for(int y = 0; y < height/2; y++){
+				const uchar* line = reduced.bits() + y*reduced.bytesPerLine();
+				for(int x = 0; x < width/2; x++){
+					const int v0 = (values.at(2*y*width + 2*x) + values.at((2*y + 1)*width + 2*x) + 1) >> 1;
+					const int v1 = (values.at(2*y*width + 2*x + 1) + values.at((2*y + 1)*width + 2*x + 1) + 1) >> 1;
+					filtered = filtered && line[x] == ((v0 + v1 + 1) >> 1);
+				}
+			}
+			reduced.unmap();
+		}
+		check(filtered && mipmap.getLevel() == 1, "display mipmap: wrong level 1 of a Y8 frame");
+
+		//the levels stop at MIN_SIZE
+		mipmap.setViewScale(0.01);
+		reduced = mipmap.process(frame);
+		check(reduced.isValid() && reduced.size() == QSize(DisplayMipmap::MIN_SIZE, DisplayMipmap::MIN_SIZE) && mipmap.getLevel() == 2, "display mipmap: reduced below the minimum size");
+
+		mipmap.setEnabled(false);
+		check(!mipmap.isActive() && !mipmap.process(frame).isValid(), "display mipmap: frame reduced while disabled");
+	}
+}
+
+
+int main() {
+	srand(1);
+	checkWindowLevel();
+	checkRoiStatistics();
+	checkLineProfile();
+	checkPolarUnwrap();
+	checkReferenceComparison();
+	checkDisplayMipmap();
+	printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+#client and latency/throughput benchmark for the control API of the camera extension
+QT = core network
+TEMPLATE = app
+TARGET = controlbench
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+	controlbench.cpp \
+	controlclient.cpp
+
+HEADERS += \
+	controlclient.h \
+	../../src/control/controlprotocol.h
+
+INCLUDEPATH += \
+	../../src/control
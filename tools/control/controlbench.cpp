@@ -0,0 +1,109 @@
+//latency and throughput benchmark for the control API of the camera extension. the extension has to be active in OCTproZ.
+//usage: controlbench [request count, default 10000] [pipeline depth, default 100] [server name]
+#include "controlclient.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QDataStream>
+#include <algorithm>
+#include <cstdio>
+
+
+static void printLatencies(const char* name, QVector<qint64> latencies) {
+	if(latencies.isEmpty()){
+		printf("%-28s no successful requests\n", name);
+		return;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	double sum = 0.0;
+	for(qint64 latency : latencies){
+		sum += latency;
+	}
+	printf("%-28s mean %8.1f us, p50 %8.1f us, p99 %8.1f us, max %8.1f us (%d requests)\n", name,
+		sum/latencies.size()/1000.0, latencies.at(latencies.size()/2)/1000.0, latencies.at(latencies.size()*99/100)/1000.0, latencies.last()/1000.0, latencies.size());
+}
+
+int main(int argc, char* argv[]) {
+	QCoreApplication app(argc, argv);
+	int count = argc > 1 ? atoi(argv[1]) : 10000;
+	int depth = argc > 2 ? qMax(1, atoi(argv[2])) : 100;
+	QString name = argc > 3 ? QString(argv[3]) : QString(ControlProtocol::SERVER_NAME);
+
+	ControlClient client;
+	if(!client.connectToServer(name)){
+		fprintf(stderr, "could not connect to %s: %s\n", qPrintable(name), qPrintable(client.getErrorString()));
+		return 1;
+	}
+
+	ControlMessage response;
+	if(client.request(ControlProtocol::GET_INFO, QByteArray(), &response) && response.header.viewOrStatus == ControlProtocol::OK){
+		QDataStream in(response.payload);
+		ControlProtocol::initStream(in);
+		quint16 version = 0;
+		quint8 viewCount = 0;
+		QString camera;
+		quint16 width = 0;
+		quint16 height = 0;
+		quint8 flags = 0;
+		in >> version >> viewCount;
+		ControlProtocol::readString(in, &camera);
+		in >> width >> height >> flags;
+		printf("protocol %d, %d views, view 0: %s %dx%d flags %d\n", version, viewCount, qPrintable(camera), width, height, flags);
+	}
+
+	//round trip latency, one request at a time
+	QByteArray payload(16, 'x');
+	QVector<qint64> latencies;
+	QElapsedTimer timer;
+	for(int i = 0; i < count; i++){
+		timer.start();
+		if(client.request(ControlProtocol::PING, payload, &response)){
+			latencies.append(timer.nsecsElapsed());
+		}
+	}
+	printLatencies("ping, sequential", latencies);
+
+	//throughput with pipelined batches, responses have to arrive in request order
+	int received = 0;
+	bool ordered = true;
+	timer.start();
+	for(int sent = 0; sent < count; sent += depth){
+		int batch = qMin(depth, count - sent);
+		quint32 firstId = 0;
+		for(int i = 0; i < batch; i++){
+			quint32 id = client.send(ControlProtocol::PING, payload);
+			firstId = i == 0 ? id : firstId;
+		}
+		for(int i = 0; i < batch; i++){
+			if(!client.receive(&response)){
+				break;
+			}
+			ordered = ordered && response.header.id == firstId + static_cast<quint32>(i);
+			received++;
+		}
+	}
+	double seconds = timer.nsecsElapsed()/1.0e9;
+	printf("%-28s %8.0f requests/s, %.2f us per request, depth %d, %d/%d responses%s\n", "ping, pipelined",
+		received/seconds, seconds*1.0e6/qMax(1, received), depth, received, count, ordered ? "" : ", OUT OF ORDER");
+
+	//downscaled frames, limited by the frame rate of the camera
+	QByteArray frameRequest;
+	QDataStream out(&frameRequest, QIODevice::WriteOnly);
+	ControlProtocol::initStream(out);
+	out << static_cast<quint16>(320) << static_cast<quint16>(240) << static_cast<quint8>(ControlProtocol::FRAME_GRAY8);
+	latencies.clear();
+	int failed = 0;
+	for(int i = 0; i < 20; i++){
+		timer.start();
+		if(client.request(ControlProtocol::GET_FRAME, frameRequest, &response) && response.header.viewOrStatus == ControlProtocol::OK){
+			latencies.append(timer.nsecsElapsed());
+		} else {
+			failed++;
+		}
+	}
+	printLatencies("get frame 320x240 gray", latencies);
+	if(failed > 0){
+		printf("%d frame requests failed (camera not active?)\n", failed);
+	}
+	return 0;
+}
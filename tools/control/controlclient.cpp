@@ -0,0 +1,63 @@
+#include "controlclient.h"
+#include <QElapsedTimer>
+
+
+ControlClient::ControlClient()
+	: nextId(1)
+{
+}
+
+bool ControlClient::connectToServer(const QString& name, int timeoutMs) {
+	this->socket.connectToServer(name);
+	return this->socket.waitForConnected(timeoutMs);
+}
+
+quint32 ControlClient::send(quint8 command, const QByteArray& payload, quint8 view) {
+	ControlProtocol::MessageHeader header;
+	header.payloadSize = static_cast<quint32>(payload.size());
+	header.id = this->nextId++;
+	header.command = command;
+	header.viewOrStatus = view;
+	ControlProtocol::writeHeader(&this->output, header);
+	this->output.append(payload);
+	return header.id;
+}
+
+bool ControlClient::flush() {
+	if(this->output.isEmpty()){
+		return true;
+	}
+	bool success = this->socket.write(this->output) == this->output.size();
+	this->output.clear();
+	this->socket.flush();
+	return success;
+}
+
+bool ControlClient::receive(ControlMessage* response, int timeoutMs) {
+	//queued requests are sent before waiting, otherwise the server would never answer
+	this->flush();
+	QElapsedTimer timer;
+	timer.start();
+	while(true){
+		if(this->input.size() >= ControlProtocol::HEADER_SIZE){
+			ControlProtocol::MessageHeader header = ControlProtocol::readHeader(this->input.constData());
+			int messageSize = ControlProtocol::HEADER_SIZE + static_cast<int>(header.payloadSize);
+			if(this->input.size() >= messageSize){
+				response->header = header;
+				response->payload = this->input.mid(ControlProtocol::HEADER_SIZE, static_cast<int>(header.payloadSize));
+				this->input.remove(0, messageSize);
+				return true;
+			}
+		}
+		qint64 remaining = timeoutMs - timer.elapsed();
+		if(remaining <= 0 || (this->socket.bytesAvailable() == 0 && !this->socket.waitForReadyRead(static_cast<int>(remaining)))){
+			return false;
+		}
+		this->input.append(this->socket.readAll());
+	}
+}
+
+bool ControlClient::request(quint8 command, const QByteArray& payload, ControlMessage* response, quint8 view, int timeoutMs) {
+	this->send(command, payload, view);
+	return this->receive(response, timeoutMs);
+}
@@ -0,0 +1,36 @@
+#ifndef CONTROLCLIENT_H
+#define CONTROLCLIENT_H
+
+#include <QLocalSocket>
+#include <QByteArray>
+#include "controlprotocol.h"
+
+
+struct ControlMessage {
+	ControlProtocol::MessageHeader header;
+	QByteArray payload;
+};
+
+//blocking client for the control API of the camera extension. send() only queues a request, so any number of requests can be sent
+//before their responses are read with receive() (pipelining)
+class ControlClient
+{
+public:
+	ControlClient();
+
+	bool connectToServer(const QString& name = ControlProtocol::SERVER_NAME, int timeoutMs = 1000);
+	QString getErrorString() const {return this->socket.errorString();}
+
+	quint32 send(quint8 command, const QByteArray& payload = QByteArray(), quint8 view = 0);
+	bool flush();
+	bool receive(ControlMessage* response, int timeoutMs = 5000);
+	bool request(quint8 command, const QByteArray& payload, ControlMessage* response, quint8 view = 0, int timeoutMs = 5000);
+
+private:
+	QLocalSocket socket;
+	QByteArray output;
+	QByteArray input;
+	quint32 nextId;
+};
+
+#endif //CONTROLCLIENT_H
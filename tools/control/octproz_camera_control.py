@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""Python client for the control API of the OCTproZ camera extension (protocol: src/control/controlprotocol.h).
+
+    camera = CameraControl()
+    print(camera.get_info())
+    print(camera.take_snapshot(displayed=True))
+    visible, x, y, anchors = camera.get_overlay("Rect overlay")
+    camera.set_overlay("Rect overlay", True, x + 10, y, anchors)
+    width, height, timestamp, pixels = camera.get_frame(320, 240)
+    stats = camera.get_roi_statistics("Rect overlay")
+
+Requests can be pipelined with send() / receive() to avoid a round trip per request.
+"""
+import os
+import socket
+import struct
+import sys
+import tempfile
+
+SERVER_NAME = "octproz_camera_control"
+HEADER = struct.Struct("<IIBBH")
+PING, GET_INFO, TAKE_SNAPSHOT, GET_OVERLAY, SET_OVERLAY, SET_CAMERA, GET_FRAME, GET_ROI_STATISTICS = range(8)
+STATUS = ["ok", "unknown command", "invalid request", "invalid view", "not found", "not available"]
+FRAME_GRAY8, FRAME_RGB888 = 0, 1
+
+
+class ControlError(Exception):
+	pass
+
+
+def _string(text):
+	data = text.encode("utf-8")
+	return struct.pack("<H", len(data)) + data
+
+
+class _Reader:
+	def __init__(self, data):
+		self.data = data
+		self.offset = 0
+
+	def unpack(self, fmt):
+		values = struct.unpack_from("<" + fmt, self.data, self.offset)
+		self.offset += struct.calcsize("<" + fmt)
+		return values
+
+	def string(self):
+		size, = self.unpack("H")
+		text = self.data[self.offset:self.offset + size].decode("utf-8")
+		self.offset += size
+		return text
+
+	def rest(self):
+		return self.data[self.offset:]
+
+
+class CameraControl:
+	def __init__(self, name=SERVER_NAME, view=0):
+		self.view = view
+		self.next_id = 1
+		if sys.platform == "win32":
+			self.pipe = open("\\\\.\\pipe\\" + name, "r+b", buffering=0)
+			self._write, self._read = self.pipe.write, self.pipe.read
+		else:
+			self.socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+			self.socket.connect(os.path.join(tempfile.gettempdir(), name))
+			self._write, self._read = self.socket.sendall, self.socket.recv
+
+	def send(self, command, payload=b""):
+		request_id = self.next_id
+		self.next_id += 1
+		self._write(HEADER.pack(len(payload), request_id, command, self.view, 0) + payload)
+		return request_id
+
+	def _read_exact(self, size):
+		data = b""
+		while len(data) < size:
+			chunk = self._read(size - len(data))
+			if not chunk:
+				raise ControlError("connection closed")
+			data += chunk
+		return data
+
+	def receive(self):
+		"""returns (request id, command, payload) of the next response, raises ControlError if the request failed"""
+		size, request_id, command, status, _ = HEADER.unpack(self._read_exact(HEADER.size))
+		payload = self._read_exact(size)
+		if status != 0:
+			raise ControlError("request %d failed: %s" % (request_id, STATUS[status] if status < len(STATUS) else status))
+		return request_id, command, payload
+
+	def request(self, command, payload=b""):
+		self.send(command, payload)
+		return self.receive()[2]
+
+	def get_info(self):
+		reader = _Reader(self.request(GET_INFO))
+		version, view_count = reader.unpack("HB")
+		camera = reader.string()
+		width, height, flags, overlay_count = reader.unpack("HHBB")
+		overlays = [reader.string() for _ in range(overlay_count)]
+		return {"version": version, "view_count": view_count, "camera": camera, "width": width, "height": height,
+				"camera_active": bool(flags & 1), "playback": bool(flags & 2), "recording": bool(flags & 4), "overlays": overlays}
+
+	def take_snapshot(self, displayed=False):
+		return _Reader(self.request(TAKE_SNAPSHOT, struct.pack("<B", 1 if displayed else 0))).string()
+
+	def get_overlay(self, name):
+		reader = _Reader(self.request(GET_OVERLAY, _string(name)))
+		visible, x, y, count = reader.unpack("BddB")
+		anchors = [reader.unpack("dd") for _ in range(count)]
+		return bool(visible), x, y, anchors
+
+	def set_overlay(self, name, visible, x, y, anchors):
+		payload = _string(name) + struct.pack("<BddB", 1 if visible else 0, x, y, len(anchors))
+		payload += b"".join(struct.pack("<dd", ax, ay) for ax, ay in anchors)
+		self.request(SET_OVERLAY, payload)
+
+	def set_camera(self, device_name=""):
+		self.request(SET_CAMERA, _string(device_name))
+
+	def get_frame(self, max_width, max_height, frame_format=FRAME_GRAY8):
+		"""returns (width, height, timestamp in us, pixel bytes without line padding)"""
+		reader = _Reader(self.request(GET_FRAME, struct.pack("<HHB", max_width, max_height, frame_format)))
+		width, height, _, timestamp = reader.unpack("HHBq")
+		return width, height, timestamp, reader.rest()
+
+	def get_roi_statistics(self, overlay_name):
+		"""intensity statistics inside an overlay, the statistics have to be enabled in the camera view"""
+		reader = _Reader(self.request(GET_ROI_STATISTICS, _string(overlay_name)))
+		pixel_count, mean, std_dev, minimum, maximum, timestamp = reader.unpack("IddBBq")
+		return {"pixel_count": pixel_count, "mean": mean, "std_dev": std_dev, "min": minimum, "max": maximum,
+				"timestamp": timestamp, "histogram": list(reader.unpack("256I"))}
+
+
+if __name__ == "__main__":
+	print(CameraControl().get_info())
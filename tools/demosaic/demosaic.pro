@@ -0,0 +1,19 @@
+#throughput benchmark and check on synthetic mosaics for the Bayer demosaic kernels of the camera extension
+QT = core gui multimedia
+TEMPLATE = app
+TARGET = demosaicbench
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+	demosaicbench.cpp \
+	../../src/processing/demosaic.cpp \
+	../../src/processing/workstealingpool.cpp
+
+HEADERS += \
+	../../src/processing/demosaic.h \
+	../../src/processing/simd.h \
+	../../src/processing/workstealingpool.h
+
+INCLUDEPATH += \
+	../../src/processing
@@ -0,0 +1,168 @@
+//throughput benchmark for the Bayer demosaic kernels of the camera extension, with a check of both kernels on synthetic mosaics:
+//the SSE2 path has to match the scalar path exactly, all four patterns have to reproduce a known image and a uniform colour has to stay uniform.
+//usage: demosaicbench [width, default 2592] [height, default 1944] [iterations, default 50]. returns 1 if a check fails
+#include "demosaic.h"
+#include "workstealingpool.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+
+namespace {
+	//smooth colour ramps in the top half, a diagonal edge and fine vertical stripes in the bottom half
+	QVector<quint32> createImage(int width, int height) {
+		QVector<quint32> image(width*height);
+		for(int y = 0; y < height; y++){
+			for(int x = 0; x < width; x++){
+				int r = x*255/width;
+				int g = y*255/height;
+				int b = (x + y)*255/(width + height);
+				if(y >= height/2){
+					bool bright = x < width/2 ? (x + y) % 64 < 32 : (x/3) % 2 == 0;
+					r = g = b = bright ? 200 : 40;
+				}
+				image[y*width + x] = 0xff000000u | (static_cast<quint32>(r) << 16) | (static_cast<quint32>(g) << 8) | static_cast<quint32>(b);
+			}
+		}
+		return image;
+	}
+
+	//channel 0 red, 1 green, 2 blue of the sample at (x, y)
+	int colorAt(int pattern, int x, int y) {
+		static const char* names[] = {"RGGB", "BGGR", "GRBG", "GBRG"};
+		char c = names[pattern][(y & 1)*2 + (x & 1)];
+		return c == 'R' ? 0 : (c == 'G' ? 1 : 2);
+	}
+
+	QVector<quint8> createMosaic(const QVector<quint32>& image, int width, int height, int pattern) {
+		QVector<quint8> mosaic(width*height);
+		for(int y = 0; y < height; y++){
+			for(int x = 0; x < width; x++){
+				int shift = 16 - 8*colorAt(pattern, x, y);
+				mosaic[y*width + x] = static_cast<quint8>((image.at(y*width + x) >> shift) & 0xff);
+			}
+		}
+		return mosaic;
+	}
+
+	//psnr of the given channels (bit mask, 1 red, 2 green, 4 blue) in the rows y0..y1
+	double psnr(const QVector<quint32>& a, const QVector<quint32>& b, int width, int y0, int y1, int channels) {
+		double squaredError = 0.0;
+		qint64 count = 0;
+		for(int i = y0*width; i < y1*width; i++){
+			for(int channel = 0; channel < 3; channel++){
+				if(channels & (1 << channel)){
+					int shift = 16 - 8*channel;
+					int diff = static_cast<int>((a.at(i) >> shift) & 0xff) - static_cast<int>((b.at(i) >> shift) & 0xff);
+					squaredError += diff*diff;
+					count++;
+				}
+			}
+		}
+		return squaredError > 0.0 ? 10.0*log10(255.0*255.0*count/squaredError) : 99.0;
+	}
+
+	int failures = 0;
+
+	void check(bool condition, const char* what) {
+		if(!condition){
+			printf("FAILED: %s\n", what);
+			failures++;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	int width = argc > 1 ? qMax(8, atoi(argv[1])) : 2592;
+	int height = argc > 2 ? qMax(8, atoi(argv[2])) : 1944;
+	int iterations = argc > 3 ? qMax(1, atoi(argv[3])) : 50;
+	const QStringList methods = Demosaic::methodNames();
+	const QStringList patterns = Demosaic::patternNames();
+	printf("%dx%d (%.1f MP), %d threads\n", width, height, width*height/1.0e6, WorkStealingPool::globalInstance()->getThreadCount());
+
+	//reconstruction of a known image for all patterns and both kernels
+	QVector<quint32> image = createImage(width, height);
+	QVector<quint32> scalar(width*height);
+	QVector<quint32> vectorized(width*height);
+	for(int pattern = Demosaic::RGGB; pattern <= Demosaic::GBRG; pattern++){
+		QVector<quint8> mosaic = createMosaic(image, width, height, pattern);
+		double bilinearEdgesGreen = 0.0;
+		for(int method = Demosaic::BILINEAR; method <= Demosaic::EDGE_AWARE; method++){
+			Demosaic::demosaic(mosaic.constData(), width, width, height, pattern, method, 300, 200, scalar.data(), width*4, false);
+			Demosaic::demosaic(mosaic.constData(), width, width, height, pattern, method, 300, 200, vectorized.data(), width*4, true);
+			check(scalar == vectorized, "vectorized kernel differs from scalar kernel");
+			Demosaic::demosaic(mosaic.constData(), width, width, height, pattern, method, Demosaic::GAIN_ONE, Demosaic::GAIN_ONE, vectorized.data(), width*4, true);
+			double smooth = psnr(image, vectorized, width, 0, height/2, 7);
+			double edgesGreen = psnr(image, vectorized, width, height/2, height, 2);
+			printf("%s %-16s psnr %.1f dB on ramps, green %.1f dB on edges\n", qPrintable(patterns.at(pattern)), qPrintable(methods.at(method)), smooth, edgesGreen);
+			check(smooth > 40.0, "ramps are not reproduced");
+			if(method == Demosaic::BILINEAR){
+				bilinearEdgesGreen = edgesGreen;
+			} else {
+				check(edgesGreen > bilinearEdgesGreen, "edge-aware kernel is not better than the bilinear kernel at edges");
+			}
+		}
+	}
+
+	//a uniform colour must not produce colour fringes at the border or in the interior
+	QVector<quint32> uniform(width*height, 0xff5080b0u);
+	for(int pattern = Demosaic::RGGB; pattern <= Demosaic::GBRG; pattern++){
+		QVector<quint8> mosaic = createMosaic(uniform, width, height, pattern);
+		for(int method = Demosaic::BILINEAR; method <= Demosaic::EDGE_AWARE; method++){
+			Demosaic::demosaic(mosaic.constData(), width, width, height, pattern, method, Demosaic::GAIN_ONE, Demosaic::GAIN_ONE, vectorized.data(), width*4, true);
+			check(vectorized == uniform, "uniform colour is not reproduced");
+		}
+	}
+
+	//small and odd sizes, where most pixels are border pixels of the scalar path
+	for(int h = 1; h <= 5; h++){
+		for(int w = 1; w <= 40; w++){
+			QVector<quint8> mosaic(w*h);
+			for(quint8& sample : mosaic){
+				sample = static_cast<quint8>(rand() & 0xff);
+			}
+			QVector<quint32> a(w*h);
+			QVector<quint32> b(w*h);
+			for(int method = Demosaic::BILINEAR; method <= Demosaic::EDGE_AWARE; method++){
+				Demosaic::demosaic(mosaic.constData(), w, w, h, Demosaic::GRBG, method, 400, 100, a.data(), w*4, false);
+				Demosaic::demosaic(mosaic.constData(), w, w, h, Demosaic::GRBG, method, 400, 100, b.data(), w*4, true);
+				check(a == b, "vectorized kernel differs from scalar kernel for small frames");
+			}
+		}
+	}
+
+	//throughput
+	QVector<quint8> mosaic = createMosaic(image, width, height, Demosaic::RGGB);
+	QVector<quint16> mosaic16(width*height);
+	for(int i = 0; i < mosaic.size(); i++){
+		mosaic16[i] = static_cast<quint16>(mosaic.at(i) << 4);
+	}
+	QElapsedTimer timer;
+	for(int method = Demosaic::BILINEAR; method <= Demosaic::EDGE_AWARE; method++){
+		for(int simd = 0; simd < 2; simd++){
+			timer.start();
+			for(int i = 0; i < iterations; i++){
+				Demosaic::demosaic(mosaic.constData(), width, width, height, Demosaic::RGGB, method, 300, 200, vectorized.data(), width*4, simd != 0);
+			}
+			double ms = timer.nsecsElapsed()/1.0e6/iterations;
+			printf("%-16s %-6s %7.2f ms per frame, %7.1f MP/s\n", qPrintable(methods.at(method)), simd ? "SSE2" : "scalar", ms, width*height/1.0e3/ms);
+		}
+	}
+	QVector<quint8> reduced(width*height);
+	timer.start();
+	for(int i = 0; i < iterations; i++){
+		Demosaic::reduceTo8Bit(reinterpret_cast<const uchar*>(mosaic16.constData()), width*2, width, height, 12, reduced.data(), width);
+	}
+	double ms = timer.nsecsElapsed()/1.0e6/iterations;
+	printf("%-23s %7.2f ms per frame, %7.1f MP/s\n", "16 bit to 8 bit", ms, width*height/1.0e3/ms);
+	check(reduced == mosaic, "16 bit reduction");
+
+	if(failures > 0){
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}
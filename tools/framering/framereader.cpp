@@ -0,0 +1,180 @@
+#include "framereader.h"
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+
+FrameRingReader::FrameRingReader()
+	: segment(nullptr),
+	  segmentSize(0),
+	  header(nullptr),
+	  nextFrame(0),
+	  missedFrames(0)
+{
+}
+
+FrameRingReader::~FrameRingReader() {
+	this->close();
+}
+
+bool FrameRingReader::open(const std::string& name) {
+	this->close();
+	int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if(fd < 0){
+		this->errorString = "could not open " + name + ": " + strerror(errno);
+		return false;
+	}
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < FrameRing::HEADER_SIZE){
+		this->errorString = name + " is not a frame ring";
+		::close(fd);
+		return false;
+	}
+	//mapped writable as readers register themselves in the header, frame data is never written
+	void* address = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(address == MAP_FAILED){
+		this->errorString = "could not map " + name + ": " + strerror(errno);
+		return false;
+	}
+	this->segment = static_cast<uint8_t*>(address);
+	this->segmentSize = static_cast<size_t>(fileStat.st_size);
+	FrameRingHeader* ringHeader = reinterpret_cast<FrameRingHeader*>(this->segment);
+	//the writer fills the header and writes the magic last after a release fence. the magic is read first, the acquire fence after it
+	//orders the reads of the other header fields behind it
+	char magic[sizeof(FrameRing::MAGIC)];
+	memcpy(magic, ringHeader->magic, sizeof(magic));
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if(memcmp(magic, FrameRing::MAGIC, sizeof(FrameRing::MAGIC)) != 0 || ringHeader->version != FrameRing::VERSION
+			|| FrameRing::HEADER_SIZE + ringHeader->slotCount*ringHeader->slotSize > this->segmentSize){
+		this->errorString = name + " is not a frame ring or was not initialized yet";
+		munmap(this->segment, this->segmentSize);
+		this->segment = nullptr;
+		return false;
+	}
+	this->header = ringHeader;
+	this->header->attachedReaders.fetch_add(1);
+	//start with the latest frame, older frames are not of interest
+	uint64_t published = this->header->publishedFrames.load(std::memory_order_acquire);
+	this->nextFrame = published > 0 ? published - 1 : 0;
+	this->missedFrames = 0;
+	return true;
+}
+
+void FrameRingReader::close() {
+	if(this->segment == nullptr){
+		return;
+	}
+	if(this->header != nullptr){
+		this->header->attachedReaders.fetch_sub(1);
+	}
+	munmap(this->segment, this->segmentSize);
+	this->segment = nullptr;
+	this->segmentSize = 0;
+	this->header = nullptr;
+}
+
+FrameRingReader::WaitResult FrameRingReader::waitForFrame(int timeoutMs) {
+	if(this->header == nullptr || this->header->closed.load(std::memory_order_acquire) != 0){
+		return CLOSED;
+	}
+	timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while(true){
+		uint32_t notifySequence = this->header->notifySequence.load();
+		if(this->header->closed.load(std::memory_order_acquire) != 0){
+			return CLOSED;
+		}
+		if(this->header->publishedFrames.load(std::memory_order_acquire) > this->nextFrame){
+			return NEW_FRAME;
+		}
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		int64_t remainingMs = timeoutMs - ((now.tv_sec - start.tv_sec)*1000 + (now.tv_nsec - start.tv_nsec)/1000000);
+		if(remainingMs <= 0){
+			return TIMEOUT;
+		}
+#ifdef __linux__
+		//the writer only issues the wake up syscall if a reader is registered as waiting
+		timespec timeout = {static_cast<time_t>(remainingMs/1000), static_cast<long>((remainingMs%1000)*1000000)};
+		this->header->waitingReaders.fetch_add(1);
+		syscall(SYS_futex, &this->header->notifySequence, FUTEX_WAIT, notifySequence, &timeout, nullptr, 0);
+		this->header->waitingReaders.fetch_sub(1);
+#else
+		(void)notifySequence;
+		usleep(1000);
+#endif
+	}
+}
+
+const FrameRingSlot* FrameRingReader::slotOf(uint64_t frameIndex) const {
+	return reinterpret_cast<const FrameRingSlot*>(this->segment + FrameRing::HEADER_SIZE + (frameIndex % this->header->slotCount)*this->header->slotSize);
+}
+
+const uint8_t* FrameRingReader::acquire(uint64_t frameIndex, FrameInfo* info) {
+	const FrameRingSlot* slot = this->slotOf(frameIndex);
+	if(slot->sequence.load(std::memory_order_acquire) != 2*frameIndex + 2){
+		return nullptr;
+	}
+	info->frameIndex = slot->frameIndex;
+	info->timestamp = slot->timestamp;
+	info->width = slot->width;
+	info->height = slot->height;
+	info->pixelFormat = slot->pixelFormat;
+	info->bytesPerLine = slot->bytesPerLine;
+	info->size = slot->size;
+	if(FrameRing::SLOT_HEADER_SIZE + static_cast<uint64_t>(info->size) > this->header->slotSize){
+		return nullptr;
+	}
+	return reinterpret_cast<const uint8_t*>(slot) + FrameRing::SLOT_HEADER_SIZE;
+}
+
+bool FrameRingReader::isStillValid(const FrameInfo& info) const {
+	if(this->header == nullptr){
+		return false;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return this->slotOf(info.frameIndex)->sequence.load(std::memory_order_relaxed) == 2*info.frameIndex + 2;
+}
+
+const uint8_t* FrameRingReader::peekLatest(FrameInfo* info) {
+	if(this->header == nullptr){
+		return nullptr;
+	}
+	uint64_t published = this->header->publishedFrames.load(std::memory_order_acquire);
+	if(published <= this->nextFrame){
+		return nullptr;
+	}
+	uint64_t frameIndex = published - 1;
+	const uint8_t* data = this->acquire(frameIndex, info);
+	if(data != nullptr){
+		this->missedFrames += frameIndex - this->nextFrame;
+		this->nextFrame = frameIndex + 1;
+	}
+	return data;
+}
+
+bool FrameRingReader::readLatest(FrameInfo* info, std::vector<uint8_t>* data) {
+	//the writer is only able to overtake a reader that is slower than slotCount frames, a few retries are enough
+	for(int attempt = 0; attempt < 3; attempt++){
+		const uint8_t* frameData = this->peekLatest(info);
+		if(frameData == nullptr){
+			return false;
+		}
+		data->resize(info->size);
+		memcpy(data->data(), frameData, info->size);
+		if(this->isStillValid(*info)){
+			return true;
+		}
+		this->nextFrame = info->frameIndex;
+	}
+	return false;
+}
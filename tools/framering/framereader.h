@@ -0,0 +1,65 @@
+#ifndef FRAMEREADER_H
+#define FRAMEREADER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "framering.h"
+
+
+struct FrameInfo {
+	uint64_t frameIndex;
+	int64_t timestamp; //us
+	uint32_t width;
+	uint32_t height;
+	int32_t pixelFormat; //QVideoFrame::PixelFormat, e.g. 5 = RGB32, 18 = YUYV, 24 = Y8
+	uint32_t bytesPerLine;
+	uint32_t size;
+};
+
+//minimal reader for the shared memory frame ring of the OCTproZ camera extension. depends only on POSIX, link with -lrt on older glibc.
+//the reader never blocks the writer: if the reader is too slow, frames are skipped (see getMissedFrames()) and a frame that is overwritten
+//while it is read is discarded
+class FrameRingReader
+{
+public:
+	enum WaitResult {
+		NEW_FRAME,
+		TIMEOUT,
+		CLOSED //writer closed the ring (camera stopped or resolution changed), call open() again
+	};
+
+	FrameRingReader();
+	~FrameRingReader();
+
+	bool open(const std::string& name = FrameRing::NAME_PREFIX);
+	void close();
+	bool isOpen() const {return this->header != nullptr;}
+	std::string getErrorString() const {return this->errorString;}
+
+	//waits until a frame newer than the last read one is available
+	WaitResult waitForFrame(int timeoutMs);
+
+	//copies the latest frame. returns false if there is no new frame or it was overwritten during the copy
+	bool readLatest(FrameInfo* info, std::vector<uint8_t>* data);
+
+	//zero copy access to the latest frame. the data can be overwritten by the writer at any time, so isStillValid() has to be
+	//checked after the data was used, if it returns false the results must be discarded
+	const uint8_t* peekLatest(FrameInfo* info);
+	bool isStillValid(const FrameInfo& info) const;
+
+	uint64_t getMissedFrames() const {return this->missedFrames;}
+
+private:
+	uint8_t* segment;
+	size_t segmentSize;
+	FrameRingHeader* header;
+	uint64_t nextFrame;
+	uint64_t missedFrames;
+	std::string errorString;
+
+	const FrameRingSlot* slotOf(uint64_t frameIndex) const;
+	const uint8_t* acquire(uint64_t frameIndex, FrameInfo* info);
+};
+
+#endif //FRAMEREADER_H
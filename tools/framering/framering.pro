@@ -0,0 +1,20 @@
+#reader library and test consumer for the shared memory frame export of the camera extension (unix only)
+TEMPLATE = app
+TARGET = framering_consumer
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+SOURCES += \
+	framereader.cpp \
+	framering_consumer.cpp
+
+HEADERS += \
+	framereader.h \
+	../../src/export/framering.h
+
+INCLUDEPATH += \
+	../../src/export
+
+unix:!macx {
+	LIBS += -lrt
+}
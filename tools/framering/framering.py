@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Minimal Python reader for the shared memory frame export of the OCTproZ camera extension (layout: src/export/framering.h).
+
+Python has no futex access, so new frames are detected by polling. Frames are copied out of the ring and validated with the sequence
+lock of the slot, frames that were overwritten while copying are discarded.
+
+    reader = FrameRingReader()
+    frame, info = reader.wait_for_frame()
+    image = numpy.frombuffer(frame, numpy.uint8)  # interpret with info["bytes_per_line"], info["pixel_format"]
+"""
+import mmap
+import os
+import struct
+import sys
+import time
+
+MAGIC = b"OCTFRING"
+VERSION = 1
+HEADER_SIZE = 4096
+SLOT_HEADER_SIZE = 64
+HEADER_FORMAT = struct.Struct("<8sIIIIQq")
+CLOSED_OFFSET = 40
+PUBLISHED_OFFSET = 56
+SLOT_FORMAT = struct.Struct("<QQqIIiII")
+
+
+class RingClosed(Exception):
+	pass
+
+
+class FrameRingReader:
+	def __init__(self, name="/octproz_camera"):
+		with open("/dev/shm/" + name.lstrip("/"), "rb") as file:
+			self.map = mmap.mmap(file.fileno(), 0, prot=mmap.PROT_READ)
+		magic, version, _, self.slot_count, _, self.slot_size, self.writer_pid = HEADER_FORMAT.unpack_from(self.map, 0)
+		if magic != MAGIC or version != VERSION:
+			raise ValueError(name + " is not a frame ring")
+		published = self._published()
+		self.next_frame = published - 1 if published > 0 else 0
+		self.missed_frames = 0
+
+	def close(self):
+		self.map.close()
+
+	def _published(self):
+		return struct.unpack_from("<Q", self.map, PUBLISHED_OFFSET)[0]
+
+	def _sequence(self, offset):
+		return struct.unpack_from("<Q", self.map, offset)[0]
+
+	def read_latest(self):
+		"""returns (bytes, info dict) of the latest frame or None if there is no new frame"""
+		if struct.unpack_from("<I", self.map, CLOSED_OFFSET)[0] != 0:
+			raise RingClosed()
+		published = self._published()
+		if published <= self.next_frame:
+			return None
+		frame_index = published - 1
+		offset = HEADER_SIZE + (frame_index % self.slot_count) * self.slot_size
+		expected = 2 * frame_index + 2
+		if self._sequence(offset) != expected:
+			return None
+		_, index, timestamp, width, height, pixel_format, bytes_per_line, size = SLOT_FORMAT.unpack_from(self.map, offset)
+		data = self.map[offset + SLOT_HEADER_SIZE:offset + SLOT_HEADER_SIZE + size]
+		if self._sequence(offset) != expected:
+			return None
+		self.missed_frames += frame_index - self.next_frame
+		self.next_frame = frame_index + 1
+		info = {"frame_index": index, "timestamp": timestamp, "width": width, "height": height,
+				"pixel_format": pixel_format, "bytes_per_line": bytes_per_line}
+		return data, info
+
+	def wait_for_frame(self, timeout=1.0, poll_interval=0.001):
+		deadline = time.monotonic() + timeout
+		while time.monotonic() < deadline:
+			frame = self.read_latest()
+			if frame is not None:
+				return frame
+			time.sleep(poll_interval)
+		return None
+
+
+if __name__ == "__main__":
+	reader = FrameRingReader(sys.argv[1] if len(sys.argv) > 1 else "/octproz_camera")
+	received = 0
+	report_time = time.monotonic()
+	while True:
+		try:
+			frame = reader.wait_for_frame()
+		except RingClosed:
+			print("ring closed by writer")
+			break
+		if frame is not None:
+			received += 1
+		now = time.monotonic()
+		if now - report_time >= 1.0:
+			info = frame[1] if frame is not None else {}
+			print("%.1f fps, %d missed, %s" % (received / (now - report_time), reader.missed_frames, info))
+			received = 0
+			report_time = now
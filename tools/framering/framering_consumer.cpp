@@ -0,0 +1,61 @@
+//test consumer for the shared memory frame export of the camera extension. prints frame rate, missed frames and the mean of the frame
+//data once per second. usage: framering_consumer [ring name, default /octproz_camera] [seconds, default: run until killed]
+#include "framereader.h"
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+
+
+int main(int argc, char* argv[]) {
+	std::string name = argc > 1 ? argv[1] : FrameRing::NAME_PREFIX;
+	int seconds = argc > 2 ? atoi(argv[2]) : 0;
+
+	FrameRingReader reader;
+	std::vector<uint8_t> data;
+	FrameInfo info = {};
+	bool firstFrameReceived = false;
+	uint64_t framesReceived = 0;
+	auto start = std::chrono::steady_clock::now();
+	auto reportTime = start;
+	while(seconds <= 0 || std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)){
+		if(!reader.isOpen()){
+			if(!reader.open(name)){
+				fprintf(stderr, "%s, retrying\n", reader.getErrorString().c_str());
+				std::this_thread::sleep_for(std::chrono::seconds(1));
+				continue;
+			}
+			printf("attached to %s\n", name.c_str());
+		}
+
+		FrameRingReader::WaitResult result = reader.waitForFrame(1000);
+		if(result == FrameRingReader::CLOSED){
+			printf("ring closed by writer, reopening\n");
+			reader.close();
+			continue;
+		}
+		if(result == FrameRingReader::NEW_FRAME && reader.readLatest(&info, &data)){
+			framesReceived++;
+			firstFrameReceived = true;
+		}
+
+		//nothing to report before the first frame, info and data are still empty
+		auto now = std::chrono::steady_clock::now();
+		if(!firstFrameReceived){
+			reportTime = now;
+		} else if(now - reportTime >= std::chrono::seconds(1)){
+			double elapsed = std::chrono::duration<double>(now - reportTime).count();
+			uint64_t sum = 0;
+			for(uint8_t value : data){
+				sum += value;
+			}
+			printf("%.1f fps, %llu missed, frame %llu: %ux%u format %d, %u bytes/line, timestamp %lld us, mean %.1f\n",
+				framesReceived/elapsed, static_cast<unsigned long long>(reader.getMissedFrames()), static_cast<unsigned long long>(info.frameIndex),
+				info.width, info.height, info.pixelFormat, info.bytesPerLine, static_cast<long long>(info.timestamp), data.empty() ? 0.0 : static_cast<double>(sum)/data.size());
+			fflush(stdout);
+			framesReceived = 0;
+			reportTime = now;
+		}
+	}
+	return 0;
+}
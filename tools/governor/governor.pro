@@ -0,0 +1,18 @@
+#check that the acquisition governor puts the analysis workers back on normal scheduling when it is released
+QT = core
+TEMPLATE = app
+TARGET = governorcheck
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+	governorcheck.cpp \
+	../../src/processing/acquisitiongovernor.cpp \
+	../../src/processing/workstealingpool.cpp
+
+HEADERS += \
+	../../src/processing/acquisitiongovernor.h \
+	../../src/processing/workstealingpool.h
+
+INCLUDEPATH += \
+	../../src/processing
@@ -0,0 +1,165 @@
+//check of the worker scheduling of the acquisition governor. OCTproZ acquisition is simulated with buffer notifications, while it is
+//detected the workers of the shared WorkStealingPool have to run at SCHED_IDLE and keep off the excluded core, once the governor is released
+//(extension deactivated or governor destroyed) they have to be back on SCHED_OTHER with all cores. the policy and affinity are read back by
+//sched_getscheduler and sched_getaffinity inside the workers. linux only.
+//usage: governorcheck. returns 1 if a check fails
+#include "acquisitiongovernor.h"
+#include "workstealingpool.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <cstdio>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+
+namespace {
+	int failures = 0;
+
+	void check(bool condition, const char* what) {
+		if(!condition){
+			printf("FAILED: %s\n", what);
+			failures++;
+		}
+	}
+
+#ifdef __linux__
+	struct WorkerState {
+		int policy = -1;
+		bool onCore0 = false;
+	};
+
+	//one task per worker. every task blocks until all tasks started, so no worker runs two of them and every worker reports its own state.
+	//workers apply a new priority and affinity before their next task, so the state is read after the change
+	QVector<WorkerState> readWorkerStates(WorkStealingPool* pool) {
+		const int count = pool->getThreadCount();
+		QVector<WorkerState> states(count);
+		QMutex mutex;
+		QWaitCondition allStarted;
+		QWaitCondition allFinished;
+		int started = 0;
+		int finished = 0;
+		for(int i = 0; i < count; i++){
+			bool accepted = pool->trySubmit([&, i]() {
+				WorkerState state;
+				state.policy = sched_getscheduler(0);
+				cpu_set_t cpuSet;
+				CPU_ZERO(&cpuSet);
+				if(sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0){
+					state.onCore0 = CPU_ISSET(0, &cpuSet);
+				}
+				QMutexLocker locker(&mutex);
+				states[i] = state;
+				started++;
+				allStarted.wakeAll();
+				while(started < count){
+					if(!allStarted.wait(&mutex, 2000)){
+						break;
+					}
+				}
+				finished++;
+				allFinished.wakeAll();
+			});
+			check(accepted, "pool rejected a task");
+		}
+		QMutexLocker locker(&mutex);
+		while(finished < count){
+			if(!allFinished.wait(&mutex, 5000)){
+				check(false, "workers did not finish");
+				break;
+			}
+		}
+		return states;
+	}
+
+	bool allWorkers(const QVector<WorkerState>& states, int policy, bool onCore0) {
+		for(const WorkerState& state : states){
+			if(state.policy != policy || state.onCore0 != onCore0){
+				return false;
+			}
+		}
+		return !states.isEmpty();
+	}
+
+	const char* policyName(int policy) {
+		switch(policy){
+			case SCHED_OTHER: return "SCHED_OTHER";
+			case SCHED_IDLE: return "SCHED_IDLE";
+			case SCHED_BATCH: return "SCHED_BATCH";
+			default: return "other";
+		}
+	}
+
+	void printStates(const char* label, const QVector<WorkerState>& states) {
+		printf("%s:", label);
+		for(const WorkerState& state : states){
+			printf(" %s%s", policyName(state.policy), state.onCore0 ? "" : " (off core 0)");
+		}
+		printf("\n");
+	}
+
+	//buffers every 20 ms until the governor detected the acquisition
+	bool simulateAcquisition(AcquisitionGovernor* governor) {
+		QElapsedTimer timer;
+		timer.start();
+		while(!governor->isAcquisitionActive() && timer.elapsed() < 5000){
+			governor->notifyRawData();
+			governor->notifyProcessedData();
+			QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+			QThread::msleep(20);
+		}
+		return governor->isAcquisitionActive();
+	}
+#endif
+}
+
+
+int main(int argc, char* argv[]) {
+	QCoreApplication app(argc, argv);
+#ifdef __linux__
+	WorkStealingPool* pool = WorkStealingPool::globalInstance();
+	//core 0 can only be excluded if another core is left, otherwise the pool keeps all cores
+	const bool excludeCore = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+	GovernorSettings settings;
+	settings.idlePriority = true;
+	if(excludeCore){
+		settings.excludedCores = QList<int>() << 0;
+	}
+
+	QVector<WorkerState> states = readWorkerStates(pool);
+	printStates("initial", states);
+	check(allWorkers(states, SCHED_OTHER, true), "workers do not start on SCHED_OTHER with all cores");
+
+	//released by deactivating the extension
+	AcquisitionGovernor* governor = new AcquisitionGovernor();
+	governor->setSettings(settings);
+	governor->setExtensionActive(true);
+	check(simulateAcquisition(governor), "acquisition not detected");
+	states = readWorkerStates(pool);
+	printStates("acquiring", states);
+	check(allWorkers(states, SCHED_IDLE, !excludeCore), "workers do not run at SCHED_IDLE off the excluded core while acquiring");
+	governor->setExtensionActive(false);
+	states = readWorkerStates(pool);
+	printStates("extension deactivated", states);
+	check(allWorkers(states, SCHED_OTHER, true), "workers stay on SCHED_IDLE or off the core after the extension was deactivated");
+
+	//released by destroying the governor
+	governor->setExtensionActive(true);
+	check(simulateAcquisition(governor), "acquisition not detected again");
+	states = readWorkerStates(pool);
+	check(allWorkers(states, SCHED_IDLE, !excludeCore), "workers do not return to SCHED_IDLE");
+	delete governor;
+	states = readWorkerStates(pool);
+	printStates("governor destroyed", states);
+	check(allWorkers(states, SCHED_OTHER, true), "workers stay on SCHED_IDLE or off the core after the governor was destroyed");
+
+	WorkStealingPool::shutdownGlobalInstance();
+#else
+	printf("worker scheduling is only checked on linux\n");
+#endif
+	printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#throughput benchmark and check of the lens undistortion of the camera extension and the RemapTable kernels it runs on
+QT = core gui multimedia
+TEMPLATE = app
+TARGET = lensundistortionbench
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+	lensundistortionbench.cpp \
+	../../src/processing/demosaic.cpp \
+	../../src/processing/frameconversion.cpp \
+	../../src/processing/lenscalibration.cpp \
+	../../src/processing/lensundistortion.cpp \
+	../../src/processing/remaptable.cpp \
+	../../src/processing/workstealingpool.cpp
+
+HEADERS += \
+	../../src/processing/demosaic.h \
+	../../src/processing/frameconversion.h \
+	../../src/processing/lenscalibration.h \
+	../../src/processing/lensundistortion.h \
+	../../src/processing/lumaimage.h \
+	../../src/processing/remaptable.h \
+	../../src/processing/simd.h \
+	../../src/processing/workstealingpool.h
+
+INCLUDEPATH += \
+	../../src/processing
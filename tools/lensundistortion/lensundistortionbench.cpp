@@ -0,0 +1,218 @@
+//throughput benchmark for the lens undistortion of the camera extension, with a check of the RemapTable kernels it runs on: the SSE2 paths
+//for 8 bit planes, packed 4:2:2, interleaved chroma and 32 bit pixels have to match the scalar path exactly and a model without distortion
+//has to reproduce every supported pixel format unchanged.
+//usage: lensundistortionbench [width, default 1920] [height, default 1080] [iterations, default 100]. returns 1 if a check fails
+#include "lensundistortion.h"
+#include "remaptable.h"
+#include "workstealingpool.h"
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace {
+	struct Layout {
+		const char* name;
+		int channels;
+		int channelStep;
+		int pixelStep;
+		int scaleX; //frame pixels per unit
+		int scaleY;
+	};
+
+	//the layouts LensUndistortion passes to RemapTable::remap(), dst has the layout of the source
+	const Layout LAYOUTS[] = {
+		{"8 bit plane", 1, 1, 1, 1, 1},
+		{"4:2:2 luma", 1, 1, 2, 1, 1},
+		{"4:2:2 chroma", 2, 2, 4, 2, 1},
+		{"NV12 chroma", 2, 1, 2, 2, 2},
+		{"32 bit pixels", 4, 1, 4, 1, 1}
+	};
+
+	struct Format {
+		const char* name;
+		QVideoFrame::PixelFormat format;
+	};
+
+	const Format FORMATS[] = {
+		{"YUYV", QVideoFrame::Format_YUYV},
+		{"UYVY", QVideoFrame::Format_UYVY},
+		{"NV12", QVideoFrame::Format_NV12},
+		{"NV21", QVideoFrame::Format_NV21},
+		{"YUV420P", QVideoFrame::Format_YUV420P},
+		{"YV12", QVideoFrame::Format_YV12},
+		{"Y8", QVideoFrame::Format_Y8},
+		{"RGB32", QVideoFrame::Format_RGB32}
+	};
+
+	//frame with tightly packed planes filled with a pattern that differs between neighbouring samples
+	QVideoFrame createFrame(QVideoFrame::PixelFormat format, int width, int height) {
+		int bytesPerLine = width;
+		int bytes = width*height;
+		switch(format){
+			case QVideoFrame::Format_YUYV:
+			case QVideoFrame::Format_UYVY:
+				bytesPerLine = 2*width;
+				bytes = bytesPerLine*height;
+				break;
+			case QVideoFrame::Format_NV12:
+			case QVideoFrame::Format_NV21:
+			case QVideoFrame::Format_YUV420P:
+			case QVideoFrame::Format_YV12:
+				bytes = width*height*3/2;
+				break;
+			case QVideoFrame::Format_RGB32:
+				bytesPerLine = 4*width;
+				bytes = bytesPerLine*height;
+				break;
+			default:
+				break;
+		}
+		QVideoFrame frame(bytes, QSize(width, height), bytesPerLine, format);
+		if(frame.map(QAbstractVideoBuffer::WriteOnly)){
+			uchar* bits = frame.bits();
+			for(int i = 0; i < frame.mappedBytes(); i++){
+				bits[i] = static_cast<uchar>(i*7 + (i >> 11));
+			}
+			frame.unmap();
+		}
+		return frame;
+	}
+
+	QByteArray frameBytes(const QVideoFrame& frame) {
+		QVideoFrame copy(frame);
+		if(!copy.map(QAbstractVideoBuffer::ReadOnly)){
+			return QByteArray();
+		}
+		QByteArray bytes(reinterpret_cast<const char*>(copy.bits()), copy.mappedBytes());
+		copy.unmap();
+		return bytes;
+	}
+
+	LensModel createModel(int width, int height, double k1, double k2) {
+		LensModel model;
+		model.imageSize = QSize(width, height);
+		model.fx = 0.75*width;
+		model.fy = 0.75*width;
+		model.cx = (width - 1)/2.0;
+		model.cy = (height - 1)/2.0;
+		model.k1 = k1;
+		model.k2 = k2;
+		return model;
+	}
+
+	//table over random positions of a units x rows plane, a few of them outside of it
+	void buildRandomTable(RemapTable* table, const Layout& layout, int units, int rows, int stride, RemapTable::Border border) {
+		table->build(QSize(units, rows), [units, rows](int, int) {
+			return QPointF((rand()%(100*units + 200) - 100)/100.0, (rand()%(100*rows + 200) - 100)/100.0);
+		}, QSize(units, rows), border);
+		table->setLayout(layout.pixelStep, stride, 0);
+	}
+
+	int failures = 0;
+
+	void check(bool condition, const char* what) {
+		if(!condition){
+			printf("FAILED: %s\n", what);
+			failures++;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	int width = argc > 1 ? qMax(8, atoi(argv[1]) & ~1) : 1920;
+	int height = argc > 2 ? qMax(8, atoi(argv[2]) & ~1) : 1080;
+	int iterations = argc > 3 ? qMax(1, atoi(argv[3])) : 100;
+	printf("%dx%d, %d threads\n", width, height, WorkStealingPool::globalInstance()->getThreadCount());
+
+	//vectorized kernels against the scalar path, for odd counts and both borders
+	srand(1);
+	for(const Layout& layout : LAYOUTS){
+		for(int size = 2; size <= 40; size += 3){
+			const int stride = size*layout.pixelStep + 3;
+			QVector<uchar> source(stride*size);
+			for(uchar& sample : source){
+				sample = static_cast<uchar>(rand() & 0xff);
+			}
+			for(int border = RemapTable::CLAMP; border <= RemapTable::ZERO; border++){
+				RemapTable table;
+				buildRandomTable(&table, layout, size, size, stride, static_cast<RemapTable::Border>(border));
+				QVector<uchar> scalar(stride*size);
+				QVector<uchar> vectorized(stride*size);
+				for(int row = 0; row < size; row++){
+					RemapTable::remap(source.constData(), table.offsetsAt(row*size), table.weightsAt(row*size), size, layout.pixelStep, stride,
+						layout.channels, layout.channelStep, scalar.data() + row*stride, layout.pixelStep, false);
+					RemapTable::remap(source.constData(), table.offsetsAt(row*size), table.weightsAt(row*size), size, layout.pixelStep, stride,
+						layout.channels, layout.channelStep, vectorized.data() + row*stride, layout.pixelStep, true);
+				}
+				check(scalar == vectorized, layout.name);
+			}
+		}
+	}
+
+	//without distortion every sample has to come from its own position
+	for(const Format& format : FORMATS){
+		LensUndistortion undistortion;
+		LensUndistortionSettings settings;
+		settings.enabled = true;
+		settings.model = createModel(width, height, 0.0, 0.0);
+		undistortion.setSettings(settings);
+		const QVideoFrame frame = createFrame(format.format, width, height);
+		const QVideoFrame output = undistortion.process(frame);
+		check(output.isValid() && frameBytes(output) == frameBytes(frame), format.name);
+	}
+
+	//kernels on a full plane with barrel distortion
+	const LensModel model = createModel(width, height, -0.25, 0.08);
+	for(const Layout& layout : LAYOUTS){
+		const int units = width/layout.scaleX;
+		const int rows = height/layout.scaleY;
+		const int stride = units*layout.pixelStep;
+		QVector<uchar> source(stride*rows, 128);
+		QVector<uchar> dst(stride*rows);
+		RemapTable table;
+		const LensModel scaled = model.scaledTo(QSize(units, rows));
+		table.build(QSize(units, rows), [&scaled](int x, int y) {return scaled.distort(QPointF(x, y));}, QSize(units, rows), RemapTable::CLAMP);
+		table.setLayout(layout.pixelStep, stride, 0);
+		QElapsedTimer timer;
+		double ms[2];
+		for(int simd = 0; simd < 2; simd++){
+			timer.start();
+			for(int i = 0; i < iterations; i++){
+				for(int row = 0; row < rows; row++){
+					RemapTable::remap(source.constData(), table.offsetsAt(row*units), table.weightsAt(row*units), units, layout.pixelStep, stride,
+						layout.channels, layout.channelStep, dst.data() + row*stride, layout.pixelStep, simd != 0);
+				}
+			}
+			ms[simd] = timer.nsecsElapsed()/1.0e6/iterations;
+		}
+		printf("%-14s %4dx%-4d single thread: scalar %6.2f ms, SSE2 %6.2f ms\n", layout.name, units, rows, ms[0], ms[1]);
+	}
+
+	//complete frames on the WorkStealingPool, including the allocation of the output frame
+	for(const Format& format : FORMATS){
+		LensUndistortion undistortion;
+		LensUndistortionSettings settings;
+		settings.enabled = true;
+		settings.model = model;
+		undistortion.setSettings(settings);
+		const QVideoFrame frame = createFrame(format.format, width, height);
+		undistortion.process(frame);
+		const double buildMs = undistortion.getLastBuildTimeUs()/1000.0;
+		QVector<double> times;
+		for(int i = 0; i < iterations; i++){
+			undistortion.process(frame);
+			times.append(undistortion.getLastProcessingTimeUs()/1000.0);
+		}
+		std::sort(times.begin(), times.end());
+		printf("%-8s table build %6.1f ms, frame median %6.2f ms, 90th percentile %6.2f ms\n", format.name, buildMs, times.at(times.size()/2),
+			times.at(times.size()*9/10));
+	}
+
+	printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#check of the phase correlation of the drift tracking on synthetically shifted and rotated frames
+QT = core
+TEMPLATE = app
+TARGET = phasecorrelationcheck
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+	phasecorrelationcheck.cpp \
+	../../src/processing/fft.cpp \
+	../../src/processing/phasecorrelator.cpp
+
+HEADERS += \
+	../../src/processing/fft.h \
+	../../src/processing/lumaimage.h \
+	../../src/processing/phasecorrelator.h
+
+INCLUDEPATH += \
+	../../src/processing
@@ -0,0 +1,238 @@
+//check of the phase correlation used by the drift tracking of the camera extension on synthetically shifted and rotated frames. a textured
+//sample (blobs and gratings) is rendered analytically at known sub-pixel shifts and rotations, so the frames contain no interpolation error,
+//and measured the way DriftTracker does it: 2x decimated luma, resampled to a patch, rotation estimated and undone, then the translation.
+//unrelated samples have to stay below the peak threshold of the drift indicator and the mosaic registration.
+//usage: phasecorrelationcheck. returns 1 if a check fails
+#include "phasecorrelator.h"
+#include <QElapsedTimer>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+
+namespace {
+	const double PI = 3.14159265358979323846;
+	//tolerances in patch pixels and degrees. the parabolic peak fit is biased by up to 0.2 px between integer shifts, the rotation is resolved
+	//to a fraction of one log-polar row of 180/128 degrees
+	const double SHIFT_TOLERANCE = 0.25;
+	const double ROTATION_TOLERANCE = 0.5;
+	const double NOISY_SHIFT_TOLERANCE = 0.25;
+	//unrelated samples compared against the reference
+	const unsigned int UNRELATED_SAMPLES = 6;
+	//noise of the frames correlated by the mosaic: sensor noise of sigma 6, halved by the 2x2 decimation
+	const double MOSAIC_NOISE = 3.0;
+
+	struct Blob {
+		double x;
+		double y;
+		double sigma;
+		double amplitude;
+	};
+
+	struct Grating {
+		double fx;
+		double fy;
+		double phase;
+		double amplitude;
+	};
+
+	//random smooth texture around the origin, similar to a sample under the microscope: blobs of different size and a few weak gratings
+	class Sample {
+	public:
+		Sample(unsigned int seed, double extent) {
+			std::mt19937 random(seed);
+			std::uniform_real_distribution<double> position(-extent, extent);
+			std::uniform_real_distribution<double> sigma(1.5, 12.0);
+			std::uniform_real_distribution<double> amplitude(-60.0, 60.0);
+			std::uniform_real_distribution<double> frequency(-0.15, 0.15);
+			std::uniform_real_distribution<double> phase(0.0, 2.0*PI);
+			for(int i = 0; i < 1200; i++){
+				this->blobs.push_back({position(random), position(random), sigma(random), amplitude(random)});
+			}
+			for(int i = 0; i < 4; i++){
+				this->gratings.push_back({frequency(random), frequency(random), phase(random), 8.0});
+			}
+		}
+
+		double value(double x, double y) const {
+			double sum = 128.0;
+			for(const Blob& blob : this->blobs){
+				double dx = x - blob.x;
+				double dy = y - blob.y;
+				double r2 = dx*dx + dy*dy;
+				if(r2 < 16.0*blob.sigma*blob.sigma){
+					sum += blob.amplitude*std::exp(-r2/(2.0*blob.sigma*blob.sigma));
+				}
+			}
+			for(const Grating& grating : this->gratings){
+				sum += grating.amplitude*std::sin(2.0*PI*(grating.fx*x + grating.fy*y) + grating.phase);
+			}
+			return sum;
+		}
+
+	private:
+		std::vector<Blob> blobs;
+		std::vector<Grating> gratings;
+	};
+
+	//frame of size x size pixels around the origin of the sample. the sample is shifted by (dx, dy) and rotated by angle degrees around the frame
+	//center, with the conventions of PhaseCorrelator: rotatePatch(reference, angle) matches the rotated frame and a positive dx moves the content right.
+	//every pixel is the average of 2x2 samples, like the decimation of FrameConversion::toLuma
+	LumaImage render(const Sample& sample, int size, double dx, double dy, double angle, double noise, unsigned int noiseSeed) {
+		LumaImage image;
+		image.resize(size, size);
+		double c = std::cos(angle*PI/180.0);
+		double s = std::sin(angle*PI/180.0);
+		double center = (size - 1)/2.0;
+		std::mt19937 random(noiseSeed);
+		std::normal_distribution<double> gaussian(0.0, noise > 0.0 ? noise : 1.0);
+		for(int y = 0; y < size; y++){
+			quint8* line = image.line(y);
+			for(int x = 0; x < size; x++){
+				double sum = 0.0;
+				for(int sy = 0; sy < 2; sy++){
+					for(int sx = 0; sx < 2; sx++){
+						double px = x - 0.25 + 0.5*sx - center;
+						double py = y - 0.25 + 0.5*sy - center;
+						double rx = c*px + s*py;
+						double ry = -s*px + c*py;
+						sum += sample.value(rx - dx, ry - dy);
+					}
+				}
+				double value = sum/4.0 + (noise > 0.0 ? gaussian(random) : 0.0);
+				line[x] = static_cast<quint8>(std::max(0.0, std::min(255.0, std::round(value))));
+			}
+		}
+		return image;
+	}
+
+	int failures = 0;
+
+	void check(bool condition, const char* what) {
+		if(!condition){
+			printf("FAILED: %s\n", what);
+			failures++;
+		}
+	}
+
+	//measurement as in DriftTracker::analyzeFrame: patch from the frame, optional rotation estimate, rotation undone, translation
+	PhaseCorrelationResult measure(PhaseCorrelator& correlator, const LumaImage& frame, const std::vector<PhaseCorrelator::Complex>& referenceSpectrum,
+			const std::vector<PhaseCorrelator::Complex>& referenceRotationSpectrum, double* rotation) {
+		int size = correlator.getSize();
+		std::vector<float> patch = PhaseCorrelator::toPatch(frame, size);
+		if(rotation != nullptr){
+			*rotation = correlator.estimateRotation(correlator.rotationSpectrum(patch), referenceRotationSpectrum);
+			patch = PhaseCorrelator::rotatePatch(patch, size, -*rotation);
+		}
+		return correlator.correlate(correlator.spectrum(patch), referenceSpectrum);
+	}
+}
+
+
+int main() {
+	//patch size of the drift tracker, the tolerances above are for this size
+	const int patchSize = 128;
+	//frames are twice the patch size, like the decimated region of the drift tracker
+	int frameSize = 2*patchSize;
+	double scale = static_cast<double>(patchSize)/frameSize;
+	PhaseCorrelator correlator(patchSize);
+	//blobs cover the frame with margin for the shifts and rotations below
+	Sample sample(1, 0.75*frameSize);
+
+	LumaImage reference = render(sample, frameSize, 0.0, 0.0, 0.0, 0.0, 0);
+	std::vector<float> referencePatch = PhaseCorrelator::toPatch(reference, patchSize);
+	std::vector<PhaseCorrelator::Complex> referenceSpectrum = correlator.spectrum(referencePatch);
+	std::vector<PhaseCorrelator::Complex> referenceRotationSpectrum = correlator.rotationSpectrum(referencePatch);
+	printf("patch %dx%d from %dx%d frames\n", patchSize, patchSize, frameSize, frameSize);
+
+	//sub-pixel translations, given in patch pixels
+	const double shifts[][2] = {{0.0, 0.0}, {0.25, -0.5}, {0.5, 0.5}, {1.3, 0.7}, {-2.75, 3.1}, {5.6, -4.2}, {-9.4, -7.85}, {13.5, 11.25}};
+	double maxShiftError = 0.0;
+	double minPeak = 1.0;
+	for(const auto& shift : shifts){
+		LumaImage frame = render(sample, frameSize, shift[0]/scale, shift[1]/scale, 0.0, 0.0, 0);
+		PhaseCorrelationResult result = measure(correlator, frame, referenceSpectrum, referenceRotationSpectrum, nullptr);
+		double error = std::hypot(result.dx - shift[0], result.dy - shift[1]);
+		printf("shift %6.2f %6.2f -> %7.3f %7.3f, error %.3f px, peak %.2f\n", shift[0], shift[1], result.dx, result.dy, error, result.peak);
+		maxShiftError = std::max(maxShiftError, error);
+		minPeak = std::min(minPeak, result.peak);
+	}
+	printf("translation: max error %.3f px (tolerance %.2f), min peak %.2f\n", maxShiftError, SHIFT_TOLERANCE, minPeak);
+	check(maxShiftError <= SHIFT_TOLERANCE, "translation error too large");
+
+	//rotations with and without translation
+	const double rotations[][3] = {{1.0, 0.0, 0.0}, {-2.0, 0.0, 0.0}, {3.5, 0.0, 0.0}, {-6.0, 0.0, 0.0}, {10.0, 0.0, 0.0},
+		{2.5, 1.5, -0.75}, {-4.0, -3.25, 2.5}, {7.0, 6.5, 4.0}};
+	double maxRotationError = 0.0;
+	double maxRotatedShiftError = 0.0;
+	for(const auto& rotation : rotations){
+		LumaImage frame = render(sample, frameSize, rotation[1]/scale, rotation[2]/scale, rotation[0], 0.0, 0);
+		double angle = 0.0;
+		PhaseCorrelationResult result = measure(correlator, frame, referenceSpectrum, referenceRotationSpectrum, &angle);
+		double rotationError = std::abs(angle - rotation[0]);
+		//the frame is shifted before it is rotated, so with the rotation undone the translation is the shift of the sample
+		double shiftError = std::hypot(result.dx - rotation[1], result.dy - rotation[2]);
+		printf("rotation %5.1f deg, shift %5.2f %5.2f -> %6.2f deg, %6.2f %6.2f, errors %.2f deg %.3f px, peak %.2f\n", rotation[0], rotation[1], rotation[2],
+			angle, result.dx, result.dy, rotationError, shiftError, result.peak);
+		maxRotationError = std::max(maxRotationError, rotationError);
+		maxRotatedShiftError = std::max(maxRotatedShiftError, shiftError);
+	}
+	printf("rotation: max error %.2f deg (tolerance %.2f), translation after rotation max error %.3f px (tolerance %.2f)\n", maxRotationError, ROTATION_TOLERANCE,
+		maxRotatedShiftError, SHIFT_TOLERANCE);
+	check(maxRotationError <= ROTATION_TOLERANCE, "rotation error too large");
+	check(maxRotatedShiftError <= SHIFT_TOLERANCE, "translation error after rotation too large");
+
+	//camera noise
+	double maxNoisyError = 0.0;
+	for(int i = 0; i < 4; i++){
+		double dx = -3.4 + 2.3*i;
+		double dy = 1.6 - 1.1*i;
+		LumaImage frame = render(sample, frameSize, dx/scale, dy/scale, 0.0, 6.0, static_cast<unsigned int>(i + 1));
+		PhaseCorrelationResult result = measure(correlator, frame, referenceSpectrum, referenceRotationSpectrum, nullptr);
+		maxNoisyError = std::max(maxNoisyError, std::hypot(result.dx - dx, result.dy - dy));
+	}
+	printf("noise sigma 6: max error %.3f px (tolerance %.2f)\n", maxNoisyError, NOISY_SHIFT_TOLERANCE);
+	check(maxNoisyError <= NOISY_SHIFT_TOLERANCE, "translation error with noise too large");
+
+	//unrelated samples must not pass as a match, neither for the drift indicator (128 px patch) nor for the mosaic registration, which
+	//correlates 256 px patches of the whole frame. matching frames have to pass both, for the mosaic with the noise left after its 2x2
+	//decimation of a noisy 1080p frame
+	PhaseCorrelator mosaicCorrelator(2*patchSize);
+	std::vector<PhaseCorrelator::Complex> mosaicReferenceSpectrum = mosaicCorrelator.spectrum(PhaseCorrelator::toPatch(reference, 2*patchSize));
+	double maxUnrelatedPeak = 0.0;
+	double maxUnrelatedMosaicPeak = 0.0;
+	for(unsigned int seed = 2; seed < 2 + UNRELATED_SAMPLES; seed++){
+		LumaImage unrelated = render(Sample(seed, 0.75*frameSize), frameSize, 0.0, 0.0, 0.0, 0.0, 0);
+		maxUnrelatedPeak = std::max(maxUnrelatedPeak, measure(correlator, unrelated, referenceSpectrum, referenceRotationSpectrum, nullptr).peak);
+		PhaseCorrelationResult mosaicResult = mosaicCorrelator.correlate(mosaicCorrelator.spectrum(PhaseCorrelator::toPatch(unrelated, 2*patchSize)),
+			mosaicReferenceSpectrum);
+		maxUnrelatedMosaicPeak = std::max(maxUnrelatedMosaicPeak, mosaicResult.peak);
+	}
+	double minMosaicPeak = 1.0;
+	for(int i = 0; i < 3; i++){
+		LumaImage frame = render(sample, frameSize, 4.0 + 8.0*i, -3.0 - 5.0*i, 0.0, MOSAIC_NOISE, static_cast<unsigned int>(i + 10));
+		PhaseCorrelationResult result = mosaicCorrelator.correlate(mosaicCorrelator.spectrum(PhaseCorrelator::toPatch(frame, 2*patchSize)), mosaicReferenceSpectrum);
+		minMosaicPeak = std::min(minMosaicPeak, result.peak);
+	}
+	printf("%d px patch: unrelated samples max peak %.3f, matching min peak %.3f, threshold %.3f\n", patchSize, maxUnrelatedPeak, minPeak,
+		correlator.getMinReliablePeak());
+	printf("%d px patch: unrelated samples max peak %.3f, matching with noise sigma %.0f min peak %.3f, threshold %.3f\n", 2*patchSize, maxUnrelatedMosaicPeak,
+		MOSAIC_NOISE, minMosaicPeak, mosaicCorrelator.getMinReliablePeak());
+	check(maxUnrelatedPeak < correlator.getMinReliablePeak() && maxUnrelatedMosaicPeak < mosaicCorrelator.getMinReliablePeak(),
+		"unrelated frames are not rejected");
+	check(minPeak >= correlator.getMinReliablePeak() && minMosaicPeak >= mosaicCorrelator.getMinReliablePeak(), "matching frames are rejected");
+
+	//time per frame of the drift tracker with rotation
+	LumaImage frame = render(sample, frameSize, 3.0, -2.0, 2.0, 0.0, 0);
+	const int iterations = 200;
+	QElapsedTimer timer;
+	timer.start();
+	double angle = 0.0;
+	for(int i = 0; i < iterations; i++){
+		measure(correlator, frame, referenceSpectrum, referenceRotationSpectrum, &angle);
+	}
+	printf("%.3f ms per frame with rotation\n", timer.nsecsElapsed()/1.0e6/iterations);
+
+	printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#benchmark and check of the lossless compression of recordings
+QT = core multimedia
+TEMPLATE = app
+TARGET = recordingcodecbench
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+	recordingcodecbench.cpp \
+	../../src/recording/lzcodec.cpp \
+	../../src/recording/recordingcodec.cpp
+
+HEADERS += \
+	../../src/recording/lzcodec.h \
+	../../src/recording/recordingcodec.h \
+	../../src/recording/recordingformat.h
+
+INCLUDEPATH += \
+	../../src/recording
@@ -0,0 +1,169 @@
+//single thread throughput of the lossless compression of recordings on synthetic YUYV frames with sensor noise, with a check that every level
+//decodes to the original chunk and that LzCodec rejects corrupt blocks (endless length continuations, lengths beyond the output, random damage)
+//without reading or writing outside of its buffers.
+//usage: recordingcodecbench [width, default 1920] [height, default 1080] [frames per chunk, default 4] [iterations, default 5]. returns 1 if a check fails
+#include "recordingcodec.h"
+#include "lzcodec.h"
+#include <QVideoFrame>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+
+namespace {
+	//standard deviation of the sensor noise in digital numbers
+	const double NOISE_SIGMA = 2.0;
+
+	//chunk of YUYV frames of a slowly moving, smooth scene: gradients and blobs in luma, smooth chroma, gaussian noise on every sample
+	QByteArray createChunk(int width, int height, int frameCount, QVector<RecordingFrameEntry>* frames) {
+		const int frameSize = width*height*2;
+		QByteArray chunk(frameSize*frameCount, 0);
+		std::mt19937 random(1);
+		std::normal_distribution<double> noise(0.0, NOISE_SIGMA);
+		for(int f = 0; f < frameCount; f++){
+			quint8* frame = reinterpret_cast<quint8*>(chunk.data()) + f*frameSize;
+			const double shift = 3.0*f;
+			for(int y = 0; y < height; y++){
+				quint8* line = frame + y*width*2;
+				for(int x = 0; x < width; x++){
+					double u = (x + shift)/width;
+					double v = static_cast<double>(y)/height;
+					double luma = 90.0 + 60.0*u + 30.0*std::sin(12.0*u + 7.0*v) + 25.0*std::cos(31.0*u*v);
+					double chroma = (x & 1) == 0 ? 128.0 + 20.0*std::sin(5.0*v + 3.0*u) : 128.0 - 15.0*std::cos(4.0*u);
+					line[2*x] = static_cast<quint8>(qBound(0.0, luma + noise(random), 255.0));
+					line[2*x + 1] = static_cast<quint8>(qBound(0.0, chroma + noise(random), 255.0));
+				}
+			}
+			RecordingFrameEntry entry;
+			entry.sequenceNumber = static_cast<quint64>(f);
+			entry.timestamp = f*16667;
+			entry.offset = static_cast<quint64>(f)*frameSize;
+			entry.size = static_cast<quint32>(frameSize);
+			entry.chunk = 0;
+			frames->append(entry);
+		}
+		return chunk;
+	}
+
+	double megabytesPerSecond(qint64 bytes, qint64 nanoseconds) {
+		return nanoseconds > 0 ? bytes/(1024.0*1024.0)/(nanoseconds/1.0e9) : 0.0;
+	}
+
+	int failures = 0;
+
+	void check(bool condition, const char* what) {
+		if(!condition){
+			printf("FAILED: %s\n", what);
+			failures++;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	int width = argc > 1 ? qMax(16, atoi(argv[1]) & ~1) : 1920;
+	int height = argc > 2 ? qMax(16, atoi(argv[2])) : 1080;
+	int frameCount = argc > 3 ? qMax(1, atoi(argv[3])) : 4;
+	int iterations = argc > 4 ? qMax(1, atoi(argv[4])) : 5;
+
+	QVector<RecordingFrameEntry> frames;
+	const QByteArray chunk = createChunk(width, height, frameCount, &frames);
+	printf("%d YUYV frames of %dx%d (%.1f MB), noise sigma %.1f\n", frameCount, width, height, chunk.size()/(1024.0*1024.0), NOISE_SIGMA);
+
+	//every level, timed like the encode task of FrameRecorder: one chunk on one thread, fastest of the iterations
+	for(int level = 1; level <= RecordingCodec::MAX_LEVEL; level++){
+		QByteArray encoded;
+		quint32 codec = RecordingFormat::RAW;
+		qint64 encodeNs = -1;
+		bool compressed = false;
+		QElapsedTimer timer;
+		for(int i = 0; i < iterations; i++){
+			timer.start();
+			compressed = RecordingCodec::encodeChunk(chunk, frames.constData(), frames.size(), QVideoFrame::Format_YUYV, level, &encoded, &codec);
+			qint64 elapsed = timer.nsecsElapsed();
+			encodeNs = encodeNs < 0 ? elapsed : qMin(encodeNs, elapsed);
+		}
+		//without the planar delta the noise leaves too few matches, such chunks are stored raw
+		check(compressed || level < 2, "noisy YUYV chunk is compressed with planar delta");
+		if(!compressed){
+			printf("level %d: stored raw (saves less than 3 %%), %6.1f MB/s per thread\n", level, megabytesPerSecond(chunk.size(), encodeNs));
+			continue;
+		}
+		QByteArray decoded;
+		qint64 decodeNs = -1;
+		bool success = false;
+		for(int i = 0; i < iterations; i++){
+			timer.start();
+			success = RecordingCodec::decodeChunk(reinterpret_cast<const uchar*>(encoded.constData()), static_cast<quint64>(encoded.size()), codec,
+				static_cast<quint64>(chunk.size()), frames.constData(), frames.size(), QVideoFrame::Format_YUYV, &decoded);
+			qint64 elapsed = timer.nsecsElapsed();
+			decodeNs = decodeNs < 0 ? elapsed : qMin(decodeNs, elapsed);
+		}
+		check(success && decoded == chunk, "chunk is decoded unchanged");
+		printf("level %d%s: ratio %.2f, encode %6.1f MB/s, decode %6.1f MB/s per thread\n", level, codec == RecordingFormat::LZ_PLANAR_DELTA ? " (planar delta)" : "",
+			static_cast<double>(chunk.size())/encoded.size(), megabytesPerSecond(chunk.size(), encodeNs), megabytesPerSecond(chunk.size(), decodeNs));
+	}
+
+	//noise without structure does not shrink and is stored raw
+	{
+		QByteArray noise(1 << 20, 0);
+		std::mt19937 random(2);
+		for(int i = 0; i < noise.size(); i++){
+			noise[i] = static_cast<char>(random() & 0xff);
+		}
+		RecordingFrameEntry entry = {0, 0, 0, static_cast<quint32>(noise.size()), 0};
+		QByteArray encoded;
+		quint32 codec = RecordingFormat::RAW;
+		check(!RecordingCodec::encodeChunk(noise, &entry, 1, QVideoFrame::Format_Y8, 2, &encoded, &codec), "incompressible chunk is stored raw");
+	}
+
+	//corrupt blocks
+	QVector<quint8> output(1 << 16);
+	{
+		//literal length with an endless run of 255 continuation bytes
+		QVector<quint8> block(16 << 20, 255);
+		block[0] = 0xf0;
+		QElapsedTimer timer;
+		timer.start();
+		int result = LzCodec::decompress(block.constData(), block.size(), output.data(), output.size());
+		check(result == -1 && timer.nsecsElapsed() < 5000000, "endless literal length is rejected once it exceeds the output");
+	}
+	{
+		//one literal, then a match with a length far beyond the output
+		QVector<quint8> block(1024, 255);
+		block[0] = 0x1f;
+		block[1] = 'a';
+		block[2] = 1;
+		block[3] = 0;
+		check(LzCodec::decompress(block.constData(), block.size(), output.data(), 200) == -1, "match length beyond the output is rejected");
+	}
+	{
+		//random damage of a valid block, every result has to stay within the output
+		QVector<quint8> source(1 << 16);
+		for(int i = 0; i < source.size(); i++){
+			source[i] = static_cast<quint8>((i/7) ^ (i >> 9));
+		}
+		QVector<quint8> compressed(LzCodec::maxCompressedSize(source.size()));
+		int compressedSize = LzCodec::compress(source.constData(), source.size(), compressed.data(), compressed.size(), 2);
+		check(compressedSize > 0 && LzCodec::decompress(compressed.constData(), compressedSize, output.data(), output.size()) == source.size(), "valid block is decoded");
+		std::mt19937 random(3);
+		bool withinOutput = true;
+		for(int i = 0; i < 2000 && compressedSize > 0; i++){
+			QVector<quint8> damaged = compressed;
+			damaged.resize(compressedSize);
+			for(int j = 0; j < 4; j++){
+				damaged[static_cast<int>(random()%compressedSize)] = static_cast<quint8>(random() % 3 == 0 ? 255 : random() & 0xff);
+			}
+			int result = LzCodec::decompress(damaged.constData(), damaged.size(), output.data(), output.size());
+			withinOutput = withinOutput && result <= output.size();
+		}
+		check(withinOutput, "damaged blocks stay within the output");
+	}
+
+	printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+	return failures == 0 ? 0 : 1;
+}
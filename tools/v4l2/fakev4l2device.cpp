@@ -0,0 +1,505 @@
+#include "fakev4l2device.h"
+#include <QMutexLocker>
+#include <cerrno>
+#include <cstring>
+#include <linux/videodev2.h>
+#include <time.h>
+
+
+namespace {
+	qint64 monotonicTimeUs() {
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<qint64>(now.tv_sec)*1000000 + now.tv_nsec/1000;
+	}
+
+	void copyName(__u8* target, int size, const char* name) {
+		strncpy(reinterpret_cast<char*>(target), name, static_cast<size_t>(size));
+	}
+
+	//controls ordered by id as the enumeration with V4L2_CTRL_FLAG_NEXT_CTRL expects. the class entries are reported like real drivers do
+	const quint32 CONTROL_IDS[] = {V4L2_CID_USER_CLASS, V4L2_CID_BRIGHTNESS, V4L2_CID_HFLIP, V4L2_CID_CAMERA_CLASS, V4L2_CID_EXPOSURE_AUTO,
+		V4L2_CID_EXPOSURE_ABSOLUTE};
+}
+
+
+FakeV4l2Device::FakeV4l2Device()
+	: opened(false),
+	  busy(false),
+	  disconnected(false),
+	  invalidIndexPending(false),
+	  invalidQueueCount(0),
+	  dmabufSupported(true),
+	  fourcc(V4L2_PIX_FMT_YUYV),
+	  width(640),
+	  height(480),
+	  frameIntervalUs(33333),
+	  streaming(false),
+	  sequence(0),
+	  lostFrames(0),
+	  nextFrameUs(0),
+	  nextExportedFd(EXPORTED_FD_BASE),
+	  brightness(0),
+	  horizontalFlip(0),
+	  autoExposure(V4L2_EXPOSURE_APERTURE_PRIORITY),
+	  exposure(156)
+{
+}
+
+bool FakeV4l2Device::open(const QString& path) {
+	Q_UNUSED(path)
+	QMutexLocker locker(&this->mutex);
+	if(this->disconnected){
+		errno = ENODEV;
+		return false;
+	}
+	this->opened = true;
+	return true;
+}
+
+void FakeV4l2Device::close() {
+	//closing the device frees the buffers, memory that is still mapped stays valid until it is unmapped
+	QMutexLocker locker(&this->mutex);
+	this->opened = false;
+	this->streaming = false;
+	this->buffers.clear();
+	this->queuedBuffers.clear();
+	this->doneBuffers.clear();
+	this->streamChanged.wakeAll();
+}
+
+bool FakeV4l2Device::isOpen() const {
+	QMutexLocker locker(&this->mutex);
+	return this->opened;
+}
+
+void FakeV4l2Device::disconnect() {
+	QMutexLocker locker(&this->mutex);
+	this->disconnected = true;
+	this->streamChanged.wakeAll();
+}
+
+void FakeV4l2Device::reportInvalidIndex() {
+	QMutexLocker locker(&this->mutex);
+	this->invalidIndexPending = true;
+}
+
+int FakeV4l2Device::getMappingCount() const {
+	QMutexLocker locker(&this->mutex);
+	return this->mappings.size();
+}
+
+int FakeV4l2Device::getExportedCount() const {
+	QMutexLocker locker(&this->mutex);
+	return this->exported.size();
+}
+
+int FakeV4l2Device::getQueuedCount() const {
+	QMutexLocker locker(&this->mutex);
+	return this->queuedBuffers.size();
+}
+
+quint32 FakeV4l2Device::getLostFrames() const {
+	QMutexLocker locker(&this->mutex);
+	return this->lostFrames;
+}
+
+int FakeV4l2Device::getInvalidQueueCount() const {
+	QMutexLocker locker(&this->mutex);
+	return this->invalidQueueCount;
+}
+
+bool FakeV4l2Device::isStreaming() const {
+	QMutexLocker locker(&this->mutex);
+	return this->streaming;
+}
+
+qint64 FakeV4l2Device::getTimestamp(quint32 sequence) const {
+	QMutexLocker locker(&this->mutex);
+	return this->timestamps.value(sequence, -1);
+}
+
+const uchar* FakeV4l2Device::getBufferData(int index) const {
+	QMutexLocker locker(&this->mutex);
+	if(index < 0 || index >= this->buffers.size()){
+		return nullptr;
+	}
+	return reinterpret_cast<const uchar*>(this->buffers.at(index).memory->constData());
+}
+
+quint32 FakeV4l2Device::bytesPerLine() const {
+	return this->fourcc == V4L2_PIX_FMT_YUYV ? 2*this->width : this->width;
+}
+
+quint32 FakeV4l2Device::imageSize() const {
+	return this->bytesPerLine()*this->height;
+}
+
+int FakeV4l2Device::ioctl(unsigned long request, void* argument) {
+	QMutexLocker locker(&this->mutex);
+	if(this->disconnected){
+		errno = ENODEV;
+		return -1;
+	}
+	if(!this->opened){
+		errno = EBADF;
+		return -1;
+	}
+
+	switch(request){
+	case VIDIOC_QUERYCAP: {
+		v4l2_capability* capability = static_cast<v4l2_capability*>(argument);
+		memset(capability, 0, sizeof(*capability));
+		copyName(capability->driver, sizeof(capability->driver), "fake");
+		copyName(capability->card, sizeof(capability->card), "Fake V4L2 camera");
+		copyName(capability->bus_info, sizeof(capability->bus_info), "platform:fake");
+		capability->device_caps = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+		capability->capabilities = capability->device_caps | V4L2_CAP_DEVICE_CAPS;
+		return 0;
+	}
+	case VIDIOC_ENUM_FMT: {
+		//the compressed format has to be skipped by the source
+		v4l2_fmtdesc* description = static_cast<v4l2_fmtdesc*>(argument);
+		static const quint32 formats[] = {V4L2_PIX_FMT_MJPEG, V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_GREY};
+		static const char* names[] = {"Motion-JPEG", "YUYV 4:2:2", "8-bit Greyscale"};
+		if(description->type != V4L2_BUF_TYPE_VIDEO_CAPTURE || description->index >= 3){
+			errno = EINVAL;
+			return -1;
+		}
+		description->pixelformat = formats[description->index];
+		description->flags = description->index == 0 ? V4L2_FMT_FLAG_COMPRESSED : 0;
+		copyName(description->description, sizeof(description->description), names[description->index]);
+		return 0;
+	}
+	case VIDIOC_G_FMT:
+	case VIDIOC_S_FMT: {
+		v4l2_format* format = static_cast<v4l2_format*>(argument);
+		if(format->type != V4L2_BUF_TYPE_VIDEO_CAPTURE){
+			errno = EINVAL;
+			return -1;
+		}
+		if(request == VIDIOC_S_FMT){
+			if(this->busy || this->streaming || !this->buffers.isEmpty()){
+				errno = EBUSY;
+				return -1;
+			}
+			//unknown formats and sizes are adjusted, as drivers do
+			quint32 requested = format->fmt.pix.pixelformat;
+			this->fourcc = requested == V4L2_PIX_FMT_GREY ? V4L2_PIX_FMT_GREY : V4L2_PIX_FMT_YUYV;
+			this->width = qBound(2u, format->fmt.pix.width & ~1u, 4096u);
+			this->height = qBound(2u, format->fmt.pix.height & ~1u, 4096u);
+		}
+		memset(&format->fmt.pix, 0, sizeof(format->fmt.pix));
+		format->fmt.pix.width = this->width;
+		format->fmt.pix.height = this->height;
+		format->fmt.pix.pixelformat = this->fourcc;
+		format->fmt.pix.field = V4L2_FIELD_NONE;
+		format->fmt.pix.bytesperline = this->bytesPerLine();
+		format->fmt.pix.sizeimage = this->imageSize();
+		format->fmt.pix.colorspace = V4L2_COLORSPACE_SRGB;
+		return 0;
+	}
+	case VIDIOC_G_PARM:
+	case VIDIOC_S_PARM: {
+		v4l2_streamparm* parameters = static_cast<v4l2_streamparm*>(argument);
+		if(parameters->type != V4L2_BUF_TYPE_VIDEO_CAPTURE){
+			errno = EINVAL;
+			return -1;
+		}
+		v4l2_fract& interval = parameters->parm.capture.timeperframe;
+		if(request == VIDIOC_S_PARM && interval.numerator > 0 && interval.denominator > 0){
+			quint64 intervalUs = static_cast<quint64>(interval.numerator)*1000000/interval.denominator;
+			this->frameIntervalUs = static_cast<quint32>(qBound(Q_UINT64_C(1000), intervalUs, Q_UINT64_C(1000000)));
+		}
+		memset(&parameters->parm.capture, 0, sizeof(parameters->parm.capture));
+		parameters->parm.capture.capability = V4L2_CAP_TIMEPERFRAME;
+		parameters->parm.capture.timeperframe.numerator = this->frameIntervalUs;
+		parameters->parm.capture.timeperframe.denominator = 1000000;
+		return 0;
+	}
+	case VIDIOC_REQBUFS: {
+		v4l2_requestbuffers* buffersRequest = static_cast<v4l2_requestbuffers*>(argument);
+		if(buffersRequest->type != V4L2_BUF_TYPE_VIDEO_CAPTURE || buffersRequest->memory != V4L2_MEMORY_MMAP){
+			errno = EINVAL;
+			return -1;
+		}
+		if(this->streaming){
+			errno = EBUSY;
+			return -1;
+		}
+		this->buffers.clear();
+		this->queuedBuffers.clear();
+		this->doneBuffers.clear();
+		quint32 count = buffersRequest->count == 0 ? 0 : qBound(2u, buffersRequest->count, static_cast<quint32>(MAX_BUFFERS));
+		for(quint32 i = 0; i < count; i++){
+			Buffer buffer;
+			buffer.memory = QSharedPointer<QByteArray>(new QByteArray(static_cast<int>(this->imageSize()), '\0'));
+			buffer.queued = false;
+			buffer.done = false;
+			buffer.bytesUsed = 0;
+			buffer.sequence = 0;
+			buffer.timestamp = 0;
+			this->buffers.append(buffer);
+		}
+		buffersRequest->count = count;
+		return 0;
+	}
+	case VIDIOC_QUERYBUF:
+	case VIDIOC_QBUF:
+	case VIDIOC_DQBUF: {
+		v4l2_buffer* buffer = static_cast<v4l2_buffer*>(argument);
+		if(buffer->type != V4L2_BUF_TYPE_VIDEO_CAPTURE || buffer->memory != V4L2_MEMORY_MMAP){
+			errno = EINVAL;
+			return -1;
+		}
+		int index = static_cast<int>(buffer->index);
+		if(request == VIDIOC_DQBUF){
+			if(!this->streaming){
+				errno = EINVAL;
+				return -1;
+			}
+			if(this->doneBuffers.isEmpty()){
+				errno = EAGAIN;
+				return -1;
+			}
+			index = this->doneBuffers.dequeue();
+			this->buffers[index].done = false;
+		} else if(index < 0 || index >= this->buffers.size()){
+			if(request == VIDIOC_QBUF){
+				this->invalidQueueCount++;
+			}
+			errno = EINVAL;
+			return -1;
+		}
+		Buffer& state = this->buffers[index];
+		if(request == VIDIOC_QBUF){
+			if(state.queued || state.done){
+				errno = EINVAL;
+				return -1;
+			}
+			state.queued = true;
+			this->queuedBuffers.enqueue(index);
+		}
+		buffer->index = static_cast<quint32>(index);
+		buffer->length = static_cast<quint32>(state.memory->size());
+		buffer->m.offset = static_cast<quint32>(index)*BUFFER_OFFSET_STEP;
+		buffer->field = V4L2_FIELD_NONE;
+		buffer->flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC | V4L2_BUF_FLAG_TSTAMP_SRC_SOE | (state.queued ? V4L2_BUF_FLAG_QUEUED : 0);
+		if(request == VIDIOC_DQBUF){
+			buffer->bytesused = state.bytesUsed;
+			buffer->sequence = state.sequence;
+			buffer->timestamp.tv_sec = state.timestamp/1000000;
+			buffer->timestamp.tv_usec = state.timestamp%1000000;
+			if(this->invalidIndexPending){
+				this->invalidIndexPending = false;
+				buffer->index = MAX_BUFFERS + static_cast<quint32>(index);
+			}
+		}
+		return 0;
+	}
+	case VIDIOC_EXPBUF: {
+		v4l2_exportbuffer* exportBuffer = static_cast<v4l2_exportbuffer*>(argument);
+		if(!this->dmabufSupported){
+			errno = ENOTTY;
+			return -1;
+		}
+		if(exportBuffer->index >= static_cast<quint32>(this->buffers.size())){
+			errno = EINVAL;
+			return -1;
+		}
+		exportBuffer->fd = this->nextExportedFd++;
+		this->exported.insert(exportBuffer->fd, static_cast<int>(exportBuffer->index));
+		return 0;
+	}
+	case VIDIOC_STREAMON:
+	case VIDIOC_STREAMOFF: {
+		if(*static_cast<int*>(argument) != V4L2_BUF_TYPE_VIDEO_CAPTURE || this->buffers.isEmpty()){
+			errno = EINVAL;
+			return -1;
+		}
+		this->streaming = request == VIDIOC_STREAMON;
+		if(this->streaming){
+			this->sequence = 0;
+			this->nextFrameUs = monotonicTimeUs() + this->frameIntervalUs;
+		} else {
+			//all buffers are returned to the application
+			for(Buffer& buffer : this->buffers){
+				buffer.queued = false;
+				buffer.done = false;
+			}
+			this->queuedBuffers.clear();
+			this->doneBuffers.clear();
+		}
+		this->streamChanged.wakeAll();
+		return 0;
+	}
+	case VIDIOC_QUERYCTRL:
+	case VIDIOC_G_CTRL:
+	case VIDIOC_S_CTRL:
+	case VIDIOC_QUERYMENU:
+		return this->controlIoctl(request, argument);
+	default:
+		errno = ENOTTY;
+		return -1;
+	}
+}
+
+int FakeV4l2Device::controlIoctl(unsigned long request, void* argument) {
+	if(request == VIDIOC_QUERYCTRL){
+		v4l2_queryctrl* query = static_cast<v4l2_queryctrl*>(argument);
+		quint32 id = query->id & ~V4L2_CTRL_FLAG_NEXT_CTRL;
+		bool next = (query->id & V4L2_CTRL_FLAG_NEXT_CTRL) != 0;
+		quint32 found = 0;
+		for(quint32 candidate : CONTROL_IDS){
+			if(next ? candidate > id : candidate == id){
+				found = candidate;
+				break;
+			}
+		}
+		if(found == 0){
+			errno = EINVAL;
+			return -1;
+		}
+		memset(query, 0, sizeof(*query));
+		query->id = found;
+		query->step = 1;
+		switch(found){
+		case V4L2_CID_USER_CLASS:
+		case V4L2_CID_CAMERA_CLASS:
+			query->type = V4L2_CTRL_TYPE_CTRL_CLASS;
+			query->flags = V4L2_CTRL_FLAG_READ_ONLY | V4L2_CTRL_FLAG_WRITE_ONLY;
+			copyName(query->name, sizeof(query->name), found == V4L2_CID_USER_CLASS ? "User Controls" : "Camera Controls");
+			break;
+		case V4L2_CID_BRIGHTNESS:
+			query->type = V4L2_CTRL_TYPE_INTEGER;
+			query->minimum = -64;
+			query->maximum = 64;
+			copyName(query->name, sizeof(query->name), "Brightness");
+			break;
+		case V4L2_CID_HFLIP:
+			query->type = V4L2_CTRL_TYPE_BOOLEAN;
+			query->maximum = 1;
+			copyName(query->name, sizeof(query->name), "Horizontal Flip");
+			break;
+		case V4L2_CID_EXPOSURE_AUTO:
+			//a menu with gaps, only 1 and 3 are valid
+			query->type = V4L2_CTRL_TYPE_MENU;
+			query->maximum = 3;
+			query->default_value = V4L2_EXPOSURE_APERTURE_PRIORITY;
+			copyName(query->name, sizeof(query->name), "Auto Exposure");
+			break;
+		case V4L2_CID_EXPOSURE_ABSOLUTE:
+			query->type = V4L2_CTRL_TYPE_INTEGER;
+			query->minimum = 1;
+			query->maximum = 5000;
+			query->default_value = 156;
+			query->flags = this->autoExposure != V4L2_EXPOSURE_MANUAL ? V4L2_CTRL_FLAG_INACTIVE : 0;
+			copyName(query->name, sizeof(query->name), "Exposure Time, Absolute");
+			break;
+		}
+		return 0;
+	}
+	if(request == VIDIOC_QUERYMENU){
+		v4l2_querymenu* item = static_cast<v4l2_querymenu*>(argument);
+		if(item->id != V4L2_CID_EXPOSURE_AUTO || (item->index != V4L2_EXPOSURE_MANUAL && item->index != V4L2_EXPOSURE_APERTURE_PRIORITY)){
+			errno = EINVAL;
+			return -1;
+		}
+		copyName(item->name, sizeof(item->name), item->index == V4L2_EXPOSURE_MANUAL ? "Manual Mode" : "Aperture Priority Mode");
+		return 0;
+	}
+
+	v4l2_control* control = static_cast<v4l2_control*>(argument);
+	qint32* value = nullptr;
+	qint32 minimum = 0;
+	qint32 maximum = 0;
+	switch(control->id){
+	case V4L2_CID_BRIGHTNESS: value = &this->brightness; minimum = -64; maximum = 64; break;
+	case V4L2_CID_HFLIP: value = &this->horizontalFlip; maximum = 1; break;
+	case V4L2_CID_EXPOSURE_AUTO: value = &this->autoExposure; minimum = V4L2_EXPOSURE_MANUAL; maximum = V4L2_EXPOSURE_APERTURE_PRIORITY; break;
+	case V4L2_CID_EXPOSURE_ABSOLUTE: value = &this->exposure; minimum = 1; maximum = 5000; break;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+	if(request == VIDIOC_G_CTRL){
+		control->value = *value;
+		return 0;
+	}
+	bool invalidMenuEntry = control->id == V4L2_CID_EXPOSURE_AUTO && control->value != V4L2_EXPOSURE_MANUAL && control->value != V4L2_EXPOSURE_APERTURE_PRIORITY;
+	if(control->value < minimum || control->value > maximum || invalidMenuEntry){
+		errno = ERANGE;
+		return -1;
+	}
+	*value = control->value;
+	return 0;
+}
+
+void* FakeV4l2Device::map(quint32 length, quint32 offset) {
+	QMutexLocker locker(&this->mutex);
+	int index = static_cast<int>(offset/BUFFER_OFFSET_STEP);
+	if(!this->opened || offset % BUFFER_OFFSET_STEP != 0 || index >= this->buffers.size() || length > static_cast<quint32>(this->buffers.at(index).memory->size())){
+		errno = EINVAL;
+		return nullptr;
+	}
+	QSharedPointer<QByteArray> memory = this->buffers.at(index).memory;
+	void* address = memory->data();
+	this->mappings.insert(address, memory);
+	return address;
+}
+
+void FakeV4l2Device::unmap(void* address, quint32 length) {
+	Q_UNUSED(length)
+	QMutexLocker locker(&this->mutex);
+	this->mappings.remove(address);
+}
+
+void FakeV4l2Device::closeExported(int fd) {
+	QMutexLocker locker(&this->mutex);
+	this->exported.remove(fd);
+}
+
+int FakeV4l2Device::waitForFrame(int timeoutMs) {
+	QMutexLocker locker(&this->mutex);
+	qint64 deadline = monotonicTimeUs() + static_cast<qint64>(timeoutMs)*1000;
+	while(true){
+		//poll() reports an error while the device is not streaming
+		if(this->disconnected || !this->opened || !this->streaming){
+			return -1;
+		}
+		if(!this->doneBuffers.isEmpty()){
+			return 1;
+		}
+		qint64 now = monotonicTimeUs();
+		if(now >= this->nextFrameUs){
+			this->produceFrame(now);
+			this->nextFrameUs = qMax(this->nextFrameUs + this->frameIntervalUs, now + 1);
+			continue;
+		}
+		if(now >= deadline){
+			return 0;
+		}
+		qint64 waitUs = qMin(this->nextFrameUs, deadline) - now;
+		this->streamChanged.wait(&this->mutex, static_cast<unsigned long>((waitUs + 999)/1000));
+	}
+}
+
+void FakeV4l2Device::produceFrame(qint64 timestamp) {
+	quint32 frameSequence = this->sequence++;
+	if(this->queuedBuffers.isEmpty()){
+		this->lostFrames++;
+		return;
+	}
+	int index = this->queuedBuffers.dequeue();
+	Buffer& buffer = this->buffers[index];
+	buffer.queued = false;
+	buffer.done = true;
+	buffer.bytesUsed = this->imageSize();
+	buffer.sequence = frameSequence;
+	buffer.timestamp = timestamp;
+	uchar* data = reinterpret_cast<uchar*>(buffer.memory->data());
+	memset(data, static_cast<int>(frameSequence & 0xff), buffer.bytesUsed);
+	memcpy(data, &frameSequence, sizeof(frameSequence));
+	this->timestamps.insert(frameSequence, timestamp);
+	this->doneBuffers.enqueue(index);
+}
@@ -0,0 +1,102 @@
+#ifndef FAKEV4L2DEVICE_H
+#define FAKEV4L2DEVICE_H
+
+#include "v4l2device.h"
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QQueue>
+#include <QElapsedTimer>
+
+
+//simulated single-planar V4L2 capture device, so V4l2Source can be checked without camera hardware. it answers the ioctls V4l2Source uses with
+//buffers in heap memory: YUYV and GREY at any even resolution up to 4096x4096, a frame rate set via S_PARM, an integer, a boolean and a menu
+//control and optionally DMABUF export. frames are produced in waitForFrame() at the configured rate: the oldest queued buffer is filled with
+//the low byte of the sequence number, its first four bytes hold the whole sequence number, and gets a CLOCK_MONOTONIC timestamp. if no buffer
+//is queued when a frame is due, the frame is lost and its sequence number is skipped as real drivers do
+class FakeV4l2Device : public V4l2Device
+{
+public:
+	FakeV4l2Device();
+
+	bool open(const QString& path) override;
+	void close() override;
+	bool isOpen() const override;
+	int ioctl(unsigned long request, void* argument) override;
+	void* map(quint32 length, quint32 offset) override;
+	void unmap(void* address, quint32 length) override;
+	int waitForFrame(int timeoutMs) override;
+	void closeExported(int fd) override;
+
+	//simulation settings, set before open()
+	void setDmabufSupported(bool supported) {this->dmabufSupported = supported;}
+	void setBusy(bool busy) {this->busy = busy;}
+	//the device behaves as if it was unplugged, waitForFrame() and all ioctls fail from now on
+	void disconnect();
+	//the next DQBUF reports an index beyond the requested buffers, like a faulty driver. the dequeued buffer is lost
+	void reportInvalidIndex();
+
+	//inspection
+	int getMappingCount() const;
+	int getExportedCount() const;
+	int getQueuedCount() const;
+	quint32 getLostFrames() const;
+	//QBUF calls with an index beyond the requested buffers
+	int getInvalidQueueCount() const;
+	bool isStreaming() const;
+	//timestamp (us) of the frame with the given sequence number, -1 if it was not delivered
+	qint64 getTimestamp(quint32 sequence) const;
+	const uchar* getBufferData(int index) const;
+
+	static const quint32 BUFFER_OFFSET_STEP = 1 << 20;
+	static const quint32 MAX_BUFFERS = 8;
+	static const quint32 EXPORTED_FD_BASE = 1000;
+
+private:
+	struct Buffer {
+		QSharedPointer<QByteArray> memory;
+		bool queued;
+		bool done;
+		quint32 bytesUsed;
+		quint32 sequence;
+		qint64 timestamp;
+	};
+
+	mutable QMutex mutex;
+	QWaitCondition streamChanged;
+	bool opened;
+	bool busy;
+	bool disconnected;
+	bool invalidIndexPending;
+	int invalidQueueCount;
+	bool dmabufSupported;
+	quint32 fourcc;
+	quint32 width;
+	quint32 height;
+	quint32 frameIntervalUs;
+	QVector<Buffer> buffers;
+	QQueue<int> queuedBuffers;
+	QQueue<int> doneBuffers;
+	bool streaming;
+	quint32 sequence;
+	quint32 lostFrames;
+	qint64 nextFrameUs;
+	QHash<quint32, qint64> timestamps;
+	QHash<void*, QSharedPointer<QByteArray>> mappings;
+	QHash<int, int> exported;
+	int nextExportedFd;
+	qint32 brightness;
+	qint32 horizontalFlip;
+	qint32 autoExposure;
+	qint32 exposure;
+
+	quint32 bytesPerLine() const;
+	quint32 imageSize() const;
+	void produceFrame(qint64 timestamp);
+	int controlIoctl(unsigned long request, void* argument);
+};
+
+#endif //FAKEV4L2DEVICE_H
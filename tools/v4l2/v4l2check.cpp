@@ -0,0 +1,315 @@
+//check of the native V4L2 capture of the camera extension (V4l2Source) against a simulated device, no camera hardware is needed: format
+//negotiation, the Bayer layout of raw fourccs, delivery of the driver buffers without copy, driver timestamps and fourcc, DMABUF export, the
+//copy fallback when the stages hold too many frames, dropping of frames the gui thread can not take in time, controls, closing while frames
+//are held, the time to first frame with and without a mode switch, a driver that reports an unknown buffer index and a disconnected device.
+//usage: v4l2check. returns 1 if a check fails
+#include "v4l2source.h"
+#include "fakev4l2device.h"
+#include <QCoreApplication>
+#include <QAbstractVideoSurface>
+#include <QVideoSurfaceFormat>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <linux/videodev2.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+
+namespace {
+	//surface that keeps the last frame and optionally the first frames, like a stage that holds on to frames
+	class TestSurface : public QAbstractVideoSurface
+	{
+	public:
+		QList<QVideoFrame::PixelFormat> supportedPixelFormats(QAbstractVideoBuffer::HandleType type = QAbstractVideoBuffer::NoHandle) const override {
+			QList<QVideoFrame::PixelFormat> formats;
+			if(type == QAbstractVideoBuffer::NoHandle){
+				formats << QVideoFrame::Format_YUYV << QVideoFrame::Format_Y8 << QVideoFrame::Format_RGB32;
+			}
+			return formats;
+		}
+
+		bool present(const QVideoFrame& frame) override {
+			this->presentedFrames++;
+			this->lastFrame = frame;
+			if(this->heldFrames.size() < this->holdCount){
+				this->heldFrames.append(frame);
+			}
+			return true;
+		}
+
+		void release() {
+			this->holdCount = 0;
+			this->heldFrames.clear();
+			this->lastFrame = QVideoFrame();
+		}
+
+		QVideoFrame lastFrame;
+		QList<QVideoFrame> heldFrames;
+		int holdCount = 0;
+		int presentedFrames = 0;
+	};
+
+	int failures = 0;
+
+	void check(bool condition, const char* description) {
+		printf("%s: %s\n", condition ? "ok" : "FAILED", description);
+		if(!condition){
+			failures++;
+		}
+	}
+
+	//frames are presented by the event loop of the gui thread
+	void runEvents(int ms) {
+		QElapsedTimer timer;
+		timer.start();
+		while(timer.elapsed() < ms){
+			QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+			QThread::msleep(1);
+		}
+	}
+
+	//the simulated device writes the sequence number into the first four bytes of every frame
+	qint64 frameSequence(QVideoFrame frame) {
+		if(!frame.map(QAbstractVideoBuffer::ReadOnly)){
+			return -1;
+		}
+		quint32 sequence = 0;
+		memcpy(&sequence, frame.bits(), sizeof(sequence));
+		frame.unmap();
+		return sequence;
+	}
+
+	bool isDriverBuffer(QVideoFrame frame, const FakeV4l2Device* device, int bufferCount) {
+		if(!frame.map(QAbstractVideoBuffer::ReadOnly)){
+			return false;
+		}
+		const uchar* data = frame.bits();
+		frame.unmap();
+		for(int i = 0; i < bufferCount; i++){
+			if(data == device->getBufferData(i)){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	QCameraViewfinderSettings mode(int width, int height, QVideoFrame::PixelFormat pixelFormat, qreal frameRate) {
+		QCameraViewfinderSettings settings;
+		settings.setResolution(width, height);
+		settings.setPixelFormat(pixelFormat);
+		settings.setMaximumFrameRate(frameRate);
+		return settings;
+	}
+
+	//ms from the start of clock until the surface presents its next frame, -1 after timeoutMs
+	double waitForNextFrame(const TestSurface& surface, const QElapsedTimer& clock, int timeoutMs) {
+		int presentedFrames = surface.presentedFrames;
+		while(surface.presentedFrames == presentedFrames){
+			if(clock.elapsed() > timeoutMs){
+				return -1.0;
+			}
+			QCoreApplication::processEvents(QEventLoop::AllEvents, 1);
+			QThread::usleep(100);
+		}
+		return clock.nsecsElapsed()/1.0e6;
+	}
+
+	const V4l2Control* findControl(const QList<V4l2Control>& controls, quint32 id) {
+		for(const V4l2Control& control : controls){
+			if(control.id == id){
+				return &control;
+			}
+		}
+		return nullptr;
+	}
+}
+
+
+int main(int argc, char* argv[]) {
+	QCoreApplication app(argc, argv);
+	TestSurface surface;
+	V4l2Source source(&surface);
+	QStringList errors;
+	QObject::connect(&source, &V4l2Source::error, [&errors](QString message) {
+		errors.append(message);
+	});
+
+	//negotiation
+	{
+		QSharedPointer<FakeV4l2Device> device(new FakeV4l2Device());
+		bool opened = source.open(device, "/dev/fake0", mode(320, 240, QVideoFrame::Format_Y8, 100.0));
+		QCameraViewfinderSettings settings = source.getSettings();
+		check(opened && settings.resolution() == QSize(320, 240) && settings.pixelFormat() == QVideoFrame::Format_Y8
+			&& qAbs(settings.maximumFrameRate() - 100.0) < 0.5, "requested mode and frame rate are set");
+		check(surface.isActive() && surface.surfaceFormat().pixelFormat() == QVideoFrame::Format_Y8
+			&& surface.surfaceFormat().frameSize() == QSize(320, 240), "surface is started with the negotiated format");
+		source.close();
+		check(!surface.isActive() && !device->isOpen() && device->getMappingCount() == 0 && device->getExportedCount() == 0,
+			"close stops the surface, unmaps the buffers and closes the DMABUFs");
+
+		//NV12 is not offered by the device and MJPEG is compressed, the current format of the driver is kept
+		opened = source.open(device, "/dev/fake0", mode(321, 240, QVideoFrame::Format_NV12, 0.0));
+		settings = source.getSettings();
+		check(opened && settings.pixelFormat() == QVideoFrame::Format_Y8 && settings.resolution() == QSize(320, 240),
+			"unsupported formats fall back to the current format, the size adjusted by the driver is used");
+		source.close();
+
+		device->setBusy(true);
+		check(!source.open(device, "/dev/fake0", QCameraViewfinderSettings()) && !source.isOpen() && errors.size() == 1
+			&& errors.last().contains("busy"), "a busy device is reported");
+		errors.clear();
+	}
+
+	//Bayer pattern and bit depth of the raw fourccs, which are all Format_CameraRaw
+	{
+		int pattern = -1;
+		int bitDepth = 0;
+		bool found = V4l2Source::bayerLayout(V4L2_PIX_FMT_SRGGB8, &pattern, &bitDepth) && pattern == 0 && bitDepth == 8;
+		found = found && V4l2Source::bayerLayout(V4L2_PIX_FMT_SBGGR10, &pattern, &bitDepth) && pattern == 1 && bitDepth == 10;
+		found = found && V4l2Source::bayerLayout(V4L2_PIX_FMT_SGRBG12, &pattern, &bitDepth) && pattern == 2 && bitDepth == 12;
+		found = found && V4l2Source::bayerLayout(V4L2_PIX_FMT_SGBRG16, &pattern, &bitDepth) && pattern == 3 && bitDepth == 16;
+		check(found && V4l2Source::toPixelFormat(V4L2_PIX_FMT_SGBRG16) == QVideoFrame::Format_CameraRaw, "pattern and bit depth of Bayer fourccs");
+		check(!V4l2Source::bayerLayout(V4L2_PIX_FMT_Y16, &pattern, &bitDepth) && pattern == 3 && bitDepth == 16, "other fourccs have no Bayer layout");
+	}
+
+	//streaming without copy, driver timestamps and DMABUF export
+	{
+		QSharedPointer<FakeV4l2Device> device(new FakeV4l2Device());
+		source.open(device, "/dev/fake0", mode(640, 480, QVideoFrame::Format_YUYV, 200.0));
+		int bufferCount = source.getStatistics().bufferCount;
+		runEvents(400);
+		V4l2Statistics statistics = source.getStatistics();
+		QVideoFrame frame = surface.lastFrame;
+		qint64 sequence = frameSequence(frame);
+		check(surface.presentedFrames > 40 && bufferCount == V4l2Source::BUFFER_COUNT, "frames are presented on the gui thread");
+		check(isDriverBuffer(frame, device.data(), bufferCount) && statistics.framesCopied == 0, "frames reference the driver buffers");
+		check(sequence >= 0 && frame.startTime() == device->getTimestamp(static_cast<quint32>(sequence)) && statistics.monotonicTimestamps,
+			"frames carry the timestamp of the driver");
+		check(frame.metaData("fourcc").toUInt() == V4L2_PIX_FMT_YUYV && source.getFourcc() == V4L2_PIX_FMT_YUYV
+			&& surface.surfaceFormat().property("fourcc").toUInt() == V4L2_PIX_FMT_YUYV, "frames and surface format carry the fourcc of the driver");
+		check(qAbs(statistics.averageIntervalUs - 5000.0) < 1000.0, "frame interval from the driver timestamps matches the frame rate");
+		check(statistics.dmabufExported && frame.handle().toInt() >= static_cast<int>(FakeV4l2Device::EXPORTED_FD_BASE)
+			&& frame.handleType() == QAbstractVideoBuffer::NoHandle, "DMABUF file descriptor is the handle of the frames, which stay mapped memory");
+		check(!frame.map(QAbstractVideoBuffer::WriteOnly), "driver buffers can not be modified");
+		check(device->getLostFrames() == 0 && statistics.framesDroppedByDriver == 0, "the driver never ran out of buffers");
+		frame = QVideoFrame();
+
+		//stages that hold most buffers get copies, the driver keeps enough buffers
+		surface.holdCount = bufferCount - 1;
+		runEvents(400);
+		statistics = source.getStatistics();
+		check(surface.heldFrames.size() == bufferCount - 1 && statistics.framesCopied > 20, "frames are copied while the stages hold the buffers");
+		check(device->getLostFrames() <= 2, "the driver keeps capturing while the stages hold the buffers");
+		check(frameSequence(surface.heldFrames.first()) < frameSequence(surface.lastFrame), "held frames keep their content");
+		surface.release();
+		runEvents(100);
+		quint64 copiedFrames = source.getStatistics().framesCopied;
+		runEvents(200);
+		check(source.getStatistics().framesCopied == copiedFrames && isDriverBuffer(surface.lastFrame, device.data(), bufferCount),
+			"released buffers are queued again and used without copy");
+
+		//a blocked gui thread only gets the latest frame
+		quint64 replacedFrames = source.getStatistics().framesReplaced;
+		int presentedFrames = surface.presentedFrames;
+		QThread::msleep(200);
+		runEvents(20);
+		check(source.getStatistics().framesReplaced - replacedFrames > 20 && surface.presentedFrames - presentedFrames < 10,
+			"frames the gui thread can not take in time are dropped");
+		check(source.getStatistics().averageLatencyUs > 0.0, "latency from the driver timestamp is measured");
+
+		//controls
+		QList<V4l2Control> controls = source.getControls();
+		const V4l2Control* brightness = findControl(controls, V4L2_CID_BRIGHTNESS);
+		const V4l2Control* flip = findControl(controls, V4L2_CID_HFLIP);
+		const V4l2Control* autoExposure = findControl(controls, V4L2_CID_EXPOSURE_AUTO);
+		const V4l2Control* exposure = findControl(controls, V4L2_CID_EXPOSURE_ABSOLUTE);
+		check(controls.size() == 4 && brightness != nullptr && flip != nullptr && autoExposure != nullptr && exposure != nullptr,
+			"controls are enumerated, class entries are skipped");
+		check(brightness != nullptr && brightness->type == V4l2Control::INTEGER && brightness->minimum == -64 && brightness->maximum == 64
+			&& brightness->name == "Brightness", "integer control");
+		check(flip != nullptr && flip->type == V4l2Control::BOOLEAN, "boolean control");
+		check(autoExposure != nullptr && autoExposure->type == V4l2Control::MENU && autoExposure->menuItems.size() == 2
+			&& autoExposure->menuItems.at(0).first == V4L2_EXPOSURE_MANUAL && autoExposure->menuItems.at(1).second == "Aperture Priority Mode",
+			"menu control, gaps in the menu are skipped");
+		check(exposure != nullptr && !exposure->enabled, "inactive control is disabled");
+		check(source.setControl(V4L2_CID_EXPOSURE_AUTO, V4L2_EXPOSURE_MANUAL) && source.setControl(V4L2_CID_EXPOSURE_ABSOLUTE, 300)
+			&& findControl(source.getControls(), V4L2_CID_EXPOSURE_ABSOLUTE)->enabled
+			&& findControl(source.getControls(), V4L2_CID_EXPOSURE_ABSOLUTE)->value == 300, "controls are set and read back");
+		check(!source.setControl(V4L2_CID_BRIGHTNESS, 100), "values out of range are rejected");
+
+		//frames held while closing stay valid, the buffers are released with the last frame
+		surface.holdCount = 2;
+		runEvents(100);
+		qint64 heldSequence = frameSequence(surface.heldFrames.first());
+		source.close();
+		check(!device->isOpen() && device->getMappingCount() == bufferCount && frameSequence(surface.heldFrames.first()) == heldSequence,
+			"held frames stay valid after close");
+		surface.release();
+		check(device->getMappingCount() == 0 && device->getExportedCount() == 0, "buffers are unmapped with the last frame");
+		check(errors.isEmpty(), "no errors while streaming");
+	}
+
+	//time to first frame in the stored mode: starting in the driver default mode and switching once the mode is known, as before the mode was
+	//stored per camera, against opening the stored mode directly. the simulated device delivers its first frame one frame interval after
+	//VIDIOC_STREAMON and has no sensor start up time, so this covers the capture path only
+	{
+		const QCameraViewfinderSettings stored = mode(1280, 720, QVideoFrame::Format_YUYV, 60.0);
+		const int rounds = 5;
+		QVector<double> switched;
+		QVector<double> direct;
+		for(int i = 0; i < rounds; i++){
+			QSharedPointer<FakeV4l2Device> device(new FakeV4l2Device());
+			QElapsedTimer clock;
+			clock.start();
+			bool opened = source.open(device, "/dev/fake2", QCameraViewfinderSettings());
+			bool first = opened && waitForNextFrame(surface, clock, 1000) >= 0.0;
+			source.close();
+			surface.release();
+			opened = first && source.open(device, "/dev/fake2", stored);
+			double elapsed = opened ? waitForNextFrame(surface, clock, 2000) : -1.0;
+			source.close();
+			surface.release();
+			switched.append(elapsed);
+
+			device.reset(new FakeV4l2Device());
+			clock.start();
+			opened = source.open(device, "/dev/fake2", stored);
+			elapsed = opened ? waitForNextFrame(surface, clock, 1000) : -1.0;
+			source.close();
+			surface.release();
+			direct.append(elapsed);
+		}
+		std::sort(switched.begin(), switched.end());
+		std::sort(direct.begin(), direct.end());
+		printf("time to first frame in the stored mode (median of %d): %.1f ms with a switch from the driver default mode, %.1f ms opened directly\n",
+			rounds, switched.at(rounds/2), direct.at(rounds/2));
+		check(switched.first() >= 0.0 && direct.first() >= 0.0 && direct.at(rounds/2) < switched.at(rounds/2),
+			"the stored mode delivers its first frame sooner when it is opened directly");
+	}
+
+	//devices without DMABUF export, disconnected device
+	{
+		QSharedPointer<FakeV4l2Device> device(new FakeV4l2Device());
+		device->setDmabufSupported(false);
+		check(source.open(device, "/dev/fake1", QCameraViewfinderSettings()), "device without DMABUF export is opened");
+		runEvents(200);
+		check(!source.getStatistics().dmabufExported && surface.lastFrame.isValid() && !surface.lastFrame.handle().isValid(),
+			"frames have no handle without DMABUF export");
+		int presentedFrames = surface.presentedFrames;
+		device->reportInvalidIndex();
+		runEvents(200);
+		check(device->getInvalidQueueCount() == 0 && surface.presentedFrames - presentedFrames > 3 && errors.isEmpty(),
+			"a buffer with an unknown index is skipped without queueing it");
+		device->disconnect();
+		runEvents(300);
+		check(!source.isOpen() && !surface.isActive() && errors.size() == 1 && errors.last().contains("disconnected"),
+			"a disconnected device closes the source with an error");
+		surface.release();
+	}
+
+	printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#check of the native V4L2 capture of the camera extension against a simulated device, linux only
+QT = core multimedia
+TEMPLATE = app
+TARGET = v4l2check
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += \
+	fakev4l2device.cpp \
+	v4l2check.cpp \
+	../../src/capture/v4l2device.cpp \
+	../../src/capture/v4l2source.cpp
+
+HEADERS += \
+	fakev4l2device.h \
+	../../src/capture/v4l2device.h \
+	../../src/capture/v4l2source.h
+
+INCLUDEPATH += \
+	../../src/capture